@@ -1,14 +1,23 @@
 package com.nervesparks.iris.app.core
 
+import androidx.annotation.VisibleForTesting
 import com.nervesparks.iris.app.events.EventBus
 import com.nervesparks.iris.app.events.IrisEvent
 import com.nervesparks.iris.app.state.StateManager
+import com.nervesparks.iris.common.error.ModelException
 import com.nervesparks.iris.common.logging.IrisLogger
+import com.nervesparks.iris.common.models.GenerationParams
 import com.nervesparks.iris.core.hw.DeviceProfileProvider
 import com.nervesparks.iris.core.hw.ThermalManager
 import com.nervesparks.iris.core.llm.LLMEngine
+import com.nervesparks.iris.core.rag.ContextPacker
+import com.nervesparks.iris.core.rag.HnswIndex
+import com.nervesparks.iris.core.rag.PackCandidate
 import com.nervesparks.iris.core.rag.RAGEngine
+import com.nervesparks.iris.core.rag.RetrievedChunk
 import com.nervesparks.iris.core.safety.SafetyEngine
+import kotlinx.coroutines.async
+import kotlinx.coroutines.coroutineScope
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.StateFlow
@@ -32,9 +41,39 @@ class AppCoordinator @Inject constructor(
     private val deviceProfileProvider: DeviceProfileProvider
 ) {
     
+    companion object {
+        // Chunks retrieved for the packer to choose from, and put in a text prompt without it
+        private const val PACK_CANDIDATES = 12
+        private const val TEXT_CONTEXT_CHUNKS = 5
+        
+        // Chunks retrieved when a reranker has picked them from a deeper candidate list
+        private const val RERANKED_CHUNKS = 3
+        
+        // Chunk IDs remembered for packer labels before the table is started over
+        private const val MAX_CHUNK_LABELS = 4096
+        
+        // Share of the context left after the answer that the preamble and history may fill
+        private const val HISTORY_CONTEXT_SHARE = 2
+    }
+    
     private val _appState = MutableStateFlow<AppState>(AppState.Initializing)
     val appState: StateFlow<AppState> = _appState.asStateFlow()
     
+    /**
+     * Creates the packer with the first RAG prompt; null without the native RAG library
+     */
+    @VisibleForTesting
+    internal var createContextPacker: () -> ContextPacker? = {
+        runCatching { if (HnswIndex.isNativeAvailable) ContextPacker() else null }.getOrNull()
+    }
+    
+    private val contextPacker: ContextPacker? by lazy { createContextPacker() }
+    
+    // Packer label of each chunk ID: distinct per chunk and stable across turns, so the
+    // packer can tell which chunks were in the previous pack
+    private val chunkLabels = mutableMapOf<String, Int>()
+    private var nextChunkLabel = 0
+    
     /**
      * Initialize the application
      */
@@ -63,6 +102,9 @@ class AppCoordinator @Inject constructor(
     
     /**
      * Process user input through the AI pipeline
+     *
+     * The prompt opens with the input's preamble and the latest turns of its history that fit
+     * the context; that opening is prefilled while retrieval runs.
      */
     suspend fun processUserInput(input: UserInput): Flow<ProcessingResult> = flow {
         try {
@@ -76,22 +118,37 @@ class AppCoordinator @Inject constructor(
                 return@flow
             }
             
-            // RAG retrieval if enabled
-            val context = if (input.enableRAG) {
-                val chunks = ragEngine.search(input.text)
-                chunks.joinToString("\n") { it.content }
+            // Prompt opening: the caller's preamble and as much of its history as fits
+            val turn = if (input.history.isEmpty()) {
+                input
             } else {
-                ""
+                input.copy(preamble = conversationPreamble(input), history = emptyList())
             }
             
-            // Build prompt with context
-            val prompt = buildPrompt(input.text, context)
+            // RAG retrieval if enabled
+            val start = System.nanoTime()
+            val chunks = when {
+                !turn.enableRAG -> emptyList()
+                contextPacker != null -> retrieveWhilePrefilling(turn)
+                else -> ragEngine.search(turn.text, searchLimit(TEXT_CONTEXT_CHUNKS))
+            }
             
-            // LLM generation
-            llmEngine.generateText(prompt, input.params)
-                .collect { token ->
-                    emit(ProcessingResult.TokenGenerated(token))
+            // LLM generation, from packed prompt tokens when the context had to fit a budget
+            val packed = if (chunks.isNotEmpty()) packPrompt(turn, chunks) else null
+            val tokens = if (packed != null) {
+                llmEngine.generateFromTokens(packed.tokens, turn.params, packed.segments)
+            } else {
+                val context = chunks.take(TEXT_CONTEXT_CHUNKS).joinToString("\n") { it.content }
+                llmEngine.generateText(buildPrompt(turn.preamble, turn.text, context), turn.params)
+            }
+            var first = true
+            tokens.collect { token ->
+                if (first && packed != null) {
+                    IrisLogger.debug("RAG turn first token after ${(System.nanoTime() - start) / 1_000_000} ms")
                 }
+                first = false
+                emit(ProcessingResult.TokenGenerated(token))
+            }
             
             emit(ProcessingResult.Completed)
         } catch (e: Exception) {
@@ -102,14 +159,123 @@ class AppCoordinator @Inject constructor(
         emit(ProcessingResult.Error(e as? Exception ?: Exception(e)))
     }
     
+    /**
+     * [UserInput.preamble] followed by the latest turns of [UserInput.history], in the turn
+     * format of [buildPrompt], that fit 1/[HISTORY_CONTEXT_SHARE] of the context left after
+     * the answer. Each part is tokenized once and turns are dropped from a running count;
+     * without a loaded model every turn is kept.
+     */
+    private suspend fun conversationPreamble(input: UserInput): String {
+        val turns = input.history.map { "User: ${it.user}\n\nAssistant: ${it.assistant}\n\n" }
+        val contextSize = llmEngine.contextSize() ?: return input.preamble + turns.joinToString("")
+        val limit = (contextSize - input.params.maxTokens) / HISTORY_CONTEXT_SHARE
+        var used = llmEngine.tokenize(input.preamble, addSpecial = true).size
+        var kept = 0
+        for (turn in turns.asReversed()) {
+            used += llmEngine.tokenize(turn).size
+            if (used > limit) {
+                break
+            }
+            kept++
+        }
+        return input.preamble + turns.takeLast(kept).joinToString("")
+    }
+    
+    /**
+     * Packer candidates for [input], searched while the LLM prefills the prompt up to its context,
+     * which does not depend on retrieval
+     */
+    private suspend fun retrieveWhilePrefilling(input: UserInput): List<RetrievedChunk> = coroutineScope {
+        val prefill = if (input.preamble.isNotEmpty() && llmEngine.contextSize() != null) {
+            async {
+                runCatching { llmEngine.prefill(llmEngine.tokenize(promptHead(input.preamble), addSpecial = true)) }
+            }
+        } else {
+            null
+        }
+        val start = System.nanoTime()
+        val chunks = ragEngine.search(input.text, searchLimit(PACK_CANDIDATES))
+        val searched = System.nanoTime()
+        prefill?.await()?.onFailure { IrisLogger.warning("Preamble prefill failed", it) }
+        IrisLogger.debug(
+            "Retrieval ${(searched - start) / 1_000_000} ms, then waited " +
+                "${(System.nanoTime() - searched) / 1_000_000} ms for the preamble prefill"
+        )
+        chunks
+    }
+    
+    /**
+     * Chunks to retrieve: [limit], or fewer when the RAG engine reranks and its first few are the ones that matter
+     */
+    private fun searchLimit(limit: Int): Int = if (ragEngine.reranks) minOf(limit, RERANKED_CHUNKS) else limit
+    
+    /**
+     * Prompt tokens and the (start, length) spans of its chunks, which the LLM may splice from its KV segment cache
+     */
+    private class PackedPrompt(val tokens: IntArray, val segments: IntArray)
+    
+    /**
+     * The prompt of [buildPrompt] as tokens, with the chunks that fit the model's context
+     * after the answer's [GenerationParams.maxTokens], chosen and ordered by [ContextPacker];
+     * null without the packer or a loaded model
+     * @throws ModelException if the preamble, question and answer leave no room in the context
+     */
+    private suspend fun packPrompt(input: UserInput, chunks: List<RetrievedChunk>): PackedPrompt? {
+        val packer = contextPacker ?: return null
+        val contextSize = llmEngine.contextSize() ?: return null
+        return try {
+            val head = llmEngine.tokenize(promptHead(input.preamble), addSpecial = true)
+            val tail = llmEngine.tokenize("\nUser: ${input.text}\n\nAssistant:") // chunks end in a separator
+            val separator = llmEngine.tokenize("\n")
+            val budget = contextSize - input.params.maxTokens - head.size - tail.size
+            if (budget <= 0) {
+                throw ModelException(
+                    "Prompt needs ${head.size + tail.size} tokens and the answer ${input.params.maxTokens}, " +
+                        "more than the $contextSize-token context"
+                )
+            }
+            val labels = chunkLabels(chunks)
+            val candidates = chunks.mapIndexed { i, chunk ->
+                PackCandidate(labels[i], chunk.score, llmEngine.tokenize(chunk.content))
+            }
+            val packed = packer.pack(candidates, budget, separator)
+            if (packed.labels.isEmpty()) {
+                val prompt = llmEngine.tokenize(buildPrompt(input.preamble, input.text, ""), addSpecial = true)
+                PackedPrompt(prompt, IntArray(0))
+            } else {
+                val segments = IntArray(packed.spans.size) { i ->
+                    if (i % 2 == 0) packed.spans[i] + head.size else packed.spans[i]
+                }
+                PackedPrompt(head + packed.tokens + tail, segments)
+            }
+        } catch (e: ModelException) {
+            throw e // as text the prompt would overflow the context all the same
+        } catch (e: Exception) {
+            IrisLogger.error("Context packing failed, sending the prompt as text", e)
+            null
+        }
+    }
+    
+    private fun chunkLabels(chunks: List<RetrievedChunk>): IntArray = synchronized(chunkLabels) {
+        if (chunkLabels.size > MAX_CHUNK_LABELS) {
+            chunkLabels.clear() // fresh labels from nextChunkLabel on, so none is reused
+        }
+        IntArray(chunks.size) { i -> chunkLabels.getOrPut(chunks[i].id) { nextChunkLabel++ } }
+    }
+    
+    /**
+     * Prompt up to where the retrieved context goes
+     */
+    private fun promptHead(preamble: String): String = "${preamble}Context:\n"
+    
     /**
      * Build prompt with optional RAG context
      */
-    private fun buildPrompt(userText: String, context: String): String {
+    private fun buildPrompt(preamble: String, userText: String, context: String): String {
         return if (context.isNotEmpty()) {
-            "Context:\n$context\n\nUser: $userText\n\nAssistant:"
+            "${promptHead(preamble)}$context\n\nUser: $userText\n\nAssistant:"
         } else {
-            "User: $userText\n\nAssistant:"
+            "${preamble}User: $userText\n\nAssistant:"
         }
     }
     
@@ -0,0 +1,61 @@
+package com.nervesparks.iris.app.core
+
+import android.content.Context
+import com.nervesparks.iris.common.logging.IrisLogger
+import com.nervesparks.iris.core.llm.LlamaReranker
+import com.nervesparks.iris.core.rag.Reranker
+import dagger.hilt.android.qualifiers.ApplicationContext
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.sync.Mutex
+import kotlinx.coroutines.sync.withLock
+import kotlinx.coroutines.withContext
+import java.io.File
+import javax.inject.Inject
+import javax.inject.Singleton
+
+/**
+ * [Reranker] backed by the cross-encoder GGUF in the app's models directory
+ * (a file named `*rerank*.gguf`, e.g. bge-reranker-v2-m3-q8_0.gguf)
+ *
+ * The model is loaded with the first query that is reranked, not at startup.
+ * If it fails to load, every later score call fails at once and the RAG engine
+ * keeps its retrieval order.
+ */
+@Singleton
+class LlamaRerankerAdapter @Inject constructor(
+    @ApplicationContext context: Context
+) : Reranker {
+
+    private val modelFile: File? = File(context.getExternalFilesDir(null), "models")
+        .listFiles { file -> file.extension == "gguf" && file.name.contains("rerank", ignoreCase = true) }
+        ?.minByOrNull { it.name }
+
+    private val mutex = Mutex()
+    private var reranker: LlamaReranker? = null
+    private var loadFailed = false
+
+    /**
+     * Whether a reranker model is installed
+     */
+    val isAvailable: Boolean get() = modelFile != null
+
+    override suspend fun score(query: String, passages: List<String>): FloatArray = withContext(Dispatchers.Default) {
+        mutex.withLock { loaded().score(query, passages) }
+    }
+
+    private fun loaded(): LlamaReranker {
+        reranker?.let { return it }
+        val file = checkNotNull(modelFile) { "No reranker model installed" }
+        check(!loadFailed) { "Reranker model ${file.name} failed to load" }
+        return try {
+            LlamaReranker.load(file).also {
+                reranker = it
+                IrisLogger.info("Loaded reranker ${file.name}")
+            }
+        } catch (e: Throwable) {
+            loadFailed = true // UnsatisfiedLinkError included: the native library will not appear later
+            IrisLogger.error("Failed to load reranker ${file.name}", e)
+            throw IllegalStateException("Reranker model ${file.name} failed to load", e)
+        }
+    }
+}
@@ -4,11 +4,24 @@ import com.nervesparks.iris.common.models.GenerationParams
 
 /**
  * User input for processing
+ * @property preamble Opening of the prompt, e.g. the system prompt, ending in a line break
+ * @property history Earlier turns of the conversation, oldest first; the latest that fit the
+ * context follow the preamble. Neither depends on retrieval, so both are prefilled while it runs.
  */
 data class UserInput(
     val text: String,
     val enableRAG: Boolean = false,
-    val params: GenerationParams = GenerationParams()
+    val params: GenerationParams = GenerationParams(),
+    val preamble: String = "",
+    val history: List<ConversationTurn> = emptyList()
+)
+
+/**
+ * A completed exchange of a conversation
+ */
+data class ConversationTurn(
+    val user: String,
+    val assistant: String
 )
 
 /**
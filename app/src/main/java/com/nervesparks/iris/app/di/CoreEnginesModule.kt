@@ -1,5 +1,6 @@
 package com.nervesparks.iris.app.di
 
+import com.nervesparks.iris.app.core.LlamaRerankerAdapter
 import com.nervesparks.iris.core.llm.LLMEngine
 import com.nervesparks.iris.core.llm.LLMEngineImpl
 import com.nervesparks.iris.core.rag.RAGEngine
@@ -8,6 +9,7 @@ import com.nervesparks.iris.core.safety.SafetyEngine
 import com.nervesparks.iris.core.safety.SafetyEngineImpl
 import dagger.Binds
 import dagger.Module
+import dagger.Provides
 import dagger.hilt.InstallIn
 import dagger.hilt.components.SingletonComponent
 import javax.inject.Singleton
@@ -23,11 +25,21 @@ abstract class CoreEnginesModule {
     @Singleton
     abstract fun bindLLMEngine(impl: LLMEngineImpl): LLMEngine
     
-    @Binds
-    @Singleton
-    abstract fun bindRAGEngine(impl: RAGEngineImpl): RAGEngine
-    
     @Binds
     @Singleton
     abstract fun bindSafetyEngine(impl: SafetyEngineImpl): SafetyEngine
+    
+    companion object {
+        /**
+         * RAG engine with the cross-encoder attached when a reranker model is installed
+         */
+        @Provides
+        @Singleton
+        fun provideRAGEngine(impl: RAGEngineImpl, reranker: LlamaRerankerAdapter): RAGEngine {
+            if (reranker.isAvailable) {
+                impl.reranker = reranker
+            }
+            return impl
+        }
+    }
 }
@@ -3,6 +3,7 @@ package com.nervesparks.iris.app.core
 import com.nervesparks.iris.app.events.EventBus
 import com.nervesparks.iris.app.state.StateManager
 import com.nervesparks.iris.common.config.ThermalState
+import com.nervesparks.iris.common.error.ModelException
 import com.nervesparks.iris.common.models.BenchmarkResults
 import com.nervesparks.iris.common.models.DeviceProfile
 import com.nervesparks.iris.common.models.GPUInfo
@@ -17,16 +18,23 @@ import com.nervesparks.iris.common.models.SoCVendor
 import com.nervesparks.iris.core.hw.DeviceProfileProvider
 import com.nervesparks.iris.core.hw.ThermalManager
 import com.nervesparks.iris.core.llm.LLMEngine
+import com.nervesparks.iris.core.rag.ContextPacker
 import com.nervesparks.iris.core.rag.DataSource
 import com.nervesparks.iris.core.rag.Document
 import com.nervesparks.iris.core.rag.IndexStats
+import com.nervesparks.iris.core.rag.PackCandidate
+import com.nervesparks.iris.core.rag.PackedContext
 import com.nervesparks.iris.core.rag.RAGEngine
 import com.nervesparks.iris.core.rag.RetrievedChunk
 import com.nervesparks.iris.core.safety.SafetyEngine
 import com.nervesparks.iris.core.safety.SafetyResult
+import io.mockk.Runs
 import io.mockk.coEvery
+import io.mockk.coVerify
 import io.mockk.every
+import io.mockk.just
 import io.mockk.mockk
+import io.mockk.slot
 import io.mockk.verify
 import kotlinx.coroutines.flow.MutableStateFlow
 import kotlinx.coroutines.flow.asStateFlow
@@ -74,6 +82,7 @@ class AppCoordinatorTest {
         every { thermalManager.thermalState } returns thermalStateFlow.asStateFlow()
         every { thermalManager.startMonitoring() } returns Unit
         every { thermalManager.stopMonitoring() } returns Unit
+        every { ragEngine.reranks } returns false
         
         appCoordinator = AppCoordinator(
             stateManager,
@@ -141,6 +150,145 @@ class AppCoordinatorTest {
         assertTrue(results.any { it is ProcessingResult.TokenGenerated })
     }
     
+    @Test
+    fun `reranked search fetches only the chunks the prompt uses`() = runTest {
+        every { ragEngine.reranks } returns true
+        coEvery { safetyEngine.checkInput(any()) } returns SafetyResult(isAllowed = true)
+        coEvery { ragEngine.search(any(), any()) } returns listOf(
+            RetrievedChunk("1", "Context content", 0.9f, "doc1", 0, emptyMap())
+        )
+        coEvery { llmEngine.generateText(any(), any()) } returns flow { emit("Response") }
+        
+        appCoordinator.processUserInput(UserInput(text = "Question", enableRAG = true)).toList()
+        
+        coVerify { ragEngine.search("Question", 3) }
+    }
+    
+    @Test
+    fun `processUserInput fails when the prompt leaves no room for context`() = runTest {
+        val packer = mockk<ContextPacker>()
+        appCoordinator.createContextPacker = { packer }
+        coEvery { safetyEngine.checkInput(any()) } returns SafetyResult(isAllowed = true)
+        coEvery { ragEngine.search(any(), any()) } returns listOf(
+            RetrievedChunk("1", "Context content", 0.9f, "doc1", 0, emptyMap())
+        )
+        every { llmEngine.contextSize() } returns 1024
+        coEvery { llmEngine.tokenize(any(), any()) } returns IntArray(300)
+        coEvery { llmEngine.prefill(any()) } just Runs
+        
+        // 600 prompt tokens plus 512 for the answer overflow a 1024-token context
+        val input = UserInput(text = "Question", enableRAG = true, params = GenerationParams(maxTokens = 512))
+        val results = appCoordinator.processUserInput(input).toList()
+        
+        val error = results.filterIsInstance<ProcessingResult.Error>().single()
+        assertTrue(error.exception is ModelException)
+        verify(exactly = 0) { packer.pack(any(), any(), any()) }
+        coVerify(exactly = 0) { llmEngine.generateText(any(), any()) }
+    }
+    
+    @Test
+    fun `packer labels are distinct per chunk and stable across turns`() = runTest {
+        val packer = mockk<ContextPacker>()
+        val packed = mutableListOf<List<PackCandidate>>()
+        val candidates = slot<List<PackCandidate>>()
+        every { packer.pack(capture(candidates), any(), any()) } answers {
+            packed.add(candidates.captured)
+            PackedContext(IntArray(0), IntArray(0))
+        }
+        appCoordinator.createContextPacker = { packer }
+        coEvery { safetyEngine.checkInput(any()) } returns SafetyResult(isAllowed = true)
+        // "Aa" and "BB" have the same String.hashCode()
+        coEvery { ragEngine.search(any(), any()) } returnsMany listOf(
+            listOf(
+                RetrievedChunk("Aa", "First chunk", 0.9f, "doc1", 0, emptyMap()),
+                RetrievedChunk("BB", "Second chunk", 0.8f, "doc1", 1, emptyMap())
+            ),
+            listOf(RetrievedChunk("BB", "Second chunk", 0.9f, "doc1", 1, emptyMap()))
+        )
+        every { llmEngine.contextSize() } returns 4096
+        coEvery { llmEngine.tokenize(any(), any()) } returns IntArray(4)
+        coEvery { llmEngine.prefill(any()) } just Runs
+        coEvery { llmEngine.generateFromTokens(any(), any(), any()) } returns flow { emit("Answer") }
+        
+        repeat(2) { appCoordinator.processUserInput(UserInput(text = "Question", enableRAG = true)).toList() }
+        
+        val first = packed[0].map { it.label }
+        assertEquals(2, first.distinct().size)
+        assertEquals(first[1], packed[1].single().label)
+    }
+    
+    @Test
+    fun `prompt opens with the caller's preamble and history`() = runTest {
+        coEvery { safetyEngine.checkInput(any()) } returns SafetyResult(isAllowed = true)
+        val prompts = mutableListOf<String>()
+        coEvery { llmEngine.generateText(capture(prompts), any()) } returns flow { emit("Fine") }
+        every { llmEngine.contextSize() } returns null
+        
+        val input = UserInput(
+            text = "Again",
+            preamble = "Be brief.\n",
+            history = listOf(ConversationTurn("Hello", "Hi there"))
+        )
+        appCoordinator.processUserInput(input).toList()
+        
+        assertEquals(
+            "Be brief.\nUser: Hello\n\nAssistant: Hi there\n\nUser: Again\n\nAssistant:",
+            prompts.single()
+        )
+    }
+    
+    @Test
+    fun `turns that do not fit the context are dropped, each tokenized once`() = runTest {
+        coEvery { safetyEngine.checkInput(any()) } returns SafetyResult(isAllowed = true)
+        val prompts = mutableListOf<String>()
+        coEvery { llmEngine.generateText(capture(prompts), any()) } returns flow { emit("Fine") }
+        every { llmEngine.contextSize() } returns 1024
+        coEvery { llmEngine.tokenize(any(), any()) } answers {
+            IntArray(if (firstArg<String>().contains("Old")) 300 else 50)
+        }
+        
+        // 512 tokens left after the answer, half of them for the preamble and history
+        val input = UserInput(
+            text = "Now",
+            preamble = "Be brief.\n",
+            history = listOf(ConversationTurn("Old", "Reply"), ConversationTurn("Recent", "Reply"))
+        )
+        appCoordinator.processUserInput(input).toList()
+        
+        assertTrue(prompts.single().contains("User: Recent"))
+        assertTrue(!prompts.single().contains("Old"))
+        coVerify(exactly = 1) { llmEngine.tokenize(match { it.contains("Recent") }, any()) }
+        coVerify(exactly = 1) { llmEngine.tokenize(match { it.contains("Old") }, any()) }
+    }
+    
+    @Test
+    fun `RAG turn prefills the preamble and history while retrieving`() = runTest {
+        val packer = mockk<ContextPacker>()
+        every { packer.pack(any(), any(), any()) } returns PackedContext(IntArray(0), IntArray(0))
+        appCoordinator.createContextPacker = { packer }
+        coEvery { safetyEngine.checkInput(any()) } returns SafetyResult(isAllowed = true)
+        coEvery { ragEngine.search(any(), any()) } returns listOf(
+            RetrievedChunk("1", "Context content", 0.9f, "doc1", 0, emptyMap())
+        )
+        every { llmEngine.contextSize() } returns 4096
+        val heads = mutableListOf<String>()
+        coEvery { llmEngine.tokenize(capture(heads), true) } returns intArrayOf(1, 2, 3)
+        coEvery { llmEngine.tokenize(any(), false) } returns IntArray(4)
+        coEvery { llmEngine.prefill(any()) } just Runs
+        coEvery { llmEngine.generateFromTokens(any(), any(), any()) } returns flow { emit("Answer") }
+        
+        val input = UserInput(
+            text = "Question",
+            enableRAG = true,
+            preamble = "Be brief.\n",
+            history = listOf(ConversationTurn("Hello", "Hi there"))
+        )
+        appCoordinator.processUserInput(input).toList()
+        
+        coVerify { llmEngine.prefill(intArrayOf(1, 2, 3)) }
+        assertTrue(heads.contains("Be brief.\nUser: Hello\n\nAssistant: Hi there\n\nContext:\n"))
+    }
+    
     @Test
     fun `shutdown stops thermal monitoring`() {
         appCoordinator.shutdown()
@@ -0,0 +1,36 @@
+package com.nervesparks.iris.app.di
+
+import com.nervesparks.iris.app.core.LlamaRerankerAdapter
+import com.nervesparks.iris.core.rag.RAGEngineImpl
+import io.mockk.every
+import io.mockk.mockk
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertSame
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+class CoreEnginesModuleTest {
+
+    @Test
+    fun `RAG engine gets the reranker when a model is installed`() {
+        val reranker = mockk<LlamaRerankerAdapter>()
+        every { reranker.isAvailable } returns true
+        val impl = RAGEngineImpl()
+
+        val engine = CoreEnginesModule.provideRAGEngine(impl, reranker)
+
+        assertSame(reranker, impl.reranker)
+        assertTrue(engine.reranks)
+    }
+
+    @Test
+    fun `RAG engine keeps retrieval order without a reranker model`() {
+        val reranker = mockk<LlamaRerankerAdapter>()
+        every { reranker.isAvailable } returns false
+        val impl = RAGEngineImpl()
+
+        CoreEnginesModule.provideRAGEngine(impl, reranker)
+
+        assertNull(impl.reranker)
+    }
+}
@@ -0,0 +1,300 @@
+/**
+ * Time to first token, disk use and accuracy of splicing precomputed KV
+ * segments (KvSegmentCache) against decoding the whole prompt.
+ *
+ * Each query's passages go into the same RAG prompt shape as rerank_bench, one
+ * segment per passage. Every prompt is prefilled three ways from an empty
+ * cache: all decoded; passages spliced the first time they are seen (decoded
+ * alone and stored, or from disk if an earlier query used them); and passages
+ * spliced from disk. Accuracy compares the spliced prompt's next-token
+ * distribution with the fully decoded one (top-1 agreement and KL divergence)
+ * and how many of the first `answer` greedy tokens match.
+ *
+ * The pairs file holds one `query<TAB>passage` per line; consecutive lines
+ * with the same query form that query's passages.
+ *
+ * Usage: kv_segment_bench generator.gguf pairs.tsv [passages=4] [answer=32] [threads=4]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../kv_segment_cache.h"
+#include "llama.h"
+
+namespace {
+
+struct Query {
+    std::string text;
+    std::vector<std::string> passages;
+};
+
+struct Prompt {
+    std::vector<llama_token> tokens;
+    std::vector<std::pair<size_t, size_t>> segments;
+};
+
+long argOr(int argc, char** argv, int position, long fallback) {
+    return argc > position ? std::strtol(argv[position], nullptr, 10) : fallback;
+}
+
+class Timer {
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+std::vector<Query> readPairs(const char* path, size_t passages) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot read ") + path);
+    }
+    std::vector<Query> queries;
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        std::string query = line.substr(0, tab);
+        if (queries.empty() || queries.back().text != query) {
+            queries.push_back({std::move(query), {}});
+        }
+        if (queries.back().passages.size() < passages) {
+            queries.back().passages.push_back(line.substr(tab + 1));
+        }
+    }
+    return queries;
+}
+
+class Generator {
+public:
+    Generator(const char* path, int threads) {
+        model = llama_model_load_from_file(path, llama_model_default_params());
+        if (!model) {
+            throw std::runtime_error(std::string("Failed to load generator from ") + path);
+        }
+        // As ModelManager configures it: a scratch sequence in one unified cache
+        llama_context_params params = llama_context_default_params();
+        params.n_ctx = 8192;
+        params.n_batch = 512;
+        params.n_seq_max = 2;
+        params.kv_unified = true;
+        params.n_threads = threads;
+        params.n_threads_batch = threads;
+        context = llama_init_from_model(model, params);
+        if (!context) {
+            throw std::runtime_error("Failed to create generator context");
+        }
+        vocab = llama_model_get_vocab(model);
+    }
+
+    ~Generator() {
+        llama_free(context);
+        llama_model_free(model);
+    }
+
+    llama_context* getContext() const { return context; }
+
+    std::vector<llama_token> tokenize(const std::string& text, bool addSpecial) const {
+        const int count = -llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, addSpecial, false);
+        std::vector<llama_token> tokens(count);
+        llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), count, addSpecial, false);
+        return tokens;
+    }
+
+    // Same shape as the RAG prompt the app builds, each passage tokenized alone as the packer sees it
+    Prompt buildPrompt(const Query& query) const {
+        Prompt prompt;
+        prompt.tokens = tokenize("Answer using the context below.\n\nContext:\n", true);
+        for (const std::string& passage : query.passages) {
+            const std::vector<llama_token> chunk = tokenize("- " + passage + "\n", false);
+            prompt.segments.emplace_back(prompt.tokens.size(), chunk.size());
+            prompt.tokens.insert(prompt.tokens.end(), chunk.begin(), chunk.end());
+        }
+        const std::vector<llama_token> tail = tokenize("\nQuestion: " + query.text + "\nAnswer:", false);
+        prompt.tokens.insert(prompt.tokens.end(), tail.begin(), tail.end());
+        return prompt;
+    }
+
+    /**
+     * Prefill from an empty cache, splicing segments through `cache` if given;
+     * returns elapsed milliseconds
+     */
+    double prefill(const Prompt& prompt, KvSegmentCache* cache) {
+        llama_memory_clear(llama_get_memory(context), true);
+        Timer timer;
+        size_t next = 0;
+        if (cache) {
+            for (const auto& [start, length] : prompt.segments) {
+                decode(prompt.tokens, next, start);
+                next = cache->splice(prompt.tokens.data() + start, length, static_cast<llama_pos>(start))
+                           ? start + length
+                           : start;
+            }
+        }
+        decode(prompt.tokens, next, prompt.tokens.size());
+        llama_synchronize(context);
+        return timer.elapsedMs();
+    }
+
+    std::vector<float> logits() const {
+        const float* last = llama_get_logits(context);
+        return std::vector<float>(last, last + llama_vocab_n_tokens(vocab));
+    }
+
+    /**
+     * Greedy continuation of the prefilled prompt
+     */
+    std::vector<llama_token> answer(size_t count) {
+        std::vector<llama_token> tokens;
+        for (size_t i = 0; i < count; i++) {
+            const std::vector<float> next = logits();
+            llama_token token = static_cast<llama_token>(std::max_element(next.begin(), next.end()) - next.begin());
+            if (llama_vocab_is_eog(vocab, token)) {
+                break;
+            }
+            tokens.push_back(token);
+            if (llama_decode(context, llama_batch_get_one(&token, 1)) != 0) {
+                throw std::runtime_error("Decode failed");
+            }
+        }
+        return tokens;
+    }
+
+private:
+    llama_model* model;
+    llama_context* context;
+    const llama_vocab* vocab;
+
+    void decode(const std::vector<llama_token>& tokens, size_t from, size_t to) {
+        std::vector<llama_token> part(tokens.begin() + from, tokens.begin() + to);
+        for (size_t at = 0; at < part.size(); at += 512) {
+            const int count = static_cast<int>(std::min<size_t>(512, part.size() - at));
+            if (llama_decode(context, llama_batch_get_one(part.data() + at, count)) != 0) {
+                throw std::runtime_error("Prefill failed");
+            }
+        }
+    }
+};
+
+// KL(p || q) of the softmax of two logit vectors
+double klDivergence(const std::vector<float>& p, const std::vector<float>& q) {
+    auto logSoftmax = [](const std::vector<float>& logits) {
+        const float top = *std::max_element(logits.begin(), logits.end());
+        double sum = 0.0;
+        for (float logit : logits) {
+            sum += std::exp(static_cast<double>(logit - top));
+        }
+        std::vector<double> result(logits.size());
+        for (size_t i = 0; i < logits.size(); i++) {
+            result[i] = logits[i] - top - std::log(sum);
+        }
+        return result;
+    };
+    const std::vector<double> lp = logSoftmax(p);
+    const std::vector<double> lq = logSoftmax(q);
+    double kl = 0.0;
+    for (size_t i = 0; i < lp.size(); i++) {
+        kl += std::exp(lp[i]) * (lp[i] - lq[i]);
+    }
+    return kl;
+}
+
+size_t argmax(const std::vector<float>& values) {
+    return static_cast<size_t>(std::max_element(values.begin(), values.end()) - values.begin());
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s generator.gguf pairs.tsv [passages] [answer] [threads]\n", argv[0]);
+        return 1;
+    }
+    const size_t passages = static_cast<size_t>(argOr(argc, argv, 3, 4));
+    const size_t answerTokens = static_cast<size_t>(argOr(argc, argv, 4, 32));
+    const int threads = static_cast<int>(argOr(argc, argv, 5, 4));
+
+    const std::filesystem::path directory = std::filesystem::temp_directory_path() / "kv_segment_bench";
+    std::filesystem::remove_all(directory);
+
+    llama_backend_init();
+    try {
+        const std::vector<Query> queries = readPairs(argv[2], passages);
+        Generator generator(argv[1], threads);
+        KvSegmentCache cache(generator.getContext(), directory.string(), SIZE_MAX, 1);
+
+        std::set<std::vector<llama_token>> stored;
+        double promptTokens = 0, segmentTokens = 0, storedTokens = 0;
+        double fullMs = 0, firstMs = 0, diskMs = 0;
+        double kl = 0, topAgree = 0, answerMatch = 0, answerTotal = 0;
+        for (const Query& query : queries) {
+            const Prompt prompt = generator.buildPrompt(query);
+            promptTokens += prompt.tokens.size();
+            for (const auto& [start, length] : prompt.segments) {
+                segmentTokens += length;
+                const auto begin = prompt.tokens.begin() + start;
+                if (stored.emplace(begin, begin + length).second) {
+                    storedTokens += length;
+                }
+            }
+
+            fullMs += generator.prefill(prompt, nullptr);
+            const std::vector<float> fullLogits = generator.logits();
+            const std::vector<llama_token> fullAnswer = generator.answer(answerTokens);
+
+            firstMs += generator.prefill(prompt, &cache);
+            diskMs += generator.prefill(prompt, &cache);
+            const std::vector<float> splicedLogits = generator.logits();
+            const std::vector<llama_token> splicedAnswer = generator.answer(answerTokens);
+
+            kl += klDivergence(fullLogits, splicedLogits);
+            topAgree += argmax(fullLogits) == argmax(splicedLogits);
+            size_t same = 0;
+            while (same < fullAnswer.size() && same < splicedAnswer.size() && fullAnswer[same] == splicedAnswer[same]) {
+                same++;
+            }
+            answerMatch += same;
+            answerTotal += fullAnswer.size();
+        }
+
+        const KvSegmentCache::Stats stats = cache.stats();
+        const double n = std::max<size_t>(1, queries.size());
+        std::printf("queries %zu, %zu passages each, %d threads\n", queries.size(), passages, threads);
+        std::printf("%-30s %10.0f\n", "prompt tokens / query", promptTokens / n);
+        std::printf("%-30s %10.0f\n", "passage tokens / query", segmentTokens / n);
+        std::printf("%-30s %10.1f\n", "prefill ms, all decoded", fullMs / n);
+        std::printf("%-30s %10.1f\n", "prefill ms, first splice", firstMs / n);
+        std::printf("%-30s %10.1f\n", "prefill ms, spliced from disk", diskMs / n);
+        std::printf("%-30s %10zu\n", "segments stored", stats.segments);
+        std::printf("%-30s %10.1f\n", "disk MB", stats.diskBytes / (1024.0 * 1024.0));
+        std::printf("%-30s %10.1f\n", "disk KB / stored token", stats.diskBytes / 1024.0 / std::max(1.0, storedTokens));
+        std::printf("%-30s %9.1f%%\n", "next token top-1 agreement", 100.0 * topAgree / n);
+        std::printf("%-30s %10.4f\n", "next token KL (nats)", kl / n);
+        std::printf("%-30s %9.1f%%\n", "greedy answer tokens matched", 100.0 * answerMatch / std::max(1.0, answerTotal));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        std::filesystem::remove_all(directory);
+        llama_backend_free();
+        return 1;
+    }
+    std::filesystem::remove_all(directory);
+    llama_backend_free();
+    return 0;
+}
@@ -0,0 +1,192 @@
+/**
+ * End-to-end cost of reranking retrieved chunks before prompting.
+ *
+ * For each query, its retrieved candidates (in retrieval order) are either all
+ * sent to the generator, or reranked and only the best `keep` sent. Both
+ * prompts are prefilled on the generator model, so the report compares real
+ * prefill time saved against real rerank time, plus the token counts behind
+ * them.
+ *
+ * The pairs file holds one `query<TAB>passage` per line; consecutive lines
+ * with the same query form that query's candidate list.
+ *
+ * Usage: rerank_bench reranker.gguf generator.gguf pairs.tsv
+ *                     [candidates=10] [keep=3] [threads=4]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../reranker.h"
+#include "llama.h"
+
+namespace {
+
+struct Query {
+    std::string text;
+    std::vector<std::string> passages;
+};
+
+long argOr(int argc, char** argv, int position, long fallback) {
+    return argc > position ? std::strtol(argv[position], nullptr, 10) : fallback;
+}
+
+class Timer {
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+std::vector<Query> readPairs(const char* path, size_t candidates) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot read ") + path);
+    }
+    std::vector<Query> queries;
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        std::string query = line.substr(0, tab);
+        if (queries.empty() || queries.back().text != query) {
+            queries.push_back({std::move(query), {}});
+        }
+        if (queries.back().passages.size() < candidates) {
+            queries.back().passages.push_back(line.substr(tab + 1));
+        }
+    }
+    return queries;
+}
+
+// Same shape as the RAG prompt the app builds: context block, then the question
+std::string buildPrompt(const Query& query, const std::vector<size_t>& order, size_t count) {
+    std::string prompt = "Answer using the context below.\n\nContext:\n";
+    for (size_t i = 0; i < count && i < order.size(); i++) {
+        prompt += "- " + query.passages[order[i]] + "\n";
+    }
+    return prompt + "\nQuestion: " + query.text + "\nAnswer:";
+}
+
+class Generator {
+public:
+    Generator(const char* path, int threads) {
+        model = llama_model_load_from_file(path, llama_model_default_params());
+        if (!model) {
+            throw std::runtime_error(std::string("Failed to load generator from ") + path);
+        }
+        llama_context_params params = llama_context_default_params();
+        params.n_ctx = 8192;
+        params.n_batch = 512;
+        params.n_threads = threads;
+        params.n_threads_batch = threads;
+        context = llama_init_from_model(model, params);
+        if (!context) {
+            throw std::runtime_error("Failed to create generator context");
+        }
+    }
+
+    ~Generator() {
+        llama_free(context);
+        llama_model_free(model);
+    }
+
+    std::vector<llama_token> tokenize(const std::string& text) const {
+        const llama_vocab* vocab = llama_model_get_vocab(model);
+        const int count = -llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, true, false);
+        std::vector<llama_token> tokens(count);
+        llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), count, true, false);
+        return tokens;
+    }
+
+    /**
+     * Prefill from an empty cache, returning elapsed milliseconds
+     */
+    double prefill(std::vector<llama_token>& tokens) {
+        llama_memory_clear(llama_get_memory(context), true);
+        Timer timer;
+        for (size_t at = 0; at < tokens.size(); at += 512) {
+            const int count = static_cast<int>(std::min<size_t>(512, tokens.size() - at));
+            if (llama_decode(context, llama_batch_get_one(tokens.data() + at, count)) != 0) {
+                throw std::runtime_error("Prefill failed");
+            }
+        }
+        llama_synchronize(context);
+        return timer.elapsedMs();
+    }
+
+private:
+    llama_model* model;
+    llama_context* context;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 4) {
+        std::fprintf(stderr, "Usage: %s reranker.gguf generator.gguf pairs.tsv [candidates] [keep] [threads]\n", argv[0]);
+        return 1;
+    }
+    const size_t candidates = static_cast<size_t>(argOr(argc, argv, 4, 10));
+    const size_t keep = static_cast<size_t>(argOr(argc, argv, 5, 3));
+    const int threads = static_cast<int>(argOr(argc, argv, 6, 4));
+
+    llama_backend_init();
+    try {
+        const std::vector<Query> queries = readPairs(argv[3], candidates);
+        Reranker reranker(argv[1], threads);
+        Generator generator(argv[2], threads);
+
+        double fullTokens = 0, keptTokens = 0, pairTokens = 0;
+        double fullMs = 0, keptMs = 0, rerankMs = 0;
+        for (const Query& query : queries) {
+            std::vector<size_t> order(query.passages.size());
+            std::iota(order.begin(), order.end(), 0);
+
+            Timer timer;
+            const std::vector<float> scores = reranker.score(query.text, query.passages);
+            rerankMs += timer.elapsedMs();
+            std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return scores[a] > scores[b]; });
+            for (const std::string& passage : query.passages) {
+                pairTokens += reranker.pairTokens(query.text, passage);
+            }
+
+            std::vector<size_t> retrieval(query.passages.size());
+            std::iota(retrieval.begin(), retrieval.end(), 0);
+            std::vector<llama_token> full = generator.tokenize(buildPrompt(query, retrieval, candidates));
+            std::vector<llama_token> kept = generator.tokenize(buildPrompt(query, order, keep));
+            fullTokens += full.size();
+            keptTokens += kept.size();
+            fullMs += generator.prefill(full);
+            keptMs += generator.prefill(kept);
+        }
+
+        const double n = std::max<size_t>(1, queries.size());
+        std::printf("queries %zu, %zu candidates, keep %zu, %d threads\n", queries.size(), candidates, keep, threads);
+        std::printf("%-28s %10s %10s\n", "per query", "tokens", "ms");
+        std::printf("%-28s %10.0f %10.1f\n", "prefill, all candidates", fullTokens / n, fullMs / n);
+        std::printf("%-28s %10.0f %10.1f\n", "rerank", pairTokens / n, rerankMs / n);
+        std::printf("%-28s %10.0f %10.1f\n", "prefill, reranked top", keptTokens / n, keptMs / n);
+        std::printf("%-28s %10.0f %10.1f\n", "saved (prefill - rerank)",
+                    (fullTokens - keptTokens) / n, (fullMs - keptMs - rerankMs) / n);
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        llama_backend_free();
+        return 1;
+    }
+    llama_backend_free();
+    return 0;
+}
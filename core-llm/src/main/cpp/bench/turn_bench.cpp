@@ -0,0 +1,258 @@
+/**
+ * Time to first token of a RAG turn with retrieval run before the prefill
+ * against retrieval run while the prompt's preamble is prefilled.
+ *
+ * Prompts have the shape AppCoordinator builds: a preamble (system prompt and
+ * the last `history` exchanges, taken from earlier queries in the file), the
+ * retrieved passages, then the question. Retrieval is an exact top-k scan
+ * over `documents` random 384-dimension vectors on its own thread, standing in
+ * for query embedding plus vector search. Sequential: retrieve, then prefill
+ * the whole prompt. Overlapped: prefill the preamble while retrieving, then
+ * prefill the rest once the passages are known. Both start from an empty KV
+ * cache and end when the first token's logits are ready.
+ *
+ * The pairs file holds one `query<TAB>passage` per line; consecutive lines
+ * with the same query form that query's passages.
+ *
+ * Usage: turn_bench generator.gguf pairs.tsv [passages=4] [history=4] [documents=200000] [threads=3]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "llama.h"
+
+namespace {
+
+constexpr size_t kDimension = 384;
+constexpr size_t kTopK = 12;
+
+const char* kSystemPrompt =
+    "You are Iris, an assistant running entirely on this device. Answer the user's question "
+    "using the context when it is relevant, and say so when the context does not cover it.\n\n";
+
+struct Query {
+    std::string text;
+    std::vector<std::string> passages;
+};
+
+long argOr(int argc, char** argv, int position, long fallback) {
+    return argc > position ? std::strtol(argv[position], nullptr, 10) : fallback;
+}
+
+class Timer {
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+std::vector<Query> readPairs(const char* path, size_t passages) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot read ") + path);
+    }
+    std::vector<Query> queries;
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t tab = line.find('\t');
+        if (tab == std::string::npos) {
+            continue;
+        }
+        std::string query = line.substr(0, tab);
+        if (queries.empty() || queries.back().text != query) {
+            queries.push_back({std::move(query), {}});
+        }
+        if (queries.back().passages.size() < passages) {
+            queries.back().passages.push_back(line.substr(tab + 1));
+        }
+    }
+    return queries;
+}
+
+/**
+ * Exact top-k inner product scan, the CPU work a vector search does per query
+ */
+class Retriever {
+public:
+    Retriever(size_t documents, std::mt19937& rng) : vectors(documents * kDimension) {
+        std::normal_distribution<float> value;
+        for (float& v : vectors) {
+            v = value(rng);
+        }
+    }
+
+    std::vector<size_t> search(std::mt19937& rng) const {
+        std::normal_distribution<float> value;
+        std::vector<float> query(kDimension);
+        for (float& v : query) {
+            v = value(rng);
+        }
+        const size_t documents = vectors.size() / kDimension;
+        std::vector<std::pair<float, size_t>> scores(documents);
+        for (size_t d = 0; d < documents; d++) {
+            const float* row = vectors.data() + d * kDimension;
+            float dot = 0.0f;
+            for (size_t i = 0; i < kDimension; i++) {
+                dot += row[i] * query[i];
+            }
+            scores[d] = {dot, d};
+        }
+        const size_t k = std::min(kTopK, documents);
+        std::partial_sort(scores.begin(), scores.begin() + k, scores.end(), std::greater<>());
+        std::vector<size_t> top(k);
+        for (size_t i = 0; i < k; i++) {
+            top[i] = scores[i].second;
+        }
+        return top;
+    }
+
+private:
+    std::vector<float> vectors;
+};
+
+class Generator {
+public:
+    Generator(const char* path, int threads) {
+        model = llama_model_load_from_file(path, llama_model_default_params());
+        if (!model) {
+            throw std::runtime_error(std::string("Failed to load generator from ") + path);
+        }
+        llama_context_params params = llama_context_default_params();
+        params.n_ctx = 8192;
+        params.n_batch = 512;
+        params.n_threads = threads;
+        params.n_threads_batch = threads;
+        context = llama_init_from_model(model, params);
+        if (!context) {
+            throw std::runtime_error("Failed to create generator context");
+        }
+    }
+
+    ~Generator() {
+        llama_free(context);
+        llama_model_free(model);
+    }
+
+    std::vector<llama_token> tokenize(const std::string& text, bool addSpecial) const {
+        const llama_vocab* vocab = llama_model_get_vocab(model);
+        const int count = -llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, addSpecial, false);
+        std::vector<llama_token> tokens(count);
+        llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), count, addSpecial, false);
+        return tokens;
+    }
+
+    void clear() { llama_memory_clear(llama_get_memory(context), true); }
+
+    /**
+     * Decode after what the cache holds
+     */
+    void prefill(std::vector<llama_token> tokens) {
+        for (size_t at = 0; at < tokens.size(); at += 512) {
+            const int count = static_cast<int>(std::min<size_t>(512, tokens.size() - at));
+            if (llama_decode(context, llama_batch_get_one(tokens.data() + at, count)) != 0) {
+                throw std::runtime_error("Prefill failed");
+            }
+        }
+        llama_synchronize(context);
+    }
+
+private:
+    llama_model* model;
+    llama_context* context;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s generator.gguf pairs.tsv [passages] [history] [documents] [threads]\n",
+                     argv[0]);
+        return 1;
+    }
+    const size_t passages = static_cast<size_t>(argOr(argc, argv, 3, 4));
+    const size_t history = static_cast<size_t>(argOr(argc, argv, 4, 4));
+    const size_t documents = static_cast<size_t>(argOr(argc, argv, 5, 200000));
+    const int threads = static_cast<int>(argOr(argc, argv, 6, 3));
+
+    llama_backend_init();
+    try {
+        const std::vector<Query> queries = readPairs(argv[2], passages);
+        Generator generator(argv[1], threads);
+        std::mt19937 rng(5);
+        const Retriever retriever(documents, rng);
+
+        double preambleTokens = 0, promptTokens = 0, retrieveMs = 0;
+        double sequentialMs = 0, overlappedMs = 0, preambleMs = 0;
+        for (size_t q = 0; q < queries.size(); q++) {
+            // Earlier queries answered with their first passage make up the history
+            std::string preamble = kSystemPrompt;
+            for (size_t h = q >= history ? q - history : 0; h < q; h++) {
+                const std::string answer = queries[h].passages.empty() ? "" : queries[h].passages[0];
+                preamble += "User: " + queries[h].text + "\n\nAssistant: " + answer + "\n\n";
+            }
+            const std::vector<llama_token> head = generator.tokenize(preamble + "Context:\n", true);
+            std::vector<llama_token> rest;
+            for (const std::string& passage : queries[q].passages) {
+                const std::vector<llama_token> chunk = generator.tokenize(passage + "\n", false);
+                rest.insert(rest.end(), chunk.begin(), chunk.end());
+            }
+            const std::vector<llama_token> tail =
+                generator.tokenize("\nUser: " + queries[q].text + "\n\nAssistant:", false);
+            rest.insert(rest.end(), tail.begin(), tail.end());
+            std::vector<llama_token> full = head;
+            full.insert(full.end(), rest.begin(), rest.end());
+            preambleTokens += head.size();
+            promptTokens += full.size();
+
+            generator.clear();
+            Timer sequential;
+            Timer retrieval;
+            retriever.search(rng);
+            retrieveMs += retrieval.elapsedMs();
+            generator.prefill(full);
+            sequentialMs += sequential.elapsedMs();
+
+            generator.clear();
+            Timer overlapped;
+            std::thread search([&retriever, q] {
+                std::mt19937 searchRng(static_cast<unsigned>(q));
+                retriever.search(searchRng);
+            });
+            generator.prefill(head);
+            preambleMs += overlapped.elapsedMs();
+            search.join();
+            generator.prefill(rest);
+            overlappedMs += overlapped.elapsedMs();
+        }
+
+        const double n = std::max<size_t>(1, queries.size());
+        std::printf("queries %zu, %zu passages, %zu history exchanges, %zu documents, %d threads\n",
+                    queries.size(), passages, history, documents, threads);
+        std::printf("%-36s %10.0f\n", "preamble tokens / turn", preambleTokens / n);
+        std::printf("%-36s %10.0f\n", "prompt tokens / turn", promptTokens / n);
+        std::printf("%-36s %10.1f\n", "retrieval ms", retrieveMs / n);
+        std::printf("%-36s %10.1f\n", "first token ms, sequential", sequentialMs / n);
+        std::printf("%-36s %10.1f\n", "first token ms, overlapped", overlappedMs / n);
+        std::printf("%-36s %10.1f\n", "preamble prefill ms, overlapped", preambleMs / n);
+        std::printf("%-36s %9.1f%%\n", "reduction", 100.0 * (1.0 - overlappedMs / std::max(1e-9, sequentialMs)));
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        llama_backend_free();
+        return 1;
+    }
+    llama_backend_free();
+    return 0;
+}
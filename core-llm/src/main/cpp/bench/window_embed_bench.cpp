@@ -0,0 +1,184 @@
+/**
+ * Retrieval quality and cost of embedding long sections in sliding windows
+ * (WindowEmbedder) against embedding only the section's first window.
+ *
+ * Every section is embedded four ways: truncated to one window, and windowed
+ * with mean, max and attention pooling. Queries are embedded once. Each query
+ * searches all sections by cosine similarity; its own section is the relevant
+ * one. The report gives recall@1 and recall@5 per way and embedding
+ * milliseconds per 1k section tokens.
+ *
+ * The sections file holds one `query<TAB>section` per line.
+ *
+ * Usage: window_embed_bench embedder.gguf sections.tsv [window=512] [overlap=64] [threads=4]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../window_embedder.h"
+#include "llama.h"
+
+namespace {
+
+struct Section {
+    std::string query;
+    std::string text;
+};
+
+struct Way {
+    const char* name;
+    std::vector<std::vector<float>> vectors;
+    double ms = 0;
+};
+
+long argOr(int argc, char** argv, int position, long fallback) {
+    return argc > position ? std::strtol(argv[position], nullptr, 10) : fallback;
+}
+
+class Timer {
+public:
+    Timer() : start(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+std::vector<Section> readSections(const char* path) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error(std::string("Cannot read ") + path);
+    }
+    std::vector<Section> sections;
+    std::string line;
+    while (std::getline(in, line)) {
+        const size_t tab = line.find('\t');
+        if (tab != std::string::npos) {
+            sections.push_back({line.substr(0, tab), line.substr(tab + 1)});
+        }
+    }
+    return sections;
+}
+
+std::vector<llama_token> tokenize(const llama_vocab* vocab, const std::string& text) {
+    const int count = -llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, false, false);
+    std::vector<llama_token> tokens(count);
+    llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), count, false, false);
+    return tokens;
+}
+
+// The text of the first `count` tokens, so the truncated way embeds what fits one window
+std::string head(const llama_vocab* vocab, const std::vector<llama_token>& tokens, size_t count) {
+    count = std::min(count, tokens.size());
+    std::string text(count * 16 + 16, '\0');
+    int length = llama_detokenize(vocab, tokens.data(), count, text.data(), text.size(), false, false);
+    if (length < 0) {
+        text.resize(-length);
+        length = llama_detokenize(vocab, tokens.data(), count, text.data(), text.size(), false, false);
+    }
+    text.resize(std::max(length, 0));
+    return text;
+}
+
+// Rank of `target` among all sections by dot product (vectors are normalized)
+size_t rankOf(const std::vector<float>& query, const std::vector<std::vector<float>>& sections, size_t target) {
+    auto dot = [&query](const std::vector<float>& section) {
+        float sum = 0.0f;
+        for (size_t i = 0; i < query.size(); i++) {
+            sum += query[i] * section[i];
+        }
+        return sum;
+    };
+    const float score = dot(sections[target]);
+    size_t rank = 0;
+    for (size_t s = 0; s < sections.size(); s++) {
+        if (s != target && dot(sections[s]) > score) {
+            rank++;
+        }
+    }
+    return rank;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s embedder.gguf sections.tsv [window] [overlap] [threads]\n", argv[0]);
+        return 1;
+    }
+    const int window = static_cast<int>(argOr(argc, argv, 3, 512));
+    const int overlap = static_cast<int>(argOr(argc, argv, 4, 64));
+    const int threads = static_cast<int>(argOr(argc, argv, 5, 4));
+
+    llama_backend_init();
+    llama_model* model = llama_model_load_from_file(argv[1], llama_model_default_params());
+    if (!model) {
+        std::fprintf(stderr, "Failed to load embedder from %s\n", argv[1]);
+        llama_backend_free();
+        return 1;
+    }
+    try {
+        const std::vector<Section> sections = readSections(argv[2]);
+        const llama_vocab* vocab = llama_model_get_vocab(model);
+        WindowEmbedder embedder(model, threads, window, overlap);
+
+        double sectionTokens = 0, windows = 0;
+        std::vector<std::vector<llama_token>> tokens;
+        for (const Section& section : sections) {
+            tokens.push_back(tokenize(vocab, section.text));
+            sectionTokens += tokens.back().size();
+            windows += embedder.windowCount(section.text);
+        }
+
+        std::vector<Way> ways = {{"truncated", {}}, {"mean", {}}, {"max", {}}, {"attention", {}}};
+        const WindowPooling poolings[] = {WindowPooling::Mean, WindowPooling::Max, WindowPooling::Attention};
+        for (size_t s = 0; s < sections.size(); s++) {
+            // Four tokens spare for the specials a window adds
+            const std::string truncated = head(vocab, tokens[s], std::min(window, llama_model_n_ctx_train(model)) - 4);
+            Timer timer;
+            ways[0].vectors.push_back(embedder.embed(truncated, WindowPooling::Mean));
+            ways[0].ms += timer.elapsedMs();
+            for (size_t p = 0; p < 3; p++) {
+                Timer pooled;
+                ways[p + 1].vectors.push_back(embedder.embed(sections[s].text, poolings[p]));
+                ways[p + 1].ms += pooled.elapsedMs();
+            }
+        }
+        std::vector<std::vector<float>> queries;
+        for (const Section& section : sections) {
+            queries.push_back(embedder.embed(section.query, WindowPooling::Mean));
+        }
+
+        const double n = std::max<size_t>(1, sections.size());
+        std::printf("sections %zu, %.0f tokens and %.1f windows each, %d-token windows, %d overlap, %d threads\n",
+                    sections.size(), sectionTokens / n, windows / n, window, overlap, threads);
+        std::printf("%-12s %10s %10s %16s\n", "way", "recall@1", "recall@5", "ms / 1k tokens");
+        for (const Way& way : ways) {
+            double top1 = 0, top5 = 0;
+            for (size_t q = 0; q < queries.size(); q++) {
+                const size_t rank = rankOf(queries[q], way.vectors, q);
+                top1 += rank < 1;
+                top5 += rank < 5;
+            }
+            std::printf("%-12s %9.1f%% %9.1f%% %16.1f\n", way.name, 100.0 * top1 / n, 100.0 * top5 / n,
+                        way.ms * 1000.0 / std::max(1.0, sectionTokens));
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        llama_model_free(model);
+        llama_backend_free();
+        return 1;
+    }
+    llama_model_free(model);
+    llama_backend_free();
+    return 0;
+}
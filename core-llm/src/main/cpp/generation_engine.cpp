@@ -12,6 +12,7 @@ GenerationEngine::GenerationEngine(ModelManager* modelManager,
     : modelManager(modelManager),
       context(modelManager->getContext()),
       currentTokenIndex(0),
+      promptSize(0),
       maxTokens(maxTokens),
       isComplete(false),
       temperature(temperature),
@@ -28,27 +29,26 @@ long GenerationEngine::startGeneration(const std::string& prompt) {
         throw std::runtime_error("Model not initialized");
     }
     
+    return startGeneration(modelManager->tokenize(prompt, true));
+}
+
+long GenerationEngine::startGeneration(const std::vector<llama_token>& promptTokens,
+                                       const std::vector<std::pair<size_t, size_t>>& segments) {
+    if (!modelManager || !context) {
+        throw std::runtime_error("Model not initialized");
+    }
+    if (promptTokens.empty()) {
+        throw std::runtime_error("Empty prompt");
+    }
+    
     try {
-        llama_model* model = modelManager->getModel();
-        const llama_vocab* vocab = llama_model_get_vocab(model);
-        
-        // Tokenize prompt
-        const int n_tokens = -llama_tokenize(vocab, prompt.c_str(), prompt.length(), NULL, 0, true, false);
-        tokens.resize(n_tokens);
-        
-        if (llama_tokenize(vocab, prompt.c_str(), prompt.length(),
-                          tokens.data(), tokens.size(), true, false) < 0) {
-            throw std::runtime_error("Failed to tokenize prompt");
-        }
+        tokens = promptTokens;
         
-        // Process prompt tokens
-        llama_batch batch = llama_batch_get_one(tokens.data(), tokens.size());
-        
-        if (llama_decode(context, batch) != 0) {
-            throw std::runtime_error("Failed to process prompt");
-        }
+        // Process prompt tokens after the prefix the context already holds
+        const size_t reused = modelManager->prefill(tokens, segments, true);
         
         currentTokenIndex = tokens.size();
+        promptSize = tokens.size();
         isComplete = false;
         
         // Return session ID based on timestamp
@@ -56,7 +56,8 @@ long GenerationEngine::startGeneration(const std::string& prompt) {
         long sessionId = std::chrono::duration_cast<std::chrono::milliseconds>(
             now.time_since_epoch()).count();
         
-        LOGI("Generation started with session ID: %ld", sessionId);
+        LOGI("Generation started with session ID: %ld (%zu of %zu prompt tokens reused)",
+             sessionId, reused, tokens.size());
         return sessionId;
         
     } catch (const std::exception& e) {
@@ -72,7 +73,7 @@ std::string GenerationEngine::generateNextToken() {
     
     try {
         // Check if we've reached max tokens
-        if (currentTokenIndex >= static_cast<size_t>(maxTokens)) {
+        if (currentTokenIndex - promptSize >= static_cast<size_t>(maxTokens)) {
             isComplete = true;
             return "";
         }
@@ -103,9 +104,12 @@ std::string GenerationEngine::generateNextToken() {
         
         if (llama_decode(context, batch) != 0) {
             LOGE("Failed to decode token");
+            llama_memory_clear(llama_get_memory(context), true);
+            modelManager->getContextTokens().clear();
             isComplete = true;
             return "";
         }
+        modelManager->getContextTokens().push_back(token);
         
         currentTokenIndex++;
         
@@ -2,6 +2,7 @@
 #define IRIS_GENERATION_ENGINE_H
 
 #include <string>
+#include <utility>
 #include <vector>
 #include "llama.h"
 #include "model_manager.h"
@@ -30,6 +31,16 @@ public:
      */
     long startGeneration(const std::string& prompt);
     
+    /**
+     * Start generation with a prompt tokenized by ModelManager::tokenize,
+     * prefilled with ModelManager::prefill
+     * @param promptTokens Input prompt tokens, BOS included
+     * @param segments (start, length) spans of promptTokens, e.g. retrieved chunks, in prompt order
+     * @return Session ID
+     */
+    long startGeneration(const std::vector<llama_token>& promptTokens,
+                         const std::vector<std::pair<size_t, size_t>>& segments = {});
+    
     /**
      * Generate next token
      * @return Generated token, empty if complete
@@ -51,6 +62,7 @@ private:
     llama_context* context;
     std::vector<llama_token> tokens;
     size_t currentTokenIndex;
+    size_t promptSize;
     int maxTokens;
     bool isComplete;
     
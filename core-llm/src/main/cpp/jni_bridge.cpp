@@ -7,6 +7,7 @@
 #include "llama.h"
 #include "model_manager.h"
 #include "generation_engine.h"
+#include "reranker.h"
 
 #define LOG_TAG "IrisLLM"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -43,6 +44,22 @@ void throwException(JNIEnv* env, const char* exceptionClass, const char* message
     env->ThrowNew(clazz, message);
 }
 
+// Generation engine configured from a Kotlin GenerationParams
+std::unique_ptr<GenerationEngine> createGenerationEngine(JNIEnv* env, ModelManager* model, jobject gen_params) {
+    jclass genParamsClass = env->GetObjectClass(gen_params);
+    jfieldID tempField = env->GetFieldID(genParamsClass, "temperature", "F");
+    jfieldID topKField = env->GetFieldID(genParamsClass, "topK", "I");
+    jfieldID topPField = env->GetFieldID(genParamsClass, "topP", "F");
+    jfieldID maxTokensField = env->GetFieldID(genParamsClass, "maxTokens", "I");
+    
+    float temperature = env->GetFloatField(gen_params, tempField);
+    int topK = env->GetIntField(gen_params, topKField);
+    float topP = env->GetFloatField(gen_params, topPField);
+    int maxTokens = env->GetIntField(gen_params, maxTokensField);
+    
+    return std::make_unique<GenerationEngine>(model, temperature, topK, topP, maxTokens);
+}
+
 extern "C" {
 
 // Backend initialization
@@ -137,21 +154,8 @@ Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeStartGeneration(
             return -1;
         }
         
-        // Extract generation parameters
-        jclass genParamsClass = env->GetObjectClass(gen_params);
-        jfieldID tempField = env->GetFieldID(genParamsClass, "temperature", "F");
-        jfieldID topKField = env->GetFieldID(genParamsClass, "topK", "I");
-        jfieldID topPField = env->GetFieldID(genParamsClass, "topP", "F");
-        jfieldID maxTokensField = env->GetFieldID(genParamsClass, "maxTokens", "I");
-        
-        float temperature = env->GetFloatField(gen_params, tempField);
-        int topK = env->GetIntField(gen_params, topKField);
-        float topP = env->GetFloatField(gen_params, topPField);
-        int maxTokens = env->GetIntField(gen_params, maxTokensField);
-        
         // Create generation engine
-        auto genEngine = std::make_unique<GenerationEngine>(
-            modelIt->second.get(), temperature, topK, topP, maxTokens);
+        auto genEngine = createGenerationEngine(env, modelIt->second.get(), gen_params);
         
         long sessionId = genEngine->startGeneration(promptStr);
         state.sessions[std::to_string(sessionId)] = std::move(genEngine);
@@ -170,6 +174,185 @@ Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeStartGeneration(
     }
 }
 
+// Text generation from a tokenized prompt
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeStartGenerationFromTokens(
+    JNIEnv* env, jobject thiz, jstring model_id, jintArray prompt_tokens, jintArray segments, jobject gen_params) {
+    
+    const char* modelIdStr = env->GetStringUTFChars(model_id, nullptr);
+    
+    try {
+        std::vector<llama_token> tokens(env->GetArrayLength(prompt_tokens));
+        env->GetIntArrayRegion(prompt_tokens, 0, tokens.size(), tokens.data());
+        
+        // (start, length) pairs
+        std::vector<jint> spans(env->GetArrayLength(segments));
+        env->GetIntArrayRegion(segments, 0, spans.size(), spans.data());
+        std::vector<std::pair<size_t, size_t>> segmentSpans;
+        for (size_t i = 0; i + 1 < spans.size(); i += 2) {
+            if (spans[i] >= 0 && spans[i + 1] > 0) {
+                segmentSpans.emplace_back(spans[i], spans[i + 1]);
+            }
+        }
+        
+        auto& state = NativeState::getInstance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        
+        auto modelIt = state.models.find(modelIdStr);
+        if (modelIt == state.models.end()) {
+            throwException(env, "java/lang/RuntimeException", "Model not found");
+            env->ReleaseStringUTFChars(model_id, modelIdStr);
+            return -1;
+        }
+        
+        auto genEngine = createGenerationEngine(env, modelIt->second.get(), gen_params);
+        long sessionId = genEngine->startGeneration(tokens, segmentSpans);
+        state.sessions[std::to_string(sessionId)] = std::move(genEngine);
+        
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        return sessionId;
+        
+    } catch (const std::exception& e) {
+        LOGE("Generation start failed: %s", e.what());
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return -1;
+    }
+}
+
+// Prompt prefill ahead of generation
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativePrefill(
+    JNIEnv* env, jobject thiz, jstring model_id, jintArray prompt_tokens) {
+    
+    const char* modelIdStr = env->GetStringUTFChars(model_id, nullptr);
+    
+    try {
+        std::vector<llama_token> tokens(env->GetArrayLength(prompt_tokens));
+        env->GetIntArrayRegion(prompt_tokens, 0, tokens.size(), tokens.data());
+        
+        auto& state = NativeState::getInstance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        
+        auto modelIt = state.models.find(modelIdStr);
+        if (modelIt == state.models.end()) {
+            throwException(env, "java/lang/RuntimeException", "Model not found");
+            env->ReleaseStringUTFChars(model_id, modelIdStr);
+            return -1;
+        }
+        
+        size_t reused = modelIt->second->prefill(tokens, {}, false);
+        
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        return static_cast<jint>(reused);
+        
+    } catch (const std::exception& e) {
+        LOGE("Prefill failed: %s", e.what());
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return -1;
+    }
+}
+
+// KV segment cache
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeEnableSegmentCache(
+    JNIEnv* env, jobject thiz, jstring model_id, jstring directory, jlong max_disk_bytes, jint compute_after_uses) {
+    
+    const char* modelIdStr = env->GetStringUTFChars(model_id, nullptr);
+    const char* directoryStr = env->GetStringUTFChars(directory, nullptr);
+    
+    try {
+        auto& state = NativeState::getInstance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        
+        bool enabled = false;
+        auto modelIt = state.models.find(modelIdStr);
+        if (modelIt != state.models.end()) {
+            enabled = modelIt->second->enableSegmentCache(directoryStr, static_cast<size_t>(max_disk_bytes),
+                                                          compute_after_uses);
+        }
+        
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        env->ReleaseStringUTFChars(directory, directoryStr);
+        return enabled ? JNI_TRUE : JNI_FALSE;
+        
+    } catch (const std::exception& e) {
+        LOGE("Segment cache setup failed: %s", e.what());
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        env->ReleaseStringUTFChars(directory, directoryStr);
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativePrecomputeSegment(
+    JNIEnv* env, jobject thiz, jstring model_id, jintArray segment_tokens) {
+    
+    const char* modelIdStr = env->GetStringUTFChars(model_id, nullptr);
+    
+    try {
+        std::vector<llama_token> tokens(env->GetArrayLength(segment_tokens));
+        env->GetIntArrayRegion(segment_tokens, 0, tokens.size(), tokens.data());
+        
+        auto& state = NativeState::getInstance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        
+        size_t bytes = 0;
+        auto modelIt = state.models.find(modelIdStr);
+        if (modelIt != state.models.end() && modelIt->second->getSegmentCache()) {
+            bytes = modelIt->second->getSegmentCache()->precompute(tokens.data(), tokens.size());
+        }
+        
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        return static_cast<jlong>(bytes);
+        
+    } catch (const std::exception& e) {
+        LOGE("Segment precompute failed: %s", e.what());
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        return 0;
+    }
+}
+
+// Tokenization
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeTokenize(
+    JNIEnv* env, jobject thiz, jstring model_id, jstring text, jboolean add_special) {
+    
+    const char* modelIdStr = env->GetStringUTFChars(model_id, nullptr);
+    const char* textStr = env->GetStringUTFChars(text, nullptr);
+    
+    try {
+        auto& state = NativeState::getInstance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        
+        auto modelIt = state.models.find(modelIdStr);
+        if (modelIt == state.models.end()) {
+            throwException(env, "java/lang/RuntimeException", "Model not found");
+            env->ReleaseStringUTFChars(model_id, modelIdStr);
+            env->ReleaseStringUTFChars(text, textStr);
+            return nullptr;
+        }
+        
+        std::vector<llama_token> tokens = modelIt->second->tokenize(textStr, add_special == JNI_TRUE);
+        
+        jintArray result = env->NewIntArray(tokens.size());
+        env->SetIntArrayRegion(result, 0, tokens.size(), tokens.data());
+        
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        env->ReleaseStringUTFChars(text, textStr);
+        
+        return result;
+        
+    } catch (const std::exception& e) {
+        LOGE("Tokenization failed: %s", e.what());
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        env->ReleaseStringUTFChars(text, textStr);
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return nullptr;
+    }
+}
+
 // Token generation
 JNIEXPORT jstring JNICALL
 Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeGenerateNextToken(
@@ -239,6 +422,50 @@ Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeGenerateEmbedding(
     }
 }
 
+// Long-text embedding with a choice of window pooling
+JNIEXPORT jfloatArray JNICALL
+Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeEmbedDocument(
+    JNIEnv* env, jobject thiz, jstring model_id, jstring text, jint pooling) {
+    
+    if (pooling < static_cast<jint>(WindowPooling::Mean) || pooling > static_cast<jint>(WindowPooling::Attention)) {
+        throwException(env, "java/lang/IllegalArgumentException", "Unknown window pooling");
+        return nullptr;
+    }
+    
+    const char* modelIdStr = env->GetStringUTFChars(model_id, nullptr);
+    const char* textStr = env->GetStringUTFChars(text, nullptr);
+    
+    try {
+        auto& state = NativeState::getInstance();
+        std::lock_guard<std::mutex> lock(state.mutex);
+        
+        auto modelIt = state.models.find(modelIdStr);
+        if (modelIt == state.models.end()) {
+            throwException(env, "java/lang/RuntimeException", "Model not found");
+            env->ReleaseStringUTFChars(model_id, modelIdStr);
+            env->ReleaseStringUTFChars(text, textStr);
+            return nullptr;
+        }
+        
+        std::vector<float> embedding = modelIt->second->generateEmbedding(textStr, static_cast<WindowPooling>(pooling));
+        
+        jfloatArray result = env->NewFloatArray(embedding.size());
+        env->SetFloatArrayRegion(result, 0, embedding.size(), embedding.data());
+        
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        env->ReleaseStringUTFChars(text, textStr);
+        
+        return result;
+        
+    } catch (const std::exception& e) {
+        LOGE("Document embedding failed: %s", e.what());
+        env->ReleaseStringUTFChars(model_id, modelIdStr);
+        env->ReleaseStringUTFChars(text, textStr);
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return nullptr;
+    }
+}
+
 // Model unloading
 JNIEXPORT jboolean JNICALL
 Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeUnloadModel(
@@ -278,6 +505,69 @@ Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeUnloadModel(
     }
 }
 
+// Reranker loading
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_llm_LlamaReranker_nativeLoad(
+    JNIEnv* env, jclass clazz, jstring model_path, jint threads, jint max_pair_tokens, jint pairs_per_batch) {
+    
+    const char* path = env->GetStringUTFChars(model_path, nullptr);
+    
+    try {
+        auto reranker = std::make_unique<Reranker>(path, threads, max_pair_tokens, pairs_per_batch);
+        env->ReleaseStringUTFChars(model_path, path);
+        return reinterpret_cast<jlong>(reranker.release());
+        
+    } catch (const std::exception& e) {
+        LOGE("Reranker loading failed: %s", e.what());
+        env->ReleaseStringUTFChars(model_path, path);
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return 0;
+    }
+}
+
+// Reranking
+JNIEXPORT jfloatArray JNICALL
+Java_com_nervesparks_iris_core_llm_LlamaReranker_nativeScore(
+    JNIEnv* env, jobject thiz, jlong handle, jstring query, jobjectArray passages) {
+    
+    const char* queryStr = env->GetStringUTFChars(query, nullptr);
+    
+    try {
+        std::vector<std::string> texts;
+        const jsize count = env->GetArrayLength(passages);
+        texts.reserve(count);
+        for (jsize i = 0; i < count; i++) {
+            auto passage = static_cast<jstring>(env->GetObjectArrayElement(passages, i));
+            const char* passageStr = env->GetStringUTFChars(passage, nullptr);
+            texts.emplace_back(passageStr);
+            env->ReleaseStringUTFChars(passage, passageStr);
+            env->DeleteLocalRef(passage);
+        }
+        
+        std::vector<float> scores = reinterpret_cast<Reranker*>(handle)->score(queryStr, texts);
+        
+        jfloatArray result = env->NewFloatArray(scores.size());
+        env->SetFloatArrayRegion(result, 0, scores.size(), scores.data());
+        
+        env->ReleaseStringUTFChars(query, queryStr);
+        return result;
+        
+    } catch (const std::exception& e) {
+        LOGE("Reranking failed: %s", e.what());
+        env->ReleaseStringUTFChars(query, queryStr);
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return nullptr;
+    }
+}
+
+// Reranker unloading
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_llm_LlamaReranker_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+    
+    delete reinterpret_cast<Reranker*>(handle);
+}
+
 // Shutdown
 JNIEXPORT void JNICALL
 Java_com_nervesparks_iris_core_llm_LLMEngineImpl_nativeShutdown(
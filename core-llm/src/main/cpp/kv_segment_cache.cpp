@@ -0,0 +1,258 @@
+#include "kv_segment_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#define LOG_TAG "IrisKvSegmentCache"
+#if defined(__ANDROID__)
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+// Host builds (benchmarks) log to stderr
+#define LOGI(...) (std::fprintf(stderr, LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+#define LOGE(...) LOGI(__VA_ARGS__)
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint32_t kMagic = 0x53564b49; // "IKVS" little-endian
+constexpr uint32_t kVersion = 1;
+constexpr const char* kExtension = ".kvseg";
+
+// Offer counts of segments not stored yet are dropped past this many
+constexpr size_t kMaxTrackedSegments = 4096;
+
+// File layout: header, the segment's tokens (to rule out hash collisions), sequence state
+struct SegmentHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t tokenCount;
+    uint64_t stateBytes;
+};
+
+uint64_t hashTokens(const llama_token* tokens, size_t count) {
+    uint64_t hash = 0xcbf29ce484222325ull; // FNV-1a
+    for (size_t i = 0; i < count; i++) {
+        uint32_t token = static_cast<uint32_t>(tokens[i]);
+        for (int byte = 0; byte < 4; byte++, token >>= 8) {
+            hash = (hash ^ (token & 0xff)) * 0x100000001b3ull;
+        }
+    }
+    return hash ^ count;
+}
+
+// Frees a llama_batch on every exit path
+struct BatchGuard {
+    llama_batch batch;
+    ~BatchGuard() { llama_batch_free(batch); }
+};
+
+} // namespace
+
+KvSegmentCache::KvSegmentCache(llama_context* context, const std::string& directory, size_t maxDiskBytes,
+                               int computeAfterUses)
+    : context(context), directory(directory), maxDiskBytes(maxDiskBytes),
+      computeAfterUses(std::max(computeAfterUses, 0)) {
+    llama_memory_t memory = llama_get_memory(context);
+    if (!memory || !llama_memory_can_shift(memory)) {
+        throw std::runtime_error("KV segments need a memory that can shift positions");
+    }
+    std::error_code error;
+    fs::create_directories(directory, error);
+    if (error) {
+        throw std::runtime_error("Cannot create " + directory + ": " + error.message());
+    }
+
+    // Files from earlier runs, oldest first, so eviction order survives restarts
+    std::vector<std::pair<fs::file_time_type, std::pair<uint64_t, size_t>>> found;
+    for (const fs::directory_entry& file : fs::directory_iterator(directory, error)) {
+        if (file.path().extension() != kExtension) {
+            continue;
+        }
+        try {
+            const uint64_t key = std::stoull(file.path().stem().string(), nullptr, 16);
+            found.push_back({file.last_write_time(), {key, static_cast<size_t>(file.file_size())}});
+        } catch (const std::exception&) {
+            fs::remove(file.path(), error);
+        }
+    }
+    std::sort(found.begin(), found.end());
+    for (const auto& [time, file] : found) {
+        entries[file.first] = {file.second, ++clock};
+    }
+    evict();
+    LOGI("KV segment cache at %s: %zu segments", directory.c_str(), entries.size());
+}
+
+bool KvSegmentCache::splice(const llama_token* tokens, size_t count, llama_pos position) {
+    if (count == 0) {
+        return false;
+    }
+    const uint64_t key = hashTokens(tokens, count);
+    if (entries.count(key) && load(key, tokens, count)) {
+        entries[key].lastUse = ++clock;
+        std::error_code error;
+        fs::last_write_time(pathFor(key), fs::file_time_type::clock::now(), error);
+        place(position);
+        counters.hits++;
+        return true;
+    }
+
+    if (computeAfterUses == 0) {
+        counters.misses++;
+        return false;
+    }
+    if (uses.size() >= kMaxTrackedSegments) {
+        uses.clear();
+    }
+    if (++uses[key] < computeAfterUses || compute(key, tokens, count) == 0) {
+        counters.misses++;
+        return false;
+    }
+    uses.erase(key);
+    place(position);
+    return true;
+}
+
+size_t KvSegmentCache::precompute(const llama_token* tokens, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t key = hashTokens(tokens, count);
+    auto it = entries.find(key);
+    if (it != entries.end()) {
+        return it->second.bytes;
+    }
+    const size_t bytes = compute(key, tokens, count);
+    llama_memory_seq_rm(llama_get_memory(context), kScratchSeq, -1, -1);
+    uses.erase(key);
+    return bytes;
+}
+
+KvSegmentCache::Stats KvSegmentCache::stats() const {
+    Stats result = counters;
+    result.segments = entries.size();
+    result.diskBytes = 0;
+    for (const auto& [key, entry] : entries) {
+        result.diskBytes += entry.bytes;
+    }
+    return result;
+}
+
+std::string KvSegmentCache::pathFor(uint64_t key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx%s", static_cast<unsigned long long>(key), kExtension);
+    return directory + "/" + name;
+}
+
+bool KvSegmentCache::load(uint64_t key, const llama_token* tokens, size_t count) {
+    std::ifstream in(pathFor(key), std::ios::binary);
+    SegmentHeader header{};
+    std::vector<llama_token> stored(count);
+    std::vector<uint8_t> state;
+    bool valid = in.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+                 header.magic == kMagic && header.version == kVersion && header.tokenCount == count &&
+                 in.read(reinterpret_cast<char*>(stored.data()), count * sizeof(llama_token)) &&
+                 std::equal(stored.begin(), stored.end(), tokens);
+    if (valid) {
+        state.resize(header.stateBytes);
+        valid = static_cast<bool>(in.read(reinterpret_cast<char*>(state.data()), state.size()));
+    }
+
+    llama_memory_seq_rm(llama_get_memory(context), kScratchSeq, -1, -1);
+    if (!valid || llama_state_seq_set_data(context, state.data(), state.size(), kScratchSeq) == 0) {
+        // Another segment with the same hash, a partial write, or another model's file
+        LOGE("Dropping unusable KV segment %016llx", static_cast<unsigned long long>(key));
+        llama_memory_seq_rm(llama_get_memory(context), kScratchSeq, -1, -1);
+        forget(key);
+        return false;
+    }
+    return true;
+}
+
+size_t KvSegmentCache::compute(uint64_t key, const llama_token* tokens, size_t count) {
+    llama_memory_t memory = llama_get_memory(context);
+    llama_memory_seq_rm(memory, kScratchSeq, -1, -1);
+
+    const size_t batchSize = llama_n_batch(context);
+    BatchGuard guard{llama_batch_init(static_cast<int32_t>(batchSize), 0, 1)};
+    llama_batch& batch = guard.batch;
+    for (size_t at = 0; at < count; at += batchSize) {
+        const size_t n = std::min(batchSize, count - at);
+        batch.n_tokens = static_cast<int32_t>(n);
+        for (size_t i = 0; i < n; i++) {
+            batch.token[i] = tokens[at + i];
+            batch.pos[i] = static_cast<llama_pos>(at + i);
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = kScratchSeq;
+            batch.logits[i] = false;
+        }
+        if (llama_decode(context, batch) != 0) {
+            LOGE("Failed to decode KV segment of %zu tokens", count);
+            llama_memory_seq_rm(memory, kScratchSeq, -1, -1);
+            return 0;
+        }
+    }
+
+    std::vector<uint8_t> state(llama_state_seq_get_size(context, kScratchSeq));
+    if (llama_state_seq_get_data(context, state.data(), state.size(), kScratchSeq) != state.size()) {
+        llama_memory_seq_rm(memory, kScratchSeq, -1, -1);
+        return 0;
+    }
+    counters.computed++;
+
+    // Written under a temporary name so a crash never leaves a truncated segment
+    const std::string path = pathFor(key);
+    const std::string partial = path + ".tmp";
+    const SegmentHeader header{kMagic, kVersion, count, state.size()};
+    std::ofstream out(partial, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(tokens), count * sizeof(llama_token));
+    out.write(reinterpret_cast<const char*>(state.data()), state.size());
+    out.close();
+    std::error_code error;
+    if (!out || (fs::rename(partial, path, error), error)) {
+        LOGE("Failed to store KV segment in %s", path.c_str());
+        fs::remove(partial, error);
+        return state.size(); // still usable for this prompt
+    }
+
+    const size_t bytes = sizeof(header) + count * sizeof(llama_token) + state.size();
+    entries[key] = {bytes, ++clock};
+    evict();
+    return bytes;
+}
+
+void KvSegmentCache::place(llama_pos position) {
+    llama_memory_t memory = llama_get_memory(context);
+    if (position != 0) {
+        llama_memory_seq_add(memory, kScratchSeq, 0, -1, position);
+    }
+    llama_memory_seq_cp(memory, kScratchSeq, 0, -1, -1);
+    llama_memory_seq_rm(memory, kScratchSeq, -1, -1);
+}
+
+void KvSegmentCache::forget(uint64_t key) {
+    std::error_code error;
+    fs::remove(pathFor(key), error);
+    entries.erase(key);
+}
+
+void KvSegmentCache::evict() {
+    size_t total = 0;
+    for (const auto& [key, entry] : entries) {
+        total += entry.bytes;
+    }
+    while (total > maxDiskBytes && !entries.empty()) {
+        auto oldest = std::min_element(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+            return a.second.lastUse < b.second.lastUse;
+        });
+        total -= oldest->second.bytes;
+        forget(oldest->first);
+    }
+}
@@ -0,0 +1,97 @@
+#ifndef IRIS_KV_SEGMENT_CACHE_H
+#define IRIS_KV_SEGMENT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "llama.h"
+
+/**
+ * Precomputed KV state of prompt segments (retrieved chunks) kept on disk, so a
+ * chunk that recurs in prompts is spliced into the context instead of decoded
+ * again.
+ *
+ * A segment is decoded alone, at positions 0..n-1 of a scratch sequence, and
+ * its sequence state saved to `<directory>/<hash>.kvseg`. Splicing loads it
+ * into the scratch sequence, shifts its positions to where the segment sits in
+ * the prompt (the context re-applies RoPE on its next update) and copies it to
+ * sequence 0. The result is an approximation of decoding the segment in place:
+ * its tokens attend to each other but not to what precedes them in the prompt,
+ * while everything decoded after them attends to them normally.
+ *
+ * A segment is computed the `computeAfterUses`-th time it is offered, or right
+ * away through precompute() for chunks known to recur (pinned documents); with
+ * `computeAfterUses` 0 only precomputed segments are ever spliced. Files
+ * are evicted least recently used past `maxDiskBytes`. Files are only valid for
+ * the model and KV type they were made with, so `directory` must be per model;
+ * a file the context rejects is deleted.
+ *
+ * Needs a context with a unified KV cache of at least two sequences and a
+ * memory that can shift positions. Not thread-safe; callers serialize use of
+ * the context anyway.
+ */
+class KvSegmentCache {
+public:
+    struct Stats {
+        size_t hits = 0;     // segments spliced from disk
+        size_t computed = 0; // segments decoded alone and stored
+        size_t misses = 0;   // segments left for the caller to decode
+        size_t segments = 0; // files on disk
+        size_t diskBytes = 0;
+    };
+
+    // Sequence segments are decoded and loaded in before being copied to sequence 0
+    static constexpr llama_seq_id kScratchSeq = 1;
+
+    /**
+     * @throws std::runtime_error if the context cannot shift positions or the directory cannot be created
+     */
+    KvSegmentCache(llama_context* context, const std::string& directory, size_t maxDiskBytes,
+                   int computeAfterUses = 0);
+
+    KvSegmentCache(const KvSegmentCache&) = delete;
+    KvSegmentCache& operator=(const KvSegmentCache&) = delete;
+
+    /**
+     * Put the KV of `tokens` into sequence 0 at positions [position, position + count),
+     * from disk or by computing the segment now if it has been offered often enough.
+     * Positions before `position` must already be in sequence 0.
+     * @return False when the caller must decode the tokens itself
+     */
+    bool splice(const llama_token* tokens, size_t count, llama_pos position);
+
+    /**
+     * Compute and store a segment ahead of use; a no-op if it is stored already
+     * @return Bytes of its state, or 0 if it could not be decoded
+     */
+    size_t precompute(const llama_token* tokens, size_t count);
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        size_t bytes;
+        uint64_t lastUse;
+    };
+
+    llama_context* context;
+    std::string directory;
+    size_t maxDiskBytes;
+    int computeAfterUses;
+
+    std::unordered_map<uint64_t, Entry> entries; // files on disk by key
+    std::unordered_map<uint64_t, int> uses;      // offers of segments not stored yet
+    uint64_t clock = 0;
+    Stats counters;
+
+    std::string pathFor(uint64_t key) const;
+    bool load(uint64_t key, const llama_token* tokens, size_t count);
+    size_t compute(uint64_t key, const llama_token* tokens, size_t count);
+    void place(llama_pos position);
+    void forget(uint64_t key);
+    void evict();
+};
+
+#endif // IRIS_KV_SEGMENT_CACHE_H
@@ -1,5 +1,6 @@
 #include "model_manager.h"
 #include <android/log.h>
+#include <algorithm>
 #include <random>
 #include <chrono>
 #include <sstream>
@@ -9,7 +10,14 @@
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-ModelManager::ModelManager() : model(nullptr), context(nullptr) {
+namespace {
+
+// KV budget of the embedding context, which is allocated on top of the generation context
+constexpr size_t kEmbeddingKvBytes = 64u << 20;
+
+} // namespace
+
+ModelManager::ModelManager() : model(nullptr), context(nullptr), threads(0) {
     // Generate unique model ID
     auto now = std::chrono::system_clock::now();
     auto timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -47,7 +55,11 @@ std::string ModelManager::loadModel(const std::string& path, int contextSize,
         llama_context_params contextParams = llama_context_default_params();
         contextParams.n_ctx = contextSize;
         contextParams.n_threads = (threads <= 0) ? 4 : threads;
+        this->threads = contextParams.n_threads;
         contextParams.n_batch = contextSize; // Set batch size
+        // Sequence 1 stages KV segments; one unified cache keeps the whole window for sequence 0
+        contextParams.n_seq_max = 2;
+        contextParams.kv_unified = true;
         
         // Create context
         context = llama_init_from_model(model, contextParams);
@@ -67,6 +79,10 @@ std::string ModelManager::loadModel(const std::string& path, int contextSize,
 }
 
 void ModelManager::unloadModel() {
+    segmentCache.reset();
+    windowEmbedder.reset();
+    contextTokens.clear();
+    
     if (context) {
         llama_free(context);
         context = nullptr;
@@ -80,53 +96,127 @@ void ModelManager::unloadModel() {
     LOGI("Model unloaded: %s", modelId.c_str());
 }
 
-std::vector<float> ModelManager::generateEmbedding(const std::string& text) {
-    if (!model || !context) {
+std::vector<float> ModelManager::generateEmbedding(const std::string& text, WindowPooling pooling) {
+    if (!model) {
         throw std::runtime_error("Model not loaded");
     }
     
     try {
-        // Get vocabulary from model
-        const llama_vocab* vocab = llama_model_get_vocab(model);
-        
-        // Tokenize input
-        std::vector<llama_token> tokens;
-        const int n_tokens = -llama_tokenize(vocab, text.c_str(), text.length(), NULL, 0, true, false);
-        tokens.resize(n_tokens);
-        
-        if (llama_tokenize(vocab, text.c_str(), text.length(), 
-                          tokens.data(), tokens.size(), true, false) < 0) {
-            throw std::runtime_error("Failed to tokenize text");
+        // A context of its own, so embedding leaves the generation KV alone
+        if (!windowEmbedder) {
+            windowEmbedder = std::make_unique<WindowEmbedder>(model, threads, 512, 64, 8, kEmbeddingKvBytes);
         }
+        return windowEmbedder->embed(text, pooling);
         
-        // Get embedding dimension
-        int n_embd = llama_model_n_embd(model);
-        std::vector<float> embedding(n_embd, 0.0f);
-        
-        // Create batch
-        llama_batch batch = llama_batch_get_one(tokens.data(), tokens.size());
-        
-        // Decode
-        if (llama_decode(context, batch) != 0) {
-            throw std::runtime_error("Failed to decode tokens for embedding");
+    } catch (const std::exception& e) {
+        LOGE("Embedding generation failed: %s", e.what());
+        throw;
+    }
+}
+
+std::vector<llama_token> ModelManager::tokenize(const std::string& text, bool addSpecial) const {
+    if (!model) {
+        throw std::runtime_error("Model not loaded");
+    }
+    
+    const llama_vocab* vocab = llama_model_get_vocab(model);
+    
+    // A first call with no buffer returns minus the token count
+    const int n_tokens = -llama_tokenize(vocab, text.c_str(), text.length(), NULL, 0, addSpecial, false);
+    std::vector<llama_token> tokens(n_tokens);
+    
+    if (llama_tokenize(vocab, text.c_str(), text.length(),
+                      tokens.data(), tokens.size(), addSpecial, false) < 0) {
+        throw std::runtime_error("Failed to tokenize text");
+    }
+    return tokens;
+}
+
+size_t ModelManager::prefill(const std::vector<llama_token>& tokens,
+                             const std::vector<std::pair<size_t, size_t>>& segments, bool forLogits) {
+    if (!context) {
+        throw std::runtime_error("Model not loaded");
+    }
+    if (tokens.empty()) {
+        return 0;
+    }
+    
+    llama_memory_t memory = llama_get_memory(context);
+    try {
+        // Keep the KV of the shared prefix
+        size_t reused = 0;
+        const size_t limit = std::min(contextTokens.size(), forLogits ? tokens.size() - 1 : tokens.size());
+        while (reused < limit && contextTokens[reused] == tokens[reused]) {
+            reused++;
         }
-        
-        // Extract embedding
-        const float* embeddingData = llama_get_embeddings(context);
-        if (!embeddingData) {
-            throw std::runtime_error("Failed to get embeddings");
+        if (reused == tokens.size()) {
+            return reused;
         }
+        if (!llama_memory_seq_rm(memory, 0, reused, -1)) {
+            llama_memory_clear(memory, true);
+            reused = 0;
+        }
+        contextTokens.resize(reused);
         
-        std::copy(embeddingData, embeddingData + n_embd, embedding.begin());
-        
-        return embedding;
+        // Splice cached segments; one ending the prompt is decoded, as its logits may be needed
+        size_t next = reused;
+        for (const auto& [start, length] : segments) {
+            if (!segmentCache || start < next || length == 0 || start + length >= tokens.size()) {
+                continue;
+            }
+            decodeRange(tokens, next, start);
+            next = start;
+            if (segmentCache->splice(tokens.data() + start, length, static_cast<llama_pos>(start))) {
+                contextTokens.insert(contextTokens.end(), tokens.begin() + start, tokens.begin() + start + length);
+                next = start + length;
+            }
+        }
+        decodeRange(tokens, next, tokens.size());
+        return reused;
         
     } catch (const std::exception& e) {
-        LOGE("Embedding generation failed: %s", e.what());
+        LOGE("Prefill failed: %s", e.what());
+        llama_memory_clear(memory, true);
+        contextTokens.clear();
         throw;
     }
 }
 
+void ModelManager::decodeRange(const std::vector<llama_token>& tokens, size_t from, size_t to) {
+    const size_t batchSize = llama_n_batch(context);
+    for (size_t at = from; at < to; at += batchSize) {
+        const size_t count = std::min(batchSize, to - at);
+        std::vector<llama_token> batchTokens(tokens.begin() + at, tokens.begin() + at + count);
+        if (llama_decode(context, llama_batch_get_one(batchTokens.data(), static_cast<int32_t>(count))) != 0) {
+            throw std::runtime_error("Failed to process prompt");
+        }
+        contextTokens.insert(contextTokens.end(), batchTokens.begin(), batchTokens.end());
+    }
+}
+
+bool ModelManager::enableSegmentCache(const std::string& directory, size_t maxDiskBytes, int computeAfterUses) {
+    if (!context) {
+        throw std::runtime_error("Model not loaded");
+    }
+    
+    try {
+        segmentCache = std::make_unique<KvSegmentCache>(context, directory, maxDiskBytes, computeAfterUses);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("KV segment cache unavailable: %s", e.what());
+        segmentCache.reset();
+        return false;
+    }
+}
+
+KvSegmentCache* ModelManager::getSegmentCache() const {
+    return segmentCache.get();
+}
+
+std::vector<llama_token>& ModelManager::getContextTokens() {
+    return contextTokens;
+}
+
 int ModelManager::determineGPULayers() {
     // TODO: Implement hardware-specific GPU layer determination
     return 0; // CPU-only for now
@@ -3,8 +3,11 @@
 
 #include <string>
 #include <memory>
+#include <utility>
 #include <vector>
 #include "llama.h"
+#include "kv_segment_cache.h"
+#include "window_embedder.h"
 
 /**
  * Manages llama.cpp model lifecycle
@@ -31,11 +34,54 @@ public:
     void unloadModel();
     
     /**
-     * Generate embedding for text
+     * Generate embedding for text of any length, in overlapping windows
+     * pooled into one vector (see WindowEmbedder)
      * @param text Input text
-     * @return Vector of embeddings
+     * @param pooling How window embeddings are combined
+     * @return L2-normalized embedding
      */
-    std::vector<float> generateEmbedding(const std::string& text);
+    std::vector<float> generateEmbedding(const std::string& text, WindowPooling pooling = WindowPooling::Mean);
+    
+    /**
+     * Tokenize text with the model's vocabulary
+     * @param text Input text
+     * @param addSpecial Add BOS and other special tokens, for the start of a prompt
+     * @return Token IDs
+     */
+    std::vector<llama_token> tokenize(const std::string& text, bool addSpecial) const;
+    
+    /**
+     * Bring sequence 0 of the context to hold `tokens`: the prefix it already
+     * holds is kept, segments are spliced from the segment cache when it has
+     * them (see KvSegmentCache), and the rest is decoded
+     * @param tokens Prompt tokens, BOS included
+     * @param segments (start, length) spans of tokens, e.g. retrieved chunks, in prompt order
+     * @param forLogits Decode the last token even if held, for its logits; otherwise a
+     *                  context that holds all of `tokens` and more is left as it is
+     * @return Tokens kept from before the call
+     */
+    size_t prefill(const std::vector<llama_token>& tokens,
+                   const std::vector<std::pair<size_t, size_t>>& segments, bool forLogits);
+    
+    /**
+     * Keep precomputed KV segments for this model in a directory of its own
+     * @param directory Directory for this model's segment files
+     * @param maxDiskBytes Disk budget; least recently used segments are evicted past it
+     * @param computeAfterUses Store a prompt segment the n-th time it is seen; 0 splices precomputed ones only
+     * @return False if the context cannot splice segments
+     */
+    bool enableSegmentCache(const std::string& directory, size_t maxDiskBytes, int computeAfterUses);
+    
+    /**
+     * Get the segment cache, null unless enabled
+     */
+    KvSegmentCache* getSegmentCache() const;
+    
+    /**
+     * Tokens whose KV sequence 0 of the context holds, in position order;
+     * generation reuses their longest common prefix with the next prompt
+     */
+    std::vector<llama_token>& getContextTokens();
     
     /**
      * Get the model handle
@@ -56,6 +102,15 @@ private:
     llama_model* model;
     llama_context* context;
     std::string modelId;
+    int threads;
+    std::unique_ptr<KvSegmentCache> segmentCache;
+    std::unique_ptr<WindowEmbedder> windowEmbedder; // created on first use
+    std::vector<llama_token> contextTokens;
+    
+    /**
+     * Decode tokens[from, to) at the end of sequence 0
+     */
+    void decodeRange(const std::vector<llama_token>& tokens, size_t from, size_t to);
     
     /**
      * Determine optimal GPU layer count
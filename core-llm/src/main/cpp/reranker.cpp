@@ -0,0 +1,208 @@
+#include "reranker.h"
+#include <algorithm>
+#include <stdexcept>
+
+#define LOG_TAG "IrisReranker"
+#if defined(__ANDROID__)
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+// Host builds (benchmarks) log to stderr
+#include <cstdio>
+#define LOGI(...) (std::fprintf(stderr, LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+#define LOGE(...) LOGI(__VA_ARGS__)
+#endif
+
+namespace {
+
+const std::string kQueryField = "{query}";
+const std::string kDocumentField = "{document}";
+
+void replaceAll(std::string& text, const std::string& field, const std::string& value) {
+    for (size_t at = text.find(field); at != std::string::npos; at = text.find(field, at + value.size())) {
+        text.replace(at, field.size(), value);
+    }
+}
+
+// Frees a llama_batch on every exit path
+struct BatchGuard {
+    llama_batch batch;
+    ~BatchGuard() { llama_batch_free(batch); }
+};
+
+} // namespace
+
+Reranker::Reranker(const std::string& path, int threads, int maxPairTokens, int pairsPerBatch)
+    : model(nullptr), context(nullptr), vocab(nullptr),
+      maxPairTokens(maxPairTokens), pairsPerBatch(pairsPerBatch) {
+    if (maxPairTokens < 8 || pairsPerBatch < 1) {
+        throw std::invalid_argument("Reranker needs maxPairTokens >= 8 and pairsPerBatch >= 1");
+    }
+    LOGI("Loading reranker from: %s", path.c_str());
+
+    llama_model_params modelParams = llama_model_default_params();
+    modelParams.n_gpu_layers = 0; // CPU only for now
+
+    model = llama_model_load_from_file(path.c_str(), modelParams);
+    if (!model) {
+        throw std::runtime_error("Failed to load reranker from " + path);
+    }
+
+    // One sequence per pair; encoder-only models need a whole batch in one ubatch
+    llama_context_params contextParams = llama_context_default_params();
+    contextParams.n_ctx = maxPairTokens * pairsPerBatch;
+    contextParams.n_batch = contextParams.n_ctx;
+    contextParams.n_ubatch = contextParams.n_ctx;
+    contextParams.n_seq_max = pairsPerBatch;
+    contextParams.n_threads = (threads <= 0) ? 4 : threads;
+    contextParams.n_threads_batch = contextParams.n_threads;
+    contextParams.embeddings = true;
+    contextParams.pooling_type = LLAMA_POOLING_TYPE_RANK;
+
+    context = llama_init_from_model(model, contextParams);
+    if (!context) {
+        llama_model_free(model);
+        model = nullptr;
+        throw std::runtime_error("Failed to create reranker context");
+    }
+    vocab = llama_model_get_vocab(model);
+
+    // Instruction-tuned rerankers ship a pair template; classic cross-encoders use [BOS] q [EOS][SEP] d [EOS]
+    const char* rerankTemplate = llama_model_chat_template(model, "rerank");
+    if (rerankTemplate) {
+        pairTemplate = rerankTemplate;
+    }
+    LOGI("Reranker loaded: %d tokens x %d pairs per batch%s", maxPairTokens, pairsPerBatch,
+         pairTemplate.empty() ? "" : ", model pair template");
+}
+
+Reranker::~Reranker() {
+    if (context) {
+        llama_free(context);
+    }
+    if (model) {
+        llama_model_free(model);
+    }
+}
+
+std::vector<llama_token> Reranker::tokenize(const std::string& text, bool parseSpecial) const {
+    const int count = -llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, false, parseSpecial);
+    std::vector<llama_token> tokens(std::max(count, 0));
+    if (count > 0 && llama_tokenize(vocab, text.c_str(), text.length(),
+                                    tokens.data(), tokens.size(), false, parseSpecial) < 0) {
+        throw std::runtime_error("Failed to tokenize text");
+    }
+    return tokens;
+}
+
+std::vector<llama_token> Reranker::formatPair(const std::vector<llama_token>& query, const std::string& passage) const {
+    std::vector<llama_token> prefix;
+    std::vector<llama_token> suffix;
+    if (pairTemplate.empty()) {
+        llama_token eos = llama_vocab_eos(vocab);
+        if (eos == LLAMA_TOKEN_NULL) {
+            eos = llama_vocab_sep(vocab);
+        }
+        if (llama_vocab_get_add_bos(vocab)) {
+            prefix.push_back(llama_vocab_bos(vocab));
+        }
+        prefix.insert(prefix.end(), query.begin(), query.end());
+        if (llama_vocab_get_add_eos(vocab)) {
+            prefix.push_back(eos);
+            suffix.push_back(eos);
+        }
+        if (llama_vocab_get_add_sep(vocab)) {
+            prefix.push_back(llama_vocab_sep(vocab));
+        }
+    } else {
+        // Render the template around the passage so the passage alone can be truncated
+        std::string queryText;
+        char piece[256];
+        for (llama_token token : query) {
+            const int length = llama_token_to_piece(vocab, token, piece, sizeof(piece), 0, false);
+            if (length > 0) {
+                queryText.append(piece, length);
+            }
+        }
+        const size_t split = pairTemplate.find(kDocumentField);
+        std::string head = pairTemplate.substr(0, split);
+        std::string tail = split == std::string::npos ? "" : pairTemplate.substr(split + kDocumentField.size());
+        replaceAll(head, kQueryField, queryText);
+        replaceAll(tail, kQueryField, queryText);
+        prefix = tokenize(head, true);
+        suffix = tokenize(tail, true);
+    }
+
+    const int room = maxPairTokens - static_cast<int>(prefix.size() + suffix.size());
+    if (room <= 0) {
+        throw std::runtime_error("Query does not leave room for a passage");
+    }
+    std::vector<llama_token> document = tokenize(passage, false);
+    if (static_cast<int>(document.size()) > room) {
+        document.resize(room);
+    }
+    prefix.insert(prefix.end(), document.begin(), document.end());
+    prefix.insert(prefix.end(), suffix.begin(), suffix.end());
+    return prefix;
+}
+
+std::vector<float> Reranker::score(const std::string& query, const std::vector<std::string>& passages) {
+    std::vector<float> scores(passages.size());
+    if (passages.empty()) {
+        return scores;
+    }
+
+    // Long queries keep their first half of the pair budget
+    std::vector<llama_token> queryTokens = tokenize(query, false);
+    if (static_cast<int>(queryTokens.size()) > maxPairTokens / 2) {
+        queryTokens.resize(maxPairTokens / 2);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    BatchGuard guard{llama_batch_init(maxPairTokens * pairsPerBatch, 0, pairsPerBatch)};
+    llama_batch& batch = guard.batch;
+
+    size_t next = 0;
+    while (next < passages.size()) {
+        const size_t first = next;
+        batch.n_tokens = 0;
+        for (int seq = 0; seq < pairsPerBatch && next < passages.size(); seq++, next++) {
+            const std::vector<llama_token> pair = formatPair(queryTokens, passages[next]);
+            for (size_t pos = 0; pos < pair.size(); pos++) {
+                const int i = batch.n_tokens++;
+                batch.token[i] = pair[pos];
+                batch.pos[i] = static_cast<llama_pos>(pos);
+                batch.n_seq_id[i] = 1;
+                batch.seq_id[i][0] = seq;
+                batch.logits[i] = true; // pooling reads every token's output
+            }
+        }
+
+        llama_memory_t memory = llama_get_memory(context);
+        if (memory) {
+            llama_memory_clear(memory, true);
+        }
+        if (llama_decode(context, batch) != 0) {
+            LOGE("Rerank decode failed for pairs %zu..%zu", first, next - 1);
+            throw std::runtime_error("Failed to decode rerank batch");
+        }
+
+        for (size_t i = first; i < next; i++) {
+            const float* output = llama_get_embeddings_seq(context, static_cast<llama_seq_id>(i - first));
+            if (!output) {
+                throw std::runtime_error("Model produced no rank score; is it a reranker?");
+            }
+            scores[i] = output[0];
+        }
+    }
+    return scores;
+}
+
+int Reranker::pairTokens(const std::string& query, const std::string& passage) const {
+    std::vector<llama_token> queryTokens = tokenize(query, false);
+    if (static_cast<int>(queryTokens.size()) > maxPairTokens / 2) {
+        queryTokens.resize(maxPairTokens / 2);
+    }
+    return static_cast<int>(formatPair(queryTokens, passage).size());
+}
@@ -0,0 +1,57 @@
+#ifndef IRIS_RERANKER_H
+#define IRIS_RERANKER_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "llama.h"
+
+/**
+ * Cross-encoder reranker over a GGUF model with rank pooling
+ * (bge-reranker, jina-reranker, Qwen3-Reranker, ...)
+ *
+ * Each (query, passage) pair is scored by one forward pass over the pair
+ * together; pairs are packed as separate sequences into one batch so a
+ * whole candidate list costs a few decodes rather than one per passage.
+ */
+class Reranker {
+public:
+    /**
+     * Load a reranker model
+     * @param path Path to GGUF file
+     * @param threads Number of threads (<= 0 for a default)
+     * @param maxPairTokens Tokens per (query, passage) pair; longer passages are truncated
+     * @param pairsPerBatch Pairs scored by one decode
+     * @throws std::runtime_error if the model cannot be loaded or has no rank head
+     */
+    Reranker(const std::string& path, int threads, int maxPairTokens = 512, int pairsPerBatch = 8);
+    ~Reranker();
+
+    Reranker(const Reranker&) = delete;
+    Reranker& operator=(const Reranker&) = delete;
+
+    /**
+     * Relevance of each passage to the query, higher is more relevant
+     * @return One score per passage, in input order
+     */
+    std::vector<float> score(const std::string& query, const std::vector<std::string>& passages);
+
+    /**
+     * Tokens the pair (query, passage) is scored over, after truncation
+     */
+    int pairTokens(const std::string& query, const std::string& passage) const;
+
+private:
+    llama_model* model;
+    llama_context* context;
+    const llama_vocab* vocab;
+    std::string pairTemplate;
+    int maxPairTokens;
+    int pairsPerBatch;
+    std::mutex mutex;
+
+    std::vector<llama_token> tokenize(const std::string& text, bool parseSpecial) const;
+    std::vector<llama_token> formatPair(const std::vector<llama_token>& query, const std::string& passage) const;
+};
+
+#endif // IRIS_RERANKER_H
@@ -0,0 +1,278 @@
+#include "window_embedder.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#define LOG_TAG "IrisWindowEmbedder"
+#if defined(__ANDROID__)
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+// Host builds (benchmarks) log to stderr
+#include <cstdio>
+#define LOGI(...) (std::fprintf(stderr, LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+#define LOGE(...) LOGI(__VA_ARGS__)
+#endif
+
+namespace {
+
+// Sharpness of attention pooling over cosine similarities
+constexpr float kAttentionTemperature = 0.1f;
+
+// Shortest window a KV budget may cut windows down to
+constexpr int kMinWindowTokens = 128;
+
+// KV cache bytes per token at the default F16 cache type; 0 if the model does not say
+size_t kvBytesPerToken(const llama_model* model) {
+    const int heads = llama_model_n_head(model);
+    const int kvHeads = llama_model_n_head_kv(model);
+    if (heads <= 0 || kvHeads <= 0) {
+        return 0;
+    }
+    const size_t kvEmbedding = static_cast<size_t>(llama_model_n_embd(model)) / heads * kvHeads;
+    return 2 * sizeof(uint16_t) * kvEmbedding * static_cast<size_t>(llama_model_n_layer(model));
+}
+
+// Frees a llama_batch on every exit path
+struct BatchGuard {
+    llama_batch batch;
+    ~BatchGuard() { llama_batch_free(batch); }
+};
+
+void normalize(std::vector<float>& vector) {
+    double norm = 0.0;
+    for (float v : vector) {
+        norm += static_cast<double>(v) * v;
+    }
+    if (norm > 0.0) {
+        const float scale = static_cast<float>(1.0 / std::sqrt(norm));
+        for (float& v : vector) {
+            v *= scale;
+        }
+    }
+}
+
+} // namespace
+
+WindowEmbedder::WindowEmbedder(llama_model* model, int threads, int windowTokens, int overlapTokens,
+                               int windowsPerBatch, size_t maxKvBytes)
+    : model(model), context(nullptr), vocab(llama_model_get_vocab(model)),
+      windowTokens(windowTokens), overlapTokens(overlapTokens), windowsPerBatch(windowsPerBatch),
+      dimension(llama_model_n_embd(model)) {
+    const int trained = llama_model_n_ctx_train(model);
+    if (trained > 0) {
+        this->windowTokens = std::min(windowTokens, trained);
+    }
+    // Room for BOS, EOS and SEP, and a window must move forward
+    if (windowsPerBatch < 1 || overlapTokens < 0 || overlapTokens >= this->windowTokens - 4) {
+        throw std::invalid_argument("Window embedder needs 0 <= overlap < window - 4 and windowsPerBatch >= 1");
+    }
+    // Fewer windows per batch to fit a KV budget, then shorter ones, down to kMinWindowTokens
+    const size_t perToken = kvBytesPerToken(model);
+    if (maxKvBytes > 0 && perToken > 0) {
+        const size_t fit = maxKvBytes / perToken;
+        if (fit < static_cast<size_t>(this->windowTokens)) {
+            const int shortened = std::max(static_cast<int>(fit), std::min(kMinWindowTokens, this->windowTokens));
+            this->overlapTokens = std::min(overlapTokens * shortened / this->windowTokens, shortened - 5);
+            this->windowTokens = shortened;
+        }
+        this->windowsPerBatch = static_cast<int>(
+            std::clamp<size_t>(fit / this->windowTokens, 1, static_cast<size_t>(windowsPerBatch)));
+    }
+
+    // One sequence per window; encoder-only models need a whole batch in one ubatch
+    llama_context_params contextParams = llama_context_default_params();
+    contextParams.n_ctx = this->windowTokens * this->windowsPerBatch;
+    contextParams.n_batch = contextParams.n_ctx;
+    contextParams.n_ubatch = contextParams.n_ctx;
+    contextParams.n_seq_max = this->windowsPerBatch;
+    contextParams.n_threads = (threads <= 0) ? 4 : threads;
+    contextParams.n_threads_batch = contextParams.n_threads;
+    contextParams.embeddings = true;
+
+    context = llama_init_from_model(model, contextParams);
+    if (!context) {
+        throw std::runtime_error("Failed to create embedding context");
+    }
+    LOGI("Window embedder: %d-token windows, %d overlap, %d per batch", this->windowTokens, this->overlapTokens,
+         this->windowsPerBatch);
+}
+
+WindowEmbedder::~WindowEmbedder() {
+    if (context) {
+        llama_free(context);
+    }
+}
+
+std::vector<float> WindowEmbedder::embed(const std::string& text, WindowPooling pooling) {
+    const std::vector<std::vector<llama_token>> windows = cut(tokenize(text));
+
+    std::vector<std::vector<float>> vectors(windows.size());
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t first = 0; first < windows.size(); first += windowsPerBatch) {
+            embedBatch(windows, first, std::min<size_t>(windowsPerBatch, windows.size() - first), vectors);
+        }
+    }
+    for (std::vector<float>& vector : vectors) {
+        normalize(vector);
+    }
+    if (vectors.size() == 1) {
+        return vectors[0];
+    }
+
+    std::vector<float> weights(vectors.size());
+    for (size_t w = 0; w < windows.size(); w++) {
+        weights[w] = static_cast<float>(windows[w].size());
+    }
+    std::vector<float> result(dimension, 0.0f);
+    auto weightedSum = [&]() {
+        std::fill(result.begin(), result.end(), 0.0f);
+        for (size_t w = 0; w < vectors.size(); w++) {
+            for (int i = 0; i < dimension; i++) {
+                result[i] += weights[w] * vectors[w][i];
+            }
+        }
+    };
+
+    switch (pooling) {
+    case WindowPooling::Mean:
+        weightedSum();
+        break;
+    case WindowPooling::Max:
+        result = vectors[0];
+        for (size_t w = 1; w < vectors.size(); w++) {
+            for (int i = 0; i < dimension; i++) {
+                result[i] = std::max(result[i], vectors[w][i]);
+            }
+        }
+        break;
+    case WindowPooling::Attention: {
+        // The length-weighted mean is the query; each window's cosine to it is its score
+        weightedSum();
+        normalize(result);
+        std::vector<float> scores(vectors.size());
+        for (size_t w = 0; w < vectors.size(); w++) {
+            float dot = 0.0f;
+            for (int i = 0; i < dimension; i++) {
+                dot += vectors[w][i] * result[i];
+            }
+            scores[w] = dot / kAttentionTemperature;
+        }
+        const float top = *std::max_element(scores.begin(), scores.end());
+        float total = 0.0f;
+        for (size_t w = 0; w < vectors.size(); w++) {
+            weights[w] = std::exp(scores[w] - top);
+            total += weights[w];
+        }
+        for (float& weight : weights) {
+            weight /= total;
+        }
+        weightedSum();
+        break;
+    }
+    default:
+        throw std::invalid_argument("Unknown window pooling");
+    }
+    normalize(result);
+    return result;
+}
+
+size_t WindowEmbedder::windowCount(const std::string& text) const {
+    return cut(tokenize(text)).size();
+}
+
+std::vector<llama_token> WindowEmbedder::tokenize(const std::string& text) const {
+    const int count = -llama_tokenize(vocab, text.c_str(), text.length(), nullptr, 0, false, false);
+    std::vector<llama_token> tokens(std::max(count, 0));
+    if (count > 0 && llama_tokenize(vocab, text.c_str(), text.length(), tokens.data(), tokens.size(),
+                                    false, false) < 0) {
+        throw std::runtime_error("Failed to tokenize text");
+    }
+    return tokens;
+}
+
+std::vector<std::vector<llama_token>> WindowEmbedder::cut(const std::vector<llama_token>& tokens) const {
+    // The specials a whole-text tokenization would add, around every window
+    std::vector<llama_token> prefix;
+    std::vector<llama_token> suffix;
+    if (llama_vocab_get_add_bos(vocab)) {
+        prefix.push_back(llama_vocab_bos(vocab));
+    }
+    if (llama_vocab_get_add_eos(vocab)) {
+        suffix.push_back(llama_vocab_eos(vocab));
+    }
+    if (llama_vocab_get_add_sep(vocab)) {
+        suffix.push_back(llama_vocab_sep(vocab));
+    }
+
+    const size_t content = windowTokens - prefix.size() - suffix.size();
+    const size_t stride = content - overlapTokens;
+    std::vector<std::vector<llama_token>> windows;
+    for (size_t start = 0;; start += stride) {
+        const size_t end = std::min(start + content, tokens.size());
+        std::vector<llama_token> window = prefix;
+        window.insert(window.end(), tokens.begin() + start, tokens.begin() + end);
+        window.insert(window.end(), suffix.begin(), suffix.end());
+        windows.push_back(std::move(window));
+        if (end == tokens.size()) {
+            break;
+        }
+    }
+    return windows;
+}
+
+void WindowEmbedder::embedBatch(const std::vector<std::vector<llama_token>>& windows, size_t first, size_t count,
+                                std::vector<std::vector<float>>& out) {
+    BatchGuard guard{llama_batch_init(windowTokens * windowsPerBatch, 0, 1)};
+    llama_batch& batch = guard.batch;
+    batch.n_tokens = 0;
+    std::vector<int> starts(count + 1);
+    for (size_t seq = 0; seq < count; seq++) {
+        const std::vector<llama_token>& window = windows[first + seq];
+        starts[seq] = batch.n_tokens;
+        for (size_t pos = 0; pos < window.size(); pos++) {
+            const int i = batch.n_tokens++;
+            batch.token[i] = window[pos];
+            batch.pos[i] = static_cast<llama_pos>(pos);
+            batch.n_seq_id[i] = 1;
+            batch.seq_id[i][0] = static_cast<llama_seq_id>(seq);
+            batch.logits[i] = true; // pooling reads every token's output
+        }
+    }
+    starts[count] = batch.n_tokens;
+
+    llama_memory_t memory = llama_get_memory(context);
+    if (memory) {
+        llama_memory_clear(memory, true);
+    }
+    if (llama_decode(context, batch) != 0) {
+        LOGE("Embedding decode failed for windows %zu..%zu", first, first + count - 1);
+        throw std::runtime_error("Failed to decode embedding batch");
+    }
+
+    const bool pooled = llama_pooling_type(context) != LLAMA_POOLING_TYPE_NONE;
+    for (size_t seq = 0; seq < count; seq++) {
+        std::vector<float>& vector = out[first + seq];
+        if (pooled) {
+            const float* output = llama_get_embeddings_seq(context, static_cast<llama_seq_id>(seq));
+            if (!output) {
+                throw std::runtime_error("Model produced no pooled embedding");
+            }
+            vector.assign(output, output + dimension);
+            continue;
+        }
+        // Models without a pooling head: mean of the window's token embeddings
+        vector.assign(dimension, 0.0f);
+        for (int i = starts[seq]; i < starts[seq + 1]; i++) {
+            const float* output = llama_get_embeddings_ith(context, i);
+            if (!output) {
+                throw std::runtime_error("Model produced no token embeddings");
+            }
+            for (int d = 0; d < dimension; d++) {
+                vector[d] += output[d];
+            }
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef IRIS_WINDOW_EMBEDDER_H
+#define IRIS_WINDOW_EMBEDDER_H
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include "llama.h"
+
+/**
+ * How window embeddings are combined into one vector for the whole text
+ */
+enum class WindowPooling {
+    Mean = 0,     // average, weighted by window length so a short last window counts less
+    Max = 1,      // elementwise maximum
+    Attention = 2 // softmax over each window's similarity to the mean, so off-topic windows count less
+};
+
+/**
+ * Embeds text of any length with a model's pooled (or mean token) embeddings.
+ *
+ * The text is tokenized once and cut into windows of `windowTokens`, each
+ * overlapping the previous one by `overlapTokens` so no sentence is only seen
+ * cut in half. Windows are decoded as separate sequences of one batch, up to
+ * `windowsPerBatch` at a time, each with the model's own BOS/EOS. The window
+ * vectors are L2-normalized, combined by a WindowPooling and normalized again.
+ * Text that fits one window gets that window's embedding, as a plain embedding
+ * call would.
+ *
+ * Owns a context of its own on a model it does not own, sized to hold one
+ * batch. With a KV budget, fewer windows go into a batch, and if a single
+ * window does not fit, windows and their overlap shrink, to no fewer than 128
+ * tokens. Safe to call from several threads; calls are
+ * serialized.
+ */
+class WindowEmbedder {
+public:
+    /**
+     * @param model Model to embed with; must outlive the embedder
+     * @param threads Number of threads (<= 0 for a default)
+     * @param windowTokens Tokens per window, specials included; capped at the model's training context
+     * @param overlapTokens Tokens a window shares with the previous one
+     * @param maxKvBytes Bound on the context's F16 KV cache, estimated from the model's shape; 0 for none
+     * @throws std::runtime_error if the context cannot be created
+     */
+    WindowEmbedder(llama_model* model, int threads, int windowTokens = 512, int overlapTokens = 64,
+                   int windowsPerBatch = 8, size_t maxKvBytes = 0);
+    ~WindowEmbedder();
+
+    WindowEmbedder(const WindowEmbedder&) = delete;
+    WindowEmbedder& operator=(const WindowEmbedder&) = delete;
+
+    /**
+     * One L2-normalized vector for the whole text
+     */
+    std::vector<float> embed(const std::string& text, WindowPooling pooling);
+
+    /**
+     * Number of windows `text` is cut into
+     */
+    size_t windowCount(const std::string& text) const;
+
+private:
+    llama_model* model;
+    llama_context* context;
+    const llama_vocab* vocab;
+    int windowTokens;
+    int overlapTokens;
+    int windowsPerBatch;
+    int dimension;
+    std::mutex mutex;
+
+    std::vector<llama_token> tokenize(const std::string& text) const;
+    std::vector<std::vector<llama_token>> cut(const std::vector<llama_token>& tokens) const;
+    void embedBatch(const std::vector<std::vector<llama_token>>& windows, size_t first, size_t count,
+                    std::vector<std::vector<float>>& out);
+};
+
+#endif // IRIS_WINDOW_EMBEDDER_H
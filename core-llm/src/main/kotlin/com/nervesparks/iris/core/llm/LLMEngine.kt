@@ -24,6 +24,58 @@ interface LLMEngine {
      */
     suspend fun generateText(prompt: String, params: GenerationParams): Flow<String>
     
+    /**
+     * Generate text from a prompt already tokenized with [tokenize]
+     * @param promptTokens Input prompt tokens, starting with the BOS token
+     * @param params Generation parameters
+     * @param segments (start, length) pairs of spans of [promptTokens], e.g. retrieved chunks,
+     * whose KV state may be spliced from the segment cache instead of decoded
+     * @return Flow of generated tokens
+     */
+    suspend fun generateFromTokens(
+        promptTokens: IntArray,
+        params: GenerationParams,
+        segments: IntArray = IntArray(0)
+    ): Flow<String>
+    
+    /**
+     * Decode the start of an upcoming prompt ahead of [generateFromTokens], e.g. the system
+     * prompt and history while retrieval runs; generation keeps what its prompt shares with it
+     * @param promptTokens Leading prompt tokens, starting with the BOS token
+     */
+    suspend fun prefill(promptTokens: IntArray)
+    
+    /**
+     * Let [generateFromTokens] splice prompt segments from a KV cache on disk instead of
+     * decoding them. Off until called: a spliced segment does not attend to the prompt before
+     * it, so output can differ from that of the fully decoded prompt.
+     * @param pinnedOnly Splice only segments stored by [precomputeSegment], e.g. chunks of pinned
+     * documents; otherwise any segment is stored the second time a prompt holds it
+     * @return False if the loaded model's context cannot splice segments
+     */
+    suspend fun enableSegmentCache(pinnedOnly: Boolean = true): Boolean
+    
+    /**
+     * Store the KV state of a prompt segment that will recur, e.g. a chunk of a pinned
+     * document, so [generateFromTokens] splices it from its first use
+     * @param tokens The segment's tokens, as they appear in prompts
+     * @return True if the segment is stored; false while the segment cache is not enabled
+     */
+    suspend fun precomputeSegment(tokens: IntArray): Boolean
+    
+    /**
+     * Tokenize text with the loaded model's vocabulary
+     * @param text Input text
+     * @param addSpecial Add BOS and other special tokens, for the start of a prompt
+     * @return Token IDs
+     */
+    suspend fun tokenize(text: String, addSpecial: Boolean = false): IntArray
+    
+    /**
+     * Context window of the loaded model in tokens, or null when none is loaded
+     */
+    fun contextSize(): Int?
+    
     /**
      * Generate embeddings for text
      * @param text Input text
@@ -31,6 +83,15 @@ interface LLMEngine {
      */
     suspend fun embed(text: String): FloatArray
     
+    /**
+     * One embedding for text of any length, for coarse retrieval over long sections.
+     * The text is embedded in overlapping windows whose vectors are pooled.
+     * @param text Input text
+     * @param pooling How window embeddings are combined
+     * @return L2-normalized embedding
+     */
+    suspend fun embedDocument(text: String, pooling: WindowPooling = WindowPooling.MEAN): FloatArray
+    
     /**
      * Unload a model from memory
      * @param handle Model handle to unload
@@ -31,6 +31,12 @@ class LLMEngineImpl @Inject constructor(
     companion object {
         private const val TAG = "LLMEngineImpl"
         
+        // Disk budget for precomputed KV segments, per model
+        private const val SEGMENT_CACHE_BYTES = 512L * 1024 * 1024
+        
+        // Prompts that must hold a segment before it is stored, when not only pinned ones are
+        private const val SEGMENT_STORE_AFTER_USES = 2
+        
         init {
             try {
                 System.loadLibrary("iris_llm")
@@ -100,14 +106,70 @@ class LLMEngineImpl @Inject constructor(
         }
     }
     
-    override suspend fun generateText(prompt: String, params: GenerationParams): Flow<String> = callbackFlow {
+    override suspend fun generateText(prompt: String, params: GenerationParams): Flow<String> =
+        stream { modelId -> nativeStartGeneration(modelId, prompt, params) }
+    
+    override suspend fun generateFromTokens(
+        promptTokens: IntArray,
+        params: GenerationParams,
+        segments: IntArray
+    ): Flow<String> =
+        stream { modelId -> nativeStartGenerationFromTokens(modelId, promptTokens, segments, params) }
+    
+    override suspend fun prefill(promptTokens: IntArray): Unit = withContext(Dispatchers.IO) {
+        val modelHandle = loadedModels.values.firstOrNull()
+            ?: throw LLMException("No model loaded")
+        
+        val reused = nativePrefill(modelHandle.id, promptTokens)
+        Log.d(TAG, "Prefilled ${promptTokens.size - reused} of ${promptTokens.size} prompt tokens")
+    }
+    
+    override suspend fun enableSegmentCache(pinnedOnly: Boolean): Boolean = withContext(Dispatchers.IO) {
+        val modelHandle = loadedModels.values.firstOrNull()
+            ?: throw LLMException("No model loaded")
+        
+        // KV segments are only valid for this model file, so they live beside it
+        val modelFile = File(modelHandle.modelPath)
+        val segmentDir = File(
+            modelFile.parentFile,
+            "kv-segments/${modelFile.nameWithoutExtension}-${modelFile.length()}"
+        )
+        val storeAfterUses = if (pinnedOnly) 0 else SEGMENT_STORE_AFTER_USES
+        val enabled = nativeEnableSegmentCache(modelHandle.id, segmentDir.path, SEGMENT_CACHE_BYTES, storeAfterUses)
+        if (!enabled) {
+            Log.w(TAG, "KV segment cache unavailable; prompts are decoded in full")
+        }
+        enabled
+    }
+    
+    override suspend fun precomputeSegment(tokens: IntArray): Boolean = withContext(Dispatchers.IO) {
+        val modelHandle = loadedModels.values.firstOrNull()
+            ?: throw LLMException("No model loaded")
+        
+        nativePrecomputeSegment(modelHandle.id, tokens) > 0
+    }
+    
+    override suspend fun tokenize(text: String, addSpecial: Boolean): IntArray = withContext(Dispatchers.IO) {
+        val modelHandle = loadedModels.values.firstOrNull()
+            ?: throw LLMException("No model loaded")
+        
+        nativeTokenize(modelHandle.id, text, addSpecial)
+            ?: throw LLMException("Tokenization failed")
+    }
+    
+    override fun contextSize(): Int? = loadedModels.values.firstOrNull()?.contextSize
+    
+    /**
+     * Tokens of the session `start` opens on the loaded model, until it completes or the flow is cancelled
+     */
+    private fun stream(start: (modelId: String) -> Long): Flow<String> = callbackFlow {
         try {
             // Find appropriate model
             val modelHandle = loadedModels.values.firstOrNull()
                 ?: throw LLMException("No model loaded")
             
             // Start native generation
-            val sessionId = nativeStartGeneration(modelHandle.id, prompt, params)
+            val sessionId = start(modelHandle.id)
             if (sessionId < 0) {
                 throw GenerationException("Failed to start generation")
             }
@@ -165,6 +227,20 @@ class LLMEngineImpl @Inject constructor(
         }
     }
     
+    override suspend fun embedDocument(text: String, pooling: WindowPooling): FloatArray =
+        withContext(Dispatchers.IO) {
+            val modelHandle = loadedModels.values.firstOrNull()
+                ?: throw LLMException("No model loaded")
+            
+            try {
+                nativeEmbedDocument(modelHandle.id, text, pooling.ordinal)
+                    ?: throw EmbeddingException("Document embedding failed")
+            } catch (e: Exception) {
+                Log.e(TAG, "Document embedding failed", e)
+                throw EmbeddingException("Document embedding failed", e)
+            }
+        }
+    
     override fun unloadModel(handle: ModelHandle) {
         try {
             // Cancel any active generations for this model
@@ -203,8 +279,24 @@ class LLMEngineImpl @Inject constructor(
     private external fun nativeInitializeBackend(backendType: Int): Int
     private external fun nativeLoadModel(modelPath: String, params: ModelLoadParams): String?
     private external fun nativeStartGeneration(modelId: String, prompt: String, params: GenerationParams): Long
+    private external fun nativeStartGenerationFromTokens(
+        modelId: String,
+        promptTokens: IntArray,
+        segments: IntArray,
+        params: GenerationParams
+    ): Long
+    private external fun nativePrefill(modelId: String, promptTokens: IntArray): Int
+    private external fun nativeEnableSegmentCache(
+        modelId: String,
+        directory: String,
+        maxDiskBytes: Long,
+        computeAfterUses: Int
+    ): Boolean
+    private external fun nativePrecomputeSegment(modelId: String, tokens: IntArray): Long
+    private external fun nativeTokenize(modelId: String, text: String, addSpecial: Boolean): IntArray?
     private external fun nativeGenerateNextToken(sessionId: Long): String?
     private external fun nativeGenerateEmbedding(modelId: String, text: String): FloatArray?
+    private external fun nativeEmbedDocument(modelId: String, text: String, pooling: Int): FloatArray?
     private external fun nativeUnloadModel(modelId: String): Boolean
     private external fun nativeShutdown()
 }
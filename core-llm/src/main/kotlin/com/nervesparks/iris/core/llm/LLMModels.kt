@@ -12,6 +12,21 @@ data class ModelLoadParams(
     val seed: Long
 )
 
+/**
+ * How [LLMEngine.embedDocument] combines the embeddings of a long text's windows.
+ * Ordinals match the native `WindowPooling`.
+ */
+enum class WindowPooling {
+    /** Average, weighted by window length */
+    MEAN,
+
+    /** Elementwise maximum */
+    MAX,
+
+    /** Weighted by each window's similarity to the mean, so off-topic windows count less */
+    ATTENTION
+}
+
 /**
  * Exception thrown when LLM operations fail
  */
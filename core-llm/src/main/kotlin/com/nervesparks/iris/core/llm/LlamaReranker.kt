@@ -0,0 +1,64 @@
+package com.nervesparks.iris.core.llm
+
+import java.io.Closeable
+import java.io.File
+
+/**
+ * Handle to a native cross-encoder reranker (libiris_llm)
+ *
+ * Loads a reranker GGUF (bge-reranker, jina-reranker, Qwen3-Reranker, ...)
+ * with rank pooling and scores (query, passage) pairs, several pairs per
+ * decode. Calls are serialized natively, so one instance can be shared.
+ */
+class LlamaReranker private constructor(private var handle: Long) : Closeable {
+
+    companion object {
+        init {
+            System.loadLibrary("iris_llm")
+        }
+
+        /**
+         * @param maxPairTokens Tokens per (query, passage) pair; longer passages are truncated
+         * @param pairsPerBatch Pairs scored by one decode
+         * @throws RuntimeException if the model cannot be loaded
+         */
+        fun load(
+            model: File,
+            threads: Int = 4,
+            maxPairTokens: Int = 512,
+            pairsPerBatch: Int = 8
+        ): LlamaReranker {
+            require(maxPairTokens >= 8 && pairsPerBatch >= 1) {
+                "Expected maxPairTokens >= 8 and pairsPerBatch >= 1"
+            }
+            return LlamaReranker(nativeLoad(model.absolutePath, threads, maxPairTokens, pairsPerBatch))
+        }
+
+        @JvmStatic
+        private external fun nativeLoad(modelPath: String, threads: Int, maxPairTokens: Int, pairsPerBatch: Int): Long
+    }
+
+    /**
+     * Relevance of each passage to `query`, higher is more relevant
+     * @return One score per passage, in input order
+     */
+    fun score(query: String, passages: List<String>): FloatArray {
+        check(handle != 0L) { "Reranker is closed" }
+        if (passages.isEmpty()) {
+            return FloatArray(0)
+        }
+        return nativeScore(handle, query, passages.toTypedArray())
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeScore(handle: Long, query: String, passages: Array<String>): FloatArray
+    private external fun nativeFree(handle: Long)
+}
@@ -0,0 +1,179 @@
+#include "audio_dsp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+namespace iris {
+namespace multimodal {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kMaxPhases = 1024;
+// Taps per phase when interpolating; about 1.6 kHz of transition band at 16 kHz out
+constexpr size_t kBaseTaps = 48;
+// Pass band edge as a fraction of the lower Nyquist frequency, at the -6 dB point
+constexpr double kRolloff = 0.9;
+// Kaiser window shape; about 80 dB of stop band
+constexpr double kKaiserBeta = 8.0;
+
+// Zeroth-order modified Bessel function of the first kind
+double besselI0(double x) {
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 50; k++) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// AudioProcessorImpl's constants
+constexpr size_t kGainWindow = 4096;
+constexpr float kTargetRms = 0.1f;
+constexpr size_t kGainFade = 100;
+constexpr size_t kEchoDelay = 80;
+constexpr float kEchoAttenuation = 0.3f;
+
+} // namespace
+
+// ============================================================================
+// PolyphaseResampler
+// ============================================================================
+
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate)
+    : inputRate_(inputRate), outputRate_(outputRate) {
+    if (inputRate <= 0 || outputRate <= 0) {
+        throw std::invalid_argument("Sample rates must be positive");
+    }
+    const int divisor = std::gcd(inputRate, outputRate);
+    up_ = static_cast<size_t>(outputRate / divisor);
+    down_ = static_cast<size_t>(inputRate / divisor);
+    if (up_ > kMaxPhases) {
+        throw std::invalid_argument("Resampling ratio needs too many filter phases");
+    }
+    // Decimation narrows the pass band in input samples; lengthen the filter to match
+    const double decimation = std::max(1.0, static_cast<double>(down_) / up_);
+    taps_ = static_cast<size_t>(std::ceil(kBaseTaps * decimation / 8.0)) * 8;
+
+    // Prototype low-pass at L times the input rate, cutoff in cycles per prototype sample
+    const size_t length = up_ * taps_;
+    const double cutoff = kRolloff * 0.5 / static_cast<double>(std::max(up_, down_));
+    const double centre = (length - 1) / 2.0;
+    const double windowNorm = besselI0(kKaiserBeta);
+    phases_.assign(length, 0.0f);
+    for (size_t j = 0; j < length; j++) {
+        const double t = static_cast<double>(j) - centre;
+        const double sinc = t == 0.0 ? 1.0 : std::sin(2.0 * kPi * cutoff * t) / (2.0 * kPi * cutoff * t);
+        const double r = t / (centre + 0.5);
+        const double window = besselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - r * r))) / windowNorm;
+        const double h = static_cast<double>(up_) * 2.0 * cutoff * sinc * window;
+        // Tap k of phase p is prototype sample p + k * L; store it at taps - 1 - k
+        const size_t phase = j % up_;
+        const size_t tap = j / up_;
+        phases_[phase * taps_ + (taps_ - 1 - tap)] = static_cast<float>(h);
+    }
+    reset();
+}
+
+size_t PolyphaseResampler::maxOutput(size_t count) const {
+    return count * up_ / down_ + 2;
+}
+
+size_t PolyphaseResampler::process(const float* in, size_t count, float* out) {
+    history_.insert(history_.end(), in, in + count);
+    size_t written = 0;
+    for (size_t newest = position_ / up_; newest < history_.size(); newest = position_ / up_) {
+        const size_t phase = position_ % up_;
+        out[written++] = kernels::dot(history_.data() + newest + 1 - taps_, phases_.data() + phase * taps_, taps_);
+        position_ += down_;
+    }
+    // Keep the inputs the next outputs still reach back to
+    const size_t drop = history_.size() - (taps_ - 1);
+    history_.erase(history_.begin(), history_.begin() + drop);
+    position_ -= drop * up_;
+    return written;
+}
+
+void PolyphaseResampler::reset() {
+    history_.assign(taps_ - 1, 0.0f);
+    position_ = (taps_ - 1) * up_;
+}
+
+// ============================================================================
+// CaptureProcessor
+// ============================================================================
+
+void CaptureProcessor::process(float* x, size_t count, Steps steps) {
+    if (steps.noiseGate) {
+        gate(x, count);
+    }
+    if (steps.gainControl) {
+        gain(x, count);
+    }
+    if (steps.echoSuppression) {
+        suppressEcho(x, count);
+    }
+}
+
+void CaptureProcessor::gate(float* x, size_t count) {
+    // The threshold follows the chunk's first 100 ms (or tenth, if shorter)
+    const size_t estimate = std::min<size_t>(1600, count / 10);
+    const float floor = estimate > 0 ? std::sqrt(kernels::dot(x, x, estimate) / estimate) : 0.01f;
+    kernels::noiseGate(x, count, 2.5f * floor);
+}
+
+void CaptureProcessor::gain(float* x, size_t count) {
+    // Windows of 4096 every 2048 samples; each one's level is measured before any gain,
+    // and overlapping gains multiply as in the Kotlin loop
+    const size_t hop = kGainWindow / 2;
+    windowRms_.clear();
+    for (size_t start = 0; start < count; start += hop) {
+        const size_t length = std::min(kGainWindow, count - start);
+        windowRms_.push_back(std::sqrt(kernels::dot(x + start, x + start, length) / length));
+    }
+    for (size_t w = 0; w < windowRms_.size(); w++) {
+        if (windowRms_[w] <= 0.001f) {
+            continue;
+        }
+        const float gain = std::min(std::max(kTargetRms / windowRms_[w], 0.3f), 3.0f);
+        const size_t start = w * hop;
+        const size_t end = std::min(start + kGainWindow, count);
+        const size_t length = end - start;
+        if (length >= 2 * kGainFade) {
+            // Fade in over 100 samples, hold, fade out over 100 samples
+            const float step = gain / kGainFade;
+            kernels::scaleClamp(x + start, kGainFade, 0.0f, step);
+            kernels::scaleClamp(x + start + kGainFade, length - 2 * kGainFade, gain, 0.0f);
+            kernels::scaleClamp(x + end - kGainFade, kGainFade, gain, -step);
+        } else {
+            for (size_t j = start; j < end; j++) {
+                const float fadeIn = j - start < kGainFade ? static_cast<float>(j - start) / kGainFade : 1.0f;
+                const float fadeOut = end - j < kGainFade ? static_cast<float>(end - j) / kGainFade : 1.0f;
+                x[j] = std::min(std::max(x[j] * gain * std::min(fadeIn, fadeOut), -1.0f), 1.0f);
+            }
+        }
+    }
+}
+
+void CaptureProcessor::suppressEcho(float* x, size_t count) {
+    if (count < 100) {
+        return;
+    }
+    // Subtract the signal 80 samples earlier, working backwards one delay at a
+    // time so the samples subtracted have not been changed yet
+    size_t end = count;
+    while (end > kEchoDelay) {
+        const size_t start = std::max(kEchoDelay, end - kEchoDelay);
+        kernels::subtractScaledClamp(x + start, x + start - kEchoDelay, end - start, kEchoAttenuation);
+        end = start;
+    }
+}
+
+} // namespace multimodal
+} // namespace iris
@@ -0,0 +1,100 @@
+#ifndef IRIS_MULTIMODAL_AUDIO_DSP_H
+#define IRIS_MULTIMODAL_AUDIO_DSP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "audio_kernels.h"
+
+namespace iris {
+namespace multimodal {
+
+/**
+ * Streaming rational resampler (mono float).
+ *
+ * The rate ratio is reduced to L/M (48000 -> 16000 is 1/3, 44100 -> 16000 is
+ * 160/441, 22050 -> 48000 is 320/147). A Kaiser-windowed sinc low-pass at
+ * 90% of the lower Nyquist frequency is designed once and split into L
+ * phases; each output sample is one dot product of a phase with the latest
+ * input. Decimating ratios get proportionally longer phases so the
+ * transition band stays the same width at the output rate.
+ *
+ * The last input samples are kept between calls, so a stream can be fed in
+ * chunks of any size with the same result as one call. The output is delayed
+ * by half the filter length (about 0.75 ms at 16 kHz).
+ *
+ * Not thread-safe.
+ */
+class PolyphaseResampler {
+public:
+    /**
+     * @throws std::invalid_argument if a rate is not positive or the reduced
+     *         ratio needs more than 1024 phases
+     */
+    PolyphaseResampler(int inputRate, int outputRate);
+
+    int inputRate() const { return inputRate_; }
+    int outputRate() const { return outputRate_; }
+
+    /**
+     * Filter taps per output sample
+     */
+    size_t taps() const { return taps_; }
+
+    /**
+     * Most samples process() can write for `count` input samples
+     */
+    size_t maxOutput(size_t count) const;
+
+    /**
+     * Resample the next chunk of the stream
+     * @param out Room for maxOutput(count) samples
+     * @return Samples written
+     */
+    size_t process(const float* in, size_t count, float* out);
+
+    /**
+     * Forget the stream
+     */
+    void reset();
+
+private:
+    const int inputRate_;
+    const int outputRate_;
+    size_t up_;   // L
+    size_t down_; // M
+    size_t taps_; // per phase
+    std::vector<float> phases_; // [phase][tap], taps reversed to match the input order
+    std::vector<float> history_; // last taps_ - 1 inputs, then the current chunk
+    size_t position_ = 0; // next output, in 1/L input samples from history_[0]
+};
+
+/**
+ * The capture clean-up chain of AudioProcessorImpl in place on one chunk:
+ * noise gate, automatic gain control, echo suppression. Each step computes
+ * the same thing as the Kotlin version it replaces, on SIMD kernels and
+ * without allocating per chunk.
+ */
+class CaptureProcessor {
+public:
+    struct Steps {
+        bool noiseGate = true;
+        bool gainControl = true;
+        bool echoSuppression = true;
+    };
+
+    void process(float* x, size_t count, Steps steps);
+
+private:
+    std::vector<float> windowRms_;
+
+    static void gate(float* x, size_t count);
+    void gain(float* x, size_t count);
+    static void suppressEcho(float* x, size_t count);
+};
+
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_AUDIO_DSP_H
@@ -0,0 +1,226 @@
+#include <jni.h>
+#include <algorithm>
+#include <exception>
+#include <memory>
+#include <vector>
+
+#include "audio_dsp.h"
+#include "audio_kernels.h"
+#include "audio_ring.h"
+#include "jni_utils.h"
+
+using iris::multimodal::AudioRing;
+using iris::multimodal::CaptureProcessor;
+using iris::multimodal::PolyphaseResampler;
+namespace kernels = iris::multimodal::kernels;
+
+namespace {
+
+// Microphone PCM at the device rate in, processed float at the requested rate out
+struct CaptureHandle {
+    std::unique_ptr<PolyphaseResampler> resampler; // null when the rates match
+    CaptureProcessor processor;
+    std::vector<float> converted;
+
+    size_t maxOutput(size_t count) const { return resampler ? resampler->maxOutput(count) : count; }
+
+    // Where PCM converted to float goes: straight to the output unless it is resampled first
+    float* convertInto(float* out, size_t count) {
+        if (!resampler) {
+            return out;
+        }
+        converted.resize(count);
+        return converted.data();
+    }
+
+    size_t finish(size_t count, float* out, CaptureProcessor::Steps steps) {
+        const size_t written = resampler ? resampler->process(converted.data(), count, out) : count;
+        processor.process(out, written, steps);
+        return written;
+    }
+};
+
+// Synthesised float at the voice's rate in, dithered PCM at the device rate out
+struct PlaybackHandle {
+    std::unique_ptr<PolyphaseResampler> resampler; // null when the rates match
+    kernels::DitherState dither;
+    std::vector<float> resampled;
+    std::vector<float> zeros;
+
+    // Room for `count` samples plus the filter tail flushed at the end
+    size_t maxOutput(size_t count) const {
+        return resampler ? resampler->maxOutput(count + resampler->taps()) + resampler->maxOutput(0) : count;
+    }
+
+    // Audio at the device rate; `source` itself when the rates match
+    const float* resample(const float* source, size_t count, bool end, size_t& rendered) {
+        rendered = count;
+        if (!resampler) {
+            return source;
+        }
+        resampled.resize(maxOutput(count));
+        rendered = resampler->process(source, count, resampled.data());
+        if (end) {
+            rendered += resampler->process(zeros.data(), zeros.size(), resampled.data() + rendered);
+        }
+        return resampled.data();
+    }
+};
+
+std::unique_ptr<PolyphaseResampler> makeResampler(int inputRate, int outputRate) {
+    if (inputRate == outputRate) {
+        return nullptr;
+    }
+    return std::make_unique<PolyphaseResampler>(inputRate, outputRate);
+}
+
+} // namespace
+
+extern "C" {
+
+// ============================================================================
+// NativeCaptureChain
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeCaptureChain_nativeCreate(
+    JNIEnv* env, jobject thiz, jint device_rate, jint output_rate) {
+
+    try {
+        auto handle = std::make_unique<CaptureHandle>();
+        handle->resampler = makeResampler(device_rate, output_rate);
+        return reinterpret_cast<jlong>(handle.release());
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in capture nativeCreate: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeCaptureChain_nativeMaxOutput(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jint count) {
+
+    return static_cast<jint>(reinterpret_cast<CaptureHandle*>(handle_ptr)->maxOutput(static_cast<size_t>(count)));
+}
+
+/**
+ * Take up to `max_frames` PCM16 samples from the capture ring, resample them
+ * and run the selected clean-up steps; writes floats to the direct buffer `out`.
+ * The samples are converted where AudioRecord wrote them.
+ * @return Samples written to `out`
+ */
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeCaptureChain_nativeProcess(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jlong ring_ptr, jint max_frames, jobject out,
+    jboolean noise_gate, jboolean gain_control, jboolean echo_suppression) {
+
+    auto* handle = reinterpret_cast<CaptureHandle*>(handle_ptr);
+    auto* ring = reinterpret_cast<AudioRing*>(ring_ptr);
+    iris::jni::DirectBuffer<float> output(env, out);
+    if (output.is_null() || max_frames < 0 || ring->frameBytes() != sizeof(int16_t) ||
+        handle->maxOutput(static_cast<size_t>(max_frames)) > output.length()) {
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, "Bad capture buffers");
+        return 0;
+    }
+
+    const size_t count = std::min(ring->available(), static_cast<size_t>(max_frames));
+    float* converted = handle->convertInto(output.data(), count);
+    // Two regions when the samples wrap around the end of the ring
+    for (size_t done = 0; done < count;) {
+        const AudioRing::Region region = ring->readable(count - done);
+        kernels::int16ToFloat(ring->frames<int16_t>() + region.offset, converted + done, region.frames);
+        ring->commitRead(region.frames);
+        done += region.frames;
+    }
+
+    CaptureProcessor::Steps steps;
+    steps.noiseGate = noise_gate == JNI_TRUE;
+    steps.gainControl = gain_control == JNI_TRUE;
+    steps.echoSuppression = echo_suppression == JNI_TRUE;
+    return static_cast<jint>(handle->finish(count, output.data(), steps));
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeCaptureChain_nativeDestroy(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    delete reinterpret_cast<CaptureHandle*>(handle_ptr);
+}
+
+// ============================================================================
+// NativePlaybackChain
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativePlaybackChain_nativeCreate(
+    JNIEnv* env, jobject thiz, jint source_rate, jint device_rate) {
+
+    try {
+        auto handle = std::make_unique<PlaybackHandle>();
+        handle->resampler = makeResampler(source_rate, device_rate);
+        if (handle->resampler) {
+            handle->zeros.assign(handle->resampler->taps(), 0.0f);
+        }
+        return reinterpret_cast<jlong>(handle.release());
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in playback nativeCreate: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativePlaybackChain_nativeMaxOutput(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jint count) {
+
+    return static_cast<jint>(reinterpret_cast<PlaybackHandle*>(handle_ptr)->maxOutput(static_cast<size_t>(count)));
+}
+
+/**
+ * Resample samples[offset, offset + count) to the device rate and write
+ * dithered PCM16 into the playback ring; `end` also flushes the resampler's
+ * tail. Nothing is rendered while the ring lacks room for the block.
+ * @return Samples written to the ring, or -1 if it is too full
+ */
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativePlaybackChain_nativeRender(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jfloatArray samples, jint offset, jint count, jboolean end,
+    jboolean dither, jlong ring_ptr) {
+
+    auto* handle = reinterpret_cast<PlaybackHandle*>(handle_ptr);
+    auto* ring = reinterpret_cast<AudioRing*>(ring_ptr);
+    iris::jni::JFloatArray audio(env, samples);
+    if (audio.is_null() || offset < 0 || count < 0 || offset + count > audio.length() ||
+        ring->frameBytes() != sizeof(int16_t) || handle->maxOutput(static_cast<size_t>(count)) > ring->capacity()) {
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, "Bad playback buffers");
+        return 0;
+    }
+    if (handle->maxOutput(static_cast<size_t>(count)) > ring->space()) {
+        return -1;
+    }
+
+    size_t rendered = 0;
+    const float* source = handle->resample(audio.data() + offset, static_cast<size_t>(count), end == JNI_TRUE,
+                                           rendered);
+    const float ditherLsb = dither == JNI_TRUE ? 1.0f : 0.0f;
+    for (size_t done = 0; done < rendered;) {
+        const AudioRing::Region region = ring->writable(rendered - done);
+        kernels::floatToInt16(source + done, ring->frames<int16_t>() + region.offset, region.frames, ditherLsb,
+                              handle->dither);
+        ring->commitWrite(region.frames);
+        done += region.frames;
+    }
+    return static_cast<jint>(rendered);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativePlaybackChain_nativeDestroy(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    delete reinterpret_cast<PlaybackHandle*>(handle_ptr);
+}
+
+} // extern "C"
@@ -0,0 +1,197 @@
+#include "audio_kernels.h"
+#include "audio_kernels_impl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#define LOG_TAG "IrisAudioKernels"
+#include "audio_log.h"
+
+namespace iris {
+namespace multimodal {
+namespace kernels {
+
+namespace {
+
+// ============================================================================
+// Portable implementations
+// ============================================================================
+
+FrameStats scalarFrameStats(const float* x, size_t count, float previous) {
+    FrameStats stats{0.0f, 0.0f, 0};
+    for (size_t i = 0; i < count; i++) {
+        const float diff = x[i] - previous;
+        stats.energy += x[i] * x[i];
+        stats.diffEnergy += diff * diff;
+        stats.crossings += (x[i] < 0.0f) != (previous < 0.0f);
+        previous = x[i];
+    }
+    return stats;
+}
+
+void scalarMultiply(const float* a, const float* b, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void scalarPower(const float* re, const float* im, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+float scalarDot(const float* a, const float* b, size_t count) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void scalarInt16ToFloat(const int16_t* in, float* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = static_cast<float>(in[i]) * (1.0f / 32768.0f);
+    }
+}
+
+void scalarFloatToInt16(const float* in, int16_t* out, size_t count, float ditherLsb, DitherState& dither) {
+    if (ditherLsb <= 0.0f) {
+        for (size_t i = 0; i < count; i++) {
+            out[i] = toInt16(in[i] * 32767.0f);
+        }
+        return;
+    }
+    // Local copy so the generators stay in registers rather than behind `out`
+    uint32_t lanes[8];
+    std::copy(dither.lanes, dither.lanes + 8, lanes);
+    for (size_t i = 0; i < count; i += 8) {
+        const size_t block = std::min<size_t>(8, count - i);
+        for (size_t k = 0; k < block; k++) {
+            const float noise = ditherUniform(lanes[k]) - ditherUniform(lanes[k]);
+            out[i + k] = toInt16(in[i + k] * 32767.0f + noise * ditherLsb);
+        }
+    }
+    std::copy(lanes, lanes + 8, dither.lanes);
+}
+
+void scalarNoiseGate(float* x, size_t count, float threshold) {
+    if (threshold <= 0.0f) {
+        return;
+    }
+    const float half = 0.5f * threshold;
+    const float inverseHalf = 1.0f / half;
+    for (size_t i = 0; i < count; i++) {
+        x[i] *= gateRatio(std::fabs(x[i]), half, inverseHalf);
+    }
+}
+
+void scalarScaleClamp(float* x, size_t count, float gain, float step) {
+    for (size_t i = 0; i < count; i++) {
+        x[i] = clampUnit(x[i] * (gain + step * static_cast<float>(i)));
+    }
+}
+
+void scalarSubtractScaledClamp(float* x, const float* y, size_t count, float scale) {
+    for (size_t i = 0; i < count; i++) {
+        x[i] = clampUnit(x[i] - scale * y[i]);
+    }
+}
+
+const KernelTable kScalarTable = {
+    "scalar",
+    scalarFrameStats,
+    scalarMultiply,
+    scalarPower,
+    scalarDot,
+    scalarInt16ToFloat,
+    scalarFloatToInt16,
+    scalarNoiseGate,
+    scalarScaleClamp,
+    scalarSubtractScaledClamp,
+};
+
+const KernelTable* selectKernels() {
+#if defined(IRIS_AUDIO_HAVE_NEON)
+    return neonKernels();
+#elif defined(IRIS_AUDIO_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return avx2Kernels();
+    }
+    return scalarKernels();
+#else
+    return scalarKernels();
+#endif
+}
+
+std::atomic<const KernelTable*> activeTable{nullptr};
+
+const KernelTable* table() {
+    const KernelTable* current = activeTable.load(std::memory_order_acquire);
+    if (current == nullptr) {
+        current = selectKernels();
+        activeTable.store(current, std::memory_order_release);
+        LOGI("Using %s audio kernels", current->name);
+    }
+    return current;
+}
+
+} // namespace
+
+const KernelTable* scalarKernels() {
+    return &kScalarTable;
+}
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+const char* backendName() {
+    return table()->name;
+}
+
+void useScalarKernels(bool scalar) {
+    activeTable.store(scalar ? scalarKernels() : selectKernels(), std::memory_order_release);
+}
+
+FrameStats frameStats(const float* x, size_t count, float previous) {
+    return table()->frameStats(x, count, previous);
+}
+
+void multiply(const float* a, const float* b, float* out, size_t count) {
+    table()->multiply(a, b, out, count);
+}
+
+void power(const float* re, const float* im, float* out, size_t count) {
+    table()->power(re, im, out, count);
+}
+
+float dot(const float* a, const float* b, size_t count) {
+    return table()->dot(a, b, count);
+}
+
+void int16ToFloat(const int16_t* in, float* out, size_t count) {
+    table()->int16ToFloat(in, out, count);
+}
+
+void floatToInt16(const float* in, int16_t* out, size_t count, float ditherLsb, DitherState& dither) {
+    table()->floatToInt16(in, out, count, ditherLsb, dither);
+}
+
+void noiseGate(float* x, size_t count, float threshold) {
+    table()->noiseGate(x, count, threshold);
+}
+
+void scaleClamp(float* x, size_t count, float gain, float step) {
+    table()->scaleClamp(x, count, gain, step);
+}
+
+void subtractScaledClamp(float* x, const float* y, size_t count, float scale) {
+    table()->subtractScaledClamp(x, y, count, scale);
+}
+
+} // namespace kernels
+} // namespace multimodal
+} // namespace iris
@@ -0,0 +1,96 @@
+#ifndef IRIS_MULTIMODAL_AUDIO_KERNELS_H
+#define IRIS_MULTIMODAL_AUDIO_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace iris {
+namespace multimodal {
+namespace kernels {
+
+/**
+ * Per-frame signal kernels for the audio front end.
+ *
+ * The implementation is picked once at first use: NEON on arm64, AVX2/FMA on
+ * x86-64, portable C++ otherwise. All kernels take float samples in [-1, 1]
+ * and any length; none of them allocates.
+ */
+
+/**
+ * Name of the selected implementation ("neon", "avx2", "scalar")
+ */
+const char* backendName();
+
+struct FrameStats {
+    float energy;       // sum of x[i]^2
+    float diffEnergy;   // sum of (x[i] - x[i-1])^2, a cheap high-frequency measure
+    uint32_t crossings; // sign changes between consecutive samples
+};
+
+/**
+ * Energy, first-difference energy and zero crossings of one frame
+ * @param previous The sample before x[0] (0 at the start of a stream)
+ */
+FrameStats frameStats(const float* x, size_t count, float previous);
+
+/**
+ * out[i] = a[i] * b[i]; applies an analysis window to a frame
+ */
+void multiply(const float* a, const float* b, float* out, size_t count);
+
+/**
+ * out[i] = re[i]^2 + im[i]^2; power spectrum of split-complex FFT bins
+ */
+void power(const float* re, const float* im, float* out, size_t count);
+
+/**
+ * Sum of a[i] * b[i]; one mel band of the filterbank
+ */
+float dot(const float* a, const float* b, size_t count);
+
+/**
+ * Per-lane xorshift32 generators for dither; any non-zero seeds
+ */
+struct DitherState {
+    uint32_t lanes[8] = {0x9e3779b9u, 0x7f4a7c15u, 0x85ebca6bu, 0xc2b2ae35u,
+                         0x27d4eb2fu, 0x165667b1u, 0xd3a2646cu, 0xfd7046c5u};
+};
+
+/**
+ * out[i] = in[i] / 32768
+ */
+void int16ToFloat(const int16_t* in, float* out, size_t count);
+
+/**
+ * out[i] = in[i] * 32767 plus triangular (TPDF) dither of up to ditherLsb
+ * steps, rounded to nearest and saturated; ditherLsb = 0 disables dither
+ */
+void floatToInt16(const float* in, int16_t* out, size_t count, float ditherLsb, DitherState& dither);
+
+/**
+ * Soft noise gate in place: samples below threshold / 2 become 0, samples
+ * between threshold / 2 and threshold are scaled down linearly, louder ones
+ * pass unchanged
+ */
+void noiseGate(float* x, size_t count, float threshold);
+
+/**
+ * x[i] = clamp(x[i] * (gain + step * i), -1, 1) in place; a gain ramp
+ */
+void scaleClamp(float* x, size_t count, float gain, float step);
+
+/**
+ * x[i] = clamp(x[i] - scale * y[i], -1, 1) in place; y must not overlap x
+ */
+void subtractScaledClamp(float* x, const float* y, size_t count, float scale);
+
+/**
+ * Force the portable implementation; used by benchmarks to get a baseline
+ */
+void useScalarKernels(bool scalar);
+
+} // namespace kernels
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_AUDIO_KERNELS_H
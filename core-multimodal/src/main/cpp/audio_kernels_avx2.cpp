@@ -0,0 +1,239 @@
+// Built with -mavx2 -mfma; only reached after a runtime CPU check.
+#include "audio_kernels_impl.h"
+
+#include <immintrin.h>
+
+#include <cmath>
+
+namespace iris {
+namespace multimodal {
+namespace kernels {
+
+namespace {
+
+inline float horizontalSum(__m256 v) {
+    const __m128 low = _mm256_castps256_ps128(v);
+    const __m128 high = _mm256_extractf128_ps(v, 1);
+    __m128 sum = _mm_add_ps(low, high);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+    return _mm_cvtss_f32(sum);
+}
+
+FrameStats avx2FrameStats(const float* x, size_t count, float previous) {
+    FrameStats stats{0.0f, 0.0f, 0};
+    if (count == 0) {
+        return stats;
+    }
+    // x[0] pairs with `previous`; every later sample pairs with the one before it in x
+    const float diff0 = x[0] - previous;
+    float energy = x[0] * x[0];
+    float diffEnergy = diff0 * diff0;
+    uint32_t crossings = (x[0] < 0.0f) != (previous < 0.0f);
+
+    const __m256 zero = _mm256_setzero_ps();
+    __m256 energyAcc = _mm256_setzero_ps();
+    __m256 diffAcc = _mm256_setzero_ps();
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 current = _mm256_loadu_ps(x + i);
+        const __m256 before = _mm256_loadu_ps(x + i - 1);
+        const __m256 diff = _mm256_sub_ps(current, before);
+        energyAcc = _mm256_fmadd_ps(current, current, energyAcc);
+        diffAcc = _mm256_fmadd_ps(diff, diff, diffAcc);
+        const int negative = _mm256_movemask_ps(_mm256_cmp_ps(current, zero, _CMP_LT_OQ));
+        const int negativeBefore = _mm256_movemask_ps(_mm256_cmp_ps(before, zero, _CMP_LT_OQ));
+        crossings += static_cast<uint32_t>(__builtin_popcount(negative ^ negativeBefore));
+    }
+    energy += horizontalSum(energyAcc);
+    diffEnergy += horizontalSum(diffAcc);
+    for (; i < count; i++) {
+        const float diff = x[i] - x[i - 1];
+        energy += x[i] * x[i];
+        diffEnergy += diff * diff;
+        crossings += (x[i] < 0.0f) != (x[i - 1] < 0.0f);
+    }
+    stats.energy = energy;
+    stats.diffEnergy = diffEnergy;
+    stats.crossings = crossings;
+    return stats;
+}
+
+void avx2Multiply(const float* a, const float* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    for (; i < count; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void avx2Power(const float* re, const float* im, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 r = _mm256_loadu_ps(re + i);
+        const __m256 m = _mm256_loadu_ps(im + i);
+        _mm256_storeu_ps(out + i, _mm256_fmadd_ps(r, r, _mm256_mul_ps(m, m)));
+    }
+    for (; i < count; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+float avx2Dot(const float* a, const float* b, size_t count) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+    }
+    if (i + 8 <= count) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        i += 8;
+    }
+    float sum = horizontalSum(_mm256_add_ps(acc0, acc1));
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void avx2Int16ToFloat(const int16_t* in, float* out, size_t count) {
+    const __m256 scale = _mm256_set1_ps(1.0f / 32768.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(packed)), scale));
+    }
+    for (; i < count; i++) {
+        out[i] = static_cast<float>(in[i]) * (1.0f / 32768.0f);
+    }
+}
+
+inline __m256i xorshift(__m256i state) {
+    state = _mm256_xor_si256(state, _mm256_slli_epi32(state, 13));
+    state = _mm256_xor_si256(state, _mm256_srli_epi32(state, 17));
+    return _mm256_xor_si256(state, _mm256_slli_epi32(state, 5));
+}
+
+inline __m256 uniform(__m256i state) {
+    return _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(state, 8)), _mm256_set1_ps(1.0f / 16777216.0f));
+}
+
+void avx2FloatToInt16(const float* in, int16_t* out, size_t count, float ditherLsb, DitherState& dither) {
+    const __m256 scale = _mm256_set1_ps(32767.0f);
+    const __m256 amplitude = _mm256_set1_ps(ditherLsb);
+    const __m256 low = _mm256_set1_ps(-32768.0f);
+    const __m256 high = _mm256_set1_ps(32767.0f);
+    const bool dithered = ditherLsb > 0.0f;
+    __m256i state = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dither.lanes));
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 v0 = _mm256_mul_ps(_mm256_loadu_ps(in + i), scale);
+        __m256 v1 = _mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale);
+        if (dithered) {
+            __m256i a = xorshift(state);
+            __m256i b = xorshift(a);
+            v0 = _mm256_fmadd_ps(_mm256_sub_ps(uniform(a), uniform(b)), amplitude, v0);
+            a = xorshift(b);
+            state = xorshift(a);
+            v1 = _mm256_fmadd_ps(_mm256_sub_ps(uniform(a), uniform(state)), amplitude, v1);
+        }
+        // Clamp before converting: out-of-range floats convert to INT32_MIN
+        const __m256i i0 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v0, low), high));
+        const __m256i i1 = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(v1, low), high));
+        // packs works per 128-bit lane; restore sample order afterwards
+        const __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(i0, i1), 0xD8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dither.lanes), state);
+    for (; i < count; i++) {
+        float value = in[i] * 32767.0f;
+        if (dithered) {
+            uint32_t& lane = dither.lanes[i & 7];
+            value += (ditherUniform(lane) - ditherUniform(lane)) * ditherLsb;
+        }
+        out[i] = toInt16(value);
+    }
+}
+
+void avx2NoiseGate(float* x, size_t count, float threshold) {
+    if (threshold <= 0.0f) {
+        return;
+    }
+    const float half = 0.5f * threshold;
+    const float inverseHalf = 1.0f / half;
+    const __m256 halfV = _mm256_set1_ps(half);
+    const __m256 inverseV = _mm256_set1_ps(inverseHalf);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_loadu_ps(x + i);
+        const __m256 magnitude = _mm256_and_ps(v, absMask);
+        const __m256 ratio = _mm256_mul_ps(_mm256_sub_ps(magnitude, halfV), inverseV);
+        _mm256_storeu_ps(x + i, _mm256_mul_ps(v, _mm256_min_ps(_mm256_max_ps(ratio, zero), one)));
+    }
+    for (; i < count; i++) {
+        x[i] *= gateRatio(std::fabs(x[i]), half, inverseHalf);
+    }
+}
+
+void avx2ScaleClamp(float* x, size_t count, float gain, float step) {
+    const __m256 low = _mm256_set1_ps(-1.0f);
+    const __m256 high = _mm256_set1_ps(1.0f);
+    const __m256 gainV = _mm256_set1_ps(gain);
+    const __m256 stepV = _mm256_set1_ps(step);
+    __m256 index = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256 eight = _mm256_set1_ps(8.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 g = _mm256_fmadd_ps(stepV, index, gainV);
+        const __m256 v = _mm256_mul_ps(_mm256_loadu_ps(x + i), g);
+        _mm256_storeu_ps(x + i, _mm256_min_ps(_mm256_max_ps(v, low), high));
+        index = _mm256_add_ps(index, eight);
+    }
+    for (; i < count; i++) {
+        x[i] = clampUnit(x[i] * (gain + step * static_cast<float>(i)));
+    }
+}
+
+void avx2SubtractScaledClamp(float* x, const float* y, size_t count, float scale) {
+    const __m256 low = _mm256_set1_ps(-1.0f);
+    const __m256 high = _mm256_set1_ps(1.0f);
+    const __m256 negativeScale = _mm256_set1_ps(-scale);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256 v = _mm256_fmadd_ps(negativeScale, _mm256_loadu_ps(y + i), _mm256_loadu_ps(x + i));
+        _mm256_storeu_ps(x + i, _mm256_min_ps(_mm256_max_ps(v, low), high));
+    }
+    for (; i < count; i++) {
+        x[i] = clampUnit(x[i] - scale * y[i]);
+    }
+}
+
+const KernelTable kAvx2Table = {
+    "avx2",
+    avx2FrameStats,
+    avx2Multiply,
+    avx2Power,
+    avx2Dot,
+    avx2Int16ToFloat,
+    avx2FloatToInt16,
+    avx2NoiseGate,
+    avx2ScaleClamp,
+    avx2SubtractScaledClamp,
+};
+
+} // namespace
+
+const KernelTable* avx2Kernels() {
+    return &kAvx2Table;
+}
+
+} // namespace kernels
+} // namespace multimodal
+} // namespace iris
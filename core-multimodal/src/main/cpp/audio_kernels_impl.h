@@ -0,0 +1,72 @@
+#ifndef IRIS_MULTIMODAL_AUDIO_KERNELS_IMPL_H
+#define IRIS_MULTIMODAL_AUDIO_KERNELS_IMPL_H
+
+#include "audio_kernels.h"
+
+namespace iris {
+namespace multimodal {
+namespace kernels {
+
+/**
+ * One implementation of every kernel; the dispatcher in audio_kernels.cpp
+ * picks a table once per process. Architecture-specific tables live in their
+ * own translation units so only they are built with extended ISA flags.
+ */
+struct KernelTable {
+    const char* name;
+    FrameStats (*frameStats)(const float*, size_t, float);
+    void (*multiply)(const float*, const float*, float*, size_t);
+    void (*power)(const float*, const float*, float*, size_t);
+    float (*dot)(const float*, const float*, size_t);
+    void (*int16ToFloat)(const int16_t*, float*, size_t);
+    void (*floatToInt16)(const float*, int16_t*, size_t, float, DitherState&);
+    void (*noiseGate)(float*, size_t, float);
+    void (*scaleClamp)(float*, size_t, float, float);
+    void (*subtractScaledClamp)(float*, const float*, size_t, float);
+};
+
+const KernelTable* scalarKernels();
+
+// Shared by every table for the tails of vector loops
+inline uint32_t nextDither(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Uniform in [0, 1) from the top 24 bits
+inline float ditherUniform(uint32_t& state) {
+    return static_cast<float>(static_cast<int32_t>(nextDither(state) >> 8)) * (1.0f / 16777216.0f);
+}
+
+// Saturate, then round to nearest even like the SIMD conversions: adding 1.5 * 2^23
+// leaves no fraction bits, so the FPU rounds (lrint would be a library call)
+inline int16_t toInt16(float value) {
+    const float scaled = value < -32768.0f ? -32768.0f : (value > 32767.0f ? 32767.0f : value);
+    return static_cast<int16_t>((scaled + 12582912.0f) - 12582912.0f);
+}
+
+inline float clampUnit(float value) {
+    return value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+}
+
+// Gate ratio: 0 below half the threshold, 1 from the threshold up, linear between
+inline float gateRatio(float magnitude, float half, float inverseHalf) {
+    const float ratio = (magnitude - half) * inverseHalf;
+    return ratio < 0.0f ? 0.0f : (ratio > 1.0f ? 1.0f : ratio);
+}
+
+#if defined(IRIS_AUDIO_HAVE_NEON)
+const KernelTable* neonKernels();
+#endif
+
+#if defined(IRIS_AUDIO_HAVE_AVX2)
+const KernelTable* avx2Kernels();
+#endif
+
+} // namespace kernels
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_AUDIO_KERNELS_IMPL_H
@@ -0,0 +1,234 @@
+// arm64 only; NEON is part of the base ISA there.
+#include "audio_kernels_impl.h"
+
+#include <arm_neon.h>
+
+#include <cmath>
+
+namespace iris {
+namespace multimodal {
+namespace kernels {
+
+namespace {
+
+FrameStats neonFrameStats(const float* x, size_t count, float previous) {
+    FrameStats stats{0.0f, 0.0f, 0};
+    if (count == 0) {
+        return stats;
+    }
+    // x[0] pairs with `previous`; every later sample pairs with the one before it in x
+    const float diff0 = x[0] - previous;
+    float energy = x[0] * x[0];
+    float diffEnergy = diff0 * diff0;
+    uint32_t crossings = (x[0] < 0.0f) != (previous < 0.0f);
+
+    float32x4_t energyAcc0 = vdupq_n_f32(0.0f);
+    float32x4_t energyAcc1 = vdupq_n_f32(0.0f);
+    float32x4_t diffAcc0 = vdupq_n_f32(0.0f);
+    float32x4_t diffAcc1 = vdupq_n_f32(0.0f);
+    uint32x4_t crossingAcc = vdupq_n_u32(0);
+    size_t i = 1;
+    for (; i + 8 <= count; i += 8) {
+        const float32x4_t current0 = vld1q_f32(x + i);
+        const float32x4_t current1 = vld1q_f32(x + i + 4);
+        const float32x4_t before0 = vld1q_f32(x + i - 1);
+        const float32x4_t before1 = vld1q_f32(x + i + 3);
+        const float32x4_t diff0v = vsubq_f32(current0, before0);
+        const float32x4_t diff1v = vsubq_f32(current1, before1);
+        energyAcc0 = vfmaq_f32(energyAcc0, current0, current0);
+        energyAcc1 = vfmaq_f32(energyAcc1, current1, current1);
+        diffAcc0 = vfmaq_f32(diffAcc0, diff0v, diff0v);
+        diffAcc1 = vfmaq_f32(diffAcc1, diff1v, diff1v);
+        // Sign bits differ exactly when one side is negative: (a < 0) ^ (b < 0) is all ones or zero
+        const uint32x4_t change0 = veorq_u32(vcltzq_f32(current0), vcltzq_f32(before0));
+        const uint32x4_t change1 = veorq_u32(vcltzq_f32(current1), vcltzq_f32(before1));
+        crossingAcc = vsraq_n_u32(crossingAcc, change0, 31);
+        crossingAcc = vsraq_n_u32(crossingAcc, change1, 31);
+    }
+    energy += vaddvq_f32(vaddq_f32(energyAcc0, energyAcc1));
+    diffEnergy += vaddvq_f32(vaddq_f32(diffAcc0, diffAcc1));
+    crossings += vaddvq_u32(crossingAcc);
+    for (; i < count; i++) {
+        const float diff = x[i] - x[i - 1];
+        energy += x[i] * x[i];
+        diffEnergy += diff * diff;
+        crossings += (x[i] < 0.0f) != (x[i - 1] < 0.0f);
+    }
+    stats.energy = energy;
+    stats.diffEnergy = diffEnergy;
+    stats.crossings = crossings;
+    return stats;
+}
+
+void neonMultiply(const float* a, const float* b, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        vst1q_f32(out + i, vmulq_f32(vld1q_f32(a + i), vld1q_f32(b + i)));
+    }
+    for (; i < count; i++) {
+        out[i] = a[i] * b[i];
+    }
+}
+
+void neonPower(const float* re, const float* im, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t r = vld1q_f32(re + i);
+        const float32x4_t m = vld1q_f32(im + i);
+        vst1q_f32(out + i, vfmaq_f32(vmulq_f32(m, m), r, r));
+    }
+    for (; i < count; i++) {
+        out[i] = re[i] * re[i] + im[i] * im[i];
+    }
+}
+
+float neonDot(const float* a, const float* b, size_t count) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    if (i + 4 <= count) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        i += 4;
+    }
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < count; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+void neonInt16ToFloat(const int16_t* in, float* out, size_t count) {
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const int16x8_t packed = vld1q_s16(in + i);
+        // Fixed-point conversion with 15 fraction bits divides by 32768
+        vst1q_f32(out + i, vcvtq_n_f32_s32(vmovl_s16(vget_low_s16(packed)), 15));
+        vst1q_f32(out + i + 4, vcvtq_n_f32_s32(vmovl_s16(vget_high_s16(packed)), 15));
+    }
+    for (; i < count; i++) {
+        out[i] = static_cast<float>(in[i]) * (1.0f / 32768.0f);
+    }
+}
+
+inline uint32x4_t xorshift(uint32x4_t state) {
+    state = veorq_u32(state, vshlq_n_u32(state, 13));
+    state = veorq_u32(state, vshrq_n_u32(state, 17));
+    return veorq_u32(state, vshlq_n_u32(state, 5));
+}
+
+inline float32x4_t uniform(uint32x4_t state) {
+    return vcvtq_n_f32_u32(vshrq_n_u32(state, 8), 24);
+}
+
+void neonFloatToInt16(const float* in, int16_t* out, size_t count, float ditherLsb, DitherState& dither) {
+    const float32x4_t low = vdupq_n_f32(-32768.0f);
+    const float32x4_t high = vdupq_n_f32(32767.0f);
+    const bool dithered = ditherLsb > 0.0f;
+    uint32x4_t state0 = vld1q_u32(dither.lanes);
+    uint32x4_t state1 = vld1q_u32(dither.lanes + 4);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        float32x4_t v0 = vmulq_n_f32(vld1q_f32(in + i), 32767.0f);
+        float32x4_t v1 = vmulq_n_f32(vld1q_f32(in + i + 4), 32767.0f);
+        if (dithered) {
+            const uint32x4_t a0 = xorshift(state0);
+            const uint32x4_t a1 = xorshift(state1);
+            state0 = xorshift(a0);
+            state1 = xorshift(a1);
+            v0 = vfmaq_n_f32(v0, vsubq_f32(uniform(a0), uniform(state0)), ditherLsb);
+            v1 = vfmaq_n_f32(v1, vsubq_f32(uniform(a1), uniform(state1)), ditherLsb);
+        }
+        const int32x4_t i0 = vcvtnq_s32_f32(vminq_f32(vmaxq_f32(v0, low), high));
+        const int32x4_t i1 = vcvtnq_s32_f32(vminq_f32(vmaxq_f32(v1, low), high));
+        vst1q_s16(out + i, vcombine_s16(vqmovn_s32(i0), vqmovn_s32(i1)));
+    }
+    vst1q_u32(dither.lanes, state0);
+    vst1q_u32(dither.lanes + 4, state1);
+    for (; i < count; i++) {
+        float value = in[i] * 32767.0f;
+        if (dithered) {
+            uint32_t& lane = dither.lanes[i & 7];
+            value += (ditherUniform(lane) - ditherUniform(lane)) * ditherLsb;
+        }
+        out[i] = toInt16(value);
+    }
+}
+
+void neonNoiseGate(float* x, size_t count, float threshold) {
+    if (threshold <= 0.0f) {
+        return;
+    }
+    const float half = 0.5f * threshold;
+    const float inverseHalf = 1.0f / half;
+    const float32x4_t halfV = vdupq_n_f32(half);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t one = vdupq_n_f32(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t v = vld1q_f32(x + i);
+        const float32x4_t ratio = vmulq_n_f32(vsubq_f32(vabsq_f32(v), halfV), inverseHalf);
+        vst1q_f32(x + i, vmulq_f32(v, vminq_f32(vmaxq_f32(ratio, zero), one)));
+    }
+    for (; i < count; i++) {
+        x[i] *= gateRatio(std::fabs(x[i]), half, inverseHalf);
+    }
+}
+
+void neonScaleClamp(float* x, size_t count, float gain, float step) {
+    const float32x4_t low = vdupq_n_f32(-1.0f);
+    const float32x4_t high = vdupq_n_f32(1.0f);
+    const float32x4_t gainV = vdupq_n_f32(gain);
+    const float indexInit[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t index = vld1q_f32(indexInit);
+    const float32x4_t four = vdupq_n_f32(4.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t g = vfmaq_n_f32(gainV, index, step);
+        const float32x4_t v = vmulq_f32(vld1q_f32(x + i), g);
+        vst1q_f32(x + i, vminq_f32(vmaxq_f32(v, low), high));
+        index = vaddq_f32(index, four);
+    }
+    for (; i < count; i++) {
+        x[i] = clampUnit(x[i] * (gain + step * static_cast<float>(i)));
+    }
+}
+
+void neonSubtractScaledClamp(float* x, const float* y, size_t count, float scale) {
+    const float32x4_t low = vdupq_n_f32(-1.0f);
+    const float32x4_t high = vdupq_n_f32(1.0f);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const float32x4_t v = vfmsq_n_f32(vld1q_f32(x + i), vld1q_f32(y + i), scale);
+        vst1q_f32(x + i, vminq_f32(vmaxq_f32(v, low), high));
+    }
+    for (; i < count; i++) {
+        x[i] = clampUnit(x[i] - scale * y[i]);
+    }
+}
+
+const KernelTable kNeonTable = {
+    "neon",
+    neonFrameStats,
+    neonMultiply,
+    neonPower,
+    neonDot,
+    neonInt16ToFloat,
+    neonFloatToInt16,
+    neonNoiseGate,
+    neonScaleClamp,
+    neonSubtractScaledClamp,
+};
+
+} // namespace
+
+const KernelTable* neonKernels() {
+    return &kNeonTable;
+}
+
+} // namespace kernels
+} // namespace multimodal
+} // namespace iris
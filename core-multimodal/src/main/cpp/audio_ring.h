@@ -0,0 +1,192 @@
+#ifndef IRIS_MULTIMODAL_AUDIO_RING_H
+#define IRIS_MULTIMODAL_AUDIO_RING_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace iris {
+namespace multimodal {
+
+/**
+ * Lock-free single-producer single-consumer ring of fixed-size audio frames
+ * (2 bytes for PCM16, 4 for float).
+ *
+ * The storage is one block that never moves, so Java can map it as a direct
+ * ByteBuffer: AudioRecord reads into a writable region and AudioTrack writes
+ * from a readable region with no copy in between. Regions are contiguous, so
+ * a wrap takes two of them.
+ *
+ * Positions are 64-bit frame counts that only grow; the producer owns the
+ * write position and the consumer the read position, each published with
+ * release and observed with acquire. They sit on separate cache lines.
+ *
+ * Overruns are frames the producer had to drop because the ring was full;
+ * underruns are the times the consumer needed audio and found none.
+ */
+class AudioRing {
+public:
+    struct Region {
+        size_t offset; // in frames from data()
+        size_t frames;
+    };
+
+    /**
+     * @param capacityFrames Rounded up to a power of two
+     */
+    AudioRing(size_t capacityFrames, size_t frameBytes)
+        : frameBytes_(frameBytes), capacity_(roundUp(capacityFrames)), mask_(capacity_ - 1),
+          storage_(capacity_ * frameBytes) {}
+
+    AudioRing(const AudioRing&) = delete;
+    AudioRing& operator=(const AudioRing&) = delete;
+
+    size_t capacity() const { return capacity_; }
+    size_t frameBytes() const { return frameBytes_; }
+    uint8_t* data() { return storage_.data(); }
+    size_t bytes() const { return storage_.size(); }
+
+    template <typename T>
+    T* frames() {
+        return reinterpret_cast<T*>(storage_.data());
+    }
+
+    // ------------------------------------------------------------------------
+    // Producer
+    // ------------------------------------------------------------------------
+
+    size_t space() const {
+        return capacity_ - static_cast<size_t>(write_.load(std::memory_order_relaxed) -
+                                               read_.load(std::memory_order_acquire));
+    }
+
+    /**
+     * Free space at the write position, up to the end of the storage
+     */
+    Region writable(size_t maxFrames) const {
+        const uint64_t position = write_.load(std::memory_order_relaxed);
+        const size_t offset = static_cast<size_t>(position) & mask_;
+        const size_t frames = std::min(std::min(space(), capacity_ - offset), maxFrames);
+        return {offset, frames};
+    }
+
+    /**
+     * Publish frames written into the last writable() region
+     */
+    void commitWrite(size_t frames) {
+        write_.store(write_.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+    }
+
+    /**
+     * Copy as many frames as fit; the rest are dropped and counted as overrun
+     * @return Frames written
+     */
+    size_t write(const void* source, size_t frames) {
+        const auto* bytes = static_cast<const uint8_t*>(source);
+        size_t written = 0;
+        while (written < frames) {
+            const Region region = writable(frames - written);
+            if (region.frames == 0) {
+                break;
+            }
+            std::memcpy(storage_.data() + region.offset * frameBytes_, bytes + written * frameBytes_,
+                        region.frames * frameBytes_);
+            commitWrite(region.frames);
+            written += region.frames;
+        }
+        reportOverrun(frames - written);
+        return written;
+    }
+
+    void reportOverrun(size_t frames) {
+        if (frames > 0) {
+            overrunFrames_.fetch_add(frames, std::memory_order_relaxed);
+        }
+    }
+
+    // ------------------------------------------------------------------------
+    // Consumer
+    // ------------------------------------------------------------------------
+
+    size_t available() const {
+        return static_cast<size_t>(write_.load(std::memory_order_acquire) - read_.load(std::memory_order_relaxed));
+    }
+
+    /**
+     * Frames at the read position, up to the end of the storage
+     */
+    Region readable(size_t maxFrames) const {
+        const uint64_t position = read_.load(std::memory_order_relaxed);
+        const size_t offset = static_cast<size_t>(position) & mask_;
+        const size_t frames = std::min(std::min(available(), capacity_ - offset), maxFrames);
+        return {offset, frames};
+    }
+
+    /**
+     * Release frames read from the last readable() region
+     */
+    void commitRead(size_t frames) {
+        read_.store(read_.load(std::memory_order_relaxed) + frames, std::memory_order_release);
+    }
+
+    /**
+     * Copy up to `frames` frames out; a short read counts as an underrun
+     * @return Frames read
+     */
+    size_t read(void* destination, size_t frames) {
+        auto* bytes = static_cast<uint8_t*>(destination);
+        size_t done = 0;
+        while (done < frames) {
+            const Region region = readable(frames - done);
+            if (region.frames == 0) {
+                break;
+            }
+            std::memcpy(bytes + done * frameBytes_, storage_.data() + region.offset * frameBytes_,
+                        region.frames * frameBytes_);
+            commitRead(region.frames);
+            done += region.frames;
+        }
+        if (done < frames) {
+            reportUnderrun();
+        }
+        return done;
+    }
+
+    void reportUnderrun() { underruns_.fetch_add(1, std::memory_order_relaxed); }
+
+    // ------------------------------------------------------------------------
+    // Either side
+    // ------------------------------------------------------------------------
+
+    uint64_t framesWritten() const { return write_.load(std::memory_order_acquire); }
+    uint64_t framesRead() const { return read_.load(std::memory_order_acquire); }
+    uint64_t overrunFrames() const { return overrunFrames_.load(std::memory_order_relaxed); }
+    uint64_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+private:
+    static size_t roundUp(size_t frames) {
+        size_t capacity = 1;
+        while (capacity < frames) {
+            capacity <<= 1;
+        }
+        return capacity;
+    }
+
+    const size_t frameBytes_;
+    const size_t capacity_;
+    const size_t mask_;
+    std::vector<uint8_t> storage_;
+
+    alignas(64) std::atomic<uint64_t> write_{0};
+    alignas(64) std::atomic<uint64_t> read_{0};
+    alignas(64) std::atomic<uint64_t> overrunFrames_{0};
+    std::atomic<uint64_t> underruns_{0};
+};
+
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_AUDIO_RING_H
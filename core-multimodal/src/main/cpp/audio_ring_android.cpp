@@ -0,0 +1,139 @@
+#include <jni.h>
+#include <exception>
+
+#include "audio_ring.h"
+#include "jni_utils.h"
+
+using iris::multimodal::AudioRing;
+
+namespace {
+
+AudioRing* ringFrom(jlong handle_ptr) {
+    return reinterpret_cast<AudioRing*>(handle_ptr);
+}
+
+} // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeCreate(
+    JNIEnv* env, jobject thiz, jint capacity_frames, jint frame_bytes) {
+
+    if (capacity_frames <= 0 || frame_bytes <= 0) {
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, "Ring size must be positive");
+        return 0;
+    }
+    try {
+        return reinterpret_cast<jlong>(
+            new AudioRing(static_cast<size_t>(capacity_frames), static_cast<size_t>(frame_bytes)));
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in ring nativeCreate: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::RUNTIME, e.what());
+        return 0;
+    }
+}
+
+/**
+ * The ring's storage as a direct ByteBuffer; regions index it in frames
+ */
+JNIEXPORT jobject JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeBuffer(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    AudioRing* ring = ringFrom(handle_ptr);
+    return env->NewDirectByteBuffer(ring->data(), static_cast<jlong>(ring->bytes()));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeCapacity(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    return static_cast<jint>(ringFrom(handle_ptr)->capacity());
+}
+
+/**
+ * Contiguous free space at the write position: out_region receives offset and frames
+ */
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeWritable(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jint max_frames, jintArray out_region) {
+
+    const AudioRing::Region region = ringFrom(handle_ptr)->writable(static_cast<size_t>(max_frames));
+    const jint values[2] = {static_cast<jint>(region.offset), static_cast<jint>(region.frames)};
+    env->SetIntArrayRegion(out_region, 0, 2, values);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeCommitWrite(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jint frames) {
+
+    ringFrom(handle_ptr)->commitWrite(static_cast<size_t>(frames));
+}
+
+/**
+ * Contiguous audio at the read position: out_region receives offset and frames
+ */
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeReadable(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jint max_frames, jintArray out_region) {
+
+    const AudioRing::Region region = ringFrom(handle_ptr)->readable(static_cast<size_t>(max_frames));
+    const jint values[2] = {static_cast<jint>(region.offset), static_cast<jint>(region.frames)};
+    env->SetIntArrayRegion(out_region, 0, 2, values);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeCommitRead(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jint frames) {
+
+    ringFrom(handle_ptr)->commitRead(static_cast<size_t>(frames));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeAvailable(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    return static_cast<jint>(ringFrom(handle_ptr)->available());
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeReportOverrun(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jint frames) {
+
+    ringFrom(handle_ptr)->reportOverrun(static_cast<size_t>(frames));
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeReportUnderrun(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    ringFrom(handle_ptr)->reportUnderrun();
+}
+
+/**
+ * Frames written, frames read, frames dropped (overrun) and underruns
+ */
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeStats(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jlongArray out_stats) {
+
+    const AudioRing* ring = ringFrom(handle_ptr);
+    const jlong values[4] = {
+        static_cast<jlong>(ring->framesWritten()),
+        static_cast<jlong>(ring->framesRead()),
+        static_cast<jlong>(ring->overrunFrames()),
+        static_cast<jlong>(ring->underruns()),
+    };
+    env->SetLongArrayRegion(out_stats, 0, 4, values);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_audio_NativeAudioRing_nativeDestroy(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    delete ringFrom(handle_ptr);
+}
+
+} // extern "C"
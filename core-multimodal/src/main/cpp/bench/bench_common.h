@@ -0,0 +1,80 @@
+#ifndef IRIS_MULTIMODAL_BENCH_COMMON_H
+#define IRIS_MULTIMODAL_BENCH_COMMON_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace iris {
+namespace bench {
+
+/**
+ * Integer command-line argument with default
+ */
+inline long argOr(int argc, char** argv, int position, long fallback) {
+    return argc > position ? std::strtol(argv[position], nullptr, 10) : fallback;
+}
+
+class Timer {
+public:
+    Timer() : start_(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    double elapsedUs() const { return elapsedMs() * 1000.0; }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Samples of a 16-bit PCM WAV file, channels averaged, scaled to [-1, 1]
+ * @return false if the file is not 16-bit PCM WAV
+ */
+inline bool readWav(const std::string& path, std::vector<float>& samples, int& sampleRate) {
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0 || std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) {
+        return false;
+    }
+    auto u16 = [&](size_t at) { return static_cast<uint16_t>(uint8_t(bytes[at]) | uint8_t(bytes[at + 1]) << 8); };
+    auto u32 = [&](size_t at) { return static_cast<uint32_t>(u16(at) | uint32_t(u16(at + 2)) << 16); };
+    int channels = 0;
+    int bits = 0;
+    for (size_t at = 12; at + 8 <= bytes.size();) {
+        const uint32_t size = u32(at + 4);
+        if (std::memcmp(bytes.data() + at, "fmt ", 4) == 0 && at + 24 <= bytes.size()) {
+            channels = u16(at + 10);
+            sampleRate = static_cast<int>(u32(at + 12));
+            bits = u16(at + 22);
+            if (u16(at + 8) != 1) {
+                return false;
+            }
+        } else if (std::memcmp(bytes.data() + at, "data", 4) == 0 && channels > 0 && bits == 16) {
+            const size_t frames = std::min<size_t>(size, bytes.size() - at - 8) / (2 * channels);
+            samples.assign(frames, 0.0f);
+            for (size_t f = 0; f < frames; f++) {
+                float sum = 0.0f;
+                for (int c = 0; c < channels; c++) {
+                    sum += static_cast<int16_t>(u16(at + 8 + 2 * (f * channels + c))) / 32768.0f;
+                }
+                samples[f] = sum / channels;
+            }
+            return true;
+        }
+        at += 8 + size + (size & 1);
+    }
+    return false;
+}
+
+} // namespace bench
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_BENCH_COMMON_H
@@ -0,0 +1,367 @@
+/**
+ * The native capture and playback DSP against the Kotlin code it replaces.
+ *
+ * The "kotlin" columns are C++ ports of AudioProcessorImpl's loops with the
+ * same shape: a new array per step (copyOf, sliceArray, map), averages in
+ * double, one sample at a time. The JIT does better than -O0 on these but no
+ * better than this; the numbers are a floor on the Kotlin cost, not a
+ * measurement of it.
+ *
+ * Reported:
+ *   - the resampler's pass band gain and residual (everything that is not
+ *     the input tone: aliases, images, filter error) for a 1 kHz tone and a
+ *     tone at 80% of the lower Nyquist frequency, and its rejection of a tone
+ *     above the output Nyquist frequency when decimating, for each rate pair
+ *     the app uses;
+ *   - the resampler's throughput in multiples of real time;
+ *   - PCM16 conversion and the capture chain (gate, AGC, echo) per second of
+ *     audio, Kotlin-shaped, native and native on portable kernels;
+ *   - the largest difference between the Kotlin-shaped chain and the native
+ *     chain on the same chunks, which should be float rounding.
+ *
+ * Usage: dsp_bench [chunkSamples=3840] [seconds=60]
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "../audio_dsp.h"
+#include "../audio_kernels.h"
+#include "bench_common.h"
+
+using iris::multimodal::CaptureProcessor;
+using iris::multimodal::PolyphaseResampler;
+namespace bench = iris::bench;
+namespace kernels = iris::multimodal::kernels;
+
+namespace {
+
+constexpr size_t kRate = 16000;
+
+// ============================================================================
+// AudioProcessorImpl, ported loop for loop
+// ============================================================================
+
+namespace kotlin {
+
+std::vector<float> toFloat(const std::vector<int16_t>& buffer) {
+    std::vector<float> out(buffer.size());
+    for (size_t i = 0; i < buffer.size(); i++) {
+        out[i] = buffer[i] / 32768.0f;
+    }
+    return out;
+}
+
+std::vector<int16_t> toShort(const std::vector<float>& audio) {
+    std::vector<int16_t> out(audio.size());
+    for (size_t i = 0; i < audio.size(); i++) {
+        const int value = static_cast<int>(audio[i] * 32767.0f);
+        out[i] = static_cast<int16_t>(std::min(std::max(value, -32768), 32767));
+    }
+    return out;
+}
+
+double meanSquare(const std::vector<float>& values) {
+    std::vector<float> squares(values.size());
+    for (size_t i = 0; i < values.size(); i++) {
+        squares[i] = values[i] * values[i];
+    }
+    double sum = 0.0;
+    for (float value : squares) {
+        sum += value;
+    }
+    return sum / squares.size();
+}
+
+std::vector<float> noiseReduction(const std::vector<float>& samples) {
+    const size_t estimate = std::min<size_t>(1600, samples.size() / 10);
+    const float floor = estimate > 0
+        ? std::sqrt(static_cast<float>(meanSquare(std::vector<float>(samples.begin(), samples.begin() + estimate))))
+        : 0.01f;
+    const float threshold = floor * 2.5f;
+    std::vector<float> out(samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        const float sample = samples[i];
+        const float magnitude = std::fabs(sample);
+        if (magnitude < threshold * 0.5f) {
+            out[i] = 0.0f;
+        } else if (magnitude < threshold) {
+            out[i] = sample * ((magnitude - threshold * 0.5f) / (threshold * 0.5f));
+        } else {
+            out[i] = sample;
+        }
+    }
+    return out;
+}
+
+std::vector<float> gainControl(const std::vector<float>& samples) {
+    const size_t windowSize = 4096;
+    std::vector<float> result = samples;
+    for (size_t i = 0; i < samples.size(); i += windowSize / 2) {
+        const size_t windowEnd = std::min(i + windowSize, samples.size());
+        const std::vector<float> window(samples.begin() + i, samples.begin() + windowEnd);
+        const float rms = std::sqrt(static_cast<float>(meanSquare(window)));
+        if (rms > 0.001f) {
+            const float gain = std::min(std::max(0.1f / rms, 0.3f), 3.0f);
+            for (size_t j = i; j < windowEnd; j++) {
+                const float fadeIn = j - i < 100 ? (j - i) / 100.0f : 1.0f;
+                const float fadeOut = windowEnd - j < 100 ? (windowEnd - j) / 100.0f : 1.0f;
+                const float smoothGain = gain * std::min(fadeIn, fadeOut);
+                result[j] = std::min(std::max(result[j] * smoothGain, -1.0f), 1.0f);
+            }
+        }
+    }
+    return result;
+}
+
+std::vector<float> echoCancellation(const std::vector<float>& samples) {
+    if (samples.size() < 100) {
+        return samples;
+    }
+    std::vector<float> result = samples;
+    for (size_t i = 80; i < samples.size(); i++) {
+        result[i] = std::min(std::max(samples[i] - samples[i - 80] * 0.3f, -1.0f), 1.0f);
+    }
+    return result;
+}
+
+std::vector<float> process(const std::vector<float>& samples) {
+    return echoCancellation(gainControl(noiseReduction(samples)));
+}
+
+} // namespace kotlin
+
+std::vector<float> speechLike(size_t samples, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<float> audio(samples);
+    double phase = 0.0;
+    for (size_t i = 0; i < samples; i++) {
+        const double t = static_cast<double>(i) / kRate;
+        const double f0 = 140.0 + 30.0 * std::sin(2.0 * M_PI * 0.7 * t);
+        phase += 2.0 * M_PI * f0 / kRate;
+        const double syllable = std::max(0.0, std::sin(2.0 * M_PI * 3.0 * t));
+        double voiced = 0.0;
+        for (int k = 1; k <= 20; k++) {
+            voiced += std::sin(k * phase) / k;
+        }
+        audio[i] = static_cast<float>(0.05 * syllable * voiced + 0.003 * noise(rng));
+    }
+    return audio;
+}
+
+std::vector<float> tone(double hz, int rate, size_t samples) {
+    std::vector<float> out(samples);
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = static_cast<float>(0.5 * std::sin(2.0 * M_PI * hz * i / rate));
+    }
+    return out;
+}
+
+double decibels(double ratio) {
+    return 20.0 * std::log10(std::max(ratio, 1e-12));
+}
+
+struct ToneFit {
+    double gainDb;     // fitted amplitude against the input's 0.5
+    double residualDb; // RMS of what is left, against the fitted tone's RMS
+};
+
+// Least-squares fit of a tone at `hz` to the output, skipping the filter's start-up
+ToneFit fitTone(const std::vector<float>& y, double hz, int rate) {
+    const size_t skip = static_cast<size_t>(rate) / 10;
+    double ss = 0.0, sc = 0.0, cc = 0.0, ys = 0.0, yc = 0.0;
+    for (size_t i = skip; i < y.size(); i++) {
+        const double s = std::sin(2.0 * M_PI * hz * i / rate);
+        const double c = std::cos(2.0 * M_PI * hz * i / rate);
+        ss += s * s;
+        sc += s * c;
+        cc += c * c;
+        ys += y[i] * s;
+        yc += y[i] * c;
+    }
+    const double det = ss * cc - sc * sc;
+    const double a = (ys * cc - yc * sc) / det;
+    const double b = (yc * ss - ys * sc) / det;
+    double residual = 0.0;
+    for (size_t i = skip; i < y.size(); i++) {
+        const double fitted = a * std::sin(2.0 * M_PI * hz * i / rate) + b * std::cos(2.0 * M_PI * hz * i / rate);
+        residual += (y[i] - fitted) * (y[i] - fitted);
+    }
+    const double amplitude = std::sqrt(a * a + b * b);
+    const double residualRms = std::sqrt(residual / (y.size() - skip));
+    return {decibels(amplitude / 0.5), decibels(residualRms / (amplitude / std::sqrt(2.0)))};
+}
+
+// Resample in 10 ms chunks, the way capture feeds it
+std::vector<float> resample(PolyphaseResampler& resampler, const std::vector<float>& in) {
+    const size_t chunk = static_cast<size_t>(resampler.inputRate()) / 100;
+    std::vector<float> out;
+    std::vector<float> buffer(resampler.maxOutput(chunk));
+    for (size_t at = 0; at < in.size(); at += chunk) {
+        const size_t count = std::min(chunk, in.size() - at);
+        const size_t written = resampler.process(in.data() + at, count, buffer.data());
+        out.insert(out.end(), buffer.begin(), buffer.begin() + written);
+    }
+    return out;
+}
+
+double rms(const std::vector<float>& x, size_t skip) {
+    double sum = 0.0;
+    for (size_t i = skip; i < x.size(); i++) {
+        sum += static_cast<double>(x[i]) * x[i];
+    }
+    return std::sqrt(sum / std::max<size_t>(1, x.size() - skip));
+}
+
+float maxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t chunk = static_cast<size_t>(bench::argOr(argc, argv, 1, 3840));
+    const size_t seconds = static_cast<size_t>(bench::argOr(argc, argv, 2, 60));
+    std::printf("Audio DSP benchmark: %s kernels, one thread\n\n", kernels::backendName());
+
+    // Resampler quality and speed for the rate pairs capture and playback use
+    std::printf("%-14s %6s %10s %12s %10s %12s %12s %10s\n", "rates", "taps", "1k gain", "1k residual",
+                "edge gain", "edge resid.", "stopband", "x realtime");
+    const int pairs[][2] = {{48000, 16000}, {44100, 16000}, {22050, 48000}, {16000, 48000}, {22050, 44100}};
+    for (const auto& pair : pairs) {
+        const int in = pair[0];
+        const int out = pair[1];
+        const double nyquist = std::min(in, out) / 2.0;
+        const size_t samples = static_cast<size_t>(in) * 2;
+
+        PolyphaseResampler resampler(in, out);
+        const ToneFit low = fitTone(resample(resampler, tone(1000.0, in, samples)), 1000.0, out);
+        resampler.reset();
+        const ToneFit edge = fitTone(resample(resampler, tone(0.8 * nyquist, in, samples)), 0.8 * nyquist, out);
+
+        // A tone between the output and input Nyquist frequencies must not alias back in
+        char stopband[16] = "-";
+        if (in > out) {
+            resampler.reset();
+            const double hz = std::min(1.15 * nyquist, 0.95 * in / 2.0);
+            const std::vector<float> aliased = resample(resampler, tone(hz, in, samples));
+            std::snprintf(stopband, sizeof(stopband), "%.1f dB", decibels(rms(aliased, out / 10) / (0.5 / std::sqrt(2.0))));
+        }
+
+        const std::vector<float> audio = speechLike(static_cast<size_t>(in) * 10, 4);
+        resampler.reset();
+        bench::Timer timer;
+        resample(resampler, audio);
+        const double realtime = 10000.0 / timer.elapsedMs();
+
+        char rates[32];
+        std::snprintf(rates, sizeof(rates), "%d>%d", in, out);
+        std::printf("%-14s %6zu %7.3f dB %9.1f dB %7.3f dB %9.1f dB %12s %10.0f\n", rates, resampler.taps(), low.gainDb,
+                    low.residualDb, edge.gainDb, edge.residualDb, stopband, realtime);
+    }
+
+    // PCM16 conversion and the capture chain on `seconds` of 16 kHz audio in capture-sized chunks
+    const std::vector<float> audio = speechLike(seconds * kRate, 5);
+    std::vector<int16_t> pcm(audio.size());
+    for (size_t i = 0; i < audio.size(); i++) {
+        pcm[i] = static_cast<int16_t>(std::lrint(audio[i] * 32767.0f));
+    }
+    std::printf("\n%zu-sample chunks, per second of audio:\n", chunk);
+    std::printf("%-24s %12s %12s %12s %9s\n", "step", "kotlin us", "native us", "scalar us", "speedup");
+
+    auto report = [&](const char* name, double kotlinMs, double nativeMs, double scalarMs) {
+        std::printf("%-24s %12.1f %12.1f %12.1f %8.1fx\n", name, kotlinMs * 1000.0 / seconds,
+                    nativeMs * 1000.0 / seconds, scalarMs * 1000.0 / seconds, kotlinMs / nativeMs);
+    };
+
+    {
+        double kotlinMs = 0.0;
+        {
+            bench::Timer timer;
+            for (size_t at = 0; at + chunk <= pcm.size(); at += chunk) {
+                const std::vector<int16_t> buffer(pcm.begin() + at, pcm.begin() + at + chunk);
+                volatile float sink = kotlin::toFloat(buffer)[0];
+                (void)sink;
+            }
+            kotlinMs = timer.elapsedMs();
+        }
+        double nativeMs[2];
+        std::vector<float> out(chunk);
+        for (int scalar = 0; scalar < 2; scalar++) {
+            kernels::useScalarKernels(scalar == 1);
+            bench::Timer timer;
+            for (size_t at = 0; at + chunk <= pcm.size(); at += chunk) {
+                kernels::int16ToFloat(pcm.data() + at, out.data(), chunk);
+            }
+            nativeMs[scalar] = timer.elapsedMs();
+        }
+        kernels::useScalarKernels(false);
+        report("pcm16 -> float", kotlinMs, nativeMs[0], nativeMs[1]);
+    }
+
+    {
+        double kotlinMs = 0.0;
+        {
+            bench::Timer timer;
+            for (size_t at = 0; at + chunk <= audio.size(); at += chunk) {
+                const std::vector<float> buffer(audio.begin() + at, audio.begin() + at + chunk);
+                volatile int16_t sink = kotlin::toShort(buffer)[0];
+                (void)sink;
+            }
+            kotlinMs = timer.elapsedMs();
+        }
+        double nativeMs[2];
+        std::vector<int16_t> out(chunk);
+        kernels::DitherState dither;
+        for (int scalar = 0; scalar < 2; scalar++) {
+            kernels::useScalarKernels(scalar == 1);
+            bench::Timer timer;
+            for (size_t at = 0; at + chunk <= audio.size(); at += chunk) {
+                kernels::floatToInt16(audio.data() + at, out.data(), chunk, 1.0f, dither);
+            }
+            nativeMs[scalar] = timer.elapsedMs();
+        }
+        kernels::useScalarKernels(false);
+        report("float -> pcm16, dither", kotlinMs, nativeMs[0], nativeMs[1]);
+    }
+
+    {
+        double kotlinMs = 0.0;
+        std::vector<float> expected;
+        {
+            bench::Timer timer;
+            for (size_t at = 0; at + chunk <= audio.size(); at += chunk) {
+                const std::vector<float> buffer(audio.begin() + at, audio.begin() + at + chunk);
+                const std::vector<float> processed = kotlin::process(buffer);
+                expected.insert(expected.end(), processed.begin(), processed.end());
+            }
+            kotlinMs = timer.elapsedMs();
+        }
+        double nativeMs[2];
+        float worst[2];
+        CaptureProcessor processor;
+        for (int scalar = 0; scalar < 2; scalar++) {
+            kernels::useScalarKernels(scalar == 1);
+            std::vector<float> actual(audio.begin(), audio.begin() + expected.size());
+            bench::Timer timer;
+            for (size_t at = 0; at + chunk <= actual.size(); at += chunk) {
+                processor.process(actual.data() + at, chunk, CaptureProcessor::Steps());
+            }
+            nativeMs[scalar] = timer.elapsedMs();
+            worst[scalar] = maxDifference(expected, actual);
+        }
+        kernels::useScalarKernels(false);
+        report("gate + AGC + echo", kotlinMs, nativeMs[0], nativeMs[1]);
+        std::printf("\nCapture chain vs Kotlin: max |difference| %.1e (%s), %.1e (scalar)\n", worst[0],
+                    kernels::backendName(), worst[1]);
+    }
+    return 0;
+}
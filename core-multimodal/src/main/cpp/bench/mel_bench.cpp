@@ -0,0 +1,332 @@
+/**
+ * LogMelSpectrogram against whisper.cpp's own log-mel front end.
+ *
+ * The reference below is whisper.cpp's log_mel_spectrogram (v1.5.x) on one
+ * thread. It pads 30 s of zeros (skipping FFTs on all-zero frames), uses a
+ * recursive radix-2 FFT that drops to a table-driven DFT at the odd length 25
+ * and allocates at every level, and applies a dense filterbank multiply with
+ * double accumulation. It is given the same filters as LogMelSpectrogram, so
+ * the outputs should match to float rounding.
+ *
+ * Reported:
+ *   - the largest difference between the two encoder inputs;
+ *   - the cost of one whole window, for the reference and for
+ *     LogMelSpectrogram with the selected and the portable kernels;
+ *   - a streaming session shaped like StreamingTranscriber (100 ms chunks, a
+ *     decode every 400 ms, the window trimmed from 4 s back to 2 s). The
+ *     reference recomputes the whole window for each decode; the incremental
+ *     front end computes frames as chunks arrive and recomputes only the end
+ *     of the window for a decode. The incremental input is checked against a
+ *     cold computation of the same window.
+ *
+ * Usage: mel_bench [sessionSeconds=30] [melBands=80]
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../audio_kernels.h"
+#include "../log_mel.h"
+#include "bench_common.h"
+
+using iris::multimodal::LogMelSpectrogram;
+namespace bench = iris::bench;
+namespace kernels = iris::multimodal::kernels;
+
+namespace {
+
+constexpr size_t kRate = LogMelSpectrogram::kSampleRate;
+constexpr size_t kFft = LogMelSpectrogram::kFftSize;
+constexpr size_t kHop = LogMelSpectrogram::kHop;
+constexpr size_t kBins = kFft / 2 + 1;
+
+// ============================================================================
+// whisper.cpp reference (MIT licence), single-threaded
+// ============================================================================
+
+namespace reference {
+
+struct Tables {
+    float sinVals[kFft];
+    float cosVals[kFft];
+    float hann[kFft];
+
+    Tables() {
+        for (size_t i = 0; i < kFft; i++) {
+            const double theta = (2 * M_PI * i) / kFft;
+            sinVals[i] = static_cast<float>(std::sin(theta));
+            cosVals[i] = static_cast<float>(std::cos(theta));
+            hann[i] = static_cast<float>(0.5 * (1.0 - std::cos((2.0 * M_PI * i) / kFft)));
+        }
+    }
+};
+
+const Tables& tables() {
+    static const Tables instance;
+    return instance;
+}
+
+void dft(const std::vector<float>& in, std::vector<float>& out) {
+    const int n = static_cast<int>(in.size());
+    out.resize(n * 2);
+    const int step = static_cast<int>(kFft) / n;
+    for (int k = 0; k < n; k++) {
+        float re = 0;
+        float im = 0;
+        for (int t = 0; t < n; t++) {
+            const int idx = (k * t * step) % static_cast<int>(kFft);
+            re += in[t] * tables().cosVals[idx];
+            im -= in[t] * tables().sinVals[idx];
+        }
+        out[k * 2 + 0] = re;
+        out[k * 2 + 1] = im;
+    }
+}
+
+void fft(const std::vector<float>& in, std::vector<float>& out) {
+    out.resize(in.size() * 2);
+    const int n = static_cast<int>(in.size());
+    if (n == 1) {
+        out[0] = in[0];
+        out[1] = 0;
+        return;
+    }
+    if (n % 2 == 1) {
+        dft(in, out);
+        return;
+    }
+    std::vector<float> even;
+    std::vector<float> odd;
+    even.reserve(n / 2);
+    odd.reserve(n / 2);
+    for (int i = 0; i < n; i++) {
+        (i % 2 == 0 ? even : odd).push_back(in[i]);
+    }
+    std::vector<float> evenFft;
+    std::vector<float> oddFft;
+    fft(even, evenFft);
+    fft(odd, oddFft);
+    const int step = static_cast<int>(kFft) / n;
+    for (int k = 0; k < n / 2; k++) {
+        const int idx = k * step;
+        const float re = tables().cosVals[idx];
+        const float im = -tables().sinVals[idx];
+        const float reOdd = oddFft[2 * k + 0];
+        const float imOdd = oddFft[2 * k + 1];
+        out[2 * k + 0] = evenFft[2 * k + 0] + re * reOdd - im * imOdd;
+        out[2 * k + 1] = evenFft[2 * k + 1] + re * imOdd + im * reOdd;
+        out[2 * (k + n / 2) + 0] = evenFft[2 * k + 0] - re * reOdd + im * imOdd;
+        out[2 * (k + n / 2) + 1] = evenFft[2 * k + 1] - re * imOdd - im * reOdd;
+    }
+}
+
+/**
+ * whisper's normalised mel, mel-major with n_len columns; returns n_len
+ */
+size_t logMel(const float* samples, size_t count, const std::vector<float>& filters, size_t bands,
+              std::vector<float>& mel) {
+    const size_t stage1 = kRate * 30;
+    const size_t stage2 = kFft / 2;
+    std::vector<float> padded(count + stage1 + stage2 * 2, 0.0f);
+    std::copy(samples, samples + count, padded.begin() + stage2);
+    std::reverse_copy(samples + 1, samples + 1 + stage2, padded.begin());
+
+    const size_t nLen = (padded.size() - kFft) / kHop;
+    mel.assign(bands * nLen, 0.0f);
+
+    std::vector<float> fftIn(kFft);
+    std::vector<float> fftOut(2 * kFft);
+    const size_t nSamples = count + stage2;
+    size_t i = 0;
+    // FFT only where the frame is not all zeros
+    for (; i < std::min(nSamples / kHop + 1, nLen); i++) {
+        const size_t offset = i * kHop;
+        for (size_t j = 0; j < std::min(kFft, padded.size() - offset); j++) {
+            fftIn[j] = tables().hann[j] * padded[offset + j];
+        }
+        fft(fftIn, fftOut);
+        for (size_t j = 0; j < kBins; j++) {
+            fftOut[j] = fftOut[2 * j + 0] * fftOut[2 * j + 0] + fftOut[2 * j + 1] * fftOut[2 * j + 1];
+        }
+        for (size_t j = 0; j < bands; j++) {
+            double sum = 0.0;
+            size_t k = 0;
+            for (k = 0; k + 3 < kBins; k += 4) {
+                sum += fftOut[k + 0] * filters[j * kBins + k + 0] + fftOut[k + 1] * filters[j * kBins + k + 1] +
+                       fftOut[k + 2] * filters[j * kBins + k + 2] + fftOut[k + 3] * filters[j * kBins + k + 3];
+            }
+            for (; k < kBins; k++) {
+                sum += fftOut[k] * filters[j * kBins + k];
+            }
+            mel[j * nLen + i] = static_cast<float>(std::log10(std::max(sum, 1e-10)));
+        }
+    }
+    for (; i < nLen; i++) {
+        for (size_t j = 0; j < bands; j++) {
+            mel[j * nLen + i] = static_cast<float>(std::log10(1e-10));
+        }
+    }
+
+    double mmax = -1e20;
+    for (float value : mel) {
+        mmax = std::max(mmax, static_cast<double>(value));
+    }
+    mmax -= 8.0;
+    for (float& value : mel) {
+        if (value < mmax) {
+            value = static_cast<float>(mmax);
+        }
+        value = static_cast<float>((value + 4.0) / 4.0);
+    }
+    return nLen;
+}
+
+} // namespace reference
+
+// ============================================================================
+
+std::vector<float> speechLike(size_t samples, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+    std::vector<float> audio(samples);
+    double phase = 0.0;
+    for (size_t i = 0; i < samples; i++) {
+        const double t = static_cast<double>(i) / kRate;
+        const double f0 = 140.0 + 30.0 * std::sin(2.0 * M_PI * 0.7 * t);
+        phase += 2.0 * M_PI * f0 / kRate;
+        const double syllable = std::max(0.0, std::sin(2.0 * M_PI * 3.0 * t));
+        double voiced = 0.0;
+        for (int k = 1; k <= 20; k++) {
+            voiced += std::sin(k * phase) / k;
+        }
+        audio[i] = static_cast<float>(0.1 * syllable * voiced + 0.003 * noise(rng));
+    }
+    return audio;
+}
+
+float maxDifference(const std::vector<float>& a, const std::vector<float>& b) {
+    float worst = 0.0f;
+    for (size_t i = 0; i < a.size() && i < b.size(); i++) {
+        worst = std::max(worst, std::fabs(a[i] - b[i]));
+    }
+    return worst;
+}
+
+// Encoder input width the stream uses: the window's positions plus a margin, doubled, as padding
+size_t columnsFor(size_t samples) {
+    const size_t positions = (samples + 2 * kHop - 1) / (2 * kHop) + 32;
+    return samples / kHop + 2 * std::min<size_t>(positions, 1500);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const double sessionSeconds = static_cast<double>(bench::argOr(argc, argv, 1, 30));
+    const size_t bands = static_cast<size_t>(bench::argOr(argc, argv, 2, 80));
+    LogMelSpectrogram mel(bands);
+    const std::vector<float> filters = mel.denseFilters();
+    std::printf("Log-mel benchmark: %s kernels, %zu bands, one thread\n\n", kernels::backendName(), bands);
+
+    // Accuracy: the full whisper input for 10 s of audio
+    {
+        const std::vector<float> audio = speechLike(10 * kRate, 1);
+        std::vector<float> expected;
+        const size_t nLen = reference::logMel(audio.data(), audio.size(), filters, bands, expected);
+        std::vector<float> actual;
+        mel.reset();
+        const size_t frames = mel.whisperInput(audio.data(), audio.size(), nLen, actual);
+        std::printf("10 s, %zu columns: max |difference| %.2e (normalised units), %zu audio frames\n\n", nLen,
+                    maxDifference(expected, actual), frames);
+    }
+
+    std::printf("%-8s %14s %14s %14s %9s\n", "window", "whisper ms", "native ms", "scalar ms", "speedup");
+    for (double seconds : {1.0, 4.0, 10.0, 30.0}) {
+        const std::vector<float> audio = speechLike(static_cast<size_t>(seconds * kRate), 2);
+        const int repeats = seconds < 5.0 ? 20 : 5;
+        std::vector<float> out;
+
+        bench::Timer referenceTimer;
+        for (int r = 0; r < repeats; r++) {
+            reference::logMel(audio.data(), audio.size(), filters, bands, out);
+        }
+        const double referenceMs = referenceTimer.elapsedMs() / repeats;
+
+        double nativeMs[2];
+        for (int scalar = 0; scalar < 2; scalar++) {
+            kernels::useScalarKernels(scalar == 1);
+            bench::Timer timer;
+            for (int r = 0; r < repeats; r++) {
+                mel.reset();
+                mel.whisperInput(audio.data(), audio.size(), columnsFor(audio.size()), out);
+            }
+            nativeMs[scalar] = timer.elapsedMs() / repeats;
+        }
+        kernels::useScalarKernels(false);
+        std::printf("%-6.0f s %14.2f %14.2f %14.2f %8.1fx\n", seconds, referenceMs, nativeMs[0], nativeMs[1],
+                    referenceMs / nativeMs[0]);
+    }
+
+    // Streaming: 100 ms chunks, a decode every 400 ms, trim from 4 s to 2 s
+    {
+        const std::vector<float> audio = speechLike(static_cast<size_t>(sessionSeconds * kRate), 3);
+        const size_t chunk = kRate / 10;
+        const size_t step = kRate * 4 / 10;
+        std::vector<float> window;
+        std::vector<float> incremental;
+        std::vector<float> cold;
+        std::vector<float> referenceOut;
+        LogMelSpectrogram check(bands);
+        mel.reset();
+        const uint64_t framesBefore = mel.framesComputed();
+
+        double referenceMs = 0.0;
+        double incrementalMs = 0.0;
+        float worst = 0.0f;
+        size_t decodes = 0;
+        size_t sinceDecode = 0;
+        size_t windowSamples = 0;
+        for (size_t at = 0; at + chunk <= audio.size(); at += chunk) {
+            window.insert(window.end(), audio.begin() + at, audio.begin() + at + chunk);
+            bench::Timer pushTimer;
+            mel.update(window.data(), window.size());
+            incrementalMs += pushTimer.elapsedMs();
+            sinceDecode += chunk;
+            if (sinceDecode < step) {
+                continue;
+            }
+            sinceDecode = 0;
+            decodes++;
+            windowSamples += window.size();
+
+            bench::Timer decodeTimer;
+            mel.whisperInput(window.data(), window.size(), columnsFor(window.size()), incremental);
+            incrementalMs += decodeTimer.elapsedMs();
+
+            bench::Timer referenceTimer;
+            reference::logMel(window.data(), window.size(), filters, bands, referenceOut);
+            referenceMs += referenceTimer.elapsedMs();
+
+            check.reset();
+            check.whisperInput(window.data(), window.size(), columnsFor(window.size()), cold);
+            worst = std::max(worst, maxDifference(incremental, cold));
+
+            if (window.size() > 4 * kRate) {
+                const size_t drop = window.size() - 2 * kRate; // trims are whole 10 ms ticks
+                window.erase(window.begin(), window.begin() + drop);
+                mel.discard(drop);
+            }
+        }
+        const uint64_t frames = mel.framesComputed() - framesBefore;
+        std::printf("\nStreaming %.0f s: %zu decodes, mean window %.1f s\n", sessionSeconds, decodes,
+                    static_cast<double>(windowSamples) / decodes / kRate);
+        std::printf("  whisper     %8.3f ms per decode (whole window + padding each time)\n", referenceMs / decodes);
+        std::printf("  incremental %8.3f ms per decode, chunk updates included (%.1f frames FFT'd per decode,"
+                    " %.1f new)\n",
+                    incrementalMs / decodes, static_cast<double>(frames) / decodes,
+                    static_cast<double>(step) / kHop);
+        std::printf("  incremental vs cold input: max |difference| %.1e\n", worst);
+    }
+    return 0;
+}
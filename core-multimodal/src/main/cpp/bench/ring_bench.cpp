@@ -0,0 +1,212 @@
+/**
+ * AudioRing between two threads against the pooled-array hand-off it replaces.
+ *
+ * The baseline is AudioBufferPool's shape: arrays recycled through a locked
+ * queue and zero-filled on acquire and on release, filled-array references
+ * handed to the consumer through a second locked queue, and one array copy
+ * per chunk for the trip across JNI. The ring moves the same audio with
+ * its regions: the producer writes in place and the consumer reads in place.
+ *
+ * Both sides carry a running sample counter, which the consumer checks, so
+ * any lost, repeated or torn sample is counted as an error. A small ring with
+ * a slow consumer checks that overruns are counted and nothing else breaks.
+ *
+ * Usage: ring_bench [seconds=600] [chunkFrames=1600]
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../audio_ring.h"
+#include "bench_common.h"
+
+using iris::multimodal::AudioRing;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr size_t kRate = 48000;
+
+struct Result {
+    double ms;
+    uint64_t errors;
+};
+
+// AudioBufferPool plus a queue of filled buffers, with a JNI-style copy per chunk
+class PooledHandoff {
+public:
+    explicit PooledHandoff(size_t chunk) : chunk_(chunk) {}
+
+    std::vector<int16_t> acquire() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pool_.empty()) {
+            return std::vector<int16_t>(chunk_);
+        }
+        std::vector<int16_t> buffer = std::move(pool_.front());
+        pool_.pop_front();
+        std::fill(buffer.begin(), buffer.end(), 0);
+        return buffer;
+    }
+
+    void release(std::vector<int16_t> buffer) {
+        std::fill(buffer.begin(), buffer.end(), 0);
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pool_.size() < 10) {
+            pool_.push_back(std::move(buffer));
+        }
+    }
+
+    void send(std::vector<int16_t> buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        filled_.push_back(std::move(buffer));
+    }
+
+    bool receive(std::vector<int16_t>& buffer) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (filled_.empty()) {
+            return false;
+        }
+        buffer = std::move(filled_.front());
+        filled_.pop_front();
+        return true;
+    }
+
+private:
+    const size_t chunk_;
+    std::mutex mutex_;
+    std::deque<std::vector<int16_t>> pool_;
+    std::deque<std::vector<int16_t>> filled_;
+};
+
+Result runPooled(size_t total, size_t chunk) {
+    PooledHandoff handoff(chunk);
+    std::atomic<uint64_t> errors{0};
+    bench::Timer timer;
+    std::thread producer([&] {
+        uint16_t next = 0;
+        for (size_t sent = 0; sent < total; sent += chunk) {
+            std::vector<int16_t> buffer = handoff.acquire();
+            for (size_t i = 0; i < chunk; i++) {
+                buffer[i] = static_cast<int16_t>(next++);
+            }
+            handoff.send(std::move(buffer));
+        }
+    });
+    std::thread consumer([&] {
+        uint16_t expected = 0;
+        std::vector<int16_t> buffer;
+        std::vector<int16_t> copied(chunk); // the array copy into native memory
+        uint64_t bad = 0;
+        for (size_t received = 0; received < total;) {
+            if (!handoff.receive(buffer)) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::copy(buffer.begin(), buffer.end(), copied.begin());
+            for (int16_t sample : copied) {
+                bad += static_cast<uint16_t>(sample) != expected++;
+            }
+            received += chunk;
+            handoff.release(std::move(buffer));
+        }
+        errors = bad;
+    });
+    producer.join();
+    consumer.join();
+    return {timer.elapsedMs(), errors.load()};
+}
+
+Result runRing(size_t total, size_t chunk, size_t capacity) {
+    AudioRing ring(capacity, sizeof(int16_t));
+    std::atomic<uint64_t> errors{0};
+    bench::Timer timer;
+    std::thread producer([&] {
+        uint16_t next = 0;
+        for (size_t sent = 0; sent < total;) {
+            const AudioRing::Region region = ring.writable(std::min(chunk, total - sent));
+            if (region.frames == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            int16_t* out = ring.frames<int16_t>() + region.offset;
+            for (size_t i = 0; i < region.frames; i++) {
+                out[i] = static_cast<int16_t>(next++);
+            }
+            ring.commitWrite(region.frames);
+            sent += region.frames;
+        }
+    });
+    std::thread consumer([&] {
+        uint16_t expected = 0;
+        uint64_t bad = 0;
+        for (size_t received = 0; received < total;) {
+            const AudioRing::Region region = ring.readable(chunk);
+            if (region.frames == 0) {
+                std::this_thread::yield();
+                continue;
+            }
+            const int16_t* in = ring.frames<int16_t>() + region.offset;
+            for (size_t i = 0; i < region.frames; i++) {
+                bad += static_cast<uint16_t>(in[i]) != expected++;
+            }
+            ring.commitRead(region.frames);
+            received += region.frames;
+        }
+        errors = bad;
+    });
+    producer.join();
+    consumer.join();
+    return {timer.elapsedMs(), errors.load()};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t seconds = static_cast<size_t>(bench::argOr(argc, argv, 1, 600));
+    const size_t chunk = static_cast<size_t>(bench::argOr(argc, argv, 2, 1600));
+    const size_t total = seconds * kRate / chunk * chunk;
+    std::printf("Audio ring benchmark: %zu s of 48 kHz PCM16 in %zu-frame chunks, two threads\n\n", seconds, chunk);
+
+    const Result pooled = runPooled(total, chunk);
+    const Result ring = runRing(total, chunk, 4 * kRate);
+    std::printf("%-28s %10s %14s %8s\n", "hand-off", "ms", "ns per frame", "errors");
+    std::printf("%-28s %10.1f %14.2f %8llu\n", "pooled arrays + copy", pooled.ms, pooled.ms * 1e6 / total,
+                static_cast<unsigned long long>(pooled.errors));
+    std::printf("%-28s %10.1f %14.2f %8llu\n", "ring, in place", ring.ms, ring.ms * 1e6 / total,
+                static_cast<unsigned long long>(ring.errors));
+    std::printf("speedup %.1fx\n", pooled.ms / ring.ms);
+
+    // Regions straddling the wrap: odd chunk sizes against a small ring
+    const Result wrapped = runRing(total / 10, 1237, 4096);
+    std::printf("\n1237-frame regions, 4096-frame ring: %llu errors\n",
+                static_cast<unsigned long long>(wrapped.errors));
+
+    // Overrun accounting: a producer that drops what does not fit, a consumer that stalls
+    {
+        AudioRing small(8192, sizeof(int16_t));
+        std::vector<int16_t> block(chunk, 1);
+        std::vector<int16_t> sink(chunk);
+        size_t written = 0;
+        size_t offered = 0;
+        for (int i = 0; i < 100; i++) {
+            written += small.write(block.data(), block.size());
+            offered += block.size();
+            if (i % 4 == 0) {
+                small.read(sink.data(), sink.size());
+            }
+        }
+        const bool consistent = small.overrunFrames() == offered - written &&
+                                small.framesWritten() - small.framesRead() == small.available();
+        std::printf("Slow consumer: %zu of %zu frames dropped as overrun, counters %s\n",
+                    static_cast<size_t>(small.overrunFrames()), offered, consistent ? "consistent" : "WRONG");
+        while (small.read(sink.data(), sink.size()) == sink.size()) {
+        }
+        std::printf("Drained with %llu underrun(s) at the end\n",
+                    static_cast<unsigned long long>(small.underruns()));
+    }
+    return 0;
+}
@@ -0,0 +1,382 @@
+/**
+ * What VoiceActivityDetector saves the recognizer, and what it costs.
+ *
+ * A synthetic session is generated per background: utterances of voiced and
+ * unvoiced syllables (harmonics under two formants, high-passed noise) with
+ * pauses in between, over quiet, fan-like (steady low-pass) and street-like
+ * (level-modulated, with clicks) noise. Samples are labelled speech from an
+ * utterance's first syllable to its last.
+ *
+ * For each background it reports how much labelled speech is forwarded, how
+ * many utterance onsets lose their first 50 ms, and how much non-speech leaks
+ * through. It also estimates the whisper decodes a streaming transcriber with
+ * a 400 ms step would run on the gated audio against the whole recording,
+ * and the encoder audio-seconds of those decodes. The encoder dominates STT
+ * energy, so the saved share of encoder work is the battery estimate.
+ * Detector cost is given as microseconds per second of audio, with the
+ * selected kernels, the portable ones, and a port of the Kotlin performVAD it
+ * replaces. That port runs on 100 ms chunks and its speech chunks are scored
+ * the same way; its fixed -20 dBFS gate sits above conversational levels
+ * (-28 to -16 dBFS here), so it forwards nothing at all.
+ *
+ * Usage: vad_bench [sessionSeconds=300] [file.wav ...]
+ * WAV files (16 kHz, 16-bit) are reported without labels.
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../audio_kernels.h"
+#include "../voice_activity_detector.h"
+#include "bench_common.h"
+
+using iris::multimodal::VadOutput;
+using iris::multimodal::VoiceActivityDetector;
+namespace bench = iris::bench;
+namespace kernels = iris::multimodal::kernels;
+
+namespace {
+
+constexpr int kRate = 16000;
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kStepSamples = kRate * 400 / 1000; // StreamOptions::stepMs
+constexpr size_t kTrimSamples = kRate * 4;          // StreamOptions::trimMs
+
+enum class Background { kQuiet, kFan, kStreet };
+
+const char* name(Background background) {
+    switch (background) {
+    case Background::kQuiet:
+        return "quiet";
+    case Background::kFan:
+        return "fan";
+    default:
+        return "street";
+    }
+}
+
+struct Session {
+    std::vector<float> audio;
+    std::vector<uint8_t> speech;
+    std::vector<size_t> onsets;
+};
+
+class SessionGenerator {
+public:
+    explicit SessionGenerator(uint64_t seed) : rng_(seed) {}
+
+    Session generate(double seconds, Background background) {
+        Session session;
+        const size_t total = static_cast<size_t>(seconds * kRate);
+        session.audio.reserve(total + kRate * 8);
+        while (session.audio.size() < total) {
+            pause(session, uniform(1.0, 6.0));
+            utterance(session);
+        }
+        pause(session, 1.0);
+        addBackground(session.audio, background);
+        return session;
+    }
+
+private:
+    std::mt19937_64 rng_;
+    std::normal_distribution<float> normal_{0.0f, 1.0f};
+
+    double uniform(double low, double high) { return std::uniform_real_distribution<double>(low, high)(rng_); }
+
+    void pause(Session& session, double seconds) {
+        const size_t count = static_cast<size_t>(seconds * kRate);
+        session.audio.insert(session.audio.end(), count, 0.0f);
+        session.speech.insert(session.speech.end(), count, 0);
+    }
+
+    void utterance(Session& session) {
+        session.onsets.push_back(session.audio.size());
+        const float gain = static_cast<float>(std::pow(10.0, uniform(-28.0, -16.0) / 20.0));
+        const double f0 = uniform(95.0, 230.0);
+        const int words = 3 + static_cast<int>(rng_() % 12);
+        for (int w = 0; w < words; w++) {
+            const int syllables = 1 + static_cast<int>(rng_() % 3);
+            for (int s = 0; s < syllables; s++) {
+                if (rng_() % 3 == 0) {
+                    unvoiced(session, uniform(0.04, 0.09), gain * 0.5f);
+                }
+                voiced(session, uniform(0.09, 0.22), f0 * uniform(0.85, 1.2), gain);
+            }
+            if (w + 1 < words) {
+                const size_t gap = static_cast<size_t>(uniform(0.05, 0.2) * kRate);
+                session.audio.insert(session.audio.end(), gap, 0.0f);
+                session.speech.insert(session.speech.end(), gap, 1);
+            }
+        }
+    }
+
+    void voiced(Session& session, double seconds, double f0, float gain) {
+        const size_t count = static_cast<size_t>(seconds * kRate);
+        const double f1 = uniform(300.0, 850.0);
+        const double f2 = uniform(900.0, 2400.0);
+        std::vector<double> weights;
+        double power = 0.0;
+        for (int k = 1; k * f0 < 4000.0; k++) {
+            const double f = k * f0;
+            weights.push_back(std::exp(-std::pow((f - f1) / 200.0, 2)) +
+                              0.6 * std::exp(-std::pow((f - f2) / 300.0, 2)) + 0.05);
+            power += weights.back() * weights.back() / 2.0;
+        }
+        // Unit RMS before the envelope, so the nucleus peaks near the utterance gain
+        for (double& weight : weights) {
+            weight /= std::sqrt(power);
+        }
+        double phase = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            const double envelope = std::sin(kPi * (i + 0.5) / count);
+            phase += 2.0 * kPi * f0 * (1.0 + 0.03 * std::sin(2.0 * kPi * 5.0 * i / kRate)) / kRate;
+            double value = 0.0;
+            for (size_t k = 0; k < weights.size(); k++) {
+                value += weights[k] * std::sin((k + 1) * phase);
+            }
+            session.audio.push_back(static_cast<float>(gain * envelope * value));
+            session.speech.push_back(1);
+        }
+    }
+
+    void unvoiced(Session& session, double seconds, float gain) {
+        const size_t count = static_cast<size_t>(seconds * kRate);
+        float previous = 0.0f;
+        for (size_t i = 0; i < count; i++) {
+            const float noise = normal_(rng_);
+            const float envelope = static_cast<float>(std::sin(kPi * (i + 0.5) / count));
+            session.audio.push_back(gain * envelope * (noise - previous) * 0.7f);
+            session.speech.push_back(1);
+            previous = noise;
+        }
+    }
+
+    void addBackground(std::vector<float>& audio, Background background) {
+        float low = 0.0f;
+        for (size_t i = 0; i < audio.size(); i++) {
+            const float white = normal_(rng_);
+            switch (background) {
+            case Background::kQuiet:
+                audio[i] += 0.0005f * white;
+                break;
+            case Background::kFan:
+                low += 0.05f * (white - low);
+                audio[i] += 0.03f * low;
+                break;
+            case Background::kStreet: {
+                low += 0.1f * (white - low);
+                const double level = 0.006 * std::pow(10.0, 0.3 * std::sin(2.0 * kPi * i / (7.0 * kRate)));
+                audio[i] += static_cast<float>(level * (low * 2.0f + 0.3f * white));
+                if (rng_() % (kRate * 3) == 0) { // a click every few seconds
+                    for (size_t k = 0; k < 200 && i + k < audio.size(); k++) {
+                        audio[i + k] += 0.2f * std::exp(-static_cast<float>(k) / 30.0f) * normal_(rng_);
+                    }
+                }
+                break;
+            }
+            }
+        }
+    }
+};
+
+/**
+ * Whisper decodes and encoder audio-seconds a streaming transcriber spends on
+ * each run of forwarded audio: one decode per step over a window that grows
+ * by a step and is trimmed back by half past the trim length, plus the final
+ * decode of each run
+ */
+struct EncoderWork {
+    size_t decodes = 0;
+    double seconds = 0.0;
+
+    void run(size_t samples) {
+        size_t window = 0;
+        for (size_t fed = kStepSamples; fed <= samples; fed += kStepSamples) {
+            window += kStepSamples;
+            decodes++;
+            seconds += static_cast<double>(window) / kRate;
+            if (window > kTrimSamples) {
+                window /= 2;
+            }
+        }
+        decodes++;
+        seconds += static_cast<double>(window + samples % kStepSamples) / kRate;
+    }
+};
+
+struct GateResult {
+    std::vector<uint8_t> forwarded;
+    size_t segments = 0;
+    EncoderWork work;
+    double ms = 0.0;
+};
+
+GateResult runDetector(const std::vector<float>& audio) {
+    GateResult result;
+    result.forwarded.assign(audio.size(), 0);
+    VoiceActivityDetector detector;
+    VadOutput out;
+    bench::Timer timer;
+    size_t segmentLength = 0;
+    // 100 ms chunks, as AudioRecord delivers them
+    for (size_t chunk = 0; chunk < audio.size(); chunk += kRate / 10) {
+        const size_t end = std::min(audio.size(), chunk + kRate / 10);
+        size_t at = chunk;
+        while (at < end) {
+            const size_t consumed = detector.process(audio.data() + at, end - at, out);
+            // Forwarded audio ends at the last complete frame consumed
+            const size_t last = (at + consumed) / detector.frameSamples() * detector.frameSamples();
+            std::fill(result.forwarded.begin() + (last - std::min(last, out.speech.size())),
+                      result.forwarded.begin() + last, 1);
+            segmentLength += out.speech.size();
+            if (out.ended) {
+                result.work.run(segmentLength);
+                segmentLength = 0;
+            }
+            at += consumed;
+        }
+    }
+    if (detector.flush()) {
+        result.work.run(segmentLength);
+    }
+    result.ms = timer.elapsedMs();
+    result.segments = detector.stats().segments;
+    return result;
+}
+
+/**
+ * The Kotlin performVAD, chunk by chunk, with its list and slice copies
+ */
+bool kotlinSpeech(const float* chunk, size_t count) {
+    std::vector<float> squares(chunk, chunk + count);
+    double sum = 0.0;
+    for (float& value : squares) {
+        value *= value;
+        sum += value;
+    }
+    const float rms = static_cast<float>(std::sqrt(sum / count));
+    const float energyDb = 20.0f * std::log10(rms + 1e-8f);
+    int crossings = 0;
+    for (size_t i = 1; i < count; i++) {
+        crossings += (chunk[i] >= 0) != (chunk[i - 1] >= 0);
+    }
+    const float zcr = static_cast<float>(crossings) / count;
+    float centroid = 0.0f;
+    int windows = 0;
+    for (size_t i = 0; i + 100 < count; i += 50) {
+        std::vector<float> window(chunk + i, chunk + std::min(i + 100, count));
+        double windowSum = 0.0;
+        for (float value : window) {
+            windowSum += value * value;
+        }
+        const float windowEnergy = static_cast<float>(std::sqrt(windowSum / window.size()));
+        if (windowEnergy > 0.01f) {
+            int zc = 0;
+            for (size_t j = 1; j < window.size(); j++) {
+                zc += (window[j] >= 0) != (window[j - 1] >= 0);
+            }
+            centroid += (zc * 16000.0f) / (2 * window.size()) * windowEnergy;
+            windows++;
+        }
+    }
+    centroid = windows > 0 ? centroid / windows : 0.0f;
+    return (energyDb > -20.0f && zcr > 0.02f && zcr < 0.3f && centroid > 200.0f) ||
+           (energyDb > -25.0f && centroid > 300.0f);
+}
+
+double microsPerSecond(double ms, size_t samples) {
+    return ms * 1000.0 / (static_cast<double>(samples) / kRate);
+}
+
+void report(const char* label, const Session& session, const std::vector<uint8_t>& forwarded, size_t segments) {
+    size_t speech = 0;
+    size_t covered = 0;
+    size_t leaked = 0;
+    size_t total = 0;
+    for (size_t i = 0; i < session.speech.size() && i < forwarded.size(); i++) {
+        speech += session.speech[i];
+        covered += session.speech[i] & forwarded[i];
+        leaked += (session.speech[i] ^ 1) & forwarded[i];
+        total += forwarded[i];
+    }
+    size_t clipped = 0;
+    for (size_t onset : session.onsets) {
+        const size_t end = std::min(forwarded.size(), onset + kRate / 20);
+        clipped += std::find(forwarded.begin() + onset, forwarded.begin() + end, 0) != forwarded.begin() + end;
+    }
+    const size_t silence = session.speech.size() - speech;
+    std::printf("  %-10s speech %6.1f%%  clipped onsets %3zu/%-3zu  leaked %5.1f%%  forwarded %5.1f%%",
+                label, 100.0 * covered / speech, clipped, session.onsets.size(), 100.0 * leaked / silence,
+                100.0 * total / session.speech.size());
+    if (segments > 0) {
+        std::printf("  segments %4zu", segments);
+    }
+    std::printf("\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const double seconds = static_cast<double>(bench::argOr(argc, argv, 1, 300));
+    std::printf("VAD benchmark: %s kernels, %.0f s sessions, 20 ms frames, 100 ms chunks\n\n",
+                kernels::backendName(), seconds);
+
+    SessionGenerator generator(7);
+    for (Background background : {Background::kQuiet, Background::kFan, Background::kStreet}) {
+        const Session session = generator.generate(seconds, background);
+        const size_t samples = session.audio.size();
+        std::printf("%s (%.0f s, %zu utterances, %.0f%% speech)\n", name(background),
+                    static_cast<double>(samples) / kRate, session.onsets.size(),
+                    100.0 * std::count(session.speech.begin(), session.speech.end(), 1) / samples);
+
+        kernels::useScalarKernels(true);
+        const GateResult scalar = runDetector(session.audio);
+        kernels::useScalarKernels(false);
+        const GateResult gated = runDetector(session.audio);
+
+        std::vector<uint8_t> kotlinForwarded(samples, 0);
+        bench::Timer kotlinTimer;
+        for (size_t chunk = 0; chunk < samples; chunk += kRate / 10) {
+            const size_t count = std::min<size_t>(kRate / 10, samples - chunk);
+            if (kotlinSpeech(session.audio.data() + chunk, count)) {
+                std::fill(kotlinForwarded.begin() + chunk, kotlinForwarded.begin() + chunk + count, 1);
+            }
+        }
+        const double kotlinMs = kotlinTimer.elapsedMs();
+
+        report("native", session, gated.forwarded, gated.segments);
+        report("kotlin", session, kotlinForwarded, 0);
+
+        EncoderWork ungated;
+        ungated.run(samples);
+        std::printf("  decodes    ungated %6zu  gated %6zu (%.1f%%)   encoder audio-s ungated %7.0f  gated %7.0f"
+                    "  -> %.0f%% encoder energy saved (est.)\n",
+                    ungated.decodes, gated.work.decodes, 100.0 * gated.work.decodes / ungated.decodes,
+                    ungated.seconds, gated.work.seconds, 100.0 * (1.0 - gated.work.seconds / ungated.seconds));
+        std::printf("  cost       %s %.1f us/s   scalar %.1f us/s   kotlin-shaped %.1f us/s\n\n",
+                    kernels::backendName(), microsPerSecond(gated.ms, samples), microsPerSecond(scalar.ms, samples),
+                    microsPerSecond(kotlinMs, samples));
+    }
+
+    for (int a = 2; a < argc; a++) {
+        std::vector<float> audio;
+        int rate = 0;
+        if (!bench::readWav(argv[a], audio, rate) || rate != kRate) {
+            std::printf("%s: skipped (needs 16 kHz 16-bit PCM WAV)\n", argv[a]);
+            continue;
+        }
+        const GateResult gated = runDetector(audio);
+        EncoderWork ungated;
+        ungated.run(audio.size());
+        const size_t forwarded = std::count(gated.forwarded.begin(), gated.forwarded.end(), 1);
+        std::printf("%s: %.1f s, forwarded %.1f%% in %zu segments, decodes %zu -> %zu, "
+                    "encoder audio-s %.0f -> %.0f\n",
+                    argv[a], static_cast<double>(audio.size()) / kRate, 100.0 * forwarded / audio.size(),
+                    gated.segments, ungated.decodes, gated.work.decodes, ungated.seconds, gated.work.seconds);
+    }
+    return 0;
+}
@@ -131,6 +131,29 @@ private:
     jsize length_ = 0;
 };
 
+/**
+ * View of a direct java.nio buffer as an array of T; nothing is copied or released
+ */
+template <typename T>
+class DirectBuffer {
+public:
+    DirectBuffer(JNIEnv* env, jobject buffer) {
+        if (buffer != nullptr) {
+            data_ = static_cast<T*>(env->GetDirectBufferAddress(buffer));
+            const jlong bytes = env->GetDirectBufferCapacity(buffer);
+            length_ = data_ != nullptr && bytes > 0 ? static_cast<size_t>(bytes) / sizeof(T) : 0;
+        }
+    }
+
+    T* data() const { return data_; }
+    size_t length() const { return length_; }
+    bool is_null() const { return data_ == nullptr; }
+
+private:
+    T* data_ = nullptr;
+    size_t length_ = 0;
+};
+
 /**
  * Helper to create Java string from C++ string
  */
@@ -138,6 +161,45 @@ inline jstring create_jstring(JNIEnv* env, const std::string& str) {
     return env->NewStringUTF(str.c_str());
 }
 
+/**
+ * Helper to create Java string from model output, which may be cut inside a
+ * UTF-8 sequence or hold bytes NewStringUTF would reject; those become U+FFFD
+ */
+inline jstring create_jstring_lenient(JNIEnv* env, const std::string& str) {
+    std::vector<jchar> utf16;
+    utf16.reserve(str.size());
+    const auto* bytes = reinterpret_cast<const unsigned char*>(str.data());
+    size_t i = 0;
+    while (i < str.size()) {
+        const unsigned char lead = bytes[i];
+        const size_t length = lead < 0x80 ? 1
+                            : (lead >> 5) == 0x6 ? 2
+                            : (lead >> 4) == 0xE ? 3
+                            : (lead >> 3) == 0x1E ? 4
+                            : 0;
+        bool valid = length > 0 && i + length <= str.size();
+        char32_t cp = length == 1 ? lead : length == 2 ? (lead & 0x1F) : length == 3 ? (lead & 0x0F) : (lead & 0x07);
+        for (size_t k = 1; valid && k < length; k++) {
+            valid = (bytes[i + k] & 0xC0) == 0x80;
+            cp = (cp << 6) | (bytes[i + k] & 0x3F);
+        }
+        const char32_t minimum[] = {0, 0, 0x80, 0x800, 0x10000};
+        if (!valid || cp < minimum[length] || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+            utf16.push_back(0xFFFD);
+            i++;
+            continue;
+        }
+        if (cp >= 0x10000) {
+            utf16.push_back(static_cast<jchar>(0xD800 + ((cp - 0x10000) >> 10)));
+            utf16.push_back(static_cast<jchar>(0xDC00 + ((cp - 0x10000) & 0x3FF)));
+        } else {
+            utf16.push_back(static_cast<jchar>(cp));
+        }
+        i += length;
+    }
+    return env->NewString(utf16.data(), static_cast<jsize>(utf16.size()));
+}
+
 /**
  * Helper to create Java float array from C++ vector
  */
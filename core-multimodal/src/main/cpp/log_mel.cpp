@@ -0,0 +1,198 @@
+#include "log_mel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "audio_kernels.h"
+
+namespace iris {
+namespace multimodal {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr size_t kBins = LogMelSpectrogram::kFftSize / 2 + 1;
+constexpr size_t kHalfWindow = LogMelSpectrogram::kFftSize / 2;
+// Frames whose window reaches into the mirrored padding before the audio
+constexpr size_t kMirroredFrames = (kHalfWindow + LogMelSpectrogram::kHop - 1) / LogMelSpectrogram::kHop;
+// log10 of whisper's power floor; the value of every all-zero frame
+constexpr float kSilence = -10.0f;
+
+// Slaney mel scale, as librosa (and so whisper's filters) use it: linear below 1 kHz, logarithmic above
+double hzToMel(double hz) {
+    constexpr double kLinearStep = 200.0 / 3.0;
+    constexpr double kLogStart = 1000.0 / kLinearStep;
+    const double logStep = std::log(6.4) / 27.0;
+    return hz < 1000.0 ? hz / kLinearStep : kLogStart + std::log(hz / 1000.0) / logStep;
+}
+
+double melToHz(double mel) {
+    constexpr double kLinearStep = 200.0 / 3.0;
+    constexpr double kLogStart = 1000.0 / kLinearStep;
+    const double logStep = std::log(6.4) / 27.0;
+    return mel < kLogStart ? mel * kLinearStep : 1000.0 * std::exp(logStep * (mel - kLogStart));
+}
+
+} // namespace
+
+LogMelSpectrogram::LogMelSpectrogram(size_t melBands)
+    : bands_(melBands), fft_(kFftSize), window_(kFftSize), padded_(kFftSize), windowed_(kFftSize), re_(kBins),
+      im_(kBins), power_(kBins) {
+    if (melBands == 0) {
+        throw std::invalid_argument("Log-mel spectrogram needs at least one band");
+    }
+    // Periodic Hann window, as whisper computes it
+    for (size_t i = 0; i < kFftSize; i++) {
+        window_[i] = static_cast<float>(0.5 * (1.0 - std::cos(2.0 * kPi * i / kFftSize)));
+    }
+    buildFilters();
+}
+
+void LogMelSpectrogram::buildFilters() {
+    // librosa.filters.mel(sr=16000, n_fft=400, n_mels=bands_), Slaney-normalised
+    std::vector<double> edges(bands_ + 2);
+    const double top = hzToMel(kSampleRate / 2.0);
+    for (size_t i = 0; i < edges.size(); i++) {
+        edges[i] = melToHz(top * i / (bands_ + 1));
+    }
+    bandStart_.resize(bands_);
+    bandLength_.resize(bands_);
+    bandOffset_.resize(bands_);
+    weights_.clear();
+    for (size_t j = 0; j < bands_; j++) {
+        const double norm = 2.0 / (edges[j + 2] - edges[j]);
+        std::vector<float> row(kBins);
+        for (size_t k = 0; k < kBins; k++) {
+            const double hz = static_cast<double>(k) * kSampleRate / kFftSize;
+            const double lower = (hz - edges[j]) / (edges[j + 1] - edges[j]);
+            const double upper = (edges[j + 2] - hz) / (edges[j + 2] - edges[j + 1]);
+            row[k] = static_cast<float>(std::max(0.0, std::min(lower, upper)) * norm);
+        }
+        size_t first = 0;
+        while (first < kBins && row[first] == 0.0f) {
+            first++;
+        }
+        size_t last = kBins;
+        while (last > first && row[last - 1] == 0.0f) {
+            last--;
+        }
+        bandStart_[j] = first;
+        bandLength_[j] = last - first;
+        bandOffset_[j] = weights_.size();
+        weights_.insert(weights_.end(), row.begin() + first, row.begin() + last);
+    }
+}
+
+std::vector<float> LogMelSpectrogram::denseFilters() const {
+    std::vector<float> dense(bands_ * kBins, 0.0f);
+    for (size_t j = 0; j < bands_; j++) {
+        std::copy(weights_.begin() + bandOffset_[j], weights_.begin() + bandOffset_[j] + bandLength_[j],
+                  dense.begin() + j * kBins + bandStart_[j]);
+    }
+    return dense;
+}
+
+void LogMelSpectrogram::update(const float* audio, size_t count) {
+    for (size_t i = 0; i < staleFront_; i++) {
+        computeFrame(audio, count, i, frames_.data() + i * bands_);
+    }
+    staleFront_ = 0;
+    // A frame is complete once the audio covers the second half of its window
+    while (complete_ * kHop + kHalfWindow < count) {
+        frames_.resize((complete_ + 1) * bands_);
+        computeFrame(audio, count, complete_, frames_.data() + complete_ * bands_);
+        complete_++;
+    }
+}
+
+void LogMelSpectrogram::discard(size_t samples) {
+    if (samples % kHop != 0) {
+        // Every frame boundary moved
+        reset();
+        return;
+    }
+    const size_t dropped = std::min(samples / kHop, complete_);
+    frames_.erase(frames_.begin(), frames_.begin() + dropped * bands_);
+    complete_ -= dropped;
+    // The new first frames mirror different audio now
+    staleFront_ = std::min(complete_, kMirroredFrames);
+}
+
+void LogMelSpectrogram::reset() {
+    frames_.clear();
+    complete_ = 0;
+    staleFront_ = 0;
+}
+
+size_t LogMelSpectrogram::whisperInput(const float* audio, size_t count, size_t columns, std::vector<float>& out) {
+    update(audio, count);
+
+    // Frames overlapping the end of the audio change as it grows, so they are not cached
+    size_t tailFrames = 0;
+    while ((complete_ + tailFrames) * kHop < count + kHalfWindow) {
+        tailFrames++;
+    }
+    tail_.resize(tailFrames * bands_);
+    for (size_t t = 0; t < tailFrames; t++) {
+        computeFrame(audio, count, complete_ + t, tail_.data() + t * bands_);
+    }
+
+    // Whisper's maximum includes its padding, so the floor never rises above silence
+    float maximum = kSilence;
+    for (float value : frames_) {
+        maximum = std::max(maximum, value);
+    }
+    for (float value : tail_) {
+        maximum = std::max(maximum, value);
+    }
+    const float floor = maximum - 8.0f;
+    const auto normalise = [floor](float value) { return (std::max(value, floor) + 4.0f) / 4.0f; };
+
+    out.resize(bands_ * columns);
+    const size_t cached = std::min(complete_, columns);
+    const size_t computed = std::min(complete_ + tailFrames, columns);
+    const float silence = normalise(kSilence);
+    for (size_t j = 0; j < bands_; j++) {
+        float* row = out.data() + j * columns;
+        for (size_t i = 0; i < cached; i++) {
+            row[i] = normalise(frames_[i * bands_ + j]);
+        }
+        for (size_t i = cached; i < computed; i++) {
+            row[i] = normalise(tail_[(i - complete_) * bands_ + j]);
+        }
+        std::fill(row + computed, row + columns, silence);
+    }
+
+    // whisper: 1 + (n_samples + n_fft / 2 - n_fft) / hop, with C division
+    const long frames = 1 + (static_cast<long>(count) - static_cast<long>(kHalfWindow)) / static_cast<long>(kHop);
+    return frames > 0 ? static_cast<size_t>(frames) : 0;
+}
+
+void LogMelSpectrogram::computeFrame(const float* audio, size_t count, size_t index, float* out) {
+    // The window covers audio[index * hop - 200, index * hop + 200): mirrored before the audio, zero after it
+    const long first = static_cast<long>(index * kHop) - static_cast<long>(kHalfWindow);
+    const float* samples;
+    if (first >= 0 && static_cast<size_t>(first) + kFftSize <= count) {
+        samples = audio + first;
+    } else {
+        for (size_t t = 0; t < kFftSize; t++) {
+            const long s = first + static_cast<long>(t);
+            const size_t source = static_cast<size_t>(s < 0 ? -s : s);
+            padded_[t] = source < count ? audio[source] : 0.0f;
+        }
+        samples = padded_.data();
+    }
+
+    kernels::multiply(samples, window_.data(), windowed_.data(), kFftSize);
+    fft_.forward(windowed_.data(), re_.data(), im_.data());
+    kernels::power(re_.data(), im_.data(), power_.data(), kBins);
+    for (size_t j = 0; j < bands_; j++) {
+        const float sum = kernels::dot(power_.data() + bandStart_[j], weights_.data() + bandOffset_[j], bandLength_[j]);
+        out[j] = std::log10(std::max(sum, 1e-10f));
+    }
+    framesComputed_++;
+}
+
+} // namespace multimodal
+} // namespace iris
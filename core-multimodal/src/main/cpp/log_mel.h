@@ -0,0 +1,109 @@
+#ifndef IRIS_MULTIMODAL_LOG_MEL_H
+#define IRIS_MULTIMODAL_LOG_MEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "real_fft.h"
+
+namespace iris {
+namespace multimodal {
+
+/**
+ * Whisper's log-mel front end, computed incrementally over a streaming window.
+ *
+ * Frames are whisper's: 400-sample periodic Hann windows every 160 samples of
+ * 16 kHz audio, centred (the first 200 samples are mirrored in front of the
+ * audio, zeros follow it), an 80- or 128-band Slaney mel filterbank and
+ * log10. whisperInput() applies whisper's normalisation: clamp to 8 below the
+ * maximum, then (x + 4) / 4.
+ *
+ * A frame is computed once, as soon as the audio covers its whole window, and
+ * kept until its audio is discarded from the front of the window. Only the
+ * few frames that overlap the end of the audio are recomputed for each
+ * decode, and the 30 s of zero padding whisper appends is a constant column,
+ * not 3000 FFTs. The normalisation depends on the window's maximum, so it is
+ * applied to the cached log-mel values on every call; that is a copy, not an
+ * FFT.
+ *
+ * Not thread-safe.
+ */
+class LogMelSpectrogram {
+public:
+    static constexpr size_t kSampleRate = 16000;
+    static constexpr size_t kFftSize = 400;
+    static constexpr size_t kHop = 160;
+
+    /**
+     * @param melBands 80, or 128 for large-v3 models
+     * @throws std::invalid_argument if melBands is 0
+     */
+    explicit LogMelSpectrogram(size_t melBands = 80);
+
+    size_t melBands() const { return bands_; }
+
+    /**
+     * Compute every frame the audio now completes. `audio` must be the audio
+     * of the previous call with samples appended, less any prefix dropped
+     * with discard().
+     */
+    void update(const float* audio, size_t count);
+
+    /**
+     * The first `samples` of the audio were dropped. Frames are kept when
+     * that is a whole number of hops and recomputed by the next update()
+     * otherwise.
+     */
+    void discard(size_t samples);
+
+    void reset();
+
+    /**
+     * Whisper's encoder input for `audio`, updating frames first: mel-major
+     * (`columns` values per band), normalised, with columns past the audio
+     * filled the way whisper's zero padding would fill them
+     * @return The number of frames whisper counts as audio (its n_len_org)
+     */
+    size_t whisperInput(const float* audio, size_t count, size_t columns, std::vector<float>& out);
+
+    /**
+     * Frames run through the FFT so far, including recomputed ones
+     */
+    uint64_t framesComputed() const { return framesComputed_; }
+
+    /**
+     * Filterbank as a dense [melBands][kFftSize / 2 + 1] matrix, for comparisons
+     */
+    std::vector<float> denseFilters() const;
+
+private:
+    const size_t bands_;
+    RealFft fft_;
+    std::vector<float> window_;
+    std::vector<size_t> bandStart_;  // first FFT bin with a non-zero weight
+    std::vector<size_t> bandLength_; // number of non-zero weights
+    std::vector<size_t> bandOffset_; // where the band's weights start in weights_
+    std::vector<float> weights_;
+
+    std::vector<float> frames_; // [frame][band] log10 mel power of complete frames
+    size_t complete_ = 0;
+    size_t staleFront_ = 0; // leading frames whose mirrored padding changed with a discard
+    uint64_t framesComputed_ = 0;
+
+    // Per-frame work buffers
+    std::vector<float> padded_;
+    std::vector<float> windowed_;
+    std::vector<float> re_;
+    std::vector<float> im_;
+    std::vector<float> power_;
+    std::vector<float> tail_;
+
+    void buildFilters();
+    void computeFrame(const float* audio, size_t count, size_t index, float* out);
+};
+
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_LOG_MEL_H
@@ -0,0 +1,276 @@
+#include "real_fft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace iris {
+namespace multimodal {
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::vector<size_t> factorize(size_t n) {
+    std::vector<size_t> factors;
+    while (n % 4 == 0) {
+        factors.push_back(4);
+        n /= 4;
+    }
+    for (size_t p = 2; n > 1; p++) {
+        while (n % p == 0) {
+            factors.push_back(p);
+            n /= p;
+        }
+    }
+    return factors;
+}
+
+} // namespace
+
+RealFft::RealFft(size_t size) : size_(size), half_(size / 2) {
+    if (size < 2 || size % 2 != 0) {
+        throw std::invalid_argument("Real FFT size must be even and at least 2");
+    }
+    const std::vector<size_t> factors = factorize(half_);
+
+    // Decimation in time: position t of the permuted input holds the sample whose
+    // mixed-radix digits are those of t reversed, the last stage's digit first
+    permutation_.resize(half_);
+    for (size_t t = 0; t < half_; t++) {
+        size_t rest = t;
+        size_t n = half_;
+        size_t index = 0;
+        size_t stride = 1;
+        for (size_t f = factors.size(); f > 0; f--) {
+            const size_t radix = factors[f - 1];
+            n /= radix;
+            index += rest / n * stride;
+            rest %= n;
+            stride *= radix;
+        }
+        permutation_[t] = static_cast<uint32_t>(index);
+    }
+
+    size_t span = 1;
+    size_t widest = 0;
+    for (size_t radix : factors) {
+        Stage stage{radix, span, {}, {}, {}, {}};
+        stage.twiddleRe.resize((radix - 1) * span);
+        stage.twiddleIm.resize((radix - 1) * span);
+        for (size_t q = 1; q < radix; q++) {
+            for (size_t j = 0; j < span; j++) {
+                const double angle = -2.0 * kPi * static_cast<double>(q * j) / static_cast<double>(span * radix);
+                stage.twiddleRe[(q - 1) * span + j] = static_cast<float>(std::cos(angle));
+                stage.twiddleIm[(q - 1) * span + j] = static_cast<float>(std::sin(angle));
+            }
+        }
+        if (radix > 5) {
+            for (size_t k = 0; k < radix; k++) {
+                const double angle = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(radix);
+                stage.rootRe.push_back(static_cast<float>(std::cos(angle)));
+                stage.rootIm.push_back(static_cast<float>(std::sin(angle)));
+            }
+        }
+        widest = std::max(widest, radix);
+        span *= radix;
+        stages_.push_back(std::move(stage));
+    }
+
+    rootsRe_.resize(half_ + 1);
+    rootsIm_.resize(half_ + 1);
+    for (size_t k = 0; k <= half_; k++) {
+        const double angle = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(size_);
+        rootsRe_[k] = static_cast<float>(std::cos(angle));
+        rootsIm_[k] = static_cast<float>(std::sin(angle));
+    }
+    zRe_.resize(half_);
+    zIm_.resize(half_);
+    scratchRe_.resize(2 * widest);
+    scratchIm_.resize(2 * widest);
+}
+
+void RealFft::forward(const float* input, float* re, float* im) {
+    for (size_t t = 0; t < half_; t++) {
+        zRe_[t] = input[2 * permutation_[t]];
+        zIm_[t] = input[2 * permutation_[t] + 1];
+    }
+    for (const Stage& stage : stages_) {
+        butterflies(stage);
+    }
+
+    // Split the packed transform into the spectra of the even and odd samples
+    // and combine them: X[k] = E[k] + W^k O[k]
+    for (size_t k = 0; k <= half_; k++) {
+        const size_t a = k % half_;
+        const size_t b = (half_ - k) % half_;
+        const float evenRe = 0.5f * (zRe_[a] + zRe_[b]);
+        const float evenIm = 0.5f * (zIm_[a] - zIm_[b]);
+        const float oddRe = 0.5f * (zIm_[a] + zIm_[b]);
+        const float oddIm = -0.5f * (zRe_[a] - zRe_[b]);
+        re[k] = evenRe + rootsRe_[k] * oddRe - rootsIm_[k] * oddIm;
+        im[k] = evenIm + rootsRe_[k] * oddIm + rootsIm_[k] * oddRe;
+    }
+}
+
+void RealFft::butterflies(const Stage& stage) {
+    const size_t radix = stage.radix;
+    const size_t span = stage.span;
+    float* xr = zRe_.data();
+    float* xi = zIm_.data();
+    const float* wr = stage.twiddleRe.data();
+    const float* wi = stage.twiddleIm.data();
+
+    for (size_t group = 0; group < half_; group += span * radix) {
+        float* gr = xr + group;
+        float* gi = xi + group;
+        switch (radix) {
+        case 2:
+            for (size_t j = 0; j < span; j++) {
+                const float br = gr[span + j] * wr[j] - gi[span + j] * wi[j];
+                const float bi = gr[span + j] * wi[j] + gi[span + j] * wr[j];
+                const float ar = gr[j];
+                const float ai = gi[j];
+                gr[j] = ar + br;
+                gi[j] = ai + bi;
+                gr[span + j] = ar - br;
+                gi[span + j] = ai - bi;
+            }
+            break;
+        case 3: {
+            const float c = 0.86602540378443864676f; // sin(2 pi / 3)
+            for (size_t j = 0; j < span; j++) {
+                const float a0r = gr[j];
+                const float a0i = gi[j];
+                const float a1r = gr[span + j] * wr[j] - gi[span + j] * wi[j];
+                const float a1i = gr[span + j] * wi[j] + gi[span + j] * wr[j];
+                const float a2r = gr[2 * span + j] * wr[span + j] - gi[2 * span + j] * wi[span + j];
+                const float a2i = gr[2 * span + j] * wi[span + j] + gi[2 * span + j] * wr[span + j];
+                const float sr = a1r + a2r;
+                const float si = a1i + a2i;
+                const float dr = a1r - a2r;
+                const float di = a1i - a2i;
+                const float mr = a0r - 0.5f * sr;
+                const float mi = a0i - 0.5f * si;
+                gr[j] = a0r + sr;
+                gi[j] = a0i + si;
+                gr[span + j] = mr + c * di;
+                gi[span + j] = mi - c * dr;
+                gr[2 * span + j] = mr - c * di;
+                gi[2 * span + j] = mi + c * dr;
+            }
+            break;
+        }
+        case 4:
+            for (size_t j = 0; j < span; j++) {
+                const float a0r = gr[j];
+                const float a0i = gi[j];
+                const float a1r = gr[span + j] * wr[j] - gi[span + j] * wi[j];
+                const float a1i = gr[span + j] * wi[j] + gi[span + j] * wr[j];
+                const float a2r = gr[2 * span + j] * wr[span + j] - gi[2 * span + j] * wi[span + j];
+                const float a2i = gr[2 * span + j] * wi[span + j] + gi[2 * span + j] * wr[span + j];
+                const float a3r = gr[3 * span + j] * wr[2 * span + j] - gi[3 * span + j] * wi[2 * span + j];
+                const float a3i = gr[3 * span + j] * wi[2 * span + j] + gi[3 * span + j] * wr[2 * span + j];
+                const float t0r = a0r + a2r;
+                const float t0i = a0i + a2i;
+                const float t1r = a0r - a2r;
+                const float t1i = a0i - a2i;
+                const float t2r = a1r + a3r;
+                const float t2i = a1i + a3i;
+                const float t3r = a1r - a3r;
+                const float t3i = a1i - a3i;
+                gr[j] = t0r + t2r;
+                gi[j] = t0i + t2i;
+                gr[span + j] = t1r + t3i;
+                gi[span + j] = t1i - t3r;
+                gr[2 * span + j] = t0r - t2r;
+                gi[2 * span + j] = t0i - t2i;
+                gr[3 * span + j] = t1r - t3i;
+                gi[3 * span + j] = t1i + t3r;
+            }
+            break;
+        case 5: {
+            const float c1 = 0.30901699437494742410f;  // cos(2 pi / 5)
+            const float c2 = -0.80901699437494742410f; // cos(4 pi / 5)
+            const float s1 = 0.95105651629515357212f;  // sin(2 pi / 5)
+            const float s2 = 0.58778525229247312917f;  // sin(4 pi / 5)
+            for (size_t j = 0; j < span; j++) {
+                float ar[5];
+                float ai[5];
+                ar[0] = gr[j];
+                ai[0] = gi[j];
+                for (size_t q = 1; q < 5; q++) {
+                    const float w_r = wr[(q - 1) * span + j];
+                    const float w_i = wi[(q - 1) * span + j];
+                    ar[q] = gr[q * span + j] * w_r - gi[q * span + j] * w_i;
+                    ai[q] = gr[q * span + j] * w_i + gi[q * span + j] * w_r;
+                }
+                const float b1r = ar[1] + ar[4];
+                const float b1i = ai[1] + ai[4];
+                const float b2r = ar[2] + ar[3];
+                const float b2i = ai[2] + ai[3];
+                const float d1r = ar[1] - ar[4];
+                const float d1i = ai[1] - ai[4];
+                const float d2r = ar[2] - ar[3];
+                const float d2i = ai[2] - ai[3];
+                const float m1r = ar[0] + c1 * b1r + c2 * b2r;
+                const float m1i = ai[0] + c1 * b1i + c2 * b2i;
+                const float m2r = ar[0] + c2 * b1r + c1 * b2r;
+                const float m2i = ai[0] + c2 * b1i + c1 * b2i;
+                const float n1r = s1 * d1r + s2 * d2r;
+                const float n1i = s1 * d1i + s2 * d2i;
+                const float n2r = s2 * d1r - s1 * d2r;
+                const float n2i = s2 * d1i - s1 * d2i;
+                gr[j] = ar[0] + b1r + b2r;
+                gi[j] = ai[0] + b1i + b2i;
+                gr[span + j] = m1r + n1i;
+                gi[span + j] = m1i - n1r;
+                gr[4 * span + j] = m1r - n1i;
+                gi[4 * span + j] = m1i + n1r;
+                gr[2 * span + j] = m2r + n2i;
+                gi[2 * span + j] = m2i - n2r;
+                gr[3 * span + j] = m2r - n2i;
+                gi[3 * span + j] = m2i + n2r;
+            }
+            break;
+        }
+        default: {
+            // Any other prime: a direct DFT over the radix legs
+            float* inRe = scratchRe_.data();
+            float* inIm = scratchIm_.data();
+            float* outRe = inRe + radix;
+            float* outIm = inIm + radix;
+            for (size_t j = 0; j < span; j++) {
+                inRe[0] = gr[j];
+                inIm[0] = gi[j];
+                for (size_t q = 1; q < radix; q++) {
+                    const float w_r = wr[(q - 1) * span + j];
+                    const float w_i = wi[(q - 1) * span + j];
+                    inRe[q] = gr[q * span + j] * w_r - gi[q * span + j] * w_i;
+                    inIm[q] = gr[q * span + j] * w_i + gi[q * span + j] * w_r;
+                }
+                for (size_t r = 0; r < radix; r++) {
+                    float sumRe = 0.0f;
+                    float sumIm = 0.0f;
+                    for (size_t q = 0; q < radix; q++) {
+                        const float c = stage.rootRe[r * q % radix];
+                        const float s = stage.rootIm[r * q % radix];
+                        sumRe += inRe[q] * c - inIm[q] * s;
+                        sumIm += inRe[q] * s + inIm[q] * c;
+                    }
+                    outRe[r] = sumRe;
+                    outIm[r] = sumIm;
+                }
+                for (size_t r = 0; r < radix; r++) {
+                    gr[r * span + j] = outRe[r];
+                    gi[r * span + j] = outIm[r];
+                }
+            }
+            break;
+        }
+        }
+    }
+}
+
+} // namespace multimodal
+} // namespace iris
@@ -0,0 +1,69 @@
+#ifndef IRIS_MULTIMODAL_REAL_FFT_H
+#define IRIS_MULTIMODAL_REAL_FFT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace iris {
+namespace multimodal {
+
+/**
+ * Precomputed plan for the forward FFT of real input of one even length.
+ *
+ * The N real samples are packed into an N/2-point complex FFT (even samples
+ * as the real part, odd as the imaginary part) and the N/2+1 output bins are
+ * recovered from it with one twiddle pass. The complex FFT is mixed radix
+ * (4, 2, 3, 5, then any remaining prime), so whisper's 400-point frame needs
+ * no zero padding: 200 = 4 * 2 * 5 * 5. Input permutation, twiddles and
+ * scratch are built once by the constructor; transforms do not allocate.
+ *
+ * Data is split complex (separate real and imaginary arrays), so every
+ * butterfly stage runs over contiguous arrays.
+ *
+ * Not thread-safe: the scratch buffers belong to the plan.
+ */
+class RealFft {
+public:
+    /**
+     * @throws std::invalid_argument if size is odd or less than 2
+     */
+    explicit RealFft(size_t size);
+
+    size_t size() const { return size_; }
+    size_t bins() const { return half_ + 1; }
+
+    /**
+     * Transform size() real samples into bins() complex bins
+     */
+    void forward(const float* input, float* re, float* im);
+
+private:
+    // One butterfly stage: `radix` sub-transforms of `span` points become one of span * radix
+    struct Stage {
+        size_t radix;
+        size_t span;
+        std::vector<float> twiddleRe; // [radix - 1][span]: W^(q*j) for q = 1..radix-1, j < span
+        std::vector<float> twiddleIm;
+        std::vector<float> rootRe; // e^(-2 pi i k / radix); only for radixes without a dedicated butterfly
+        std::vector<float> rootIm;
+    };
+
+    size_t size_;
+    size_t half_;
+    std::vector<uint32_t> permutation_; // digit-reversed input order of the complex FFT
+    std::vector<Stage> stages_;
+    std::vector<float> rootsRe_; // e^(-2 pi i k / N), k <= N/2, for unpacking the real transform
+    std::vector<float> rootsIm_;
+    std::vector<float> zRe_;
+    std::vector<float> zIm_;
+    std::vector<float> scratchRe_; // one input per butterfly leg for the generic radix
+    std::vector<float> scratchIm_;
+
+    void butterflies(const Stage& stage);
+};
+
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_REAL_FFT_H
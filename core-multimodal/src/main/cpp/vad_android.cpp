@@ -0,0 +1,113 @@
+#include <jni.h>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "jni_utils.h"
+#include "voice_activity_detector.h"
+
+using iris::multimodal::VadModel;
+using iris::multimodal::VadOptions;
+using iris::multimodal::VadOutput;
+using iris::multimodal::VoiceActivityDetector;
+
+namespace {
+
+// A detector and the output buffer it reuses between calls
+struct VadHandle {
+    VoiceActivityDetector detector;
+    VadOutput output;
+
+    VadHandle(VadOptions options, std::unique_ptr<VadModel> model) : detector(options, std::move(model)) {}
+};
+
+} // namespace
+
+extern "C" {
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_VoiceActivityDetector_nativeCreate(
+    JNIEnv* env, jobject thiz, jint sample_rate, jint frame_ms, jint hangover_ms, jstring model_path) {
+
+    try {
+        VadOptions options;
+        options.sampleRate = sample_rate;
+        options.frameMs = frame_ms;
+        options.hangoverMs = hangover_ms;
+
+        std::unique_ptr<VadModel> model;
+        if (model_path != nullptr) {
+            iris::jni::JString path(env, model_path);
+            model = VadModel::load(path.c_str());
+        }
+        return reinterpret_cast<jlong>(new VadHandle(options, std::move(model)));
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in VAD nativeCreate: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, e.what());
+        return 0;
+    }
+}
+
+/**
+ * Returns the speech to forward (null if none); out_state receives samples
+ * consumed, segment started and segment ended
+ */
+JNIEXPORT jfloatArray JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_VoiceActivityDetector_nativeProcess(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jfloatArray samples, jint offset, jint count,
+    jintArray out_state) {
+
+    auto* handle = reinterpret_cast<VadHandle*>(handle_ptr);
+    iris::jni::JFloatArray audio(env, samples);
+    if (audio.is_null() || offset < 0 || count < 0 || offset + count > audio.length()) {
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, "Bad sample range");
+        return nullptr;
+    }
+
+    const size_t consumed = handle->detector.process(audio.data() + offset, static_cast<size_t>(count),
+                                                     handle->output);
+    const jint state[3] = {
+        static_cast<jint>(consumed),
+        handle->output.started ? 1 : 0,
+        handle->output.ended ? 1 : 0,
+    };
+    env->SetIntArrayRegion(out_state, 0, 3, state);
+    if (handle->output.speech.empty()) {
+        return nullptr;
+    }
+    return iris::jni::create_jfloat_array(env, handle->output.speech);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_VoiceActivityDetector_nativeFlush(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    return reinterpret_cast<VadHandle*>(handle_ptr)->detector.flush() ? JNI_TRUE : JNI_FALSE;
+}
+
+/**
+ * Frames, speech frames, segments and forwarded samples so far
+ */
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_VoiceActivityDetector_nativeStats(
+    JNIEnv* env, jobject thiz, jlong handle_ptr, jlongArray out_stats) {
+
+    const auto& stats = reinterpret_cast<VadHandle*>(handle_ptr)->detector.stats();
+    const jlong values[4] = {
+        static_cast<jlong>(stats.frames),
+        static_cast<jlong>(stats.speechFrames),
+        static_cast<jlong>(stats.segments),
+        static_cast<jlong>(stats.forwardedSamples),
+    };
+    env->SetLongArrayRegion(out_stats, 0, 4, values);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_VoiceActivityDetector_nativeDestroy(
+    JNIEnv* env, jobject thiz, jlong handle_ptr) {
+
+    delete reinterpret_cast<VadHandle*>(handle_ptr);
+}
+
+} // extern "C"
@@ -0,0 +1,226 @@
+#include "voice_activity_detector.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "audio_kernels.h"
+
+#define LOG_TAG "IrisVad"
+#include "audio_log.h"
+
+namespace iris {
+namespace multimodal {
+
+namespace {
+
+// The noise floor is the quietest frame of this much recent audio; a sentence has pauses shorter than this
+constexpr int kFloorWindowMs = 1500;
+// Upward steps toward a louder floor are smoothed; downward ones are taken at once
+constexpr float kFloorRise = 0.05f;
+// A floor above this would hide normal speech, so a stream that starts mid-sentence still gets an onset
+constexpr float kMaxFloorDb = -35.0f;
+// Frames with many zero crossings must clear the floor by this much more to count as speech
+constexpr float kHissMarginDb = 6.0f;
+constexpr float kSilenceDb = -100.0f;
+
+uint32_t readU32(const char* bytes) {
+    uint32_t value;
+    std::memcpy(&value, bytes, sizeof(value));
+    return value;
+}
+
+} // namespace
+
+// ============================================================================
+// VadModel
+// ============================================================================
+
+std::unique_ptr<VadModel> VadModel::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Cannot open VAD model: " + path);
+    }
+    const std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.size() < 16 || std::memcmp(bytes.data(), "IVAD", 4) != 0 || readU32(bytes.data() + 4) != 1) {
+        throw std::runtime_error("Not a version 1 VAD model: " + path);
+    }
+    const size_t contextFrames = readU32(bytes.data() + 8);
+    const size_t hidden = readU32(bytes.data() + 12);
+    if (contextFrames == 0 || contextFrames > 64 || hidden == 0 || hidden > 256) {
+        throw std::runtime_error("VAD model dimensions out of range: " + path);
+    }
+    const size_t count = hidden * (contextFrames * kFeatures) + hidden + hidden + 1;
+    if (bytes.size() != 16 + count * sizeof(float)) {
+        throw std::runtime_error("VAD model size does not match its header: " + path);
+    }
+    std::vector<float> weights(count);
+    std::memcpy(weights.data(), bytes.data() + 16, count * sizeof(float));
+    LOGI("Loaded VAD model: %zu frames of context, %zu hidden units", contextFrames, hidden);
+    return std::make_unique<VadModel>(contextFrames, hidden, std::move(weights));
+}
+
+VadModel::VadModel(size_t contextFrames, size_t hidden, std::vector<float> weights)
+    : contextFrames_(contextFrames), hidden_(hidden), weights_(std::move(weights)) {}
+
+float VadModel::speechProbability(const float* features) const {
+    const size_t inputs = contextFrames_ * kFeatures;
+    const float* inputWeights = weights_.data();
+    const float* hiddenBias = inputWeights + hidden_ * inputs;
+    const float* outputWeights = hiddenBias + hidden_;
+    float logit = outputWeights[hidden_];
+    for (size_t h = 0; h < hidden_; h++) {
+        float activation = hiddenBias[h];
+        for (size_t i = 0; i < inputs; i++) {
+            activation += inputWeights[h * inputs + i] * features[i];
+        }
+        logit += outputWeights[h] * std::max(activation, 0.0f);
+    }
+    return 1.0f / (1.0f + std::exp(-logit));
+}
+
+// ============================================================================
+// VoiceActivityDetector
+// ============================================================================
+
+VoiceActivityDetector::VoiceActivityDetector(VadOptions options, std::unique_ptr<VadModel> model)
+    : options_(options), model_(std::move(model)),
+      frame_(static_cast<size_t>(options.sampleRate) * options.frameMs / 1000),
+      historyFrames_(static_cast<size_t>((options.preRollMs + options.frameMs - 1) / options.frameMs +
+                                         std::max(options.onsetFrames, 1))),
+      hangoverFrames_(std::max(1, (options.hangoverMs + options.frameMs - 1) / options.frameMs)),
+      floorDb_(kSilenceDb) {
+    if (options.frameMs < 10 || options.frameMs > 30 || options.sampleRate < 8000) {
+        throw std::invalid_argument("VAD frames must be 10 to 30 ms at 8 kHz or more");
+    }
+    pending_.reserve(frame_);
+    history_.resize(historyFrames_ * frame_);
+    levels_.assign(static_cast<size_t>(std::max(1, kFloorWindowMs / options.frameMs)), kSilenceDb);
+    if (model_) {
+        features_.assign(model_->contextFrames() * VadModel::kFeatures, 0.0f);
+    }
+}
+
+size_t VoiceActivityDetector::process(const float* samples, size_t count, VadOutput& out) {
+    out.speech.clear();
+    out.started = false;
+    out.ended = false;
+    size_t used = 0;
+    while (used < count) {
+        const size_t take = std::min(frame_ - pending_.size(), count - used);
+        pending_.insert(pending_.end(), samples + used, samples + used + take);
+        used += take;
+        if (pending_.size() < frame_) {
+            break;
+        }
+        processFrame(pending_.data(), out);
+        pending_.clear();
+        if (out.ended) {
+            break;
+        }
+    }
+    stats_.forwardedSamples += out.speech.size();
+    return used;
+}
+
+bool VoiceActivityDetector::flush() {
+    pending_.clear();
+    const bool open = speaking_;
+    speaking_ = false;
+    speechRun_ = 0;
+    silentRun_ = 0;
+    return open;
+}
+
+void VoiceActivityDetector::reset() {
+    flush();
+    previous_ = 0.0f;
+    historyHead_ = 0;
+    historyCount_ = 0;
+    std::fill(levels_.begin(), levels_.end(), kSilenceDb);
+    levelCount_ = 0;
+    std::fill(features_.begin(), features_.end(), 0.0f);
+    floorDb_ = kSilenceDb;
+    stats_ = VadStats();
+}
+
+bool VoiceActivityDetector::classify(const float* frame) {
+    const kernels::FrameStats stats = kernels::frameStats(frame, frame_, previous_);
+    previous_ = frame[frame_ - 1];
+    const float levelDb = 10.0f * std::log10(stats.energy / frame_ + 1e-10f);
+    const float crossingRate = static_cast<float>(stats.crossings) / frame_;
+
+    // Minimum-statistics noise floor over the recent frames, this one included
+    levels_[levelCount_++ % levels_.size()] = levelDb;
+    const size_t filled = std::min(levelCount_, levels_.size());
+    const float quietest = std::min(*std::min_element(levels_.begin(), levels_.begin() + filled), kMaxFloorDb);
+    if (levelCount_ == 1 || quietest < floorDb_) {
+        floorDb_ = quietest;
+    } else {
+        floorDb_ += kFloorRise * (quietest - floorDb_);
+    }
+
+    const float aboveDb = levelDb - floorDb_;
+    if (levelDb <= options_.minLevelDb) {
+        return false;
+    }
+    if (model_) {
+        std::copy(features_.begin() + VadModel::kFeatures, features_.end(), features_.begin());
+        float* newest = features_.data() + features_.size() - VadModel::kFeatures;
+        newest[0] = aboveDb / 20.0f;
+        newest[1] = crossingRate;
+        newest[2] = stats.diffEnergy / (stats.energy + 1e-10f);
+        return aboveDb > options_.thresholdDb * 0.5f &&
+               model_->speechProbability(features_.data()) >= options_.modelThreshold;
+    }
+    if (crossingRate > options_.maxCrossingRate) {
+        return aboveDb > options_.thresholdDb + kHissMarginDb;
+    }
+    return aboveDb > options_.thresholdDb;
+}
+
+void VoiceActivityDetector::processFrame(const float* frame, VadOutput& out) {
+    stats_.frames++;
+    const bool speech = classify(frame);
+    stats_.speechFrames += speech;
+
+    if (!speaking_) {
+        remember(frame);
+        speechRun_ = speech ? speechRun_ + 1 : 0;
+        if (speechRun_ < options_.onsetFrames) {
+            return;
+        }
+        // Onset: forward the pre-roll and the onset frames, oldest first
+        speaking_ = true;
+        silentRun_ = 0;
+        out.started = true;
+        stats_.segments++;
+        for (size_t k = 0; k < historyCount_; k++) {
+            const size_t slot = (historyHead_ + historyFrames_ - historyCount_ + k) % historyFrames_;
+            const float* stored = history_.data() + slot * frame_;
+            out.speech.insert(out.speech.end(), stored, stored + frame_);
+        }
+        historyCount_ = 0;
+        return;
+    }
+
+    out.speech.insert(out.speech.end(), frame, frame + frame_);
+    silentRun_ = speech ? 0 : silentRun_ + 1;
+    if (silentRun_ >= hangoverFrames_) {
+        speaking_ = false;
+        speechRun_ = 0;
+        out.ended = true;
+    }
+}
+
+void VoiceActivityDetector::remember(const float* frame) {
+    std::copy(frame, frame + frame_, history_.data() + historyHead_ * frame_);
+    historyHead_ = (historyHead_ + 1) % historyFrames_;
+    historyCount_ = std::min(historyCount_ + 1, historyFrames_);
+}
+
+} // namespace multimodal
+} // namespace iris
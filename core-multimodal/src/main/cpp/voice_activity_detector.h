@@ -0,0 +1,150 @@
+#ifndef IRIS_MULTIMODAL_VOICE_ACTIVITY_DETECTOR_H
+#define IRIS_MULTIMODAL_VOICE_ACTIVITY_DETECTOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace iris {
+namespace multimodal {
+
+struct VadOptions {
+    int sampleRate = 16000;
+    int frameMs = 20;              // 10 to 30
+    float thresholdDb = 9.0f;      // speech frames sit at least this far above the noise floor
+    float minLevelDb = -50.0f;     // frames quieter than this (dBFS) are never speech
+    float maxCrossingRate = 0.35f; // zero crossings per sample above this need a louder frame to count
+    int onsetFrames = 3;           // speech frames in a row that open a segment
+    int hangoverMs = 400;          // a segment stays open this long after its last speech frame
+    int preRollMs = 200;           // audio before the onset forwarded with the segment
+    float modelThreshold = 0.5f;   // speech probability a loaded model must give
+};
+
+/**
+ * Tiny frame classifier: one hidden ReLU layer over the features of the last
+ * few frames, sigmoid output.
+ *
+ * File layout, little-endian: "IVAD", uint32 version (1), uint32 context
+ * frames, uint32 hidden units, then float32 weights: hidden x (3 x context)
+ * input weights, hidden biases, hidden output weights, output bias. The three
+ * features per frame, oldest frame first, are (level above the noise floor) /
+ * 20 dB, zero crossings per sample, and first-difference to signal energy
+ * ratio.
+ */
+class VadModel {
+public:
+    static constexpr size_t kFeatures = 3;
+
+    /**
+     * @throws std::runtime_error if the file is missing or malformed
+     */
+    static std::unique_ptr<VadModel> load(const std::string& path);
+
+    VadModel(size_t contextFrames, size_t hidden, std::vector<float> weights);
+
+    size_t contextFrames() const { return contextFrames_; }
+
+    /**
+     * @param features contextFrames() x kFeatures values, oldest frame first
+     */
+    float speechProbability(const float* features) const;
+
+private:
+    size_t contextFrames_;
+    size_t hidden_;
+    std::vector<float> weights_;
+};
+
+struct VadOutput {
+    std::vector<float> speech; // audio to forward: pre-roll and onset at a start, then every frame until the end
+    bool started = false;      // a segment opened in this call
+    bool ended = false;        // a segment closed; the call stopped right after it
+};
+
+struct VadStats {
+    uint64_t frames = 0;
+    uint64_t speechFrames = 0; // frames classified as speech, before onset and hangover
+    uint64_t segments = 0;
+    uint64_t forwardedSamples = 0;
+};
+
+/**
+ * Streaming voice-activity detector that decides which audio reaches the
+ * recognizer.
+ *
+ * Audio is cut into fixed frames regardless of how it arrives. Each frame's
+ * energy, first-difference energy and zero crossings come from one SIMD pass
+ * (kernels::frameStats). A frame is speech when its level clears an adaptive
+ * noise floor by `thresholdDb`; hiss-like frames with many zero crossings
+ * must clear it by 6 dB more. With a VadModel loaded, the model decides among
+ * frames loud enough to be considered at all.
+ *
+ * `onsetFrames` speech frames in a row open a segment, which is forwarded
+ * with the `preRollMs` of audio before it so the first syllable is not cut.
+ * The segment stays open through pauses shorter than `hangoverMs`. The noise
+ * floor follows the quietest recent frames, quickly downward and slowly
+ * upward, so steady background noise is learnt instead of transcribed.
+ *
+ * Not thread-safe.
+ */
+class VoiceActivityDetector {
+public:
+    /**
+     * @throws std::invalid_argument for a frame outside 10..30 ms
+     */
+    explicit VoiceActivityDetector(VadOptions options = {}, std::unique_ptr<VadModel> model = nullptr);
+
+    /**
+     * Consume audio up to the end of the current segment
+     * @return Samples consumed: `count`, or fewer if a segment ended, in
+     *         which case the caller passes the rest again
+     */
+    size_t process(const float* samples, size_t count, VadOutput& out);
+
+    /**
+     * Close an open segment at the end of the stream
+     * @return true if a segment was open
+     */
+    bool flush();
+
+    void reset();
+
+    bool speaking() const { return speaking_; }
+    float noiseFloorDb() const { return floorDb_; }
+    const VadStats& stats() const { return stats_; }
+    size_t frameSamples() const { return frame_; }
+
+private:
+    const VadOptions options_;
+    const std::unique_ptr<VadModel> model_;
+    const size_t frame_;
+    const size_t historyFrames_;
+    const int hangoverFrames_;
+
+    std::vector<float> pending_; // partial frame
+    float previous_ = 0.0f;      // last sample of the previous frame
+
+    std::vector<float> history_; // ring of recent frames while silent, for the pre-roll
+    size_t historyHead_ = 0;
+    size_t historyCount_ = 0;
+
+    std::vector<float> levels_; // frame levels of the noise floor window, a ring
+    size_t levelCount_ = 0;
+    std::vector<float> features_; // model input, oldest frame first
+    float floorDb_;
+    int speechRun_ = 0;
+    int silentRun_ = 0;
+    bool speaking_ = false;
+    VadStats stats_;
+
+    bool classify(const float* frame);
+    void processFrame(const float* frame, VadOutput& out);
+    void remember(const float* frame);
+};
+
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_VOICE_ACTIVITY_DETECTOR_H
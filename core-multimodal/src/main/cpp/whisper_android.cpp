@@ -0,0 +1,182 @@
+#include <jni.h>
+#include <exception>
+#include <memory>
+#include <string>
+
+#include "jni_utils.h"
+#include "whisper.h"
+#include "whisper_stream.h"
+
+using iris::multimodal::StreamOptions;
+using iris::multimodal::StreamingTranscriber;
+
+namespace {
+
+StreamOptions streamOptions(JNIEnv* env, jstring language, jint step_ms) {
+    StreamOptions options;
+    iris::jni::JString code(env, language);
+    if (!code.is_null() && code.c_str()[0] != '\0') {
+        options.language = code.c_str();
+    }
+    if (step_ms > 0) {
+        options.stepMs = step_ms;
+    }
+    return options;
+}
+
+// Committed and tentative text into out[0] and out[1]; returns the confidence
+jfloat writeHypothesis(JNIEnv* env, const StreamingTranscriber& stream, jobjectArray out) {
+    const auto& hypothesis = stream.hypothesis();
+    jstring committed = iris::jni::create_jstring_lenient(env, hypothesis.committed);
+    jstring tentative = iris::jni::create_jstring_lenient(env, hypothesis.tentative);
+    env->SetObjectArrayElement(out, 0, committed);
+    env->SetObjectArrayElement(out, 1, tentative);
+    env->DeleteLocalRef(committed);
+    env->DeleteLocalRef(tentative);
+    return hypothesis.confidence;
+}
+
+} // namespace
+
+extern "C" {
+
+// ============================================================================
+// Model lifetime
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativeLoadWhisperModel(
+    JNIEnv* env, jobject thiz, jstring model_path) {
+
+    iris::jni::JString path(env, model_path);
+    if (path.is_null()) {
+        iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, "Model path is null");
+        return 0;
+    }
+
+    whisper_context_params params = whisper_context_default_params();
+    params.use_gpu = false;
+    whisper_context* context = whisper_init_from_file_with_params(path.c_str(), params);
+    if (!context) {
+        LOGE("Failed to load Whisper model: %s", path.c_str());
+        return 0;
+    }
+    LOGI("Whisper model loaded: %s", path.c_str());
+    return reinterpret_cast<jlong>(context);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativeUnloadWhisperModel(
+    JNIEnv* env, jobject thiz, jlong context_ptr) {
+
+    if (context_ptr != 0) {
+        whisper_free(reinterpret_cast<whisper_context*>(context_ptr));
+    }
+}
+
+// ============================================================================
+// One-shot transcription
+// ============================================================================
+
+JNIEXPORT jstring JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativeTranscribeAudio(
+    JNIEnv* env, jobject thiz, jlong context_ptr, jfloatArray audio_data, jstring language,
+    jfloatArray out_confidence) {
+
+    try {
+        auto* context = reinterpret_cast<whisper_context*>(context_ptr);
+        const StreamOptions options = streamOptions(env, language, 0);
+        iris::jni::JFloatArray samples(env, audio_data);
+        if (samples.is_null()) {
+            iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, "Audio data is null");
+            return nullptr;
+        }
+
+        float confidence = 0.0f;
+        const std::string text =
+            StreamingTranscriber::transcribe(context, options, samples.data(), samples.length(), &confidence);
+        if (out_confidence != nullptr && env->GetArrayLength(out_confidence) > 0) {
+            env->SetFloatArrayRegion(out_confidence, 0, 1, &confidence);
+        }
+        return iris::jni::create_jstring_lenient(env, text);
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeTranscribeAudio: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::RUNTIME, e.what());
+        return nullptr;
+    }
+}
+
+// ============================================================================
+// Streaming transcription
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativeOpenStream(
+    JNIEnv* env, jobject thiz, jlong context_ptr, jstring language, jint step_ms) {
+
+    try {
+        auto* context = reinterpret_cast<whisper_context*>(context_ptr);
+        auto stream = std::make_unique<StreamingTranscriber>(context, streamOptions(env, language, step_ms));
+        return reinterpret_cast<jlong>(stream.release());
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeOpenStream: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::RUNTIME, e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativePushStream(
+    JNIEnv* env, jobject thiz, jlong stream_ptr, jfloatArray samples, jint count) {
+
+    try {
+        auto* stream = reinterpret_cast<StreamingTranscriber*>(stream_ptr);
+        iris::jni::JFloatArray audio(env, samples);
+        if (audio.is_null() || count < 0 || count > audio.length()) {
+            iris::jni::throw_exception(env, iris::jni::exceptions::ILLEGAL_ARGUMENT, "Bad sample range");
+            return JNI_FALSE;
+        }
+        return stream->push(audio.data(), static_cast<size_t>(count)) ? JNI_TRUE : JNI_FALSE;
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativePushStream: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::RUNTIME, e.what());
+        return JNI_FALSE;
+    }
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativeStreamHypothesis(
+    JNIEnv* env, jobject thiz, jlong stream_ptr, jobjectArray out_text) {
+
+    return writeHypothesis(env, *reinterpret_cast<StreamingTranscriber*>(stream_ptr), out_text);
+}
+
+JNIEXPORT jfloat JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativeFinishStream(
+    JNIEnv* env, jobject thiz, jlong stream_ptr, jobjectArray out_text) {
+
+    try {
+        auto* stream = reinterpret_cast<StreamingTranscriber*>(stream_ptr);
+        stream->finish();
+        LOGI("Final text %.0f ms after end of speech (%zu decodes, %.0f ms decoding)", stream->stats().finishMs,
+             stream->stats().decodes, stream->stats().decodeMs);
+        return writeHypothesis(env, *stream, out_text);
+
+    } catch (const std::exception& e) {
+        LOGE("Exception in nativeFinishStream: %s", e.what());
+        iris::jni::throw_exception(env, iris::jni::exceptions::RUNTIME, e.what());
+        return 0.0f;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_multimodal_voice_SpeechToTextEngineImpl_nativeCloseStream(
+    JNIEnv* env, jobject thiz, jlong stream_ptr) {
+
+    delete reinterpret_cast<StreamingTranscriber*>(stream_ptr);
+}
+
+} // extern "C"
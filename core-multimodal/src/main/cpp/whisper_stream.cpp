@@ -0,0 +1,322 @@
+#include "whisper_stream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
+#define LOG_TAG "IrisWhisperStream"
+#if defined(__ANDROID__)
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define LOGI(...) (std::fprintf(stderr, LOG_TAG ": " __VA_ARGS__), std::fputc('\n', stderr))
+#define LOGE(...) LOGI(__VA_ARGS__)
+#endif
+
+namespace iris {
+namespace multimodal {
+
+namespace {
+
+constexpr int64_t kSamplesPerMs = WHISPER_SAMPLE_RATE / 1000;
+// Token times are in 10 ms units
+constexpr int64_t kSamplesPerTick = WHISPER_SAMPLE_RATE / 100;
+// The encoder halves the mel frame rate: one position per 20 ms, 1500 for 30 s
+constexpr size_t kSamplesPerPosition = 2 * WHISPER_HOP_LENGTH;
+constexpr int kMaxAudioContext = 1500;
+// Encoder positions past the end of the audio, so the last word is not cut off
+constexpr int kAudioContextMargin = 32;
+// Longest run of re-decoded committed tokens removed from the start of a decode
+constexpr size_t kMaxRepeatTokens = 5;
+
+double msSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+whisper_full_params baseParams(const StreamOptions& options) {
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.n_threads = options.threads > 0 ? options.threads : 4;
+    params.language = options.language.c_str();
+    params.detect_language = false;
+    params.translate = options.translate;
+    params.print_special = false;
+    params.print_progress = false;
+    params.print_realtime = false;
+    params.print_timestamps = false;
+    params.suppress_blank = true;
+    // No temperature fallback: a rejected greedy pass would double the latency of that step
+    params.temperature_inc = 0.0f;
+    return params;
+}
+
+bool endsSentence(const char* piece) {
+    const std::string text(piece);
+    const size_t last = text.find_last_not_of(" \"')");
+    return last != std::string::npos && (text[last] == '.' || text[last] == '?' || text[last] == '!');
+}
+
+} // namespace
+
+StreamingTranscriber::StreamingTranscriber(whisper_context* context, StreamOptions options)
+    : context_(context), state_(nullptr), options_(std::move(options)),
+      mel_(static_cast<size_t>(whisper_model_n_mels(context))) {
+    if (options_.language != "auto" && whisper_lang_id(options_.language.c_str()) < 0) {
+        throw std::invalid_argument("Unknown whisper language: " + options_.language);
+    }
+    if (options_.stepMs <= 0 || options_.trimMs <= 0 || options_.maxWindowMs <= options_.trimMs) {
+        throw std::invalid_argument("Stream needs stepMs > 0 and 0 < trimMs < maxWindowMs");
+    }
+    state_ = whisper_init_state(context_);
+    if (!state_) {
+        throw std::runtime_error("Failed to allocate whisper state");
+    }
+}
+
+StreamingTranscriber::~StreamingTranscriber() {
+    if (state_) {
+        whisper_free_state(state_);
+    }
+}
+
+bool StreamingTranscriber::push(const float* samples, size_t count) {
+    window_.insert(window_.end(), samples, samples + count);
+    mel_.update(window_.data(), window_.size());
+    sinceDecode_ += count;
+    if (sinceDecode_ < static_cast<size_t>(options_.stepMs * kSamplesPerMs)) {
+        return false;
+    }
+    sinceDecode_ = 0;
+
+    agree(decode());
+    if (window_.size() > static_cast<size_t>(options_.maxWindowMs * kSamplesPerMs)) {
+        // No agreement for a whole window; whisper would start to drop audio, so take what it has
+        commit(tentative_.data(), tentative_.size());
+        tentative_.clear();
+    }
+    trim();
+    bound();
+    updateTentative();
+    return true;
+}
+
+void StreamingTranscriber::finish() {
+    const auto start = std::chrono::steady_clock::now();
+    // Audio since the last decode may hold the last words; otherwise that decode already saw everything
+    if (sinceDecode_ > 0 && !window_.empty()) {
+        tentative_ = unseen(decode());
+    }
+    commit(tentative_.data(), tentative_.size());
+    tentative_.clear();
+
+    windowStart_ += static_cast<int64_t>(window_.size());
+    window_.clear();
+    mel_.reset();
+    sinceDecode_ = 0;
+    promptEnd_ = committed_.size();
+    updateTentative();
+
+    stats_.finishMs = msSince(start);
+    LOGI("Stream finished in %.0f ms after %zu decodes", stats_.finishMs, stats_.decodes);
+}
+
+void StreamingTranscriber::reset() {
+    window_.clear();
+    windowStart_ = 0;
+    mel_.reset();
+    sinceDecode_ = 0;
+    committed_.clear();
+    promptEnd_ = 0;
+    tentative_.clear();
+    probabilitySum_ = 0.0;
+    hypothesis_ = StreamHypothesis();
+    stats_ = StreamStats();
+}
+
+std::string StreamingTranscriber::transcribe(whisper_context* context, const StreamOptions& options,
+                                             const float* samples, size_t count, float* confidence) {
+    whisper_state* state = whisper_init_state(context);
+    if (!state) {
+        throw std::runtime_error("Failed to allocate whisper state");
+    }
+    whisper_full_params params = baseParams(options);
+    if (whisper_full_with_state(context, state, params, samples, static_cast<int>(count)) != 0) {
+        whisper_free_state(state);
+        throw std::runtime_error("Whisper failed to transcribe audio");
+    }
+
+    std::string text;
+    double probabilitySum = 0.0;
+    size_t tokens = 0;
+    const whisper_token eot = whisper_token_eot(context);
+    const int segments = whisper_full_n_segments_from_state(state);
+    for (int s = 0; s < segments; s++) {
+        text += whisper_full_get_segment_text_from_state(state, s);
+        const int n = whisper_full_n_tokens_from_state(state, s);
+        for (int t = 0; t < n; t++) {
+            const whisper_token_data data = whisper_full_get_token_data_from_state(state, s, t);
+            if (data.id < eot) {
+                probabilitySum += data.p;
+                tokens++;
+            }
+        }
+    }
+    whisper_free_state(state);
+
+    if (confidence) {
+        *confidence = tokens > 0 ? static_cast<float>(probabilitySum / tokens) : 0.0f;
+    }
+    return text;
+}
+
+std::vector<StreamingTranscriber::Token> StreamingTranscriber::decode() {
+    whisper_full_params params = baseParams(options_);
+    params.no_context = true; // the prompt is given explicitly below
+    params.token_timestamps = true;
+
+    std::vector<whisper_token> prompt;
+    const size_t promptTokens = static_cast<size_t>(std::max(options_.promptTokens, 0));
+    for (size_t i = promptEnd_ > promptTokens ? promptEnd_ - promptTokens : 0; i < promptEnd_; i++) {
+        prompt.push_back(committed_[i].id);
+    }
+    params.prompt_tokens = prompt.empty() ? nullptr : prompt.data();
+    params.prompt_n_tokens = static_cast<int>(prompt.size());
+
+    if (options_.shrinkAudioContext) {
+        const size_t positions = (window_.size() + kSamplesPerPosition - 1) / kSamplesPerPosition;
+        params.audio_ctx = std::min(kMaxAudioContext, static_cast<int>(positions) + kAudioContextMargin);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    // The encoder reads 2 * audio_ctx frames from the seek position; past the audio they must hold whisper's padding
+    const int audioContext = params.audio_ctx > 0 ? params.audio_ctx : kMaxAudioContext;
+    const size_t columns = window_.size() / WHISPER_HOP_LENGTH + 2 * static_cast<size_t>(audioContext);
+    const size_t frames = mel_.whisperInput(window_.data(), window_.size(), columns, melInput_);
+    if (whisper_set_mel_with_state(context_, state_, melInput_.data(), static_cast<int>(columns),
+                                   static_cast<int>(mel_.melBands())) != 0) {
+        throw std::runtime_error("Whisper rejected the stream's mel input");
+    }
+    // With a precomputed mel whisper takes all columns as audio; the duration stops it at the real end
+    params.duration_ms = static_cast<int>(frames * 10);
+    if (whisper_full_with_state(context_, state_, params, nullptr, 0) != 0) {
+        LOGE("Whisper decode failed on a %zu-sample window", window_.size());
+        throw std::runtime_error("Whisper failed to decode the stream window");
+    }
+    stats_.decodes++;
+    stats_.samplesDecoded += window_.size();
+    stats_.decodeMs += msSince(start);
+
+    std::vector<Token> tokens;
+    const whisper_token eot = whisper_token_eot(context_);
+    const int64_t offset = windowStart_ / kSamplesPerTick;
+    const int segments = whisper_full_n_segments_from_state(state_);
+    for (int s = 0; s < segments; s++) {
+        const int n = whisper_full_n_tokens_from_state(state_, s);
+        for (int t = 0; t < n; t++) {
+            const whisper_token_data data = whisper_full_get_token_data_from_state(state_, s, t);
+            if (data.id < eot) { // timestamps and other specials are not text
+                tokens.push_back({data.id, offset + data.t0, offset + data.t1, data.p});
+            }
+        }
+    }
+    return tokens;
+}
+
+std::vector<StreamingTranscriber::Token> StreamingTranscriber::unseen(std::vector<Token> current) const {
+    // The window still holds audio of committed tokens; drop what lies before the committed end
+    const int64_t end = committedEnd();
+    size_t first = 0;
+    while (first < current.size() && (current[first].t0 + current[first].t1) / 2 <= end) {
+        first++;
+    }
+    current.erase(current.begin(), current.begin() + first);
+
+    // Token times are approximate, so a committed word can still come back at the boundary
+    const size_t inWindow = committed_.size() - promptEnd_;
+    for (size_t n = std::min({kMaxRepeatTokens, inWindow, current.size()}); n > 0; n--) {
+        if (std::equal(current.begin(), current.begin() + n, committed_.end() - n,
+                       [](const Token& a, const Token& b) { return a.id == b.id; })) {
+            current.erase(current.begin(), current.begin() + n);
+            break;
+        }
+    }
+    return current;
+}
+
+void StreamingTranscriber::agree(std::vector<Token> current) {
+    current = unseen(std::move(current));
+    size_t agreed = 0;
+    while (agreed < current.size() && agreed < tentative_.size() && current[agreed].id == tentative_[agreed].id) {
+        agreed++;
+    }
+    commit(current.data(), agreed);
+    tentative_.assign(current.begin() + agreed, current.end());
+}
+
+void StreamingTranscriber::commit(const Token* tokens, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        committed_.push_back(tokens[i]);
+        probabilitySum_ += tokens[i].p;
+    }
+    hypothesis_.committed += text(tokens, count);
+    hypothesis_.confidence = committed_.empty() ? 0.0f : static_cast<float>(probabilitySum_ / committed_.size());
+}
+
+void StreamingTranscriber::trim() {
+    if (window_.size() <= static_cast<size_t>(options_.trimMs * kSamplesPerMs) || promptEnd_ == committed_.size()) {
+        return;
+    }
+    // Cut after the last committed sentence so the next decode starts on a clean boundary
+    size_t cut = committed_.size() - 1;
+    for (size_t i = committed_.size(); i > promptEnd_; i--) {
+        if (endsSentence(whisper_token_to_str(context_, committed_[i - 1].id))) {
+            cut = i - 1;
+            break;
+        }
+    }
+    const int64_t samples = committed_[cut].t1 * kSamplesPerTick - windowStart_;
+    if (samples <= 0) {
+        return;
+    }
+    dropFront(std::min(static_cast<size_t>(samples), window_.size()));
+    promptEnd_ = cut + 1;
+}
+
+void StreamingTranscriber::bound() {
+    const size_t maxSamples = static_cast<size_t>(options_.maxWindowMs * kSamplesPerMs);
+    if (window_.size() <= maxSamples) {
+        return;
+    }
+    // Nothing committed to cut at (no tokens, or none agreed, as with noise past the VAD):
+    // drop the oldest audio anyway so decodes stay short, keeping trimMs of context
+    dropFront(window_.size() - static_cast<size_t>(options_.trimMs * kSamplesPerMs));
+    while (promptEnd_ < committed_.size() && committed_[promptEnd_].t1 * kSamplesPerTick <= windowStart_) {
+        promptEnd_++;
+    }
+}
+
+void StreamingTranscriber::dropFront(size_t samples) {
+    window_.erase(window_.begin(), window_.begin() + samples);
+    mel_.discard(samples);
+    windowStart_ += static_cast<int64_t>(samples);
+}
+
+void StreamingTranscriber::updateTentative() {
+    hypothesis_.tentative = text(tentative_.data(), tentative_.size());
+}
+
+int64_t StreamingTranscriber::committedEnd() const {
+    return committed_.empty() ? 0 : committed_.back().t1;
+}
+
+std::string StreamingTranscriber::text(const Token* tokens, size_t count) const {
+    std::string result;
+    for (size_t i = 0; i < count; i++) {
+        result += whisper_token_to_str(context_, tokens[i].id);
+    }
+    return result;
+}
+
+} // namespace multimodal
+} // namespace iris
@@ -0,0 +1,150 @@
+#ifndef IRIS_MULTIMODAL_WHISPER_STREAM_H
+#define IRIS_MULTIMODAL_WHISPER_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "log_mel.h"
+#include "whisper.h"
+
+namespace iris {
+namespace multimodal {
+
+struct StreamOptions {
+    std::string language = "en";
+    int threads = 4;
+    bool translate = false;
+    // Decode again once this much audio has arrived since the last decode
+    int stepMs = 400;
+    // Drop committed audio from the window once it is longer than this
+    int trimMs = 4000;
+    // Commit the whole hypothesis if nothing has been agreed for this long, and never let
+    // the window grow past it (audio beyond trimMs is dropped); below whisper's 30 s
+    int maxWindowMs = 24000;
+    // Committed tokens that scrolled out of the window, passed back as the decoder prompt
+    int promptTokens = 96;
+    // Run the encoder over the window only instead of a padded 30 s
+    bool shrinkAudioContext = true;
+};
+
+struct StreamHypothesis {
+    std::string committed; // settled text; later decodes never change it
+    std::string tentative; // the rest of the latest decode, which may still change
+    float confidence = 0.0f; // mean probability of the committed tokens
+};
+
+struct StreamStats {
+    size_t decodes = 0;
+    size_t samplesDecoded = 0; // total window length over all decodes
+    double decodeMs = 0.0;
+    double finishMs = 0.0; // time spent in the last finish()
+};
+
+/**
+ * Transcribes 16 kHz mono audio while it is being recorded.
+ *
+ * Audio accumulates in a window. Every `stepMs` of new audio the window is
+ * decoded again, with the encoder sized to the window rather than whisper's
+ * padded 30 s. A token is committed once two consecutive decodes agree on it
+ * (local agreement), so the committed text only ever grows; the unagreed rest
+ * is reported as tentative. Committed audio is trimmed off the window at a
+ * sentence end where possible, and the committed tokens that left the window
+ * are fed back as the prompt so the decoder keeps the context without
+ * re-reading the audio.
+ *
+ * The log-mel input is computed natively as audio arrives (LogMelSpectrogram)
+ * and handed to whisper, so a decode only adds the frames at the end of the
+ * window instead of whisper recomputing the window and its 30 s of padding.
+ *
+ * One whisper_state is allocated up front and reused by every decode. At end
+ * of speech finish() decodes only what is left in the window, which trimming
+ * keeps to a few seconds, so the final text costs one short decode.
+ *
+ * Not thread-safe; the model may be shared with other transcribers.
+ */
+class StreamingTranscriber {
+public:
+    /**
+     * @param context Loaded model; must outlive the transcriber
+     * @throws std::runtime_error if the decoder state cannot be allocated
+     */
+    StreamingTranscriber(whisper_context* context, StreamOptions options);
+    ~StreamingTranscriber();
+
+    StreamingTranscriber(const StreamingTranscriber&) = delete;
+    StreamingTranscriber& operator=(const StreamingTranscriber&) = delete;
+
+    /**
+     * Append samples; decodes when a step of new audio is complete
+     * @return true if a decode ran and hypothesis() may have changed
+     * @throws std::runtime_error if whisper fails
+     */
+    bool push(const float* samples, size_t count);
+
+    /**
+     * End of speech: decode the rest of the window and commit all of it.
+     * The transcriber can take new audio afterwards; the transcript continues.
+     */
+    void finish();
+
+    /**
+     * Forget all audio and text
+     */
+    void reset();
+
+    const StreamHypothesis& hypothesis() const { return hypothesis_; }
+    const StreamStats& stats() const { return stats_; }
+
+    /**
+     * Decode a whole recording in one call; whisper slides its own 30 s
+     * windows over longer audio
+     * @param confidence Receives the mean token probability; may be null
+     */
+    static std::string transcribe(whisper_context* context, const StreamOptions& options, const float* samples,
+                                  size_t count, float* confidence);
+
+private:
+    // A decoded text token; times are absolute, in whisper's 10 ms units
+    struct Token {
+        whisper_token id;
+        int64_t t0;
+        int64_t t1;
+        float p;
+    };
+
+    whisper_context* context_;
+    whisper_state* state_;
+    const StreamOptions options_;
+
+    std::vector<float> window_;
+    int64_t windowStart_ = 0; // absolute sample index of window_[0]
+    LogMelSpectrogram mel_;
+    std::vector<float> melInput_;
+    size_t sinceDecode_ = 0;
+
+    std::vector<Token> committed_;
+    size_t promptEnd_ = 0; // committed_[0, promptEnd_) lie before the window
+    std::vector<Token> tentative_;
+    double probabilitySum_ = 0.0;
+
+    StreamHypothesis hypothesis_;
+    StreamStats stats_;
+
+    std::vector<Token> decode();
+    std::vector<Token> unseen(std::vector<Token> current) const;
+    void agree(std::vector<Token> current);
+    void commit(const Token* tokens, size_t count);
+    void trim();
+    void bound();
+    void dropFront(size_t samples);
+    void updateTentative();
+    int64_t committedEnd() const;
+    std::string text(const Token* tokens, size_t count) const;
+};
+
+} // namespace multimodal
+} // namespace iris
+
+#endif // IRIS_MULTIMODAL_WHISPER_STREAM_H
@@ -6,6 +6,10 @@ import java.util.concurrent.atomic.AtomicInteger
 /**
  * Audio buffer pool for efficient memory management
  * Reduces GC pressure by reusing audio buffers
+ *
+ * Native capture and playback do not go through this pool: they share a
+ * [NativeAudioRing] with AudioRecord/AudioTrack instead of copying arrays
+ * across JNI.
  */
 class AudioBufferPool(
     private val bufferSize: Int,
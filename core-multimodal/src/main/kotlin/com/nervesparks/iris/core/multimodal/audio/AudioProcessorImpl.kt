@@ -2,6 +2,7 @@ package com.nervesparks.iris.core.multimodal.audio
 
 import android.content.Context
 import android.media.AudioFormat as AndroidAudioFormat
+import android.media.AudioManager
 import android.media.AudioRecord
 import android.media.AudioTrack
 import android.media.MediaRecorder
@@ -11,20 +12,29 @@ import com.nervesparks.iris.core.multimodal.voice.AudioConfig
 import com.nervesparks.iris.core.multimodal.voice.AudioProcessor
 import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.FlowCollector
 import kotlinx.coroutines.flow.flow
 import kotlinx.coroutines.isActive
 import kotlinx.coroutines.withContext
 import java.io.File
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
+import java.util.concurrent.atomic.AtomicBoolean
 import javax.inject.Inject
 import javax.inject.Singleton
+import kotlin.concurrent.thread
 import kotlin.coroutines.coroutineContext
 import kotlin.math.sqrt
 
 /**
  * Implementation of AudioProcessor using Android AudioRecord and AudioTrack APIs
+ *
+ * With the native library, mono capture and all playback run at the device's
+ * own sample rate and are resampled, converted and cleaned up natively
+ * ([NativeCaptureChain], [NativePlaybackChain]); otherwise the Kotlin loops
+ * below do the same work at the requested rate.
  */
 @Singleton
 class AudioProcessorImpl @Inject constructor(
@@ -34,6 +44,25 @@ class AudioProcessorImpl @Inject constructor(
     companion object {
         private const val TAG = "AudioProcessor"
         private const val BUFFER_SIZE_MULTIPLIER = 4
+        private const val PLAYBACK_BLOCK = 4096 // samples rendered per AudioTrack write
+        private const val FALLBACK_DEVICE_RATE = 48000
+        private const val CAPTURE_RING_SECONDS = 4
+        private const val PLAYBACK_RING_SECONDS = 1
+        private const val CAPTURE_POLL_MS = 5L
+        private const val PLAYBACK_POLL_MS = 5L
+
+        // Native library loading - only loads if library exists
+        private var nativeLibraryLoaded = false
+
+        init {
+            try {
+                System.loadLibrary("iris_multimodal")
+                nativeLibraryLoaded = true
+            } catch (e: UnsatisfiedLinkError) {
+                Log.w(TAG, "Native multimodal library not available, using Kotlin audio processing", e)
+                nativeLibraryLoaded = false
+            }
+        }
     }
     
     private var audioRecord: AudioRecord? = null
@@ -51,15 +80,19 @@ class AudioProcessorImpl @Inject constructor(
         } else {
             AndroidAudioFormat.CHANNEL_IN_STEREO
         }
+
+        // Record at the device's rate and resample natively, so the platform does not resample first
+        val useNative = nativeLibraryLoaded && channels == 1
+        val recordRate = if (useNative) deviceSampleRate() else sampleRate
         
         val bufferSize = AudioRecord.getMinBufferSize(
-            sampleRate,
+            recordRate,
             channelConfig,
             AndroidAudioFormat.ENCODING_PCM_16BIT
         ) * BUFFER_SIZE_MULTIPLIER
         
         if (bufferSize <= 0) {
-            Log.e(TAG, "Invalid buffer size: $bufferSize for sample rate $sampleRate")
+            Log.e(TAG, "Invalid buffer size: $bufferSize for sample rate $recordRate")
             emit(AudioData.Error("Invalid buffer size for recording. Device may not support this sample rate."))
             return@flow
         }
@@ -73,7 +106,7 @@ class AudioProcessorImpl @Inject constructor(
             try {
                 audioRecord = AudioRecord(
                     MediaRecorder.AudioSource.MIC,
-                    sampleRate,
+                    recordRate,
                     channelConfig,
                     AndroidAudioFormat.ENCODING_PCM_16BIT,
                     bufferSize
@@ -128,29 +161,11 @@ class AudioProcessorImpl @Inject constructor(
         try {
             audioRecord?.startRecording()
             isRecording = true
-            
-            val buffer = ShortArray(bufferSize / 2)
-            
-            while (coroutineContext.isActive && isRecording) {
-                val readResult = audioRecord?.read(buffer, 0, buffer.size) ?: -1
-                
-                if (readResult > 0) {
-                    // Convert short samples to float
-                    val floatSamples = FloatArray(readResult) { index ->
-                        buffer[index] / 32768.0f
-                    }
-                    
-                    // Apply audio processing if enabled
-                    val processedSamples = if (config.noiseReduction || config.automaticGainControl) {
-                        applyAudioProcessing(floatSamples, config)
-                    } else {
-                        floatSamples
-                    }
-                    
-                    emit(AudioData.Chunk(processedSamples, System.currentTimeMillis()))
-                } else if (readResult < 0) {
-                    Log.w(TAG, "Error reading audio: $readResult")
-                }
+
+            if (useNative) {
+                recordNative(recordRate, sampleRate, bufferSize / 2, config)
+            } else {
+                recordKotlin(bufferSize / 2, config)
             }
             
             emit(AudioData.Ended)
@@ -163,6 +178,112 @@ class AudioProcessorImpl @Inject constructor(
         }
     }
     
+    private suspend fun FlowCollector<AudioData>.recordKotlin(frames: Int, config: AudioConfig) {
+        val buffer = ShortArray(frames)
+
+        while (coroutineContext.isActive && isRecording) {
+            val readResult = audioRecord?.read(buffer, 0, buffer.size) ?: -1
+
+            if (readResult > 0) {
+                // Convert short samples to float
+                val floatSamples = FloatArray(readResult) { index ->
+                    buffer[index] / 32768.0f
+                }
+
+                // Apply audio processing if enabled
+                val processedSamples = if (config.noiseReduction || config.automaticGainControl) {
+                    applyAudioProcessing(floatSamples, config)
+                } else {
+                    floatSamples
+                }
+
+                emit(AudioData.Chunk(processedSamples, System.currentTimeMillis()))
+            } else if (readResult < 0) {
+                Log.w(TAG, "Error reading audio: $readResult")
+            }
+        }
+    }
+
+    /**
+     * AudioRecord is drained on its own thread straight into a native ring, so a slow
+     * consumer (a whisper decode) costs ring space rather than dropped microphone
+     * buffers; the chain converts and processes the PCM where it was written
+     */
+    private suspend fun FlowCollector<AudioData>.recordNative(
+        deviceRate: Int,
+        outputRate: Int,
+        frames: Int,
+        config: AudioConfig
+    ) {
+        val processing = config.noiseReduction || config.automaticGainControl
+        NativeCaptureChain(deviceRate, outputRate).use { chain ->
+            NativeAudioRing(deviceRate * CAPTURE_RING_SECONDS, Short.SIZE_BYTES).use { ring ->
+                val out = chain.outputBuffer(frames)
+                val samples = out.asFloatBuffer()
+                val running = AtomicBoolean(true)
+                val reader = thread(name = "IrisAudioCapture") { readIntoRing(ring, frames, running) }
+
+                try {
+                    while (coroutineContext.isActive && (isRecording || ring.available > 0)) {
+                        // Keep the chunks the size AudioRecord reads; after stopping, flush what is left
+                        if (ring.available < frames && isRecording) {
+                            delay(CAPTURE_POLL_MS)
+                            continue
+                        }
+                        val written = chain.process(
+                            ring,
+                            frames,
+                            out,
+                            noiseGate = config.noiseReduction,
+                            gainControl = config.automaticGainControl,
+                            echoSuppression = processing && config.echoCancellation
+                        )
+                        if (written > 0) {
+                            val chunk = FloatArray(written)
+                            samples.position(0)
+                            samples.get(chunk)
+                            emit(AudioData.Chunk(chunk, System.currentTimeMillis()))
+                        }
+                    }
+                } finally {
+                    running.set(false)
+                    reader.join()
+                    val stats = ring.stats()
+                    Log.i(TAG, "Capture ring: ${stats.framesWritten} frames, ${stats.overrunFrames} dropped")
+                }
+            }
+        }
+    }
+
+    private fun readIntoRing(ring: NativeAudioRing, frames: Int, running: AtomicBoolean) {
+        val spill = ByteBuffer.allocateDirect(frames * Short.SIZE_BYTES)
+        while (running.get()) {
+            val record = audioRecord ?: break
+            val region = ring.writable(frames)
+            // With the ring full, keep the microphone drained and count what is lost
+            val target = region ?: spill.apply { clear() }
+            val bytesRead = record.read(target, target.capacity())
+            if (bytesRead > 0) {
+                if (region != null) {
+                    ring.commitWrite(bytesRead / Short.SIZE_BYTES)
+                } else {
+                    ring.reportOverrun(bytesRead / Short.SIZE_BYTES)
+                }
+            } else if (bytesRead < 0) {
+                Log.w(TAG, "Error reading audio: $bytesRead")
+                if (bytesRead == AudioRecord.ERROR_INVALID_OPERATION || bytesRead == AudioRecord.ERROR_DEAD_OBJECT) {
+                    break
+                }
+            }
+        }
+    }
+
+    private fun deviceSampleRate(): Int {
+        val audioManager = context.getSystemService(Context.AUDIO_SERVICE) as? AudioManager
+        return audioManager?.getProperty(AudioManager.PROPERTY_OUTPUT_SAMPLE_RATE)?.toIntOrNull()
+            ?: FALLBACK_DEVICE_RATE
+    }
+    
     override suspend fun stopRecording() {
         isRecording = false
         try {
@@ -179,8 +300,12 @@ class AudioProcessorImpl @Inject constructor(
         sampleRate: Int
     ): Result<Unit> = withContext(Dispatchers.IO) {
         try {
+            // Play at the device's rate, resampled and dithered natively, so the mixer passes it through
+            val useNative = nativeLibraryLoaded
+            val trackRate = if (useNative) deviceSampleRate() else sampleRate
+
             val bufferSize = AudioTrack.getMinBufferSize(
-                sampleRate,
+                trackRate,
                 AndroidAudioFormat.CHANNEL_OUT_MONO,
                 AndroidAudioFormat.ENCODING_PCM_16BIT
             )
@@ -192,7 +317,7 @@ class AudioProcessorImpl @Inject constructor(
             audioTrack = AudioTrack.Builder()
                 .setAudioFormat(
                     android.media.AudioFormat.Builder()
-                        .setSampleRate(sampleRate)
+                        .setSampleRate(trackRate)
                         .setChannelMask(AndroidAudioFormat.CHANNEL_OUT_MONO)
                         .setEncoding(AndroidAudioFormat.ENCODING_PCM_16BIT)
                         .build()
@@ -204,15 +329,19 @@ class AudioProcessorImpl @Inject constructor(
                 return@withContext Result.failure(VoiceException("Failed to initialize AudioTrack"))
             }
             
-            // Convert float samples to short
-            val shortBuffer = ShortArray(audioData.size) { index ->
-                (audioData[index] * 32767.0f).toInt().coerceIn(-32768, 32767).toShort()
-            }
-            
             audioTrack?.play()
             isPlaying = true
-            
-            audioTrack?.write(shortBuffer, 0, shortBuffer.size)
+
+            if (useNative) {
+                writeNative(audioData, sampleRate, trackRate)
+            } else {
+                // Convert float samples to short
+                val shortBuffer = ShortArray(audioData.size) { index ->
+                    (audioData[index] * 32767.0f).toInt().coerceIn(-32768, 32767).toShort()
+                }
+
+                audioTrack?.write(shortBuffer, 0, shortBuffer.size)
+            }
             
             // Wait for playback to complete
             while (audioTrack?.playState == AudioTrack.PLAYSTATE_PLAYING && isPlaying) {
@@ -229,6 +358,62 @@ class AudioProcessorImpl @Inject constructor(
         }
     }
     
+    /**
+     * Render into a native ring while a writer thread drains it into the AudioTrack,
+     * so the track is fed from the ring's memory and synthesis never waits on a write
+     */
+    private fun writeNative(audioData: FloatArray, sourceRate: Int, deviceRate: Int) {
+        NativePlaybackChain(sourceRate, deviceRate).use { chain ->
+            val capacity = maxOf(deviceRate * PLAYBACK_RING_SECONDS, 2 * chain.maxOutput(PLAYBACK_BLOCK))
+            NativeAudioRing(capacity, Short.SIZE_BYTES).use { ring ->
+                val rendered = AtomicBoolean(false)
+                val writer = thread(name = "IrisAudioPlayback") { drainRing(ring, rendered) }
+
+                try {
+                    var offset = 0
+                    do {
+                        val count = minOf(PLAYBACK_BLOCK, audioData.size - offset)
+                        val end = offset + count == audioData.size
+                        while (chain.render(audioData, offset, count, end, ring) < 0) {
+                            if (!isPlaying || !writer.isAlive) return
+                            Thread.sleep(PLAYBACK_POLL_MS)
+                        }
+                        offset += count
+                    } while (offset < audioData.size && isPlaying)
+                } finally {
+                    rendered.set(true)
+                    writer.join()
+                    val stats = ring.stats()
+                    Log.i(TAG, "Playback ring: ${stats.framesRead} frames, ${stats.underruns} underruns")
+                }
+            }
+        }
+    }
+
+    private fun drainRing(ring: NativeAudioRing, rendered: AtomicBoolean) {
+        try {
+            while (isPlaying) {
+                val region = ring.readable(PLAYBACK_BLOCK)
+                if (region == null) {
+                    // Check the flag first: everything rendered before it was set is in the ring
+                    if (rendered.get() && ring.available == 0) break
+                    if (ring.stats().framesRead > 0) ring.reportUnderrun()
+                    Thread.sleep(PLAYBACK_POLL_MS)
+                    continue
+                }
+                val track = audioTrack ?: break
+                val bytesWritten = track.write(region, region.remaining(), AudioTrack.WRITE_BLOCKING)
+                if (bytesWritten < 0) {
+                    Log.w(TAG, "Error writing audio: $bytesWritten")
+                    break
+                }
+                ring.commitRead(bytesWritten / Short.SIZE_BYTES)
+            }
+        } catch (e: IllegalStateException) {
+            Log.w(TAG, "Playback stopped while writing", e)
+        }
+    }
+    
     override suspend fun stopPlayback() {
         isPlaying = false
         try {
@@ -0,0 +1,128 @@
+package com.nervesparks.iris.core.multimodal.audio
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Native capture path (libiris_multimodal): PCM16 from the microphone at the
+ * device's rate becomes float at the requested rate, then the same noise gate,
+ * AGC and echo suppression as [AudioProcessorImpl]'s Kotlin fallback, in place.
+ *
+ * The PCM is read where AudioRecord wrote it, in a [NativeAudioRing], and the
+ * output buffer is direct and reused, so a chunk costs no JVM allocation until
+ * the caller copies the result out. Requires the native library to be loaded;
+ * not thread-safe.
+ */
+internal class NativeCaptureChain(deviceRate: Int, outputRate: Int) : AutoCloseable {
+
+    private var handle = nativeCreate(deviceRate, outputRate)
+
+    /**
+     * Direct buffer for the output of [frames] input samples
+     */
+    fun outputBuffer(frames: Int): ByteBuffer {
+        check(handle != 0L) { "NativeCaptureChain is closed" }
+        return directBuffer(nativeMaxOutput(handle, frames) * Float.SIZE_BYTES)
+    }
+
+    /**
+     * Consume up to [maxFrames] PCM16 samples from [ring] and process them into [out]
+     * @return Samples written to [out]
+     */
+    fun process(
+        ring: NativeAudioRing,
+        maxFrames: Int,
+        out: ByteBuffer,
+        noiseGate: Boolean,
+        gainControl: Boolean,
+        echoSuppression: Boolean
+    ): Int {
+        check(handle != 0L && ring.handle != 0L) { "NativeCaptureChain or its ring is closed" }
+        return nativeProcess(handle, ring.handle, maxFrames, out, noiseGate, gainControl, echoSuppression)
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(deviceRate: Int, outputRate: Int): Long
+
+    private external fun nativeMaxOutput(handle: Long, count: Int): Int
+
+    private external fun nativeProcess(
+        handle: Long,
+        ring: Long,
+        maxFrames: Int,
+        out: ByteBuffer,
+        noiseGate: Boolean,
+        gainControl: Boolean,
+        echoSuppression: Boolean
+    ): Int
+
+    private external fun nativeDestroy(handle: Long)
+}
+
+/**
+ * Native playback path (libiris_multimodal): float audio at the voice's rate
+ * becomes dithered PCM16 at the device's rate, so the mixer does not resample
+ * it again. It is rendered straight into a [NativeAudioRing] that AudioTrack
+ * drains. Requires the native library to be loaded; not thread-safe.
+ */
+internal class NativePlaybackChain(sourceRate: Int, deviceRate: Int) : AutoCloseable {
+
+    private var handle = nativeCreate(sourceRate, deviceRate)
+
+    /**
+     * Most PCM16 samples [render] can write for [frames] input samples
+     */
+    fun maxOutput(frames: Int): Int {
+        check(handle != 0L) { "NativePlaybackChain is closed" }
+        return nativeMaxOutput(handle, frames)
+    }
+
+    /**
+     * Render samples[offset, offset + count) into [ring]; [end] flushes the
+     * resampler after the last block
+     * @return Samples written to [ring], or -1 if it has no room for the block yet
+     */
+    fun render(
+        samples: FloatArray,
+        offset: Int,
+        count: Int,
+        end: Boolean,
+        ring: NativeAudioRing,
+        dither: Boolean = true
+    ): Int {
+        check(handle != 0L && ring.handle != 0L) { "NativePlaybackChain or its ring is closed" }
+        return nativeRender(handle, samples, offset, count, end, dither, ring.handle)
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(sourceRate: Int, deviceRate: Int): Long
+
+    private external fun nativeMaxOutput(handle: Long, count: Int): Int
+
+    private external fun nativeRender(
+        handle: Long,
+        samples: FloatArray,
+        offset: Int,
+        count: Int,
+        end: Boolean,
+        dither: Boolean,
+        ring: Long
+    ): Int
+
+    private external fun nativeDestroy(handle: Long)
+}
+
+private fun directBuffer(bytes: Int): ByteBuffer =
+    ByteBuffer.allocateDirect(bytes).order(ByteOrder.nativeOrder())
@@ -0,0 +1,134 @@
+package com.nervesparks.iris.core.multimodal.audio
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Lock-free single-producer single-consumer audio ring in native memory
+ * (libiris_multimodal)
+ *
+ * The storage is mapped as one direct ByteBuffer, so AudioRecord can read into
+ * a region and AudioTrack can write from one while native code processes the
+ * same memory in place; nothing is copied across JNI. Regions are contiguous,
+ * so a wrap around the end of the ring takes two of them.
+ *
+ * One thread may write and one other thread may read at the same time. Close
+ * the ring only after both have stopped.
+ *
+ * @param capacityFrames Rounded up to a power of two
+ * @param frameBytes 2 for PCM16, 4 for float
+ */
+internal class NativeAudioRing(capacityFrames: Int, private val frameBytes: Int) : AutoCloseable {
+
+    internal var handle = nativeCreate(capacityFrames, frameBytes)
+        private set
+
+    private val storage: ByteBuffer = nativeBuffer(handle).order(ByteOrder.nativeOrder())
+    private val writeRegion = IntArray(2)
+    private val readRegion = IntArray(2)
+
+    val capacity: Int = nativeCapacity(handle)
+
+    /**
+     * Frames ready for the consumer
+     */
+    val available: Int
+        get() = nativeAvailable(checkOpen())
+
+    /**
+     * Producer: free space at the write position as a buffer view, or null if
+     * the ring is full. Fill it, then [commitWrite] the frames written.
+     */
+    fun writable(maxFrames: Int): ByteBuffer? {
+        nativeWritable(checkOpen(), maxFrames, writeRegion)
+        return view(writeRegion)
+    }
+
+    fun commitWrite(frames: Int) = nativeCommitWrite(checkOpen(), frames)
+
+    /**
+     * Producer: frames lost because the ring was full
+     */
+    fun reportOverrun(frames: Int) = nativeReportOverrun(checkOpen(), frames)
+
+    /**
+     * Consumer: audio at the read position as a buffer view, or null if the
+     * ring is empty. Use it, then [commitRead] the frames consumed.
+     */
+    fun readable(maxFrames: Int): ByteBuffer? {
+        nativeReadable(checkOpen(), maxFrames, readRegion)
+        return view(readRegion)
+    }
+
+    fun commitRead(frames: Int) = nativeCommitRead(checkOpen(), frames)
+
+    /**
+     * Consumer: audio was needed and the ring was empty
+     */
+    fun reportUnderrun() = nativeReportUnderrun(checkOpen())
+
+    fun stats(): AudioRingStats {
+        val values = LongArray(4)
+        nativeStats(checkOpen(), values)
+        return AudioRingStats(values[0], values[1], values[2], values[3])
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private fun checkOpen(): Long {
+        check(handle != 0L) { "NativeAudioRing is closed" }
+        return handle
+    }
+
+    private fun view(region: IntArray): ByteBuffer? {
+        if (region[1] == 0) return null
+        val start = region[0] * frameBytes
+        return storage.duplicate()
+            .apply {
+                position(start)
+                limit(start + region[1] * frameBytes)
+            }
+            .slice()
+            .order(ByteOrder.nativeOrder())
+    }
+
+    private external fun nativeCreate(capacityFrames: Int, frameBytes: Int): Long
+
+    private external fun nativeBuffer(handle: Long): ByteBuffer
+
+    private external fun nativeCapacity(handle: Long): Int
+
+    private external fun nativeWritable(handle: Long, maxFrames: Int, outRegion: IntArray)
+
+    private external fun nativeCommitWrite(handle: Long, frames: Int)
+
+    private external fun nativeReadable(handle: Long, maxFrames: Int, outRegion: IntArray)
+
+    private external fun nativeCommitRead(handle: Long, frames: Int)
+
+    private external fun nativeAvailable(handle: Long): Int
+
+    private external fun nativeReportOverrun(handle: Long, frames: Int)
+
+    private external fun nativeReportUnderrun(handle: Long)
+
+    private external fun nativeStats(handle: Long, outStats: LongArray)
+
+    private external fun nativeDestroy(handle: Long)
+}
+
+/**
+ * Ring counters; [overrunFrames] were dropped by the producer, [underruns]
+ * counts the times the consumer found the ring empty
+ */
+data class AudioRingStats(
+    val framesWritten: Long,
+    val framesRead: Long,
+    val overrunFrames: Long,
+    val underruns: Long
+)
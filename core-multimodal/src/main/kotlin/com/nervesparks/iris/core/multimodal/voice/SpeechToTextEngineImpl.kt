@@ -2,6 +2,7 @@ package com.nervesparks.iris.core.multimodal.voice
 
 import android.content.Context
 import android.util.Log
+import androidx.annotation.VisibleForTesting
 import com.nervesparks.iris.app.events.EventBus
 import com.nervesparks.iris.app.events.IrisEvent
 import com.nervesparks.iris.common.error.VoiceException
@@ -13,6 +14,8 @@ import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.Flow
 import kotlinx.coroutines.flow.flow
+import kotlinx.coroutines.flow.flowOn
+import kotlinx.coroutines.flow.takeWhile
 import kotlinx.coroutines.withContext
 import java.io.File
 import javax.inject.Inject
@@ -42,6 +45,8 @@ class SpeechToTextEngineImpl @Inject constructor(
         private const val SILENCE_THRESHOLD_DB = -30.0f
         private const val MAX_RECORDING_DURATION_MS = 60000 // 60 seconds
         private const val VAD_WINDOW_MS = 100
+        private const val STREAM_STEP_MS = 400 // decode the native stream after this much new audio
+        private const val VAD_HANGOVER_MS = 300 // native VAD keeps forwarding this long into a pause
         
         // Native library loading - only loads if library exists
         private var nativeLibraryLoaded = false
@@ -62,6 +67,20 @@ class SpeechToTextEngineImpl @Inject constructor(
     private var isSTTModelLoaded = false
     private var isRecording = false
     private var currentRecordingSession: RecordingSession? = null
+    private var whisperContext = 0L // native model, 0 when running in mock mode
+    
+    /**
+     * Opens the frame-level VAD for a session at the given sample rate; null falls
+     * back to performVAD on whole chunks
+     */
+    @VisibleForTesting
+    internal var openVad: (Int) -> VoiceActivityDetector? = { sampleRate ->
+        if (nativeLibraryLoaded) {
+            VoiceActivityDetector(sampleRate = sampleRate, hangoverMs = VAD_HANGOVER_MS, modelPath = getVadModelPath())
+        } else {
+            null
+        }
+    }
     
     override suspend fun loadSTTModel(model: STTModelDescriptor): Result<Unit> {
         return withContext(Dispatchers.IO) {
@@ -93,6 +112,17 @@ class SpeechToTextEngineImpl @Inject constructor(
                 val selectedBackend = selectOptimalSTTBackend(model)
                 Log.i(TAG, "Selected STT backend: $selectedBackend for device capabilities")
                 
+                // Load the Whisper model natively when both the library and the file are present
+                if (nativeLibraryLoaded && modelFile.exists()) {
+                    releaseWhisperModel()
+                    val contextPtr = nativeLoadWhisperModel(modelPath)
+                    if (contextPtr == 0L) {
+                        eventBus.emit(IrisEvent.STTModelLoadFailed(model.id, "Native model load failed"))
+                        return@withContext Result.failure(VoiceException("Failed to load Whisper model"))
+                    }
+                    whisperContext = contextPtr
+                }
+                
                 // Store model configuration for inference
                 currentSTTModel = model
                 isSTTModelLoaded = true
@@ -123,6 +153,11 @@ class SpeechToTextEngineImpl @Inject constructor(
             return@flow
         }
         
+        // Native stream decoding while audio arrives; 0 falls back to whole-buffer processing
+        var stream = 0L
+        // Native frame-level gating; null falls back to performVAD on whole chunks
+        var vad: VoiceActivityDetector? = null
+        
         try {
             isRecording = true
             currentRecordingSession = RecordingSession(
@@ -140,17 +175,78 @@ class SpeechToTextEngineImpl @Inject constructor(
                 config = config.audioConfig
             )
             
+            if (whisperContext != 0L && config.streamingMode) {
+                val language = config.language ?: currentSTTModel!!.language
+                stream = nativeOpenStream(whisperContext, language, STREAM_STEP_MS)
+            }
+            vad = openVad(currentSTTModel!!.audioRequirements.sampleRate)
+            // The segment already carries VAD_HANGOVER_MS of the pause
+            val endSilenceSamples = maxOf(0, config.endOfSpeechSilenceMs - VAD_HANGOVER_MS).toLong() *
+                currentSTTModel!!.audioRequirements.sampleRate / 1000
+            var samplesSinceSegment = -1L // -1 until a segment closes, and while one is open
+            var settled: FinalTranscriptionResult? = null
+            
             var silenceCount = 0
             var hasDetectedSpeech = false
             val audioBuffer = mutableListOf<FloatArray>()
             
-            audioFlow.collect { audioData ->
+            // Chunks still buffered after a final result or stopListening() are dropped
+            audioFlow.takeWhile { isRecording }.collect { audioData ->
                 when (audioData) {
                     is AudioData.Chunk -> {
                         // Voice Activity Detection
-                        val vadResult = performVAD(audioData.samples)
-                        
-                        when (vadResult) {
+                        val gate = vad
+                        if (gate != null) {
+                            // Only speech segments, with their pre-roll, reach the recognizer
+                            for (step in gate.process(audioData.samples)) {
+                                if (step.started) {
+                                    hasDetectedSpeech = true
+                                    samplesSinceSegment = -1L
+                                    settled = null
+                                    emit(SpeechRecognitionResult.SpeechDetected())
+                                }
+                                step.speech?.let { speech ->
+                                    audioBuffer.add(speech)
+                                    if (stream != 0L) {
+                                        pushStream(stream, speech)?.let { partialResult ->
+                                            emit(SpeechRecognitionResult.PartialTranscription(
+                                                text = partialResult.text,
+                                                confidence = partialResult.confidence,
+                                                isFinal = partialResult.isFinal
+                                            ))
+                                        }
+                                    }
+                                }
+                                if (step.ended) {
+                                    samplesSinceSegment = 0L
+                                    if (stream != 0L) {
+                                        // Settle the text now, so it is ready the moment the pause is long enough
+                                        settled = finalTranscription(stream, audioBuffer).also { result ->
+                                            emit(SpeechRecognitionResult.PartialTranscription(
+                                                text = result.text,
+                                                confidence = result.confidence,
+                                                isFinal = false
+                                            ))
+                                        }
+                                    }
+                                }
+                            }
+                            if (samplesSinceSegment >= 0L) {
+                                samplesSinceSegment += audioData.samples.size
+                                if (samplesSinceSegment >= endSilenceSamples) {
+                                    val finalTranscription = settled ?: finalTranscription(stream, audioBuffer)
+                                    
+                                    emit(SpeechRecognitionResult.FinalTranscription(
+                                        text = finalTranscription.text,
+                                        confidence = finalTranscription.confidence,
+                                        duration = System.currentTimeMillis() - currentRecordingSession!!.startTime
+                                    ))
+                                    
+                                    stopListening()
+                                    return@collect
+                                }
+                            }
+                        } else when (performVAD(audioData.samples)) {
                             VADResult.SPEECH -> {
                                 hasDetectedSpeech = true
                                 silenceCount = 0
@@ -160,7 +256,12 @@ class SpeechToTextEngineImpl @Inject constructor(
                                 
                                 // Process audio chunk through STT
                                 if (config.streamingMode) {
-                                    processAudioChunk(audioData.samples, config.streamingMode)?.let { partialResult ->
+                                    val partial = if (stream != 0L) {
+                                        pushStream(stream, audioData.samples)
+                                    } else {
+                                        processAudioChunk(audioData.samples, config.streamingMode)
+                                    }
+                                    partial?.let { partialResult ->
                                         emit(SpeechRecognitionResult.PartialTranscription(
                                             text = partialResult.text,
                                             confidence = partialResult.confidence,
@@ -177,7 +278,7 @@ class SpeechToTextEngineImpl @Inject constructor(
                                     // End of speech detection
                                     if (silenceCount >= config.endOfSpeechSilenceMs / VAD_WINDOW_MS) {
                                         // Process complete audio buffer
-                                        val finalTranscription = processFinalAudio(audioBuffer)
+                                        val finalTranscription = finalTranscription(stream, audioBuffer)
                                         
                                         emit(SpeechRecognitionResult.FinalTranscription(
                                             text = finalTranscription.text,
@@ -188,6 +289,11 @@ class SpeechToTextEngineImpl @Inject constructor(
                                         stopListening()
                                         return@collect
                                     }
+                                    
+                                    // Trailing audio may still hold the end of the last word
+                                    if (stream != 0L) {
+                                        nativePushStream(stream, audioData.samples, audioData.samples.size)
+                                    }
                                 }
                                 
                                 audioBuffer.add(audioData.samples)
@@ -195,6 +301,9 @@ class SpeechToTextEngineImpl @Inject constructor(
                             
                             VADResult.NOISE -> {
                                 // Ignore noise chunks but keep in buffer for context
+                                if (stream != 0L && hasDetectedSpeech) {
+                                    nativePushStream(stream, audioData.samples, audioData.samples.size)
+                                }
                                 audioBuffer.add(audioData.samples)
                             }
                         }
@@ -202,7 +311,7 @@ class SpeechToTextEngineImpl @Inject constructor(
                         // Check maximum recording duration
                         val recordingDuration = System.currentTimeMillis() - currentRecordingSession!!.startTime
                         if (recordingDuration > MAX_RECORDING_DURATION_MS) {
-                            val finalTranscription = processFinalAudio(audioBuffer)
+                            val finalTranscription = finalTranscription(stream, audioBuffer)
                             
                             emit(SpeechRecognitionResult.FinalTranscription(
                                 text = finalTranscription.text,
@@ -223,8 +332,9 @@ class SpeechToTextEngineImpl @Inject constructor(
                     }
                     
                     is AudioData.Ended -> {
+                        vad?.flush()
                         if (audioBuffer.isNotEmpty()) {
-                            val finalTranscription = processFinalAudio(audioBuffer)
+                            val finalTranscription = settled ?: finalTranscription(stream, audioBuffer)
                             
                             emit(SpeechRecognitionResult.FinalTranscription(
                                 text = finalTranscription.text,
@@ -244,8 +354,18 @@ class SpeechToTextEngineImpl @Inject constructor(
             Log.e(TAG, "Speech recognition failed", e)
             emit(SpeechRecognitionResult.Error("Speech recognition failed: ${e.message}"))
             stopListening()
+        } finally {
+            if (stream != 0L) {
+                nativeCloseStream(stream)
+            }
+            vad?.let { gate ->
+                val stats = gate.stats()
+                Log.i(TAG, "VAD forwarded ${stats.forwardedSamples} samples in ${stats.segments} segments " +
+                    "(${stats.speechFrames}/${stats.frames} speech frames)")
+                gate.close()
+            }
         }
-    }
+    }.flowOn(Dispatchers.Default) // Stream pushes and the final decode run whisper; keep them off the collector
     
     override suspend fun stopListening(): Boolean {
         return try {
@@ -290,6 +410,20 @@ class SpeechToTextEngineImpl @Inject constructor(
             
             val samples = audioData.getOrNull()!!
             
+            if (whisperContext != 0L) {
+                val transcription = transcribeNative(samples, language ?: currentSTTModel!!.language)
+                val durationMs = (samples.size * 1000L) / currentSTTModel!!.audioRequirements.sampleRate
+                return@withContext Result.success(
+                    TranscriptionResult(
+                        text = transcription.text,
+                        confidence = transcription.confidence,
+                        segments = transcription.segments,
+                        duration = durationMs,
+                        language = language ?: currentSTTModel!!.language
+                    )
+                )
+            }
+            
             // Transcribe audio through inference engine
             // Production: This would use Whisper.cpp native inference
             // Current: Mock implementation for testing infrastructure
@@ -524,6 +658,10 @@ class SpeechToTextEngineImpl @Inject constructor(
                 offset += chunk.size
             }
             
+            if (whisperContext != 0L) {
+                return transcribeNative(combinedAudio, currentSTTModel!!.language)
+            }
+            
             // Process complete audio for final transcription
             // Production: This would use Whisper.cpp full inference
             // Current: Mock implementation with audio analysis
@@ -596,10 +734,72 @@ class SpeechToTextEngineImpl @Inject constructor(
         }
     }
     
+    /**
+     * Final text at end of speech: the native stream only decodes the audio it has not
+     * committed yet; without one the whole buffer is processed
+     */
+    private suspend fun finalTranscription(stream: Long, audioBuffer: List<FloatArray>): FinalTranscriptionResult {
+        if (stream == 0L) {
+            return processFinalAudio(audioBuffer)
+        }
+        val text = arrayOfNulls<String>(2)
+        val confidence = nativeFinishStream(stream, text)
+        val transcript = text[0].orEmpty().trim()
+        val durationSec = audioBuffer.sumOf { it.size } / currentSTTModel!!.audioRequirements.sampleRate.toFloat()
+        return FinalTranscriptionResult(
+            text = transcript,
+            confidence = confidence,
+            segments = listOf(TranscriptionSegment(transcript, 0.0f, durationSec, confidence))
+        )
+    }
+    
+    /**
+     * Push a chunk to the native stream
+     * @return The committed text plus the tentative rest, or null if no decode ran
+     */
+    private fun pushStream(stream: Long, samples: FloatArray): PartialTranscriptionResult? {
+        if (!nativePushStream(stream, samples, samples.size)) {
+            return null
+        }
+        val text = arrayOfNulls<String>(2)
+        val confidence = nativeStreamHypothesis(stream, text)
+        return PartialTranscriptionResult(
+            text = (text[0].orEmpty() + text[1].orEmpty()).trim(),
+            confidence = confidence,
+            isFinal = false
+        )
+    }
+    
+    private fun transcribeNative(samples: FloatArray, language: String): FinalTranscriptionResult {
+        val confidence = FloatArray(1)
+        val text = nativeTranscribeAudio(whisperContext, samples, language, confidence)?.trim().orEmpty()
+        val durationSec = samples.size / currentSTTModel!!.audioRequirements.sampleRate.toFloat()
+        return FinalTranscriptionResult(
+            text = text,
+            confidence = confidence[0],
+            segments = listOf(TranscriptionSegment(text, 0.0f, durationSec, confidence[0]))
+        )
+    }
+    
+    private fun releaseWhisperModel() {
+        if (whisperContext != 0L) {
+            nativeUnloadWhisperModel(whisperContext)
+            whisperContext = 0L
+        }
+    }
+    
     private fun generateSessionId(): String {
         return "stt_${System.currentTimeMillis()}_${(1000..9999).random()}"
     }
     
+    /**
+     * Optional tiny VAD model next to the STT models; null when absent
+     */
+    private fun getVadModelPath(): String? {
+        val file = File(File(context.getExternalFilesDir(null), "models"), "vad-tiny.bin")
+        return if (file.exists()) file.absolutePath else null
+    }
+    
     private fun getModelPath(model: STTModelDescriptor): String {
         return File(
             File(context.getExternalFilesDir(null), "models"),
@@ -625,14 +825,47 @@ class SpeechToTextEngineImpl @Inject constructor(
      * @param contextPtr Native context pointer from nativeLoadWhisperModel
      * @param audioData Audio samples as float array (normalized -1.0 to 1.0)
      * @param language Language code (e.g., "en", "es", "fr")
+     * @param outConfidence Receives the mean token probability in element 0
      * @return Transcribed text or null if failed
      */
     private external fun nativeTranscribeAudio(
         contextPtr: Long,
         audioData: FloatArray,
-        language: String
+        language: String,
+        outConfidence: FloatArray
     ): String?
     
+    /**
+     * Open a streaming transcriber that decodes overlapping windows as audio arrives
+     * and commits text once consecutive decodes agree on it
+     * @param contextPtr Native context pointer from nativeLoadWhisperModel
+     * @param stepMs Audio to collect between decodes
+     * @return Native stream pointer
+     */
+    private external fun nativeOpenStream(contextPtr: Long, language: String, stepMs: Int): Long
+    
+    /**
+     * Append 16 kHz samples to a stream
+     * @return true if a decode ran and the hypothesis may have changed
+     */
+    private external fun nativePushStream(streamPtr: Long, samples: FloatArray, count: Int): Boolean
+    
+    /**
+     * Current hypothesis: committed text in outText[0], tentative rest in outText[1]
+     * @return Mean probability of the committed tokens
+     */
+    private external fun nativeStreamHypothesis(streamPtr: Long, outText: Array<String?>): Float
+    
+    /**
+     * End of speech: decode what is left and commit it all; outText as for nativeStreamHypothesis
+     */
+    private external fun nativeFinishStream(streamPtr: Long, outText: Array<String?>): Float
+    
+    /**
+     * Free a stream from nativeOpenStream
+     */
+    private external fun nativeCloseStream(streamPtr: Long)
+    
     /**
      * Unload a Whisper model and free native memory
      * @param contextPtr Native context pointer from nativeLoadWhisperModel
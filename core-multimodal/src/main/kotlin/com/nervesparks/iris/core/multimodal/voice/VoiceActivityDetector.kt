@@ -0,0 +1,97 @@
+package com.nervesparks.iris.core.multimodal.voice
+
+/**
+ * Native streaming voice-activity detector (libiris_multimodal)
+ *
+ * Audio is classified in fixed 10-30 ms frames by energy above an adaptive noise
+ * floor and zero-crossing rate, or by a tiny neural model when one is given. A
+ * segment opens after a few speech frames and closes after [hangoverMs] without
+ * speech. Only segment audio is returned, with a short pre-roll before each onset,
+ * so silence never reaches the recognizer.
+ *
+ * Requires the native library to be loaded; not thread-safe.
+ *
+ * @param modelPath Optional tiny VAD model ("IVAD" file); null for the energy/ZCR rule
+ */
+internal class VoiceActivityDetector(
+    sampleRate: Int,
+    frameMs: Int = 20,
+    hangoverMs: Int = 400,
+    modelPath: String? = null
+) : AutoCloseable {
+
+    /**
+     * One piece of gated audio
+     * @property speech Audio to forward to the recognizer, or null if this piece held none
+     * @property started A speech segment opened in this piece
+     * @property ended A speech segment closed at the end of this piece
+     */
+    class Step(val speech: FloatArray?, val started: Boolean, val ended: Boolean)
+
+    private var handle = nativeCreate(sampleRate, frameMs, hangoverMs, modelPath)
+    private val state = IntArray(3)
+
+    /**
+     * Gate a chunk of audio. The chunk is split where a segment ends, so each
+     * [Step.ended] comes right after the speech of the segment it closes.
+     */
+    fun process(samples: FloatArray): List<Step> {
+        check(handle != 0L) { "VoiceActivityDetector is closed" }
+        val steps = mutableListOf<Step>()
+        var offset = 0
+        while (offset < samples.size) {
+            val speech = nativeProcess(handle, samples, offset, samples.size - offset, state)
+            offset += state[0]
+            if (speech != null || state[1] != 0 || state[2] != 0) {
+                steps.add(Step(speech, started = state[1] != 0, ended = state[2] != 0))
+            }
+        }
+        return steps
+    }
+
+    /**
+     * Close an open segment at the end of the recording
+     * @return true if a segment was open
+     */
+    fun flush(): Boolean = handle != 0L && nativeFlush(handle)
+
+    fun stats(): VadStats {
+        check(handle != 0L) { "VoiceActivityDetector is closed" }
+        val values = LongArray(4)
+        nativeStats(handle, values)
+        return VadStats(values[0], values[1], values[2], values[3])
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeDestroy(handle)
+            handle = 0L
+        }
+    }
+
+    private external fun nativeCreate(sampleRate: Int, frameMs: Int, hangoverMs: Int, modelPath: String?): Long
+
+    private external fun nativeProcess(
+        handle: Long,
+        samples: FloatArray,
+        offset: Int,
+        count: Int,
+        outState: IntArray
+    ): FloatArray?
+
+    private external fun nativeFlush(handle: Long): Boolean
+
+    private external fun nativeStats(handle: Long, outStats: LongArray)
+
+    private external fun nativeDestroy(handle: Long)
+}
+
+/**
+ * Detector counters; [speechFrames] counts frames classified as speech, before onset and hangover
+ */
+data class VadStats(
+    val frames: Long,
+    val speechFrames: Long,
+    val segments: Long,
+    val forwardedSamples: Long
+)
@@ -512,4 +512,68 @@ class SpeechToTextEngineImplTest {
         val speechDetections = results.filterIsInstance<SpeechRecognitionResult.SpeechDetected>()
         assertTrue(speechDetections.isEmpty() || speechDetections.size < 2)
     }
+    
+    // =========================
+    // End-of-Speech Tests
+    // =========================
+    
+    @Test
+    fun `native VAD segment end settles into one final transcription`() = runTest {
+        sttEngine.loadSTTModel(testModel)
+        val speech = TestAudioUtils.generateSineWave(440, 100).samples
+        val vad = mockk<VoiceActivityDetector>()
+        every { vad.process(any()) } returnsMany listOf(
+            listOf(VoiceActivityDetector.Step(speech, started = true, ended = false)),
+            listOf(VoiceActivityDetector.Step(speech.copyOf(800), started = false, ended = true)),
+            emptyList()
+        )
+        every { vad.flush() } returns false
+        every { vad.stats() } returns VadStats(0, 0, 1, 2400)
+        every { vad.close() } just Runs
+        sttEngine.openVad = { vad }
+        
+        val audioFlow = flow<AudioData> {
+            repeat(6) { emit(TestAudioUtils.generateSineWave(440, 100)) }
+            emit(AudioData.Ended)
+        }
+        coEvery { audioProcessor.startRecording(any(), any(), any()) } returns audioFlow
+        
+        // The segment carries 300 ms of the pause; 200 ms more (two chunks) ends the utterance
+        val results = sttEngine.startListening(ListeningConfig(endOfSpeechSilenceMs = 500)).toList()
+        
+        val finals = results.filterIsInstance<SpeechRecognitionResult.FinalTranscription>()
+        assertEquals(1, finals.size)
+        assertTrue(finals[0].text.contains("2400 samples")) // only the gated speech
+        assertEquals(1, results.count { it is SpeechRecognitionResult.SpeechDetected })
+        assertFalse(results.any { it is SpeechRecognitionResult.Error })
+        verify(exactly = 3) { vad.process(any()) } // later chunks are not processed
+        verify { vad.close() }
+        coVerify { audioProcessor.stopRecording() }
+        assertFalse(sttEngine.isListening())
+    }
+    
+    @Test
+    fun `performVAD fallback ends the utterance after enough silent chunks`() = runTest {
+        sttEngine.loadSTTModel(testModel)
+        sttEngine.openVad = { null }
+        
+        val audioFlow = flow<AudioData> {
+            repeat(2) { emit(TestAudioUtils.generateSineWave(440, 100, amplitude = 0.8f)) }
+            repeat(5) { emit(TestAudioUtils.generateSilence(100)) }
+            emit(TestAudioUtils.generateSineWave(440, 100, amplitude = 0.8f))
+            emit(AudioData.Ended)
+        }
+        coEvery { audioProcessor.startRecording(any(), any(), any()) } returns audioFlow
+        
+        val config = ListeningConfig(streamingMode = false, endOfSpeechSilenceMs = 300)
+        val results = sttEngine.startListening(config).toList()
+        
+        val finals = results.filterIsInstance<SpeechRecognitionResult.FinalTranscription>()
+        assertEquals(1, finals.size)
+        // Two speech chunks and the two silent ones before the third closed the utterance
+        assertTrue(finals[0].text.contains("6400 samples"))
+        assertEquals(2, results.count { it is SpeechRecognitionResult.SpeechDetected })
+        assertFalse(results.any { it is SpeechRecognitionResult.Error })
+        coVerify { audioProcessor.stopRecording() }
+    }
 }
@@ -0,0 +1,85 @@
+package com.nervesparks.iris.core.rag
+
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import kotlinx.coroutines.delay
+import kotlinx.coroutines.runBlocking
+import kotlinx.coroutines.withTimeout
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+import kotlin.random.Random
+
+/**
+ * VectorStoreImpl compaction against the native store, on a device
+ */
+@RunWith(AndroidJUnit4::class)
+class VectorStoreImplCompactionTest {
+
+    private val context = InstrumentationRegistry.getInstrumentation().targetContext
+    private val embeddingService = EmbeddingServiceImpl()
+
+    @Before
+    @After
+    fun removeStores() {
+        context.filesDir.listFiles { file -> file.name.startsWith("rag_vectors") }?.forEach { it.deleteRecursively() }
+    }
+
+    @Test
+    fun compactionWaitsForTheStartupBuilds() = runBlocking {
+        assertTrue(VectorFile.isNativeAvailable)
+        val random = Random(7)
+        val chunks = (0 until 4096).map { i ->
+            EmbeddedChunk(
+                id = "chunk$i",
+                documentId = "doc${i % 4}",
+                content = "passage number $i",
+                embedding = FloatArray(64) { random.nextFloat() - 0.5f },
+                startIndex = 0,
+                endIndex = 0,
+                metadata = emptyMap()
+            )
+        }
+        VectorStoreImpl(embeddingService, context).saveChunks(chunks)
+
+        // A second store opens the saved rows, and its HNSW and BM25 builds are held
+        val started = CountDownLatch(2)
+        val release = CountDownLatch(1)
+        val store = VectorStoreImpl(embeddingService, context)
+        store.beforeBuild = {
+            started.countDown()
+            release.await()
+        }
+        store.searchLexical("passage", 1)
+        assertTrue(started.await(10, TimeUnit.SECONDS))
+
+        // Three quarters of the rows become tombstones, past the compaction threshold
+        listOf("doc0", "doc1", "doc2").forEach { store.deleteChunksByDocumentId(it) }
+        delay(500)
+        assertFalse(File(context.filesDir, "rag_vectors.compact").exists())
+        assertEquals(4096, store.storedRowCount())
+
+        // Once the builds are done, the store compacts and keeps answering
+        release.countDown()
+        withTimeout(60_000) {
+            while (store.storedRowCount() != 1024) {
+                delay(50)
+            }
+        }
+        val nearest = store.searchSimilar(chunks[3].embedding, 1, -1.0f)
+        assertEquals("chunk3", nearest.single().chunk.id)
+        withTimeout(10_000) {
+            while (store.searchLexical("passage", 10).isEmpty()) {
+                delay(50)
+            }
+        }
+        assertTrue(store.searchLexical("passage", 10).all { it.chunk.documentId == "doc3" })
+    }
+}
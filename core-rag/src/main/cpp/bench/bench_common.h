@@ -0,0 +1,102 @@
+#ifndef IRIS_RAG_BENCH_COMMON_H
+#define IRIS_RAG_BENCH_COMMON_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace iris {
+namespace bench {
+
+/**
+ * Synthetic embedding corpus: points scattered around random cluster centres,
+ * which is closer to real sentence embeddings than uniform noise.
+ */
+inline std::vector<float> clusteredVectors(size_t count, int dim, size_t clusters, uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<float> centres(clusters * dim);
+    for (float& value : centres) {
+        value = normal(rng);
+    }
+
+    std::uniform_int_distribution<size_t> pick(0, clusters - 1);
+    std::vector<float> data(count * dim);
+    for (size_t i = 0; i < count; i++) {
+        const float* centre = centres.data() + pick(rng) * dim;
+        for (int d = 0; d < dim; d++) {
+            data[i * dim + d] = centre[d] + 0.6f * normal(rng);
+        }
+    }
+    return data;
+}
+
+/**
+ * Integer command-line argument with default
+ */
+inline long argOr(int argc, char** argv, int position, long fallback) {
+    return argc > position ? std::strtol(argv[position], nullptr, 10) : fallback;
+}
+
+class Timer {
+public:
+    Timer() : start_(std::chrono::steady_clock::now()) {}
+
+    double elapsedMs() const {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_).count();
+    }
+
+    double elapsedUs() const { return elapsedMs() * 1000.0; }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * Percentile of a sample set (sorts in place)
+ */
+inline double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) {
+        return 0.0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const size_t index = std::min(samples.size() - 1, static_cast<size_t>(p * (samples.size() - 1) + 0.5));
+    return samples[index];
+}
+
+inline double mean(const std::vector<double>& samples) {
+    double sum = 0.0;
+    for (double s : samples) {
+        sum += s;
+    }
+    return samples.empty() ? 0.0 : sum / samples.size();
+}
+
+/**
+ * Fraction of `truth` labels that appear in `found`
+ */
+template <typename Hit>
+double recallAt(const std::vector<Hit>& truth, const std::vector<Hit>& found) {
+    if (truth.empty()) {
+        return 1.0;
+    }
+    size_t matched = 0;
+    for (const Hit& t : truth) {
+        for (const Hit& f : found) {
+            if (f.label == t.label) {
+                matched++;
+                break;
+            }
+        }
+    }
+    return static_cast<double>(matched) / truth.size();
+}
+
+} // namespace bench
+} // namespace iris
+
+#endif // IRIS_RAG_BENCH_COMMON_H
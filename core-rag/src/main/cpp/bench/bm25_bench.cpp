@@ -0,0 +1,166 @@
+/**
+ * Build cost, posting size and query latency of Bm25Index at 10k, 100k and 1M
+ * chunks, comparing Block-Max WAND against exhaustive scoring of every match.
+ *
+ * Chunks are 80 words drawn from a Zipfian vocabulary of 50k words, so a few
+ * terms appear nearly everywhere and most are rare. Queries mix 2-4 words of
+ * any frequency with single rare "identifier" terms, the case embedding search
+ * tends to miss. WAND results are checked against the exhaustive top-k.
+ *
+ * Usage: bm25_bench [maxCount=1000000] [queries=200]
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../bm25_index.h"
+#include "../rank_fusion.h"
+#include "bench_common.h"
+
+using iris::rag::Bm25Index;
+using iris::rag::SearchHit;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr int kTopK = 10;
+constexpr size_t kVocabulary = 50000;
+constexpr size_t kWordsPerChunk = 80;
+
+class ZipfWords {
+public:
+    explicit ZipfWords(uint64_t seed) : rng_(seed), uniform_(0.0, 1.0), cumulative_(kVocabulary) {
+        double sum = 0.0;
+        for (size_t r = 0; r < kVocabulary; r++) {
+            sum += 1.0 / static_cast<double>(r + 1);
+            cumulative_[r] = sum;
+        }
+        for (double& c : cumulative_) {
+            c /= sum;
+        }
+    }
+
+    size_t rank() {
+        const double u = uniform_(rng_);
+        return std::lower_bound(cumulative_.begin(), cumulative_.end(), u) - cumulative_.begin();
+    }
+
+    std::mt19937_64& rng() { return rng_; }
+
+private:
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    std::vector<double> cumulative_;
+};
+
+std::string word(size_t rank) {
+    return "w" + std::to_string(rank);
+}
+
+std::string makeChunk(ZipfWords& words) {
+    std::string text;
+    text.reserve(kWordsPerChunk * 7);
+    for (size_t i = 0; i < kWordsPerChunk; i++) {
+        text += word(words.rank());
+        text += i % 12 == 11 ? ". " : " ";
+    }
+    return text;
+}
+
+struct Timing {
+    double mean;
+    double p99;
+};
+
+Timing measure(const Bm25Index& index, const std::vector<std::string>& queries, bool wand,
+               std::vector<std::vector<SearchHit>>& results) {
+    std::vector<double> latencies;
+    results.resize(queries.size());
+    for (size_t q = 0; q < queries.size(); q++) {
+        bench::Timer timer;
+        results[q] = wand ? index.search(queries[q], kTopK) : index.exhaustiveSearch(queries[q], kTopK);
+        latencies.push_back(timer.elapsedUs());
+    }
+    return {bench::mean(latencies), bench::percentile(latencies, 0.99)};
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t maxCount = static_cast<size_t>(bench::argOr(argc, argv, 1, 1000000));
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 2, 200));
+
+    std::printf("BM25 benchmark: %zu words per chunk, vocabulary %zu, %zu queries, top-%d\n\n", kWordsPerChunk,
+                kVocabulary, queryCount, kTopK);
+
+    ZipfWords queryWords(99);
+    std::vector<std::string> queries;
+    for (size_t q = 0; q < queryCount; q++) {
+        std::string query;
+        if (q % 4 == 3) {
+            query = word(5000 + queryWords.rng()() % 40000); // a rare identifier-like term
+        } else {
+            const size_t terms = 2 + q % 3;
+            for (size_t t = 0; t < terms; t++) {
+                query += word(queryWords.rank()) + " ";
+            }
+        }
+        queries.push_back(query);
+    }
+
+    std::printf("%-8s %9s %8s %11s %12s %12s %13s %13s %7s\n", "chunks", "build(s)", "terms", "postings",
+                "wand mean", "wand p99", "exhaust mean", "exhaust p99", "agree");
+    bool allAgree = true;
+    for (size_t count : {size_t{10000}, size_t{100000}, size_t{1000000}}) {
+        if (count > maxCount) {
+            break;
+        }
+        ZipfWords words(count);
+        Bm25Index index;
+        bench::Timer buildTimer;
+        for (size_t doc = 0; doc < count; doc++) {
+            index.add(static_cast<int32_t>(doc), makeChunk(words));
+        }
+        const double buildSeconds = buildTimer.elapsedMs() / 1000.0;
+
+        std::vector<std::vector<SearchHit>> wandHits;
+        std::vector<std::vector<SearchHit>> exhaustiveHits;
+        const Timing wand = measure(index, queries, true, wandHits);
+        const Timing exhaustive = measure(index, queries, false, exhaustiveHits);
+
+        // Same scores at every rank (labels may differ only between tied scores)
+        size_t agree = 0;
+        for (size_t q = 0; q < queryCount; q++) {
+            bool same = wandHits[q].size() == exhaustiveHits[q].size();
+            for (size_t i = 0; same && i < wandHits[q].size(); i++) {
+                same = std::abs(wandHits[q][i].score - exhaustiveHits[q][i].score) < 1e-4f;
+            }
+            agree += same;
+        }
+        allAgree = allAgree && agree == queryCount;
+
+        std::printf("%-8zu %9.1f %8zu %9.1fMB %10.0fus %10.0fus %11.0fus %11.0fus %6.1f%%\n", count, buildSeconds,
+                    index.termCount(), index.postingBytes() / 1e6, wand.mean, wand.p99, exhaustive.mean,
+                    exhaustive.p99, 100.0 * agree / queryCount);
+    }
+
+    // Fusion of a lexical and a semantic top-100
+    std::vector<std::vector<int32_t>> rankings(2);
+    std::mt19937 rng(5);
+    for (auto& ranking : rankings) {
+        for (int i = 0; i < 100; i++) {
+            ranking.push_back(static_cast<int32_t>(rng() % 300));
+        }
+    }
+    std::vector<double> fusionLatencies;
+    for (int i = 0; i < 1000; i++) {
+        bench::Timer timer;
+        iris::rag::reciprocalRankFusion(rankings, kTopK);
+        fusionLatencies.push_back(timer.elapsedUs());
+    }
+    std::printf("\nreciprocal-rank fusion of 2 x 100 hits: mean %.1f us\n", bench::mean(fusionLatencies));
+    return allAgree ? 0 : 1;
+}
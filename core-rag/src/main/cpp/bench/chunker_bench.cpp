@@ -0,0 +1,167 @@
+/**
+ * Throughput and budget fill of TextChunker on 1, 4 and 16 MB documents.
+ *
+ * Words are 1-4 syllables from a 400-syllable inventory; the WordPiece
+ * vocabulary written to a temporary file holds every syllable as a word start
+ * and a "##" continuation plus the 3000 most common whole words, so common
+ * words are one token and rare ones split into pieces, as with a real model.
+ * Sentences of 6-24 words, some with commas, form paragraphs of 2-8 sentences.
+ *
+ * Every chunk is re-tokenized on its own to check it fits the budget.
+ *
+ * Usage: chunker_bench [maxMegabytes=16] [vocabPath=/tmp/iris_chunker_vocab.txt]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../subword_tokenizer.h"
+#include "../text_chunker.h"
+#include "bench_common.h"
+
+using iris::rag::ChunkSpan;
+using iris::rag::SubwordTokenizer;
+using iris::rag::TextChunker;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr size_t kSyllables = 400;
+constexpr size_t kCommonWords = 3000;
+
+class Corpus {
+public:
+    explicit Corpus(uint64_t seed) : rng_(seed) {
+        const char* onsets[] = {"b", "c", "d", "f", "g", "h", "k", "l", "m", "n",
+                                "p", "r", "s", "t", "v", "w", "st", "tr", "pl", "ch"};
+        const char* nuclei[] = {"a", "e", "i", "o", "u", "ai", "ou", "ea", "io", "y"};
+        const char* codas[] = {"", "n"};
+        for (const char* onset : onsets) {
+            for (const char* nucleus : nuclei) {
+                for (const char* coda : codas) {
+                    syllables_.push_back(std::string(onset) + nucleus + coda);
+                }
+            }
+        }
+        // Zipfian word list: word r is a fixed syllable sequence
+        for (size_t r = 0; r < 60000; r++) {
+            std::string w;
+            const size_t parts = 1 + rng_() % 4;
+            for (size_t p = 0; p < parts; p++) {
+                w += syllables_[rng_() % kSyllables];
+            }
+            words_.push_back(w);
+        }
+        double sum = 0.0;
+        for (size_t r = 0; r < words_.size(); r++) {
+            sum += 1.0 / static_cast<double>(r + 1);
+            cumulative_.push_back(sum);
+        }
+        for (double& c : cumulative_) {
+            c /= sum;
+        }
+    }
+
+    void writeVocabulary(const std::string& path) const {
+        std::ofstream out(path);
+        out << "[PAD]\n[UNK]\n[CLS]\n[SEP]\n.\n,\n";
+        for (const std::string& s : syllables_) {
+            out << s << "\n##" << s << "\n";
+        }
+        for (size_t r = 0; r < kCommonWords; r++) {
+            out << words_[r] << "\n";
+        }
+    }
+
+    std::string document(size_t bytes) {
+        std::uniform_real_distribution<double> uniform(0.0, 1.0);
+        std::string text;
+        text.reserve(bytes + 4096);
+        while (text.size() < bytes) {
+            const size_t sentences = 2 + rng_() % 7;
+            for (size_t s = 0; s < sentences; s++) {
+                const size_t count = 6 + rng_() % 19;
+                for (size_t w = 0; w < count; w++) {
+                    const size_t r = std::lower_bound(cumulative_.begin(), cumulative_.end(), uniform(rng_)) -
+                                     cumulative_.begin();
+                    std::string word = words_[std::min(r, words_.size() - 1)];
+                    if (w == 0) {
+                        word[0] = static_cast<char>(word[0] - 'a' + 'A');
+                    }
+                    text += word;
+                    text += w + 1 == count ? ". " : (rng_() % 10 == 0 ? ", " : " ");
+                }
+            }
+            text += "\n\n";
+        }
+        return text;
+    }
+
+private:
+    std::mt19937_64 rng_;
+    std::vector<std::string> syllables_;
+    std::vector<std::string> words_;
+    std::vector<double> cumulative_;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t maxMegabytes = static_cast<size_t>(bench::argOr(argc, argv, 1, 16));
+    const std::string vocabPath = argc > 2 ? argv[2] : "/tmp/iris_chunker_vocab.txt";
+
+    Corpus corpus(7);
+    corpus.writeVocabulary(vocabPath);
+    const auto tokenizer = SubwordTokenizer::load(vocabPath);
+    std::printf("Chunker benchmark: vocabulary of %zu pieces\n\n", tokenizer->vocabularySize());
+
+    std::printf("%-6s %-8s %11s %8s %10s %10s %10s %9s\n", "MB", "budget", "tokenize", "chunk", "chunks", "mean fill",
+                "min fill", "overflow");
+    bool fits = true;
+    for (size_t megabytes : {size_t{1}, size_t{4}, size_t{16}}) {
+        if (megabytes > maxMegabytes) {
+            break;
+        }
+        const std::string text = corpus.document(megabytes << 20);
+
+        bench::Timer tokenizeTimer;
+        const size_t totalTokens = tokenizer->countTokens(text);
+        const double tokenizeMs = tokenizeTimer.elapsedMs();
+
+        for (const auto& budget : {std::pair<size_t, size_t>{256, 32}, std::pair<size_t, size_t>{512, 64}}) {
+            const TextChunker chunker(*tokenizer, budget.first, budget.second);
+            bench::Timer chunkTimer;
+            const std::vector<ChunkSpan> spans = chunker.chunk(text);
+            const double chunkMs = chunkTimer.elapsedMs();
+
+            // All but the last chunk; the last one holds whatever is left
+            double fill = 0.0;
+            double minFill = 1.0;
+            size_t overflow = 0;
+            for (size_t i = 0; i < spans.size(); i++) {
+                const ChunkSpan& span = spans[i];
+                const size_t recounted = tokenizer->countTokens(
+                    std::string_view(text).substr(span.begin, span.end - span.begin));
+                overflow += recounted > budget.first || span.tokens > budget.first;
+                if (i + 1 < spans.size()) {
+                    const double f = static_cast<double>(span.tokens) / budget.first;
+                    fill += f;
+                    minFill = std::min(minFill, f);
+                }
+            }
+            fits = fits && overflow == 0;
+            char label[32];
+            std::snprintf(label, sizeof(label), "%zu/%zu", budget.first, budget.second);
+            std::printf("%-6zu %-8s %8.0fMB/s %6.0fMB/s %10zu %9.1f%% %9.1f%% %9zu\n", megabytes, label,
+                        megabytes / (tokenizeMs / 1000.0), megabytes / (chunkMs / 1000.0), spans.size(),
+                        100.0 * fill / std::max<size_t>(1, spans.size() - 1), 100.0 * minFill, overflow);
+        }
+        std::printf("%-6s %zu tokens, %.2f bytes per token\n", "", totalTokens,
+                    static_cast<double>(text.size()) / totalTokens);
+    }
+    return fits ? 0 : 1;
+}
@@ -0,0 +1,167 @@
+/**
+ * Near-duplicate detection: signature cost, lookup cost as the index grows,
+ * and how well MinHash + LSH flags copies at several edit rates.
+ *
+ * Chunks are 200 words from a Zipfian vocabulary. After a set of originals,
+ * every third chunk is a copy of an earlier one with a share of its words
+ * replaced (0% is an exact repeat such as a PDF header, 2% a forwarded email
+ * with a changed line, 20% a different text on the same topic). The true
+ * Jaccard similarity of each copy's 3-word shingles to its original is
+ * computed exactly. The threshold is 0.8 and estimates are noisy near it, so
+ * recall counts copies at 0.85 or more, and a flag is false if the flagged
+ * pair is below 0.7.
+ *
+ * Usage: dedup_bench [chunks=20000]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../near_duplicate_index.h"
+#include "../text_tokenizer.h"
+#include "bench_common.h"
+
+using iris::rag::NearDuplicateIndex;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr size_t kVocabulary = 50000;
+constexpr size_t kWordsPerChunk = 200;
+constexpr float kThreshold = 0.8f;
+
+class ZipfWords {
+public:
+    explicit ZipfWords(uint64_t seed) : rng_(seed), uniform_(0.0, 1.0), cumulative_(kVocabulary) {
+        double sum = 0.0;
+        for (size_t r = 0; r < kVocabulary; r++) {
+            sum += 1.0 / static_cast<double>(r + 1);
+            cumulative_[r] = sum;
+        }
+        for (double& c : cumulative_) {
+            c /= sum;
+        }
+    }
+
+    std::string word() {
+        const double u = uniform_(rng_);
+        return "w" + std::to_string(std::lower_bound(cumulative_.begin(), cumulative_.end(), u) - cumulative_.begin());
+    }
+
+    std::mt19937_64& rng() { return rng_; }
+
+private:
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    std::vector<double> cumulative_;
+};
+
+std::string join(const std::vector<std::string>& words) {
+    std::string text;
+    for (const std::string& word : words) {
+        text += word;
+        text += ' ';
+    }
+    return text;
+}
+
+double jaccard(const std::string& a, const std::string& b) {
+    auto shingles = [](const std::string& text) {
+        const std::vector<std::string> tokens = iris::rag::tokenize(text);
+        std::set<std::string> out;
+        for (size_t i = 0; i + NearDuplicateIndex::kShingleWords <= tokens.size(); i++) {
+            out.insert(tokens[i] + " " + tokens[i + 1] + " " + tokens[i + 2]);
+        }
+        return out;
+    };
+    const std::set<std::string> sa = shingles(a);
+    const std::set<std::string> sb = shingles(b);
+    size_t shared = 0;
+    for (const std::string& s : sa) {
+        shared += sb.count(s);
+    }
+    return static_cast<double>(shared) / static_cast<double>(sa.size() + sb.size() - shared);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = static_cast<size_t>(bench::argOr(argc, argv, 1, 20000));
+
+    std::printf("Near-duplicate benchmark: %zu chunks of %zu words, 16 bands x 8 rows, Jaccard >= %.1f\n\n", count,
+                kWordsPerChunk, kThreshold);
+    std::printf("%-6s %9s %10s %10s %8s %12s %12s %12s %9s\n", "edits", "mean J", "J >= 0.85", "flagged", "recall",
+                "false flags", "sign (us)", "match (us)", "entries");
+
+    bool good = true;
+    for (double editRate : {0.0, 0.02, 0.05, 0.1, 0.2}) {
+        ZipfWords words(42);
+        std::vector<std::string> texts;
+        std::vector<int32_t> originalOf(count, -1);
+        texts.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            std::vector<std::string> chunk;
+            if (i >= 100 && i % 3 == 0) {
+                // Copies of copies would be judged against a text the index never kept
+                size_t original = words.rng()() % (i / 2);
+                while (originalOf[original] >= 0) {
+                    original--;
+                }
+                originalOf[i] = static_cast<int32_t>(original);
+                const std::vector<std::string> source = iris::rag::tokenize(texts[original]);
+                for (const std::string& word : source) {
+                    chunk.push_back(std::uniform_real_distribution<double>(0, 1)(words.rng()) < editRate ? words.word()
+                                                                                                         : word);
+                }
+            } else {
+                for (size_t w = 0; w < kWordsPerChunk; w++) {
+                    chunk.push_back(words.word());
+                }
+            }
+            texts.push_back(join(chunk));
+        }
+
+        NearDuplicateIndex index;
+        std::vector<double> signUs, matchUs;
+        std::vector<int32_t> flagged(count, -1);
+        for (size_t i = 0; i < count; i++) {
+            bench::Timer signTimer;
+            const std::vector<uint32_t> sig = index.signature(texts[i]);
+            signUs.push_back(signTimer.elapsedUs());
+            bench::Timer matchTimer;
+            flagged[i] = index.find(sig);
+            if (flagged[i] < 0) {
+                index.add(static_cast<int32_t>(i), sig);
+            }
+            matchUs.push_back(matchTimer.elapsedUs());
+        }
+
+        // Copies are judged against their original; any other flag is checked exactly
+        size_t copies = 0, similarCopies = 0, foundCopies = 0, flags = 0, falseFlags = 0;
+        double sumJaccard = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            if (originalOf[i] >= 0) {
+                copies++;
+                const double j = jaccard(texts[i], texts[originalOf[i]]);
+                sumJaccard += j;
+                if (j >= kThreshold + 0.05) {
+                    similarCopies++;
+                    foundCopies += flagged[i] >= 0;
+                }
+            }
+            if (flagged[i] >= 0) {
+                flags++;
+                falseFlags += jaccard(texts[i], texts[flagged[i]]) < kThreshold - 0.1;
+            }
+        }
+        const double recall = similarCopies ? static_cast<double>(foundCopies) / similarCopies : 1.0;
+        good = good && recall >= 0.95 && falseFlags == 0;
+        std::printf("%5.0f%% %9.2f %9.1f%% %9.1f%% %8.3f %12zu %12.1f %12.1f %9zu\n", editRate * 100.0,
+                    sumJaccard / copies, 100.0 * similarCopies / copies, 100.0 * flags / count, recall, falseFlags,
+                    bench::mean(signUs), bench::mean(matchUs), index.size());
+    }
+    return good ? 0 : 1;
+}
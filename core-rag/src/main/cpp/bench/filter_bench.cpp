@@ -0,0 +1,194 @@
+/**
+ * Filtered search: recall@10 and latency of each way to restrict a query to a
+ * document, a tag or a date range, at selectivities from one document to over
+ * a third of the store.
+ *
+ * Rows carry the metadata Kotlin writes (`tags`, `modified`), in documents of
+ * 20 chunks; each document has one of 8 tags and a modification day within
+ * the last year. Per filter the benchmark compares:
+ *   overfetch  unfiltered HNSW top-100, filtered afterwards (the old Kotlin way)
+ *   hnsw       HNSW traversal that only returns rows in the filter
+ *   scan       VectorFile::exactSearch over the filter's rows, skipping empty blocks
+ *   auto       what VectorStoreImpl picks: scan up to 16384 matching rows or below
+ *              2% selectivity, else hnsw
+ * Truth is an exact rescore of every row in the filter.
+ *
+ * Usage: filter_bench [count=100000] [dim=384] [queries=100] [dir=/tmp/iris_filter_bench]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../hnsw_index.h"
+#include "../vector_file.h"
+#include "bench_common.h"
+
+using iris::rag::ChunkRecord;
+using iris::rag::HnswIndex;
+using iris::rag::RowBitmap;
+using iris::rag::RowFilter;
+using iris::rag::SearchHit;
+using iris::rag::VectorFile;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr int kTopK = 10;
+constexpr int kOverfetch = 100;
+constexpr int kEf = 64;
+constexpr size_t kChunksPerDocument = 20;
+// VectorStoreImpl.FILTER_SCAN_MAX_ROWS and FILTER_SCAN_MAX_SELECTIVITY
+constexpr size_t kScanMaxRows = 16384;
+constexpr double kScanMaxSelectivity = 0.02;
+constexpr int64_t kNow = 1760000000000;       // fixed "now" so runs are comparable
+constexpr int64_t kDay = 86400000;
+const char* kFingerprint = "bench-model:v1";
+const char* kTags[] = {"work", "personal", "travel", "finance", "health", "recipes", "research", "archive"};
+
+void removeStore(const std::string& dir) {
+    for (const char* name : {"/store.vec", "/store.str", "/store.wal"}) {
+        ::unlink((dir + name).c_str());
+    }
+}
+
+struct NamedFilter {
+    const char* name;
+    RowFilter filter;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = static_cast<size_t>(bench::argOr(argc, argv, 1, 100000));
+    const int dim = static_cast<int>(bench::argOr(argc, argv, 2, 384));
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 3, 100));
+    const std::string dir = argc > 4 ? argv[4] : "/tmp/iris_filter_bench";
+    const int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::printf("Filtered search benchmark: %zu rows, dim %d, %zu queries, recall@%d\n\n", count, dim, queryCount,
+                kTopK);
+    removeStore(dir);
+
+    std::vector<float> data = bench::clusteredVectors(count, dim, std::max<size_t>(count / 100, 8), 1);
+    std::vector<float> queries(queryCount * dim);
+    {
+        std::mt19937 rng(7);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+        for (size_t q = 0; q < queryCount; q++) {
+            const float* source = data.data() + (q * 7919 % count) * dim;
+            for (int d = 0; d < dim; d++) {
+                queries[q * dim + d] = source[d] + noise(rng);
+            }
+        }
+    }
+
+    auto file = VectorFile::open(dir, dim, kFingerprint, false);
+    {
+        std::mt19937_64 rng(5);
+        std::uniform_int_distribution<int64_t> withinDay(0, kDay - 1);
+        std::vector<ChunkRecord> records;
+        for (size_t first = 0; first < count; first += records.size()) {
+            const size_t document = first / kChunksPerDocument;
+            const int64_t modified = kNow - static_cast<int64_t>(document * 7919 % 365) * kDay - withinDay(rng);
+            const std::string metadata = "{\"tags\":\"" + std::string(kTags[document % 8]) + "\",\"modified\":\"" +
+                                         std::to_string(modified) + "\"}";
+            records.assign(std::min(kChunksPerDocument, count - first), ChunkRecord());
+            for (size_t i = 0; i < records.size(); i++) {
+                records[i].id = "chunk-" + std::to_string(first + i);
+                records[i].documentId = "doc-" + std::to_string(document);
+                records[i].metadata = metadata;
+            }
+            file->append(records, data.data() + first * dim);
+        }
+    }
+
+    HnswIndex index(dim, 16, 200, count);
+    {
+        std::vector<int32_t> labels(count);
+        for (size_t i = 0; i < count; i++) labels[i] = static_cast<int32_t>(i);
+        bench::Timer timer;
+        index.addBatch(labels.data(), data.data(), count, threads);
+        std::printf("HNSW build (%d threads): %.0f ms\n", threads, timer.elapsedMs());
+    }
+
+    std::vector<NamedFilter> filters(5);
+    filters[0].name = "one document";
+    filters[0].filter.documentIds = {"doc-42"};
+    filters[1].name = "last 7 days";
+    filters[1].filter.modifiedFrom = kNow - 7 * kDay;
+    filters[2].name = "work, last 30 days";
+    filters[2].filter.tags = {"work"};
+    filters[2].filter.modifiedFrom = kNow - 30 * kDay;
+    filters[3].name = "tag work";
+    filters[3].filter.tags = {"work"};
+    filters[4].name = "any of three tags";
+    filters[4].filter.tags = {"work", "personal", "travel"};
+
+    {
+        // The first tag or date filter builds the bitmaps from the stored metadata
+        bench::Timer timer;
+        file->filterRows(filters[3].filter);
+        std::printf("facet bitmaps built on first filter: %.1f ms\n\n", timer.elapsedMs());
+    }
+
+    bool exact = true;
+    std::printf("%-20s %7s %9s %-10s %8s %10s %10s\n", "filter", "rows", "select", "method", "recall", "mean(us)",
+                "p99(us)");
+    for (const NamedFilter& named : filters) {
+        std::vector<double> filterLatencies;
+        RowBitmap rows;
+        for (size_t q = 0; q < queryCount; q++) {
+            bench::Timer timer;
+            rows = file->filterRows(named.filter);
+            filterLatencies.push_back(timer.elapsedUs());
+        }
+        const size_t matching = rows.cardinality();
+        const double selectivity = static_cast<double>(matching) / count;
+
+        std::vector<std::vector<SearchHit>> truth(queryCount);
+        for (size_t q = 0; q < queryCount; q++) {
+            truth[q] = file->rescore(queries.data() + q * dim, rows.rows(), kTopK);
+        }
+
+        for (const char* method : {"overfetch", "hnsw", "scan", "auto"}) {
+            const std::string name = method;
+            std::vector<double> latencies;
+            double recall = 0.0;
+            for (size_t q = 0; q < queryCount; q++) {
+                const float* query = queries.data() + q * dim;
+                bench::Timer timer;
+                std::vector<SearchHit> found;
+                if (name == "overfetch") {
+                    for (const SearchHit& hit : index.search(query, kOverfetch, std::max(kEf, kOverfetch))) {
+                        if (rows.contains(static_cast<uint32_t>(hit.label)) && found.size() < kTopK) {
+                            found.push_back(hit);
+                        }
+                    }
+                } else if (name == "hnsw" ||
+                           (name == "auto" && matching > kScanMaxRows && selectivity >= kScanMaxSelectivity)) {
+                    found = index.search(query, kTopK, kEf, &rows);
+                } else {
+                    found = file->exactSearch(query, kTopK, &rows);
+                }
+                latencies.push_back(timer.elapsedUs());
+                recall += bench::recallAt(truth[q], found);
+            }
+            recall /= queryCount;
+            if (name == "scan" && recall < 0.999) {
+                exact = false;
+            }
+            std::printf("%-20s %7zu %8.2f%% %-10s %8.3f %10.0f %10.0f\n", named.name, matching, selectivity * 100.0,
+                        method, recall, bench::mean(latencies), bench::percentile(latencies, 0.99));
+        }
+        std::printf("%-20s %7s %9s %-10s %8s %10.1f\n\n", "", "", "", "(filter)", "", bench::mean(filterLatencies));
+    }
+
+    file.reset();
+    removeStore(dir);
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,68 @@
+/**
+ * Recall@10 versus latency for HnswIndex against the exact brute-force scan.
+ *
+ * Usage: hnsw_bench [count=20000] [dim=384] [queries=200] [threads=hw]
+ */
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "../hnsw_index.h"
+#include "bench_common.h"
+
+using iris::rag::HnswIndex;
+using iris::rag::SearchHit;
+namespace bench = iris::bench;
+
+int main(int argc, char** argv) {
+    const size_t count = static_cast<size_t>(bench::argOr(argc, argv, 1, 20000));
+    const int dim = static_cast<int>(bench::argOr(argc, argv, 2, 384));
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 3, 200));
+    const int threads = static_cast<int>(bench::argOr(argc, argv, 4, std::thread::hardware_concurrency()));
+    const int k = 10;
+
+    std::printf("HNSW benchmark: %zu vectors, dim %d, %zu queries, %d build threads\n",
+                count, dim, queryCount, threads);
+
+    const size_t clusters = std::max<size_t>(count / 100, 8);
+    std::vector<float> data = bench::clusteredVectors(count, dim, clusters, 1);
+    std::vector<float> queries = bench::clusteredVectors(queryCount, dim, clusters, 1 + count);
+    std::vector<int32_t> labels(count);
+    for (size_t i = 0; i < count; i++) {
+        labels[i] = static_cast<int32_t>(i);
+    }
+
+    HnswIndex index(dim, 16, 200, count);
+    bench::Timer buildTimer;
+    index.addBatch(labels.data(), data.data(), count, threads);
+    const double buildMs = buildTimer.elapsedMs();
+    std::printf("build: %.1f ms (%.0f vectors/s)\n\n", buildMs, count / (buildMs / 1000.0));
+
+    std::vector<std::vector<SearchHit>> truth(queryCount);
+    std::vector<double> exactUs;
+    for (size_t q = 0; q < queryCount; q++) {
+        bench::Timer timer;
+        truth[q] = index.exactSearch(queries.data() + q * dim, k);
+        exactUs.push_back(timer.elapsedUs());
+    }
+
+    std::printf("%-12s %10s %12s %12s\n", "mode", "recall@10", "mean (us)", "p99 (us)");
+    std::printf("%-12s %10.4f %12.1f %12.1f\n", "brute-force", 1.0, bench::mean(exactUs),
+                bench::percentile(exactUs, 0.99));
+
+    for (int ef : {10, 16, 32, 64, 128, 256}) {
+        std::vector<double> latencies;
+        double recall = 0.0;
+        for (size_t q = 0; q < queryCount; q++) {
+            bench::Timer timer;
+            std::vector<SearchHit> hits = index.search(queries.data() + q * dim, k, ef);
+            latencies.push_back(timer.elapsedUs());
+            recall += bench::recallAt(truth[q], hits);
+        }
+        char mode[32];
+        std::snprintf(mode, sizeof(mode), "hnsw ef=%d", ef);
+        std::printf("%-12s %10.4f %12.1f %12.1f\n", mode, recall / queryCount, bench::mean(latencies),
+                    bench::percentile(latencies, 0.99));
+    }
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * Training time, memory, recall@10 and latency of IvfPqIndex against the exact
+ * scan of a VectorFile.
+ *
+ * The corpus is written to a store, the quantizers are trained on a random
+ * sample of it, and every row is then encoded. Each nprobe setting is measured
+ * on the raw ADC ranking and with the ADC shortlist rescored from the store's
+ * f32 rows (VectorFile::rescore), which is how VectorStoreImpl uses the index.
+ * Queries are noisy copies of corpus rows.
+ *
+ * Usage: ivfpq_bench [count=100000] [dim=384] [nlist=256] [subquantizers=48] [queries=100]
+ *                    [dir=/tmp/iris_ivfpq_bench]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../ivf_pq_index.h"
+#include "../vector_file.h"
+#include "bench_common.h"
+
+using iris::rag::ChunkRecord;
+using iris::rag::IvfPqIndex;
+using iris::rag::SearchHit;
+using iris::rag::VectorFile;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr int kTopK = 10;
+constexpr int kRescoreCandidates = 100;
+constexpr size_t kTrainingSamples = 20000;
+const char* kFingerprint = "bench-model:v1";
+
+void removeStore(const std::string& dir) {
+    for (const char* name : {"/store.vec", "/store.str", "/store.wal", "/ivfpq.idx"}) {
+        ::unlink((dir + name).c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = static_cast<size_t>(bench::argOr(argc, argv, 1, 100000));
+    const int dim = static_cast<int>(bench::argOr(argc, argv, 2, 384));
+    const int nlist = static_cast<int>(bench::argOr(argc, argv, 3, 256));
+    const int subquantizers = static_cast<int>(bench::argOr(argc, argv, 4, 48));
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 5, 100));
+    const std::string dir = argc > 6 ? argv[6] : "/tmp/iris_ivfpq_bench";
+    const int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::printf("IVF-PQ benchmark: %zu vectors, dim %d, nlist %d, M %d, %zu queries, recall@%d\n\n", count, dim,
+                nlist, subquantizers, queryCount, kTopK);
+    removeStore(dir);
+
+    std::vector<float> data = bench::clusteredVectors(count, dim, std::max<size_t>(count / 100, 8), 1);
+    std::vector<float> queries(queryCount * dim);
+    {
+        std::mt19937 rng(7);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+        for (size_t q = 0; q < queryCount; q++) {
+            const float* source = data.data() + (q * 7919 % count) * dim;
+            for (int d = 0; d < dim; d++) {
+                queries[q * dim + d] = source[d] + noise(rng);
+            }
+        }
+    }
+
+    auto file = VectorFile::open(dir, dim, kFingerprint, false);
+    constexpr size_t kBatch = 512;
+    for (size_t first = 0; first < count; first += kBatch) {
+        const size_t n = std::min(kBatch, count - first);
+        std::vector<ChunkRecord> records(n);
+        for (size_t i = 0; i < n; i++) {
+            records[i].id = "chunk-" + std::to_string(first + i);
+            records[i].documentId = "doc";
+        }
+        file->append(records, data.data() + first * dim);
+    }
+
+    // Train on a random sample, then encode every row
+    IvfPqIndex index(dim, nlist, subquantizers);
+    {
+        std::vector<size_t> order(count);
+        for (size_t i = 0; i < count; i++) {
+            order[i] = i;
+        }
+        std::shuffle(order.begin(), order.end(), std::mt19937_64(3));
+        const size_t sampleCount = std::min(kTrainingSamples, count);
+        std::vector<float> samples(sampleCount * dim);
+        for (size_t i = 0; i < sampleCount; i++) {
+            std::copy_n(data.data() + order[i] * dim, dim, samples.data() + i * dim);
+        }
+        bench::Timer trainTimer;
+        index.train(samples.data(), sampleCount, 10, threads);
+        std::printf("train on %zu samples (%d threads): %.0f ms\n", sampleCount, threads, trainTimer.elapsedMs());
+    }
+    {
+        std::vector<int32_t> labels(count);
+        for (size_t i = 0; i < count; i++) {
+            labels[i] = static_cast<int32_t>(i);
+        }
+        bench::Timer addTimer;
+        index.add(labels.data(), data.data(), count);
+        const double addMs = addTimer.elapsedMs();
+        std::printf("encode %zu rows: %.0f ms, %.0f rows/s\n", count, addMs, count / (addMs / 1000.0));
+    }
+
+    bench::Timer saveTimer;
+    index.save(dir + "/ivfpq.idx");
+    std::printf("save: %.1f ms; ", saveTimer.elapsedMs());
+    bench::Timer loadTimer;
+    const bool reloaded = IvfPqIndex::load(dir + "/ivfpq.idx")->size() == count;
+    std::printf("load: %.1f ms (%s)\n", loadTimer.elapsedMs(), reloaded ? "ok" : "MISMATCH");
+    std::printf("bytes/vec: %zu (f32 %zu)\n\n", sizeof(int32_t) + subquantizers, dim * sizeof(float));
+
+    std::vector<std::vector<SearchHit>> truth(queryCount);
+    std::vector<double> exactLatencies;
+    for (size_t q = 0; q < queryCount; q++) {
+        bench::Timer timer;
+        truth[q] = file->exactSearch(queries.data() + q * dim, kTopK);
+        exactLatencies.push_back(timer.elapsedUs());
+    }
+    std::printf("%-8s %8s %9s %10s %10s\n", "nprobe", "rescore", "recall", "mean(us)", "p99(us)");
+    std::printf("%-8s %8s %9.3f %10.0f %10.0f\n", "exact", "-", 1.0, bench::mean(exactLatencies),
+                bench::percentile(exactLatencies, 0.99));
+
+    for (int nprobe : {1, 4, 8, 16, 32, 64}) {
+        for (bool rescore : {false, true}) {
+            std::vector<double> latencies;
+            double recall = 0.0;
+            for (size_t q = 0; q < queryCount; q++) {
+                const float* query = queries.data() + q * dim;
+                bench::Timer timer;
+                std::vector<SearchHit> found;
+                if (rescore) {
+                    std::vector<uint32_t> rows;
+                    for (const SearchHit& hit : index.search(query, kRescoreCandidates, nprobe)) {
+                        rows.push_back(static_cast<uint32_t>(hit.label));
+                    }
+                    found = file->rescore(query, std::move(rows), kTopK);
+                } else {
+                    found = index.search(query, kTopK, nprobe);
+                }
+                latencies.push_back(timer.elapsedUs());
+                recall += bench::recallAt(truth[q], found);
+            }
+            std::printf("%-8d %8s %9.3f %10.0f %10.0f\n", nprobe, rescore ? "100" : "-", recall / queryCount,
+                        bench::mean(latencies), bench::percentile(latencies, 0.99));
+        }
+    }
+
+    file.reset();
+    removeStore(dir);
+    return reloaded ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+/**
+ * Per-dimension microbenchmarks for the block similarity kernels.
+ *
+ * For each dimension a block of vectors (~32 MB of f32, so it does not sit in
+ * cache) is scored against one query. "double-ref" mirrors the previous Kotlin
+ * loop (double accumulation, norms recomputed); "scalar" is the portable table
+ * and "simd" is whatever the dispatcher selected on this CPU.
+ *
+ * Usage: kernels_bench [repeats=5]
+ */
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../vector_kernels.h"
+#include "bench_common.h"
+
+namespace kernels = iris::rag::kernels;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr size_t kBlockBytes = 32u << 20;
+
+template <typename Fn>
+double bestNsPerVector(int repeats, size_t count, Fn&& fn) {
+    double best = 1e30;
+    for (int r = 0; r < repeats; r++) {
+        bench::Timer timer;
+        fn();
+        best = std::min(best, timer.elapsedUs() * 1000.0 / count);
+    }
+    return best;
+}
+
+float doubleReferenceCosine(const float* a, const float* b, size_t dim) {
+    double dot = 0.0, na = 0.0, nb = 0.0;
+    for (size_t i = 0; i < dim; i++) {
+        dot += a[i] * b[i];
+        na += a[i] * a[i];
+        nb += b[i] * b[i];
+    }
+    return static_cast<float>(dot / (std::sqrt(na) * std::sqrt(nb)));
+}
+
+void row(const char* kind, const char* impl, double nsPerVector, size_t bytesPerVector, double maxError) {
+    std::printf("  %-6s %-10s %10.1f ns/vec %8.2f GB/s   max|err| %.2e\n", kind, impl, nsPerVector,
+                bytesPerVector / nsPerVector, maxError);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const int repeats = static_cast<int>(bench::argOr(argc, argv, 1, 5));
+    std::printf("Vector kernel benchmark (dispatch: %s)\n", kernels::backendName());
+
+    std::mt19937 rng(7);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::uniform_int_distribution<int> int8Dist(-127, 127);
+
+    for (size_t dim : {384u, 768u, 1024u, 4096u}) {
+        const size_t count = kBlockBytes / (dim * sizeof(float));
+        const size_t words = (dim + 63) / 64;
+        std::printf("\ndim %zu, %zu vectors\n", dim, count);
+
+        std::vector<float> block(count * dim);
+        std::vector<float> query(dim);
+        for (float& v : block) v = normal(rng);
+        for (float& v : query) v = normal(rng);
+
+        std::vector<uint16_t> halfBlock(block.size());
+        kernels::floatToHalfArray(block.data(), halfBlock.data(), block.size());
+
+        std::vector<int8_t> i8Block(block.size());
+        std::vector<int8_t> i8Query(dim);
+        for (int8_t& v : i8Block) v = static_cast<int8_t>(int8Dist(rng));
+        for (int8_t& v : i8Query) v = static_cast<int8_t>(int8Dist(rng));
+
+        std::vector<uint64_t> bitBlock(count * words);
+        std::vector<uint64_t> bitQuery(words);
+        for (uint64_t& w : bitBlock) w = (static_cast<uint64_t>(rng()) << 32) | rng();
+        for (uint64_t& w : bitQuery) w = (static_cast<uint64_t>(rng()) << 32) | rng();
+
+        std::vector<float> reference(count), scores(count);
+        std::vector<int32_t> i8Reference(count), i8Scores(count);
+        std::vector<uint32_t> bitReference(count), bitScores(count);
+
+        // f32: the previous Kotlin-equivalent loop, then portable and SIMD kernels
+        const double refNs = bestNsPerVector(repeats, count, [&] {
+            for (size_t i = 0; i < count; i++) {
+                reference[i] = doubleReferenceCosine(query.data(), block.data() + i * dim, dim);
+            }
+        });
+        row("f32", "double-ref", refNs, dim * sizeof(float), 0.0);
+
+        for (bool scalar : {true, false}) {
+            kernels::useScalarKernels(scalar);
+            const double ns = bestNsPerVector(repeats, count, [&] {
+                kernels::dotBlockF32(query.data(), block.data(), count, dim, scores.data());
+            });
+            // Compare as cosine so the error is on the same scale as the reference
+            const float queryNorm = std::sqrt(kernels::dotF32(query.data(), query.data(), dim));
+            double maxError = 0.0;
+            for (size_t i = 0; i < count; i += 97) {
+                const float* v = block.data() + i * dim;
+                const float cosine = scores[i] / (queryNorm * std::sqrt(kernels::dotF32(v, v, dim)));
+                maxError = std::max(maxError, static_cast<double>(std::fabs(cosine - reference[i])));
+            }
+            row("f32", kernels::backendName(), ns, dim * sizeof(float), maxError);
+        }
+
+        for (bool scalar : {true, false}) {
+            kernels::useScalarKernels(scalar);
+            const double ns = bestNsPerVector(repeats, count, [&] {
+                kernels::dotBlockF16(query.data(), halfBlock.data(), count, dim, scores.data());
+            });
+            double maxError = 0.0;
+            for (size_t i = 0; i < count; i += 97) {
+                const float exact = kernels::dotF32(query.data(), block.data() + i * dim, dim);
+                maxError = std::max(maxError, static_cast<double>(std::fabs(scores[i] - exact) / std::sqrt(dim)));
+            }
+            row("f16", kernels::backendName(), ns, dim * sizeof(uint16_t), maxError);
+        }
+
+        kernels::useScalarKernels(true);
+        kernels::dotBlockI8(i8Query.data(), i8Block.data(), count, dim, i8Reference.data());
+        for (bool scalar : {true, false}) {
+            kernels::useScalarKernels(scalar);
+            const double ns = bestNsPerVector(repeats, count, [&] {
+                kernels::dotBlockI8(i8Query.data(), i8Block.data(), count, dim, i8Scores.data());
+            });
+            double maxError = 0.0;
+            for (size_t i = 0; i < count; i++) {
+                maxError = std::max(maxError, std::fabs(static_cast<double>(i8Scores[i] - i8Reference[i])));
+            }
+            row("int8", kernels::backendName(), ns, dim, maxError);
+        }
+
+        kernels::useScalarKernels(true);
+        kernels::hammingBlock(bitQuery.data(), bitBlock.data(), count, words, bitReference.data());
+        for (bool scalar : {true, false}) {
+            kernels::useScalarKernels(scalar);
+            const double ns = bestNsPerVector(repeats, count, [&] {
+                kernels::hammingBlock(bitQuery.data(), bitBlock.data(), count, words, bitScores.data());
+            });
+            double maxError = 0.0;
+            for (size_t i = 0; i < count; i++) {
+                maxError = std::max(maxError,
+                                    std::fabs(static_cast<double>(bitScores[i]) - bitReference[i]));
+            }
+            row("binary", kernels::backendName(), ns, words * sizeof(uint64_t), maxError);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * Throughput of TextNormalizer on PDF-like and plain text of 1, 4 and 16 MB,
+ * with the selected byte-scan kernel and with the portable one, against a
+ * split/trim/rebuild baseline shaped like the Kotlin path it replaces.
+ *
+ * PDF-like text is wrapped at about 72 columns, with a tenth of the wraps
+ * hyphenating a word, layout runs of spaces, non-breaking spaces, "fi"/"fl"
+ * ligatures and decomposed accents. Plain text is the same sentences without
+ * any of that, so it shows the fast path alone.
+ *
+ * Usage: normalizer_bench [maxMegabytes=16]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "../text_normalizer.h"
+#include "../vector_kernels.h"
+#include "bench_common.h"
+
+using iris::rag::NormalizedText;
+using iris::rag::TextNormalizer;
+namespace bench = iris::bench;
+namespace kernels = iris::rag::kernels;
+
+namespace {
+
+class Corpus {
+public:
+    explicit Corpus(uint64_t seed) : rng_(seed) {
+        const char* syllables[] = {"ba", "ce", "di", "fo", "gu", "ha", "ke", "li", "mo", "nu",
+                                   "pa", "re", "si", "to", "vu", "wa", "fi", "fl", "tra", "ste"};
+        for (size_t r = 0; r < 5000; r++) {
+            std::string word;
+            const size_t parts = 1 + rng_() % 4;
+            for (size_t p = 0; p < parts; p++) {
+                word += syllables[rng_() % (sizeof(syllables) / sizeof(*syllables))];
+            }
+            words_.push_back(word);
+        }
+    }
+
+    std::string document(size_t bytes, bool pdf) {
+        std::string text;
+        text.reserve(bytes + 4096);
+        size_t column = 0;
+        while (text.size() < bytes) {
+            const size_t sentences = 2 + rng_() % 7;
+            for (size_t s = 0; s < sentences; s++) {
+                const size_t count = 6 + rng_() % 19;
+                for (size_t w = 0; w < count; w++) {
+                    std::string word = words_[rng_() % words_.size()];
+                    if (w == 0) {
+                        word[0] = static_cast<char>(word[0] - 'a' + 'A');
+                    }
+                    if (pdf) {
+                        word = pdfWord(word);
+                    }
+                    const bool wrap = pdf && column + word.size() > 72;
+                    if (wrap && word.size() > 5 && rng_() % 10 == 0) {
+                        const size_t cut = word.size() / 2;
+                        text += word.substr(0, cut) + "-\n" + word.substr(cut);
+                        column = word.size() - cut;
+                    } else {
+                        if (wrap) {
+                            text += '\n';
+                            column = 0;
+                        }
+                        text += word;
+                        column += word.size();
+                    }
+                    text += w + 1 == count ? "." : "";
+                    text += pdf && rng_() % 20 == 0 ? "   " : " ";
+                    column += 2;
+                }
+            }
+            text += "\n\n";
+            column = 0;
+        }
+        return text;
+    }
+
+private:
+    std::mt19937_64 rng_;
+    std::vector<std::string> words_;
+
+    // Ligatures, non-breaking spaces and decomposed accents as PDF extraction leaves them
+    std::string pdfWord(const std::string& word) {
+        std::string out;
+        for (size_t i = 0; i < word.size(); i++) {
+            if (word.compare(i, 2, "fi") == 0) {
+                out += "\xEF\xAC\x81";
+                i++;
+            } else if (word.compare(i, 2, "fl") == 0) {
+                out += "\xEF\xAC\x82";
+                i++;
+            } else {
+                out += word[i];
+                if (word[i] == 'e' && rng_() % 16 == 0) {
+                    out += "\xCC\x81";
+                }
+            }
+        }
+        if (rng_() % 50 == 0) {
+            out += "\xC2\xA0";
+        }
+        return out;
+    }
+};
+
+/**
+ * Split into lines, trim each, rebuild, then split sentences at [.!?] followed
+ * by whitespace into separate strings: the shape of the replaced Kotlin code
+ */
+size_t baseline(const std::string& text) {
+    std::vector<std::string> lines;
+    size_t start = 0;
+    while (start <= text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        std::string line = text.substr(start, end - start);
+        const size_t first = line.find_first_not_of(" \t");
+        const size_t last = line.find_last_not_of(" \t");
+        if (first != std::string::npos) {
+            lines.push_back(line.substr(first, last - first + 1));
+        }
+        start = end + 1;
+    }
+    std::string joined;
+    for (const std::string& line : lines) {
+        joined += line;
+        joined += '\n';
+    }
+    std::vector<std::string> sentences;
+    std::string current;
+    for (size_t i = 0; i < joined.size(); i++) {
+        current += joined[i];
+        const char c = joined[i];
+        if ((c == '.' || c == '!' || c == '?') && i + 1 < joined.size() &&
+            (joined[i + 1] == ' ' || joined[i + 1] == '\n')) {
+            sentences.push_back(current);
+            current.clear();
+        }
+    }
+    if (!current.empty()) {
+        sentences.push_back(current);
+    }
+    return sentences.size();
+}
+
+double bestMs(int repeats, const std::function<void()>& run) {
+    double best = 1e300;
+    for (int r = 0; r < repeats; r++) {
+        bench::Timer timer;
+        run();
+        best = std::min(best, timer.elapsedMs());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t maxMegabytes = static_cast<size_t>(bench::argOr(argc, argv, 1, 16));
+
+    Corpus corpus(11);
+    std::printf("Normalizer benchmark: %s kernels\n\n", kernels::backendName());
+    std::printf("%-6s %-6s %12s %12s %12s %10s %10s %10s\n", "MB", "text", "simd", "scalar", "baseline", "sentences",
+                "joined", "out/in");
+    for (size_t megabytes : {size_t{1}, size_t{4}, size_t{16}}) {
+        if (megabytes > maxMegabytes) {
+            break;
+        }
+        for (bool pdf : {false, true}) {
+            const std::string text = corpus.document(megabytes << 20, pdf);
+            NormalizedText result;
+
+            kernels::useScalarKernels(false);
+            const double simdMs = bestMs(3, [&] { result = TextNormalizer::normalize(text, {pdf}); });
+            kernels::useScalarKernels(true);
+            const double scalarMs = bestMs(3, [&] { TextNormalizer::normalize(text, {pdf}); });
+            kernels::useScalarKernels(false);
+            size_t baselineSentences = 0;
+            const double baselineMs = bestMs(3, [&] { baselineSentences = baseline(text); });
+
+            const double mb = static_cast<double>(text.size()) / (1 << 20);
+            std::printf("%-6zu %-6s %8.0fMB/s %8.0fMB/s %8.0fMB/s %10zu %10zu %9.3f\n", megabytes,
+                        pdf ? "pdf" : "plain", mb / (simdMs / 1000.0), mb / (scalarMs / 1000.0),
+                        mb / (baselineMs / 1000.0), result.sentences.size(), result.dehyphenated,
+                        static_cast<double>(result.text.size()) / text.size());
+            if (baselineSentences == 0) {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,193 @@
+/**
+ * Context packing: relevance, redundancy, budget use and KV prefix reuse of
+ * MMR packing against filling the budget in score order.
+ *
+ * A conversation of `turns` questions moves between topics, a new one every
+ * 5 turns on average. Each topic has 20 relevant chunks of 60-400 tokens
+ * (Zipfian IDs over a 32k vocabulary), 4 of them near-copies of another (a
+ * few tokens changed) that score like their original, as repeated
+ * boilerplate would. Every turn retrieves the topic's top 12 chunks under
+ * noisy scores, so consecutive turns on one topic see mostly the same chunks
+ * in a different order. Relevance counts a chunk and its copies once; copy
+ * pairs are a chunk packed together with a copy, or two copies of one chunk.
+ * Prefix reuse is the number of leading context tokens a prompt shares with
+ * the previous one, which is what a KV cache can keep.
+ *
+ * Usage: pack_bench [turns=2000] [budget=1024]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../context_packer.h"
+#include "bench_common.h"
+
+using iris::rag::ContextPacker;
+using iris::rag::PackCandidate;
+using iris::rag::PackedContext;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr size_t kTopics = 50;
+constexpr size_t kChunksPerTopic = 20;
+constexpr size_t kCopiesPerTopic = 4;
+constexpr size_t kRetrieved = 12;
+constexpr int32_t kVocabulary = 32000;
+const std::vector<int32_t> kSeparator = {13};
+
+struct Chunk {
+    std::vector<int32_t> tokens;
+    int32_t copyOf = -1;
+};
+
+std::vector<Chunk> makeChunks(std::mt19937_64& rng) {
+    std::vector<double> weights(kVocabulary);
+    for (int32_t t = 0; t < kVocabulary; t++) {
+        weights[t] = 1.0 / static_cast<double>(t + 1);
+    }
+    std::discrete_distribution<int32_t> token(weights.begin(), weights.end());
+    std::uniform_int_distribution<size_t> length(60, 400);
+
+    std::vector<Chunk> chunks(kTopics * kChunksPerTopic);
+    for (size_t topic = 0; topic < kTopics; topic++) {
+        const size_t base = topic * kChunksPerTopic;
+        for (size_t i = 0; i < kChunksPerTopic; i++) {
+            Chunk& chunk = chunks[base + i];
+            if (i >= kChunksPerTopic - kCopiesPerTopic) {
+                const size_t original = base + rng() % (kChunksPerTopic - kCopiesPerTopic);
+                chunk.copyOf = static_cast<int32_t>(original);
+                chunk.tokens = chunks[original].tokens;
+                for (int edit = 0; edit < 3; edit++) {
+                    chunk.tokens[rng() % chunk.tokens.size()] = token(rng);
+                }
+                continue;
+            }
+            chunk.tokens.resize(length(rng));
+            for (int32_t& t : chunk.tokens) {
+                t = token(rng);
+            }
+        }
+    }
+    return chunks;
+}
+
+size_t sharedPrefix(const std::vector<int32_t>& a, const std::vector<int32_t>& b) {
+    const size_t n = std::min(a.size(), b.size());
+    size_t i = 0;
+    while (i < n && a[i] == b[i]) {
+        i++;
+    }
+    return i;
+}
+
+/**
+ * Candidates in descending score order until the next one does not fit
+ */
+PackedContext fillByScore(const std::vector<PackCandidate>& candidates, size_t budget) {
+    PackedContext packed;
+    size_t used = 0;
+    for (const PackCandidate& c : candidates) {
+        if (used + c.tokenCount + kSeparator.size() > budget) {
+            continue;
+        }
+        used += c.tokenCount + kSeparator.size();
+        packed.labels.push_back(c.label);
+        packed.tokens.insert(packed.tokens.end(), c.tokens, c.tokens + c.tokenCount);
+        packed.tokens.insert(packed.tokens.end(), kSeparator.begin(), kSeparator.end());
+    }
+    return packed;
+}
+
+struct Totals {
+    double relevance = 0.0;
+    size_t copies = 0;
+    size_t tokens = 0;
+    size_t prefix = 0;
+    size_t overBudget = 0;
+    std::vector<double> us;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t turns = static_cast<size_t>(bench::argOr(argc, argv, 1, 2000));
+    const size_t budget = static_cast<size_t>(bench::argOr(argc, argv, 2, 1024));
+
+    std::mt19937_64 rng(11);
+    const std::vector<Chunk> chunks = makeChunks(rng);
+    std::vector<float> baseScore(chunks.size());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        baseScore[i] = 1.0f - 0.03f * static_cast<float>(i % kChunksPerTopic);
+    }
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (chunks[i].copyOf >= 0) {
+            baseScore[i] = baseScore[chunks[i].copyOf] - 0.01f; // a copy matches the query as well as its original
+        }
+    }
+    std::normal_distribution<float> noise(0.0f, 0.08f);
+
+    std::printf("Context packing benchmark: %zu turns, budget %zu tokens, %zu candidates per turn\n\n", turns,
+                budget, kRetrieved);
+
+    ContextPacker packer;
+    Totals byScore, mmr;
+    std::vector<int32_t> lastByScore, lastMmr;
+    size_t topic = 0;
+    for (size_t turn = 0; turn < turns; turn++) {
+        if (rng() % 5 == 0) {
+            topic = rng() % kTopics;
+        }
+        std::vector<std::pair<float, size_t>> scored;
+        for (size_t i = 0; i < kChunksPerTopic; i++) {
+            const size_t id = topic * kChunksPerTopic + i;
+            scored.emplace_back(baseScore[id] + noise(rng), id);
+        }
+        std::sort(scored.begin(), scored.end(), std::greater<>());
+        scored.resize(kRetrieved);
+
+        std::vector<PackCandidate> candidates;
+        for (const auto& [score, id] : scored) {
+            candidates.push_back({static_cast<int32_t>(id), score, chunks[id].tokens.data(), chunks[id].tokens.size()});
+        }
+
+        auto account = [&](Totals& totals, const PackedContext& packed, std::vector<int32_t>& last) {
+            std::vector<int32_t> roots;
+            for (int32_t label : packed.labels) {
+                const int32_t root = chunks[label].copyOf >= 0 ? chunks[label].copyOf : label;
+                if (std::find(roots.begin(), roots.end(), root) != roots.end()) {
+                    totals.copies++;
+                    continue;
+                }
+                roots.push_back(root);
+                totals.relevance += baseScore[label];
+            }
+            totals.tokens += packed.tokens.size();
+            totals.overBudget += packed.tokens.size() > budget;
+            totals.prefix += sharedPrefix(last, packed.tokens);
+            last = packed.tokens;
+        };
+
+        bench::Timer scoreTimer;
+        const PackedContext plain = fillByScore(candidates, budget);
+        byScore.us.push_back(scoreTimer.elapsedUs());
+        account(byScore, plain, lastByScore);
+
+        bench::Timer mmrTimer;
+        const PackedContext packed = packer.pack(candidates, budget, kSeparator);
+        mmr.us.push_back(mmrTimer.elapsedUs());
+        account(mmr, packed, lastMmr);
+    }
+
+    std::printf("%-14s %14s %12s %12s %14s %12s %10s\n", "packing", "relevance/turn", "copy pairs", "budget used",
+                "prefix reused", "over budget", "time (us)");
+    for (const auto& [name, totals] : {std::pair<const char*, const Totals&>{"score order", byScore},
+                                       std::pair<const char*, const Totals&>{"MMR + order", mmr}}) {
+        std::printf("%-14s %14.2f %12zu %11.1f%% %13.1f%% %12zu %10.1f\n", name, totals.relevance / turns,
+                    totals.copies, 100.0 * totals.tokens / (static_cast<double>(budget) * turns),
+                    100.0 * totals.prefix / std::max<size_t>(totals.tokens, 1), totals.overBudget,
+                    bench::mean(totals.us));
+    }
+    return mmr.copies * 20 <= byScore.copies && mmr.overBudget == 0 && mmr.prefix > byScore.prefix ? 0 : 1;
+}
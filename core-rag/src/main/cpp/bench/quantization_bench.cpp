@@ -0,0 +1,124 @@
+/**
+ * Memory, recall@10 and latency of VectorFile's quantized two-stage search.
+ *
+ * One store is written unquantized, then reopened as int8 and as binary (which
+ * re-encodes the codes in place). Each level is searched with several shortlist
+ * sizes; recall is measured against the exact f32 scan of the same store.
+ * Queries are noisy copies of corpus rows, as a retrieval query lands near the
+ * chunks that answer it.
+ *
+ * Usage: quantization_bench [count=20000] [dim=4096] [queries=100] [dir=/tmp/iris_quantization_bench]
+ */
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../vector_file.h"
+#include "bench_common.h"
+
+using iris::rag::ChunkRecord;
+using iris::rag::Quantization;
+using iris::rag::SearchHit;
+using iris::rag::VectorFile;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr int kTopK = 10;
+const char* kFingerprint = "bench-model:v1";
+
+void removeStore(const std::string& dir) {
+    for (const char* name : {"/store.vec", "/store.str", "/store.wal"}) {
+        ::unlink((dir + name).c_str());
+    }
+}
+
+const char* levelName(Quantization quantization) {
+    switch (quantization) {
+    case Quantization::kInt8:
+        return "int8";
+    case Quantization::kBinary:
+        return "binary";
+    case Quantization::kNone:
+        break;
+    }
+    return "f32";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = static_cast<size_t>(bench::argOr(argc, argv, 1, 20000));
+    const int dim = static_cast<int>(bench::argOr(argc, argv, 2, 4096));
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 3, 100));
+    const std::string dir = argc > 4 ? argv[4] : "/tmp/iris_quantization_bench";
+
+    std::printf("Quantization benchmark: %zu vectors, dim %d, %zu queries, recall@%d\n\n", count, dim, queryCount,
+                kTopK);
+    removeStore(dir);
+
+    const size_t clusters = std::max<size_t>(count / 100, 8);
+    std::vector<float> queries(queryCount * dim);
+    {
+        std::vector<float> data = bench::clusteredVectors(count, dim, clusters, 1);
+        std::mt19937 rng(7);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+        for (size_t q = 0; q < queryCount; q++) {
+            const float* source = data.data() + (q * 7919 % count) * dim;
+            for (int d = 0; d < dim; d++) {
+                queries[q * dim + d] = source[d] + noise(rng);
+            }
+        }
+        auto file = VectorFile::open(dir, dim, kFingerprint, false, Quantization::kNone);
+        constexpr size_t kBatch = 512;
+        for (size_t first = 0; first < count; first += kBatch) {
+            const size_t n = std::min(kBatch, count - first);
+            std::vector<ChunkRecord> records(n);
+            for (size_t i = 0; i < n; i++) {
+                records[i].id = "chunk-" + std::to_string(first + i);
+                records[i].documentId = "doc";
+            }
+            file->append(records, data.data() + first * dim);
+        }
+    }
+
+    // Ground truth from the exact f32 scan
+    std::vector<std::vector<SearchHit>> truth(queryCount);
+    {
+        auto file = VectorFile::open(dir, dim, kFingerprint, false);
+        for (size_t q = 0; q < queryCount; q++) {
+            truth[q] = file->exactSearch(queries.data() + q * dim, kTopK);
+        }
+    }
+
+    std::printf("%-7s %10s %10s %9s %10s %10s\n", "codes", "bytes/vec", "shortlist", "recall", "mean(us)", "p99(us)");
+    for (Quantization level : {Quantization::kNone, Quantization::kInt8, Quantization::kBinary}) {
+        bench::Timer encodeTimer;
+        auto file = VectorFile::open(dir, dim, kFingerprint, false, level);
+        if (level != Quantization::kNone) {
+            std::printf("(re-encoded %zu rows as %s in %.0f ms)\n", count, levelName(level), encodeTimer.elapsedMs());
+        }
+        const size_t bytes = level == Quantization::kNone ? dim * sizeof(float) : file->codeBytes();
+
+        const std::vector<int> shortlists =
+            level == Quantization::kNone ? std::vector<int>{kTopK} : std::vector<int>{kTopK, 40, 100, 400};
+        for (int shortlist : shortlists) {
+            std::vector<double> latencies;
+            double recall = 0.0;
+            for (size_t q = 0; q < queryCount; q++) {
+                bench::Timer timer;
+                std::vector<SearchHit> found = file->search(queries.data() + q * dim, kTopK, shortlist);
+                latencies.push_back(timer.elapsedUs());
+                recall += bench::recallAt(truth[q], found);
+            }
+            std::printf("%-7s %10zu %10d %9.3f %10.0f %10.0f\n", levelName(level), bytes, shortlist,
+                        recall / queryCount, bench::mean(latencies), bench::percentile(latencies, 0.99));
+        }
+    }
+
+    removeStore(dir);
+    return 0;
+}
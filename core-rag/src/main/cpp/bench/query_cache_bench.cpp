@@ -0,0 +1,117 @@
+/**
+ * Query cache: hit rate of the exact and semantic tiers on a skewed stream of
+ * repeated questions, false semantic hits, and the cost of each lookup.
+ *
+ * Each of 2000 intents has an embedding from clusteredVectors() (intents in one
+ * cluster are related but different questions) and is asked in three
+ * phrasings: two that normalize to the same text ("What is X?" / "what is x")
+ * and one that does not. Every phrasing's embedding is the intent's plus a
+ * little noise. Intents are drawn Zipf-distributed; the index version changes
+ * every 5000 queries, as if a document had been added.
+ *
+ * Usage: query_cache_bench [queries=20000] [dim=384] [min_similarity_pct=95]
+ */
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../query_cache.h"
+#include "bench_common.h"
+
+using iris::rag::QueryCache;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr size_t kIntents = 2000;
+constexpr int kTopK = 10;
+constexpr size_t kVersionEvery = 5000;
+
+struct Query {
+    size_t intent;
+    std::string text;
+    std::vector<float> embedding;
+};
+
+std::vector<Query> makeQueries(size_t count, int dim) {
+    const std::vector<float> intents = bench::clusteredVectors(kIntents, dim, kIntents / 10, 1);
+    std::mt19937_64 rng(7);
+    std::normal_distribution<float> noise(0.0f, 0.2f);
+    std::vector<double> weights(kIntents);
+    for (size_t i = 0; i < kIntents; i++) {
+        weights[i] = 1.0 / static_cast<double>(i + 1);
+    }
+    std::discrete_distribution<size_t> pickIntent(weights.begin(), weights.end());
+
+    std::vector<Query> queries(count);
+    for (Query& query : queries) {
+        query.intent = pickIntent(rng);
+        const std::string topic = "topic " + std::to_string(query.intent);
+        switch (rng() % 3) {
+            case 0: query.text = "What is " + topic + "?"; break;
+            case 1: query.text = "  what IS " + topic; break;
+            default: query.text = "Tell me about " + topic; break;
+        }
+        query.embedding.resize(dim);
+        for (int d = 0; d < dim; d++) {
+            query.embedding[d] = intents[query.intent * dim + d] + noise(rng);
+        }
+    }
+    return queries;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 1, 20000));
+    const int dim = static_cast<int>(bench::argOr(argc, argv, 2, 384));
+    const float minSimilarity = static_cast<float>(bench::argOr(argc, argv, 3, 95)) / 100.0f;
+
+    std::printf("Query cache benchmark: %zu queries over %zu intents, dim %d, similarity >= %.2f\n\n", queryCount,
+                kIntents, dim, minSimilarity);
+    const std::vector<Query> queries = makeQueries(queryCount, dim);
+
+    std::printf("%-9s %-16s %9s %10s %11s %12s %13s %9s\n", "capacity", "tiers", "hit rate", "semantic",
+                "false hits", "exact (us)", "similar (us)", "put (us)");
+    bool correct = true;
+    for (size_t capacity : {size_t{64}, size_t{256}, size_t{1024}}) {
+        for (bool semantic : {false, true}) {
+            QueryCache cache(capacity, minSimilarity);
+            std::vector<size_t> slotIntent(capacity);
+            std::vector<double> exactUs, similarUs, putUs;
+            size_t falseHits = 0;
+            for (size_t q = 0; q < queries.size(); q++) {
+                const Query& query = queries[q];
+                const uint64_t version = q / kVersionEvery;
+
+                bench::Timer exactTimer;
+                int slot = cache.lookupExact(query.text, version, kTopK);
+                exactUs.push_back(exactTimer.elapsedUs());
+                if (slot < 0 && semantic) {
+                    bench::Timer similarTimer;
+                    slot = cache.lookupSimilar(query.embedding.data(), dim, version, kTopK);
+                    similarUs.push_back(similarTimer.elapsedUs());
+                }
+                if (slot >= 0) {
+                    falseHits += slotIntent[slot] != query.intent;
+                    continue;
+                }
+                bench::Timer putTimer;
+                slot = cache.put(query.text, semantic ? query.embedding.data() : nullptr, dim, version, kTopK, 40.0,
+                                 10.0);
+                putUs.push_back(putTimer.elapsedUs());
+                slotIntent[slot] = query.intent;
+            }
+
+            const QueryCache::Stats stats = cache.stats();
+            correct = correct && falseHits <= stats.semanticHits / 100;
+            std::printf("%-9zu %-16s %8.1f%% %9.1f%% %11zu %12.2f %13.2f %9.2f\n", capacity,
+                        semantic ? "exact + semantic" : "exact", 100.0 * (stats.exactHits + stats.semanticHits) /
+                        stats.lookups, 100.0 * stats.semanticHits / stats.lookups, falseHits, bench::mean(exactUs),
+                        bench::mean(similarUs), bench::mean(putUs));
+        }
+    }
+    return correct ? 0 : 1;
+}
@@ -0,0 +1,174 @@
+/**
+ * Exact top-k scan: latency of the partitioned scan against pool size, and
+ * its results against a single-threaded reference that scores every row and
+ * sorts. Also times VectorFile::exactSearch, which runs on ScanPool::shared().
+ *
+ * Usage: scan_bench [count=100000] [dim=384] [queries=50] [max_threads=8] [dir=/tmp/iris_scan_bench]
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+#include "../exact_scan.h"
+#include "../vector_file.h"
+#include "../vector_kernels.h"
+#include "bench_common.h"
+
+using iris::rag::ChunkRecord;
+using iris::rag::ScanPool;
+using iris::rag::SearchHit;
+using iris::rag::TopK;
+using iris::rag::VectorFile;
+namespace bench = iris::bench;
+namespace kernels = iris::rag::kernels;
+
+namespace {
+
+constexpr int kTopK = 10;
+constexpr uint32_t kBlock = 256;
+
+/**
+ * Score everything, then sort; ties by row like TopK
+ */
+std::vector<SearchHit> referenceTopK(const float* query, const float* data, size_t count, int dim) {
+    std::vector<float> scores(count);
+    for (size_t i = 0; i < count; i++) {
+        scores[i] = kernels::dotF32(query, data + i * dim, dim);
+    }
+    std::vector<uint32_t> order(count);
+    std::iota(order.begin(), order.end(), 0u);
+    const size_t k = std::min<size_t>(kTopK, count);
+    std::partial_sort(order.begin(), order.begin() + k, order.end(), [&](uint32_t a, uint32_t b) {
+        return scores[a] > scores[b] || (scores[a] == scores[b] && a < b);
+    });
+    std::vector<SearchHit> hits(k);
+    for (size_t i = 0; i < k; i++) {
+        hits[i] = {static_cast<int32_t>(order[i]), scores[order[i]]};
+    }
+    return hits;
+}
+
+bool sameHits(const std::vector<SearchHit>& a, const std::vector<SearchHit>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].label != b[i].label) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void removeStore(const std::string& dir) {
+    for (const char* name : {"/store.vec", "/store.str", "/store.wal"}) {
+        ::unlink((dir + name).c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = static_cast<size_t>(bench::argOr(argc, argv, 1, 100000));
+    const int dim = static_cast<int>(bench::argOr(argc, argv, 2, 384));
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 3, 50));
+    const int maxThreads = static_cast<int>(bench::argOr(argc, argv, 4, 8));
+    const std::string dir = argc > 5 ? argv[5] : "/tmp/iris_scan_bench";
+
+    std::printf("Exact scan benchmark: %zu vectors, dim %d, %zu queries, top-%d, %u hardware threads\n\n", count,
+                dim, queryCount, kTopK, std::thread::hardware_concurrency());
+
+    // Normalized like the stores keep them, so dot products are cosine scores
+    std::vector<float> data = bench::clusteredVectors(count, dim, std::max<size_t>(count / 100, 8), 1);
+    std::vector<float> queries = bench::clusteredVectors(queryCount, dim, std::max<size_t>(count / 100, 8), 2);
+    for (std::vector<float>* vectors : {&data, &queries}) {
+        for (size_t i = 0; i < vectors->size() / dim; i++) {
+            float* v = vectors->data() + i * dim;
+            const float norm = std::sqrt(kernels::dotF32(v, v, dim));
+            for (int d = 0; d < dim; d++) v[d] /= norm;
+        }
+    }
+
+    std::vector<std::vector<SearchHit>> truth(queryCount);
+    std::vector<double> referenceUs;
+    for (size_t q = 0; q < queryCount; q++) {
+        bench::Timer timer;
+        truth[q] = referenceTopK(queries.data() + q * dim, data.data(), count, dim);
+        referenceUs.push_back(timer.elapsedUs());
+    }
+
+    bool exact = true;
+    std::printf("%-24s %8s %12s %12s %10s\n", "scan", "threads", "mean (us)", "p99 (us)", "matches");
+    std::printf("%-24s %8d %12.0f %12.0f %10s\n", "score all + sort", 1, bench::mean(referenceUs),
+                bench::percentile(referenceUs, 0.99), "-");
+
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        ScanPool pool(threads);
+        std::vector<double> latencies;
+        size_t matching = 0;
+        for (size_t q = 0; q < queryCount; q++) {
+            const float* query = queries.data() + q * dim;
+            bench::Timer timer;
+            std::vector<SearchHit> hits = iris::rag::parallelTopK(
+                pool, static_cast<uint32_t>(count), static_cast<size_t>(dim) * sizeof(float), kBlock, kTopK,
+                -1.0f, [&](uint32_t begin, uint32_t end, TopK& top) {
+                    float scores[kBlock];
+                    for (uint32_t first = begin; first < end; first += kBlock) {
+                        const uint32_t blockSize = std::min<uint32_t>(kBlock, end - first);
+                        kernels::dotBlockF32(query, data.data() + static_cast<size_t>(first) * dim, blockSize,
+                                             static_cast<size_t>(dim), scores);
+                        for (uint32_t i = 0; i < blockSize; i++) {
+                            if (scores[i] >= top.floor()) top.offer(scores[i], first + i);
+                        }
+                    }
+                });
+            latencies.push_back(timer.elapsedUs());
+            matching += sameHits(truth[q], hits);
+        }
+        exact = exact && matching == queryCount;
+        std::printf("%-24s %8d %12.0f %12.0f %6zu/%zu\n", "partitioned top-k", threads, bench::mean(latencies),
+                    bench::percentile(latencies, 0.99), matching, queryCount);
+    }
+
+    // The store's scan, on the shared pool
+    removeStore(dir);
+    {
+        auto file = VectorFile::open(dir, dim, "bench-model:v1", false);
+        std::vector<ChunkRecord> records(1024);
+        for (size_t first = 0; first < count; first += records.size()) {
+            records.resize(std::min<size_t>(1024, count - first));
+            for (size_t i = 0; i < records.size(); i++) {
+                records[i].id = "chunk-" + std::to_string(first + i);
+                records[i].documentId = "doc-" + std::to_string((first + i) / 20);
+            }
+            file->append(records, data.data() + first * dim);
+        }
+        for (float threshold : {-1.0f, 0.5f}) {
+            std::vector<double> latencies;
+            size_t matching = 0;
+            for (size_t q = 0; q < queryCount; q++) {
+                bench::Timer timer;
+                std::vector<SearchHit> hits = file->exactSearch(queries.data() + q * dim, kTopK, nullptr, threshold);
+                latencies.push_back(timer.elapsedUs());
+                std::vector<SearchHit> expected = truth[q];
+                expected.erase(std::remove_if(expected.begin(), expected.end(),
+                                              [&](const SearchHit& hit) { return hit.score < threshold; }),
+                               expected.end());
+                matching += sameHits(expected, hits);
+            }
+            exact = exact && matching == queryCount;
+            char name[32];
+            std::snprintf(name, sizeof(name), "VectorFile, score>=%.1f", threshold);
+            std::printf("%-24s %8d %12.0f %12.0f %6zu/%zu\n", name, ScanPool::shared().threads(),
+                        bench::mean(latencies), bench::percentile(latencies, 0.99), matching, queryCount);
+        }
+    }
+    removeStore(dir);
+    return exact ? 0 : 1;
+}
@@ -0,0 +1,264 @@
+/**
+ * TfIdfIndex against the map-based TF-IDF it replaced in RAGEngineImpl, on the
+ * same corpus: index memory, add and delete cost, and query latency.
+ *
+ * The map-based baseline is a C++ rendering of the Kotlin code: a term -> count
+ * hash map per chunk, a term -> (chunk -> count) map for document frequencies,
+ * a full scan of every chunk per query and a walk of every term per deleted
+ * chunk. JVM object headers and boxing make the Kotlin version larger and
+ * slower than this, so its numbers are a lower bound.
+ *
+ * Chunks are 80 words drawn from a Zipfian vocabulary of 50k words; queries
+ * are 2-4 words. search() is checked against exhaustiveSearch() (fresh norms)
+ * by top-k overlap, before and after deleting a tenth of the chunks.
+ *
+ * Usage: tfidf_bench [maxCount=100000] [queries=200]
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../text_tokenizer.h"
+#include "../tfidf_index.h"
+#include "bench_common.h"
+
+using iris::rag::SearchHit;
+using iris::rag::TfIdfIndex;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr int kTopK = 10;
+constexpr size_t kVocabulary = 50000;
+constexpr size_t kWordsPerChunk = 80;
+constexpr size_t kMinTermChars = 3;
+
+const std::vector<std::string> kStopWords = {"the", "and", "for", "are", "but", "not", "you", "all"};
+
+class ZipfWords {
+public:
+    explicit ZipfWords(uint64_t seed) : rng_(seed), uniform_(0.0, 1.0), cumulative_(kVocabulary) {
+        double sum = 0.0;
+        for (size_t r = 0; r < kVocabulary; r++) {
+            sum += 1.0 / static_cast<double>(r + 1);
+            cumulative_[r] = sum;
+        }
+        for (double& c : cumulative_) {
+            c /= sum;
+        }
+    }
+
+    size_t rank() {
+        const double u = uniform_(rng_);
+        return std::lower_bound(cumulative_.begin(), cumulative_.end(), u) - cumulative_.begin();
+    }
+
+private:
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> uniform_;
+    std::vector<double> cumulative_;
+};
+
+std::string word(size_t rank) {
+    return "term" + std::to_string(rank);
+}
+
+std::string makeChunk(ZipfWords& words) {
+    std::string text;
+    text.reserve(kWordsPerChunk * 9);
+    for (size_t i = 0; i < kWordsPerChunk; i++) {
+        text += word(words.rank());
+        text += i % 12 == 11 ? ". " : " ";
+    }
+    return text;
+}
+
+/**
+ * The replaced Kotlin index: hash maps of strings, cosine over every chunk
+ */
+class MapIndex {
+public:
+    void add(const std::string& id, std::string_view text) {
+        Chunk& chunk = chunks_[id];
+        chunk.terms = terms(text);
+        double sum = 0.0;
+        for (const auto& [term, tf] : chunk.terms) {
+            sum += static_cast<double>(tf) * tf;
+            termFrequencies_[term][id] = tf;
+        }
+        chunk.magnitude = std::sqrt(sum);
+    }
+
+    void remove(const std::string& id) {
+        chunks_.erase(id);
+        for (auto& entry : termFrequencies_) {
+            entry.second.erase(id);
+        }
+        for (auto it = termFrequencies_.begin(); it != termFrequencies_.end();) {
+            it = it->second.empty() ? termFrequencies_.erase(it) : std::next(it);
+        }
+    }
+
+    size_t search(std::string_view query) const {
+        const auto queryTerms = terms(query);
+        double sum = 0.0;
+        for (const auto& [term, tf] : queryTerms) {
+            sum += static_cast<double>(tf) * tf;
+        }
+        const double queryMagnitude = std::sqrt(sum);
+        std::vector<std::pair<double, const std::string*>> scored;
+        scored.reserve(chunks_.size());
+        for (const auto& [id, chunk] : chunks_) {
+            double dot = 0.0;
+            for (const auto& [term, tf] : queryTerms) {
+                auto it = chunk.terms.find(term);
+                dot += it == chunk.terms.end() ? 0.0 : static_cast<double>(tf) * it->second;
+            }
+            if (dot > 0.0) {
+                scored.emplace_back(dot / (queryMagnitude * chunk.magnitude), &id);
+            }
+        }
+        std::sort(scored.begin(), scored.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+        return std::min<size_t>(scored.size(), kTopK);
+    }
+
+    /**
+     * Hash nodes and strings, without allocator overhead
+     */
+    size_t memoryBytes() const {
+        constexpr size_t kNode = sizeof(void*) * 2;
+        size_t bytes = chunks_.bucket_count() * sizeof(void*);
+        for (const auto& [id, chunk] : chunks_) {
+            bytes += kNode + sizeof(id) + sizeof(chunk) + chunk.terms.bucket_count() * sizeof(void*);
+            for (const auto& entry : chunk.terms) {
+                bytes += kNode + sizeof(entry);
+            }
+        }
+        bytes += termFrequencies_.bucket_count() * sizeof(void*);
+        for (const auto& [term, postings] : termFrequencies_) {
+            bytes += kNode + sizeof(term) + sizeof(postings) + postings.bucket_count() * sizeof(void*);
+            bytes += postings.size() * (kNode + sizeof(std::pair<std::string, int>));
+        }
+        return bytes;
+    }
+
+private:
+    struct Chunk {
+        std::unordered_map<std::string, int> terms;
+        double magnitude = 0.0;
+    };
+
+    static std::unordered_map<std::string, int> terms(std::string_view text) {
+        std::unordered_map<std::string, int> counts;
+        for (std::string& token : iris::rag::tokenize(text)) {
+            if (token.size() >= kMinTermChars &&
+                std::find(kStopWords.begin(), kStopWords.end(), token) == kStopWords.end()) {
+                counts[std::move(token)]++;
+            }
+        }
+        return counts;
+    }
+
+    std::unordered_map<std::string, Chunk> chunks_;
+    std::unordered_map<std::string, std::unordered_map<std::string, int>> termFrequencies_;
+};
+
+struct Timing {
+    double mean;
+    double p99;
+};
+
+template <typename Search>
+Timing measure(const std::vector<std::string>& queries, Search&& search) {
+    std::vector<double> latencies;
+    for (const std::string& query : queries) {
+        bench::Timer timer;
+        search(query);
+        latencies.push_back(timer.elapsedUs());
+    }
+    return {bench::mean(latencies), bench::percentile(latencies, 0.99)};
+}
+
+double overlap(const TfIdfIndex& index, const std::vector<std::string>& queries) {
+    std::vector<double> recalls;
+    for (const std::string& query : queries) {
+        recalls.push_back(bench::recallAt(index.exhaustiveSearch(query, kTopK), index.search(query, kTopK)));
+    }
+    return bench::mean(recalls);
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t maxCount = static_cast<size_t>(bench::argOr(argc, argv, 1, 100000));
+    const size_t queryCount = static_cast<size_t>(bench::argOr(argc, argv, 2, 200));
+
+    std::printf("TF-IDF benchmark: %zu words per chunk, vocabulary %zu, %zu queries, top-%d\n\n", kWordsPerChunk,
+                kVocabulary, queryCount, kTopK);
+
+    ZipfWords queryWords(99);
+    std::vector<std::string> queries;
+    for (size_t q = 0; q < queryCount; q++) {
+        std::string query;
+        for (size_t t = 0; t < 2 + q % 3; t++) {
+            query += word(queryWords.rank()) + " ";
+        }
+        queries.push_back(query);
+    }
+
+    std::printf("%-8s %-8s %9s %10s %12s %10s %10s %9s\n", "chunks", "index", "memory", "add (us)",
+                "delete (us)", "mean (us)", "p99 (us)", "overlap");
+    bool agree = true;
+    for (size_t count : {size_t{1000}, size_t{10000}, size_t{100000}}) {
+        if (count > maxCount) {
+            break;
+        }
+        std::vector<std::string> chunks;
+        ZipfWords words(count);
+        for (size_t i = 0; i < count; i++) {
+            chunks.push_back(makeChunk(words));
+        }
+        // Delete every tenth chunk; the map index walks its whole dictionary per chunk
+        const size_t deletes = std::min<size_t>(count / 10, 200);
+
+        MapIndex maps;
+        bench::Timer mapAdd;
+        for (size_t i = 0; i < count; i++) {
+            maps.add("chunk_" + std::to_string(i), chunks[i]);
+        }
+        const double mapAddUs = mapAdd.elapsedUs() / count;
+        const size_t mapBytes = maps.memoryBytes();
+        const Timing mapSearch = measure(queries, [&](const std::string& q) { return maps.search(q); });
+        bench::Timer mapDelete;
+        for (size_t i = 0; i < deletes; i++) {
+            maps.remove("chunk_" + std::to_string(i * 10));
+        }
+        const double mapDeleteUs = mapDelete.elapsedUs() / deletes;
+        std::printf("%-8zu %-8s %7.1fMB %10.1f %12.1f %10.0f %10.0f %9s\n", count, "maps", mapBytes / 1e6,
+                    mapAddUs, mapDeleteUs, mapSearch.mean, mapSearch.p99, "-");
+
+        TfIdfIndex index(kStopWords, kMinTermChars);
+        bench::Timer add;
+        for (size_t i = 0; i < count; i++) {
+            index.add(static_cast<int32_t>(i), chunks[i]);
+        }
+        const double addUs = add.elapsedUs() / count;
+        const size_t bytes = index.memoryBytes();
+        const Timing search = measure(queries, [&](const std::string& q) { return index.search(q, kTopK); });
+        const double before = overlap(index, queries);
+        bench::Timer remove;
+        for (size_t i = 0; i < count / 10; i++) {
+            index.remove(static_cast<int32_t>(i * 10));
+        }
+        const double removeUs = remove.elapsedUs() / (count / 10);
+        const double after = overlap(index, queries);
+        agree = agree && before >= 0.95 && after >= 0.95;
+        std::printf("%-8zu %-8s %7.1fMB %10.1f %12.1f %10.0f %10.0f %4.2f/%4.2f\n", count, "csr", bytes / 1e6,
+                    addUs, removeUs, search.mean, search.p99, before, after);
+    }
+    return agree ? 0 : 1;
+}
@@ -0,0 +1,204 @@
+/**
+ * Cold-open, append and scan timings for the memory-mapped VectorFile, plus a
+ * crash check: a forked child appends a batch and exits without checkpointing,
+ * then the parent reopens and verifies the WAL replay recovered every row.
+ *
+ * Incremental maintenance: whole-document deletes through the per-document row
+ * lists, content matching for an edited document, and compaction of a store
+ * with 30% tombstones while another thread keeps searching it.
+ *
+ * Usage: vector_file_bench [count=100000] [dim=384] [dir=/tmp/iris_vector_file_bench]
+ */
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../vector_file.h"
+#include "bench_common.h"
+
+using iris::rag::ChunkRecord;
+using iris::rag::VectorFile;
+namespace bench = iris::bench;
+
+namespace {
+
+constexpr size_t kBatch = 256;
+const char* kFingerprint = "bench-model:v1";
+
+std::vector<ChunkRecord> makeRecords(size_t first, size_t count) {
+    std::vector<ChunkRecord> records(count);
+    for (size_t i = 0; i < count; i++) {
+        const size_t n = first + i;
+        records[i].id = "chunk-" + std::to_string(n);
+        records[i].documentId = "doc-" + std::to_string(n / 20);
+        records[i].content = std::string(600, static_cast<char>('a' + n % 26));
+        records[i].metadata = "{\"chunk_index\":\"" + std::to_string(n % 20) + "\"}";
+        records[i].startIndex = static_cast<int32_t>(n % 20 * 600);
+        records[i].endIndex = records[i].startIndex + 600;
+    }
+    return records;
+}
+
+void removeStore(const std::string& dir) {
+    for (const char* name : {"/store.vec", "/store.str", "/store.wal"}) {
+        ::unlink((dir + name).c_str());
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const size_t count = static_cast<size_t>(bench::argOr(argc, argv, 1, 100000));
+    const int dim = static_cast<int>(bench::argOr(argc, argv, 2, 384));
+    const std::string dir = argc > 3 ? argv[3] : "/tmp/iris_vector_file_bench";
+
+    std::printf("VectorFile benchmark: %zu rows, dim %d, %s\n\n", count, dim, dir.c_str());
+    removeStore(dir);
+    std::vector<float> data = bench::clusteredVectors(count, dim, std::max<size_t>(count / 100, 8), 1);
+
+    {
+        auto file = VectorFile::open(dir, dim, kFingerprint, false);
+        bench::Timer timer;
+        for (size_t first = 0; first < count; first += kBatch) {
+            const size_t n = std::min(kBatch, count - first);
+            file->append(makeRecords(first, n), data.data() + first * dim);
+        }
+        const double appendMs = timer.elapsedMs();
+        std::printf("append (batches of %zu, WAL fsync each): %.1f ms, %.0f rows/s\n", kBatch, appendMs,
+                    count / (appendMs / 1000.0));
+    }
+
+    bench::Timer openTimer;
+    auto file = VectorFile::open(dir, 0, kFingerprint, false);
+    const double openMs = openTimer.elapsedMs();
+    std::printf("cold open: %.2f ms (%u rows)\n", openMs, file->rowCount());
+
+    std::vector<double> latencies;
+    for (int q = 0; q < 50; q++) {
+        bench::Timer timer;
+        file->exactSearch(data.data() + static_cast<size_t>(q) * 97 * dim, 10);
+        latencies.push_back(timer.elapsedUs());
+    }
+    std::printf("exact scan of mapped arena: mean %.0f us, p99 %.0f us\n", bench::mean(latencies),
+                bench::percentile(latencies, 0.99));
+
+    bench::Timer idTimer;
+    size_t idBytes = 0;
+    for (uint32_t row : file->liveRows()) {
+        idBytes += file->readChunkId(row).size();
+    }
+    std::printf("read all chunk ids: %.1f ms (%zu bytes)\n", idTimer.elapsedMs(), idBytes);
+
+    // Crash during ingestion: the child never reaches a checkpoint
+    const uint32_t before = file->rowCount();
+    file.reset();
+    const size_t crashRows = 1000;
+    const pid_t child = ::fork();
+    if (child == 0) {
+        auto crashing = VectorFile::open(dir, dim, kFingerprint, false);
+        crashing->append(makeRecords(count, crashRows), data.data());
+        crashing->markDeleted({0, 1, 2});
+        std::_Exit(0);
+    }
+    int status = 0;
+    ::waitpid(child, &status, 0);
+
+    bench::Timer replayTimer;
+    file = VectorFile::open(dir, dim, kFingerprint, false);
+    const double replayMs = replayTimer.elapsedMs();
+    const bool recovered = file->rowCount() == before + crashRows && file->isDeleted(1) &&
+                           file->readChunkId(before + crashRows - 1) == "chunk-" + std::to_string(count + crashRows - 1);
+    std::printf("open after crash (WAL replay of %zu rows): %.2f ms, %s\n", crashRows, replayMs,
+                recovered ? "recovered" : "MISMATCH");
+
+    bool rejected = false;
+    try {
+        VectorFile::open(dir, dim, "other-model:v2", false);
+    } catch (const iris::rag::VectorFileMismatch&) {
+        rejected = true;
+    }
+    std::printf("fingerprint mismatch rejected: %s\n", rejected ? "yes" : "NO");
+
+    // Delete 30% of documents by ID
+    const size_t documents = count / 20;
+    const size_t deletedDocuments = documents * 3 / 10;
+    bench::Timer deleteTimer;
+    size_t deletedRows = 0;
+    for (size_t d = 0; d < deletedDocuments; d++) {
+        deletedRows += file->deleteDocument("doc-" + std::to_string(d * 10 / 3)).size();
+    }
+    const double deleteMs = deleteTimer.elapsedMs();
+    std::printf("\ndelete %zu documents (%zu rows): %.1f ms, %.0f us per document\n", deletedDocuments, deletedRows,
+                deleteMs, deleteMs * 1000.0 / deletedDocuments);
+
+    // An edited document: one of its 20 chunks changed
+    const std::string edited = "doc-" + std::to_string(documents - 1);
+    std::vector<std::string> contents;
+    for (uint32_t row : file->documentRows(edited)) {
+        contents.push_back(file->readRecord(row).content);
+    }
+    contents[contents.size() / 2] += " (edited)";
+    bench::Timer matchTimer;
+    size_t unchanged = 0;
+    for (int32_t row : file->matchContent(edited, contents)) {
+        unchanged += row >= 0 ? 1 : 0;
+    }
+    std::printf("match edited document: %zu of %zu chunks reusable, %.0f us\n", unchanged, contents.size(),
+                matchTimer.elapsedUs());
+
+    // Compact while searching
+    latencies.clear();
+    for (int q = 0; q < 50; q++) {
+        bench::Timer timer;
+        file->exactSearch(data.data() + static_cast<size_t>(q) * 97 * dim, 10);
+        latencies.push_back(timer.elapsedUs());
+    }
+    const double idleP99 = bench::percentile(latencies, 0.99);
+
+    const std::string compactDir = dir + ".compact";
+    std::vector<int32_t> rowMap;
+    std::unique_ptr<VectorFile> compacted;
+    std::atomic<bool> compacting{true};
+    double compactMs = 0.0;
+    std::thread compactor([&] {
+        bench::Timer timer;
+        compacted = file->compactInto(compactDir, rowMap);
+        compactMs = timer.elapsedMs();
+        compacting = false;
+    });
+    latencies.clear();
+    for (int q = 0; compacting; q++) {
+        bench::Timer timer;
+        file->exactSearch(data.data() + static_cast<size_t>(q % 1000) * 97 * dim, 10);
+        latencies.push_back(timer.elapsedUs());
+    }
+    compactor.join();
+
+    // A write after the copy, carried over by a sync
+    file->append(makeRecords(count + crashRows, 1), data.data());
+    file->deleteDocument("doc-" + std::to_string(documents - 2));
+    file->syncCompacted(*compacted, rowMap);
+
+    bool mapped = compacted->liveCount() == file->liveCount() && rowMap.size() == file->rowCount();
+    for (uint32_t row : file->liveRows()) {
+        mapped = mapped && rowMap[row] >= 0 &&
+                 compacted->readChunkId(static_cast<uint32_t>(rowMap[row])) == file->readChunkId(row);
+    }
+    std::printf("compaction: %u rows -> %u in %.0f ms, %s\n", file->rowCount(), compacted->rowCount(), compactMs,
+                mapped ? "rows mapped" : "MAPPING MISMATCH");
+    std::printf("search during compaction: %zu queries, mean %.0f us, p99 %.0f us (idle p99 %.0f us)\n",
+                latencies.size(), bench::mean(latencies), bench::percentile(latencies, 0.99), idleP99);
+
+    compacted.reset();
+    removeStore(compactDir);
+    ::rmdir(compactDir.c_str());
+    file.reset();
+    removeStore(dir);
+    return recovered && rejected && mapped ? 0 : 1;
+}
@@ -0,0 +1,454 @@
+#include "bm25_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+
+#include "text_tokenizer.h"
+
+#define LOG_TAG "IrisBm25Index"
+#include "rag_log.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+constexpr uint32_t kEnd = std::numeric_limits<uint32_t>::max();
+
+constexpr uint8_t kAbsent = 0;
+constexpr uint8_t kLive = 1;
+constexpr uint8_t kDeleted = 2;
+
+void putVarint(std::vector<uint8_t>& out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+const uint8_t* getVarint(const uint8_t* in, uint32_t& value) {
+    uint32_t result = 0;
+    int shift = 0;
+    while (*in & 0x80) {
+        result |= static_cast<uint32_t>(*in++ & 0x7F) << shift;
+        shift += 7;
+    }
+    value = result | static_cast<uint32_t>(*in++) << shift;
+    return in;
+}
+
+/**
+ * BM25 term weight with the collection statistics of one query
+ */
+struct Scorer {
+    float k1;
+    float b;
+    float averageLength;
+
+    float operator()(float idf, uint32_t tf, uint32_t length) const {
+        const float norm = k1 * (1.0f - b + b * static_cast<float>(length) / averageLength);
+        return idf * static_cast<float>(tf) * (k1 + 1.0f) / (static_cast<float>(tf) + norm);
+    }
+};
+
+} // namespace
+
+/**
+ * Iterator over one term's postings, decoding a block at a time
+ */
+class Bm25Index::Cursor {
+public:
+    Cursor(const Postings& postings, float idf, const Scorer& scorer, const std::vector<uint32_t>& lengths)
+        : postings_(postings),
+          scorer_(scorer),
+          idf_(idf),
+          blockCount_(postings.blocks.size() + (postings.tailDocs.empty() ? 0 : 1)) {
+        for (size_t i = 0; i < postings.tailDocs.size(); i++) {
+            tailMaxTf_ = std::max(tailMaxTf_, postings.tailTfs[i]);
+            tailMinLength_ = std::min(tailMinLength_, lengths[postings.tailDocs[i]]);
+        }
+        for (size_t b = 0; b < blockCount_; b++) {
+            maxScore_ = std::max(maxScore_, boundOf(b));
+        }
+        load(0);
+    }
+
+    uint32_t doc() const { return doc_; }
+    uint16_t tf() const { return tfs_[position_]; }
+    float idf() const { return idf_; }
+
+    /**
+     * Upper bound on this term's score for any document
+     */
+    float maxScore() const { return maxScore_; }
+
+    void next() {
+        if (++position_ == count_) {
+            load(block_ + 1);
+        } else {
+            doc_ = docs_[position_];
+        }
+    }
+
+    /**
+     * Move to the first posting >= target, skipping whole blocks by their last doc
+     */
+    void advance(uint32_t target) {
+        if (doc_ >= target) {
+            return;
+        }
+        size_t block = block_;
+        while (block < blockCount_ && lastDoc(block) < target) {
+            block++;
+        }
+        if (block != block_) {
+            load(block);
+            if (doc_ == kEnd) {
+                return;
+            }
+        }
+        while (docs_[position_] < target) {
+            position_++;
+        }
+        doc_ = docs_[position_];
+    }
+
+    /**
+     * Bound for the block that holds the first posting >= target, without decoding it
+     * @param blockLast Set to that block's last doc (kEnd past the end)
+     */
+    float blockBound(uint32_t target, uint32_t& blockLast) const {
+        size_t block = block_;
+        while (block < blockCount_ && lastDoc(block) < target) {
+            block++;
+        }
+        if (block == blockCount_) {
+            blockLast = kEnd;
+            return 0.0f;
+        }
+        blockLast = lastDoc(block);
+        return boundOf(block);
+    }
+
+private:
+    const Postings& postings_;
+    const Scorer& scorer_;
+    const float idf_;
+    const size_t blockCount_;
+    uint16_t tailMaxTf_ = 0;
+    uint32_t tailMinLength_ = std::numeric_limits<uint32_t>::max();
+    float maxScore_ = 0.0f;
+
+    size_t block_ = 0;
+    size_t position_ = 0;
+    size_t count_ = 0;
+    uint32_t doc_ = kEnd;
+    uint32_t docs_[kBlockSize];
+    uint16_t tfs_[kBlockSize];
+
+    bool isTail(size_t block) const { return block == postings_.blocks.size(); }
+
+    uint32_t lastDoc(size_t block) const {
+        return isTail(block) ? postings_.tailDocs.back() : postings_.blocks[block].lastDoc;
+    }
+
+    float boundOf(size_t block) const {
+        if (isTail(block)) {
+            return scorer_(idf_, tailMaxTf_, tailMinLength_);
+        }
+        const Block& b = postings_.blocks[block];
+        return scorer_(idf_, b.maxTf, b.minLength);
+    }
+
+    void load(size_t block) {
+        block_ = block;
+        position_ = 0;
+        if (block >= blockCount_) {
+            count_ = 0;
+            doc_ = kEnd;
+            return;
+        }
+        if (isTail(block)) {
+            count_ = postings_.tailDocs.size();
+            std::copy(postings_.tailDocs.begin(), postings_.tailDocs.end(), docs_);
+            std::copy(postings_.tailTfs.begin(), postings_.tailTfs.end(), tfs_);
+        } else {
+            const Block& b = postings_.blocks[block];
+            count_ = b.count;
+            uint32_t doc = block == 0 ? 0 : postings_.blocks[block - 1].lastDoc;
+            const uint8_t* in = postings_.bytes.data() + b.offset;
+            for (size_t i = 0; i < count_; i++) {
+                uint32_t gap;
+                uint32_t tf;
+                in = getVarint(in, gap);
+                in = getVarint(in, tf);
+                doc += gap;
+                docs_[i] = doc;
+                tfs_[i] = static_cast<uint16_t>(tf);
+            }
+        }
+        doc_ = docs_[0];
+    }
+};
+
+Bm25Index::Bm25Index(float k1, float b) : k1_(k1), b_(b) {
+    if (k1 < 0.0f || b < 0.0f || b > 1.0f) {
+        throw std::invalid_argument("BM25 needs k1 >= 0 and 0 <= b <= 1");
+    }
+}
+
+// ============================================================================
+// Updates
+// ============================================================================
+
+void Bm25Index::add(int32_t doc, std::string_view text) {
+    if (doc < 0) {
+        throw std::invalid_argument("Document IDs must be non-negative");
+    }
+    // Tokenize and count outside the lock
+    std::vector<std::string> tokens = tokenize(text);
+    std::sort(tokens.begin(), tokens.end());
+    const uint32_t length = static_cast<uint32_t>(tokens.size());
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (doc <= lastDoc_) {
+        throw std::invalid_argument("Document IDs must be added in increasing order");
+    }
+    const uint32_t id = static_cast<uint32_t>(doc);
+    lengths_.resize(id + 1, 0);
+    states_.resize(id + 1, kAbsent);
+    lengths_[id] = length;
+    states_[id] = kLive;
+    totalLength_ += length;
+    live_++;
+    lastDoc_ = doc;
+
+    for (size_t i = 0; i < tokens.size();) {
+        size_t end = i + 1;
+        while (end < tokens.size() && tokens[end] == tokens[i]) {
+            end++;
+        }
+        const auto inserted = termIds_.emplace(tokens[i], static_cast<uint32_t>(postings_.size()));
+        if (inserted.second) {
+            postings_.emplace_back();
+        }
+        Postings& postings = postings_[inserted.first->second];
+        postings.tailDocs.push_back(id);
+        postings.tailTfs.push_back(static_cast<uint16_t>(std::min<size_t>(end - i, UINT16_MAX)));
+        postings.count++;
+        if (postings.tailDocs.size() == kBlockSize) {
+            sealTail(postings);
+        }
+        i = end;
+    }
+}
+
+/**
+ * Compress a full tail into a block: varint gap from the previous doc, then tf
+ */
+void Bm25Index::sealTail(Postings& postings) {
+    Block block{};
+    block.lastDoc = postings.tailDocs.back();
+    block.offset = static_cast<uint32_t>(postings.bytes.size());
+    block.count = static_cast<uint16_t>(postings.tailDocs.size());
+    block.minLength = std::numeric_limits<uint32_t>::max();
+
+    uint32_t previous = postings.blocks.empty() ? 0 : postings.blocks.back().lastDoc;
+    for (size_t i = 0; i < postings.tailDocs.size(); i++) {
+        const uint32_t doc = postings.tailDocs[i];
+        putVarint(postings.bytes, doc - previous);
+        putVarint(postings.bytes, postings.tailTfs[i]);
+        previous = doc;
+        block.maxTf = std::max(block.maxTf, postings.tailTfs[i]);
+        block.minLength = std::min(block.minLength, lengths_[doc]);
+    }
+    postings.blocks.push_back(block);
+    postings.tailDocs.clear();
+    postings.tailTfs.clear();
+}
+
+bool Bm25Index::remove(int32_t doc) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (doc < 0 || static_cast<size_t>(doc) >= states_.size() || states_[doc] != kLive) {
+        return false;
+    }
+    states_[doc] = kDeleted;
+    totalLength_ -= lengths_[doc];
+    live_--;
+    return true;
+}
+
+// ============================================================================
+// Queries
+// ============================================================================
+
+bool Bm25Index::contains(int32_t doc) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return doc >= 0 && static_cast<size_t>(doc) < states_.size() && states_[doc] == kLive;
+}
+
+std::vector<int32_t> Bm25Index::documents() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<int32_t> result;
+    result.reserve(live_);
+    for (size_t doc = 0; doc < states_.size(); doc++) {
+        if (states_[doc] == kLive) {
+            result.push_back(static_cast<int32_t>(doc));
+        }
+    }
+    return result;
+}
+
+int32_t Bm25Index::lastDocument() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return lastDoc_;
+}
+
+size_t Bm25Index::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return live_;
+}
+
+size_t Bm25Index::termCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return termIds_.size();
+}
+
+size_t Bm25Index::postingBytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    size_t bytes = 0;
+    for (const Postings& postings : postings_) {
+        bytes += postings.bytes.size() + postings.blocks.size() * sizeof(Block) +
+                 postings.tailDocs.size() * (sizeof(uint32_t) + sizeof(uint16_t));
+    }
+    return bytes;
+}
+
+std::vector<SearchHit> Bm25Index::search(std::string_view query, int k) const {
+    return searchImpl(query, k, true);
+}
+
+std::vector<SearchHit> Bm25Index::exhaustiveSearch(std::string_view query, int k) const {
+    return searchImpl(query, k, false);
+}
+
+std::vector<SearchHit> Bm25Index::searchImpl(std::string_view query, int k, bool prune) const {
+    if (k <= 0) {
+        return {};
+    }
+    std::vector<std::string> terms = tokenize(query);
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    if (live_ == 0) {
+        return {};
+    }
+    const Scorer scorer{k1_, b_, std::max(static_cast<float>(totalLength_) / live_, 1.0f)};
+    const float documentCount = static_cast<float>(live_);
+
+    std::vector<Cursor> cursors;
+    cursors.reserve(terms.size());
+    for (const std::string& term : terms) {
+        const auto it = termIds_.find(term);
+        if (it == termIds_.end()) {
+            continue;
+        }
+        const Postings& postings = postings_[it->second];
+        // Postings of deleted documents still count towards df until compaction
+        const float df = std::min(static_cast<float>(postings.count), documentCount);
+        const float idf = std::log(1.0f + (documentCount - df + 0.5f) / (df + 0.5f));
+        cursors.emplace_back(postings, idf, scorer, lengths_);
+    }
+    if (cursors.empty()) {
+        return {};
+    }
+
+    using Entry = std::pair<float, int32_t>; // (-score, doc): max-heap top is the worst kept hit
+    std::priority_queue<Entry> best;
+    auto threshold = [&]() {
+        return prune && best.size() == static_cast<size_t>(k) ? -best.top().first : 0.0f;
+    };
+
+    std::vector<Cursor*> order;
+    for (Cursor& cursor : cursors) {
+        order.push_back(&cursor);
+    }
+    const size_t n = order.size();
+    while (true) {
+        std::sort(order.begin(), order.end(), [](const Cursor* a, const Cursor* b) { return a->doc() < b->doc(); });
+
+        // Pivot: the first cursor at which the summed term bounds can beat the threshold
+        const float theta = threshold();
+        float bound = 0.0f;
+        size_t pivot = n;
+        for (size_t i = 0; i < n && order[i]->doc() != kEnd; i++) {
+            bound += order[i]->maxScore();
+            if (bound > theta) {
+                pivot = i;
+                break;
+            }
+        }
+        if (pivot == n) {
+            break;
+        }
+        const uint32_t pivotDoc = order[pivot]->doc();
+        while (pivot + 1 < n && order[pivot + 1]->doc() == pivotDoc) {
+            pivot++;
+        }
+
+        if (prune) {
+            // Block-max check: the current blocks cannot reach theta before nextDoc
+            float blockBound = 0.0f;
+            uint32_t nextDoc = pivot + 1 < n ? order[pivot + 1]->doc() : kEnd;
+            for (size_t i = 0; i <= pivot; i++) {
+                uint32_t blockLast;
+                blockBound += order[i]->blockBound(pivotDoc, blockLast);
+                nextDoc = std::min(nextDoc, blockLast == kEnd ? kEnd : blockLast + 1);
+            }
+            if (blockBound <= theta) {
+                for (size_t i = 0; i <= pivot; i++) {
+                    order[i]->advance(nextDoc);
+                }
+                continue;
+            }
+        }
+
+        if (order[0]->doc() == pivotDoc) {
+            if (states_[pivotDoc] == kLive) {
+                float score = 0.0f;
+                for (size_t i = 0; i <= pivot; i++) {
+                    score += scorer(order[i]->idf(), order[i]->tf(), lengths_[pivotDoc]);
+                }
+                if (best.size() < static_cast<size_t>(k)) {
+                    best.push({-score, static_cast<int32_t>(pivotDoc)});
+                } else if (-score < best.top().first) {
+                    best.pop();
+                    best.push({-score, static_cast<int32_t>(pivotDoc)});
+                }
+            }
+            for (size_t i = 0; i <= pivot; i++) {
+                order[i]->next();
+            }
+        } else {
+            for (size_t i = 0; i < pivot && order[i]->doc() < pivotDoc; i++) {
+                order[i]->advance(pivotDoc);
+            }
+        }
+    }
+
+    std::vector<SearchHit> hits(best.size());
+    for (size_t i = hits.size(); i-- > 0;) {
+        hits[i] = {best.top().second, -best.top().first};
+        best.pop();
+    }
+    return hits;
+}
+
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,121 @@
+#ifndef IRIS_RAG_BM25_INDEX_H
+#define IRIS_RAG_BM25_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "hnsw_index.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Inverted index scored with Okapi BM25.
+ *
+ * Text is split by tokenize(). Each term's postings are kept in blocks of
+ * kBlockSize documents, stored as varint doc-ID gaps and term frequencies;
+ * the newest postings sit in an uncompressed tail until a block fills. Every
+ * block records its last doc ID (for skipping without decoding) plus the
+ * largest term frequency and shortest document in it, which bound the BM25
+ * contribution of any posting in the block.
+ *
+ * search() is Block-Max WAND: documents are visited in ID order, and runs of
+ * documents whose term or block upper bounds cannot beat the current k-th
+ * score are skipped. Document IDs must be added in increasing order; removal
+ * is a tombstone.
+ *
+ * Adds, removes and searches may run concurrently.
+ */
+class Bm25Index {
+public:
+    static constexpr size_t kBlockSize = 128;
+
+    /**
+     * @param k1 Term-frequency saturation
+     * @param b Document-length normalization
+     */
+    explicit Bm25Index(float k1 = 1.2f, float b = 0.75f);
+
+    /**
+     * Index `text` under `doc`, which must be greater than every doc added before
+     */
+    void add(int32_t doc, std::string_view text);
+
+    bool remove(int32_t doc);
+
+    bool contains(int32_t doc) const;
+
+    /**
+     * Live documents in ascending order
+     */
+    std::vector<int32_t> documents() const;
+
+    /**
+     * Largest doc ID added so far, or -1
+     */
+    int32_t lastDocument() const;
+
+    size_t size() const;
+
+    size_t termCount() const;
+
+    /**
+     * Bytes held by compressed postings, tails and block metadata
+     */
+    size_t postingBytes() const;
+
+    /**
+     * Top-k documents by BM25 over the query's tokens (OR semantics)
+     */
+    std::vector<SearchHit> search(std::string_view query, int k) const;
+
+    /**
+     * Same ranking as search() scoring every matching document; the baseline
+     * for benchmarks and tests
+     */
+    std::vector<SearchHit> exhaustiveSearch(std::string_view query, int k) const;
+
+private:
+    struct Block {
+        uint32_t lastDoc;
+        uint32_t offset; // into Postings::bytes
+        uint32_t minLength;
+        uint16_t count;
+        uint16_t maxTf;
+    };
+
+    struct Postings {
+        std::vector<uint8_t> bytes;
+        std::vector<Block> blocks;
+        std::vector<uint32_t> tailDocs;
+        std::vector<uint16_t> tailTfs;
+        uint32_t count = 0;
+    };
+
+    class Cursor;
+
+    const float k1_;
+    const float b_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, uint32_t> termIds_;
+    std::vector<Postings> postings_;
+    std::vector<uint32_t> lengths_; // tokens per doc
+    std::vector<uint8_t> states_;   // absent, live or deleted
+    uint64_t totalLength_ = 0;
+    uint32_t live_ = 0;
+    int32_t lastDoc_ = -1;
+
+    void sealTail(Postings& postings);
+    std::vector<SearchHit> searchImpl(std::string_view query, int k, bool prune) const;
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_BM25_INDEX_H
@@ -0,0 +1,152 @@
+#include "context_packer.h"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <stdexcept>
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+constexpr size_t kFingerprintWords = 128; // 8192 bits; a 400-token chunk sets about 5% of them
+
+using Fingerprint = std::array<uint64_t, kFingerprintWords>;
+
+/**
+ * Token bigrams hashed into a bit set; a chunk of one token is its single unigram
+ */
+Fingerprint fingerprint(const PackCandidate& candidate) {
+    Fingerprint bits{};
+    auto set = [&bits](uint64_t gram) {
+        gram *= 0x9e3779b97f4a7c15ull;
+        const uint64_t bit = gram >> 51; // top 13 bits
+        bits[bit / 64] |= uint64_t{1} << (bit % 64);
+    };
+    if (candidate.tokenCount == 1) {
+        set(static_cast<uint32_t>(candidate.tokens[0]));
+    }
+    for (size_t i = 1; i < candidate.tokenCount; i++) {
+        set((static_cast<uint64_t>(static_cast<uint32_t>(candidate.tokens[i - 1])) << 32) |
+            static_cast<uint32_t>(candidate.tokens[i]));
+    }
+    return bits;
+}
+
+/**
+ * Jaccard similarity of two fingerprints; hash collisions bias it up slightly
+ */
+float jaccard(const Fingerprint& a, const Fingerprint& b) {
+    int shared = 0;
+    int either = 0;
+    for (size_t w = 0; w < kFingerprintWords; w++) {
+        shared += __builtin_popcountll(a[w] & b[w]);
+        either += __builtin_popcountll(a[w] | b[w]);
+    }
+    return either ? static_cast<float>(shared) / static_cast<float>(either) : 0.0f;
+}
+
+} // namespace
+
+ContextPacker::ContextPacker(float lambda, float maxRedundancy) : lambda_(lambda), maxRedundancy_(maxRedundancy) {
+    if (lambda < 0.0f || lambda > 1.0f) {
+        throw std::invalid_argument("MMR lambda must be in [0, 1]");
+    }
+}
+
+PackedContext ContextPacker::pack(const std::vector<PackCandidate>& candidates, size_t budget,
+                                  const std::vector<int32_t>& separator) {
+    PackedContext packed;
+    const size_t n = candidates.size();
+    if (n == 0) {
+        return packed;
+    }
+
+    float low = std::numeric_limits<float>::max();
+    float high = std::numeric_limits<float>::lowest();
+    for (const PackCandidate& c : candidates) {
+        low = std::min(low, c.score);
+        high = std::max(high, c.score);
+    }
+    std::vector<float> relevance(n);
+    std::vector<Fingerprint> grams(n);
+    for (size_t i = 0; i < n; i++) {
+        relevance[i] = high > low ? (candidates[i].score - low) / (high - low) : 1.0f;
+        grams[i] = fingerprint(candidates[i]);
+    }
+
+    // Greedy MMR; a candidate that does not fit now never will, since the budget only shrinks
+    std::vector<float> redundancy(n, 0.0f);
+    std::vector<bool> open(n, true);
+    std::vector<size_t> taken;
+    size_t remaining = budget;
+    while (true) {
+        size_t best = n;
+        float bestValue = std::numeric_limits<float>::lowest();
+        for (size_t i = 0; i < n; i++) {
+            if (!open[i]) {
+                continue;
+            }
+            const size_t cost = candidates[i].tokenCount + separator.size();
+            if (cost > remaining || candidates[i].tokenCount == 0) {
+                open[i] = false;
+                continue;
+            }
+            const float value = lambda_ * relevance[i] - (1.0f - lambda_) * redundancy[i];
+            if (value > bestValue) {
+                best = i;
+                bestValue = value;
+            }
+        }
+        if (best == n) {
+            break;
+        }
+        open[best] = false;
+        taken.push_back(best);
+        remaining -= candidates[best].tokenCount + separator.size();
+        for (size_t i = 0; i < n; i++) {
+            if (!open[i]) {
+                continue;
+            }
+            redundancy[i] = std::max(redundancy[i], jaccard(grams[i], grams[best]));
+            if (redundancy[i] >= maxRedundancy_) {
+                open[i] = false;
+                packed.redundant++;
+            }
+        }
+    }
+
+    // Chunks from the last pack first, in its order, then new ones by relevance
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto previousRank = [this](int32_t label) {
+        const auto it = std::find(previous_.begin(), previous_.end(), label);
+        return it == previous_.end() ? previous_.size() : static_cast<size_t>(it - previous_.begin());
+    };
+    std::stable_sort(taken.begin(), taken.end(), [&](size_t a, size_t b) {
+        const size_t ra = previousRank(candidates[a].label);
+        const size_t rb = previousRank(candidates[b].label);
+        if (ra != rb) {
+            return ra < rb;
+        }
+        return relevance[a] > relevance[b];
+    });
+
+    packed.tokens.reserve(budget - remaining);
+    for (size_t i : taken) {
+        const PackCandidate& c = candidates[i];
+        packed.labels.push_back(c.label);
+        packed.tokens.insert(packed.tokens.end(), c.tokens, c.tokens + c.tokenCount);
+        packed.tokens.insert(packed.tokens.end(), separator.begin(), separator.end());
+    }
+    previous_ = packed.labels;
+    return packed;
+}
+
+void ContextPacker::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    previous_.clear();
+}
+
+} // namespace rag
+} // namespace iris
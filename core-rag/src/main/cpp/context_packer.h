@@ -0,0 +1,75 @@
+#ifndef IRIS_RAG_CONTEXT_PACKER_H
+#define IRIS_RAG_CONTEXT_PACKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace iris {
+namespace rag {
+
+/**
+ * A retrieved chunk offered to the packer, already tokenized by the LLM's
+ * tokenizer. The label must name the same chunk from one pack() to the next;
+ * `tokens` must stay valid for the call.
+ */
+struct PackCandidate {
+    int32_t label;
+    float score; // higher is more relevant; any scale
+    const int32_t* tokens;
+    size_t tokenCount;
+};
+
+struct PackedContext {
+    std::vector<int32_t> labels; // in prompt order
+    std::vector<int32_t> tokens; // each chunk's tokens followed by the separator
+    size_t redundant = 0;        // candidates dropped as near-copies of a packed one
+};
+
+/**
+ * Chooses which retrieved chunks go into a prompt under a token budget, and in
+ * what order.
+ *
+ * Selection is greedy maximal marginal relevance: each step takes the
+ * candidate that still fits and maximizes
+ *   lambda * relevance - (1 - lambda) * max similarity to the chunks taken,
+ * where relevance is the score scaled to [0, 1] over the candidates and
+ * similarity is the Jaccard similarity of token bigram sets, compared as
+ * 8192-bit fingerprints with popcount. A candidate at `maxRedundancy` or more
+ * to a taken chunk is dropped.
+ *
+ * Order favours KV cache reuse: chunks that were in the previous pack come
+ * first, in their previous order, so consecutive prompts share the longest
+ * prefix; new chunks follow by descending relevance.
+ *
+ * Safe to call from several threads; the previous order is shared.
+ */
+class ContextPacker {
+public:
+    explicit ContextPacker(float lambda = 0.7f, float maxRedundancy = 0.8f);
+
+    /**
+     * @param budget Tokens available, separators included
+     * @param separator Tokens emitted after each chunk, e.g. a newline
+     */
+    PackedContext pack(const std::vector<PackCandidate>& candidates, size_t budget,
+                       const std::vector<int32_t>& separator);
+
+    /**
+     * Forget the previous pack, e.g. when the conversation changes
+     */
+    void reset();
+
+private:
+    const float lambda_;
+    const float maxRedundancy_;
+
+    std::mutex mutex_;
+    std::vector<int32_t> previous_; // labels of the last pack, in order
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_CONTEXT_PACKER_H
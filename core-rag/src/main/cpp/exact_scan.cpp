@@ -0,0 +1,95 @@
+#include "exact_scan.h"
+
+namespace iris {
+namespace rag {
+
+ScanPool::ScanPool(int threads) {
+    const int extra = std::max(threads, 1) - 1;
+    workers_.reserve(static_cast<size_t>(extra));
+    for (int w = 1; w <= extra; w++) {
+        workers_.emplace_back([this, w]() { workerLoop(w); });
+    }
+}
+
+ScanPool::~ScanPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ScanPool& ScanPool::shared() {
+    static ScanPool pool(static_cast<int>(std::max(1u, std::thread::hardware_concurrency())));
+    return pool;
+}
+
+void ScanPool::run(size_t tasks, const std::function<void(size_t task, int worker)>& fn) {
+    std::unique_lock<std::mutex> job(jobMutex_, std::try_to_lock);
+    if (!job.owns_lock() || workers_.empty() || tasks <= 1) {
+        for (size_t task = 0; task < tasks; task++) {
+            fn(task, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        job_ = &fn;
+        tasks_ = tasks;
+        next_.store(0);
+        error_ = nullptr;
+        busyWorkers_ = static_cast<int>(workers_.size());
+        generation_++;
+    }
+    wake_.notify_all();
+    work(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex_);
+    done_.wait(lock, [this]() { return busyWorkers_ == 0; });
+    job_ = nullptr;
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void ScanPool::workerLoop(int worker) {
+    uint64_t seen = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex_);
+            wake_.wait(lock, [&]() { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+        }
+        work(worker);
+        {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            busyWorkers_--;
+        }
+        done_.notify_one();
+    }
+}
+
+void ScanPool::work(int worker) {
+    size_t task;
+    while ((task = next_.fetch_add(1)) < tasks_) {
+        try {
+            (*job_)(task, worker);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(stateMutex_);
+            if (!error_) {
+                error_ = std::current_exception();
+            }
+            next_.store(tasks_); // abandon the remaining tasks
+        }
+    }
+}
+
+} // namespace rag
+} // namespace iris
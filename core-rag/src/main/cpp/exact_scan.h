@@ -0,0 +1,194 @@
+#ifndef IRIS_RAG_EXACT_SCAN_H
+#define IRIS_RAG_EXACT_SCAN_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hnsw_index.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Best k (score, row) pairs seen so far, in storage allocated once up front.
+ *
+ * A min-heap on score keeps the worst kept hit on top; once full, anything not
+ * above it (or below the threshold) is rejected with one compare, so the hot
+ * loop of a scan rarely touches the heap. Equal scores are ordered by row so
+ * the result does not depend on how rows were split between workers.
+ */
+class TopK {
+public:
+    struct Entry {
+        float score;
+        uint32_t row;
+    };
+
+    TopK() = default;
+    TopK(int k, float threshold) { reset(k, threshold); }
+
+    void reset(int k, float threshold) {
+        k_ = static_cast<size_t>(std::max(k, 0));
+        threshold_ = threshold;
+        floor_ = threshold;
+        heap_.clear();
+        heap_.reserve(k_);
+    }
+
+    /**
+     * Lowest score that can still enter; scans may skip anything below it
+     */
+    float floor() const { return floor_; }
+
+    void offer(float score, uint32_t row) {
+        if (score < floor_ || k_ == 0) {
+            return;
+        }
+        const Entry entry{score, row};
+        if (heap_.size() < k_) {
+            heap_.push_back(entry);
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        } else if (better(entry, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), better);
+            heap_.back() = entry;
+            std::push_heap(heap_.begin(), heap_.end(), better);
+        } else {
+            return;
+        }
+        if (heap_.size() == k_) {
+            floor_ = std::max(threshold_, heap_.front().score);
+        }
+    }
+
+    void merge(const TopK& other) {
+        for (const Entry& entry : other.heap_) {
+            offer(entry.score, entry.row);
+        }
+    }
+
+    size_t size() const { return heap_.size(); }
+
+    /**
+     * Kept hits best-first, labelled by row
+     */
+    std::vector<SearchHit> sorted() const {
+        std::vector<Entry> entries(heap_);
+        std::sort(entries.begin(), entries.end(), better);
+        std::vector<SearchHit> hits(entries.size());
+        for (size_t i = 0; i < entries.size(); i++) {
+            hits[i] = {static_cast<int32_t>(entries[i].row), entries[i].score};
+        }
+        return hits;
+    }
+
+private:
+    // Heap order: the top is the entry every other kept one is better than
+    static bool better(const Entry& a, const Entry& b) {
+        return a.score > b.score || (a.score == b.score && a.row < b.row);
+    }
+
+    size_t k_ = 0;
+    float threshold_ = -std::numeric_limits<float>::infinity();
+    float floor_ = -std::numeric_limits<float>::infinity();
+    std::vector<Entry> heap_;
+};
+
+/**
+ * Fixed set of worker threads for splitting one scan across cores.
+ *
+ * run() hands out task numbers through an atomic counter, so faster cores take
+ * more tasks; the calling thread works too. One job runs at a time: a caller
+ * that finds the pool busy (another search is scanning) runs its tasks inline
+ * instead of queueing behind it.
+ */
+class ScanPool {
+public:
+    /**
+     * @param threads Threads per job including the caller; 1 runs everything inline
+     */
+    explicit ScanPool(int threads);
+    ~ScanPool();
+
+    ScanPool(const ScanPool&) = delete;
+    ScanPool& operator=(const ScanPool&) = delete;
+
+    /**
+     * Workers per job, caller included; per-worker state is indexed below this
+     */
+    int threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+    /**
+     * Call fn(task, worker) for every task in [0, tasks) and wait for all of them;
+     * rethrows the first exception
+     */
+    void run(size_t tasks, const std::function<void(size_t task, int worker)>& fn);
+
+    /**
+     * Process-wide pool with one thread per core
+     */
+    static ScanPool& shared();
+
+private:
+    void workerLoop(int worker);
+    void work(int worker);
+
+    std::vector<std::thread> workers_;
+    std::mutex jobMutex_; // held by the caller for the whole job
+    std::mutex stateMutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    const std::function<void(size_t, int)>* job_ = nullptr;
+    size_t tasks_ = 0;
+    std::atomic<size_t> next_{0};
+    uint64_t generation_ = 0;
+    int busyWorkers_ = 0;
+    bool stopping_ = false;
+    std::exception_ptr error_;
+};
+
+/**
+ * Exact top-k over rows [0, rowCount): the rows are cut into partitions of
+ * about `partitionBytes` of vectors (a multiple of `blockRows`), partitions are
+ * spread over `pool`, each worker fills its own TopK through
+ * scan(first, end, top), and the worker heaps are merged at the end.
+ * Nothing is allocated per row.
+ */
+template <typename Scan>
+std::vector<SearchHit> parallelTopK(ScanPool& pool, uint32_t rowCount, size_t rowBytes, uint32_t blockRows,
+                                    int k, float threshold, Scan&& scan) {
+    constexpr size_t kPartitionBytes = size_t{1} << 20;
+    const uint32_t partitionRows = std::max<uint32_t>(
+        blockRows, static_cast<uint32_t>(kPartitionBytes / std::max<size_t>(rowBytes, 1)) / blockRows * blockRows);
+    const size_t partitions = (static_cast<size_t>(rowCount) + partitionRows - 1) / partitionRows;
+
+    std::vector<TopK> tops(partitions > 1 ? static_cast<size_t>(pool.threads()) : 1);
+    for (TopK& top : tops) {
+        top.reset(k, threshold);
+    }
+    if (partitions <= 1) {
+        scan(uint32_t{0}, rowCount, tops[0]);
+        return tops[0].sorted();
+    }
+    pool.run(partitions, [&](size_t partition, int worker) {
+        const uint32_t first = static_cast<uint32_t>(partition) * partitionRows;
+        scan(first, std::min(rowCount, first + partitionRows), tops[worker]);
+    });
+    for (size_t i = 1; i < tops.size(); i++) {
+        tops[0].merge(tops[i]);
+    }
+    return tops[0].sorted();
+}
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_EXACT_SCAN_H
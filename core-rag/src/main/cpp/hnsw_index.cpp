@@ -0,0 +1,491 @@
+#include "hnsw_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <thread>
+
+#include "exact_scan.h"
+#include "vector_kernels.h"
+
+#define LOG_TAG "IrisHnswIndex"
+#include "rag_log.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Generation-tagged visited set, pooled so searches do not allocate
+ */
+class HnswIndex::VisitedList {
+public:
+    void reset(size_t nodeCount) {
+        if (marks_.size() < nodeCount) {
+            marks_.resize(nodeCount, 0);
+        }
+        if (++tag_ == 0) {
+            std::fill(marks_.begin(), marks_.end(), 0);
+            tag_ = 1;
+        }
+    }
+
+    // Returns true if the node had already been visited
+    bool visit(uint32_t node) {
+        if (marks_[node] == tag_) {
+            return true;
+        }
+        marks_[node] = tag_;
+        return false;
+    }
+
+private:
+    std::vector<uint16_t> marks_;
+    uint16_t tag_ = 0;
+};
+
+void normalizeVector(const float* src, float* dst, int dim) {
+    const float norm = kernels::dotF32(src, src, static_cast<size_t>(dim));
+    const float scale = norm > 0.0f ? 1.0f / std::sqrt(norm) : 0.0f;
+    for (int i = 0; i < dim; i++) {
+        dst[i] = src[i] * scale;
+    }
+}
+
+HnswIndex::HnswIndex(int dim, int M, int efConstruction, size_t initialCapacity, uint64_t seed)
+    : dim_(dim),
+      M_(static_cast<size_t>(std::max(M, 2))),
+      maxM0_(static_cast<size_t>(std::max(M, 2)) * 2),
+      efConstruction_(static_cast<size_t>(std::max(efConstruction, M))),
+      levelMult_(1.0 / std::log(static_cast<double>(std::max(M, 2)))),
+      rng_(seed) {
+    if (dim <= 0) {
+        throw std::invalid_argument("Vector dimension must be positive");
+    }
+    grow(std::max<size_t>(initialCapacity, 16));
+}
+
+HnswIndex::~HnswIndex() = default;
+
+void HnswIndex::grow(size_t minCapacity) {
+    if (minCapacity <= capacity_) {
+        return;
+    }
+    const size_t newCapacity = std::max(minCapacity, capacity_ * 2);
+
+    vectors_.resize(newCapacity * dim_);
+    labels_.resize(newCapacity, -1);
+    levels_.resize(newCapacity, 0);
+    links0_.resize(newCapacity * (maxM0_ + 1), 0);
+    upperLinks_.resize(newCapacity);
+
+    auto states = std::make_unique<std::atomic<uint8_t>[]>(newCapacity);
+    for (size_t i = 0; i < newCapacity; i++) {
+        states[i].store(i < capacity_ ? states_[i].load(std::memory_order_relaxed) : static_cast<uint8_t>(kEmpty),
+                        std::memory_order_relaxed);
+    }
+    states_ = std::move(states);
+    nodeLocks_ = std::make_unique<std::mutex[]>(newCapacity);
+
+    capacity_ = newCapacity;
+}
+
+int HnswIndex::randomLevel() {
+    std::lock_guard<std::mutex> lock(entryMutex_);
+    std::uniform_real_distribution<double> dist(0.0, 1.0);
+    const double r = std::max(dist(rng_), std::numeric_limits<double>::min());
+    return static_cast<int>(-std::log(r) * levelMult_);
+}
+
+float HnswIndex::distance(const float* a, const float* b) const {
+    return 1.0f - kernels::dotF32(a, b, static_cast<size_t>(dim_));
+}
+
+uint32_t* HnswIndex::linksAt(uint32_t node, int level) {
+    if (level == 0) {
+        return links0_.data() + static_cast<size_t>(node) * (maxM0_ + 1);
+    }
+    return upperLinks_[node].data() + static_cast<size_t>(level - 1) * (M_ + 1);
+}
+
+void HnswIndex::copyLinks(uint32_t node, int level, std::vector<uint32_t>& out) const {
+    std::lock_guard<std::mutex> lock(nodeLocks_[node]);
+    const uint32_t* links = const_cast<HnswIndex*>(this)->linksAt(node, level);
+    out.assign(links + 1, links + 1 + links[0]);
+}
+
+void HnswIndex::add(int32_t label, const float* vector) {
+    std::vector<float> normalized(dim_);
+    normalizeVector(vector, normalized.data(), dim_);
+    const int level = randomLevel();
+    const uint32_t node = nodeCount_.fetch_add(1);
+
+    {
+        std::shared_lock<std::shared_mutex> readLock(structureMutex_);
+        if (node >= capacity_) {
+            readLock.unlock();
+            std::unique_lock<std::shared_mutex> writeLock(structureMutex_);
+            grow(static_cast<size_t>(node) + 1);
+        }
+    }
+
+    std::shared_lock<std::shared_mutex> readLock(structureMutex_);
+    {
+        std::lock_guard<std::mutex> lock(labelMutex_);
+        auto it = labelToNode_.find(label);
+        if (it != labelToNode_.end()) {
+            if (states_[it->second].exchange(kDeleted) == kLive) {
+                liveCount_.fetch_sub(1, std::memory_order_relaxed);
+            }
+            it->second = node;
+        } else {
+            labelToNode_.emplace(label, node);
+        }
+    }
+    labels_[node] = label;
+    insertNode(node, normalized.data(), level);
+}
+
+void HnswIndex::addBatch(const int32_t* labels, const float* vectors, size_t count, int numThreads) {
+    if (count == 0) {
+        return;
+    }
+    {
+        std::unique_lock<std::shared_mutex> writeLock(structureMutex_);
+        grow(static_cast<size_t>(nodeCount_.load()) + count);
+    }
+
+    const size_t threadCount = std::min<size_t>(std::max(numThreads, 1), count);
+    if (threadCount == 1) {
+        for (size_t i = 0; i < count; i++) {
+            add(labels[i], vectors + i * dim_);
+        }
+        return;
+    }
+
+    std::atomic<size_t> next{0};
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    for (size_t t = 0; t < threadCount; t++) {
+        workers.emplace_back([&]() {
+            try {
+                size_t i;
+                while ((i = next.fetch_add(1)) < count) {
+                    add(labels[i], vectors + i * dim_);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool HnswIndex::remove(int32_t label) {
+    std::shared_lock<std::shared_mutex> readLock(structureMutex_);
+    std::lock_guard<std::mutex> lock(labelMutex_);
+    auto it = labelToNode_.find(label);
+    if (it == labelToNode_.end()) {
+        return false;
+    }
+    if (states_[it->second].exchange(kDeleted) == kLive) {
+        liveCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+    labelToNode_.erase(it);
+    return true;
+}
+
+void HnswIndex::insertNode(uint32_t node, const float* normalized, int level) {
+    std::copy(normalized, normalized + dim_, vectors_.data() + static_cast<size_t>(node) * dim_);
+    {
+        std::lock_guard<std::mutex> lock(nodeLocks_[node]);
+        levels_[node] = level;
+        upperLinks_[node].assign(static_cast<size_t>(level) * (M_ + 1), 0);
+        linksAt(node, 0)[0] = 0;
+    }
+
+    // Held for the whole insert only when this node becomes the new top level
+    std::unique_lock<std::mutex> entryLock(entryMutex_);
+    const uint32_t entry = entryPoint_;
+    const int currentMaxLevel = maxLevel_;
+    if (entry == kNoNode) {
+        entryPoint_ = node;
+        maxLevel_ = level;
+    } else {
+        if (level <= currentMaxLevel) {
+            entryLock.unlock();
+        }
+
+        const float* query = vectorAt(node);
+        uint32_t current = greedyDescend(query, entry, currentMaxLevel, level + 1);
+        for (int lc = std::min(level, currentMaxLevel); lc >= 0; lc--) {
+            std::vector<Candidate> candidates = searchLayer(query, current, efConstruction_, lc, false);
+            current = std::min_element(candidates.begin(), candidates.end())->node;
+            connect(node, lc, selectNeighbors(std::move(candidates), M_));
+        }
+
+        if (level > currentMaxLevel) {
+            entryPoint_ = node;
+            maxLevel_ = level;
+        }
+    }
+
+    uint8_t expected = kEmpty;
+    if (states_[node].compare_exchange_strong(expected, kLive, std::memory_order_release)) {
+        liveCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+uint32_t HnswIndex::greedyDescend(const float* query, uint32_t entry, int fromLevel, int toLevel) const {
+    uint32_t current = entry;
+    float currentDistance = distance(query, vectorAt(current));
+    std::vector<uint32_t> neighbors;
+
+    for (int level = fromLevel; level >= toLevel; level--) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            copyLinks(current, level, neighbors);
+            for (uint32_t neighbor : neighbors) {
+                const float d = distance(query, vectorAt(neighbor));
+                if (d < currentDistance) {
+                    currentDistance = d;
+                    current = neighbor;
+                    changed = true;
+                }
+            }
+        }
+    }
+    return current;
+}
+
+std::vector<HnswIndex::Candidate> HnswIndex::searchLayer(const float* query, uint32_t entry, size_t ef,
+                                                         int level, bool liveOnly, const RowBitmap* filter) const {
+    std::unique_ptr<VisitedList> visited = acquireVisited();
+    visited->reset(capacity_);
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> frontier;
+    std::priority_queue<Candidate> results;
+    // Nodes that may be returned; the rest are only walked through
+    auto accepts = [&](uint32_t node) {
+        return (!liveOnly || states_[node].load(std::memory_order_acquire) == kLive) &&
+               (!filter || filter->contains(static_cast<uint32_t>(labels_[node])));
+    };
+
+    const float entryDistance = distance(query, vectorAt(entry));
+    frontier.push({entryDistance, entry});
+    visited->visit(entry);
+    if (accepts(entry)) {
+        results.push({entryDistance, entry});
+    }
+
+    std::vector<uint32_t> neighbors;
+    while (!frontier.empty()) {
+        const Candidate closest = frontier.top();
+        if (results.size() >= ef && closest.distance > results.top().distance) {
+            break;
+        }
+        frontier.pop();
+
+        copyLinks(closest.node, level, neighbors);
+        for (uint32_t neighbor : neighbors) {
+            if (visited->visit(neighbor)) {
+                continue;
+            }
+            const float d = distance(query, vectorAt(neighbor));
+            if (results.size() < ef || d < results.top().distance) {
+                frontier.push({d, neighbor});
+                if (accepts(neighbor)) {
+                    results.push({d, neighbor});
+                    if (results.size() > ef) {
+                        results.pop();
+                    }
+                }
+            }
+        }
+    }
+    releaseVisited(std::move(visited));
+
+    std::vector<Candidate> out;
+    out.reserve(results.size());
+    while (!results.empty()) {
+        out.push_back(results.top());
+        results.pop();
+    }
+    return out;
+}
+
+std::vector<HnswIndex::Candidate> HnswIndex::selectNeighbors(std::vector<Candidate> candidates,
+                                                             size_t maxCount) const {
+    std::sort(candidates.begin(), candidates.end());
+    if (candidates.size() <= maxCount) {
+        return candidates;
+    }
+
+    // Keep a candidate only if it is closer to the base than to any neighbor
+    // already kept, which spreads links across directions
+    std::vector<Candidate> selected;
+    selected.reserve(maxCount);
+    for (const Candidate& candidate : candidates) {
+        if (selected.size() >= maxCount) {
+            break;
+        }
+        bool keep = true;
+        for (const Candidate& kept : selected) {
+            if (distance(vectorAt(candidate.node), vectorAt(kept.node)) < candidate.distance) {
+                keep = false;
+                break;
+            }
+        }
+        if (keep) {
+            selected.push_back(candidate);
+        }
+    }
+    return selected;
+}
+
+void HnswIndex::connect(uint32_t node, int level, const std::vector<Candidate>& neighbors) {
+    const size_t limit = maxLinks(level);
+    {
+        std::lock_guard<std::mutex> lock(nodeLocks_[node]);
+        uint32_t* links = linksAt(node, level);
+        uint32_t count = 0;
+        for (const Candidate& neighbor : neighbors) {
+            if (count >= limit) {
+                break;
+            }
+            links[1 + count++] = neighbor.node;
+        }
+        links[0] = count;
+    }
+
+    for (const Candidate& neighbor : neighbors) {
+        if (neighbor.node == node) {
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(nodeLocks_[neighbor.node]);
+        uint32_t* links = linksAt(neighbor.node, level);
+        const uint32_t count = links[0];
+        if (std::find(links + 1, links + 1 + count, node) != links + 1 + count) {
+            continue;
+        }
+        if (count < limit) {
+            links[1 + count] = node;
+            links[0] = count + 1;
+            continue;
+        }
+
+        // Full: re-run the heuristic over the existing links plus the new node
+        const float* base = vectorAt(neighbor.node);
+        std::vector<Candidate> pool;
+        pool.reserve(count + 1);
+        pool.push_back({distance(base, vectorAt(node)), node});
+        for (uint32_t i = 0; i < count; i++) {
+            pool.push_back({distance(base, vectorAt(links[1 + i])), links[1 + i]});
+        }
+        std::vector<Candidate> kept = selectNeighbors(std::move(pool), limit);
+        for (size_t i = 0; i < kept.size(); i++) {
+            links[1 + i] = kept[i].node;
+        }
+        links[0] = static_cast<uint32_t>(kept.size());
+    }
+}
+
+std::vector<SearchHit> HnswIndex::search(const float* query, int k, int ef, const RowBitmap* filter) const {
+    if (k <= 0) {
+        return {};
+    }
+    std::vector<float> normalized(dim_);
+    normalizeVector(query, normalized.data(), dim_);
+
+    std::shared_lock<std::shared_mutex> readLock(structureMutex_);
+    uint32_t entry;
+    int topLevel;
+    {
+        std::lock_guard<std::mutex> lock(entryMutex_);
+        entry = entryPoint_;
+        topLevel = maxLevel_;
+    }
+    if (entry == kNoNode) {
+        return {};
+    }
+
+    const uint32_t start = greedyDescend(normalized.data(), entry, topLevel, 1);
+    std::vector<Candidate> candidates = searchLayer(
+        normalized.data(), start, static_cast<size_t>(std::max(ef, k)), 0, true, filter);
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<SearchHit> hits;
+    hits.reserve(std::min<size_t>(candidates.size(), k));
+    for (const Candidate& candidate : candidates) {
+        if (hits.size() >= static_cast<size_t>(k)) {
+            break;
+        }
+        hits.push_back({labels_[candidate.node], 1.0f - candidate.distance});
+    }
+    return hits;
+}
+
+std::vector<SearchHit> HnswIndex::exactSearch(const float* query, int k) const {
+    if (k <= 0) {
+        return {};
+    }
+    std::vector<float> normalized(dim_);
+    normalizeVector(query, normalized.data(), dim_);
+
+    std::shared_lock<std::shared_mutex> readLock(structureMutex_);
+    const size_t nodeCount = std::min<size_t>(nodeCount_.load(), capacity_);
+
+    // Score the arena in blocks, partitions of it on the scan pool; each worker
+    // keeps its best k in a bounded heap
+    constexpr uint32_t kBlock = 256;
+    auto scan = [&](uint32_t begin, uint32_t end, TopK& top) {
+        float scores[kBlock];
+        for (uint32_t first = begin; first < end; first += kBlock) {
+            const uint32_t blockSize = std::min<uint32_t>(kBlock, end - first);
+            kernels::dotBlockF32(normalized.data(), vectorAt(first), blockSize, static_cast<size_t>(dim_), scores);
+            for (uint32_t i = 0; i < blockSize; i++) {
+                if (scores[i] >= top.floor() && states_[first + i].load(std::memory_order_acquire) == kLive) {
+                    top.offer(scores[i], first + i);
+                }
+            }
+        }
+    };
+    std::vector<SearchHit> hits = parallelTopK(ScanPool::shared(), static_cast<uint32_t>(nodeCount),
+                                               static_cast<size_t>(dim_) * sizeof(float), kBlock, k,
+                                               -std::numeric_limits<float>::infinity(), scan);
+    for (SearchHit& hit : hits) {
+        hit.label = labels_[hit.label];
+    }
+    return hits;
+}
+
+std::unique_ptr<HnswIndex::VisitedList> HnswIndex::acquireVisited() const {
+    std::lock_guard<std::mutex> lock(visitedMutex_);
+    if (visitedPool_.empty()) {
+        return std::make_unique<VisitedList>();
+    }
+    std::unique_ptr<VisitedList> list = std::move(visitedPool_.back());
+    visitedPool_.pop_back();
+    return list;
+}
+
+void HnswIndex::releaseVisited(std::unique_ptr<VisitedList> list) const {
+    std::lock_guard<std::mutex> lock(visitedMutex_);
+    visitedPool_.push_back(std::move(list));
+}
+
+} // namespace rag
+} // namespace iris
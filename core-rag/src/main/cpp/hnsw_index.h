@@ -0,0 +1,167 @@
+#ifndef IRIS_RAG_HNSW_INDEX_H
+#define IRIS_RAG_HNSW_INDEX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "row_bitmap.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Single search result: caller-assigned label and cosine similarity
+ */
+struct SearchHit {
+    int32_t label;
+    float score;
+};
+
+/**
+ * Hierarchical Navigable Small World graph over cosine similarity.
+ *
+ * Vectors are L2-normalized on insert so that similarity is a plain dot
+ * product. Inserts and searches may run concurrently from several threads:
+ * each node's neighbor lists are guarded by a per-node lock and the arena
+ * only grows under an exclusive lock. Removal is a tombstone; removed nodes
+ * still route searches but are never returned.
+ */
+class HnswIndex {
+public:
+    /**
+     * @param dim Vector dimension
+     * @param M Max neighbors per node on upper layers (2*M on layer 0)
+     * @param efConstruction Candidate list size used while inserting
+     * @param initialCapacity Number of nodes to preallocate
+     * @param seed Seed for the level generator
+     */
+    HnswIndex(int dim, int M = 16, int efConstruction = 200,
+              size_t initialCapacity = 1024, uint64_t seed = 42);
+    ~HnswIndex();
+
+    HnswIndex(const HnswIndex&) = delete;
+    HnswIndex& operator=(const HnswIndex&) = delete;
+
+    int dimension() const { return dim_; }
+
+    /**
+     * Number of live (non-removed) vectors
+     */
+    size_t size() const { return liveCount_.load(std::memory_order_relaxed); }
+
+    /**
+     * Insert a vector. An existing vector with the same label is replaced.
+     */
+    void add(int32_t label, const float* vector);
+
+    /**
+     * Insert `count` row-major vectors using up to `numThreads` threads
+     */
+    void addBatch(const int32_t* labels, const float* vectors, size_t count, int numThreads);
+
+    /**
+     * Remove the vector with the given label
+     * @return true if the label was present
+     */
+    bool remove(int32_t label);
+
+    /**
+     * Approximate top-k search
+     * @param query Query vector (need not be normalized)
+     * @param k Number of results
+     * @param ef Candidate list size; larger is slower but more accurate
+     * @param filter Only labels in this set are returned; other nodes still
+     *        route the traversal. A very selective filter makes the walk visit
+     *        most of the graph, where an exact scan of the set is cheaper.
+     * @return Hits sorted by descending score
+     */
+    std::vector<SearchHit> search(const float* query, int k, int ef, const RowBitmap* filter = nullptr) const;
+
+    /**
+     * Exact top-k over every live vector, partitioned across ScanPool::shared();
+     * the recall baseline for search()
+     */
+    std::vector<SearchHit> exactSearch(const float* query, int k) const;
+
+private:
+    static constexpr uint32_t kNoNode = 0xFFFFFFFFu;
+
+    enum NodeState : uint8_t { kEmpty = 0, kLive = 1, kDeleted = 2 };
+
+    struct Candidate {
+        float distance;
+        uint32_t node;
+        bool operator<(const Candidate& other) const { return distance < other.distance; }
+        bool operator>(const Candidate& other) const { return distance > other.distance; }
+    };
+
+    class VisitedList;
+
+    const int dim_;
+    const size_t M_;
+    const size_t maxM0_;
+    const size_t efConstruction_;
+    const double levelMult_;
+
+    // Arena; reallocated only while structureMutex_ is held exclusively
+    mutable std::shared_mutex structureMutex_;
+    size_t capacity_ = 0;
+    std::vector<float> vectors_;
+    std::vector<int32_t> labels_;
+    std::vector<int> levels_;
+    std::vector<uint32_t> links0_;                  // capacity * (maxM0 + 1), [0] = count
+    std::vector<std::vector<uint32_t>> upperLinks_; // per node, (level) * (M + 1)
+    std::unique_ptr<std::atomic<uint8_t>[]> states_;
+    std::unique_ptr<std::mutex[]> nodeLocks_;
+
+    // Label bookkeeping
+    std::mutex labelMutex_;
+    std::unordered_map<int32_t, uint32_t> labelToNode_;
+    std::atomic<uint32_t> nodeCount_{0};
+    std::atomic<size_t> liveCount_{0};
+
+    // Entry point and level generator
+    mutable std::mutex entryMutex_;
+    uint32_t entryPoint_ = kNoNode;
+    int maxLevel_ = -1;
+    std::mt19937_64 rng_;
+
+    mutable std::mutex visitedMutex_;
+    mutable std::vector<std::unique_ptr<VisitedList>> visitedPool_;
+
+    void grow(size_t minCapacity);
+    int randomLevel();
+    float distance(const float* a, const float* b) const;
+    const float* vectorAt(uint32_t node) const { return vectors_.data() + static_cast<size_t>(node) * dim_; }
+
+    uint32_t* linksAt(uint32_t node, int level);
+    void copyLinks(uint32_t node, int level, std::vector<uint32_t>& out) const;
+    size_t maxLinks(int level) const { return level == 0 ? maxM0_ : M_; }
+
+    void insertNode(uint32_t node, const float* normalized, int level);
+    uint32_t greedyDescend(const float* query, uint32_t entry, int fromLevel, int toLevel) const;
+    std::vector<Candidate> searchLayer(const float* query, uint32_t entry, size_t ef,
+                                       int level, bool liveOnly, const RowBitmap* filter = nullptr) const;
+    std::vector<Candidate> selectNeighbors(std::vector<Candidate> candidates, size_t maxCount) const;
+    void connect(uint32_t node, int level, const std::vector<Candidate>& neighbors);
+
+    std::unique_ptr<VisitedList> acquireVisited() const;
+    void releaseVisited(std::unique_ptr<VisitedList> list) const;
+};
+
+/**
+ * L2-normalize `src` into `dst` (may alias); zero vectors are left as zero
+ */
+void normalizeVector(const float* src, float* dst, int dim);
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_HNSW_INDEX_H
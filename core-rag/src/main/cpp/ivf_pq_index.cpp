@@ -0,0 +1,543 @@
+#include "ivf_pq_index.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <thread>
+
+#include "vector_kernels.h"
+
+#define LOG_TAG "IrisIvfPqIndex"
+#include "rag_log.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+constexpr char kMagic[8] = {'I', 'R', 'I', 'S', 'I', 'V', 'F', '1'};
+constexpr uint32_t kVersion = 1;
+
+// PQ codebooks are trained on at most this many residuals
+constexpr size_t kMaxCodebookSamples = 65536;
+
+/**
+ * Run fn(begin, end) over [0, count) split across threads; rethrows the first error
+ */
+template <typename Fn>
+void parallelFor(size_t count, int numThreads, Fn&& fn) {
+    const size_t threadCount = std::min<size_t>(std::max(numThreads, 1), std::max<size_t>(count, 1));
+    if (threadCount == 1) {
+        fn(size_t{0}, count);
+        return;
+    }
+
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> workers;
+    workers.reserve(threadCount);
+    const size_t chunk = (count + threadCount - 1) / threadCount;
+    for (size_t t = 0; t < threadCount; t++) {
+        const size_t begin = t * chunk;
+        const size_t end = std::min(count, begin + chunk);
+        workers.emplace_back([&, begin, end]() {
+            try {
+                fn(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/**
+ * Index of the best centroid: largest dot for spherical k-means, otherwise
+ * smallest squared L2 (= largest x.c - |c|^2 / 2)
+ */
+uint32_t nearestCentroid(const float* x, const float* centroids, const float* halfNorms, int k, int dim,
+                         float* scores) {
+    kernels::dotBlockF32(x, centroids, static_cast<size_t>(k), static_cast<size_t>(dim), scores);
+    uint32_t best = 0;
+    float bestScore = -std::numeric_limits<float>::infinity();
+    for (int c = 0; c < k; c++) {
+        const float score = halfNorms ? scores[c] - halfNorms[c] : scores[c];
+        if (score > bestScore) {
+            bestScore = score;
+            best = static_cast<uint32_t>(c);
+        }
+    }
+    return best;
+}
+
+void computeHalfNorms(const float* centroids, int k, int dim, float* out) {
+    for (int c = 0; c < k; c++) {
+        const float* v = centroids + static_cast<size_t>(c) * dim;
+        out[c] = 0.5f * kernels::dotF32(v, v, static_cast<size_t>(dim));
+    }
+}
+
+/**
+ * Lloyd's k-means seeded from random samples. Spherical mode keeps centroids
+ * unit-length and assigns by dot product; otherwise assignment is by L2.
+ */
+std::vector<float> kmeans(const float* data, size_t n, int dim, int k, int iterations, bool spherical,
+                          int numThreads, std::mt19937_64& rng, std::vector<uint32_t>& assignment) {
+    std::vector<size_t> order(n);
+    std::iota(order.begin(), order.end(), size_t{0});
+    std::shuffle(order.begin(), order.end(), rng);
+
+    const size_t stride = static_cast<size_t>(dim);
+    std::vector<float> centroids(static_cast<size_t>(k) * stride);
+    for (int c = 0; c < k; c++) {
+        std::memcpy(centroids.data() + c * stride, data + order[c] * stride, stride * sizeof(float));
+    }
+
+    std::vector<float> halfNorms(k);
+    assignment.assign(n, 0);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    for (int iteration = 0; iteration < iterations; iteration++) {
+        if (!spherical) {
+            computeHalfNorms(centroids.data(), k, dim, halfNorms.data());
+        }
+        parallelFor(n, numThreads, [&](size_t begin, size_t end) {
+            std::vector<float> scores(k);
+            for (size_t i = begin; i < end; i++) {
+                assignment[i] = nearestCentroid(data + i * stride, centroids.data(),
+                                                spherical ? nullptr : halfNorms.data(), k, dim, scores.data());
+            }
+        });
+
+        std::vector<double> sums(static_cast<size_t>(k) * stride, 0.0);
+        std::vector<size_t> counts(k, 0);
+        for (size_t i = 0; i < n; i++) {
+            double* sum = sums.data() + assignment[i] * stride;
+            const float* x = data + i * stride;
+            for (size_t d = 0; d < stride; d++) {
+                sum[d] += x[d];
+            }
+            counts[assignment[i]]++;
+        }
+        for (int c = 0; c < k; c++) {
+            float* centroid = centroids.data() + c * stride;
+            if (counts[c] == 0) {
+                // Empty cluster: restart it at a random sample
+                std::memcpy(centroid, data + pick(rng) * stride, stride * sizeof(float));
+                continue;
+            }
+            for (size_t d = 0; d < stride; d++) {
+                centroid[d] = static_cast<float>(sums[c * stride + d] / counts[c]);
+            }
+            if (spherical) {
+                normalizeVector(centroid, centroid, dim);
+            }
+        }
+    }
+    return centroids;
+}
+
+template <typename T>
+void writeValues(std::FILE* file, const T* values, size_t count) {
+    if (count > 0 && std::fwrite(values, sizeof(T), count, file) != count) {
+        throw std::runtime_error("IVF-PQ index write failed");
+    }
+}
+
+template <typename T>
+void readValues(std::FILE* file, T* values, size_t count) {
+    if (count > 0 && std::fread(values, sizeof(T), count, file) != count) {
+        throw std::runtime_error("IVF-PQ index file is truncated");
+    }
+}
+
+} // namespace
+
+IvfPqIndex::IvfPqIndex(int dim, int nlist, int subquantizers)
+    : dim_(dim),
+      nlist_(nlist),
+      subquantizers_(subquantizers),
+      subDim_(subquantizers > 0 ? dim / subquantizers : 0),
+      lists_(static_cast<size_t>(std::max(nlist, 0))) {
+    if (dim <= 0 || nlist <= 0 || subquantizers <= 0 || dim % subquantizers != 0) {
+        throw std::invalid_argument("IVF-PQ needs dim > 0, nlist > 0 and subquantizers dividing dim");
+    }
+}
+
+size_t IvfPqIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return locations_.size();
+}
+
+// ============================================================================
+// Training and encoding
+// ============================================================================
+
+void IvfPqIndex::train(const float* samples, size_t count, int iterations, int numThreads, uint64_t seed) {
+    if (count < static_cast<size_t>(std::max(nlist_, kCodebookSize))) {
+        throw std::invalid_argument("IVF-PQ training needs at least max(nlist, 256) samples");
+    }
+    std::mt19937_64 rng(seed);
+    const size_t stride = static_cast<size_t>(dim_);
+
+    std::vector<float> normalized(count * stride);
+    for (size_t i = 0; i < count; i++) {
+        normalizeVector(samples + i * stride, normalized.data() + i * stride, dim_);
+    }
+
+    std::vector<uint32_t> assignment;
+    centroids_ = kmeans(normalized.data(), count, dim_, nlist_, iterations, true, numThreads, rng, assignment);
+
+    // Residuals of a sample subset, split by subspace for the codebook k-means
+    const size_t residualCount = std::min(count, kMaxCodebookSamples);
+    std::vector<float> subvectors(residualCount * subDim_);
+    codebooks_.assign(static_cast<size_t>(subquantizers_) * kCodebookSize * subDim_, 0.0f);
+    for (int m = 0; m < subquantizers_; m++) {
+        for (size_t i = 0; i < residualCount; i++) {
+            const float* x = normalized.data() + i * stride + m * subDim_;
+            const float* c = centroids_.data() + assignment[i] * stride + m * subDim_;
+            for (int d = 0; d < subDim_; d++) {
+                subvectors[i * subDim_ + d] = x[d] - c[d];
+            }
+        }
+        std::vector<uint32_t> subAssignment;
+        std::vector<float> codebook = kmeans(subvectors.data(), residualCount, subDim_, kCodebookSize, iterations,
+                                             false, numThreads, rng, subAssignment);
+        std::copy(codebook.begin(), codebook.end(),
+                  codebooks_.begin() + static_cast<size_t>(m) * kCodebookSize * subDim_);
+    }
+
+    codebookHalfNorms_.resize(static_cast<size_t>(subquantizers_) * kCodebookSize);
+    computeHalfNorms(codebooks_.data(), subquantizers_ * kCodebookSize, subDim_, codebookHalfNorms_.data());
+    trainedOn_ = count;
+    trained_ = true;
+    LOGI("Trained IVF-PQ (nlist=%d, M=%d) on %zu samples", nlist_, subquantizers_, count);
+}
+
+uint32_t IvfPqIndex::nearestList(const float* normalized) const {
+    std::vector<float> scores(nlist_);
+    return nearestCentroid(normalized, centroids_.data(), nullptr, nlist_, dim_, scores.data());
+}
+
+void IvfPqIndex::encodeResidual(const float* residual, uint8_t* code) const {
+    float scores[kCodebookSize];
+    for (int m = 0; m < subquantizers_; m++) {
+        const size_t offset = static_cast<size_t>(m) * kCodebookSize;
+        code[m] = static_cast<uint8_t>(nearestCentroid(residual + m * subDim_, codebooks_.data() + offset * subDim_,
+                                                       codebookHalfNorms_.data() + offset, kCodebookSize, subDim_,
+                                                       scores));
+    }
+}
+
+// ============================================================================
+// Inverted lists
+// ============================================================================
+
+void IvfPqIndex::add(const int32_t* labels, const float* vectors, size_t count) {
+    if (!trained_) {
+        throw std::logic_error("IVF-PQ index must be trained before adding vectors");
+    }
+    // Encode outside the lock; only the list appends are serialized
+    std::vector<uint32_t> listIds(count);
+    std::vector<uint8_t> codes(count * subquantizers_);
+    std::vector<float> normalized(dim_);
+    for (size_t i = 0; i < count; i++) {
+        normalizeVector(vectors + i * dim_, normalized.data(), dim_);
+        listIds[i] = nearestList(normalized.data());
+        const float* centroid = centroids_.data() + static_cast<size_t>(listIds[i]) * dim_;
+        for (int d = 0; d < dim_; d++) {
+            normalized[d] -= centroid[d];
+        }
+        encodeResidual(normalized.data(), codes.data() + i * subquantizers_);
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (size_t i = 0; i < count; i++) {
+        removeLocked(labels[i]);
+        InvertedList& list = lists_[listIds[i]];
+        locations_[labels[i]] = {listIds[i], static_cast<uint32_t>(list.labels.size())};
+        list.labels.push_back(labels[i]);
+        list.codes.insert(list.codes.end(), codes.begin() + i * subquantizers_,
+                          codes.begin() + (i + 1) * subquantizers_);
+    }
+}
+
+bool IvfPqIndex::remove(int32_t label) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (locations_.find(label) == locations_.end()) {
+        return false;
+    }
+    removeLocked(label);
+    return true;
+}
+
+/**
+ * Swap-remove from the inverted list so lists stay dense for scanning
+ */
+void IvfPqIndex::removeLocked(int32_t label) {
+    auto it = locations_.find(label);
+    if (it == locations_.end()) {
+        return;
+    }
+    const Location location = it->second;
+    locations_.erase(it);
+
+    InvertedList& list = lists_[location.list];
+    const uint32_t last = static_cast<uint32_t>(list.labels.size() - 1);
+    if (location.position != last) {
+        list.labels[location.position] = list.labels[last];
+        std::memcpy(list.codes.data() + static_cast<size_t>(location.position) * subquantizers_,
+                    list.codes.data() + static_cast<size_t>(last) * subquantizers_, subquantizers_);
+        locations_[list.labels[location.position]].position = location.position;
+    }
+    list.labels.pop_back();
+    list.codes.resize(list.codes.size() - subquantizers_);
+}
+
+void IvfPqIndex::relabel(const std::vector<int32_t>& mapping) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    locations_.clear();
+    for (uint32_t l = 0; l < static_cast<uint32_t>(lists_.size()); l++) {
+        InvertedList& list = lists_[l];
+        uint32_t kept = 0;
+        for (size_t i = 0; i < list.labels.size(); i++) {
+            const int32_t old = list.labels[i];
+            const int32_t label = old >= 0 && static_cast<size_t>(old) < mapping.size() ? mapping[old] : -1;
+            if (label < 0) {
+                continue;
+            }
+            if (kept != i) {
+                std::memcpy(list.codes.data() + static_cast<size_t>(kept) * subquantizers_,
+                            list.codes.data() + i * subquantizers_, subquantizers_);
+            }
+            list.labels[kept] = label;
+            locations_[label] = {l, kept};
+            kept++;
+        }
+        list.labels.resize(kept);
+        list.codes.resize(static_cast<size_t>(kept) * subquantizers_);
+    }
+}
+
+bool IvfPqIndex::contains(int32_t label) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return locations_.find(label) != locations_.end();
+}
+
+std::vector<int32_t> IvfPqIndex::labels() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<int32_t> result;
+    result.reserve(locations_.size());
+    for (const auto& entry : locations_) {
+        result.push_back(entry.first);
+    }
+    return result;
+}
+
+// ============================================================================
+// Search
+// ============================================================================
+
+std::vector<SearchHit> IvfPqIndex::search(const float* query, int k, int nprobe, const RowBitmap* filter) const {
+    if (k <= 0 || !trained_) {
+        return {};
+    }
+    std::vector<float> normalized(dim_);
+    normalizeVector(query, normalized.data(), dim_);
+
+    // Coarse scores and the probed lists
+    std::vector<float> listScores(nlist_);
+    kernels::dotBlockF32(normalized.data(), centroids_.data(), static_cast<size_t>(nlist_),
+                         static_cast<size_t>(dim_), listScores.data());
+    const int probes = std::min(std::max(nprobe, 1), nlist_);
+    std::vector<uint32_t> probed(nlist_);
+    std::iota(probed.begin(), probed.end(), 0u);
+    std::partial_sort(probed.begin(), probed.begin() + probes, probed.end(),
+                      [&](uint32_t a, uint32_t b) { return listScores[a] > listScores[b]; });
+
+    // ADC table: q_m . codeword for every subspace and codeword
+    std::vector<float> table(static_cast<size_t>(subquantizers_) * kCodebookSize);
+    for (int m = 0; m < subquantizers_; m++) {
+        const size_t offset = static_cast<size_t>(m) * kCodebookSize;
+        kernels::dotBlockF32(normalized.data() + m * subDim_, codebooks_.data() + offset * subDim_, kCodebookSize,
+                             static_cast<size_t>(subDim_), table.data() + offset);
+    }
+
+    using Entry = std::pair<float, int32_t>; // (-score, label): max-heap top is the worst kept hit
+    std::priority_queue<Entry> best;
+    auto offer = [&](float score, int32_t label) {
+        if (best.size() < static_cast<size_t>(k)) {
+            best.push({-score, label});
+        } else if (-score < best.top().first) {
+            best.pop();
+            best.push({-score, label});
+        }
+    };
+
+    const size_t M = static_cast<size_t>(subquantizers_);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    for (int p = 0; p < probes; p++) {
+        const InvertedList& list = lists_[probed[p]];
+        const float base = listScores[probed[p]];
+        const size_t n = list.labels.size();
+        const uint8_t* codes = list.codes.data();
+
+        if (filter) {
+            for (size_t i = 0; i < n; i++) {
+                if (!filter->contains(static_cast<uint32_t>(list.labels[i]))) {
+                    continue;
+                }
+                const uint8_t* c = codes + i * M;
+                float s = base;
+                for (size_t m = 0; m < M; m++) {
+                    s += table[m * kCodebookSize + c[m]];
+                }
+                offer(s, list.labels[i]);
+            }
+            continue;
+        }
+
+        // Four codes at a time so the table lookups overlap
+        size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            const uint8_t* c0 = codes + i * M;
+            const uint8_t* c1 = c0 + M;
+            const uint8_t* c2 = c1 + M;
+            const uint8_t* c3 = c2 + M;
+            float s0 = base, s1 = base, s2 = base, s3 = base;
+            for (size_t m = 0; m < M; m++) {
+                const float* t = table.data() + m * kCodebookSize;
+                s0 += t[c0[m]];
+                s1 += t[c1[m]];
+                s2 += t[c2[m]];
+                s3 += t[c3[m]];
+            }
+            offer(s0, list.labels[i]);
+            offer(s1, list.labels[i + 1]);
+            offer(s2, list.labels[i + 2]);
+            offer(s3, list.labels[i + 3]);
+        }
+        for (; i < n; i++) {
+            const uint8_t* c = codes + i * M;
+            float s = base;
+            for (size_t m = 0; m < M; m++) {
+                s += table[m * kCodebookSize + c[m]];
+            }
+            offer(s, list.labels[i]);
+        }
+    }
+
+    std::vector<SearchHit> hits(best.size());
+    for (size_t i = hits.size(); i-- > 0;) {
+        hits[i] = {best.top().second, -best.top().first};
+        best.pop();
+    }
+    return hits;
+}
+
+// ============================================================================
+// Persistence
+// ============================================================================
+
+void IvfPqIndex::save(const std::string& path) const {
+    if (!trained_) {
+        throw std::logic_error("Cannot save an untrained IVF-PQ index");
+    }
+    const std::string tmpPath = path + ".tmp";
+    std::FILE* file = std::fopen(tmpPath.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot create " + tmpPath);
+    }
+    try {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const uint64_t trainedOn = trainedOn_;
+        const int32_t shape[3] = {dim_, nlist_, subquantizers_};
+        writeValues(file, kMagic, sizeof(kMagic));
+        writeValues(file, &kVersion, 1);
+        writeValues(file, shape, 3);
+        writeValues(file, &trainedOn, 1);
+        writeValues(file, centroids_.data(), centroids_.size());
+        writeValues(file, codebooks_.data(), codebooks_.size());
+        for (const InvertedList& list : lists_) {
+            const uint32_t n = static_cast<uint32_t>(list.labels.size());
+            writeValues(file, &n, 1);
+            writeValues(file, list.labels.data(), list.labels.size());
+            writeValues(file, list.codes.data(), list.codes.size());
+        }
+    } catch (...) {
+        std::fclose(file);
+        std::remove(tmpPath.c_str());
+        throw;
+    }
+    if (std::fflush(file) != 0 || std::fclose(file) != 0 || std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        std::remove(tmpPath.c_str());
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+std::unique_ptr<IvfPqIndex> IvfPqIndex::load(const std::string& path) {
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+    if (!file) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    try {
+        char magic[8];
+        uint32_t version = 0;
+        int32_t shape[3];
+        uint64_t trainedOn = 0;
+        readValues(file, magic, sizeof(magic));
+        readValues(file, &version, 1);
+        if (std::memcmp(magic, kMagic, sizeof(kMagic)) != 0 || version != kVersion) {
+            throw std::runtime_error("Not an IVF-PQ index file: " + path);
+        }
+        readValues(file, shape, 3);
+        readValues(file, &trainedOn, 1);
+
+        auto index = std::make_unique<IvfPqIndex>(shape[0], shape[1], shape[2]);
+        index->centroids_.resize(static_cast<size_t>(index->nlist_) * index->dim_);
+        index->codebooks_.resize(static_cast<size_t>(index->subquantizers_) * kCodebookSize * index->subDim_);
+        readValues(file, index->centroids_.data(), index->centroids_.size());
+        readValues(file, index->codebooks_.data(), index->codebooks_.size());
+        for (uint32_t l = 0; l < static_cast<uint32_t>(index->nlist_); l++) {
+            InvertedList& list = index->lists_[l];
+            uint32_t n = 0;
+            readValues(file, &n, 1);
+            list.labels.resize(n);
+            list.codes.resize(static_cast<size_t>(n) * index->subquantizers_);
+            readValues(file, list.labels.data(), n);
+            readValues(file, list.codes.data(), list.codes.size());
+            for (uint32_t i = 0; i < n; i++) {
+                index->locations_[list.labels[i]] = {l, i};
+            }
+        }
+        std::fclose(file);
+
+        index->codebookHalfNorms_.resize(static_cast<size_t>(index->subquantizers_) * kCodebookSize);
+        computeHalfNorms(index->codebooks_.data(), index->subquantizers_ * kCodebookSize, index->subDim_,
+                         index->codebookHalfNorms_.data());
+        index->trainedOn_ = trainedOn;
+        index->trained_ = true;
+        return index;
+    } catch (...) {
+        std::fclose(file);
+        throw;
+    }
+}
+
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,133 @@
+#ifndef IRIS_RAG_IVF_PQ_INDEX_H
+#define IRIS_RAG_IVF_PQ_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hnsw_index.h"
+#include "row_bitmap.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Inverted-file index with product-quantized residuals (IVF-PQ).
+ *
+ * A spherical k-means coarse quantizer splits the corpus into `nlist` lists.
+ * Each vector is stored in its nearest list as `subquantizers` one-byte codes
+ * of its residual from the list centroid (256 centroids per subspace), so a
+ * 4096-dim vector costs 4 bytes of label plus e.g. 256 bytes of code.
+ *
+ * Search probes the `nprobe` closest lists. Because vectors are normalized,
+ * the score q.x ~= q.c + sum_m q_m.pq_m[code_m]; the per-subspace tables
+ * q_m.pq_m[*] do not depend on the list and are computed once per query with
+ * the block kernels. Scores are approximate: callers rescore the shortlist
+ * against full-precision vectors (VectorFile::rescore).
+ *
+ * Adds, removes and searches may run concurrently; train() must complete
+ * before the first add.
+ */
+class IvfPqIndex {
+public:
+    /**
+     * @param dim Vector dimension
+     * @param nlist Number of coarse lists
+     * @param subquantizers PQ subspaces; must divide dim
+     */
+    IvfPqIndex(int dim, int nlist, int subquantizers);
+
+    int dimension() const { return dim_; }
+    int nlist() const { return nlist_; }
+    int subquantizers() const { return subquantizers_; }
+    bool isTrained() const { return trained_; }
+
+    /**
+     * Number of vectors the quantizers were trained on
+     */
+    size_t trainedOn() const { return trainedOn_; }
+
+    size_t size() const;
+
+    /**
+     * Train the coarse quantizer and the PQ codebooks
+     * @param samples Row-major vectors (need not be normalized)
+     * @param numThreads Threads used for the k-means assignment steps
+     */
+    void train(const float* samples, size_t count, int iterations, int numThreads, uint64_t seed = 42);
+
+    /**
+     * Encode and insert vectors; an existing label is replaced
+     */
+    void add(const int32_t* labels, const float* vectors, size_t count);
+
+    bool remove(int32_t label);
+
+    /**
+     * Rename every label `l` to `mapping[l]`, e.g. after the store it indexes is
+     * compacted; labels mapped to -1 or beyond the mapping are removed. Codes are
+     * kept, so nothing is re-encoded.
+     */
+    void relabel(const std::vector<int32_t>& mapping);
+
+    bool contains(int32_t label) const;
+
+    /**
+     * Every label in the index
+     */
+    std::vector<int32_t> labels() const;
+
+    /**
+     * Approximate top-k by asymmetric distance over the `nprobe` nearest lists
+     * @param filter Only labels in this set are scored
+     */
+    std::vector<SearchHit> search(const float* query, int k, int nprobe, const RowBitmap* filter = nullptr) const;
+
+    /**
+     * Write the trained quantizers and lists to `path` (via a temporary file)
+     */
+    void save(const std::string& path) const;
+
+    static std::unique_ptr<IvfPqIndex> load(const std::string& path);
+
+private:
+    static constexpr int kCodebookSize = 256;
+
+    struct InvertedList {
+        std::vector<int32_t> labels;
+        std::vector<uint8_t> codes; // subquantizers_ bytes per entry
+    };
+
+    struct Location {
+        uint32_t list;
+        uint32_t position;
+    };
+
+    const int dim_;
+    const int nlist_;
+    const int subquantizers_;
+    const int subDim_;
+
+    bool trained_ = false;
+    size_t trainedOn_ = 0;
+    std::vector<float> centroids_; // nlist x dim, normalized
+    std::vector<float> codebooks_; // subquantizers x 256 x subDim
+    std::vector<float> codebookHalfNorms_; // |codeword|^2 / 2 for residual encoding
+
+    mutable std::shared_mutex mutex_;
+    std::vector<InvertedList> lists_;
+    std::unordered_map<int32_t, Location> locations_;
+
+    uint32_t nearestList(const float* normalized) const;
+    void encodeResidual(const float* residual, uint8_t* code) const;
+    void removeLocked(int32_t label);
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_IVF_PQ_INDEX_H
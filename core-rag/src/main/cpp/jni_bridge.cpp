@@ -0,0 +1,1451 @@
+#include <jni.h>
+#include <algorithm>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "bm25_index.h"
+#include "context_packer.h"
+#include "hnsw_index.h"
+#include "ivf_pq_index.h"
+#include "near_duplicate_index.h"
+#include "query_cache.h"
+#include "rank_fusion.h"
+#include "subword_tokenizer.h"
+#include "text_chunker.h"
+#include "text_normalizer.h"
+#include "tfidf_index.h"
+#include "vector_file.h"
+
+#define LOG_TAG "IrisRag"
+#include "rag_log.h"
+
+using iris::rag::Bm25Index;
+using iris::rag::ChunkRecord;
+using iris::rag::ContextPacker;
+using iris::rag::HnswIndex;
+using iris::rag::IvfPqIndex;
+using iris::rag::NearDuplicateIndex;
+using iris::rag::QueryCache;
+using iris::rag::RowBitmap;
+using iris::rag::RowFilter;
+using iris::rag::SearchHit;
+using iris::rag::SubwordTokenizer;
+using iris::rag::TextChunker;
+using iris::rag::TextNormalizer;
+using iris::rag::TfIdfIndex;
+using iris::rag::VectorFile;
+
+namespace {
+
+void throwException(JNIEnv* env, const char* exceptionClass, const char* message) {
+    jclass clazz = env->FindClass(exceptionClass);
+    if (!clazz) {
+        env->ExceptionClear();
+        clazz = env->FindClass("java/lang/RuntimeException");
+    }
+    env->ThrowNew(clazz, message);
+}
+
+HnswIndex* toIndex(jlong handle) {
+    return reinterpret_cast<HnswIndex*>(handle);
+}
+
+Bm25Index* toBm25Index(jlong handle) {
+    return reinterpret_cast<Bm25Index*>(handle);
+}
+
+IvfPqIndex* toIvfPqIndex(jlong handle) {
+    return reinterpret_cast<IvfPqIndex*>(handle);
+}
+
+VectorFile* toVectorFile(jlong handle) {
+    return reinterpret_cast<VectorFile*>(handle);
+}
+
+SubwordTokenizer* toTokenizer(jlong handle) {
+    return reinterpret_cast<SubwordTokenizer*>(handle);
+}
+
+TfIdfIndex* toTfIdfIndex(jlong handle) {
+    return reinterpret_cast<TfIdfIndex*>(handle);
+}
+
+QueryCache* toQueryCache(jlong handle) {
+    return reinterpret_cast<QueryCache*>(handle);
+}
+
+NearDuplicateIndex* toNearDuplicateIndex(jlong handle) {
+    return reinterpret_cast<NearDuplicateIndex*>(handle);
+}
+
+ContextPacker* toContextPacker(jlong handle) {
+    return reinterpret_cast<ContextPacker*>(handle);
+}
+
+/**
+ * Optional Java float[] copied out; empty when null
+ */
+std::vector<float> toFloats(JNIEnv* env, jfloatArray values) {
+    std::vector<float> out(values ? env->GetArrayLength(values) : 0);
+    if (!out.empty()) {
+        env->GetFloatArrayRegion(values, 0, static_cast<jsize>(out.size()), out.data());
+    }
+    return out;
+}
+
+/**
+ * Optional row filter; 0 means search every live row
+ */
+const RowBitmap* toRowBitmap(jlong handle) {
+    return reinterpret_cast<const RowBitmap*>(handle);
+}
+
+/**
+ * Java string to standard UTF-8 (GetStringUTFChars yields modified UTF-8,
+ * which encodes supplementary characters and NUL differently)
+ */
+std::string toUtf8(JNIEnv* env, jstring value) {
+    std::string out;
+    if (!value) {
+        return out;
+    }
+    const jsize length = env->GetStringLength(value);
+    const jchar* chars = env->GetStringCritical(value, nullptr);
+    out.reserve(static_cast<size_t>(length));
+    for (jsize i = 0; i < length; i++) {
+        uint32_t cp = chars[i];
+        if (cp >= 0xd800 && cp < 0xdc00 && i + 1 < length && chars[i + 1] >= 0xdc00 && chars[i + 1] < 0xe000) {
+            cp = 0x10000 + ((cp - 0xd800) << 10) + (chars[++i] - 0xdc00);
+        } else if (cp >= 0xd800 && cp < 0xe000) {
+            cp = 0xfffd; // unpaired surrogate
+        }
+        if (cp < 0x80) {
+            out += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            out += static_cast<char>(0xc0 | (cp >> 6));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else if (cp < 0x10000) {
+            out += static_cast<char>(0xe0 | (cp >> 12));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        } else {
+            out += static_cast<char>(0xf0 | (cp >> 18));
+            out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+            out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+            out += static_cast<char>(0x80 | (cp & 0x3f));
+        }
+    }
+    env->ReleaseStringCritical(value, chars);
+    return out;
+}
+
+/**
+ * Standard UTF-8 to a Java string; malformed sequences become U+FFFD
+ */
+jstring fromUtf8(JNIEnv* env, const std::string& value) {
+    std::vector<jchar> chars;
+    chars.reserve(value.size());
+    const auto* bytes = reinterpret_cast<const uint8_t*>(value.data());
+    const size_t size = value.size();
+    for (size_t i = 0; i < size;) {
+        const uint8_t lead = bytes[i];
+        int extra = lead < 0x80 ? 0 : (lead >> 5) == 0x6 ? 1 : (lead >> 4) == 0xe ? 2 : (lead >> 3) == 0x1e ? 3 : -1;
+        uint32_t cp = extra == 0 ? lead : extra == 1 ? lead & 0x1f : extra == 2 ? lead & 0x0f : lead & 0x07;
+        bool valid = extra >= 0 && i + extra < size;
+        for (int k = 1; valid && k <= extra; k++) {
+            valid = (bytes[i + k] & 0xc0) == 0x80;
+            cp = (cp << 6) | (bytes[i + k] & 0x3f);
+        }
+        if (!valid) {
+            chars.push_back(0xfffd);
+            i++;
+            continue;
+        }
+        i += static_cast<size_t>(extra) + 1;
+        if (cp >= 0x10000) {
+            cp -= 0x10000;
+            chars.push_back(static_cast<jchar>(0xd800 + (cp >> 10)));
+            chars.push_back(static_cast<jchar>(0xdc00 + (cp & 0x3ff)));
+        } else {
+            chars.push_back(static_cast<jchar>(cp));
+        }
+    }
+    return env->NewString(chars.data(), static_cast<jsize>(chars.size()));
+}
+
+/**
+ * Maps ascending byte offsets of a UTF-8 string to UTF-16 indices of the
+ * Java string it was converted from, in one forward pass
+ */
+class Utf16Cursor {
+public:
+    explicit Utf16Cursor(const std::string& utf8) : utf8_(utf8) {}
+
+    jint advanceTo(size_t byteOffset) {
+        for (; byte_ < byteOffset; byte_++) {
+            const auto lead = static_cast<uint8_t>(utf8_[byte_]);
+            if ((lead & 0xc0) != 0x80) {
+                utf16_ += lead >= 0xf0 ? 2 : 1; // supplementary characters are surrogate pairs
+            }
+        }
+        return utf16_;
+    }
+
+private:
+    const std::string& utf8_;
+    size_t byte_ = 0;
+    jint utf16_ = 0;
+};
+
+/**
+ * Sentences as (start, end, paragraphStart) triples in UTF-16 units of the
+ * Java string `utf8` was converted from or is converted to; `source` picks
+ * the source or the normalized range
+ */
+jintArray toSentenceArray(JNIEnv* env, const std::string& utf8, const std::vector<iris::rag::SentenceSpan>& sentences,
+                          bool source) {
+    Utf16Cursor begins(utf8);
+    Utf16Cursor ends(utf8);
+    std::vector<jint> spans;
+    spans.reserve(sentences.size() * 3);
+    for (const iris::rag::SentenceSpan& sentence : sentences) {
+        spans.push_back(begins.advanceTo(source ? sentence.sourceBegin : sentence.begin));
+        spans.push_back(ends.advanceTo(source ? sentence.sourceEnd : sentence.end));
+        spans.push_back(sentence.paragraphStart ? 1 : 0);
+    }
+    jintArray result = env->NewIntArray(static_cast<jsize>(spans.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(spans.size()), spans.data());
+    return result;
+}
+
+std::string stringAt(JNIEnv* env, jobjectArray array, jsize index) {
+    auto value = static_cast<jstring>(env->GetObjectArrayElement(array, index));
+    std::string out = toUtf8(env, value);
+    env->DeleteLocalRef(value);
+    return out;
+}
+
+/**
+ * Copy hits into caller-provided label/score arrays; returns the hit count
+ */
+jint writeHits(JNIEnv* env, const std::vector<SearchHit>& hits, jintArray outLabels, jfloatArray outScores) {
+    std::vector<jint> labels(hits.size());
+    std::vector<jfloat> scores(hits.size());
+    for (size_t i = 0; i < hits.size(); i++) {
+        labels[i] = hits[i].label;
+        scores[i] = hits[i].score;
+    }
+    env->SetIntArrayRegion(outLabels, 0, static_cast<jsize>(hits.size()), labels.data());
+    env->SetFloatArrayRegion(outScores, 0, static_cast<jsize>(hits.size()), scores.data());
+    return static_cast<jint>(hits.size());
+}
+
+} // namespace
+
+extern "C" {
+
+// ============================================================================
+// HNSW index
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeCreate(
+    JNIEnv* env, jobject thiz, jint dimension, jint m, jint ef_construction, jint capacity) {
+
+    try {
+        auto* index = new HnswIndex(dimension, m, ef_construction, static_cast<size_t>(capacity));
+        LOGI("Created HNSW index (dim=%d, M=%d, efConstruction=%d)", dimension, m, ef_construction);
+        return reinterpret_cast<jlong>(index);
+    } catch (const std::exception& e) {
+        LOGE("HNSW index creation failed: %s", e.what());
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeAdd(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray labels, jfloatArray vectors, jint threads) {
+
+    HnswIndex* index = toIndex(handle);
+    const jsize count = env->GetArrayLength(labels);
+    if (static_cast<jlong>(env->GetArrayLength(vectors)) !=
+        static_cast<jlong>(count) * index->dimension()) {
+        throwException(env, "java/lang/IllegalArgumentException", "Vector data does not match label count");
+        return;
+    }
+
+    jint* labelData = env->GetIntArrayElements(labels, nullptr);
+    jfloat* vectorData = env->GetFloatArrayElements(vectors, nullptr);
+    try {
+        index->addBatch(labelData, vectorData, static_cast<size_t>(count), threads);
+    } catch (const std::exception& e) {
+        LOGE("HNSW insert failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+    env->ReleaseFloatArrayElements(vectors, vectorData, JNI_ABORT);
+    env->ReleaseIntArrayElements(labels, labelData, JNI_ABORT);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeRemove(
+    JNIEnv* env, jobject thiz, jlong handle, jint label) {
+
+    return toIndex(handle)->remove(label) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeSearch(
+    JNIEnv* env, jobject thiz, jlong handle, jfloatArray query, jint k, jint ef, jlong filter_handle,
+    jintArray out_labels, jfloatArray out_scores) {
+
+    HnswIndex* index = toIndex(handle);
+    if (env->GetArrayLength(query) != index->dimension()) {
+        throwException(env, "java/lang/IllegalArgumentException", "Query dimension mismatch");
+        return 0;
+    }
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+
+    std::vector<float> queryData(index->dimension());
+    env->GetFloatArrayRegion(query, 0, index->dimension(), queryData.data());
+
+    try {
+        return writeHits(env, index->search(queryData.data(), std::min(k, capacity), ef, toRowBitmap(filter_handle)),
+                         out_labels, out_scores);
+    } catch (const std::exception& e) {
+        LOGE("HNSW search failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeExactSearch(
+    JNIEnv* env, jobject thiz, jlong handle, jfloatArray query, jint k,
+    jintArray out_labels, jfloatArray out_scores) {
+
+    HnswIndex* index = toIndex(handle);
+    if (env->GetArrayLength(query) != index->dimension()) {
+        throwException(env, "java/lang/IllegalArgumentException", "Query dimension mismatch");
+        return 0;
+    }
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+
+    std::vector<float> queryData(index->dimension());
+    env->GetFloatArrayRegion(query, 0, index->dimension(), queryData.data());
+
+    try {
+        return writeHits(env, index->exactSearch(queryData.data(), std::min(k, capacity)), out_labels, out_scores);
+    } catch (const std::exception& e) {
+        LOGE("Exact search failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeAddFromFile(
+    JNIEnv* env, jobject thiz, jlong handle, jlong file_handle, jintArray rows, jint threads) {
+
+    std::vector<uint32_t> rowData(env->GetArrayLength(rows));
+    env->GetIntArrayRegion(rows, 0, static_cast<jsize>(rowData.size()), reinterpret_cast<jint*>(rowData.data()));
+    try {
+        toVectorFile(file_handle)->addToIndex(*toIndex(handle), rowData, threads);
+    } catch (const std::exception& e) {
+        LOGE("HNSW build from vector store failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeSize(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toIndex(handle)->size());
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_HnswIndex_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toIndex(handle);
+}
+
+// ============================================================================
+// BM25 index and rank fusion
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeCreate(
+    JNIEnv* env, jobject thiz, jfloat k1, jfloat b) {
+
+    try {
+        return reinterpret_cast<jlong>(new Bm25Index(k1, b));
+    } catch (const std::exception& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeAdd(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray docs, jobjectArray texts) {
+
+    const jsize count = env->GetArrayLength(docs);
+    if (env->GetArrayLength(texts) != count) {
+        throwException(env, "java/lang/IllegalArgumentException", "Text count does not match document count");
+        return;
+    }
+    std::vector<jint> docData(count);
+    env->GetIntArrayRegion(docs, 0, count, docData.data());
+    try {
+        Bm25Index* index = toBm25Index(handle);
+        for (jsize i = 0; i < count; i++) {
+            index->add(docData[i], stringAt(env, texts, i));
+        }
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+    } catch (const std::exception& e) {
+        LOGE("BM25 add failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeAddFromFile(
+    JNIEnv* env, jobject thiz, jlong handle, jlong file_handle, jintArray rows) {
+
+    std::vector<uint32_t> rowData(env->GetArrayLength(rows));
+    env->GetIntArrayRegion(rows, 0, static_cast<jsize>(rowData.size()), reinterpret_cast<jint*>(rowData.data()));
+    try {
+        toVectorFile(file_handle)->addToIndex(*toBm25Index(handle), rowData);
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+    } catch (const std::exception& e) {
+        LOGE("BM25 add from vector store failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeSyncWithFile(
+    JNIEnv* env, jobject thiz, jlong handle, jlong file_handle) {
+
+    // Drop documents the store has deleted and index rows appended after the last one
+    Bm25Index* index = toBm25Index(handle);
+    VectorFile* file = toVectorFile(file_handle);
+    try {
+        const std::vector<uint32_t> live = file->liveRows();
+        for (int32_t doc : index->documents()) {
+            if (!std::binary_search(live.begin(), live.end(), static_cast<uint32_t>(doc))) {
+                index->remove(doc);
+            }
+        }
+        const int64_t last = index->lastDocument();
+        std::vector<uint32_t> appended;
+        for (uint32_t row : live) {
+            if (static_cast<int64_t>(row) > last) {
+                appended.push_back(row);
+            }
+        }
+        file->addToIndex(*index, appended);
+    } catch (const std::exception& e) {
+        LOGE("BM25 sync failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeRemove(
+    JNIEnv* env, jobject thiz, jlong handle, jint doc) {
+
+    return toBm25Index(handle)->remove(doc) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeSearch(
+    JNIEnv* env, jobject thiz, jlong handle, jstring query, jint k,
+    jintArray out_labels, jfloatArray out_scores) {
+
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+    return writeHits(env, toBm25Index(handle)->search(toUtf8(env, query), std::min(k, capacity)), out_labels,
+                     out_scores);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeSize(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toBm25Index(handle)->size());
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_Bm25Index_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toBm25Index(handle);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_RankFusion_nativeFuse(
+    JNIEnv* env, jclass clazz, jobjectArray rankings, jint limit, jfloat k0,
+    jintArray out_labels, jfloatArray out_scores) {
+
+    std::vector<std::vector<int32_t>> lists(env->GetArrayLength(rankings));
+    for (size_t i = 0; i < lists.size(); i++) {
+        auto ranking = static_cast<jintArray>(env->GetObjectArrayElement(rankings, static_cast<jsize>(i)));
+        lists[i].resize(env->GetArrayLength(ranking));
+        env->GetIntArrayRegion(ranking, 0, static_cast<jsize>(lists[i].size()), lists[i].data());
+        env->DeleteLocalRef(ranking);
+    }
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+    const size_t keep = static_cast<size_t>(std::max(0, std::min(limit, capacity)));
+    return writeHits(env, iris::rag::reciprocalRankFusion(lists, keep, k0), out_labels, out_scores);
+}
+
+// ============================================================================
+// TF-IDF index
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_TfIdfIndex_nativeCreate(
+    JNIEnv* env, jobject thiz, jobjectArray stop_words, jint min_term_chars) {
+
+    std::vector<std::string> stopWords(env->GetArrayLength(stop_words));
+    for (size_t i = 0; i < stopWords.size(); i++) {
+        stopWords[i] = stringAt(env, stop_words, static_cast<jsize>(i));
+    }
+    return reinterpret_cast<jlong>(new TfIdfIndex(stopWords, static_cast<size_t>(std::max(min_term_chars, 0))));
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_TfIdfIndex_nativeAdd(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray docs, jobjectArray texts) {
+
+    const jsize count = env->GetArrayLength(docs);
+    if (env->GetArrayLength(texts) != count) {
+        throwException(env, "java/lang/IllegalArgumentException", "Text count does not match document count");
+        return;
+    }
+    std::vector<jint> docData(count);
+    env->GetIntArrayRegion(docs, 0, count, docData.data());
+    try {
+        TfIdfIndex* index = toTfIdfIndex(handle);
+        for (jsize i = 0; i < count; i++) {
+            index->add(docData[i], stringAt(env, texts, i));
+        }
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+    } catch (const std::exception& e) {
+        LOGE("TF-IDF add failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_rag_TfIdfIndex_nativeRemove(
+    JNIEnv* env, jobject thiz, jlong handle, jint doc) {
+
+    return toTfIdfIndex(handle)->remove(doc) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_TfIdfIndex_nativeSearch(
+    JNIEnv* env, jobject thiz, jlong handle, jstring query, jint k,
+    jintArray out_labels, jfloatArray out_scores) {
+
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+    return writeHits(env, toTfIdfIndex(handle)->search(toUtf8(env, query), std::min(k, capacity)), out_labels,
+                     out_scores);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_TfIdfIndex_nativeSize(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toTfIdfIndex(handle)->size());
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_TfIdfIndex_nativeMemoryBytes(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jlong>(toTfIdfIndex(handle)->memoryBytes());
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_TfIdfIndex_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toTfIdfIndex(handle);
+}
+
+// ============================================================================
+// Query cache
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_QueryCache_nativeCreate(
+    JNIEnv* env, jobject thiz, jint capacity, jfloat min_similarity) {
+
+    return reinterpret_cast<jlong>(new QueryCache(static_cast<size_t>(std::max(capacity, 1)), min_similarity));
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_QueryCache_nativeLookupExact(
+    JNIEnv* env, jobject thiz, jlong handle, jstring query, jlong version, jint k) {
+
+    return toQueryCache(handle)->lookupExact(toUtf8(env, query), static_cast<uint64_t>(version), k);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_QueryCache_nativeLookupSimilar(
+    JNIEnv* env, jobject thiz, jlong handle, jfloatArray embedding, jlong version, jint k) {
+
+    const std::vector<float> query = toFloats(env, embedding);
+    if (query.empty()) {
+        return -1;
+    }
+    return toQueryCache(handle)->lookupSimilar(query.data(), query.size(), static_cast<uint64_t>(version), k);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_QueryCache_nativePut(
+    JNIEnv* env, jobject thiz, jlong handle, jstring query, jfloatArray embedding, jlong version, jint k,
+    jdouble cost_ms, jdouble embed_ms) {
+
+    const std::vector<float> vector = toFloats(env, embedding);
+    return toQueryCache(handle)->put(toUtf8(env, query), vector.empty() ? nullptr : vector.data(), vector.size(),
+                                     static_cast<uint64_t>(version), k, cost_ms, embed_ms);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_QueryCache_nativeClear(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    toQueryCache(handle)->clear();
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_QueryCache_nativeStats(
+    JNIEnv* env, jobject thiz, jlong handle, jlongArray out_stats) {
+
+    // Layout shared with QueryCache.kt: lookups, exact hits, semantic hits,
+    // invalidations, evictions, entries, saved microseconds
+    const QueryCache::Stats stats = toQueryCache(handle)->stats();
+    const jlong values[] = {static_cast<jlong>(stats.lookups), static_cast<jlong>(stats.exactHits),
+                            static_cast<jlong>(stats.semanticHits), static_cast<jlong>(stats.invalidations),
+                            static_cast<jlong>(stats.evictions), static_cast<jlong>(stats.entries),
+                            static_cast<jlong>(stats.savedMs * 1000.0)};
+    const jsize count = static_cast<jsize>(sizeof(values) / sizeof(values[0]));
+    env->SetLongArrayRegion(out_stats, 0, std::min(env->GetArrayLength(out_stats), count), values);
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_QueryCache_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toQueryCache(handle);
+}
+
+// ============================================================================
+// Near-duplicate index
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_NearDuplicateIndex_nativeCreate(
+    JNIEnv* env, jobject thiz, jint bands, jint rows, jfloat threshold) {
+
+    try {
+        return reinterpret_cast<jlong>(new NearDuplicateIndex(bands, rows, threshold));
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_NearDuplicateIndex_nativeAddOrMatch(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray labels, jobjectArray texts, jintArray out_matches) {
+
+    const jsize count = env->GetArrayLength(labels);
+    if (env->GetArrayLength(texts) != count || env->GetArrayLength(out_matches) < count) {
+        throwException(env, "java/lang/IllegalArgumentException", "Text count does not match label count");
+        return;
+    }
+    std::vector<jint> labelData(count);
+    env->GetIntArrayRegion(labels, 0, count, labelData.data());
+    // In order, so a text can match one earlier in the same batch
+    std::vector<jint> matches(count);
+    NearDuplicateIndex* index = toNearDuplicateIndex(handle);
+    for (jsize i = 0; i < count; i++) {
+        matches[i] = index->addOrMatch(labelData[i], stringAt(env, texts, i));
+    }
+    env->SetIntArrayRegion(out_matches, 0, count, matches.data());
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_rag_NearDuplicateIndex_nativeRemove(
+    JNIEnv* env, jobject thiz, jlong handle, jint label) {
+
+    return toNearDuplicateIndex(handle)->remove(label) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_NearDuplicateIndex_nativeSize(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toNearDuplicateIndex(handle)->size());
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_NearDuplicateIndex_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toNearDuplicateIndex(handle);
+}
+
+// ============================================================================
+// Context packer
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_ContextPacker_nativeCreate(
+    JNIEnv* env, jobject thiz, jfloat lambda, jfloat max_redundancy) {
+
+    try {
+        return reinterpret_cast<jlong>(new ContextPacker(lambda, max_redundancy));
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_ContextPacker_nativePack(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray labels, jfloatArray scores, jintArray tokens,
+    jintArray offsets, jintArray separator, jint budget, jintArray out_labels, jintArray out_tokens) {
+
+    // Candidate i's tokens are tokens[offsets[i], offsets[i + 1])
+    const jsize count = env->GetArrayLength(labels);
+    const jsize tokenCount = env->GetArrayLength(tokens);
+    if (env->GetArrayLength(scores) != count || env->GetArrayLength(offsets) != count + 1) {
+        throwException(env, "java/lang/IllegalArgumentException", "Candidate arrays differ in length");
+        return 0;
+    }
+    std::vector<jint> labelData(count);
+    std::vector<jfloat> scoreData(count);
+    std::vector<jint> tokenData(tokenCount);
+    std::vector<jint> offsetData(count + 1);
+    std::vector<jint> separatorData(env->GetArrayLength(separator));
+    env->GetIntArrayRegion(labels, 0, count, labelData.data());
+    env->GetFloatArrayRegion(scores, 0, count, scoreData.data());
+    env->GetIntArrayRegion(tokens, 0, tokenCount, tokenData.data());
+    env->GetIntArrayRegion(offsets, 0, count + 1, offsetData.data());
+    env->GetIntArrayRegion(separator, 0, static_cast<jsize>(separatorData.size()), separatorData.data());
+
+    std::vector<iris::rag::PackCandidate> candidates(count);
+    for (jsize i = 0; i < count; i++) {
+        if (offsetData[i] < 0 || offsetData[i] > offsetData[i + 1] || offsetData[i + 1] > tokenCount) {
+            throwException(env, "java/lang/IllegalArgumentException", "Token offsets out of range");
+            return 0;
+        }
+        candidates[i] = {labelData[i], scoreData[i], tokenData.data() + offsetData[i],
+                         static_cast<size_t>(offsetData[i + 1] - offsetData[i])};
+    }
+    const iris::rag::PackedContext packed = toContextPacker(handle)->pack(
+        candidates, static_cast<size_t>(std::max(budget, 0)),
+        std::vector<int32_t>(separatorData.begin(), separatorData.end()));
+
+    // The caller sizes out_tokens to the budget and out_labels to the candidates
+    const jsize packedLabels = std::min(env->GetArrayLength(out_labels), static_cast<jsize>(packed.labels.size()));
+    const jsize packedTokens = std::min(env->GetArrayLength(out_tokens), static_cast<jsize>(packed.tokens.size()));
+    env->SetIntArrayRegion(out_labels, 0, packedLabels, packed.labels.data());
+    env->SetIntArrayRegion(out_tokens, 0, packedTokens, packed.tokens.data());
+    return packedLabels;
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_ContextPacker_nativeReset(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    toContextPacker(handle)->reset();
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_ContextPacker_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toContextPacker(handle);
+}
+
+// ============================================================================
+// Subword tokenizer and chunker
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_SubwordTokenizer_nativeCreate(
+    JNIEnv* env, jclass clazz) {
+
+    return reinterpret_cast<jlong>(new SubwordTokenizer());
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_SubwordTokenizer_nativeLoad(
+    JNIEnv* env, jclass clazz, jstring vocab_path) {
+
+    try {
+        auto tokenizer = SubwordTokenizer::load(toUtf8(env, vocab_path));
+        LOGI("Loaded vocabulary of %zu pieces", tokenizer->vocabularySize());
+        return reinterpret_cast<jlong>(tokenizer.release());
+    } catch (const std::exception& e) {
+        LOGE("Vocabulary load failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_SubwordTokenizer_nativeVocabularySize(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toTokenizer(handle)->vocabularySize());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_SubwordTokenizer_nativeCountTokens(
+    JNIEnv* env, jobject thiz, jlong handle, jstring text) {
+
+    return static_cast<jint>(toTokenizer(handle)->countTokens(toUtf8(env, text)));
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_SubwordTokenizer_nativeChunk(
+    JNIEnv* env, jobject thiz, jlong handle, jstring text, jint max_tokens, jint overlap_tokens) {
+
+    try {
+        const TextChunker chunker(*toTokenizer(handle), static_cast<size_t>(std::max(max_tokens, 0)),
+                                  static_cast<size_t>(std::max(overlap_tokens, 0)));
+        const std::string utf8 = toUtf8(env, text);
+
+        // Chunk starts and ends each ascend, so one cursor per side converts them
+        Utf16Cursor begins(utf8);
+        Utf16Cursor ends(utf8);
+        std::vector<jint> spans;
+        chunker.chunk(utf8, [&](const iris::rag::ChunkSpan& span) {
+            spans.push_back(begins.advanceTo(span.begin));
+            spans.push_back(ends.advanceTo(span.end));
+            spans.push_back(static_cast<jint>(span.tokens));
+        });
+
+        jintArray result = env->NewIntArray(static_cast<jsize>(spans.size()));
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(spans.size()), spans.data());
+        return result;
+    } catch (const std::exception& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_SubwordTokenizer_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toTokenizer(handle);
+}
+
+// ============================================================================
+// Text normalizer
+// ============================================================================
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_TextNormalizer_nativeNormalize(
+    JNIEnv* env, jclass clazz, jbyteArray bytes, jboolean dehyphenate, jobjectArray out_text) {
+
+    try {
+        // Fed in slices, so the document is never copied whole before normalization
+        constexpr jsize kSliceBytes = 64 * 1024;
+        TextNormalizer normalizer({dehyphenate == JNI_TRUE});
+        const jsize length = env->GetArrayLength(bytes);
+        std::vector<char> slice(static_cast<size_t>(std::min(length, kSliceBytes)));
+        for (jsize at = 0; at < length; at += static_cast<jsize>(slice.size())) {
+            const jsize count = std::min<jsize>(static_cast<jsize>(slice.size()), length - at);
+            env->GetByteArrayRegion(bytes, at, count, reinterpret_cast<jbyte*>(slice.data()));
+            normalizer.feed(std::string_view(slice.data(), static_cast<size_t>(count)));
+        }
+        const iris::rag::NormalizedText normalized = normalizer.finish();
+        if (normalized.invalidSequences > 0) {
+            LOGW("Replaced %zu malformed UTF-8 sequences", normalized.invalidSequences);
+        }
+
+        env->SetObjectArrayElement(out_text, 0, fromUtf8(env, normalized.text));
+        return toSentenceArray(env, normalized.text, normalized.sentences, false);
+    } catch (const std::exception& e) {
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_TextNormalizer_nativeNormalizeText(
+    JNIEnv* env, jclass clazz, jstring text, jboolean dehyphenate, jobjectArray out_text) {
+
+    try {
+        const iris::rag::NormalizedText normalized =
+            TextNormalizer::normalize(toUtf8(env, text), {dehyphenate == JNI_TRUE});
+        env->SetObjectArrayElement(out_text, 0, fromUtf8(env, normalized.text));
+        return toSentenceArray(env, normalized.text, normalized.sentences, false);
+    } catch (const std::exception& e) {
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_TextNormalizer_nativeSentences(
+    JNIEnv* env, jclass clazz, jstring text) {
+
+    try {
+        const std::string utf8 = toUtf8(env, text);
+        return toSentenceArray(env, utf8, TextNormalizer::normalize(utf8).sentences, true);
+    } catch (const std::exception& e) {
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return nullptr;
+    }
+}
+
+// ============================================================================
+// IVF-PQ index
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeCreate(
+    JNIEnv* env, jclass clazz, jint dimension, jint nlist, jint subquantizers) {
+
+    try {
+        auto* index = new IvfPqIndex(dimension, nlist, subquantizers);
+        LOGI("Created IVF-PQ index (dim=%d, nlist=%d, M=%d)", dimension, nlist, subquantizers);
+        return reinterpret_cast<jlong>(index);
+    } catch (const std::exception& e) {
+        LOGE("IVF-PQ index creation failed: %s", e.what());
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeLoad(
+    JNIEnv* env, jclass clazz, jstring path) {
+
+    try {
+        return reinterpret_cast<jlong>(IvfPqIndex::load(toUtf8(env, path)).release());
+    } catch (const std::exception& e) {
+        LOGW("IVF-PQ index load failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeSave(
+    JNIEnv* env, jobject thiz, jlong handle, jstring path) {
+
+    try {
+        toIvfPqIndex(handle)->save(toUtf8(env, path));
+    } catch (const std::exception& e) {
+        LOGE("IVF-PQ index save failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeTrainFromFile(
+    JNIEnv* env, jobject thiz, jlong handle, jlong file_handle, jint max_samples, jint iterations, jint threads) {
+
+    try {
+        toVectorFile(file_handle)->trainIndex(*toIvfPqIndex(handle), static_cast<size_t>(max_samples), iterations,
+                                              threads);
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+    } catch (const std::exception& e) {
+        LOGE("IVF-PQ training failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeAddFromFile(
+    JNIEnv* env, jobject thiz, jlong handle, jlong file_handle, jintArray rows) {
+
+    std::vector<uint32_t> rowData(env->GetArrayLength(rows));
+    env->GetIntArrayRegion(rows, 0, static_cast<jsize>(rowData.size()), reinterpret_cast<jint*>(rowData.data()));
+    try {
+        toVectorFile(file_handle)->addToIndex(*toIvfPqIndex(handle), rowData);
+    } catch (const std::exception& e) {
+        LOGE("IVF-PQ add from vector store failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeSyncWithFile(
+    JNIEnv* env, jobject thiz, jlong handle, jlong file_handle) {
+
+    // Drop labels the store no longer has and encode live rows the index is missing,
+    // e.g. after loading a saved index that predates the last writes
+    IvfPqIndex* index = toIvfPqIndex(handle);
+    VectorFile* file = toVectorFile(file_handle);
+    try {
+        const std::vector<uint32_t> live = file->liveRows();
+        std::vector<int32_t> indexed = index->labels();
+        std::sort(indexed.begin(), indexed.end());
+
+        for (int32_t label : indexed) {
+            if (!std::binary_search(live.begin(), live.end(), static_cast<uint32_t>(label))) {
+                index->remove(label);
+            }
+        }
+        std::vector<uint32_t> missing;
+        for (uint32_t row : live) {
+            if (!std::binary_search(indexed.begin(), indexed.end(), static_cast<int32_t>(row))) {
+                missing.push_back(row);
+            }
+        }
+        file->addToIndex(*index, missing);
+    } catch (const std::exception& e) {
+        LOGE("IVF-PQ sync failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeRelabel(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray mapping) {
+
+    std::vector<int32_t> mappingData(env->GetArrayLength(mapping));
+    env->GetIntArrayRegion(mapping, 0, static_cast<jsize>(mappingData.size()),
+                           reinterpret_cast<jint*>(mappingData.data()));
+    toIvfPqIndex(handle)->relabel(mappingData);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeRemove(
+    JNIEnv* env, jobject thiz, jlong handle, jint label) {
+
+    return toIvfPqIndex(handle)->remove(label) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeSearch(
+    JNIEnv* env, jobject thiz, jlong handle, jlong file_handle, jfloatArray query, jint k, jint nprobe,
+    jint candidates, jlong filter_handle, jintArray out_labels, jfloatArray out_scores) {
+
+    // ADC shortlist of `candidates` rows, rescored exactly against the store
+    IvfPqIndex* index = toIvfPqIndex(handle);
+    VectorFile* file = toVectorFile(file_handle);
+    if (env->GetArrayLength(query) != index->dimension()) {
+        throwException(env, "java/lang/IllegalArgumentException", "Query dimension mismatch");
+        return 0;
+    }
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+
+    std::vector<float> queryData(index->dimension());
+    env->GetFloatArrayRegion(query, 0, index->dimension(), queryData.data());
+
+    try {
+        std::vector<uint32_t> rows;
+        for (const SearchHit& hit : index->search(queryData.data(), std::max(k, candidates), nprobe,
+                                                           toRowBitmap(filter_handle))) {
+            rows.push_back(static_cast<uint32_t>(hit.label));
+        }
+        return writeHits(env, file->rescore(queryData.data(), std::move(rows), std::min(k, capacity)), out_labels,
+                         out_scores);
+    } catch (const std::exception& e) {
+        LOGE("IVF-PQ search failed: %s", e.what());
+        throwException(env, "java/lang/RuntimeException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeSize(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toIvfPqIndex(handle)->size());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeTrainedOn(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toIvfPqIndex(handle)->trainedOn());
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_IvfPqIndex_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toIvfPqIndex(handle);
+}
+
+// ============================================================================
+// Memory-mapped vector store
+// ============================================================================
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeOpen(
+    JNIEnv* env, jclass clazz, jstring directory, jint dimension, jstring fingerprint, jboolean reset_on_mismatch,
+    jint quantization) {
+
+    // quantization: VectorQuantization ordinal, or -1 to keep what the store has
+    std::optional<iris::rag::Quantization> codes;
+    if (quantization >= 0) {
+        codes = static_cast<iris::rag::Quantization>(quantization);
+    }
+    try {
+        auto file = VectorFile::open(toUtf8(env, directory), dimension, toUtf8(env, fingerprint),
+                                     reset_on_mismatch == JNI_TRUE, codes);
+        return reinterpret_cast<jlong>(file.release());
+    } catch (const iris::rag::VectorFileMismatch& e) {
+        throwException(env, "java/lang/IllegalStateException", e.what());
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+    } catch (const std::exception& e) {
+        LOGE("Vector store open failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+    }
+    return 0;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeDimension(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return toVectorFile(handle)->dimension();
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeQuantization(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toVectorFile(handle)->quantization());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeLiveCount(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toVectorFile(handle)->liveCount());
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeRowCount(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toVectorFile(handle)->rowCount());
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeAppend(
+    JNIEnv* env, jobject thiz, jlong handle, jobjectArray ids, jobjectArray document_ids,
+    jobjectArray contents, jobjectArray metadata, jintArray starts, jintArray ends, jfloatArray vectors) {
+
+    VectorFile* file = toVectorFile(handle);
+    const jsize count = env->GetArrayLength(ids);
+    if (static_cast<jlong>(env->GetArrayLength(vectors)) != static_cast<jlong>(count) * file->dimension()) {
+        throwException(env, "java/lang/IllegalArgumentException", "Vector data does not match chunk count");
+        return nullptr;
+    }
+
+    std::vector<ChunkRecord> records(static_cast<size_t>(count));
+    std::vector<jint> startData(count), endData(count);
+    env->GetIntArrayRegion(starts, 0, count, startData.data());
+    env->GetIntArrayRegion(ends, 0, count, endData.data());
+    for (jsize i = 0; i < count; i++) {
+        records[i].id = stringAt(env, ids, i);
+        records[i].documentId = stringAt(env, document_ids, i);
+        records[i].content = stringAt(env, contents, i);
+        records[i].metadata = stringAt(env, metadata, i);
+        records[i].startIndex = startData[i];
+        records[i].endIndex = endData[i];
+    }
+
+    std::vector<float> vectorData(static_cast<size_t>(count) * file->dimension());
+    env->GetFloatArrayRegion(vectors, 0, static_cast<jsize>(vectorData.size()), vectorData.data());
+
+    try {
+        const std::vector<uint32_t> rows = file->append(records, vectorData.data());
+        jintArray result = env->NewIntArray(count);
+        env->SetIntArrayRegion(result, 0, count, reinterpret_cast<const jint*>(rows.data()));
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Vector store append failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeMarkDeleted(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray rows) {
+
+    std::vector<uint32_t> rowData(env->GetArrayLength(rows));
+    env->GetIntArrayRegion(rows, 0, static_cast<jsize>(rowData.size()), reinterpret_cast<jint*>(rowData.data()));
+    try {
+        toVectorFile(handle)->markDeleted(rowData);
+    } catch (const std::exception& e) {
+        LOGE("Vector store delete failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+    }
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeDocumentRows(
+    JNIEnv* env, jobject thiz, jlong handle, jstring document_id) {
+
+    const std::vector<uint32_t> rows = toVectorFile(handle)->documentRows(toUtf8(env, document_id));
+    jintArray result = env->NewIntArray(static_cast<jsize>(rows.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(rows.size()), reinterpret_cast<const jint*>(rows.data()));
+    return result;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeDeleteDocument(
+    JNIEnv* env, jobject thiz, jlong handle, jstring document_id) {
+
+    try {
+        const std::vector<uint32_t> rows = toVectorFile(handle)->deleteDocument(toUtf8(env, document_id));
+        jintArray result = env->NewIntArray(static_cast<jsize>(rows.size()));
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(rows.size()),
+                               reinterpret_cast<const jint*>(rows.data()));
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Vector store document delete failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeMatchContent(
+    JNIEnv* env, jobject thiz, jlong handle, jstring document_id, jobjectArray contents) {
+
+    const jsize count = env->GetArrayLength(contents);
+    std::vector<std::string> contentData(static_cast<size_t>(count));
+    for (jsize i = 0; i < count; i++) {
+        contentData[i] = stringAt(env, contents, i);
+    }
+    const std::vector<int32_t> rows = toVectorFile(handle)->matchContent(toUtf8(env, document_id), contentData);
+    jintArray result = env->NewIntArray(count);
+    env->SetIntArrayRegion(result, 0, count, reinterpret_cast<const jint*>(rows.data()));
+    return result;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeCompactInto(
+    JNIEnv* env, jobject thiz, jlong handle, jstring directory, jlongArray out_handle) {
+
+    // Returns the row map; the compacted store's handle goes to out_handle[0]
+    try {
+        std::vector<int32_t> rowMap;
+        auto compacted = toVectorFile(handle)->compactInto(toUtf8(env, directory), rowMap);
+        jintArray result = env->NewIntArray(static_cast<jsize>(rowMap.size()));
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(rowMap.size()),
+                               reinterpret_cast<const jint*>(rowMap.data()));
+        const jlong compactedHandle = reinterpret_cast<jlong>(compacted.release());
+        env->SetLongArrayRegion(out_handle, 0, 1, &compactedHandle);
+        return result;
+    } catch (const std::invalid_argument& e) {
+        throwException(env, "java/lang/IllegalArgumentException", e.what());
+    } catch (const std::exception& e) {
+        LOGE("Vector store compaction failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+    }
+    return nullptr;
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeSyncCompacted(
+    JNIEnv* env, jobject thiz, jlong handle, jlong target_handle, jintArray row_map) {
+
+    std::vector<int32_t> rowMap(env->GetArrayLength(row_map));
+    env->GetIntArrayRegion(row_map, 0, static_cast<jsize>(rowMap.size()), reinterpret_cast<jint*>(rowMap.data()));
+    try {
+        toVectorFile(handle)->syncCompacted(*toVectorFile(target_handle), rowMap);
+        jintArray result = env->NewIntArray(static_cast<jsize>(rowMap.size()));
+        env->SetIntArrayRegion(result, 0, static_cast<jsize>(rowMap.size()),
+                               reinterpret_cast<const jint*>(rowMap.data()));
+        return result;
+    } catch (const std::exception& e) {
+        LOGE("Vector store compaction sync failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeCheckpoint(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    try {
+        toVectorFile(handle)->checkpoint();
+    } catch (const std::exception& e) {
+        LOGE("Vector store checkpoint failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+    }
+}
+
+JNIEXPORT jintArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeLiveRows(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    const std::vector<uint32_t> rows = toVectorFile(handle)->liveRows();
+    jintArray result = env->NewIntArray(static_cast<jsize>(rows.size()));
+    env->SetIntArrayRegion(result, 0, static_cast<jsize>(rows.size()), reinterpret_cast<const jint*>(rows.data()));
+    return result;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeKeys(
+    JNIEnv* env, jobject thiz, jlong handle, jintArray rows) {
+
+    // Chunk and document IDs interleaved, for rebuilding the Kotlin lookup maps
+    VectorFile* file = toVectorFile(handle);
+    const jsize count = env->GetArrayLength(rows);
+    std::vector<jint> rowData(count);
+    env->GetIntArrayRegion(rows, 0, count, rowData.data());
+
+    jobjectArray result = env->NewObjectArray(count * 2, env->FindClass("java/lang/String"), nullptr);
+    try {
+        for (jsize i = 0; i < count; i++) {
+            jstring id = fromUtf8(env, file->readChunkId(static_cast<uint32_t>(rowData[i])));
+            jstring documentId = fromUtf8(env, file->readDocumentId(static_cast<uint32_t>(rowData[i])));
+            env->SetObjectArrayElement(result, i * 2, id);
+            env->SetObjectArrayElement(result, i * 2 + 1, documentId);
+            env->DeleteLocalRef(id);
+            env->DeleteLocalRef(documentId);
+        }
+    } catch (const std::exception& e) {
+        throwException(env, "java/lang/IndexOutOfBoundsException", e.what());
+        return nullptr;
+    }
+    return result;
+}
+
+JNIEXPORT jobjectArray JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeReadRecord(
+    JNIEnv* env, jobject thiz, jlong handle, jint row, jintArray out_span, jfloatArray out_vector) {
+
+    // Returns [id, documentId, content, metadata]; span and vector go to the out arrays
+    VectorFile* file = toVectorFile(handle);
+    try {
+        const ChunkRecord record = file->readRecord(static_cast<uint32_t>(row));
+        std::vector<float> vector(file->dimension());
+        file->readVector(static_cast<uint32_t>(row), vector.data());
+
+        const jint span[2] = {record.startIndex, record.endIndex};
+        env->SetIntArrayRegion(out_span, 0, 2, span);
+        env->SetFloatArrayRegion(out_vector, 0, file->dimension(), vector.data());
+
+        jobjectArray result = env->NewObjectArray(4, env->FindClass("java/lang/String"), nullptr);
+        const std::string* fields[] = {&record.id, &record.documentId, &record.content, &record.metadata};
+        for (jsize i = 0; i < 4; i++) {
+            jstring value = fromUtf8(env, *fields[i]);
+            env->SetObjectArrayElement(result, i, value);
+            env->DeleteLocalRef(value);
+        }
+        return result;
+    } catch (const std::exception& e) {
+        throwException(env, "java/lang/IndexOutOfBoundsException", e.what());
+        return nullptr;
+    }
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeExactSearch(
+    JNIEnv* env, jobject thiz, jlong handle, jfloatArray query, jint k, jlong filter_handle, jfloat threshold,
+    jintArray out_labels, jfloatArray out_scores) {
+
+    VectorFile* file = toVectorFile(handle);
+    if (env->GetArrayLength(query) != file->dimension()) {
+        throwException(env, "java/lang/IllegalArgumentException", "Query dimension mismatch");
+        return 0;
+    }
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+
+    std::vector<float> queryData(file->dimension());
+    env->GetFloatArrayRegion(query, 0, file->dimension(), queryData.data());
+    return writeHits(env,
+                     file->exactSearch(queryData.data(), std::min(k, capacity), toRowBitmap(filter_handle), threshold),
+                     out_labels, out_scores);
+}
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeSearch(
+    JNIEnv* env, jobject thiz, jlong handle, jfloatArray query, jint k, jint candidates, jlong filter_handle,
+    jintArray out_labels, jfloatArray out_scores) {
+
+    VectorFile* file = toVectorFile(handle);
+    if (env->GetArrayLength(query) != file->dimension()) {
+        throwException(env, "java/lang/IllegalArgumentException", "Query dimension mismatch");
+        return 0;
+    }
+    const jint capacity = std::min(env->GetArrayLength(out_labels), env->GetArrayLength(out_scores));
+
+    std::vector<float> queryData(file->dimension());
+    env->GetFloatArrayRegion(query, 0, file->dimension(), queryData.data());
+    return writeHits(env, file->search(queryData.data(), std::min(k, capacity), candidates, toRowBitmap(filter_handle)),
+                     out_labels, out_scores);
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeFilterRows(
+    JNIEnv* env, jobject thiz, jlong handle, jobjectArray document_ids, jobjectArray tags,
+    jlong modified_from, jlong modified_to) {
+
+    // Live rows matching every given criterion, as a RowBitmap handle the caller frees
+    RowFilter filter;
+    for (jsize i = 0; i < env->GetArrayLength(document_ids); i++) {
+        filter.documentIds.push_back(stringAt(env, document_ids, i));
+    }
+    for (jsize i = 0; i < env->GetArrayLength(tags); i++) {
+        filter.tags.push_back(stringAt(env, tags, i));
+    }
+    filter.modifiedFrom = modified_from;
+    filter.modifiedTo = modified_to;
+    try {
+        return reinterpret_cast<jlong>(new RowBitmap(toVectorFile(handle)->filterRows(filter)));
+    } catch (const std::exception& e) {
+        LOGE("Vector store filter failed: %s", e.what());
+        throwException(env, "java/io/IOException", e.what());
+        return 0;
+    }
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_VectorFile_nativeClose(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toVectorFile(handle);
+}
+
+// ============================================================================
+// Row bitmap
+// ============================================================================
+
+JNIEXPORT jint JNICALL
+Java_com_nervesparks_iris_core_rag_RowBitmap_nativeCardinality(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    return static_cast<jint>(toRowBitmap(handle)->cardinality());
+}
+
+JNIEXPORT void JNICALL
+Java_com_nervesparks_iris_core_rag_RowBitmap_nativeFree(
+    JNIEnv* env, jobject thiz, jlong handle) {
+
+    delete toRowBitmap(handle);
+}
+
+} // extern "C"
@@ -0,0 +1,205 @@
+#include "near_duplicate_index.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "text_tokenizer.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+constexpr uint64_t kFnvOffset = 0xcbf29ce484222325ull;
+constexpr uint64_t kFnvPrime = 0x100000001b3ull;
+
+uint64_t fnv1a(uint64_t hash, std::string_view bytes) {
+    for (char c : bytes) {
+        hash = (hash ^ static_cast<uint8_t>(c)) * kFnvPrime;
+    }
+    return hash;
+}
+
+/**
+ * 64-bit finalizer (splitmix64), so FNV's weak low bits do not reach the permutations
+ */
+uint64_t mix64(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+} // namespace
+
+NearDuplicateIndex::NearDuplicateIndex(int bands, int rows, float threshold)
+    : bands_(bands), rows_(rows), threshold_(threshold) {
+    if (bands <= 0 || rows <= 0) {
+        throw std::invalid_argument("MinHash needs at least one band of one row");
+    }
+    // Fixed seed: signatures must not change between runs
+    std::mt19937 rng(0x51a7e5u);
+    const size_t functions = static_cast<size_t>(bands) * static_cast<size_t>(rows);
+    multipliers_.resize(functions);
+    offsets_.resize(functions);
+    for (size_t i = 0; i < functions; i++) {
+        multipliers_[i] = static_cast<uint32_t>(rng()) | 1u;
+        offsets_[i] = static_cast<uint32_t>(rng());
+    }
+}
+
+std::vector<uint32_t> NearDuplicateIndex::signature(std::string_view text) const {
+    const std::vector<std::string> tokens = tokenize(text);
+    if (tokens.empty()) {
+        return {};
+    }
+
+    // Shingle hashes; a text shorter than one shingle is a single shingle
+    const size_t shingles = tokens.size() >= kShingleWords ? tokens.size() - kShingleWords + 1 : 1;
+    std::vector<uint32_t> hashes(shingles);
+    for (size_t s = 0; s < shingles; s++) {
+        uint64_t hash = kFnvOffset;
+        for (size_t w = s; w < std::min(tokens.size(), s + kShingleWords); w++) {
+            hash = fnv1a(hash, tokens[w]);
+            hash = (hash ^ 0x1f) * kFnvPrime; // word separator
+        }
+        hash = mix64(hash);
+        hashes[s] = static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+    std::sort(hashes.begin(), hashes.end());
+    hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+
+    // h_i(x) = mix32(a_i * x + b_i); the inner loop over i is branch-free and vectorizes
+    const size_t functions = multipliers_.size();
+    std::vector<uint32_t> mins(functions, std::numeric_limits<uint32_t>::max());
+    const uint32_t* a = multipliers_.data();
+    const uint32_t* b = offsets_.data();
+    uint32_t* out = mins.data();
+    for (uint32_t x : hashes) {
+        for (size_t i = 0; i < functions; i++) {
+            uint32_t v = x * a[i] + b[i];
+            v ^= v >> 16;
+            v *= 0x7feb352du;
+            v ^= v >> 15;
+            out[i] = std::min(out[i], v);
+        }
+    }
+    return mins;
+}
+
+float NearDuplicateIndex::similarity(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    if (a.empty() || a.size() != b.size()) {
+        return 0.0f;
+    }
+    size_t same = 0;
+    for (size_t i = 0; i < a.size(); i++) {
+        same += a[i] == b[i];
+    }
+    return static_cast<float>(same) / static_cast<float>(a.size());
+}
+
+uint64_t NearDuplicateIndex::bandKey(const std::vector<uint32_t>& signature, int band) const {
+    uint64_t key = mix64(static_cast<uint64_t>(band) + 1);
+    for (int r = 0; r < rows_; r++) {
+        key = mix64(key ^ signature[static_cast<size_t>(band) * rows_ + r]);
+    }
+    return key;
+}
+
+int32_t NearDuplicateIndex::findLocked(const std::vector<uint32_t>& signature) const {
+    if (signature.size() != multipliers_.size()) {
+        return -1;
+    }
+    int32_t best = -1;
+    float bestSimilarity = threshold_;
+    std::vector<int32_t> seen;
+    for (int band = 0; band < bands_; band++) {
+        auto bucket = buckets_.find(bandKey(signature, band));
+        if (bucket == buckets_.end()) {
+            continue;
+        }
+        for (int32_t label : bucket->second) {
+            if (std::find(seen.begin(), seen.end(), label) != seen.end()) {
+                continue;
+            }
+            seen.push_back(label);
+            const float s = similarity(signature, signatures_.at(label));
+            if (s > bestSimilarity || (s == bestSimilarity && (best < 0 || label < best))) {
+                best = label;
+                bestSimilarity = s;
+            }
+        }
+    }
+    return best;
+}
+
+int32_t NearDuplicateIndex::find(const std::vector<uint32_t>& signature) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return findLocked(signature);
+}
+
+void NearDuplicateIndex::addLocked(int32_t label, const std::vector<uint32_t>& signature) {
+    removeLocked(label);
+    for (int band = 0; band < bands_; band++) {
+        buckets_[bandKey(signature, band)].push_back(label);
+    }
+    signatures_.emplace(label, signature);
+}
+
+int32_t NearDuplicateIndex::addOrMatch(int32_t label, std::string_view text) {
+    const std::vector<uint32_t> sig = signature(text);
+    if (sig.empty()) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const int32_t match = findLocked(sig);
+    if (match < 0) {
+        addLocked(label, sig);
+    }
+    return match;
+}
+
+void NearDuplicateIndex::add(int32_t label, const std::vector<uint32_t>& signature) {
+    if (signature.size() != multipliers_.size()) {
+        throw std::invalid_argument("Signature length does not match the index");
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    addLocked(label, signature);
+}
+
+bool NearDuplicateIndex::removeLocked(int32_t label) {
+    auto it = signatures_.find(label);
+    if (it == signatures_.end()) {
+        return false;
+    }
+    for (int band = 0; band < bands_; band++) {
+        auto bucket = buckets_.find(bandKey(it->second, band));
+        if (bucket == buckets_.end()) {
+            continue;
+        }
+        auto& labels = bucket->second;
+        labels.erase(std::remove(labels.begin(), labels.end(), label), labels.end());
+        if (labels.empty()) {
+            buckets_.erase(bucket);
+        }
+    }
+    signatures_.erase(it);
+    return true;
+}
+
+bool NearDuplicateIndex::remove(int32_t label) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return removeLocked(label);
+}
+
+size_t NearDuplicateIndex::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return signatures_.size();
+}
+
+} // namespace rag
+} // namespace iris
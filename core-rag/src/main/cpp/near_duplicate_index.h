@@ -0,0 +1,89 @@
+#ifndef IRIS_RAG_NEAR_DUPLICATE_INDEX_H
+#define IRIS_RAG_NEAR_DUPLICATE_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace iris {
+namespace rag {
+
+/**
+ * Finds texts that are nearly the same as one indexed before, by MinHash with
+ * LSH banding.
+ *
+ * A text is the set of its word shingles (kShingleWords consecutive tokenize()
+ * tokens). Its signature is the minimum of each of `bands * rows` hash
+ * functions over the shingles, so two signatures agree in a position with
+ * probability equal to the Jaccard similarity of the shingle sets. Signatures
+ * are split into `bands` groups of `rows`; texts sharing any whole band are
+ * candidates, and a candidate is a duplicate if the share of agreeing
+ * positions reaches `threshold`. With 16 bands of 8 rows a pair at Jaccard
+ * 0.8 becomes a candidate with probability 0.95, one at 0.5 with 0.06.
+ *
+ * The signature loop applies all hash functions to one shingle at a time over
+ * plain uint32 arrays, which the compiler vectorizes (NEON on arm64).
+ *
+ * Labels are chosen by the caller. Safe to call from several threads.
+ */
+class NearDuplicateIndex {
+public:
+    static constexpr size_t kShingleWords = 3;
+
+    NearDuplicateIndex(int bands = 16, int rows = 8, float threshold = 0.8f);
+
+    /**
+     * MinHash signature of `text`, bands * rows values; empty if it has no words
+     */
+    std::vector<uint32_t> signature(std::string_view text) const;
+
+    /**
+     * Estimated Jaccard similarity of two signatures
+     */
+    static float similarity(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b);
+
+    /**
+     * Label of the most similar indexed text at or above the threshold, or -1
+     */
+    int32_t find(const std::vector<uint32_t>& signature) const;
+
+    /**
+     * Index `text` under `label` unless it duplicates an indexed text
+     * @return The duplicated label (and `text` is not indexed), or -1
+     */
+    int32_t addOrMatch(int32_t label, std::string_view text);
+
+    /**
+     * Index a signature under `label`, replacing any previous one
+     */
+    void add(int32_t label, const std::vector<uint32_t>& signature);
+
+    bool remove(int32_t label);
+
+    size_t size() const;
+
+private:
+    // Caller holds mutex_
+    int32_t findLocked(const std::vector<uint32_t>& signature) const;
+    void addLocked(int32_t label, const std::vector<uint32_t>& signature);
+    bool removeLocked(int32_t label);
+    uint64_t bandKey(const std::vector<uint32_t>& signature, int band) const;
+
+    const int bands_;
+    const int rows_;
+    const float threshold_;
+    std::vector<uint32_t> multipliers_; // per hash function, odd
+    std::vector<uint32_t> offsets_;
+
+    mutable std::mutex mutex_;
+    std::unordered_map<int32_t, std::vector<uint32_t>> signatures_;
+    std::unordered_map<uint64_t, std::vector<int32_t>> buckets_; // band key -> labels
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_NEAR_DUPLICATE_INDEX_H
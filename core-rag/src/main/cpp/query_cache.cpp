@@ -0,0 +1,165 @@
+#include "query_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "text_tokenizer.h"
+#include "vector_kernels.h"
+
+namespace iris {
+namespace rag {
+
+QueryCache::QueryCache(size_t capacity, float minSimilarity)
+    : capacity_(std::max<size_t>(capacity, 1)), minSimilarity_(minSimilarity), entries_(capacity_) {}
+
+std::string QueryCache::normalize(std::string_view text) {
+    std::string key;
+    for (const std::string& token : tokenize(text)) {
+        if (!key.empty()) {
+            key += ' ';
+        }
+        key += token;
+    }
+    return key;
+}
+
+bool QueryCache::syncVersion(uint64_t version) {
+    if (version < version_) {
+        return false;
+    }
+    if (version > version_) {
+        stats_.invalidations += slots_.size();
+        dropAll();
+        version_ = version;
+    }
+    return true;
+}
+
+void QueryCache::dropAll() {
+    for (Entry& entry : entries_) {
+        entry = Entry();
+    }
+    slots_.clear();
+}
+
+int QueryCache::freeSlot() {
+    int oldest = 0;
+    for (size_t slot = 0; slot < capacity_; slot++) {
+        if (entries_[slot].lastUse == 0) {
+            return static_cast<int>(slot);
+        }
+        if (entries_[slot].lastUse < entries_[oldest].lastUse) {
+            oldest = static_cast<int>(slot);
+        }
+    }
+    slots_.erase(entries_[oldest].key);
+    entries_[oldest] = Entry();
+    stats_.evictions++;
+    return oldest;
+}
+
+int QueryCache::lookupExact(std::string_view text, uint64_t version, int k) {
+    const std::string key = normalize(text);
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.lookups++;
+    if (key.empty() || !syncVersion(version)) {
+        return -1;
+    }
+    auto it = slots_.find(key);
+    if (it == slots_.end() || entries_[it->second].k < k) {
+        return -1;
+    }
+    Entry& entry = entries_[it->second];
+    entry.lastUse = ++clock_;
+    stats_.exactHits++;
+    stats_.savedMs += entry.costMs;
+    return it->second;
+}
+
+int QueryCache::lookupSimilar(const float* embedding, size_t dim, uint64_t version, int k) {
+    std::vector<float> query(embedding, embedding + dim);
+    const float norm = std::sqrt(kernels::dotF32(query.data(), query.data(), dim));
+    if (norm == 0.0f) {
+        return -1;
+    }
+    for (float& value : query) {
+        value /= norm;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dim != dim_ || slots_.empty() || !syncVersion(version)) {
+        return -1;
+    }
+    std::vector<float> scores(capacity_);
+    kernels::dotBlockF32(query.data(), embeddings_.data(), capacity_, dim_, scores.data());
+    int best = -1;
+    for (size_t slot = 0; slot < capacity_; slot++) {
+        const Entry& entry = entries_[slot];
+        if (entry.lastUse != 0 && entry.hasEmbedding && entry.k >= k && scores[slot] >= minSimilarity_ &&
+            (best < 0 || scores[slot] > scores[best])) {
+            best = static_cast<int>(slot);
+        }
+    }
+    if (best >= 0) {
+        Entry& entry = entries_[best];
+        entry.lastUse = ++clock_;
+        stats_.semanticHits++;
+        stats_.savedMs += std::max(0.0, entry.costMs - entry.embedMs);
+    }
+    return best;
+}
+
+int QueryCache::put(std::string_view text, const float* embedding, size_t dim, uint64_t version, int k,
+                    double costMs, double embedMs) {
+    std::string key = normalize(text);
+    float norm = 0.0f;
+    if (embedding && dim > 0) {
+        norm = std::sqrt(kernels::dotF32(embedding, embedding, dim));
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (key.empty() || !syncVersion(version)) {
+        return -1;
+    }
+    auto it = slots_.find(key);
+    const int slot = it != slots_.end() ? it->second : freeSlot();
+    Entry& entry = entries_[slot];
+    entry.k = k;
+    entry.costMs = costMs;
+    entry.embedMs = embedMs;
+    entry.lastUse = ++clock_;
+    entry.hasEmbedding = norm > 0.0f;
+    if (entry.hasEmbedding) {
+        // A new embedding model: the stored embeddings cannot be compared with its queries
+        if (dim != dim_) {
+            for (Entry& other : entries_) {
+                other.hasEmbedding = false;
+            }
+            entry.hasEmbedding = true;
+            dim_ = dim;
+            embeddings_.assign(capacity_ * dim_, 0.0f);
+        }
+        float* row = embeddings_.data() + static_cast<size_t>(slot) * dim_;
+        for (size_t d = 0; d < dim_; d++) {
+            row[d] = embedding[d] / norm;
+        }
+    }
+    entry.key = key;
+    slots_[std::move(key)] = slot;
+    return slot;
+}
+
+void QueryCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    dropAll();
+}
+
+QueryCache::Stats QueryCache::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Stats stats = stats_;
+    stats.entries = static_cast<uint32_t>(slots_.size());
+    return stats;
+}
+
+} // namespace rag
+} // namespace iris
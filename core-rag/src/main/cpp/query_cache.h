@@ -0,0 +1,113 @@
+#ifndef IRIS_RAG_QUERY_CACHE_H
+#define IRIS_RAG_QUERY_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace iris {
+namespace rag {
+
+/**
+ * Two-tier cache of search results for repeated and near-identical queries.
+ *
+ * The first tier is keyed by the normalized query text (tokenize() output
+ * joined by spaces, so case, punctuation and spacing do not matter). The
+ * second matches query embeddings: the cached query with the highest cosine
+ * similarity to the new one is a hit if the similarity reaches
+ * `minSimilarity`. With a few hundred entries the embeddings are scanned with
+ * the block kernels, which is exact and takes tens of microseconds.
+ *
+ * The cache holds no results itself: each entry owns a slot in
+ * [0, capacity) and the caller keeps the results for that slot. Every lookup
+ * and put carries the index version the results depend on; a newer version
+ * empties the cache, and puts computed under an older one are dropped. The
+ * least recently used entry is evicted when the cache is full.
+ *
+ * Safe to call from several threads.
+ */
+class QueryCache {
+public:
+    struct Stats {
+        uint64_t lookups = 0;      // exact-tier lookups; one per query
+        uint64_t exactHits = 0;
+        uint64_t semanticHits = 0;
+        uint64_t invalidations = 0; // entries dropped by a version change
+        uint64_t evictions = 0;
+        uint32_t entries = 0;
+        double savedMs = 0.0;       // cost of the searches hits replaced
+    };
+
+    /**
+     * @param capacity Entries (and slots) kept
+     * @param minSimilarity Cosine similarity at which a cached query embedding matches
+     */
+    QueryCache(size_t capacity, float minSimilarity);
+
+    /**
+     * Normalized form of a query; empty if it has no words
+     */
+    static std::string normalize(std::string_view text);
+
+    /**
+     * Slot of the entry for this exact (normalized) query holding at least `k`
+     * results, or -1
+     */
+    int lookupExact(std::string_view text, uint64_t version, int k);
+
+    /**
+     * Slot of the entry whose query embedding is most similar to `embedding`,
+     * if it reaches minSimilarity and holds at least `k` results, or -1
+     */
+    int lookupSimilar(const float* embedding, size_t dim, uint64_t version, int k);
+
+    /**
+     * Add or replace the entry for `text`; `embedding` may be null. `costMs` is
+     * the time the search took, `embedMs` the part of it spent embedding the
+     * query, which a semantic hit does not save.
+     * @return The entry's slot, or -1 if `version` is already stale or the
+     *         query has no words
+     */
+    int put(std::string_view text, const float* embedding, size_t dim, uint64_t version, int k, double costMs,
+            double embedMs);
+
+    void clear();
+
+    Stats stats() const;
+
+private:
+    struct Entry {
+        std::string key;
+        int k = 0;
+        bool hasEmbedding = false;
+        double costMs = 0.0;
+        double embedMs = 0.0;
+        uint64_t lastUse = 0; // 0: slot is free
+    };
+
+    // Caller holds mutex_
+    bool syncVersion(uint64_t version);
+    void dropAll();
+    int freeSlot();
+
+    const size_t capacity_;
+    const float minSimilarity_;
+
+    mutable std::mutex mutex_;
+    uint64_t version_ = 0;
+    uint64_t clock_ = 0;
+    std::vector<Entry> entries_;
+    std::unordered_map<std::string, int> slots_;
+    size_t dim_ = 0;             // set by the first embedding
+    std::vector<float> embeddings_; // capacity_ x dim_, unit length
+    Stats stats_;
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_QUERY_CACHE_H
@@ -0,0 +1,28 @@
+#ifndef IRIS_RAG_LOG_H
+#define IRIS_RAG_LOG_H
+
+/**
+ * Logging macros shared by the native RAG sources.
+ * Each translation unit defines LOG_TAG before including this header.
+ * Host builds (benchmarks) log to stderr instead of logcat.
+ */
+#ifndef LOG_TAG
+#define LOG_TAG "IrisRag"
+#endif
+
+#ifdef __ANDROID__
+#include <android/log.h>
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#else
+#include <cstdio>
+#define IRIS_RAG_HOST_LOG(level, ...) \
+    do { std::fprintf(stderr, "%s/%s: ", level, LOG_TAG); \
+         std::fprintf(stderr, __VA_ARGS__); std::fputc('\n', stderr); } while (0)
+#define LOGI(...) IRIS_RAG_HOST_LOG("I", __VA_ARGS__)
+#define LOGW(...) IRIS_RAG_HOST_LOG("W", __VA_ARGS__)
+#define LOGE(...) IRIS_RAG_HOST_LOG("E", __VA_ARGS__)
+#endif
+
+#endif // IRIS_RAG_LOG_H
@@ -0,0 +1,52 @@
+#include "rank_fusion.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace iris {
+namespace rag {
+
+std::vector<SearchHit> reciprocalRankFusion(const std::vector<std::vector<int32_t>>& rankings, size_t limit,
+                                            float k0) {
+    struct Fused {
+        float score;
+        size_t firstSeen;
+    };
+    std::unordered_map<int32_t, Fused> fused;
+    std::vector<int32_t> labels;
+    size_t seen = 0;
+    for (const std::vector<int32_t>& ranking : rankings) {
+        std::unordered_set<int32_t> counted;
+        for (size_t rank = 0; rank < ranking.size(); rank++) {
+            const int32_t label = ranking[rank];
+            if (!counted.insert(label).second) {
+                continue;
+            }
+            const float contribution = 1.0f / (k0 + static_cast<float>(rank + 1));
+            auto inserted = fused.emplace(label, Fused{contribution, seen++});
+            if (inserted.second) {
+                labels.push_back(label);
+            } else {
+                inserted.first->second.score += contribution;
+            }
+        }
+    }
+
+    const size_t keep = std::min(limit, labels.size());
+    std::partial_sort(labels.begin(), labels.begin() + keep, labels.end(), [&](int32_t a, int32_t b) {
+        const Fused& fa = fused.at(a);
+        const Fused& fb = fused.at(b);
+        return fa.score != fb.score ? fa.score > fb.score : fa.firstSeen < fb.firstSeen;
+    });
+
+    std::vector<SearchHit> hits;
+    hits.reserve(keep);
+    for (size_t i = 0; i < keep; i++) {
+        hits.push_back({labels[i], fused.at(labels[i]).score});
+    }
+    return hits;
+}
+
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,31 @@
+#ifndef IRIS_RAG_RANK_FUSION_H
+#define IRIS_RAG_RANK_FUSION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "hnsw_index.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Reciprocal-rank fusion of several rankings of the same label space.
+ *
+ * A label scores sum(1 / (k0 + rank)) over the rankings it appears in, with
+ * ranks counted from 1, so agreement between retrievers outweighs a high rank
+ * in any single one and raw scores on different scales never need calibrating.
+ * Ties are broken by first appearance across the rankings.
+ *
+ * @param rankings Labels best-first; duplicates within a ranking count once
+ * @param limit Number of fused hits returned
+ * @param k0 Rank offset; larger values flatten the contribution of top ranks
+ */
+std::vector<SearchHit> reciprocalRankFusion(const std::vector<std::vector<int32_t>>& rankings, size_t limit,
+                                            float k0 = 60.0f);
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_RANK_FUSION_H
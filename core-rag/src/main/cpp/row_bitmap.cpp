@@ -0,0 +1,313 @@
+#include "row_bitmap.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+inline uint16_t highBits(uint32_t row) { return static_cast<uint16_t>(row >> 16); }
+inline uint16_t lowBits(uint32_t row) { return static_cast<uint16_t>(row & 0xFFFF); }
+
+uint32_t popcount(const std::vector<uint64_t>& words) {
+    uint32_t count = 0;
+    for (uint64_t word : words) {
+        count += static_cast<uint32_t>(__builtin_popcountll(word));
+    }
+    return count;
+}
+
+} // namespace
+
+// ============================================================================
+// Containers
+// ============================================================================
+
+bool RowBitmap::Container::contains(uint16_t low) const {
+    if (isBitmap()) {
+        return (bits[low >> 6] >> (low & 63)) & 1;
+    }
+    return std::binary_search(array.begin(), array.end(), low);
+}
+
+void RowBitmap::Container::add(uint16_t low) {
+    if (isBitmap()) {
+        uint64_t& word = bits[low >> 6];
+        const uint64_t mask = uint64_t{1} << (low & 63);
+        if (!(word & mask)) {
+            word |= mask;
+            cardinality++;
+        }
+        return;
+    }
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) {
+        return;
+    }
+    array.insert(it, low);
+    cardinality++;
+    if (cardinality > kArrayMax) {
+        toBitmap();
+    }
+}
+
+void RowBitmap::Container::remove(uint16_t low) {
+    if (isBitmap()) {
+        uint64_t& word = bits[low >> 6];
+        const uint64_t mask = uint64_t{1} << (low & 63);
+        if (word & mask) {
+            word &= ~mask;
+            cardinality--;
+            if (cardinality <= kArrayMax) {
+                toArray();
+            }
+        }
+        return;
+    }
+    auto it = std::lower_bound(array.begin(), array.end(), low);
+    if (it != array.end() && *it == low) {
+        array.erase(it);
+        cardinality--;
+    }
+}
+
+void RowBitmap::Container::toBitmap() {
+    bits.assign(kBitmapWords, 0);
+    for (uint16_t low : array) {
+        bits[low >> 6] |= uint64_t{1} << (low & 63);
+    }
+    array.clear();
+    array.shrink_to_fit();
+}
+
+void RowBitmap::Container::toArray() {
+    array.clear();
+    array.reserve(cardinality);
+    for (size_t w = 0; w < bits.size(); w++) {
+        for (uint64_t word = bits[w]; word; word &= word - 1) {
+            array.push_back(static_cast<uint16_t>(w * 64 + __builtin_ctzll(word)));
+        }
+    }
+    bits.clear();
+    bits.shrink_to_fit();
+}
+
+RowBitmap::Container RowBitmap::unite(const Container& a, const Container& b) {
+    Container out;
+    out.key = a.key;
+    if (a.isBitmap() || b.isBitmap() || a.cardinality + b.cardinality > kArrayMax) {
+        out.bits.assign(kBitmapWords, 0);
+        for (const Container* c : {&a, &b}) {
+            if (c->isBitmap()) {
+                for (size_t w = 0; w < kBitmapWords; w++) out.bits[w] |= c->bits[w];
+            } else {
+                for (uint16_t low : c->array) out.bits[low >> 6] |= uint64_t{1} << (low & 63);
+            }
+        }
+        out.cardinality = popcount(out.bits);
+        if (out.cardinality <= kArrayMax) {
+            out.toArray();
+        }
+        return out;
+    }
+    out.array.reserve(a.cardinality + b.cardinality);
+    std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(), std::back_inserter(out.array));
+    out.cardinality = static_cast<uint32_t>(out.array.size());
+    return out;
+}
+
+RowBitmap::Container RowBitmap::intersect(const Container& a, const Container& b) {
+    Container out;
+    out.key = a.key;
+    if (a.isBitmap() && b.isBitmap()) {
+        out.bits.resize(kBitmapWords);
+        for (size_t w = 0; w < kBitmapWords; w++) out.bits[w] = a.bits[w] & b.bits[w];
+        out.cardinality = popcount(out.bits);
+        if (out.cardinality <= kArrayMax) {
+            out.toArray();
+        }
+        return out;
+    }
+    if (a.isBitmap() || b.isBitmap()) {
+        // Probe the bitmap with the array's entries
+        const Container& array = a.isBitmap() ? b : a;
+        const Container& bitmap = a.isBitmap() ? a : b;
+        for (uint16_t low : array.array) {
+            if (bitmap.contains(low)) out.array.push_back(low);
+        }
+    } else {
+        std::set_intersection(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                              std::back_inserter(out.array));
+    }
+    out.cardinality = static_cast<uint32_t>(out.array.size());
+    return out;
+}
+
+// ============================================================================
+// Bitmap
+// ============================================================================
+
+RowBitmap RowBitmap::fromSorted(const std::vector<uint32_t>& rows) {
+    RowBitmap bitmap;
+    for (size_t i = 0; i < rows.size();) {
+        Container container;
+        container.key = highBits(rows[i]);
+        size_t end = i;
+        while (end < rows.size() && highBits(rows[end]) == container.key) end++;
+        container.array.reserve(end - i);
+        for (; i < end; i++) {
+            if (container.array.empty() || container.array.back() != lowBits(rows[i])) {
+                container.array.push_back(lowBits(rows[i]));
+            }
+        }
+        container.cardinality = static_cast<uint32_t>(container.array.size());
+        if (container.cardinality > kArrayMax) {
+            container.toBitmap();
+        }
+        bitmap.containers_.push_back(std::move(container));
+    }
+    return bitmap;
+}
+
+RowBitmap::Container* RowBitmap::find(uint16_t key) {
+    auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                               [](const Container& c, uint16_t k) { return c.key < k; });
+    return it != containers_.end() && it->key == key ? &*it : nullptr;
+}
+
+const RowBitmap::Container* RowBitmap::find(uint16_t key) const {
+    return const_cast<RowBitmap*>(this)->find(key);
+}
+
+void RowBitmap::add(uint32_t row) {
+    const uint16_t key = highBits(row);
+    // Rows are mostly appended in order, so the last container is the usual target
+    if (containers_.empty() || containers_.back().key < key) {
+        containers_.emplace_back();
+        containers_.back().key = key;
+        containers_.back().add(lowBits(row));
+        return;
+    }
+    Container* container = find(key);
+    if (!container) {
+        auto it = std::lower_bound(containers_.begin(), containers_.end(), key,
+                                   [](const Container& c, uint16_t k) { return c.key < k; });
+        container = &*containers_.emplace(it);
+        container->key = key;
+    }
+    container->add(lowBits(row));
+}
+
+void RowBitmap::remove(uint32_t row) {
+    Container* container = find(highBits(row));
+    if (!container) {
+        return;
+    }
+    container->remove(lowBits(row));
+    if (container->cardinality == 0) {
+        containers_.erase(containers_.begin() + (container - containers_.data()));
+    }
+}
+
+bool RowBitmap::contains(uint32_t row) const {
+    const Container* container = find(highBits(row));
+    return container && container->contains(lowBits(row));
+}
+
+size_t RowBitmap::cardinality() const {
+    size_t count = 0;
+    for (const Container& container : containers_) {
+        count += container.cardinality;
+    }
+    return count;
+}
+
+RowBitmap& RowBitmap::operator|=(const RowBitmap& other) {
+    std::vector<Container> merged;
+    merged.reserve(containers_.size() + other.containers_.size());
+    size_t i = 0, j = 0;
+    while (i < containers_.size() || j < other.containers_.size()) {
+        if (j == other.containers_.size() || (i < containers_.size() && containers_[i].key < other.containers_[j].key)) {
+            merged.push_back(std::move(containers_[i++]));
+        } else if (i == containers_.size() || other.containers_[j].key < containers_[i].key) {
+            merged.push_back(other.containers_[j++]);
+        } else {
+            merged.push_back(unite(containers_[i++], other.containers_[j++]));
+        }
+    }
+    containers_ = std::move(merged);
+    return *this;
+}
+
+RowBitmap& RowBitmap::operator&=(const RowBitmap& other) {
+    std::vector<Container> kept;
+    size_t i = 0, j = 0;
+    while (i < containers_.size() && j < other.containers_.size()) {
+        if (containers_[i].key < other.containers_[j].key) {
+            i++;
+        } else if (other.containers_[j].key < containers_[i].key) {
+            j++;
+        } else {
+            Container both = intersect(containers_[i++], other.containers_[j++]);
+            if (both.cardinality > 0) {
+                kept.push_back(std::move(both));
+            }
+        }
+    }
+    containers_ = std::move(kept);
+    return *this;
+}
+
+std::vector<uint32_t> RowBitmap::rows() const {
+    std::vector<uint32_t> out;
+    out.reserve(cardinality());
+    for (const Container& container : containers_) {
+        const uint32_t base = static_cast<uint32_t>(container.key) << 16;
+        if (container.isBitmap()) {
+            for (size_t w = 0; w < kBitmapWords; w++) {
+                for (uint64_t word = container.bits[w]; word; word &= word - 1) {
+                    out.push_back(base + static_cast<uint32_t>(w * 64 + __builtin_ctzll(word)));
+                }
+            }
+        } else {
+            for (uint16_t low : container.array) out.push_back(base + low);
+        }
+    }
+    return out;
+}
+
+void RowBitmap::toDense(uint32_t rowCount, std::vector<uint64_t>& words) const {
+    words.assign((static_cast<size_t>(rowCount) + 63) / 64, 0);
+    for (const Container& container : containers_) {
+        const size_t baseWord = (static_cast<size_t>(container.key) << 16) / 64;
+        if (baseWord >= words.size()) {
+            break;
+        }
+        if (container.isBitmap()) {
+            const size_t count = std::min(kBitmapWords, words.size() - baseWord);
+            std::copy(container.bits.begin(), container.bits.begin() + count, words.begin() + baseWord);
+        } else {
+            for (uint16_t low : container.array) {
+                const size_t word = baseWord + (low >> 6);
+                if (word < words.size()) words[word] |= uint64_t{1} << (low & 63);
+            }
+        }
+    }
+    // Rows at or past rowCount in the last word
+    if (rowCount % 64 != 0 && !words.empty()) {
+        words.back() &= (uint64_t{1} << (rowCount % 64)) - 1;
+    }
+}
+
+size_t RowBitmap::memoryBytes() const {
+    size_t bytes = containers_.capacity() * sizeof(Container);
+    for (const Container& container : containers_) {
+        bytes += container.array.capacity() * sizeof(uint16_t) + container.bits.capacity() * sizeof(uint64_t);
+    }
+    return bytes;
+}
+
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,81 @@
+#ifndef IRIS_RAG_ROW_BITMAP_H
+#define IRIS_RAG_ROW_BITMAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace iris {
+namespace rag {
+
+/**
+ * Compressed set of row numbers, laid out like a roaring bitmap.
+ *
+ * Rows are split by their high 16 bits into containers of up to 65536 rows.
+ * A container holds a sorted array of low halves while it has at most 4096
+ * rows (2 bytes per row), and a 65536-bit bitmap (8 KB) beyond that, so both
+ * sparse and dense sets stay small and intersect quickly.
+ *
+ * Not thread-safe; owners guard it like any other container.
+ */
+class RowBitmap {
+public:
+    RowBitmap() = default;
+
+    /**
+     * @param rows Ascending row numbers
+     */
+    static RowBitmap fromSorted(const std::vector<uint32_t>& rows);
+
+    void add(uint32_t row);
+    void remove(uint32_t row);
+    bool contains(uint32_t row) const;
+
+    size_t cardinality() const;
+    bool empty() const { return containers_.empty(); }
+
+    RowBitmap& operator|=(const RowBitmap& other);
+    RowBitmap& operator&=(const RowBitmap& other);
+
+    /**
+     * Rows in ascending order
+     */
+    std::vector<uint32_t> rows() const;
+
+    /**
+     * Expand into one bit per row below `rowCount`, for branch-light membership tests in scans
+     */
+    void toDense(uint32_t rowCount, std::vector<uint64_t>& words) const;
+
+    size_t memoryBytes() const;
+
+private:
+    static constexpr uint32_t kArrayMax = 4096;
+    static constexpr size_t kBitmapWords = 65536 / 64;
+
+    struct Container {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> array; // sorted low halves while cardinality <= kArrayMax
+        std::vector<uint64_t> bits;  // kBitmapWords words otherwise
+
+        bool isBitmap() const { return !bits.empty(); }
+        bool contains(uint16_t low) const;
+        void add(uint16_t low);
+        void remove(uint16_t low);
+        void toBitmap();
+        void toArray();
+    };
+
+    std::vector<Container> containers_; // ascending by key
+
+    Container* find(uint16_t key);
+    const Container* find(uint16_t key) const;
+    static Container unite(const Container& a, const Container& b);
+    static Container intersect(const Container& a, const Container& b);
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_ROW_BITMAP_H
@@ -0,0 +1,173 @@
+#include "subword_tokenizer.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+
+#include "text_tokenizer.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+bool isWhitespace(char32_t cp) {
+    return cp <= 0x20 || cp == 0x7F || cp == 0x85 || cp == 0xA0 || (cp >= 0x2000 && cp <= 0x200B) ||
+           cp == 0x2028 || cp == 0x2029 || cp == 0x202F || cp == 0x205F || cp == 0x3000 || cp == 0xFEFF ||
+           cp == 0xFFFD;
+}
+
+bool isCharBoundary(std::string_view text, size_t at) {
+    return at == text.size() || (static_cast<uint8_t>(text[at]) & 0xC0) != 0x80;
+}
+
+} // namespace
+
+SubwordTokenizer::SubwordTokenizer() = default;
+
+std::unique_ptr<SubwordTokenizer> SubwordTokenizer::load(const std::string& vocabPath) {
+    std::ifstream in(vocabPath, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open vocabulary " + vocabPath);
+    }
+    auto tokenizer = std::make_unique<SubwordTokenizer>();
+    tokenizer->arena_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+
+    const std::string_view all(tokenizer->arena_);
+    bool cased = false;
+    int32_t id = 0;
+    size_t lineStart = 0;
+    while (lineStart < all.size()) {
+        size_t lineEnd = all.find('\n', lineStart);
+        if (lineEnd == std::string_view::npos) {
+            lineEnd = all.size();
+        }
+        std::string_view piece = all.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+        if (!piece.empty() && piece.back() == '\r') {
+            piece.remove_suffix(1);
+        }
+        if (piece.empty()) {
+            id++; // keep IDs aligned with line numbers
+            continue;
+        }
+        if (piece.size() > 2 && piece.substr(0, 2) == "##") {
+            piece.remove_prefix(2);
+            tokenizer->continuations_.emplace(piece, id);
+        } else {
+            tokenizer->pieces_.emplace(piece, id);
+            // Special tokens such as [CLS] say nothing about the casing of the vocabulary
+            if (piece.front() != '[') {
+                cased = cased || std::any_of(piece.begin(), piece.end(), [](char c) { return c >= 'A' && c <= 'Z'; });
+            }
+        }
+        tokenizer->maxPieceBytes_ = std::max(tokenizer->maxPieceBytes_, piece.size());
+        id++;
+    }
+    tokenizer->vocabularySize_ = tokenizer->pieces_.size() + tokenizer->continuations_.size();
+    if (tokenizer->vocabularySize_ == 0) {
+        throw std::runtime_error("Vocabulary " + vocabPath + " is empty");
+    }
+    tokenizer->lowercase_ = !cased;
+    return tokenizer;
+}
+
+void SubwordTokenizer::splitWord(std::string_view text, size_t begin, size_t end, size_t base,
+                                 std::vector<TextToken>& out) const {
+    const auto whole = [&]() {
+        out.push_back({static_cast<uint32_t>(base + begin), static_cast<uint32_t>(base + end), true});
+    };
+    if (vocabularySize_ == 0) {
+        whole();
+        return;
+    }
+
+    // Matching key plus, for each of its character boundaries, the offset in `text`
+    thread_local std::string folded;
+    thread_local std::vector<uint32_t> sourceAt;
+    std::string_view key;
+    size_t chars = 0;
+    if (lowercase_) {
+        folded.clear();
+        sourceAt.clear();
+        size_t i = begin;
+        while (i < end) {
+            sourceAt.resize(folded.size() + 1);
+            sourceAt[folded.size()] = static_cast<uint32_t>(i);
+            appendUtf8(folded, foldCase(decodeUtf8(text, i)));
+            chars++;
+        }
+        sourceAt.resize(folded.size() + 1);
+        sourceAt[folded.size()] = static_cast<uint32_t>(end);
+        key = folded;
+    } else {
+        key = text.substr(begin, end - begin);
+        for (size_t i = 0; i < key.size(); i++) {
+            chars += isCharBoundary(key, i);
+        }
+    }
+    if (chars > kMaxWordChars) {
+        whole();
+        return;
+    }
+    const auto toSource = [&](size_t at) { return lowercase_ ? sourceAt[at] : begin + at; };
+
+    const size_t first = out.size();
+    size_t pos = 0;
+    while (pos < key.size()) {
+        const auto& table = pos == 0 ? pieces_ : continuations_;
+        size_t length = std::min(maxPieceBytes_, key.size() - pos);
+        for (; length > 0; length--) {
+            if (isCharBoundary(key, pos + length) && table.count(key.substr(pos, length))) {
+                break;
+            }
+        }
+        if (length == 0) {
+            out.resize(first); // the model sees one unknown token for the whole word
+            whole();
+            return;
+        }
+        out.push_back({static_cast<uint32_t>(base + toSource(pos)), static_cast<uint32_t>(base + toSource(pos + length)),
+                       pos == 0});
+        pos += length;
+    }
+}
+
+void SubwordTokenizer::tokenize(std::string_view text, size_t base, std::vector<TextToken>& out) const {
+    constexpr size_t kNone = static_cast<size_t>(-1);
+    size_t wordBegin = kNone;
+    size_t i = 0;
+    const auto flush = [&](size_t wordEnd) {
+        if (wordBegin != kNone) {
+            splitWord(text, wordBegin, wordEnd, base, out);
+            wordBegin = kNone;
+        }
+    };
+    while (i < text.size()) {
+        const size_t start = i;
+        const char32_t cp = decodeUtf8(text, i);
+        const CharClass cls = classify(cp);
+        if (cls == CharClass::kWord) {
+            if (wordBegin == kNone) {
+                wordBegin = start;
+            }
+            continue;
+        }
+        flush(start);
+        if (!isWhitespace(cp)) {
+            // Punctuation, symbols and ideographs stand alone
+            out.push_back({static_cast<uint32_t>(base + start), static_cast<uint32_t>(base + i), true});
+        }
+    }
+    flush(text.size());
+}
+
+size_t SubwordTokenizer::countTokens(std::string_view text) const {
+    std::vector<TextToken> tokens;
+    tokenize(text, 0, tokens);
+    return tokens.size();
+}
+
+} // namespace rag
+} // namespace iris
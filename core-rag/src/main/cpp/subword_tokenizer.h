@@ -0,0 +1,80 @@
+#ifndef IRIS_RAG_SUBWORD_TOKENIZER_H
+#define IRIS_RAG_SUBWORD_TOKENIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace iris {
+namespace rag {
+
+/**
+ * A token as a byte range of the source text
+ */
+struct TextToken {
+    uint32_t begin;
+    uint32_t end;
+    bool wordStart; // false for "##" continuation pieces
+};
+
+/**
+ * WordPiece tokenizer for the embedding model's vocabulary (BERT-style
+ * vocab.txt, one piece per line, continuations prefixed with "##").
+ *
+ * Text is pre-split the way the model's basic tokenizer does it: whitespace
+ * separates words, every punctuation mark and ideograph is a word of its own.
+ * Words are then matched greedily, longest piece first; a word that cannot be
+ * covered is one unknown token. Uncased vocabularies (no upper-case pieces)
+ * see case-folded text. Accents are not stripped, so accented words in an
+ * uncased model may split into a few more pieces than the reference tokenizer
+ * produces.
+ *
+ * Without a vocabulary every word counts as one token, an approximation for
+ * when no model is available. Tokens are reported as offsets into the input;
+ * nothing is copied except case-folded words during matching.
+ */
+class SubwordTokenizer {
+public:
+    /**
+     * Word-level tokenizer (no vocabulary)
+     */
+    SubwordTokenizer();
+
+    /**
+     * @throws std::runtime_error if the file cannot be read or is empty
+     */
+    static std::unique_ptr<SubwordTokenizer> load(const std::string& vocabPath);
+
+    /**
+     * Pieces in the vocabulary, 0 when word-level
+     */
+    size_t vocabularySize() const { return vocabularySize_; }
+
+    /**
+     * Append the tokens of `text` to `out`, offset by `base` bytes
+     */
+    void tokenize(std::string_view text, size_t base, std::vector<TextToken>& out) const;
+
+    size_t countTokens(std::string_view text) const;
+
+    static constexpr size_t kMaxWordChars = 100; // longer words are one unknown token
+
+private:
+    std::string arena_; // vocabulary file contents; pieces_ views into it
+    std::unordered_map<std::string_view, int32_t> pieces_;
+    std::unordered_map<std::string_view, int32_t> continuations_; // keys without "##"
+    size_t vocabularySize_ = 0;
+    size_t maxPieceBytes_ = 0;
+    bool lowercase_ = false;
+
+    void splitWord(std::string_view text, size_t begin, size_t end, size_t base, std::vector<TextToken>& out) const;
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_SUBWORD_TOKENIZER_H
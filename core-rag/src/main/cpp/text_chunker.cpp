@@ -0,0 +1,150 @@
+#include "text_chunker.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "text_tokenizer.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+bool isOneOf(std::string_view token, std::initializer_list<std::string_view> marks) {
+    return std::find(marks.begin(), marks.end(), token) != marks.end();
+}
+
+CharClass leadingClass(std::string_view text) {
+    size_t i = 0;
+    return text.empty() ? CharClass::kSeparator : classify(decodeUtf8(text, i));
+}
+
+} // namespace
+
+TextChunker::TextChunker(const SubwordTokenizer& tokenizer, size_t maxTokens, size_t overlapTokens)
+    : tokenizer_(tokenizer), maxTokens_(maxTokens), overlapTokens_(overlapTokens) {
+    if (maxTokens == 0 || overlapTokens >= maxTokens) {
+        throw std::invalid_argument("Chunking needs maxTokens > 0 and overlapTokens < maxTokens");
+    }
+}
+
+TextChunker::Break TextChunker::breakBefore(std::string_view text, const TextToken* previous, const TextToken& token) {
+    if (!token.wordStart) {
+        return kMidWord;
+    }
+    if (previous == nullptr) {
+        return kParagraph;
+    }
+    const std::string_view gap = text.substr(previous->end, token.begin - previous->end);
+    const auto newlines = std::count(gap.begin(), gap.end(), '\n');
+    if (newlines >= 2) {
+        return kParagraph;
+    }
+    if (newlines == 1) {
+        return kSentence;
+    }
+    // ASCII punctuation only ends a sentence or clause when followed by space ("3.14", "1,000");
+    // CJK punctuation is never followed by space
+    const std::string_view mark = text.substr(previous->begin, previous->end - previous->begin);
+    const bool spaced = !gap.empty();
+    if ((spaced && isOneOf(mark, {".", "!", "?", "…"})) || isOneOf(mark, {"。", "！", "？"})) {
+        return kSentence;
+    }
+    if ((spaced && isOneOf(mark, {",", ";", ":", ")"})) || isOneOf(mark, {"、", "，", "；", "："})) {
+        return kClause;
+    }
+    // Ideographs are words of their own, but punctuation stays with what precedes it
+    const CharClass current = leadingClass(text.substr(token.begin, token.end - token.begin));
+    if (spaced || current == CharClass::kIdeograph ||
+        (current == CharClass::kWord && leadingClass(mark) == CharClass::kIdeograph)) {
+        return kWord;
+    }
+    return kMidWord; // glued to the previous token: "3.14", "don't", "word,"
+}
+
+void TextChunker::chunk(std::string_view text, const std::function<void(const ChunkSpan&)>& emit) const {
+    if (text.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::invalid_argument("Text is too long to chunk");
+    }
+
+    // Tokens from the first one the next chunk may use; earlier ones are dropped as chunks are emitted
+    std::vector<TextToken> tokens;
+    std::vector<uint8_t> breaks;
+    size_t head = 0;
+    size_t scanned = 0;
+
+    const auto tokenizeWindow = [&]() {
+        size_t end = std::min(scanned + kWindowBytes, text.size());
+        if (end < text.size()) {
+            // End the window at whitespace so no word straddles two windows
+            const size_t space = text.find_first_of(" \t\r\n", end);
+            if (space != std::string_view::npos && space - end < kWindowBytes) {
+                end = space;
+            } else {
+                while (end > scanned && (static_cast<uint8_t>(text[end]) & 0xC0) == 0x80) {
+                    end--;
+                }
+            }
+        }
+        const size_t first = tokens.size();
+        tokenizer_.tokenize(text.substr(scanned, end - scanned), scanned, tokens);
+        for (size_t i = first; i < tokens.size(); i++) {
+            breaks.push_back(breakBefore(text, i > 0 ? &tokens[i - 1] : nullptr, tokens[i]));
+        }
+        scanned = end;
+    };
+
+    const size_t minTokens = std::max<size_t>(1, maxTokens_ / 2);
+    while (true) {
+        // One token beyond the budget tells whether the budget ends on a boundary
+        while (tokens.size() - head <= maxTokens_ && scanned < text.size()) {
+            tokenizeWindow();
+        }
+        const size_t available = tokens.size() - head;
+        if (available == 0) {
+            return;
+        }
+        if (available <= maxTokens_) {
+            emit({tokens[head].begin, tokens.back().end, static_cast<uint32_t>(available)});
+            return;
+        }
+
+        // Strongest boundary in the second half of the budget, the latest among equals
+        size_t cut = head + maxTokens_;
+        uint8_t best = breaks[cut];
+        for (size_t j = cut - 1; j >= head + minTokens && best < kParagraph; j--) {
+            if (breaks[j] > best) {
+                best = breaks[j];
+                cut = j;
+            }
+        }
+        emit({tokens[head].begin, tokens[cut - 1].end, static_cast<uint32_t>(cut - head)});
+
+        // The overlap starts at its strongest boundary, the earliest among equals
+        size_t next = cut;
+        uint8_t overlapBest = kMidWord;
+        for (size_t j = cut - std::min(overlapTokens_, cut - head - 1); j < cut; j++) {
+            if (breaks[j] > overlapBest) {
+                overlapBest = breaks[j];
+                next = j;
+            }
+        }
+        head = next;
+
+        if (head >= tokens.size() / 2 && head >= maxTokens_) {
+            tokens.erase(tokens.begin(), tokens.begin() + static_cast<std::ptrdiff_t>(head));
+            breaks.erase(breaks.begin(), breaks.begin() + static_cast<std::ptrdiff_t>(head));
+            head = 0;
+        }
+    }
+}
+
+std::vector<ChunkSpan> TextChunker::chunk(std::string_view text) const {
+    std::vector<ChunkSpan> spans;
+    chunk(text, [&](const ChunkSpan& span) { spans.push_back(span); });
+    return spans;
+}
+
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,64 @@
+#ifndef IRIS_RAG_TEXT_CHUNKER_H
+#define IRIS_RAG_TEXT_CHUNKER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "subword_tokenizer.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * A chunk as a byte range of the source text
+ */
+struct ChunkSpan {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t tokens;
+};
+
+/**
+ * Splits text into chunks of at most `maxTokens` model tokens.
+ *
+ * The text is tokenized once, in windows of about kWindowBytes, and chunks are
+ * emitted as soon as their end is known, so memory stays bounded by the window
+ * and the token budget however long the document is. Each cut is placed at the
+ * strongest boundary in the second half of the budget: paragraph, then line or
+ * sentence end, then clause punctuation, then any word start; a chunk is cut
+ * mid-word only when a single word exceeds the budget. Consecutive chunks share
+ * up to `overlapTokens` tokens, starting at the strongest boundary among them.
+ */
+class TextChunker {
+public:
+    static constexpr size_t kWindowBytes = 64 * 1024;
+
+    /**
+     * @throws std::invalid_argument unless 0 <= overlapTokens < maxTokens
+     */
+    TextChunker(const SubwordTokenizer& tokenizer, size_t maxTokens, size_t overlapTokens);
+
+    /**
+     * Report each chunk of `text` to `emit`, in order
+     */
+    void chunk(std::string_view text, const std::function<void(const ChunkSpan&)>& emit) const;
+
+    std::vector<ChunkSpan> chunk(std::string_view text) const;
+
+private:
+    enum Break : uint8_t { kMidWord, kWord, kClause, kSentence, kParagraph };
+
+    const SubwordTokenizer& tokenizer_;
+    const size_t maxTokens_;
+    const size_t overlapTokens_;
+
+    static Break breakBefore(std::string_view text, const TextToken* previous, const TextToken& token);
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_TEXT_CHUNKER_H
@@ -0,0 +1,434 @@
+#include "text_normalizer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include "text_tokenizer.h"
+#include "vector_kernels.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+constexpr char32_t kReplacement = 0xFFFD;
+constexpr char32_t kMalformed = 0x110000; // decodeStrict's marker, written as U+FFFD
+
+// Words that end in '.' without ending a sentence; single letters (initials, "e.g.") are handled apart
+constexpr std::string_view kAbbreviations[] = {
+    "Mr", "Mrs", "Ms", "Dr", "Prof", "Sr", "Jr", "St", "vs", "cf", "al", "approx",
+    "Fig", "fig", "Figs", "Eq", "eq", "No", "no", "Vol", "vol", "pp", "Inc", "Ltd", "Co", "Corp", "Dept",
+    "Jan", "Feb", "Mar", "Apr", "Jun", "Jul", "Aug", "Sep", "Sept", "Oct", "Nov", "Dec",
+};
+
+// U+FB00..U+FB06
+constexpr const char* kLigatures[] = {"ff", "fi", "fl", "ffi", "ffl", "st", "st"};
+
+struct Composition {
+    char32_t mark;
+    char base;
+    char32_t composed;
+};
+
+// Latin letter + combining accent -> precomposed letter, sorted by (mark, base)
+constexpr Composition kCompositions[] = {
+    {0x0300, 'A', 0x00C0}, {0x0300, 'E', 0x00C8}, {0x0300, 'I', 0x00CC}, {0x0300, 'N', 0x01F8},
+    {0x0300, 'O', 0x00D2}, {0x0300, 'U', 0x00D9}, {0x0300, 'a', 0x00E0}, {0x0300, 'e', 0x00E8},
+    {0x0300, 'i', 0x00EC}, {0x0300, 'n', 0x01F9}, {0x0300, 'o', 0x00F2}, {0x0300, 'u', 0x00F9},
+    {0x0301, 'A', 0x00C1}, {0x0301, 'C', 0x0106}, {0x0301, 'E', 0x00C9}, {0x0301, 'G', 0x01F4},
+    {0x0301, 'I', 0x00CD}, {0x0301, 'L', 0x0139}, {0x0301, 'N', 0x0143}, {0x0301, 'O', 0x00D3},
+    {0x0301, 'R', 0x0154}, {0x0301, 'S', 0x015A}, {0x0301, 'U', 0x00DA}, {0x0301, 'Y', 0x00DD},
+    {0x0301, 'Z', 0x0179}, {0x0301, 'a', 0x00E1}, {0x0301, 'c', 0x0107}, {0x0301, 'e', 0x00E9},
+    {0x0301, 'g', 0x01F5}, {0x0301, 'i', 0x00ED}, {0x0301, 'l', 0x013A}, {0x0301, 'n', 0x0144},
+    {0x0301, 'o', 0x00F3}, {0x0301, 'r', 0x0155}, {0x0301, 's', 0x015B}, {0x0301, 'u', 0x00FA},
+    {0x0301, 'y', 0x00FD}, {0x0301, 'z', 0x017A}, {0x0302, 'A', 0x00C2}, {0x0302, 'C', 0x0108},
+    {0x0302, 'E', 0x00CA}, {0x0302, 'G', 0x011C}, {0x0302, 'H', 0x0124}, {0x0302, 'I', 0x00CE},
+    {0x0302, 'J', 0x0134}, {0x0302, 'O', 0x00D4}, {0x0302, 'S', 0x015C}, {0x0302, 'U', 0x00DB},
+    {0x0302, 'W', 0x0174}, {0x0302, 'Y', 0x0176}, {0x0302, 'a', 0x00E2}, {0x0302, 'c', 0x0109},
+    {0x0302, 'e', 0x00EA}, {0x0302, 'g', 0x011D}, {0x0302, 'h', 0x0125}, {0x0302, 'i', 0x00EE},
+    {0x0302, 'j', 0x0135}, {0x0302, 'o', 0x00F4}, {0x0302, 's', 0x015D}, {0x0302, 'u', 0x00FB},
+    {0x0302, 'w', 0x0175}, {0x0302, 'y', 0x0177}, {0x0303, 'A', 0x00C3}, {0x0303, 'I', 0x0128},
+    {0x0303, 'N', 0x00D1}, {0x0303, 'O', 0x00D5}, {0x0303, 'U', 0x0168}, {0x0303, 'a', 0x00E3},
+    {0x0303, 'i', 0x0129}, {0x0303, 'n', 0x00F1}, {0x0303, 'o', 0x00F5}, {0x0303, 'u', 0x0169},
+    {0x0304, 'A', 0x0100}, {0x0304, 'E', 0x0112}, {0x0304, 'I', 0x012A}, {0x0304, 'O', 0x014C},
+    {0x0304, 'U', 0x016A}, {0x0304, 'Y', 0x0232}, {0x0304, 'a', 0x0101}, {0x0304, 'e', 0x0113},
+    {0x0304, 'i', 0x012B}, {0x0304, 'o', 0x014D}, {0x0304, 'u', 0x016B}, {0x0304, 'y', 0x0233},
+    {0x0306, 'A', 0x0102}, {0x0306, 'E', 0x0114}, {0x0306, 'G', 0x011E}, {0x0306, 'I', 0x012C},
+    {0x0306, 'O', 0x014E}, {0x0306, 'U', 0x016C}, {0x0306, 'a', 0x0103}, {0x0306, 'e', 0x0115},
+    {0x0306, 'g', 0x011F}, {0x0306, 'i', 0x012D}, {0x0306, 'o', 0x014F}, {0x0306, 'u', 0x016D},
+    {0x0307, 'A', 0x0226}, {0x0307, 'C', 0x010A}, {0x0307, 'E', 0x0116}, {0x0307, 'G', 0x0120},
+    {0x0307, 'I', 0x0130}, {0x0307, 'O', 0x022E}, {0x0307, 'Z', 0x017B}, {0x0307, 'a', 0x0227},
+    {0x0307, 'c', 0x010B}, {0x0307, 'e', 0x0117}, {0x0307, 'g', 0x0121}, {0x0307, 'o', 0x022F},
+    {0x0307, 'z', 0x017C}, {0x0308, 'A', 0x00C4}, {0x0308, 'E', 0x00CB}, {0x0308, 'I', 0x00CF},
+    {0x0308, 'O', 0x00D6}, {0x0308, 'U', 0x00DC}, {0x0308, 'Y', 0x0178}, {0x0308, 'a', 0x00E4},
+    {0x0308, 'e', 0x00EB}, {0x0308, 'i', 0x00EF}, {0x0308, 'o', 0x00F6}, {0x0308, 'u', 0x00FC},
+    {0x0308, 'y', 0x00FF}, {0x030A, 'A', 0x00C5}, {0x030A, 'U', 0x016E}, {0x030A, 'a', 0x00E5},
+    {0x030A, 'u', 0x016F}, {0x030B, 'O', 0x0150}, {0x030B, 'U', 0x0170}, {0x030B, 'o', 0x0151},
+    {0x030B, 'u', 0x0171}, {0x030C, 'A', 0x01CD}, {0x030C, 'C', 0x010C}, {0x030C, 'D', 0x010E},
+    {0x030C, 'E', 0x011A}, {0x030C, 'G', 0x01E6}, {0x030C, 'H', 0x021E}, {0x030C, 'I', 0x01CF},
+    {0x030C, 'K', 0x01E8}, {0x030C, 'L', 0x013D}, {0x030C, 'N', 0x0147}, {0x030C, 'O', 0x01D1},
+    {0x030C, 'R', 0x0158}, {0x030C, 'S', 0x0160}, {0x030C, 'T', 0x0164}, {0x030C, 'U', 0x01D3},
+    {0x030C, 'Z', 0x017D}, {0x030C, 'a', 0x01CE}, {0x030C, 'c', 0x010D}, {0x030C, 'd', 0x010F},
+    {0x030C, 'e', 0x011B}, {0x030C, 'g', 0x01E7}, {0x030C, 'h', 0x021F}, {0x030C, 'i', 0x01D0},
+    {0x030C, 'j', 0x01F0}, {0x030C, 'k', 0x01E9}, {0x030C, 'l', 0x013E}, {0x030C, 'n', 0x0148},
+    {0x030C, 'o', 0x01D2}, {0x030C, 'r', 0x0159}, {0x030C, 's', 0x0161}, {0x030C, 't', 0x0165},
+    {0x030C, 'u', 0x01D4}, {0x030C, 'z', 0x017E}, {0x0327, 'C', 0x00C7}, {0x0327, 'E', 0x0228},
+    {0x0327, 'G', 0x0122}, {0x0327, 'K', 0x0136}, {0x0327, 'L', 0x013B}, {0x0327, 'N', 0x0145},
+    {0x0327, 'R', 0x0156}, {0x0327, 'S', 0x015E}, {0x0327, 'T', 0x0162}, {0x0327, 'c', 0x00E7},
+    {0x0327, 'e', 0x0229}, {0x0327, 'g', 0x0123}, {0x0327, 'k', 0x0137}, {0x0327, 'l', 0x013C},
+    {0x0327, 'n', 0x0146}, {0x0327, 'r', 0x0157}, {0x0327, 's', 0x015F}, {0x0327, 't', 0x0163},
+    {0x0328, 'A', 0x0104}, {0x0328, 'E', 0x0118}, {0x0328, 'I', 0x012E}, {0x0328, 'O', 0x01EA},
+    {0x0328, 'U', 0x0172}, {0x0328, 'a', 0x0105}, {0x0328, 'e', 0x0119}, {0x0328, 'i', 0x012F},
+    {0x0328, 'o', 0x01EB}, {0x0328, 'u', 0x0173},
+};
+
+/**
+ * Decode one code point, rejecting overlongs, surrogates and values past U+10FFFF
+ * @return Bytes consumed (the maximal invalid prefix for malformed input, with
+ *         `cp` = kMalformed), or 0 if `length` ends inside a valid prefix
+ */
+size_t decodeStrict(const uint8_t* bytes, size_t length, char32_t& cp) {
+    const uint8_t lead = bytes[0];
+    if (lead < 0x80) {
+        cp = lead;
+        return 1;
+    }
+    size_t need;
+    char32_t value;
+    uint8_t low = 0x80;
+    uint8_t high = 0xBF;
+    if (lead >= 0xC2 && lead <= 0xDF) {
+        need = 2;
+        value = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        need = 3;
+        value = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        need = 4;
+        value = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        cp = kMalformed;
+        return 1;
+    }
+    for (size_t k = 1; k < need; k++) {
+        if (k >= length) {
+            return 0;
+        }
+        if (bytes[k] < low || bytes[k] > high) {
+            cp = kMalformed;
+            return k;
+        }
+        low = 0x80;
+        high = 0xBF;
+        value = (value << 6) | (bytes[k] & 0x3F);
+    }
+    cp = value;
+    return need;
+}
+
+bool isAsciiLetter(char32_t cp) {
+    return (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+}
+
+/**
+ * Lowercase letter of a cased script (Latin, Greek, Cyrillic, Armenian)
+ */
+bool isLower(char32_t cp) {
+    if (cp < 0x80) {
+        return cp >= 'a' && cp <= 'z';
+    }
+    const bool combining = cp >= 0x300 && cp <= 0x36F;
+    return cp < 0x590 && !combining && classify(cp) == CharClass::kWord && foldCase(cp) == cp;
+}
+
+bool isOpener(char32_t cp) {
+    return cp == '"' || cp == '\'' || cp == '(' || cp == '[' || cp == 0xA1 || cp == 0xAB || cp == 0xBF ||
+           cp == 0x2018 || cp == 0x201C || cp == 0x300C || cp == 0x300E;
+}
+
+bool isCloser(char32_t cp) {
+    return cp == '"' || cp == '\'' || cp == ')' || cp == ']' || cp == '}' || cp == 0xBB || cp == 0x2019 ||
+           cp == 0x201D || cp == 0x300D || cp == 0x300F;
+}
+
+/**
+ * Whether `cp`, after whitespace, can begin a new sentence
+ */
+bool startsSentence(char32_t cp) {
+    return !isLower(cp) && (classify(cp) != CharClass::kSeparator || isOpener(cp));
+}
+
+} // namespace
+
+TextNormalizer::TextNormalizer(NormalizeOptions options) : options_(options) {}
+
+NormalizedText TextNormalizer::normalize(std::string_view bytes, NormalizeOptions options) {
+    TextNormalizer normalizer(options);
+    normalizer.result_.text.reserve(bytes.size());
+    normalizer.feed(bytes);
+    return normalizer.finish();
+}
+
+void TextNormalizer::feed(std::string_view bytes) {
+    const auto* data = reinterpret_cast<const uint8_t*>(bytes.data());
+    const size_t length = bytes.size();
+    size_t i = 0;
+
+    // Finish a character split across feeds
+    if (carryLength_ > 0) {
+        while (i < length) {
+            carry_[carryLength_++] = data[i++];
+            char32_t cp;
+            const size_t used = decodeStrict(carry_, carryLength_, cp);
+            if (used == 0) {
+                continue;
+            }
+            // Bytes past an invalid prefix came from this feed; decode them again
+            i -= carryLength_ - used;
+            carryLength_ = 0;
+            process(cp, carryAt_, carryAt_ + used);
+            break;
+        }
+    }
+
+    while (i < length) {
+        if (data[i] < 0x80 && fastPathReady()) {
+            const size_t run = kernels::plainTextRun(bytes.data() + i, length - i);
+            if (run > 0) {
+                appendPlain(bytes.data() + i, run, consumed_ + i);
+                i += run;
+                continue;
+            }
+        }
+        char32_t cp;
+        const size_t used = decodeStrict(data + i, length - i, cp);
+        if (used == 0) {
+            std::memcpy(carry_, data + i, length - i);
+            carryLength_ = length - i;
+            carryAt_ = consumed_ + i;
+            break;
+        }
+        process(cp, consumed_ + i, consumed_ + i + used);
+        i += used;
+    }
+    consumed_ += length;
+}
+
+NormalizedText TextNormalizer::finish() {
+    if (carryLength_ > 0) {
+        process(kMalformed, carryAt_, carryAt_ + carryLength_);
+        carryLength_ = 0;
+    }
+    closeSentence();
+    return std::move(result_);
+}
+
+bool TextNormalizer::fastPathReady() const {
+    return sentenceOpen_ && !pendingSpace_ && pendingNewlines_ == 0 && terminal_ == Terminal::kNone &&
+           hyphen_ == Hyphen::kNone;
+}
+
+void TextNormalizer::appendPlain(const char* bytes, size_t length, size_t at) {
+    // A trailing space stays pending like any other, in case a line break follows
+    size_t end = length;
+    if (bytes[end - 1] == ' ') {
+        end--;
+        pendingSpace_ = true;
+    }
+    result_.text.append(bytes, end);
+    last_ = static_cast<uint8_t>(bytes[end - 1]);
+    lastSourceEnd_ = at + end;
+    lastReplacement_ = false;
+    lastCarriageReturn_ = false;
+}
+
+void TextNormalizer::process(char32_t cp, size_t at, size_t next) {
+    const bool afterCarriageReturn = lastCarriageReturn_;
+    lastCarriageReturn_ = false;
+
+    switch (cp) {
+    case '\r':
+        lastCarriageReturn_ = true;
+        pendingNewlines_ = std::min(pendingNewlines_ + 1, 2);
+        return;
+    case '\n':
+        if (!afterCarriageReturn) {
+            pendingNewlines_ = std::min(pendingNewlines_ + 1, 2);
+        }
+        return;
+    case 0x0B:
+    case 0x0C:
+    case 0x85:
+    case 0x2028:
+        pendingNewlines_ = std::min(pendingNewlines_ + 1, 2);
+        return;
+    case 0x2029:
+        pendingNewlines_ = 2;
+        return;
+    case '\t':
+    case ' ':
+    case 0xA0:
+    case 0x1680:
+    case 0x202F:
+    case 0x205F:
+    case 0x3000:
+        pendingSpace_ = true;
+        return;
+    case 0xAD:
+        // Soft hyphen: invisible, but marks a word broken at a line end
+        if (hyphen_ == Hyphen::kNone && classify(last_) == CharClass::kWord) {
+            hyphen_ = Hyphen::kSoft;
+        }
+        return;
+    case 0x200B:
+    case 0x2060:
+    case 0xFEFF:
+        return;
+    case 0x2026:
+        for (int k = 0; k < 3; k++) {
+            visible('.', at, next, false);
+        }
+        return;
+    case kMalformed:
+        result_.invalidSequences++;
+        visible(kReplacement, at, next, false);
+        return;
+    default:
+        break;
+    }
+    if (cp >= 0x2000 && cp <= 0x200A) {
+        pendingSpace_ = true;
+        return;
+    }
+    if (cp < 0x20 || (cp >= 0x7F && cp <= 0x9F)) {
+        return;
+    }
+    if (cp >= 0xFB00 && cp <= 0xFB06) {
+        for (const char* c = kLigatures[cp - 0xFB00]; *c; c++) {
+            visible(static_cast<char32_t>(*c), at, next, false);
+        }
+        return;
+    }
+    if (cp >= 0xFF01 && cp <= 0xFF5E) {
+        visible(cp - 0xFEE0, at, next, true);
+        return;
+    }
+    if (cp >= 0x300 && cp <= 0x36F && !pendingSpace_ && pendingNewlines_ == 0 && isAsciiLetter(last_)) {
+        const auto key = [](const Composition& c) { return std::make_pair(c.mark, c.base); };
+        const Composition* found = std::lower_bound(
+            std::begin(kCompositions), std::end(kCompositions), std::make_pair(cp, static_cast<char>(last_)),
+            [&key](const Composition& c, const std::pair<char32_t, char>& wanted) { return key(c) < wanted; });
+        if (found != std::end(kCompositions) && found->mark == cp && found->base == static_cast<char>(last_)) {
+            result_.text.pop_back();
+            appendUtf8(result_.text, found->composed);
+            last_ = found->composed;
+            lastSourceEnd_ = next;
+            return;
+        }
+    }
+    visible(cp, at, next, false);
+}
+
+void TextNormalizer::visible(char32_t cp, size_t at, size_t next, bool wide) {
+    std::string& text = result_.text;
+    bool lineBreak = pendingNewlines_ > 0;
+    const bool paragraph = pendingNewlines_ > 1;
+    bool space = pendingSpace_ || lineBreak;
+
+    if (cp == kReplacement && lastReplacement_ && !space) {
+        lastSourceEnd_ = next;
+        return;
+    }
+
+    // A lowercase letter starting the next line continues a word hyphenated at the line end
+    if (pendingNewlines_ == 1 && isLower(cp) &&
+        (hyphen_ == Hyphen::kSoft || (hyphen_ == Hyphen::kHard && options_.dehyphenate))) {
+        if (hyphen_ == Hyphen::kHard) {
+            text.pop_back();
+        }
+        result_.dehyphenated++;
+        pendingSpace_ = false;
+        pendingNewlines_ = 0;
+        lineBreak = false;
+        space = false;
+    }
+
+    if (terminal_ != Terminal::kNone) {
+        if (!space && isCloser(cp)) {
+            // Quotes and brackets after the terminator belong to the sentence
+        } else if (terminal_ == Terminal::kWide || (space && (lineBreak ? !isLower(cp) : startsSentence(cp)))) {
+            closeSentence();
+        } else {
+            terminal_ = Terminal::kNone;
+        }
+    }
+    if (paragraph) {
+        closeSentence();
+    }
+
+    // Whitespace is written only once a visible character follows it
+    if (!text.empty()) {
+        if (paragraph) {
+            text += "\n\n";
+        } else if (lineBreak) {
+            text += '\n';
+        } else if (pendingSpace_) {
+            text += ' ';
+        }
+    }
+    pendingSpace_ = false;
+    pendingNewlines_ = 0;
+
+    if (!sentenceOpen_) {
+        sentenceOpen_ = true;
+        sentence_ = {static_cast<uint32_t>(text.size()), 0, static_cast<uint32_t>(at), 0,
+                     paragraph || result_.sentences.empty()};
+    }
+
+    if (cp == 0x3002 || cp == 0xFF61 || (wide && (cp == '.' || cp == '!' || cp == '?'))) {
+        terminal_ = Terminal::kWide;
+    } else if (cp == '!' || cp == '?' || (cp == '.' && !abbreviationBefore())) {
+        terminal_ = Terminal::kPending;
+    }
+    hyphen_ = cp == '-' && isLower(last_) ? Hyphen::kHard : Hyphen::kNone;
+
+    appendUtf8(text, cp);
+    last_ = cp;
+    lastSourceEnd_ = next;
+    lastReplacement_ = cp == kReplacement;
+}
+
+bool TextNormalizer::abbreviationBefore() const {
+    const std::string& text = result_.text;
+    size_t start = text.size();
+    while (start > 0 && isAsciiLetter(static_cast<uint8_t>(text[start - 1]))) {
+        start--;
+    }
+    const std::string_view word(text.data() + start, text.size() - start);
+    if (word.empty()) {
+        return false;
+    }
+    // Initials, and the letters of "e.g." and "i.e."
+    if (word.size() == 1) {
+        return true;
+    }
+    return std::find(std::begin(kAbbreviations), std::end(kAbbreviations), word) != std::end(kAbbreviations);
+}
+
+void TextNormalizer::closeSentence() {
+    if (sentenceOpen_) {
+        sentence_.end = static_cast<uint32_t>(result_.text.size());
+        sentence_.sourceEnd = static_cast<uint32_t>(lastSourceEnd_);
+        result_.sentences.push_back(sentence_);
+        sentenceOpen_ = false;
+    }
+    terminal_ = Terminal::kNone;
+}
+
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,107 @@
+#ifndef IRIS_RAG_TEXT_NORMALIZER_H
+#define IRIS_RAG_TEXT_NORMALIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iris {
+namespace rag {
+
+struct NormalizeOptions {
+    // Join words split by a hyphen at a line end ("exam-\nple" -> "example"); for PDF text
+    bool dehyphenate = false;
+};
+
+/**
+ * A sentence as a byte range of the normalized text and of the source
+ */
+struct SentenceSpan {
+    uint32_t begin;
+    uint32_t end;
+    uint32_t sourceBegin;
+    uint32_t sourceEnd;
+    bool paragraphStart; // first sentence, or first after a blank line
+};
+
+struct NormalizedText {
+    std::string text;
+    std::vector<SentenceSpan> sentences;
+    size_t invalidSequences = 0; // malformed UTF-8 sequences, each replaced by U+FFFD
+    size_t dehyphenated = 0;
+};
+
+/**
+ * Cleans extracted document text and finds its sentences in one pass.
+ *
+ * Input is UTF-8 fed in pieces of any size, split anywhere, even inside a
+ * character. Each pass:
+ * - validates UTF-8 strictly (no overlongs, surrogates or code points past
+ *   U+10FFFF); each malformed sequence becomes U+FFFD, runs of them one
+ * - applies the compatibility mappings extraction produces: ligatures,
+ *   fullwidth ASCII, the ellipsis character and Unicode spaces. Latin letters
+ *   followed by a combining accent are composed. This is not full NFKC
+ * - drops control and zero-width characters, folds CR LF and other line
+ *   separators to `\n`, collapses runs of spaces to one, trims lines, and keeps
+ *   at most one blank line
+ * - joins words hyphenated across a line break, when enabled, and always
+ *   across a soft hyphen
+ * - ends a sentence at `.`, `!` or `?` (and trailing quotes or brackets) that
+ *   is followed by whitespace and a character that can start one, at a CJK
+ *   full stop, and at a blank line. Initials and common abbreviations are not
+ *   sentence ends.
+ *
+ * Runs of plain ASCII are found with kernels::plainTextRun and copied
+ * unchanged; only the bytes between them are decoded one by one.
+ */
+class TextNormalizer {
+public:
+    explicit TextNormalizer(NormalizeOptions options = {});
+
+    void feed(std::string_view bytes);
+
+    /**
+     * Flush what is pending; the normalizer is spent afterwards
+     */
+    NormalizedText finish();
+
+    static NormalizedText normalize(std::string_view bytes, NormalizeOptions options = {});
+
+private:
+    enum class Terminal : uint8_t { kNone, kPending, kWide };
+    enum class Hyphen : uint8_t { kNone, kHard, kSoft };
+
+    const NormalizeOptions options_;
+    NormalizedText result_;
+
+    uint8_t carry_[4];
+    size_t carryLength_ = 0;
+    size_t carryAt_ = 0;
+    size_t consumed_ = 0;
+
+    bool pendingSpace_ = false;
+    int pendingNewlines_ = 0;
+    bool lastCarriageReturn_ = false;
+    bool lastReplacement_ = false;
+    char32_t last_ = 0;
+    size_t lastSourceEnd_ = 0;
+
+    Hyphen hyphen_ = Hyphen::kNone;
+    Terminal terminal_ = Terminal::kNone;
+    bool sentenceOpen_ = false;
+    SentenceSpan sentence_{};
+
+    void process(char32_t cp, size_t at, size_t next);
+    void visible(char32_t cp, size_t at, size_t next, bool wide);
+    void appendPlain(const char* bytes, size_t length, size_t at);
+    void closeSentence();
+    bool abbreviationBefore() const;
+    bool fastPathReady() const;
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_TEXT_NORMALIZER_H
@@ -0,0 +1,212 @@
+#include "text_tokenizer.h"
+
+#include <cstdint>
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+constexpr char32_t kInvalid = 0xFFFD;
+
+bool inRange(char32_t cp, char32_t first, char32_t last) {
+    return cp >= first && cp <= last;
+}
+
+} // namespace
+
+char32_t decodeUtf8(std::string_view text, size_t& i) {
+    const auto byte = [&](size_t at) { return static_cast<uint8_t>(text[at]); };
+    const uint8_t lead = byte(i);
+    if (lead < 0x80) {
+        i += 1;
+        return lead;
+    }
+    size_t length;
+    char32_t cp;
+    if ((lead & 0xE0) == 0xC0) {
+        length = 2;
+        cp = lead & 0x1F;
+    } else if ((lead & 0xF0) == 0xE0) {
+        length = 3;
+        cp = lead & 0x0F;
+    } else if ((lead & 0xF8) == 0xF0) {
+        length = 4;
+        cp = lead & 0x07;
+    } else {
+        i += 1;
+        return kInvalid;
+    }
+    if (i + length > text.size()) {
+        i += 1;
+        return kInvalid;
+    }
+    for (size_t k = 1; k < length; k++) {
+        if ((byte(i + k) & 0xC0) != 0x80) {
+            i += 1;
+            return kInvalid;
+        }
+        cp = (cp << 6) | (byte(i + k) & 0x3F);
+    }
+    i += length;
+    return cp;
+}
+
+void appendUtf8(std::string& out, char32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+CharClass classify(char32_t cp) {
+    if (cp < 0x80) {
+        const bool alnum = (cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z');
+        return alnum ? CharClass::kWord : CharClass::kSeparator;
+    }
+    if (cp < 0xC0) {
+        // Latin-1 punctuation and symbols, except the ordinal and micro letters
+        return cp == 0xAA || cp == 0xB5 || cp == 0xBA ? CharClass::kWord : CharClass::kSeparator;
+    }
+    if (cp == 0xD7 || cp == 0xF7 || cp == kInvalid) {
+        return CharClass::kSeparator;
+    }
+    if (inRange(cp, 0x3040, 0x30FF) || inRange(cp, 0x3400, 0x4DBF) || inRange(cp, 0x4E00, 0x9FFF) ||
+        inRange(cp, 0xF900, 0xFAFF) || inRange(cp, 0x20000, 0x2FA1F)) {
+        return CharClass::kIdeograph;
+    }
+    if (inRange(cp, 0x2000, 0x2BFF) ||   // general punctuation, currency, arrows, math, box drawing
+        inRange(cp, 0x2E00, 0x2E7F) ||   // supplemental punctuation
+        inRange(cp, 0x3000, 0x303F) ||   // CJK punctuation and ideographic space
+        inRange(cp, 0xE000, 0xF8FF) ||   // private use
+        inRange(cp, 0xFE10, 0xFE6F) ||   // vertical, small and compatibility punctuation forms
+        inRange(cp, 0xFF00, 0xFF0F) || inRange(cp, 0xFF1A, 0xFF20) || inRange(cp, 0xFF3B, 0xFF40) ||
+        inRange(cp, 0xFF5B, 0xFF65) ||   // fullwidth punctuation
+        inRange(cp, 0x1F000, 0x1FAFF) || // emoji and pictographs
+        cp == 0x037E || cp == 0x0387 || cp == 0x055D || cp == 0x0589 || cp == 0x05BE || cp == 0x060C ||
+        cp == 0x061B || cp == 0x061F || cp == 0x06D4 || cp == 0x0964 || cp == 0x0965 || cp == 0xFEFF) {
+        return CharClass::kSeparator;
+    }
+    return CharClass::kWord;
+}
+
+char32_t foldCase(char32_t cp) {
+    if (cp < 0x80) {
+        return cp >= 'A' && cp <= 'Z' ? cp + 0x20 : cp;
+    }
+    if (inRange(cp, 0xC0, 0xDE) && cp != 0xD7) {
+        return cp + 0x20;
+    }
+    if (inRange(cp, 0x100, 0x137) || inRange(cp, 0x14A, 0x177) || inRange(cp, 0x182, 0x185) ||
+        inRange(cp, 0x1A0, 0x1A5) || inRange(cp, 0x1DE, 0x1EF) || inRange(cp, 0x1F8, 0x24F)) {
+        return cp | 1;
+    }
+    if (inRange(cp, 0x139, 0x148) || inRange(cp, 0x179, 0x17E) || inRange(cp, 0x1CD, 0x1DC)) {
+        return (cp & 1) ? cp + 1 : cp;
+    }
+    if (cp == 0x178) {
+        return 0xFF;
+    }
+    if (inRange(cp, 0x391, 0x3AB) && cp != 0x3A2) {
+        return cp + 0x20;
+    }
+    if (cp == 0x386) {
+        return 0x3AC;
+    }
+    if (inRange(cp, 0x388, 0x38A)) {
+        return cp + 0x25;
+    }
+    if (cp == 0x38C) {
+        return 0x3CC;
+    }
+    if (cp == 0x38E || cp == 0x38F) {
+        return cp + 0x3F;
+    }
+    if (cp == 0x3C2) {
+        return 0x3C3; // final sigma
+    }
+    if (inRange(cp, 0x400, 0x40F)) {
+        return cp + 0x50;
+    }
+    if (inRange(cp, 0x410, 0x42F)) {
+        return cp + 0x20;
+    }
+    if (inRange(cp, 0x460, 0x481) || inRange(cp, 0x48A, 0x4BF) || inRange(cp, 0x4D0, 0x52F)) {
+        return cp | 1;
+    }
+    if (inRange(cp, 0x4C1, 0x4CE)) {
+        return (cp & 1) ? cp + 1 : cp;
+    }
+    if (inRange(cp, 0x531, 0x556)) {
+        return cp + 0x30;
+    }
+    if (inRange(cp, 0x1E00, 0x1EFF)) {
+        return cp | 1;
+    }
+    if (inRange(cp, 0xFF10, 0xFF19)) {
+        return cp - 0xFF10 + '0';
+    }
+    if (inRange(cp, 0xFF21, 0xFF3A)) {
+        return cp - 0xFF21 + 'a';
+    }
+    if (inRange(cp, 0xFF41, 0xFF5A)) {
+        return cp - 0xFF41 + 'a';
+    }
+    return cp;
+}
+
+std::vector<std::string> tokenize(std::string_view text) {
+    std::vector<std::string> tokens;
+    std::string current;
+    bool truncated = false;
+    auto flush = [&]() {
+        if (!current.empty()) {
+            tokens.push_back(std::move(current));
+            current.clear();
+        }
+        truncated = false;
+    };
+
+    size_t i = 0;
+    while (i < text.size()) {
+        const char32_t cp = decodeUtf8(text, i);
+        switch (classify(cp)) {
+        case CharClass::kSeparator:
+            flush();
+            break;
+        case CharClass::kIdeograph:
+            flush();
+            appendUtf8(current, cp);
+            flush();
+            break;
+        case CharClass::kWord: {
+            if (truncated) {
+                break;
+            }
+            const size_t before = current.size();
+            appendUtf8(current, foldCase(cp));
+            if (current.size() > kMaxTokenBytes) {
+                current.resize(before);
+                truncated = true;
+            }
+            break;
+        }
+        }
+    }
+    flush();
+    return tokens;
+}
+
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,49 @@
+#ifndef IRIS_RAG_TEXT_TOKENIZER_H
+#define IRIS_RAG_TEXT_TOKENIZER_H
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace iris {
+namespace rag {
+
+/**
+ * Split UTF-8 text into lowercased word tokens for lexical indexing.
+ *
+ * Letters, digits and combining marks of any script form words; punctuation,
+ * symbols, whitespace and invalid bytes separate them. Latin, Greek, Cyrillic
+ * and fullwidth forms are case-folded. Han ideographs and kana are emitted one
+ * character per token since those scripts do not separate words with spaces.
+ * Tokens longer than kMaxTokenBytes are truncated at a character boundary.
+ */
+std::vector<std::string> tokenize(std::string_view text);
+
+constexpr size_t kMaxTokenBytes = 64;
+
+/**
+ * Character classes used to find word boundaries; shared with the subword tokenizer
+ */
+enum class CharClass { kSeparator, kWord, kIdeograph };
+
+/**
+ * Decode one code point at `text[i]` and advance `i`; malformed input yields U+FFFD
+ */
+char32_t decodeUtf8(std::string_view text, size_t& i);
+
+void appendUtf8(std::string& out, char32_t cp);
+
+/**
+ * Coarse block-based classification; scripts not listed count as word characters
+ */
+CharClass classify(char32_t cp);
+
+/**
+ * Simple (one-to-one) lowercase mapping for the scripts that have case
+ */
+char32_t foldCase(char32_t cp);
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_TEXT_TOKENIZER_H
@@ -0,0 +1,312 @@
+#include "tfidf_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+#include "exact_scan.h"
+#include "text_tokenizer.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+// The inverted index is rebuilt once the unindexed tail, or the removed
+// documents still in it, exceed this many documents and a quarter of it
+constexpr uint32_t kMinRebuildDocs = 64;
+
+constexpr uint32_t kNoTerm = std::numeric_limits<uint32_t>::max();
+
+/**
+ * Smallest positive score; documents sharing no term with the query score 0
+ */
+constexpr float kMinScore = std::numeric_limits<float>::min();
+
+size_t countChars(const std::string& token, bool& ideograph) {
+    size_t chars = 0;
+    ideograph = false;
+    for (size_t i = 0; i < token.size();) {
+        ideograph = classify(decodeUtf8(token, i)) == CharClass::kIdeograph;
+        chars++;
+    }
+    return chars;
+}
+
+} // namespace
+
+TfIdfIndex::TfIdfIndex(const std::vector<std::string>& stopWords, size_t minTermChars)
+    : stopWords_(stopWords.begin(), stopWords.end()), minTermChars_(minTermChars) {
+    docStart_.push_back(0);
+    termStart_.push_back(0);
+}
+
+std::vector<std::pair<std::string, uint16_t>> TfIdfIndex::terms(std::string_view text) const {
+    std::unordered_map<std::string, uint16_t> counts;
+    for (std::string& token : tokenize(text)) {
+        bool ideograph;
+        if ((countChars(token, ideograph) < minTermChars_ && !ideograph) || stopWords_.count(token)) {
+            continue;
+        }
+        uint16_t& tf = counts[std::move(token)];
+        if (tf < std::numeric_limits<uint16_t>::max()) {
+            tf++;
+        }
+    }
+    return {counts.begin(), counts.end()};
+}
+
+float TfIdfIndex::idf(uint32_t term) const {
+    return std::log((static_cast<float>(liveCount_) + 1.0f) / (static_cast<float>(df_[term]) + 1.0f)) + 1.0f;
+}
+
+float TfIdfIndex::norm(uint32_t doc) const {
+    float sum = 0.0f;
+    for (uint32_t i = docStart_[doc]; i < docStart_[doc + 1]; i++) {
+        const float weight = static_cast<float>(docTfs_[i]) * idf(docTerms_[i]);
+        sum += weight * weight;
+    }
+    return std::sqrt(sum);
+}
+
+void TfIdfIndex::add(int32_t doc, std::string_view text) {
+    const auto docTerms = terms(text);
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    const uint32_t docCount = static_cast<uint32_t>(live_.size());
+    if (doc < 0 || static_cast<uint32_t>(doc) < docCount) {
+        throw std::invalid_argument("TF-IDF documents must be added in increasing order");
+    }
+    // IDs skipped by the caller become empty, never-live documents
+    live_.resize(static_cast<size_t>(doc) + 1, 0);
+    norms_.resize(static_cast<size_t>(doc) + 1, 0.0f);
+    docStart_.resize(static_cast<size_t>(doc) + 1, static_cast<uint32_t>(docTerms_.size()));
+
+    for (const auto& [term, tf] : docTerms) {
+        auto inserted = termIds_.emplace(term, static_cast<uint32_t>(df_.size()));
+        if (inserted.second) {
+            df_.push_back(0);
+        }
+        df_[inserted.first->second]++;
+        docTerms_.push_back(inserted.first->second);
+        docTfs_.push_back(tf);
+    }
+    docStart_.push_back(static_cast<uint32_t>(docTerms_.size()));
+    live_[doc] = 1;
+    liveCount_++;
+    norms_[doc] = norm(static_cast<uint32_t>(doc));
+
+    const uint32_t tail = static_cast<uint32_t>(live_.size()) - indexedDocs_;
+    if (tail > std::max(kMinRebuildDocs, indexedDocs_ / 4)) {
+        rebuild();
+    }
+}
+
+bool TfIdfIndex::remove(int32_t doc) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    if (doc < 0 || static_cast<size_t>(doc) >= live_.size() || !live_[doc]) {
+        return false;
+    }
+    live_[doc] = 0;
+    liveCount_--;
+    for (uint32_t i = docStart_[doc]; i < docStart_[doc + 1]; i++) {
+        df_[docTerms_[i]]--;
+    }
+    if (static_cast<uint32_t>(doc) < indexedDocs_ && ++removedCount_ > std::max(kMinRebuildDocs, indexedDocs_ / 4)) {
+        rebuild();
+    }
+    return true;
+}
+
+size_t TfIdfIndex::size() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return liveCount_;
+}
+
+size_t TfIdfIndex::termCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return termIds_.size();
+}
+
+size_t TfIdfIndex::memoryBytes() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    // Hash nodes: key, value and a next pointer, plus the bucket array
+    size_t bytes = termIds_.bucket_count() * sizeof(void*);
+    for (const auto& entry : termIds_) {
+        bytes += sizeof(entry) + sizeof(void*) + (entry.first.capacity() > 15 ? entry.first.capacity() : 0);
+    }
+    bytes += df_.capacity() * sizeof(uint32_t);
+    bytes += docStart_.capacity() * sizeof(uint32_t) + docTerms_.capacity() * sizeof(uint32_t) +
+             docTfs_.capacity() * sizeof(uint16_t) + norms_.capacity() * sizeof(float) + live_.capacity();
+    bytes += termStart_.capacity() * sizeof(uint32_t) + postingDocs_.capacity() * sizeof(uint32_t) +
+             postingWeights_.capacity() * sizeof(float);
+    return bytes;
+}
+
+std::vector<TfIdfIndex::QueryTerm> TfIdfIndex::queryTerms(std::string_view query, float& queryNorm) const {
+    std::vector<QueryTerm> out;
+    float sum = 0.0f;
+    for (const auto& [term, tf] : terms(query)) {
+        auto it = termIds_.find(term);
+        if (it == termIds_.end() || df_[it->second] == 0) {
+            continue;
+        }
+        const float termIdf = idf(it->second);
+        out.push_back({it->second, static_cast<float>(tf) * termIdf, termIdf});
+        sum += out.back().weight * out.back().weight;
+    }
+    std::sort(out.begin(), out.end(), [](const QueryTerm& a, const QueryTerm& b) { return a.term < b.term; });
+    queryNorm = std::sqrt(sum);
+    return out;
+}
+
+std::vector<SearchHit> TfIdfIndex::search(std::string_view query, int k) const {
+    if (k <= 0) {
+        return {};
+    }
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    float queryNorm;
+    const std::vector<QueryTerm> queryTerms = this->queryTerms(query, queryNorm);
+    if (queryTerms.empty()) {
+        return {};
+    }
+
+    // Term at a time over the inverted index: acc[d] = sum q_t * idf_t * tf_dt / |d|
+    const uint32_t docCount = static_cast<uint32_t>(live_.size());
+    std::vector<float> acc(docCount, 0.0f);
+    const uint32_t indexedTerms = static_cast<uint32_t>(termStart_.size()) - 1;
+    for (const QueryTerm& q : queryTerms) {
+        if (q.term >= indexedTerms) {
+            continue;
+        }
+        const float scale = q.weight * q.idf;
+        for (uint32_t i = termStart_[q.term]; i < termStart_[q.term + 1]; i++) {
+            acc[postingDocs_[i]] += scale * postingWeights_[i];
+        }
+    }
+
+    // The tail has no postings yet; score it from the forward index
+    for (uint32_t doc = indexedDocs_; doc < docCount; doc++) {
+        if (!live_[doc] || norms_[doc] == 0.0f) {
+            continue;
+        }
+        float dot = 0.0f;
+        for (uint32_t i = docStart_[doc]; i < docStart_[doc + 1]; i++) {
+            auto it = std::lower_bound(queryTerms.begin(), queryTerms.end(), docTerms_[i],
+                                       [](const QueryTerm& q, uint32_t term) { return q.term < term; });
+            if (it != queryTerms.end() && it->term == docTerms_[i]) {
+                dot += it->weight * it->idf * static_cast<float>(docTfs_[i]);
+            }
+        }
+        acc[doc] = dot / norms_[doc];
+    }
+
+    TopK top(k, kMinScore);
+    const float inverseQueryNorm = 1.0f / queryNorm;
+    for (uint32_t doc = 0; doc < docCount; doc++) {
+        const float score = acc[doc] * inverseQueryNorm;
+        if (score >= top.floor() && live_[doc]) {
+            top.offer(score, doc);
+        }
+    }
+    return top.sorted();
+}
+
+std::vector<SearchHit> TfIdfIndex::exhaustiveSearch(std::string_view query, int k) const {
+    if (k <= 0) {
+        return {};
+    }
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    float queryNorm;
+    const std::vector<QueryTerm> queryTerms = this->queryTerms(query, queryNorm);
+    if (queryTerms.empty()) {
+        return {};
+    }
+
+    TopK top(k, kMinScore);
+    for (uint32_t doc = 0; doc < live_.size(); doc++) {
+        if (!live_[doc]) {
+            continue;
+        }
+        float dot = 0.0f;
+        for (uint32_t i = docStart_[doc]; i < docStart_[doc + 1]; i++) {
+            for (const QueryTerm& q : queryTerms) {
+                if (q.term == docTerms_[i]) {
+                    dot += q.weight * q.idf * static_cast<float>(docTfs_[i]);
+                }
+            }
+        }
+        const float docNorm = norm(doc);
+        if (dot > 0.0f && docNorm > 0.0f) {
+            top.offer(dot / (docNorm * queryNorm), doc);
+        }
+    }
+    return top.sorted();
+}
+
+void TfIdfIndex::rebuild() {
+    // Drop terms no live document uses and renumber the rest
+    std::vector<uint32_t> remap(df_.size(), kNoTerm);
+    std::vector<uint32_t> df;
+    for (auto it = termIds_.begin(); it != termIds_.end();) {
+        if (df_[it->second] == 0) {
+            it = termIds_.erase(it);
+            continue;
+        }
+        remap[it->second] = static_cast<uint32_t>(df.size());
+        df.push_back(df_[it->second]);
+        it->second = remap[it->second];
+        ++it;
+    }
+    df_ = std::move(df);
+
+    // Forward index without removed documents, norms from the current idf
+    const uint32_t docCount = static_cast<uint32_t>(live_.size());
+    std::vector<uint32_t> docStart(docCount + 1, 0);
+    std::vector<uint32_t> docTerms;
+    std::vector<uint16_t> docTfs;
+    docTerms.reserve(docTerms_.size());
+    docTfs.reserve(docTfs_.size());
+    for (uint32_t doc = 0; doc < docCount; doc++) {
+        if (live_[doc]) {
+            for (uint32_t i = docStart_[doc]; i < docStart_[doc + 1]; i++) {
+                docTerms.push_back(remap[docTerms_[i]]);
+                docTfs.push_back(docTfs_[i]);
+            }
+        }
+        docStart[doc + 1] = static_cast<uint32_t>(docTerms.size());
+    }
+    docStart_ = std::move(docStart);
+    docTerms_ = std::move(docTerms);
+    docTfs_ = std::move(docTfs);
+    for (uint32_t doc = 0; doc < docCount; doc++) {
+        norms_[doc] = live_[doc] ? norm(doc) : 0.0f;
+    }
+
+    // Inverted index by counting sort on term; documents stay ascending per term
+    std::vector<uint32_t> termStart(df_.size() + 1, 0);
+    for (uint32_t term : docTerms_) {
+        termStart[term + 1]++;
+    }
+    for (size_t t = 0; t < df_.size(); t++) {
+        termStart[t + 1] += termStart[t];
+    }
+    std::vector<uint32_t> fill(termStart.begin(), termStart.end() - 1);
+    postingDocs_.assign(docTerms_.size(), 0);
+    postingWeights_.assign(docTerms_.size(), 0.0f);
+    for (uint32_t doc = 0; doc < docCount; doc++) {
+        for (uint32_t i = docStart_[doc]; i < docStart_[doc + 1]; i++) {
+            const uint32_t slot = fill[docTerms_[i]]++;
+            postingDocs_[slot] = doc;
+            postingWeights_[slot] = static_cast<float>(docTfs_[i]) / norms_[doc];
+        }
+    }
+    termStart_ = std::move(termStart);
+    indexedDocs_ = docCount;
+    removedCount_ = 0;
+}
+
+} // namespace rag
+} // namespace iris
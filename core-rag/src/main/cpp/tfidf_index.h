@@ -0,0 +1,120 @@
+#ifndef IRIS_RAG_TFIDF_INDEX_H
+#define IRIS_RAG_TFIDF_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "hnsw_index.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Sparse TF-IDF vectors ranked by cosine similarity.
+ *
+ * Text is split by tokenize(); stop words and terms shorter than
+ * `minTermChars` characters are dropped (single Han or kana characters are
+ * kept). Terms are interned to dense IDs. A document's weight for term t is
+ * tf * idf(t), with the smoothed idf(t) = ln((N + 1) / (df(t) + 1)) + 1 over
+ * the N live documents.
+ *
+ * Documents are stored twice, both in CSR form: a forward index (term IDs and
+ * counts per document) and an inverted index (document IDs and tf / |d| per
+ * term), where |d| is the document's norm. search() is term-at-a-time over the
+ * inverted index into a dense accumulator, applying the current idf of each
+ * query term, so adds and removes only update document frequencies.
+ *
+ * Documents added since the inverted index was last built sit in a tail that
+ * is scored from the forward index. The inverted index is rebuilt, and removed
+ * documents dropped, once the tail or the removed documents exceed a quarter
+ * of the indexed ones, so adds cost amortized O(terms). Norms are computed
+ * when a document is added or the index is rebuilt; between rebuilds they lag
+ * the idf of at most a quarter of the corpus. exhaustiveSearch() scores with
+ * fresh norms and is the reference.
+ *
+ * Document IDs must be added in increasing order and index dense arrays, so
+ * they should be small (e.g. a running counter). Adds, removes and searches
+ * may run concurrently.
+ */
+class TfIdfIndex {
+public:
+    /**
+     * @param stopWords Lowercase terms never indexed or queried
+     * @param minTermChars Shortest term kept, in characters
+     */
+    TfIdfIndex(const std::vector<std::string>& stopWords, size_t minTermChars);
+
+    /**
+     * Index `text` under `doc`, which must be greater than every doc added before
+     */
+    void add(int32_t doc, std::string_view text);
+
+    bool remove(int32_t doc);
+
+    size_t size() const;
+
+    size_t termCount() const;
+
+    /**
+     * Bytes held by the dictionary, both CSR indexes and per-document arrays
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * Top-k live documents by cosine similarity to the query; only documents
+     * sharing a term with it (score > 0) are returned
+     */
+    std::vector<SearchHit> search(std::string_view query, int k) const;
+
+    /**
+     * Same ranking as search() with every document's norm recomputed from the
+     * current idf; the baseline for benchmarks and tests
+     */
+    std::vector<SearchHit> exhaustiveSearch(std::string_view query, int k) const;
+
+private:
+    struct QueryTerm {
+        uint32_t term;
+        float weight; // tf * idf in the query
+        float idf;
+    };
+
+    const std::unordered_set<std::string> stopWords_;
+    const size_t minTermChars_;
+
+    mutable std::shared_mutex mutex_;
+    std::unordered_map<std::string, uint32_t> termIds_;
+    std::vector<uint32_t> df_; // live documents containing each term
+
+    // Forward index: docStart_[d] .. docStart_[d + 1] into docTerms_ / docTfs_
+    std::vector<uint32_t> docStart_;
+    std::vector<uint32_t> docTerms_;
+    std::vector<uint16_t> docTfs_;
+    std::vector<float> norms_;
+    std::vector<uint8_t> live_;
+    uint32_t liveCount_ = 0;
+    uint32_t removedCount_ = 0; // removed since the last rebuild
+
+    // Inverted index over docs below indexedDocs_: termStart_[t] .. termStart_[t + 1]
+    std::vector<uint32_t> termStart_;
+    std::vector<uint32_t> postingDocs_;
+    std::vector<float> postingWeights_; // tf / |d|
+    uint32_t indexedDocs_ = 0;
+
+    std::vector<std::pair<std::string, uint16_t>> terms(std::string_view text) const;
+    float idf(uint32_t term) const;
+    float norm(uint32_t doc) const;
+    std::vector<QueryTerm> queryTerms(std::string_view query, float& queryNorm) const;
+    void rebuild();
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_TFIDF_INDEX_H
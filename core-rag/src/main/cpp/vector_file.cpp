@@ -0,0 +1,1561 @@
+#include "vector_file.h"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "exact_scan.h"
+#include "vector_kernels.h"
+
+#define LOG_TAG "IrisVectorFile"
+#include "rag_log.h"
+
+namespace iris {
+namespace rag {
+
+namespace {
+
+constexpr char kMagic[8] = {'I', 'R', 'I', 'S', 'V', 'E', 'C', '1'};
+constexpr uint32_t kVersion = 2;
+constexpr size_t kHeaderSize = 4096;
+constexpr size_t kFingerprintMax = 255;
+constexpr uint64_t kInitialCapacity = 1024;
+
+constexpr uint32_t kWalMagic = 0x4c575249; // "IRWL"
+constexpr uint32_t kWalAppend = 1;
+constexpr uint32_t kWalDelete = 2;
+// Checkpoint once the WAL holds this much, so replay after a crash stays short
+constexpr uint64_t kWalCheckpointBytes = 8u << 20;
+
+constexpr size_t kStringsMinMap = 1u << 20;
+
+// Rows copied out per lock hold when feeding an index
+constexpr size_t kIndexSlice = 4096;
+
+constexpr uint8_t kFlagDeleted = 1;
+
+// Metadata columns in file order; each column is `capacity` entries, 64-byte aligned
+enum Column {
+    kStringOffset, kIdLength, kDocumentLength, kContentLength, kMetadataLength, kStart, kEnd, kScale, kFlags,
+    kColumnCount
+};
+constexpr size_t kColumnWidth[kColumnCount] = {8, 4, 4, 4, 4, 4, 4, 4, 1};
+
+struct WalRecord {
+    uint32_t magic;
+    uint32_t type;
+    uint32_t size; // payload bytes following this header
+    uint32_t crc;  // CRC-32 of the payload
+};
+
+// Append payload; followed by `dim` floats and the four strings back to back
+struct WalAppendPayload {
+    uint32_t row;
+    int32_t start;
+    int32_t end;
+    uint32_t idLength;
+    uint32_t documentLength;
+    uint32_t contentLength;
+    uint32_t metadataLength;
+    uint32_t reserved;
+    uint64_t stringOffset;
+};
+
+struct WalDeletePayload {
+    uint32_t row;
+};
+
+uint32_t crc32(const uint8_t* data, size_t size) {
+    static const auto table = [] {
+        std::array<uint32_t, 256> t{};
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++) {
+                c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+            }
+            t[i] = c;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+    }
+    return crc ^ 0xffffffffu;
+}
+
+uint64_t alignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+std::runtime_error ioError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+void writeFully(int fd, const void* data, size_t size, uint64_t offset, const std::string& path) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    while (size > 0) {
+        const ssize_t written = ::pwrite(fd, bytes, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            throw ioError("Write failed", path);
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+}
+
+void syncDirectory(const std::string& directory) {
+    const int fd = ::open(directory.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd >= 0) {
+        ::fsync(fd);
+        ::close(fd);
+    }
+}
+
+bool fileExists(const std::string& path) {
+    struct stat st {};
+    return ::stat(path.c_str(), &st) == 0;
+}
+
+// FNV-1a; only compared within one document's rows, never persisted
+uint64_t contentHash(const char* data, size_t size) {
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ static_cast<uint8_t>(data[i])) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+constexpr int64_t kMillisPerDay = 86400000;
+
+// Days since the epoch, rounding down for times before it
+int64_t dayOf(int64_t millis) {
+    return millis >= 0 ? millis / kMillisPerDay : -((-(millis + 1)) / kMillisPerDay) - 1;
+}
+
+void appendUtf8(std::string& out, uint32_t codepoint) {
+    if (codepoint < 0x80) {
+        out += static_cast<char>(codepoint);
+    } else if (codepoint < 0x800) {
+        out += static_cast<char>(0xC0 | (codepoint >> 6));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else if (codepoint < 0x10000) {
+        out += static_cast<char>(0xE0 | (codepoint >> 12));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (codepoint >> 18));
+        out += static_cast<char>(0x80 | ((codepoint >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((codepoint >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (codepoint & 0x3F));
+    }
+}
+
+bool parseHex4(std::string_view json, size_t at, uint32_t& value) {
+    if (at + 4 > json.size()) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = at; i < at + 4; i++) {
+        const char c = json[i];
+        value <<= 4;
+        if (c >= '0' && c <= '9') value |= c - '0';
+        else if (c >= 'a' && c <= 'f') value |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') value |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+// Decode the JSON string whose opening quote is at `at`; leaves `at` past the closing quote
+bool parseJsonString(std::string_view json, size_t& at, std::string& out) {
+    out.clear();
+    for (at++; at < json.size(); at++) {
+        const char c = json[at];
+        if (c == '"') {
+            at++;
+            return true;
+        }
+        if (c != '\\') {
+            out += c;
+            continue;
+        }
+        if (++at >= json.size()) {
+            return false;
+        }
+        switch (json[at]) {
+        case 'b': out += '\b'; break;
+        case 'f': out += '\f'; break;
+        case 'n': out += '\n'; break;
+        case 'r': out += '\r'; break;
+        case 't': out += '\t'; break;
+        case 'u': {
+            uint32_t codepoint;
+            if (!parseHex4(json, at + 1, codepoint)) {
+                return false;
+            }
+            at += 4;
+            uint32_t low;
+            if (codepoint >= 0xD800 && codepoint < 0xDC00 && at + 2 < json.size() && json[at + 1] == '\\' &&
+                json[at + 2] == 'u' && parseHex4(json, at + 3, low) && low >= 0xDC00 && low < 0xE000) {
+                codepoint = 0x10000 + ((codepoint - 0xD800) << 10) + (low - 0xDC00);
+                at += 6;
+            }
+            appendUtf8(out, codepoint);
+            break;
+        }
+        default: out += json[at]; break; // \" \\ \/
+        }
+    }
+    return false;
+}
+
+/**
+ * String value of `key` in the flat JSON object Kotlin writes as chunk metadata
+ */
+bool metadataField(std::string_view json, const char* key, std::string& value) {
+    auto skipSpace = [&](size_t& at) {
+        while (at < json.size() && (json[at] == ' ' || json[at] == '\n' || json[at] == '\r' || json[at] == '\t')) at++;
+    };
+    size_t at = 0;
+    skipSpace(at);
+    if (at >= json.size() || json[at++] != '{') {
+        return false;
+    }
+    std::string name;
+    while (true) {
+        skipSpace(at);
+        if (at >= json.size() || json[at] != '"' || !parseJsonString(json, at, name)) {
+            return false;
+        }
+        skipSpace(at);
+        if (at >= json.size() || json[at++] != ':') {
+            return false;
+        }
+        skipSpace(at);
+        if (at < json.size() && json[at] == '"') {
+            if (!parseJsonString(json, at, value)) {
+                return false;
+            }
+            if (name == key) {
+                return true;
+            }
+        } else {
+            // Non-string scalar: skip it
+            while (at < json.size() && json[at] != ',' && json[at] != '}') at++;
+        }
+        skipSpace(at);
+        if (at >= json.size() || json[at] != ',') {
+            return false;
+        }
+        at++;
+    }
+}
+
+bool parseMillis(const std::string& text, int64_t& millis) {
+    if (text.empty()) {
+        return false;
+    }
+    char* end = nullptr;
+    millis = std::strtoll(text.c_str(), &end, 10);
+    return end != text.c_str();
+}
+
+template <typename T>
+void appendBytes(std::vector<uint8_t>& out, const T* data, size_t count) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    out.insert(out.end(), bytes, bytes + count * sizeof(T));
+}
+
+} // namespace
+
+struct VectorFile::Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t dim;
+    uint32_t quantization;
+    uint32_t reserved;
+    uint64_t capacity;
+    uint64_t rowCount;    // rows covered by the last checkpoint
+    uint64_t stringBytes; // string heap bytes covered by the last checkpoint
+    uint32_t fingerprintLength;
+    char fingerprint[kFingerprintMax + 1];
+    uint32_t crc; // CRC-32 of every preceding header byte
+};
+
+struct VectorFile::Columns {
+    uint64_t* stringOffset;
+    uint32_t* idLength;
+    uint32_t* documentLength;
+    uint32_t* contentLength;
+    uint32_t* metadataLength;
+    int32_t* start;
+    int32_t* end;
+    float* scale; // int8 code scale
+    uint8_t* flags;
+};
+
+namespace {
+
+struct Layout {
+    uint64_t columnOffset[kColumnCount];
+    uint64_t codeOffset; // page-aligned so the code region can be advised separately
+    uint64_t totalSize;
+};
+
+Layout layoutFor(uint64_t capacity, size_t rowStride, size_t codeStride) {
+    Layout layout{};
+    uint64_t offset = alignUp(kHeaderSize + capacity * rowStride, 64);
+    for (int c = 0; c < kColumnCount; c++) {
+        layout.columnOffset[c] = offset;
+        offset = alignUp(offset + capacity * kColumnWidth[c], 64);
+    }
+    layout.codeOffset = alignUp(offset, kHeaderSize);
+    layout.totalSize = alignUp(layout.codeOffset + capacity * codeStride, kHeaderSize);
+    return layout;
+}
+
+size_t codeStrideFor(Quantization quantization, int dim) {
+    switch (quantization) {
+    case Quantization::kInt8:
+        return static_cast<size_t>(dim);
+    case Quantization::kBinary:
+        return (static_cast<size_t>(dim) + 63) / 64 * sizeof(uint64_t);
+    case Quantization::kNone:
+        break;
+    }
+    return 0;
+}
+
+const char* quantizationName(Quantization quantization) {
+    switch (quantization) {
+    case Quantization::kInt8:
+        return "int8";
+    case Quantization::kBinary:
+        return "binary";
+    case Quantization::kNone:
+        break;
+    }
+    return "none";
+}
+
+} // namespace
+
+VectorFile::VectorFile(std::string directory, int dim, std::string fingerprint)
+    : directory_(std::move(directory)),
+      dim_(dim),
+      fingerprint_(std::move(fingerprint)),
+      rowStride_(static_cast<size_t>(dim) * sizeof(float)) {
+    static_assert(sizeof(Header) <= kHeaderSize, "header must fit in its page");
+}
+
+uint32_t VectorFile::headerCrc(const Header* header) {
+    return crc32(reinterpret_cast<const uint8_t*>(header), offsetof(Header, crc));
+}
+
+std::unique_ptr<VectorFile> VectorFile::open(const std::string& directory, int dim,
+                                             const std::string& fingerprint, bool resetOnMismatch,
+                                             std::optional<Quantization> quantization) {
+    if (fingerprint.size() > kFingerprintMax) {
+        throw std::invalid_argument("Model fingerprint longer than 255 bytes");
+    }
+    if (::mkdir(directory.c_str(), 0700) != 0 && errno != EEXIST) {
+        throw ioError("Cannot create", directory);
+    }
+
+    const std::string mainPath = directory + "/store.vec";
+    bool exists = fileExists(mainPath);
+    if (exists) {
+        Header stored{};
+        const int fd = ::open(mainPath.c_str(), O_RDONLY | O_CLOEXEC);
+        const bool readable = fd >= 0 && ::pread(fd, &stored, sizeof(stored), 0) == static_cast<ssize_t>(sizeof(stored));
+        if (fd >= 0) ::close(fd);
+
+        std::string reason;
+        if (!readable || std::memcmp(stored.magic, kMagic, sizeof(kMagic)) != 0 ||
+            stored.crc != headerCrc(&stored) || stored.fingerprintLength > kFingerprintMax ||
+            stored.quantization > static_cast<uint32_t>(Quantization::kBinary)) {
+            reason = "unreadable header";
+        } else if (stored.version != kVersion) {
+            reason = "format version " + std::to_string(stored.version);
+        } else if (dim != 0 && static_cast<int>(stored.dim) != dim) {
+            reason = "dimension " + std::to_string(stored.dim) + " != " + std::to_string(dim);
+        } else if (std::string(stored.fingerprint, stored.fingerprintLength) != fingerprint) {
+            reason = "written by model '" + std::string(stored.fingerprint, stored.fingerprintLength) + "'";
+        } else {
+            dim = static_cast<int>(stored.dim);
+        }
+
+        if (!reason.empty()) {
+            if (!resetOnMismatch) {
+                throw VectorFileMismatch("Incompatible vector store in " + directory + ": " + reason);
+            }
+            LOGW("Discarding vector store in %s: %s", directory.c_str(), reason.c_str());
+            for (const char* name : {"/store.vec", "/store.str", "/store.wal"}) {
+                ::unlink((directory + name).c_str());
+            }
+            exists = false;
+        }
+    }
+    if (dim <= 0) {
+        throw std::invalid_argument("Vector dimension required to create a store");
+    }
+
+    std::unique_ptr<VectorFile> file(new VectorFile(directory, dim, fingerprint));
+    if (!exists) {
+        file->setQuantization(quantization.value_or(Quantization::kNone));
+    }
+    file->initialize(!exists);
+    if (quantization && *quantization != file->quantization_) {
+        LOGI("Re-encoding vector store codes: %s -> %s", quantizationName(file->quantization_),
+             quantizationName(*quantization));
+        file->relayout(file->capacity_, *quantization);
+    }
+    LOGI("Opened vector store %s (dim=%d, quantization=%s, rows=%u, live=%u)", directory.c_str(), dim,
+         quantizationName(file->quantization_), file->rows_, file->live_);
+    return file;
+}
+
+VectorFile::~VectorFile() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    try {
+        if (mainMap_ != nullptr && walBytes_ > 0) {
+            checkpointLocked();
+        }
+    } catch (const std::exception& e) {
+        LOGE("Checkpoint on close failed: %s", e.what());
+    }
+    unmapMain();
+    if (stringsMap_ != nullptr) {
+        ::munmap(const_cast<uint8_t*>(stringsMap_), stringsMapped_);
+    }
+    for (int fd : {mainFd_, stringsFd_, walFd_}) {
+        if (fd >= 0) ::close(fd);
+    }
+}
+
+// ============================================================================
+// Opening, mapping and growth
+// ============================================================================
+
+std::string VectorFile::path(const char* name) const {
+    return directory_ + "/" + name;
+}
+
+void VectorFile::initialize(bool create) {
+    const int truncate = create ? O_TRUNC : 0;
+    mainFd_ = ::open(path("store.vec").c_str(), O_RDWR | O_CREAT | O_CLOEXEC | truncate, 0600);
+    stringsFd_ = ::open(path("store.str").c_str(), O_RDWR | O_CREAT | O_CLOEXEC | truncate, 0600);
+    walFd_ = ::open(path("store.wal").c_str(), O_RDWR | O_CREAT | O_CLOEXEC | truncate, 0600);
+    if (mainFd_ < 0 || stringsFd_ < 0 || walFd_ < 0) {
+        throw ioError("Cannot open store files in", directory_);
+    }
+
+    if (create) {
+        capacity_ = kInitialCapacity;
+        if (::ftruncate(mainFd_, static_cast<off_t>(layoutFor(capacity_, rowStride_, codeStride_).totalSize)) != 0) {
+            throw ioError("Cannot size", path("store.vec"));
+        }
+        mapMain();
+        Header* h = header();
+        std::memcpy(h->magic, kMagic, sizeof(kMagic));
+        h->version = kVersion;
+        h->dim = static_cast<uint32_t>(dim_);
+        h->quantization = static_cast<uint32_t>(quantization_);
+        h->capacity = capacity_;
+        h->fingerprintLength = static_cast<uint32_t>(fingerprint_.size());
+        std::memcpy(h->fingerprint, fingerprint_.data(), fingerprint_.size());
+        h->crc = headerCrc(h);
+        ::msync(mainMap_, kHeaderSize, MS_SYNC);
+        syncDirectory(directory_);
+        return;
+    }
+
+    struct stat st {};
+    if (::fstat(mainFd_, &st) != 0) {
+        throw ioError("Cannot stat", path("store.vec"));
+    }
+    Header stored{};
+    if (::pread(mainFd_, &stored, sizeof(stored), 0) != static_cast<ssize_t>(sizeof(stored))) {
+        throw ioError("Cannot read header of", path("store.vec"));
+    }
+    capacity_ = stored.capacity;
+    setQuantization(static_cast<Quantization>(stored.quantization));
+    if (static_cast<uint64_t>(st.st_size) < layoutFor(capacity_, rowStride_, codeStride_).totalSize ||
+        stored.rowCount > capacity_) {
+        throw std::runtime_error("Vector store file is truncated: " + path("store.vec"));
+    }
+    mapMain();
+    rows_ = static_cast<uint32_t>(stored.rowCount);
+    // Searches stream the code region; ask for it up front
+    const Layout layout = layoutFor(capacity_, rowStride_, codeStride_);
+    if (codeStride_ > 0) {
+        ::madvise(mainMap_ + layout.codeOffset, layout.totalSize - layout.codeOffset, MADV_WILLNEED);
+    }
+    stringBytes_ = stored.stringBytes;
+
+    const uint8_t* flags = columns().flags;
+    live_ = static_cast<uint32_t>(std::count_if(flags, flags + rows_, [](uint8_t f) { return !(f & kFlagDeleted); }));
+    mapStrings();
+    replayWal();
+}
+
+/**
+ * Build the per-document row lists on first use, so opening stays a few mmaps.
+ * Called under the shared lock; writers keep the lists current once built.
+ */
+void VectorFile::indexDocumentRows() const {
+    std::call_once(documentRowsOnce_, [this] {
+        const uint8_t* flags = columns().flags;
+        for (uint32_t row = 0; row < rows_; row++) {
+            if (!(flags[row] & kFlagDeleted)) {
+                documentRows_[readDocumentIdLocked(row)].push_back(row);
+            }
+        }
+        documentRowsBuilt_ = true;
+    });
+}
+
+/**
+ * Build the tag and day bitmaps on first use; same contract as indexDocumentRows()
+ */
+void VectorFile::indexFacets() const {
+    std::call_once(facetsOnce_, [this] {
+        const uint8_t* flags = columns().flags;
+        for (uint32_t row = 0; row < rows_; row++) {
+            if (!(flags[row] & kFlagDeleted)) {
+                const std::string_view metadata = metadataAt(row);
+                updateFacets(row, metadata.data(), metadata.size(), true);
+            }
+        }
+        facetsBuilt_ = true;
+    });
+}
+
+void VectorFile::updateFacets(uint32_t row, const char* metadata, size_t length, bool add) const {
+    auto update = [&](RowBitmap& rows) {
+        if (add) {
+            rows.add(row);
+        } else {
+            rows.remove(row);
+        }
+    };
+    const std::string_view json(metadata, length);
+    std::string value;
+    if (metadataField(json, kTagsMetadataKey, value)) {
+        size_t start = 0;
+        while (start <= value.size()) {
+            size_t end = value.find(',', start);
+            if (end == std::string::npos) end = value.size();
+            size_t first = start, last = end;
+            while (first < last && value[first] == ' ') first++;
+            while (last > first && value[last - 1] == ' ') last--;
+            if (first < last) {
+                const std::string tag = value.substr(first, last - first);
+                if (add) {
+                    update(tagRows_[tag]);
+                } else if (auto it = tagRows_.find(tag); it != tagRows_.end()) {
+                    update(it->second);
+                    if (it->second.empty()) tagRows_.erase(it);
+                }
+            }
+            start = end + 1;
+        }
+    }
+    int64_t millis;
+    if (metadataField(json, kModifiedMetadataKey, value) && parseMillis(value, millis)) {
+        const int64_t day = dayOf(millis);
+        if (add) {
+            update(dayRows_[day]);
+        } else if (auto it = dayRows_.find(day); it != dayRows_.end()) {
+            update(it->second);
+            if (it->second.empty()) dayRows_.erase(it);
+        }
+    }
+}
+
+std::string_view VectorFile::metadataAt(uint32_t row) const {
+    const Columns c = columns();
+    const uint64_t offset = c.stringOffset[row] + c.idLength[row] + c.documentLength[row] + c.contentLength[row];
+    if (offset + c.metadataLength[row] > stringBytes_) {
+        throw std::runtime_error("String heap reference out of range");
+    }
+    return std::string_view(reinterpret_cast<const char*>(stringsMap_ + offset), c.metadataLength[row]);
+}
+
+void VectorFile::mapMain() {
+    mainSize_ = layoutFor(capacity_, rowStride_, codeStride_).totalSize;
+    void* map = ::mmap(nullptr, mainSize_, PROT_READ | PROT_WRITE, MAP_SHARED, mainFd_, 0);
+    if (map == MAP_FAILED) {
+        mainMap_ = nullptr;
+        throw ioError("Cannot map", path("store.vec"));
+    }
+    mainMap_ = static_cast<uint8_t*>(map);
+}
+
+void VectorFile::unmapMain() {
+    if (mainMap_ != nullptr) {
+        ::munmap(mainMap_, mainSize_);
+        mainMap_ = nullptr;
+    }
+}
+
+void VectorFile::mapStrings() {
+    if (stringBytes_ <= stringsMapped_ && stringsMap_ != nullptr) {
+        return;
+    }
+    // Map past EOF with headroom so most appends do not remap; only bytes
+    // below stringBytes_ are ever touched
+    size_t size = kStringsMinMap;
+    while (size < stringBytes_) size *= 2;
+
+    void* map = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, stringsFd_, 0);
+    if (map == MAP_FAILED) {
+        throw ioError("Cannot map", path("store.str"));
+    }
+    if (stringsMap_ != nullptr) {
+        ::munmap(const_cast<uint8_t*>(stringsMap_), stringsMapped_);
+    }
+    stringsMap_ = static_cast<const uint8_t*>(map);
+    stringsMapped_ = size;
+}
+
+void VectorFile::setQuantization(Quantization quantization) {
+    quantization_ = quantization;
+    codeStride_ = codeStrideFor(quantization, dim_);
+}
+
+void VectorFile::growTo(uint64_t minCapacity) {
+    if (minCapacity > capacity_) {
+        relayout(std::max(minCapacity, capacity_ * 2), quantization_);
+    }
+}
+
+/**
+ * Re-lay the main file out at a new capacity and/or code type. The copy is
+ * written to a temporary file and renamed over the original, so a crash
+ * leaves the old file (plus the WAL) intact.
+ */
+void VectorFile::relayout(uint64_t capacity, Quantization quantization) {
+    const size_t codeStride = codeStrideFor(quantization, dim_);
+    const Layout oldLayout = layoutFor(capacity_, rowStride_, codeStride_);
+    const Layout newLayout = layoutFor(capacity, rowStride_, codeStride);
+    const std::string tmpPath = path("store.vec.tmp");
+
+    const int fd = ::open(tmpPath.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0 || ::ftruncate(fd, static_cast<off_t>(newLayout.totalSize)) != 0) {
+        if (fd >= 0) ::close(fd);
+        throw ioError("Cannot create", tmpPath);
+    }
+    void* map = ::mmap(nullptr, newLayout.totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        ::close(fd);
+        throw ioError("Cannot map", tmpPath);
+    }
+    auto* target = static_cast<uint8_t*>(map);
+
+    std::memcpy(target, mainMap_, kHeaderSize);
+    auto* h = reinterpret_cast<Header*>(target);
+    h->capacity = capacity;
+    h->quantization = static_cast<uint32_t>(quantization);
+    h->crc = headerCrc(h);
+    std::memcpy(target + kHeaderSize, mainMap_ + kHeaderSize, static_cast<size_t>(rows_) * rowStride_);
+    for (int c = 0; c < kColumnCount; c++) {
+        std::memcpy(target + newLayout.columnOffset[c], mainMap_ + oldLayout.columnOffset[c],
+                    static_cast<size_t>(rows_) * kColumnWidth[c]);
+    }
+    if (quantization == quantization_) {
+        std::memcpy(target + newLayout.codeOffset, mainMap_ + oldLayout.codeOffset,
+                    static_cast<size_t>(rows_) * codeStride);
+    }
+    ::msync(target, newLayout.totalSize, MS_SYNC);
+    ::munmap(target, newLayout.totalSize);
+
+    if (::fsync(fd) != 0 || ::rename(tmpPath.c_str(), path("store.vec").c_str()) != 0) {
+        ::close(fd);
+        throw ioError("Cannot replace", path("store.vec"));
+    }
+    syncDirectory(directory_);
+
+    unmapMain();
+    ::close(mainFd_);
+    mainFd_ = fd;
+    capacity_ = capacity;
+    const bool reencode = quantization != quantization_;
+    setQuantization(quantization);
+    mapMain();
+
+    if (reencode) {
+        for (uint32_t row = 0; row < rows_; row++) {
+            encodeRow(row);
+        }
+        ::msync(mainMap_, mainSize_, MS_SYNC);
+    }
+    LOGI("Laid out vector store for %llu rows (%s codes)", static_cast<unsigned long long>(capacity),
+         quantizationName(quantization_));
+}
+
+/**
+ * Derive the quantized code (and int8 scale) for a row from its f32 vector
+ */
+void VectorFile::encodeRow(uint32_t row) {
+    uint8_t* code = const_cast<uint8_t*>(codeAt(row));
+    switch (quantization_) {
+    case Quantization::kInt8:
+        columns().scale[row] = kernels::quantizeI8(vectorAt(row), reinterpret_cast<int8_t*>(code), dim_);
+        break;
+    case Quantization::kBinary:
+        kernels::binarize(vectorAt(row), reinterpret_cast<uint64_t*>(code), dim_);
+        break;
+    case Quantization::kNone:
+        break;
+    }
+}
+
+// ============================================================================
+// Write-ahead log
+// ============================================================================
+
+void VectorFile::replayWal() {
+    struct stat st {};
+    if (::fstat(walFd_, &st) != 0) {
+        throw ioError("Cannot stat", path("store.wal"));
+    }
+    if (st.st_size == 0) {
+        return;
+    }
+
+    std::vector<uint8_t> wal(static_cast<size_t>(st.st_size));
+    size_t read = 0;
+    while (read < wal.size()) {
+        const ssize_t n = ::pread(walFd_, wal.data() + read, wal.size() - read, static_cast<off_t>(read));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            break;
+        }
+        read += static_cast<size_t>(n);
+    }
+
+    const size_t valid = applyWal(wal.data(), read);
+    if (valid < wal.size()) {
+        LOGW("Ignoring %zu bytes of torn WAL tail", wal.size() - valid);
+    }
+    checkpointLocked();
+}
+
+/**
+ * Apply consecutive well-formed records; returns the number of bytes consumed.
+ * Records carry their target row and string offset, so replaying a record that
+ * was already applied rewrites the same bytes.
+ */
+size_t VectorFile::applyWal(const uint8_t* data, size_t size) {
+    size_t offset = 0;
+    size_t applied = 0;
+    while (offset + sizeof(WalRecord) <= size) {
+        WalRecord record;
+        std::memcpy(&record, data + offset, sizeof(record));
+        const uint8_t* payload = data + offset + sizeof(record);
+        if (record.magic != kWalMagic || record.size > size - offset - sizeof(record) ||
+            crc32(payload, record.size) != record.crc) {
+            break;
+        }
+
+        if (record.type == kWalAppend && record.size >= sizeof(WalAppendPayload) + rowStride_) {
+            WalAppendPayload append;
+            std::memcpy(&append, payload, sizeof(append));
+            const uint64_t stringLength = static_cast<uint64_t>(append.idLength) + append.documentLength +
+                                          append.contentLength + append.metadataLength;
+            if (sizeof(append) + rowStride_ + stringLength != record.size) {
+                break;
+            }
+            applyAppend(payload);
+        } else if (record.type == kWalDelete && record.size == sizeof(WalDeletePayload)) {
+            WalDeletePayload remove;
+            std::memcpy(&remove, payload, sizeof(remove));
+            applyDelete(remove.row);
+        } else {
+            break;
+        }
+        offset += sizeof(record) + record.size;
+        applied++;
+    }
+    if (applied > 0) {
+        mapStrings();
+    }
+    return offset;
+}
+
+void VectorFile::writeWal(const std::vector<uint8_t>& records) {
+    writeFully(walFd_, records.data(), records.size(), walBytes_, path("store.wal"));
+    if (::fdatasync(walFd_) != 0) {
+        throw ioError("Cannot sync", path("store.wal"));
+    }
+    walBytes_ += records.size();
+}
+
+void VectorFile::applyAppend(const uint8_t* payload) {
+    WalAppendPayload append;
+    std::memcpy(&append, payload, sizeof(append));
+    const uint8_t* vector = payload + sizeof(append);
+    const uint8_t* strings = vector + rowStride_;
+    growTo(static_cast<uint64_t>(append.row) + 1);
+
+    const size_t stringLength = static_cast<size_t>(append.idLength) + append.documentLength +
+                                append.contentLength + append.metadataLength;
+    writeFully(stringsFd_, strings, stringLength, append.stringOffset, path("store.str"));
+    stringBytes_ = std::max<uint64_t>(stringBytes_, append.stringOffset + stringLength);
+
+    std::memcpy(mainMap_ + kHeaderSize + static_cast<size_t>(append.row) * rowStride_, vector, rowStride_);
+    Columns c = columns();
+    const uint32_t row = append.row;
+    const bool wasLive = row < rows_ && !(c.flags[row] & kFlagDeleted);
+    c.stringOffset[row] = append.stringOffset;
+    c.idLength[row] = append.idLength;
+    c.documentLength[row] = append.documentLength;
+    c.contentLength[row] = append.contentLength;
+    c.metadataLength[row] = append.metadataLength;
+    c.start[row] = append.start;
+    c.end[row] = append.end;
+    c.flags[row] = 0;
+    encodeRow(row);
+
+    if (row >= rows_) {
+        // Rows past the old end that replay skipped stay tombstoned
+        for (uint32_t gap = rows_; gap < row; gap++) c.flags[gap] = kFlagDeleted;
+        rows_ = row + 1;
+    }
+    if (!wasLive) {
+        live_++;
+    }
+    if (!wasLive && documentRowsBuilt_) {
+        std::vector<uint32_t>& documentRows =
+            documentRows_[std::string(reinterpret_cast<const char*>(strings) + append.idLength, append.documentLength)];
+        documentRows.insert(std::upper_bound(documentRows.begin(), documentRows.end(), row), row);
+    }
+    if (!wasLive && facetsBuilt_) {
+        updateFacets(row,
+                     reinterpret_cast<const char*>(strings) + append.idLength + append.documentLength +
+                         append.contentLength,
+                     append.metadataLength, true);
+    }
+}
+
+void VectorFile::applyDelete(uint32_t row) {
+    Columns c = columns();
+    if (row < rows_ && !(c.flags[row] & kFlagDeleted)) {
+        c.flags[row] |= kFlagDeleted;
+        live_--;
+        if (!documentRowsBuilt_ && !facetsBuilt_) {
+            return;
+        }
+
+        mapStrings(); // the row may have been appended earlier in the same WAL batch
+        if (documentRowsBuilt_) {
+            auto it = documentRows_.find(readDocumentIdLocked(row));
+            if (it != documentRows_.end()) {
+                std::vector<uint32_t>& rows = it->second;
+                rows.erase(std::remove(rows.begin(), rows.end(), row), rows.end());
+                if (rows.empty()) {
+                    documentRows_.erase(it);
+                }
+            }
+        }
+        if (facetsBuilt_) {
+            const std::string_view metadata = metadataAt(row);
+            updateFacets(row, metadata.data(), metadata.size(), false);
+        }
+    }
+}
+
+void VectorFile::checkpointLocked() {
+    // Data first, then the header that makes it reachable, then drop the WAL
+    if (::msync(mainMap_, mainSize_, MS_SYNC) != 0 || ::fsync(stringsFd_) != 0) {
+        throw ioError("Cannot flush", directory_);
+    }
+    Header* h = header();
+    h->rowCount = rows_;
+    h->stringBytes = stringBytes_;
+    h->crc = headerCrc(h);
+    if (::msync(mainMap_, kHeaderSize, MS_SYNC) != 0) {
+        throw ioError("Cannot flush header of", path("store.vec"));
+    }
+    if (::ftruncate(walFd_, 0) != 0 || ::fsync(walFd_) != 0) {
+        throw ioError("Cannot truncate", path("store.wal"));
+    }
+    walBytes_ = 0;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+uint32_t VectorFile::rowCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return rows_;
+}
+
+uint32_t VectorFile::liveCount() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return live_;
+}
+
+std::vector<uint32_t> VectorFile::append(const std::vector<ChunkRecord>& records, const float* vectors) {
+    return appendRecords(records, vectors, true);
+}
+
+/**
+ * Encode records as WAL appends and apply them. Without `durable` the WAL
+ * write is skipped: for a compaction copy, which nothing reads until it has
+ * been checkpointed.
+ */
+std::vector<uint32_t> VectorFile::appendRecords(const std::vector<ChunkRecord>& records, const float* vectors,
+                                                bool durable) {
+    if (records.empty()) {
+        return {};
+    }
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+
+    std::vector<uint32_t> rows(records.size());
+    std::vector<uint8_t> wal;
+    std::vector<float> normalized(dim_);
+    uint64_t stringOffset = stringBytes_;
+    for (size_t i = 0; i < records.size(); i++) {
+        const ChunkRecord& r = records[i];
+        rows[i] = rows_ + static_cast<uint32_t>(i);
+        normalizeVector(vectors + i * dim_, normalized.data(), dim_);
+
+        WalAppendPayload append{};
+        append.row = rows[i];
+        append.start = r.startIndex;
+        append.end = r.endIndex;
+        append.idLength = static_cast<uint32_t>(r.id.size());
+        append.documentLength = static_cast<uint32_t>(r.documentId.size());
+        append.contentLength = static_cast<uint32_t>(r.content.size());
+        append.metadataLength = static_cast<uint32_t>(r.metadata.size());
+        append.stringOffset = stringOffset;
+        stringOffset += r.id.size() + r.documentId.size() + r.content.size() + r.metadata.size();
+
+        const size_t recordStart = wal.size();
+        wal.resize(recordStart + sizeof(WalRecord));
+        appendBytes(wal, &append, 1);
+        appendBytes(wal, normalized.data(), normalized.size());
+        for (const std::string* s : {&r.id, &r.documentId, &r.content, &r.metadata}) {
+            appendBytes(wal, s->data(), s->size());
+        }
+        WalRecord header{kWalMagic, kWalAppend, static_cast<uint32_t>(wal.size() - recordStart - sizeof(WalRecord)), 0};
+        header.crc = crc32(wal.data() + recordStart + sizeof(WalRecord), header.size);
+        std::memcpy(wal.data() + recordStart, &header, sizeof(header));
+    }
+
+    growTo(static_cast<uint64_t>(rows_) + records.size());
+    if (durable) {
+        writeWal(wal);
+    }
+    applyWal(wal.data(), wal.size());
+
+    if (walBytes_ >= kWalCheckpointBytes) {
+        checkpointLocked();
+    }
+    return rows;
+}
+
+void VectorFile::markDeleted(const std::vector<uint32_t>& rows) {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    std::vector<uint8_t> wal;
+    const Columns c = columns();
+    for (uint32_t row : rows) {
+        if (row >= rows_ || (c.flags[row] & kFlagDeleted)) {
+            continue;
+        }
+        const WalDeletePayload remove{row};
+        WalRecord header{kWalMagic, kWalDelete, sizeof(remove), 0};
+        header.crc = crc32(reinterpret_cast<const uint8_t*>(&remove), sizeof(remove));
+        appendBytes(wal, &header, 1);
+        appendBytes(wal, &remove, 1);
+    }
+    if (wal.empty()) {
+        return;
+    }
+    writeWal(wal);
+    applyWal(wal.data(), wal.size());
+}
+
+bool VectorFile::isDeleted(uint32_t row) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return row >= rows_ || (columns().flags[row] & kFlagDeleted);
+}
+
+void VectorFile::checkpoint() {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    checkpointLocked();
+}
+
+ChunkRecord VectorFile::readRecord(uint32_t row) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return readRecordLocked(row);
+}
+
+ChunkRecord VectorFile::readRecordLocked(uint32_t row) const {
+    checkRow(row);
+    const Columns c = columns();
+    uint64_t offset = c.stringOffset[row];
+    ChunkRecord record;
+    record.id = readString(offset, c.idLength[row]);
+    offset += c.idLength[row];
+    record.documentId = readString(offset, c.documentLength[row]);
+    offset += c.documentLength[row];
+    record.content = readString(offset, c.contentLength[row]);
+    offset += c.contentLength[row];
+    record.metadata = readString(offset, c.metadataLength[row]);
+    record.startIndex = c.start[row];
+    record.endIndex = c.end[row];
+    return record;
+}
+
+std::string VectorFile::readChunkId(uint32_t row) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    checkRow(row);
+    const Columns c = columns();
+    return readString(c.stringOffset[row], c.idLength[row]);
+}
+
+std::string VectorFile::readDocumentId(uint32_t row) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return readDocumentIdLocked(row);
+}
+
+std::string VectorFile::readDocumentIdLocked(uint32_t row) const {
+    checkRow(row);
+    const Columns c = columns();
+    return readString(c.stringOffset[row] + c.idLength[row], c.documentLength[row]);
+}
+
+std::vector<uint32_t> VectorFile::documentRows(const std::string& documentId) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    indexDocumentRows();
+    auto it = documentRows_.find(documentId);
+    return it == documentRows_.end() ? std::vector<uint32_t>() : it->second;
+}
+
+std::vector<uint32_t> VectorFile::deleteDocument(const std::string& documentId) {
+    std::vector<uint32_t> rows = documentRows(documentId);
+    // markDeleted skips rows another writer deleted in between
+    markDeleted(rows);
+    return rows;
+}
+
+std::vector<int32_t> VectorFile::matchContent(const std::string& documentId,
+                                              const std::vector<std::string>& contents) const {
+    std::vector<int32_t> matches(contents.size(), -1);
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    indexDocumentRows();
+    auto it = documentRows_.find(documentId);
+    if (it == documentRows_.end()) {
+        return matches;
+    }
+
+    const Columns c = columns();
+    std::unordered_multimap<uint64_t, uint32_t> byHash;
+    for (uint32_t row : it->second) {
+        const uint64_t offset = c.stringOffset[row] + c.idLength[row] + c.documentLength[row];
+        byHash.emplace(contentHash(reinterpret_cast<const char*>(stringsMap_ + offset), c.contentLength[row]), row);
+    }
+    for (size_t i = 0; i < contents.size(); i++) {
+        auto range = byHash.equal_range(contentHash(contents[i].data(), contents[i].size()));
+        for (auto candidate = range.first; candidate != range.second; ++candidate) {
+            const uint32_t row = candidate->second;
+            const uint64_t offset = c.stringOffset[row] + c.idLength[row] + c.documentLength[row];
+            if (c.contentLength[row] == contents[i].size() &&
+                std::memcmp(stringsMap_ + offset, contents[i].data(), contents[i].size()) == 0) {
+                matches[i] = static_cast<int32_t>(row);
+                byHash.erase(candidate);
+                break;
+            }
+        }
+    }
+    return matches;
+}
+
+RowBitmap VectorFile::filterRows(const RowFilter& filter) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::optional<RowBitmap> result;
+    auto restrict = [&](RowBitmap rows) {
+        if (result) {
+            *result &= rows;
+        } else {
+            result = std::move(rows);
+        }
+    };
+
+    if (!filter.documentIds.empty()) {
+        indexDocumentRows();
+        RowBitmap rows;
+        for (const std::string& documentId : filter.documentIds) {
+            auto it = documentRows_.find(documentId);
+            if (it != documentRows_.end()) rows |= RowBitmap::fromSorted(it->second);
+        }
+        restrict(std::move(rows));
+    }
+    if (!filter.tags.empty()) {
+        indexFacets();
+        RowBitmap rows;
+        for (const std::string& tag : filter.tags) {
+            auto it = tagRows_.find(tag);
+            if (it != tagRows_.end()) rows |= it->second;
+        }
+        restrict(std::move(rows));
+    }
+    if (filter.modifiedFrom != std::numeric_limits<int64_t>::min() ||
+        filter.modifiedTo != std::numeric_limits<int64_t>::max()) {
+        indexFacets();
+        const int64_t firstDay = dayOf(filter.modifiedFrom);
+        const int64_t lastDay = dayOf(filter.modifiedTo);
+        RowBitmap rows;
+        std::string value;
+        for (auto it = dayRows_.lower_bound(firstDay); it != dayRows_.end() && it->first <= lastDay; ++it) {
+            if (it->first != firstDay && it->first != lastDay) {
+                rows |= it->second;
+                continue;
+            }
+            // The bounds fall inside these days; check each row's own time
+            for (uint32_t row : it->second.rows()) {
+                int64_t millis;
+                if (metadataField(metadataAt(row), kModifiedMetadataKey, value) && parseMillis(value, millis) &&
+                    millis >= filter.modifiedFrom && millis <= filter.modifiedTo) {
+                    rows.add(row);
+                }
+            }
+        }
+        restrict(std::move(rows));
+    }
+
+    if (result) {
+        return std::move(*result);
+    }
+    std::vector<uint32_t> live;
+    live.reserve(live_);
+    const uint8_t* flags = columns().flags;
+    for (uint32_t row = 0; row < rows_; row++) {
+        if (!(flags[row] & kFlagDeleted)) live.push_back(row);
+    }
+    return RowBitmap::fromSorted(live);
+}
+
+std::unique_ptr<VectorFile> VectorFile::compactInto(const std::string& directory, std::vector<int32_t>& rowMap) const {
+    if (directory == directory_) {
+        throw std::invalid_argument("Cannot compact a vector store into its own directory");
+    }
+    for (const char* name : {"/store.vec", "/store.str", "/store.wal"}) {
+        ::unlink((directory + name).c_str());
+    }
+    std::unique_ptr<VectorFile> target = open(directory, dim_, fingerprint_, false, quantization_);
+    {
+        std::unique_lock<std::shared_mutex> lock(target->mutex_);
+        target->growTo(liveCount());
+    }
+    rowMap.clear();
+    syncCompacted(*target, rowMap);
+    LOGI("Compacted vector store %s: %zu rows -> %u", directory_.c_str(), rowMap.size(), target->rowCount());
+    return target;
+}
+
+void VectorFile::syncCompacted(VectorFile& target, std::vector<int32_t>& rowMap) const {
+    if (&target == this || target.dim_ != dim_) {
+        throw std::invalid_argument("Compaction target must be another store of the same dimension");
+    }
+
+    // Rows deleted here since they were copied
+    std::vector<uint32_t> deleted;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        const uint8_t* flags = columns().flags;
+        for (size_t row = 0; row < rowMap.size(); row++) {
+            if (rowMap[row] >= 0 && (flags[row] & kFlagDeleted)) {
+                deleted.push_back(static_cast<uint32_t>(rowMap[row]));
+                rowMap[row] = -1;
+            }
+        }
+    }
+    target.markDeleted(deleted);
+
+    // Rows appended here since, a slice per lock hold
+    std::vector<ChunkRecord> records;
+    std::vector<float> vectors;
+    std::vector<uint32_t> sources;
+    while (true) {
+        records.clear();
+        sources.clear();
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            if (rowMap.size() >= rows_) {
+                break;
+            }
+            const uint32_t first = static_cast<uint32_t>(rowMap.size());
+            const uint32_t end = static_cast<uint32_t>(std::min<size_t>(rows_, first + kIndexSlice));
+            const uint8_t* flags = columns().flags;
+            vectors.resize(static_cast<size_t>(end - first) * dim_);
+            for (uint32_t row = first; row < end; row++) {
+                rowMap.push_back(-1);
+                if (flags[row] & kFlagDeleted) {
+                    continue;
+                }
+                std::memcpy(vectors.data() + records.size() * dim_, vectorAt(row), rowStride_);
+                records.push_back(readRecordLocked(row));
+                sources.push_back(row);
+            }
+        }
+        const std::vector<uint32_t> rows = target.appendRecords(records, vectors.data(), false);
+        for (size_t i = 0; i < rows.size(); i++) {
+            rowMap[sources[i]] = static_cast<int32_t>(rows[i]);
+        }
+    }
+    target.checkpoint();
+}
+
+void VectorFile::readVector(uint32_t row, float* out) const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    checkRow(row);
+    std::memcpy(out, vectorAt(row), rowStride_);
+}
+
+std::vector<uint32_t> VectorFile::liveRows() const {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    std::vector<uint32_t> rows;
+    rows.reserve(live_);
+    const uint8_t* flags = columns().flags;
+    for (uint32_t row = 0; row < rows_; row++) {
+        if (!(flags[row] & kFlagDeleted)) rows.push_back(row);
+    }
+    return rows;
+}
+
+std::vector<SearchHit> VectorFile::exactSearch(const float* query, int k, const RowBitmap* filter,
+                                               float threshold) const {
+    if (k <= 0) {
+        return {};
+    }
+    std::vector<float> normalized(dim_);
+    normalizeVector(query, normalized.data(), dim_);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const uint8_t* flags = columns().flags;
+    std::vector<uint64_t> allowed;
+    if (filter) {
+        filter->toDense(rows_, allowed);
+    }
+
+    // Same blocked scan as HnswIndex::exactSearch, reading the mapped arena in
+    // place; partitions of it run on the scan pool, each into its own heap
+    constexpr uint32_t kBlock = 256;
+    // A filtered block with fewer matches than this scores them one by one
+    constexpr int kSparseBlockRows = kBlock / 4;
+    auto scan = [&](uint32_t begin, uint32_t end, TopK& top) {
+        float scores[kBlock];
+        for (uint32_t first = begin; first < end; first += kBlock) {
+            const uint32_t blockSize = std::min<uint32_t>(kBlock, end - first);
+            if (filter) {
+                const uint64_t* words = allowed.data() + first / 64;
+                const size_t wordCount = (blockSize + 63) / 64;
+                int matches = 0;
+                for (size_t w = 0; w < wordCount; w++) matches += __builtin_popcountll(words[w]);
+                if (matches == 0) {
+                    continue;
+                }
+                if (matches < kSparseBlockRows) {
+                    for (size_t w = 0; w < wordCount; w++) {
+                        for (uint64_t word = words[w]; word; word &= word - 1) {
+                            const uint32_t row = first + static_cast<uint32_t>(w * 64 + __builtin_ctzll(word));
+                            if (!(flags[row] & kFlagDeleted)) {
+                                top.offer(kernels::dotF32(normalized.data(), vectorAt(row), dim_), row);
+                            }
+                        }
+                    }
+                    continue;
+                }
+            }
+            kernels::dotBlockF32(normalized.data(), vectorAt(first), blockSize, static_cast<size_t>(dim_), scores);
+            for (uint32_t i = 0; i < blockSize; i++) {
+                const uint32_t row = first + i;
+                if (scores[i] < top.floor() || (flags[row] & kFlagDeleted) ||
+                    (filter && !((allowed[row / 64] >> (row % 64)) & 1))) {
+                    continue;
+                }
+                top.offer(scores[i], row);
+            }
+        }
+    };
+    return parallelTopK(ScanPool::shared(), rows_, rowStride_, kBlock, k, threshold, scan);
+}
+
+std::vector<SearchHit> VectorFile::search(const float* query, int k, int candidates,
+                                          const RowBitmap* filter) const {
+    if (quantization_ == Quantization::kNone) {
+        return exactSearch(query, k, filter);
+    }
+    if (k <= 0) {
+        return {};
+    }
+    std::vector<float> normalized(dim_);
+    normalizeVector(query, normalized.data(), dim_);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const Columns c = columns();
+    const size_t shortlist = static_cast<size_t>(std::max(k, candidates));
+    if (filter && filter->cardinality() <= shortlist) {
+        // The whole filtered set fits in the shortlist; skip the code pass
+        std::vector<uint32_t> rows = filter->rows();
+        rows.erase(std::remove_if(rows.begin(), rows.end(),
+                                  [&](uint32_t row) { return row >= rows_ || (c.flags[row] & kFlagDeleted); }),
+                   rows.end());
+        return rescoreLocked(normalized.data(), std::move(rows), k);
+    }
+    std::vector<uint64_t> allowed;
+    if (filter) {
+        filter->toDense(rows_, allowed);
+    }
+    auto skipBlock = [&](uint32_t first, uint32_t blockSize) {
+        if (!filter) return false;
+        for (uint32_t w = first / 64; w < (first + blockSize + 63) / 64; w++) {
+            if (allowed[w]) return false;
+        }
+        return true;
+    };
+    auto admits = [&](uint32_t row) {
+        return !(c.flags[row] & kFlagDeleted) && (!filter || ((allowed[row / 64] >> (row % 64)) & 1));
+    };
+
+    // First pass over the codes; the heap keeps the `shortlist` smallest keys
+    using Entry = std::pair<float, uint32_t>; // (key, row): lower key is better
+    std::priority_queue<Entry> best;
+    auto offer = [&](float key, uint32_t row) {
+        if (best.size() < shortlist) {
+            best.push({key, row});
+        } else if (key < best.top().first) {
+            best.pop();
+            best.push({key, row});
+        }
+    };
+
+    constexpr uint32_t kBlock = 256;
+    if (quantization_ == Quantization::kInt8) {
+        std::vector<int8_t> code(dim_);
+        kernels::quantizeI8(normalized.data(), code.data(), dim_);
+        int32_t dots[kBlock];
+        for (uint32_t first = 0; first < rows_; first += kBlock) {
+            const uint32_t blockSize = std::min<uint32_t>(kBlock, rows_ - first);
+            if (skipBlock(first, blockSize)) {
+                continue;
+            }
+            kernels::dotBlockI8(code.data(), reinterpret_cast<const int8_t*>(codeAt(first)), blockSize,
+                                static_cast<size_t>(dim_), dots);
+            for (uint32_t i = 0; i < blockSize; i++) {
+                if (admits(first + i)) {
+                    offer(-static_cast<float>(dots[i]) * c.scale[first + i], first + i);
+                }
+            }
+        }
+    } else {
+        const size_t words = codeStride_ / sizeof(uint64_t);
+        std::vector<uint64_t> code(words);
+        kernels::binarize(normalized.data(), code.data(), dim_);
+        uint32_t distances[kBlock];
+        for (uint32_t first = 0; first < rows_; first += kBlock) {
+            const uint32_t blockSize = std::min<uint32_t>(kBlock, rows_ - first);
+            if (skipBlock(first, blockSize)) {
+                continue;
+            }
+            kernels::hammingBlock(code.data(), reinterpret_cast<const uint64_t*>(codeAt(first)), blockSize, words,
+                                  distances);
+            for (uint32_t i = 0; i < blockSize; i++) {
+                if (admits(first + i)) {
+                    offer(static_cast<float>(distances[i]), first + i);
+                }
+            }
+        }
+    }
+
+    // Second pass: exact scores from the f32 rows
+    std::vector<uint32_t> rows;
+    rows.reserve(best.size());
+    for (; !best.empty(); best.pop()) {
+        rows.push_back(best.top().second);
+    }
+    return rescoreLocked(normalized.data(), std::move(rows), k);
+}
+
+std::vector<SearchHit> VectorFile::rescore(const float* query, std::vector<uint32_t> rows, int k) const {
+    if (k <= 0) {
+        return {};
+    }
+    std::vector<float> normalized(dim_);
+    normalizeVector(query, normalized.data(), dim_);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const Columns c = columns();
+    rows.erase(std::remove_if(rows.begin(), rows.end(),
+                              [&](uint32_t row) { return row >= rows_ || (c.flags[row] & kFlagDeleted); }),
+               rows.end());
+    return rescoreLocked(normalized.data(), std::move(rows), k);
+}
+
+std::vector<SearchHit> VectorFile::rescoreLocked(const float* normalized, std::vector<uint32_t> rows, int k) const {
+    // Read in file order so the mapped pages are touched sequentially
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+
+    std::vector<SearchHit> hits;
+    hits.reserve(rows.size());
+    for (uint32_t row : rows) {
+        hits.push_back({static_cast<int32_t>(row), kernels::dotF32(normalized, vectorAt(row), dim_)});
+    }
+    const size_t keep = std::min(hits.size(), static_cast<size_t>(k));
+    std::partial_sort(hits.begin(), hits.begin() + keep, hits.end(),
+                      [](const SearchHit& a, const SearchHit& b) { return a.score > b.score; });
+    hits.resize(keep);
+    return hits;
+}
+
+void VectorFile::addToIndex(HnswIndex& index, const std::vector<uint32_t>& rows, int numThreads) const {
+    if (index.dimension() != dim_) {
+        throw std::invalid_argument("Index dimension does not match vector store");
+    }
+    // Copy out in slices so the store lock is not held while the graph is built
+    std::vector<int32_t> labels;
+    std::vector<float> vectors;
+    for (size_t first = 0; first < rows.size(); first += kIndexSlice) {
+        copyLiveSlice(rows, first, labels, vectors);
+        index.addBatch(labels.data(), vectors.data(), labels.size(), numThreads);
+    }
+}
+
+void VectorFile::addToIndex(IvfPqIndex& index, const std::vector<uint32_t>& rows) const {
+    if (index.dimension() != dim_) {
+        throw std::invalid_argument("Index dimension does not match vector store");
+    }
+    std::vector<int32_t> labels;
+    std::vector<float> vectors;
+    for (size_t first = 0; first < rows.size(); first += kIndexSlice) {
+        copyLiveSlice(rows, first, labels, vectors);
+        index.add(labels.data(), vectors.data(), labels.size());
+    }
+}
+
+void VectorFile::addToIndex(Bm25Index& index, const std::vector<uint32_t>& rows) const {
+    // Copy content out per slice; tokenizing happens without the store lock
+    std::vector<std::pair<int32_t, std::string>> slice;
+    for (size_t first = 0; first < rows.size(); first += kIndexSlice) {
+        const size_t count = std::min(kIndexSlice, rows.size() - first);
+        slice.clear();
+        {
+            std::shared_lock<std::shared_mutex> lock(mutex_);
+            const Columns c = columns();
+            for (size_t i = 0; i < count; i++) {
+                const uint32_t row = rows[first + i];
+                if (row >= rows_ || (c.flags[row] & kFlagDeleted)) continue;
+                const uint64_t offset = c.stringOffset[row] + c.idLength[row] + c.documentLength[row];
+                slice.emplace_back(static_cast<int32_t>(row), readString(offset, c.contentLength[row]));
+            }
+        }
+        for (const auto& entry : slice) {
+            index.add(entry.first, entry.second);
+        }
+    }
+}
+
+void VectorFile::trainIndex(IvfPqIndex& index, size_t maxSamples, int iterations, int numThreads) const {
+    if (index.dimension() != dim_) {
+        throw std::invalid_argument("Index dimension does not match vector store");
+    }
+    std::vector<uint32_t> rows = liveRows();
+    std::mt19937_64 rng(rows.size());
+    std::shuffle(rows.begin(), rows.end(), rng);
+    rows.resize(std::min(rows.size(), maxSamples));
+
+    std::vector<float> samples;
+    {
+        std::shared_lock<std::shared_mutex> lock(mutex_);
+        samples.resize(rows.size() * dim_);
+        for (size_t i = 0; i < rows.size(); i++) {
+            std::memcpy(samples.data() + i * dim_, vectorAt(rows[i]), rowStride_);
+        }
+    }
+    index.train(samples.data(), rows.size(), iterations, numThreads);
+}
+
+void VectorFile::copyLiveSlice(const std::vector<uint32_t>& rows, size_t first, std::vector<int32_t>& labels,
+                               std::vector<float>& vectors) const {
+    const size_t count = std::min(kIndexSlice, rows.size() - first);
+    labels.clear();
+    vectors.resize(count * dim_);
+
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    const uint8_t* flags = columns().flags;
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t row = rows[first + i];
+        if (row >= rows_ || (flags[row] & kFlagDeleted)) continue;
+        std::memcpy(vectors.data() + labels.size() * dim_, vectorAt(row), rowStride_);
+        labels.push_back(static_cast<int32_t>(row));
+    }
+}
+
+// ============================================================================
+// Mapping accessors
+// ============================================================================
+
+VectorFile::Header* VectorFile::header() const {
+    return reinterpret_cast<Header*>(mainMap_);
+}
+
+VectorFile::Columns VectorFile::columns() const {
+    const Layout layout = layoutFor(capacity_, rowStride_, codeStride_);
+    auto at = [&](Column c) { return mainMap_ + layout.columnOffset[c]; };
+    return {
+        reinterpret_cast<uint64_t*>(at(kStringOffset)),
+        reinterpret_cast<uint32_t*>(at(kIdLength)),
+        reinterpret_cast<uint32_t*>(at(kDocumentLength)),
+        reinterpret_cast<uint32_t*>(at(kContentLength)),
+        reinterpret_cast<uint32_t*>(at(kMetadataLength)),
+        reinterpret_cast<int32_t*>(at(kStart)),
+        reinterpret_cast<int32_t*>(at(kEnd)),
+        reinterpret_cast<float*>(at(kScale)),
+        at(kFlags),
+    };
+}
+
+const float* VectorFile::vectorAt(uint32_t row) const {
+    return reinterpret_cast<const float*>(mainMap_ + kHeaderSize + static_cast<size_t>(row) * rowStride_);
+}
+
+const uint8_t* VectorFile::codeAt(uint32_t row) const {
+    return mainMap_ + layoutFor(capacity_, rowStride_, codeStride_).codeOffset + static_cast<size_t>(row) * codeStride_;
+}
+
+void VectorFile::checkRow(uint32_t row) const {
+    if (row >= rows_) {
+        throw std::out_of_range("Row " + std::to_string(row) + " out of range");
+    }
+}
+
+std::string VectorFile::readString(uint64_t offset, uint32_t length) const {
+    if (offset + length > stringBytes_) {
+        throw std::runtime_error("String heap reference out of range");
+    }
+    return std::string(reinterpret_cast<const char*>(stringsMap_ + offset), length);
+}
+
+} // namespace rag
+} // namespace iris
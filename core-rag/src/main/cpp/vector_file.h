@@ -0,0 +1,344 @@
+#ifndef IRIS_RAG_VECTOR_FILE_H
+#define IRIS_RAG_VECTOR_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "bm25_index.h"
+#include "hnsw_index.h"
+#include "ivf_pq_index.h"
+#include "row_bitmap.h"
+
+namespace iris {
+namespace rag {
+
+/**
+ * Chunk fields stored next to each vector. Strings are opaque UTF-8;
+ * `metadata` is whatever encoding the caller chose (JSON from Kotlin).
+ */
+struct ChunkRecord {
+    std::string id;
+    std::string documentId;
+    std::string content;
+    std::string metadata;
+    int32_t startIndex = 0;
+    int32_t endIndex = 0;
+};
+
+/**
+ * Metadata keys indexed for filtered search, in the flat JSON object Kotlin
+ * writes: comma-separated tags, and the source's modification time in epoch
+ * milliseconds (bucketed by day)
+ */
+constexpr const char* kTagsMetadataKey = "tags";
+constexpr const char* kModifiedMetadataKey = "modified";
+
+/**
+ * Restricts a search to rows meeting every criterion given; an empty list
+ * or open bound places no restriction
+ */
+struct RowFilter {
+    std::vector<std::string> documentIds; // in any of these documents
+    std::vector<std::string> tags;        // tagged with any of these
+    int64_t modifiedFrom = std::numeric_limits<int64_t>::min(); // epoch ms, inclusive
+    int64_t modifiedTo = std::numeric_limits<int64_t>::max();   // epoch ms, inclusive
+};
+
+/**
+ * Compact per-row codes kept next to the f32 arena for a cheap first-pass scan
+ */
+enum class Quantization : uint32_t {
+    kNone = 0,
+    kInt8 = 1,   // dim bytes + f32 scale per row, ranks by scaled int8 dot
+    kBinary = 2, // one sign bit per dimension, ranks by Hamming distance
+};
+
+/**
+ * Thrown by VectorFile::open when an existing store was written by a
+ * different embedding model or with a different dimension
+ */
+class VectorFileMismatch : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * Memory-mapped persistent vector store.
+ *
+ * A store directory holds three files:
+ *   store.vec  4 KB header (magic, version, dimension, quantization, model
+ *              fingerprint, checkpointed row count) followed by a page-aligned
+ *              vector arena, fixed-width metadata columns and, when quantized,
+ *              a code region; all sized by capacity
+ *   store.str  append-only heap of the variable-length chunk strings
+ *   store.wal  write-ahead segment of append/delete records since the last
+ *              checkpoint
+ *
+ * Opening maps the files and replays the WAL; nothing is deserialized, and
+ * vectors are read in place. Appends are group-committed to the WAL with one
+ * fsync before they are applied to the mapping, so a crash at any point
+ * leaves either the old or the new state after replay. Vectors are stored
+ * L2-normalized.
+ *
+ * With quantization the code region (4-32x smaller than the arena) is what a
+ * search streams through; only the best candidates' f32 rows are read back
+ * for rescoring, so the arena can stay mostly out of RAM.
+ *
+ * Deletes are tombstones that searches skip. Each document's live rows are
+ * tracked in memory, so a document's chunks are found without a scan. Rows
+ * are never reused; compactInto() copies the live rows into a fresh store
+ * while this one keeps serving, reclaiming tombstoned rows and their strings.
+ *
+ * Rows are also indexed by tag and by modification day in RowBitmaps, built
+ * on first use like the document lists. filterRows() combines them into the
+ * rows a query may return; the scans take that set and skip whole blocks
+ * without a match, and HNSW and IVF-PQ searches apply it while traversing.
+ *
+ * All methods are thread-safe; readers share a lock, writers are exclusive.
+ */
+class VectorFile {
+public:
+    /**
+     * Open or create a store
+     * @param directory Directory holding the store files (created if missing)
+     * @param dim Vector dimension; 0 adopts the dimension of an existing store
+     * @param fingerprint Identifies the embedding model that produced the vectors
+     * @param resetOnMismatch Discard an incompatible store instead of throwing
+     * @param quantization Code type; a store with other codes is re-encoded from
+     *        its f32 rows. nullopt keeps an existing store's codes (kNone for a new store)
+     */
+    static std::unique_ptr<VectorFile> open(const std::string& directory, int dim,
+                                            const std::string& fingerprint, bool resetOnMismatch,
+                                            std::optional<Quantization> quantization = std::nullopt);
+
+    ~VectorFile();
+
+    VectorFile(const VectorFile&) = delete;
+    VectorFile& operator=(const VectorFile&) = delete;
+
+    int dimension() const { return dim_; }
+    const std::string& fingerprint() const { return fingerprint_; }
+    Quantization quantization() const { return quantization_; }
+
+    /**
+     * Bytes per row of the quantized code region (0 when unquantized)
+     */
+    size_t codeBytes() const { return codeStride_ + (quantization_ == Quantization::kInt8 ? sizeof(float) : 0); }
+
+    /**
+     * Rows ever appended, including deleted ones; row numbers are stable
+     */
+    uint32_t rowCount() const;
+    uint32_t liveCount() const;
+
+    /**
+     * Durably append chunks (one WAL fsync for the whole batch)
+     * @param vectors `records.size()` row-major vectors of `dimension()` floats
+     * @return Row number assigned to each record
+     */
+    std::vector<uint32_t> append(const std::vector<ChunkRecord>& records, const float* vectors);
+
+    /**
+     * Durably tombstone rows; already-deleted rows are ignored
+     */
+    void markDeleted(const std::vector<uint32_t>& rows);
+
+    bool isDeleted(uint32_t row) const;
+
+    /**
+     * Live rows of one document in ascending order
+     */
+    std::vector<uint32_t> documentRows(const std::string& documentId) const;
+
+    /**
+     * Durably tombstone every live row of a document
+     * @return The rows deleted
+     */
+    std::vector<uint32_t> deleteDocument(const std::string& documentId);
+
+    /**
+     * For each of `contents`, a live row of `documentId` that stores exactly that
+     * content, or -1. Rows are matched by content hash and then compared; each
+     * row matches at most one content, so repeated chunks map to distinct rows.
+     */
+    std::vector<int32_t> matchContent(const std::string& documentId, const std::vector<std::string>& contents) const;
+
+    /**
+     * Live rows meeting `filter`; every live row when it sets no criterion
+     */
+    RowBitmap filterRows(const RowFilter& filter) const;
+
+    /**
+     * Copy the live rows, in order, into a new store in `directory` (replacing
+     * any store there). Rows are copied a slice at a time under the shared lock,
+     * so searches and writes on this store proceed meanwhile.
+     * @param rowMap Receives, for each row of this store, its row in the copy or -1
+     */
+    std::unique_ptr<VectorFile> compactInto(const std::string& directory, std::vector<int32_t>& rowMap) const;
+
+    /**
+     * Carry writes made to this store since `rowMap` was last updated over to
+     * `target`: tombstone rows deleted here, copy rows appended here, and
+     * extend `rowMap` to cover them. Checkpoints `target`.
+     */
+    void syncCompacted(VectorFile& target, std::vector<int32_t>& rowMap) const;
+
+    /**
+     * Flush the mapping and string heap, advance the header and truncate the WAL
+     */
+    void checkpoint();
+
+    ChunkRecord readRecord(uint32_t row) const;
+    std::string readChunkId(uint32_t row) const;
+    std::string readDocumentId(uint32_t row) const;
+
+    /**
+     * Copy a stored (normalized) vector into `out`
+     */
+    void readVector(uint32_t row, float* out) const;
+
+    /**
+     * Live row numbers in ascending order
+     */
+    std::vector<uint32_t> liveRows() const;
+
+    /**
+     * Exact top-k over live rows, scanning the mapped arena with the SIMD kernels.
+     * Stores larger than a partition (about 1 MB of vectors) are scanned on
+     * ScanPool::shared(), one bounded heap per worker, merged at the end.
+     * @param filter Only rows in this set are scored; blocks without one are skipped
+     * @param threshold Rows scoring below this are not returned
+     * @return Hits labelled by row number
+     */
+    std::vector<SearchHit> exactSearch(const float* query, int k, const RowBitmap* filter = nullptr,
+                                       float threshold = -std::numeric_limits<float>::infinity()) const;
+
+    /**
+     * Two-stage top-k: scan the quantized codes for the best `candidates` rows,
+     * then rescore those against the f32 rows. Same as exactSearch when unquantized.
+     * @param candidates First-pass shortlist size; clamped to at least k
+     * @param filter Only rows in this set are considered; a set no larger than
+     *        the shortlist is rescored directly
+     */
+    std::vector<SearchHit> search(const float* query, int k, int candidates,
+                                  const RowBitmap* filter = nullptr) const;
+
+    /**
+     * Exact top-k among `rows`, e.g. an approximate index's shortlist.
+     * Deleted and out-of-range rows are skipped.
+     */
+    std::vector<SearchHit> rescore(const float* query, std::vector<uint32_t> rows, int k) const;
+
+    /**
+     * Insert live rows into an HNSW index (labels are row numbers)
+     */
+    void addToIndex(HnswIndex& index, const std::vector<uint32_t>& rows, int numThreads) const;
+
+    /**
+     * Encode live rows into a trained IVF-PQ index (labels are row numbers)
+     */
+    void addToIndex(IvfPqIndex& index, const std::vector<uint32_t>& rows) const;
+
+    /**
+     * Index the content of live rows for BM25 (labels are row numbers)
+     * @param rows Ascending and above every row already in the index
+     */
+    void addToIndex(Bm25Index& index, const std::vector<uint32_t>& rows) const;
+
+    /**
+     * Train an IVF-PQ index on up to `maxSamples` live rows chosen at random
+     */
+    void trainIndex(IvfPqIndex& index, size_t maxSamples, int iterations, int numThreads) const;
+
+private:
+    struct Header;
+    struct Columns;
+
+    VectorFile(std::string directory, int dim, std::string fingerprint);
+
+    const std::string directory_;
+    const int dim_;
+    const std::string fingerprint_;
+    size_t rowStride_ = 0; // bytes per vector row (dense, dim * sizeof(float))
+    Quantization quantization_ = Quantization::kNone;
+    size_t codeStride_ = 0; // bytes per code row (dense, so block kernels apply)
+
+    mutable std::shared_mutex mutex_;
+    int mainFd_ = -1;
+    int stringsFd_ = -1;
+    int walFd_ = -1;
+
+    uint8_t* mainMap_ = nullptr;
+    size_t mainSize_ = 0;
+    uint64_t capacity_ = 0;
+    uint32_t rows_ = 0;
+    uint32_t live_ = 0;
+
+    const uint8_t* stringsMap_ = nullptr;
+    size_t stringsMapped_ = 0;
+    uint64_t stringBytes_ = 0;
+
+    uint64_t walBytes_ = 0;
+
+    // Live rows per document ID, ascending; built on first use
+    mutable std::unordered_map<std::string, std::vector<uint32_t>> documentRows_;
+    mutable std::once_flag documentRowsOnce_;
+    mutable bool documentRowsBuilt_ = false;
+
+    // Live rows per tag and per modification day (days since the epoch); built on first use
+    mutable std::unordered_map<std::string, RowBitmap> tagRows_;
+    mutable std::map<int64_t, RowBitmap> dayRows_;
+    mutable std::once_flag facetsOnce_;
+    mutable bool facetsBuilt_ = false;
+
+    static uint32_t headerCrc(const Header* header);
+    Header* header() const;
+    Columns columns() const;
+    const float* vectorAt(uint32_t row) const;
+    const uint8_t* codeAt(uint32_t row) const;
+    void setQuantization(Quantization quantization);
+    void encodeRow(uint32_t row);
+    void checkRow(uint32_t row) const;
+    std::string path(const char* name) const;
+    std::string readString(uint64_t offset, uint32_t length) const;
+    ChunkRecord readRecordLocked(uint32_t row) const;
+    std::string readDocumentIdLocked(uint32_t row) const;
+    void indexDocumentRows() const;
+    void indexFacets() const;
+    void updateFacets(uint32_t row, const char* metadata, size_t length, bool add) const;
+    std::string_view metadataAt(uint32_t row) const;
+
+    void initialize(bool create);
+    void mapMain();
+    void unmapMain();
+    void mapStrings();
+    void growTo(uint64_t minCapacity);
+    void relayout(uint64_t capacity, Quantization quantization);
+
+    void replayWal();
+    size_t applyWal(const uint8_t* data, size_t size);
+    void writeWal(const std::vector<uint8_t>& records);
+    void applyAppend(const uint8_t* payload);
+    void applyDelete(uint32_t row);
+    std::vector<uint32_t> appendRecords(const std::vector<ChunkRecord>& records, const float* vectors, bool durable);
+    void checkpointLocked();
+    std::vector<SearchHit> rescoreLocked(const float* normalized, std::vector<uint32_t> rows, int k) const;
+    void copyLiveSlice(const std::vector<uint32_t>& rows, size_t first, std::vector<int32_t>& labels,
+                       std::vector<float>& vectors) const;
+};
+
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_VECTOR_FILE_H
@@ -0,0 +1,303 @@
+#include "vector_kernels.h"
+#include "vector_kernels_impl.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+
+#if defined(IRIS_RAG_HAVE_DOTPROD) && defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_ASIMDDP
+#define HWCAP_ASIMDDP (1 << 20)
+#endif
+#endif
+
+#define LOG_TAG "IrisVectorKernels"
+#include "rag_log.h"
+
+namespace iris {
+namespace rag {
+namespace kernels {
+
+// ============================================================================
+// Half-precision conversion
+// ============================================================================
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000u;
+    const uint32_t exponent = (bits >> 23) & 0xFFu;
+    uint32_t mantissa = bits & 0x7FFFFFu;
+
+    if (exponent == 0xFFu) {
+        // Inf / NaN (keep NaN quiet)
+        return static_cast<uint16_t>(sign | 0x7C00u | (mantissa ? 0x200u : 0u));
+    }
+
+    const int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+    if (halfExponent >= 0x1F) {
+        return static_cast<uint16_t>(sign | 0x7C00u);
+    }
+    if (halfExponent <= 0) {
+        if (halfExponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        // Subnormal half
+        mantissa |= 0x800000u;
+        const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1u))) {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    uint32_t half = sign | (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1FFFu;
+    if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u))) {
+        half++; // may carry into the exponent, which is the correct rounding
+    }
+    return static_cast<uint16_t>(half);
+}
+
+float halfToFloat(uint16_t value) {
+    const uint32_t sign = (static_cast<uint32_t>(value) & 0x8000u) << 16;
+    const uint32_t exponent = (value >> 10) & 0x1Fu;
+    uint32_t mantissa = value & 0x3FFu;
+    uint32_t bits;
+
+    if (exponent == 0) {
+        if (mantissa == 0) {
+            bits = sign;
+        } else {
+            // Normalize the subnormal
+            int32_t e = -1;
+            do {
+                e++;
+                mantissa <<= 1;
+            } while ((mantissa & 0x400u) == 0);
+            bits = sign | (static_cast<uint32_t>(127 - 15 - e) << 23) | ((mantissa & 0x3FFu) << 13);
+        }
+    } else if (exponent == 0x1F) {
+        bits = sign | 0x7F800000u | (mantissa << 13);
+    } else {
+        bits = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13);
+    }
+
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+void floatToHalfArray(const float* src, uint16_t* dst, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = floatToHalf(src[i]);
+    }
+}
+
+float quantizeI8(const float* src, int8_t* dst, size_t dim) {
+    float maxAbs = 0.0f;
+    for (size_t i = 0; i < dim; i++) {
+        maxAbs = std::max(maxAbs, std::fabs(src[i]));
+    }
+    const float scale = maxAbs > 0.0f ? maxAbs / 127.0f : 1.0f;
+    const float inverse = 1.0f / scale;
+    for (size_t i = 0; i < dim; i++) {
+        dst[i] = static_cast<int8_t>(std::lrint(std::min(127.0f, std::max(-127.0f, src[i] * inverse))));
+    }
+    return scale;
+}
+
+void binarize(const float* src, uint64_t* dst, size_t dim) {
+    const size_t words = (dim + 63) / 64;
+    for (size_t w = 0; w < words; w++) {
+        uint64_t bits = 0;
+        const size_t end = std::min(dim, (w + 1) * 64);
+        for (size_t i = w * 64; i < end; i++) {
+            bits |= static_cast<uint64_t>(src[i] > 0.0f) << (i - w * 64);
+        }
+        dst[w] = bits;
+    }
+}
+
+// ============================================================================
+// Portable kernels
+// ============================================================================
+
+namespace {
+
+float scalarDotF32(const float* a, const float* b, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float scalarDotF16(const uint16_t* a, const float* query, size_t dim) {
+    float sum = 0.0f;
+    for (size_t i = 0; i < dim; i++) {
+        sum += halfToFloat(a[i]) * query[i];
+    }
+    return sum;
+}
+
+int32_t scalarDotI8(const int8_t* a, const int8_t* b, size_t dim) {
+    int32_t sum = 0;
+    for (size_t i = 0; i < dim; i++) {
+        sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+    }
+    return sum;
+}
+
+uint32_t scalarHamming(const uint64_t* a, const uint64_t* b, size_t words) {
+    uint32_t distance = 0;
+    for (size_t i = 0; i < words; i++) {
+        distance += static_cast<uint32_t>(__builtin_popcountll(a[i] ^ b[i]));
+    }
+    return distance;
+}
+
+void scalarDotBlockF32(const float* query, const float* block, size_t count, size_t dim, float* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = scalarDotF32(query, block + i * dim, dim);
+    }
+}
+
+void scalarDotBlockF16(const float* query, const uint16_t* block, size_t count, size_t dim, float* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = scalarDotF16(block + i * dim, query, dim);
+    }
+}
+
+void scalarDotBlockI8(const int8_t* query, const int8_t* block, size_t count, size_t dim, int32_t* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = scalarDotI8(query, block + i * dim, dim);
+    }
+}
+
+void scalarHammingBlock(const uint64_t* query, const uint64_t* block, size_t count, size_t words,
+                        uint32_t* out) {
+    for (size_t i = 0; i < count; i++) {
+        out[i] = scalarHamming(query, block + i * words, words);
+    }
+}
+
+size_t scalarPlainTextRun(const char* text, size_t length) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(text);
+    // A leading space is never part of a run
+    if (length == 0 || !isPlainTextByte(bytes[0], ' ')) {
+        return 0;
+    }
+    size_t i = 1;
+    while (i < length && isPlainTextByte(bytes[i], bytes[i - 1])) {
+        i++;
+    }
+    return i;
+}
+
+const KernelTable kScalarTable = {
+    "scalar",
+    scalarDotF32,
+    scalarDotF16,
+    scalarDotI8,
+    scalarHamming,
+    scalarDotBlockF32,
+    scalarDotBlockF16,
+    scalarDotBlockI8,
+    scalarHammingBlock,
+    scalarPlainTextRun,
+};
+
+const KernelTable* selectKernels() {
+#if defined(IRIS_RAG_HAVE_DOTPROD) && defined(__linux__)
+    if (getauxval(AT_HWCAP) & HWCAP_ASIMDDP) {
+        return dotprodKernels();
+    }
+#endif
+#if defined(IRIS_RAG_HAVE_NEON)
+    return neonKernels();
+#elif defined(IRIS_RAG_HAVE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") && __builtin_cpu_supports("f16c")) {
+        return avx2Kernels();
+    }
+    return scalarKernels();
+#else
+    return scalarKernels();
+#endif
+}
+
+std::atomic<const KernelTable*> activeTable{nullptr};
+
+const KernelTable* table() {
+    const KernelTable* current = activeTable.load(std::memory_order_acquire);
+    if (current == nullptr) {
+        current = selectKernels();
+        activeTable.store(current, std::memory_order_release);
+        LOGI("Using %s vector kernels", current->name);
+    }
+    return current;
+}
+
+} // namespace
+
+const KernelTable* scalarKernels() {
+    return &kScalarTable;
+}
+
+// ============================================================================
+// Dispatch
+// ============================================================================
+
+const char* backendName() {
+    return table()->name;
+}
+
+void useScalarKernels(bool scalar) {
+    activeTable.store(scalar ? scalarKernels() : selectKernels(), std::memory_order_release);
+}
+
+float dotF32(const float* a, const float* b, size_t dim) {
+    return table()->dotF32(a, b, dim);
+}
+
+float dotF16(const uint16_t* a, const float* query, size_t dim) {
+    return table()->dotF16(a, query, dim);
+}
+
+int32_t dotI8(const int8_t* a, const int8_t* b, size_t dim) {
+    return table()->dotI8(a, b, dim);
+}
+
+uint32_t hamming(const uint64_t* a, const uint64_t* b, size_t words) {
+    return table()->hamming(a, b, words);
+}
+
+void dotBlockF32(const float* query, const float* block, size_t count, size_t dim, float* out) {
+    table()->dotBlockF32(query, block, count, dim, out);
+}
+
+void dotBlockF16(const float* query, const uint16_t* block, size_t count, size_t dim, float* out) {
+    table()->dotBlockF16(query, block, count, dim, out);
+}
+
+void dotBlockI8(const int8_t* query, const int8_t* block, size_t count, size_t dim, int32_t* out) {
+    table()->dotBlockI8(query, block, count, dim, out);
+}
+
+void hammingBlock(const uint64_t* query, const uint64_t* block, size_t count, size_t words, uint32_t* out) {
+    table()->hammingBlock(query, block, count, words, out);
+}
+
+size_t plainTextRun(const char* text, size_t length) {
+    return table()->plainTextRun(text, length);
+}
+
+} // namespace kernels
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,84 @@
+#ifndef IRIS_RAG_VECTOR_KERNELS_H
+#define IRIS_RAG_VECTOR_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace iris {
+namespace rag {
+namespace kernels {
+
+/**
+ * Similarity kernels over contiguous, row-major vector blocks, and the byte
+ * scan text normalization runs on.
+ *
+ * The implementation is picked once at first use: NEON (plus dotprod when the
+ * CPU reports it) on arm64, AVX2/FMA/F16C on x86-64, portable C++ otherwise.
+ * Half-precision vectors are IEEE binary16 stored as uint16_t; binary codes are
+ * packed 64 dimensions per word.
+ */
+
+/**
+ * Name of the selected implementation ("neon+dotprod", "avx2", "scalar", ...)
+ */
+const char* backendName();
+
+float dotF32(const float* a, const float* b, size_t dim);
+
+/**
+ * Dot product of a half-precision stored vector with a float query
+ */
+float dotF16(const uint16_t* a, const float* query, size_t dim);
+
+int32_t dotI8(const int8_t* a, const int8_t* b, size_t dim);
+
+uint32_t hamming(const uint64_t* a, const uint64_t* b, size_t words);
+
+/**
+ * Score `count` vectors of `dim` floats against one query in a single call
+ * @param out `count` dot products
+ */
+void dotBlockF32(const float* query, const float* block, size_t count, size_t dim, float* out);
+
+void dotBlockF16(const float* query, const uint16_t* block, size_t count, size_t dim, float* out);
+
+void dotBlockI8(const int8_t* query, const int8_t* block, size_t count, size_t dim, int32_t* out);
+
+void hammingBlock(const uint64_t* query, const uint64_t* block, size_t count, size_t words, uint32_t* out);
+
+/**
+ * Length of the prefix of `text` that is printable ASCII other than `-.!?`,
+ * with single spaces between non-space bytes. Text normalization copies such
+ * runs as they are and only looks at the bytes in between.
+ */
+size_t plainTextRun(const char* text, size_t length);
+
+/**
+ * IEEE binary16 conversion helpers (round-to-nearest-even)
+ */
+uint16_t floatToHalf(float value);
+float halfToFloat(uint16_t value);
+void floatToHalfArray(const float* src, uint16_t* dst, size_t count);
+
+/**
+ * Symmetric int8 quantization: dst[i] = round(src[i] / scale) with the scale
+ * chosen so the largest magnitude maps to 127
+ * @return The scale; dot products of two codes times both scales approximate the f32 dot
+ */
+float quantizeI8(const float* src, int8_t* dst, size_t dim);
+
+/**
+ * Sign bits, one per dimension, packed into `(dim + 63) / 64` words
+ */
+void binarize(const float* src, uint64_t* dst, size_t dim);
+
+/**
+ * Force the portable implementation; used by benchmarks to get a baseline
+ */
+void useScalarKernels(bool scalar);
+
+} // namespace kernels
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_VECTOR_KERNELS_H
@@ -0,0 +1,205 @@
+// Built with -mavx2 -mfma -mf16c; only reached after a runtime CPU check.
+#include "vector_kernels_impl.h"
+
+#include <immintrin.h>
+
+namespace iris {
+namespace rag {
+namespace kernels {
+
+namespace {
+
+inline float horizontalSum(__m256 v) {
+    const __m128 low = _mm256_castps256_ps128(v);
+    const __m128 high = _mm256_extractf128_ps(v, 1);
+    __m128 sum = _mm_add_ps(low, high);
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 0x55));
+    return _mm_cvtss_f32(sum);
+}
+
+inline int32_t horizontalSum(__m256i v) {
+    const __m128i low = _mm256_castsi256_si128(v);
+    const __m128i high = _mm256_extracti128_si256(v, 1);
+    __m128i sum = _mm_add_epi32(low, high);
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+float avx2DotF32(const float* a, const float* b, size_t dim) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    __m256 acc2 = _mm256_setzero_ps();
+    __m256 acc3 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+        acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 8), _mm256_loadu_ps(b + i + 8), acc1);
+        acc2 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 16), _mm256_loadu_ps(b + i + 16), acc2);
+        acc3 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i + 24), _mm256_loadu_ps(b + i + 24), acc3);
+    }
+    for (; i + 8 <= dim; i += 8) {
+        acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc0);
+    }
+    float sum = horizontalSum(_mm256_add_ps(_mm256_add_ps(acc0, acc1), _mm256_add_ps(acc2, acc3)));
+    for (; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float avx2DotF16(const uint16_t* a, const float* query, size_t dim) {
+    __m256 acc0 = _mm256_setzero_ps();
+    __m256 acc1 = _mm256_setzero_ps();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        const __m256 a0 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        const __m256 a1 = _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + 8)));
+        acc0 = _mm256_fmadd_ps(a0, _mm256_loadu_ps(query + i), acc0);
+        acc1 = _mm256_fmadd_ps(a1, _mm256_loadu_ps(query + i + 8), acc1);
+    }
+    float sum = horizontalSum(_mm256_add_ps(acc0, acc1));
+    for (; i < dim; i++) {
+        sum += _cvtsh_ss(a[i]) * query[i];
+    }
+    return sum;
+}
+
+int32_t avx2DotI8(const int8_t* a, const int8_t* b, size_t dim) {
+    __m256i acc = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        const __m256i a16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)));
+        const __m256i b16 = _mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(a16, b16));
+    }
+    int32_t sum = horizontalSum(acc);
+    for (; i < dim; i++) {
+        sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+    }
+    return sum;
+}
+
+uint32_t avx2Hamming(const uint64_t* a, const uint64_t* b, size_t words) {
+    uint64_t distance = 0;
+    for (size_t i = 0; i < words; i++) {
+        distance += static_cast<uint64_t>(_mm_popcnt_u64(a[i] ^ b[i]));
+    }
+    return static_cast<uint32_t>(distance);
+}
+
+// Four rows per pass so each query load feeds four FMAs
+void avx2DotBlockF32(const float* query, const float* block, size_t count, size_t dim, float* out) {
+    size_t row = 0;
+    for (; row + 4 <= count; row += 4) {
+        const float* r0 = block + row * dim;
+        const float* r1 = r0 + dim;
+        const float* r2 = r1 + dim;
+        const float* r3 = r2 + dim;
+        __m256 acc0 = _mm256_setzero_ps();
+        __m256 acc1 = _mm256_setzero_ps();
+        __m256 acc2 = _mm256_setzero_ps();
+        __m256 acc3 = _mm256_setzero_ps();
+        size_t i = 0;
+        for (; i + 8 <= dim; i += 8) {
+            const __m256 q = _mm256_loadu_ps(query + i);
+            acc0 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r0 + i), acc0);
+            acc1 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r1 + i), acc1);
+            acc2 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r2 + i), acc2);
+            acc3 = _mm256_fmadd_ps(q, _mm256_loadu_ps(r3 + i), acc3);
+        }
+        float s0 = horizontalSum(acc0);
+        float s1 = horizontalSum(acc1);
+        float s2 = horizontalSum(acc2);
+        float s3 = horizontalSum(acc3);
+        for (; i < dim; i++) {
+            s0 += query[i] * r0[i];
+            s1 += query[i] * r1[i];
+            s2 += query[i] * r2[i];
+            s3 += query[i] * r3[i];
+        }
+        out[row] = s0;
+        out[row + 1] = s1;
+        out[row + 2] = s2;
+        out[row + 3] = s3;
+    }
+    for (; row < count; row++) {
+        out[row] = avx2DotF32(query, block + row * dim, dim);
+    }
+}
+
+void avx2DotBlockF16(const float* query, const uint16_t* block, size_t count, size_t dim, float* out) {
+    for (size_t row = 0; row < count; row++) {
+        out[row] = avx2DotF16(block + row * dim, query, dim);
+    }
+}
+
+void avx2DotBlockI8(const int8_t* query, const int8_t* block, size_t count, size_t dim, int32_t* out) {
+    for (size_t row = 0; row < count; row++) {
+        out[row] = avx2DotI8(query, block + row * dim, dim);
+    }
+}
+
+void avx2HammingBlock(const uint64_t* query, const uint64_t* block, size_t count, size_t words,
+                      uint32_t* out) {
+    for (size_t row = 0; row < count; row++) {
+        out[row] = avx2Hamming(query, block + row * words, words);
+    }
+}
+
+size_t avx2PlainTextRun(const char* text, size_t length) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(text);
+    // A leading space is never part of a run
+    if (length == 0 || !isPlainTextByte(bytes[0], ' ')) {
+        return 0;
+    }
+    const __m256i space = _mm256_set1_epi8(' ');
+    size_t i = 1;
+    // Each block is compared with itself shifted back one byte to find double spaces
+    for (; i + 32 <= length; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i));
+        const __m256i previous = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bytes + i - 1));
+        // Signed compares: bytes >= 0x80 are negative and fail the first test
+        const __m256i printable = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8(0x20)),
+                                                   _mm256_cmpgt_epi8(_mm256_set1_epi8(0x7f), v));
+        const __m256i special =
+            _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')),
+                                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))),
+                            _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('!')),
+                                            _mm256_cmpeq_epi8(v, _mm256_set1_epi8('?'))));
+        const __m256i singleSpace = _mm256_andnot_si256(_mm256_cmpeq_epi8(previous, space), _mm256_cmpeq_epi8(v, space));
+        const __m256i plain = _mm256_or_si256(_mm256_andnot_si256(special, printable), singleSpace);
+        const uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(plain));
+        if (mask != 0xffffffffu) {
+            return i + static_cast<size_t>(__builtin_ctz(~mask));
+        }
+    }
+    while (i < length && isPlainTextByte(bytes[i], bytes[i - 1])) {
+        i++;
+    }
+    return i;
+}
+
+const KernelTable kAvx2Table = {
+    "avx2",
+    avx2DotF32,
+    avx2DotF16,
+    avx2DotI8,
+    avx2Hamming,
+    avx2DotBlockF32,
+    avx2DotBlockF16,
+    avx2DotBlockI8,
+    avx2HammingBlock,
+    avx2PlainTextRun,
+};
+
+} // namespace
+
+const KernelTable* avx2Kernels() {
+    return &kAvx2Table;
+}
+
+} // namespace kernels
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,54 @@
+// Built with -march=armv8.2-a+dotprod; only reached when HWCAP_ASIMDDP is set.
+// Overrides the int8 kernels of the NEON table with SDOT.
+#include "vector_kernels_impl.h"
+
+#include <arm_neon.h>
+
+namespace iris {
+namespace rag {
+namespace kernels {
+
+namespace {
+
+int32_t dotprodDotI8(const int8_t* a, const int8_t* b, size_t dim) {
+    int32x4_t acc0 = vdupq_n_s32(0);
+    int32x4_t acc1 = vdupq_n_s32(0);
+    size_t i = 0;
+    for (; i + 32 <= dim; i += 32) {
+        acc0 = vdotq_s32(acc0, vld1q_s8(a + i), vld1q_s8(b + i));
+        acc1 = vdotq_s32(acc1, vld1q_s8(a + i + 16), vld1q_s8(b + i + 16));
+    }
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = vdotq_s32(acc0, vld1q_s8(a + i), vld1q_s8(b + i));
+    }
+    int32_t sum = vaddvq_s32(vaddq_s32(acc0, acc1));
+    for (; i < dim; i++) {
+        sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+    }
+    return sum;
+}
+
+void dotprodDotBlockI8(const int8_t* query, const int8_t* block, size_t count, size_t dim, int32_t* out) {
+    for (size_t row = 0; row < count; row++) {
+        out[row] = dotprodDotI8(query, block + row * dim, dim);
+    }
+}
+
+KernelTable makeDotprodTable() {
+    KernelTable table = *neonKernels();
+    table.name = "neon+dotprod";
+    table.dotI8 = dotprodDotI8;
+    table.dotBlockI8 = dotprodDotBlockI8;
+    return table;
+}
+
+} // namespace
+
+const KernelTable* dotprodKernels() {
+    static const KernelTable table = makeDotprodTable();
+    return &table;
+}
+
+} // namespace kernels
+} // namespace rag
+} // namespace iris
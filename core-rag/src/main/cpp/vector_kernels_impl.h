@@ -0,0 +1,58 @@
+#ifndef IRIS_RAG_VECTOR_KERNELS_IMPL_H
+#define IRIS_RAG_VECTOR_KERNELS_IMPL_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace iris {
+namespace rag {
+namespace kernels {
+
+/**
+ * One implementation of every kernel; the dispatcher in vector_kernels.cpp
+ * picks a table once per process. Architecture-specific tables live in their
+ * own translation units so only they are built with extended ISA flags.
+ */
+struct KernelTable {
+    const char* name;
+    float (*dotF32)(const float*, const float*, size_t);
+    float (*dotF16)(const uint16_t*, const float*, size_t);
+    int32_t (*dotI8)(const int8_t*, const int8_t*, size_t);
+    uint32_t (*hamming)(const uint64_t*, const uint64_t*, size_t);
+    void (*dotBlockF32)(const float*, const float*, size_t, size_t, float*);
+    void (*dotBlockF16)(const float*, const uint16_t*, size_t, size_t, float*);
+    void (*dotBlockI8)(const int8_t*, const int8_t*, size_t, size_t, int32_t*);
+    void (*hammingBlock)(const uint64_t*, const uint64_t*, size_t, size_t, uint32_t*);
+    size_t (*plainTextRun)(const char*, size_t);
+};
+
+/**
+ * Whether `byte` may continue a plain text run (see plainTextRun); `previous`
+ * is the byte before it
+ */
+inline bool isPlainTextByte(uint8_t byte, uint8_t previous) {
+    if (byte == ' ') {
+        return previous != ' ';
+    }
+    return byte > 0x20 && byte < 0x7f && byte != '-' && byte != '.' && byte != '!' && byte != '?';
+}
+
+const KernelTable* scalarKernels();
+
+#if defined(IRIS_RAG_HAVE_NEON)
+const KernelTable* neonKernels();
+#endif
+
+#if defined(IRIS_RAG_HAVE_DOTPROD)
+const KernelTable* dotprodKernels();
+#endif
+
+#if defined(IRIS_RAG_HAVE_AVX2)
+const KernelTable* avx2Kernels();
+#endif
+
+} // namespace kernels
+} // namespace rag
+} // namespace iris
+
+#endif // IRIS_RAG_VECTOR_KERNELS_IMPL_H
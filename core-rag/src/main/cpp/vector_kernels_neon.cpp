@@ -0,0 +1,190 @@
+// AArch64 Advanced SIMD kernels; NEON is mandatory on arm64 so no runtime check.
+#include "vector_kernels_impl.h"
+
+#include <arm_neon.h>
+
+namespace iris {
+namespace rag {
+namespace kernels {
+
+namespace {
+
+float neonDotF32(const float* a, const float* b, size_t dim) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    float32x4_t acc2 = vdupq_n_f32(0.0f);
+    float32x4_t acc3 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+        acc2 = vfmaq_f32(acc2, vld1q_f32(a + i + 8), vld1q_f32(b + i + 8));
+        acc3 = vfmaq_f32(acc3, vld1q_f32(a + i + 12), vld1q_f32(b + i + 12));
+    }
+    for (; i + 4 <= dim; i += 4) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+    float sum = vaddvq_f32(vaddq_f32(vaddq_f32(acc0, acc1), vaddq_f32(acc2, acc3)));
+    for (; i < dim; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+float neonDotF16(const uint16_t* a, const float* query, size_t dim) {
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    size_t i = 0;
+    for (; i + 8 <= dim; i += 8) {
+        const float16x8_t half = vreinterpretq_f16_u16(vld1q_u16(a + i));
+        acc0 = vfmaq_f32(acc0, vcvt_f32_f16(vget_low_f16(half)), vld1q_f32(query + i));
+        acc1 = vfmaq_f32(acc1, vcvt_high_f32_f16(half), vld1q_f32(query + i + 4));
+    }
+    float sum = vaddvq_f32(vaddq_f32(acc0, acc1));
+    for (; i < dim; i++) {
+        const float16x4_t half = vreinterpret_f16_u16(vdup_n_u16(a[i]));
+        sum += vgetq_lane_f32(vcvt_f32_f16(half), 0) * query[i];
+    }
+    return sum;
+}
+
+int32_t neonDotI8(const int8_t* a, const int8_t* b, size_t dim) {
+    int32x4_t acc = vdupq_n_s32(0);
+    size_t i = 0;
+    for (; i + 16 <= dim; i += 16) {
+        const int8x16_t va = vld1q_s8(a + i);
+        const int8x16_t vb = vld1q_s8(b + i);
+        acc = vpadalq_s16(acc, vmull_s8(vget_low_s8(va), vget_low_s8(vb)));
+        acc = vpadalq_s16(acc, vmull_high_s8(va, vb));
+    }
+    int32_t sum = vaddvq_s32(acc);
+    for (; i < dim; i++) {
+        sum += static_cast<int32_t>(a[i]) * static_cast<int32_t>(b[i]);
+    }
+    return sum;
+}
+
+uint32_t neonHamming(const uint64_t* a, const uint64_t* b, size_t words) {
+    uint32_t distance = 0;
+    size_t i = 0;
+    for (; i + 2 <= words; i += 2) {
+        const uint8x16_t x = vreinterpretq_u8_u64(veorq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+        distance += vaddvq_u8(vcntq_u8(x));
+    }
+    for (; i < words; i++) {
+        distance += static_cast<uint32_t>(__builtin_popcountll(a[i] ^ b[i]));
+    }
+    return distance;
+}
+
+// Four rows per pass so each query load feeds four FMAs
+void neonDotBlockF32(const float* query, const float* block, size_t count, size_t dim, float* out) {
+    size_t row = 0;
+    for (; row + 4 <= count; row += 4) {
+        const float* r0 = block + row * dim;
+        const float* r1 = r0 + dim;
+        const float* r2 = r1 + dim;
+        const float* r3 = r2 + dim;
+        float32x4_t acc0 = vdupq_n_f32(0.0f);
+        float32x4_t acc1 = vdupq_n_f32(0.0f);
+        float32x4_t acc2 = vdupq_n_f32(0.0f);
+        float32x4_t acc3 = vdupq_n_f32(0.0f);
+        size_t i = 0;
+        for (; i + 4 <= dim; i += 4) {
+            const float32x4_t q = vld1q_f32(query + i);
+            acc0 = vfmaq_f32(acc0, q, vld1q_f32(r0 + i));
+            acc1 = vfmaq_f32(acc1, q, vld1q_f32(r1 + i));
+            acc2 = vfmaq_f32(acc2, q, vld1q_f32(r2 + i));
+            acc3 = vfmaq_f32(acc3, q, vld1q_f32(r3 + i));
+        }
+        float s0 = vaddvq_f32(acc0);
+        float s1 = vaddvq_f32(acc1);
+        float s2 = vaddvq_f32(acc2);
+        float s3 = vaddvq_f32(acc3);
+        for (; i < dim; i++) {
+            s0 += query[i] * r0[i];
+            s1 += query[i] * r1[i];
+            s2 += query[i] * r2[i];
+            s3 += query[i] * r3[i];
+        }
+        out[row] = s0;
+        out[row + 1] = s1;
+        out[row + 2] = s2;
+        out[row + 3] = s3;
+    }
+    for (; row < count; row++) {
+        out[row] = neonDotF32(query, block + row * dim, dim);
+    }
+}
+
+void neonDotBlockF16(const float* query, const uint16_t* block, size_t count, size_t dim, float* out) {
+    for (size_t row = 0; row < count; row++) {
+        out[row] = neonDotF16(block + row * dim, query, dim);
+    }
+}
+
+void neonDotBlockI8(const int8_t* query, const int8_t* block, size_t count, size_t dim, int32_t* out) {
+    for (size_t row = 0; row < count; row++) {
+        out[row] = neonDotI8(query, block + row * dim, dim);
+    }
+}
+
+void neonHammingBlock(const uint64_t* query, const uint64_t* block, size_t count, size_t words,
+                      uint32_t* out) {
+    for (size_t row = 0; row < count; row++) {
+        out[row] = neonHamming(query, block + row * words, words);
+    }
+}
+
+size_t neonPlainTextRun(const char* text, size_t length) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(text);
+    // A leading space is never part of a run
+    if (length == 0 || !isPlainTextByte(bytes[0], ' ')) {
+        return 0;
+    }
+    const uint8x16_t space = vdupq_n_u8(' ');
+    size_t i = 1;
+    // Each block is compared with itself shifted back one byte to find double spaces
+    for (; i + 16 <= length; i += 16) {
+        const uint8x16_t v = vld1q_u8(bytes + i);
+        const uint8x16_t previous = vld1q_u8(bytes + i - 1);
+        const uint8x16_t printable = vcleq_u8(vsubq_u8(v, vdupq_n_u8(0x21)), vdupq_n_u8(0x7e - 0x21));
+        const uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(v, vdupq_n_u8('-')), vceqq_u8(v, vdupq_n_u8('.'))),
+                                            vorrq_u8(vceqq_u8(v, vdupq_n_u8('!')), vceqq_u8(v, vdupq_n_u8('?'))));
+        const uint8x16_t singleSpace = vbicq_u8(vceqq_u8(v, space), vceqq_u8(previous, space));
+        const uint8x16_t plain = vorrq_u8(vbicq_u8(printable, special), singleSpace);
+        if (vminvq_u8(plain) != 0xff) {
+            // Narrow to one nibble per byte; the first zero nibble is the first stop
+            const uint64_t mask =
+                vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(vmvnq_u8(plain)), 4)), 0);
+            return i + static_cast<size_t>(__builtin_ctzll(mask) >> 2);
+        }
+    }
+    while (i < length && isPlainTextByte(bytes[i], bytes[i - 1])) {
+        i++;
+    }
+    return i;
+}
+
+const KernelTable kNeonTable = {
+    "neon",
+    neonDotF32,
+    neonDotF16,
+    neonDotI8,
+    neonHamming,
+    neonDotBlockF32,
+    neonDotBlockF16,
+    neonDotBlockI8,
+    neonHammingBlock,
+    neonPlainTextRun,
+};
+
+} // namespace
+
+const KernelTable* neonKernels() {
+    return &kNeonTable;
+}
+
+} // namespace kernels
+} // namespace rag
+} // namespace iris
@@ -0,0 +1,97 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+
+/**
+ * Handle to the native BM25 inverted index (libiris_rag)
+ *
+ * Text is tokenized natively (Unicode-aware, case-folded; Han and kana one
+ * character per token). Postings are block-compressed and queries use
+ * Block-Max WAND, so short keyword queries touch a small part of the index.
+ * Document IDs must be added in increasing order, e.g. [VectorFile] rows.
+ * Adds, removes and searches are safe to call concurrently.
+ */
+class Bm25Index(k1: Float = DEFAULT_K1, b: Float = DEFAULT_B) : Closeable {
+
+    companion object {
+        const val DEFAULT_K1 = 1.2f
+        const val DEFAULT_B = 0.75f
+    }
+
+    private var handle: Long = nativeCreate(k1, b)
+
+    /**
+     * Number of live documents
+     */
+    val size: Int
+        get() = if (handle != 0L) nativeSize(handle) else 0
+
+    /**
+     * Index texts; IDs must be ascending and above every ID added before
+     */
+    fun add(docs: IntArray, texts: Array<String>) {
+        check(handle != 0L) { "Index is closed" }
+        require(docs.size == texts.size) { "Expected ${docs.size} texts, got ${texts.size}" }
+        nativeAdd(handle, docs, texts)
+    }
+
+    /**
+     * Index the content of [VectorFile] rows straight from the store; labels are row numbers
+     */
+    fun addFromFile(file: VectorFile, rows: IntArray) {
+        check(handle != 0L) { "Index is closed" }
+        if (rows.isNotEmpty()) {
+            nativeAddFromFile(handle, file.nativeHandle, rows)
+        }
+    }
+
+    /**
+     * Drop rows `file` has deleted and index rows appended since the last add
+     */
+    fun syncWith(file: VectorFile) {
+        check(handle != 0L) { "Index is closed" }
+        nativeSyncWithFile(handle, file.nativeHandle)
+    }
+
+    fun remove(doc: Int): Boolean {
+        check(handle != 0L) { "Index is closed" }
+        return nativeRemove(handle, doc)
+    }
+
+    /**
+     * Top-k documents by BM25; any query term may match
+     * @return Hits sorted by descending score
+     */
+    fun search(query: String, k: Int): List<IndexHit> {
+        check(handle != 0L) { "Index is closed" }
+        if (k <= 0) return emptyList()
+
+        val labels = IntArray(k)
+        val scores = FloatArray(k)
+        val count = nativeSearch(handle, query, k, labels, scores)
+        return List(count) { IndexHit(labels[it], scores[it]) }
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeCreate(k1: Float, b: Float): Long
+    private external fun nativeAdd(handle: Long, docs: IntArray, texts: Array<String>)
+    private external fun nativeAddFromFile(handle: Long, fileHandle: Long, rows: IntArray)
+    private external fun nativeSyncWithFile(handle: Long, fileHandle: Long)
+    private external fun nativeRemove(handle: Long, doc: Int): Boolean
+    private external fun nativeSearch(
+        handle: Long,
+        query: String,
+        k: Int,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+    private external fun nativeSize(handle: Long): Int
+    private external fun nativeFree(handle: Long)
+}
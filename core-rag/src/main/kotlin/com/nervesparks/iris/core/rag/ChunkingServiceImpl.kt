@@ -3,8 +3,12 @@ package com.nervesparks.iris.core.rag
 import android.util.Log
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.withContext
+import java.io.File
+import java.util.concurrent.locks.ReentrantReadWriteLock
 import javax.inject.Inject
 import javax.inject.Singleton
+import kotlin.concurrent.read
+import kotlin.concurrent.write
 
 /**
  * Service for chunking text into manageable segments
@@ -14,6 +18,24 @@ class ChunkingServiceImpl @Inject constructor() : ChunkingService {
     
     companion object {
         private const val TAG = "ChunkingService"
+        private const val CHARS_PER_TOKEN = 4 // budget conversion when the native tokenizer is unavailable
+    }
+    
+    // Native tokenizer: the embedding model's vocabulary once loaded, word-level until then
+    private val tokenizerLock = ReentrantReadWriteLock()
+    private var tokenizer: SubwordTokenizer? = null
+    
+    /**
+     * Count tokens with the embedding model's WordPiece vocabulary (`vocab.txt`)
+     * from now on; call when the embedding model is loaded
+     */
+    fun loadVocabulary(vocabulary: File) {
+        val loaded = SubwordTokenizer.load(vocabulary)
+        tokenizerLock.write {
+            tokenizer?.close()
+            tokenizer = loaded
+        }
+        Log.i(TAG, "Loaded vocabulary of ${loaded.vocabularySize} pieces from ${vocabulary.name}")
     }
     
     override suspend fun chunkText(
@@ -95,6 +117,10 @@ class ChunkingServiceImpl @Inject constructor() : ChunkingService {
         documentId: String
     ): List<DocumentChunk> = withContext(Dispatchers.Default) {
         
+        if (HnswIndex.isNativeAvailable) {
+            return@withContext chunkBySentenceSpans(text, maxChunkSize, overlap, documentId)
+        }
+        
         // More sophisticated chunking that respects semantic boundaries
         val sentences = splitIntoSentences(text)
         val chunks = mutableListOf<DocumentChunk>()
@@ -161,6 +187,92 @@ class ChunkingServiceImpl @Inject constructor() : ChunkingService {
         chunks
     }
     
+    override suspend fun chunkByTokens(
+        text: String,
+        maxTokens: Int,
+        overlapTokens: Int,
+        documentId: String
+    ): List<DocumentChunk> = withContext(Dispatchers.Default) {
+        
+        if (!HnswIndex.isNativeAvailable) {
+            return@withContext smartChunkText(
+                text, maxTokens * CHARS_PER_TOKEN, overlapTokens * CHARS_PER_TOKEN, documentId
+            )
+        }
+        
+        // One native pass over the document; only the final substrings are copied
+        val spans = tokenizerLock.read {
+            if (tokenizer == null) {
+                tokenizerLock.write {
+                    if (tokenizer == null) tokenizer = SubwordTokenizer.wordLevel()
+                }
+            }
+            tokenizer!!.chunk(text, maxTokens, overlapTokens)
+        }
+        
+        val chunks = spans.mapIndexed { index, span ->
+            DocumentChunk(
+                content = text.substring(span.start, span.end),
+                startIndex = span.start,
+                endIndex = span.end,
+                metadata = mapOf(
+                    "chunk_index" to index.toString(),
+                    "document_id" to documentId,
+                    "chunking_method" to "token_budget",
+                    "token_count" to span.tokens.toString()
+                )
+            )
+        }
+        
+        Log.d(TAG, "Token chunking created ${chunks.size} chunks of up to $maxTokens tokens from ${text.length} characters")
+        chunks
+    }
+    
+    /**
+     * Sentence-aligned chunks cut straight from `text` by native sentence offsets; a
+     * chunk overlaps the previous one by its last sentences within `overlap` characters
+     */
+    private fun chunkBySentenceSpans(
+        text: String,
+        maxChunkSize: Int,
+        overlap: Int,
+        documentId: String
+    ): List<DocumentChunk> {
+        val sentences = TextNormalizer.sentences(text)
+        val chunks = mutableListOf<DocumentChunk>()
+        
+        var first = 0
+        while (first < sentences.size) {
+            // A sentence longer than the budget becomes a chunk of its own
+            var last = first
+            while (last + 1 < sentences.size && sentences[last + 1].end - sentences[first].start <= maxChunkSize) {
+                last++
+            }
+            val start = sentences[first].start
+            val end = sentences[last].end
+            chunks.add(DocumentChunk(
+                content = text.substring(start, end),
+                startIndex = start,
+                endIndex = end,
+                metadata = mapOf(
+                    "chunk_index" to chunks.size.toString(),
+                    "document_id" to documentId,
+                    "chunking_method" to "smart_semantic"
+                )
+            ))
+            if (last + 1 == sentences.size) break
+            
+            var next = last + 1
+            while (next - 1 > first && end - sentences[next - 1].start <= overlap) {
+                next--
+            }
+            first = next
+        }
+        
+        Log.d(TAG, "Smart chunking created ${chunks.size} chunks from ${sentences.size} sentences")
+        return chunks
+    }
+    
     private fun splitIntoSentences(text: String): List<String> {
         // Simple sentence splitting - in a real implementation, 
         // you might use a more sophisticated NLP library
@@ -0,0 +1,120 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+
+/**
+ * A retrieved chunk tokenized by the LLM's tokenizer
+ *
+ * @property label Names the chunk across calls, e.g. a hash of its ID
+ */
+class PackCandidate(
+    val label: Int,
+    val score: Float,
+    val tokens: IntArray
+)
+
+/**
+ * @property labels Packed chunks in prompt order
+ * @property tokens Their tokens, each chunk followed by the separator, ready to go into the prompt
+ * @property spans (start, length) of each chunk's tokens in [tokens], separator excluded
+ */
+class PackedContext(
+    val labels: IntArray,
+    val tokens: IntArray,
+    val spans: IntArray = IntArray(0)
+)
+
+/**
+ * Handle to the native context packer (libiris_rag)
+ *
+ * Picks the retrieved chunks that fit a prompt's token budget by maximal
+ * marginal relevance: score, less a penalty for token-bigram overlap with the
+ * chunks already picked, so a near-copy of a picked chunk does not spend the
+ * budget twice. Chunks that were in the previous pack come first, in the same
+ * order, so consecutive prompts share a long prefix the LLM's KV cache can
+ * keep. The result is token IDs, so the context is not tokenized again.
+ */
+class ContextPacker(
+    lambda: Float = DEFAULT_LAMBDA,
+    maxRedundancy: Float = DEFAULT_MAX_REDUNDANCY
+) : Closeable {
+
+    companion object {
+        // Weight of relevance against redundancy
+        const val DEFAULT_LAMBDA = 0.7f
+
+        // Bigram overlap of a chunk and a copy of it with a few words changed
+        const val DEFAULT_MAX_REDUNDANCY = 0.8f
+    }
+
+    private var handle: Long = nativeCreate(lambda, maxRedundancy)
+
+    /**
+     * @param budget Tokens the packed context may use, separators included
+     * @param separator Tokens after each chunk, e.g. the model's newline
+     */
+    fun pack(candidates: List<PackCandidate>, budget: Int, separator: IntArray): PackedContext {
+        check(handle != 0L) { "Packer is closed" }
+        if (candidates.isEmpty() || budget <= 0) return PackedContext(IntArray(0), IntArray(0))
+
+        val offsets = IntArray(candidates.size + 1)
+        candidates.forEachIndexed { i, candidate -> offsets[i + 1] = offsets[i] + candidate.tokens.size }
+        val tokens = IntArray(offsets.last())
+        candidates.forEachIndexed { i, candidate -> candidate.tokens.copyInto(tokens, offsets[i]) }
+
+        val labels = IntArray(candidates.size)
+        val packed = IntArray(budget)
+        val count = nativePack(
+            handle,
+            IntArray(candidates.size) { candidates[it].label },
+            FloatArray(candidates.size) { candidates[it].score },
+            tokens,
+            offsets,
+            separator,
+            budget,
+            labels,
+            packed
+        )
+        val sizes = candidates.associate { it.label to it.tokens.size }
+        val spans = IntArray(count * 2)
+        var used = 0
+        for (i in 0 until count) {
+            spans[i * 2] = used
+            spans[i * 2 + 1] = sizes[labels[i]] ?: 0
+            used += spans[i * 2 + 1] + separator.size
+        }
+        return PackedContext(labels.copyOf(count), packed.copyOf(used), spans)
+    }
+
+    /**
+     * Forget the previous pack's order, e.g. when a new conversation starts
+     */
+    fun reset() {
+        if (handle != 0L) {
+            nativeReset(handle)
+        }
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeCreate(lambda: Float, maxRedundancy: Float): Long
+    private external fun nativePack(
+        handle: Long,
+        labels: IntArray,
+        scores: FloatArray,
+        tokens: IntArray,
+        offsets: IntArray,
+        separator: IntArray,
+        budget: Int,
+        outLabels: IntArray,
+        outTokens: IntArray
+    ): Int
+    private external fun nativeReset(handle: Long)
+    private external fun nativeFree(handle: Long)
+}
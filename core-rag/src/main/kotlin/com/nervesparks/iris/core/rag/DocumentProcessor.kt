@@ -77,6 +77,17 @@ interface ChunkingService {
         overlap: Int,
         documentId: String
     ): List<DocumentChunk>
+    
+    /**
+     * Chunk to a budget of embedding-model tokens, cutting at paragraph and
+     * sentence boundaries, with overlap measured in tokens
+     */
+    suspend fun chunkByTokens(
+        text: String,
+        maxTokens: Int,
+        overlapTokens: Int,
+        documentId: String
+    ): List<DocumentChunk>
 }
 
 /**
@@ -92,6 +103,20 @@ interface EmbeddingService {
      * Batch generate embeddings
      */
     suspend fun generateEmbeddings(texts: List<String>): List<FloatArray>
+    
+    /**
+     * Identifies the model behind the embeddings; persisted vectors from a
+     * different fingerprint are discarded rather than mixed
+     */
+    val modelFingerprint: String
+        get() = javaClass.name
+    
+    /**
+     * Whether the embeddings come from a trained model and their similarity means
+     * something; hybrid search leaves the semantic ranking out when it does not
+     */
+    val isSemantic: Boolean
+        get() = true
 }
 
 /**
@@ -132,7 +157,24 @@ interface VectorStore {
      * Delete chunks by document ID
      */
     suspend fun deleteChunksByDocumentId(documentId: String): Boolean
-    
+
+    /**
+     * Replace a document's chunks with `chunks` (stored as `<documentId>_chunk_<i>`),
+     * calling `embed` only for chunks whose content the document does not already
+     * have; the default embeds them all
+     * @return Number of chunks embedded
+     */
+    suspend fun upsertChunks(
+        documentId: String,
+        chunks: List<DocumentChunk>,
+        embed: suspend (List<String>) -> List<FloatArray>
+    ): Int {
+        deleteChunksByDocumentId(documentId)
+        val embeddings = if (chunks.isEmpty()) emptyList() else embed(chunks.map { it.content })
+        saveChunks(chunks.mapIndexed { i, chunk -> chunk.embedded(documentId, i, embeddings[i]) })
+        return chunks.size
+    }
+
     /**
      * Search for similar chunks
      */
@@ -141,6 +183,35 @@ interface VectorStore {
         limit: Int,
         threshold: Float
     ): List<ScoredChunk>
+    
+    /**
+     * [searchSimilar] restricted to chunks matching `filter`; the default
+     * over-fetches and filters the results, so it may return fewer than `limit`
+     */
+    suspend fun searchFiltered(
+        queryEmbedding: FloatArray,
+        limit: Int,
+        threshold: Float,
+        filter: SearchFilter
+    ): List<ScoredChunk> {
+        if (filter.isEmpty) return searchSimilar(queryEmbedding, limit, threshold)
+        return searchSimilar(queryEmbedding, limit * SearchFilter.OVERFETCH_FACTOR, threshold)
+            .filter { filter.matches(it.chunk) }
+            .take(limit)
+    }
+    
+    /**
+     * Keyword search over chunk text (BM25); scores are not comparable with
+     * [searchSimilar] and are meant for rank fusion
+     */
+    suspend fun searchLexical(query: String, limit: Int): List<ScoredChunk> = emptyList()
+    
+    /**
+     * Incremented by every change to stored chunks, so cached search results can
+     * be checked against it; null if the store does not track changes
+     */
+    val chunkVersion: Long?
+        get() = null
 }
 
 // Data classes
@@ -190,7 +261,20 @@ data class DocumentChunk(
     val startIndex: Int,
     val endIndex: Int,
     val metadata: Map<String, String>
-)
+) {
+    /**
+     * This chunk stored as the `index`th chunk of `documentId`
+     */
+    fun embedded(documentId: String, index: Int, embedding: FloatArray) = EmbeddedChunk(
+        id = "${documentId}_chunk_$index",
+        documentId = documentId,
+        content = content,
+        embedding = embedding,
+        startIndex = startIndex,
+        endIndex = endIndex,
+        metadata = metadata
+    )
+}
 
 /**
  * Chunk with embedding
@@ -227,6 +311,56 @@ data class EmbeddedChunk(
     }
 }
 
+/**
+ * Restricts a search to chunks of some documents, with some tags, or modified
+ * within a time range. Criteria are ANDed; a set matches any of its entries,
+ * and an empty set or null bound does not restrict.
+ *
+ * Tags and modification times are read from chunk metadata under [TAGS_KEY]
+ * (comma-separated) and [MODIFIED_KEY] (epoch ms); [facetsOf] produces them
+ * for a document's chunks.
+ */
+data class SearchFilter(
+    val documentIds: Set<String> = emptySet(),
+    val tags: Set<String> = emptySet(),
+    val modifiedFrom: Long? = null,
+    val modifiedTo: Long? = null
+) {
+    companion object {
+        const val TAGS_KEY = "tags"
+        const val MODIFIED_KEY = "modified"
+        
+        // Results fetched per requested one when a store filters after searching
+        const val OVERFETCH_FACTOR = 10
+        
+        /**
+         * Chunk metadata carrying the document's tags and modification time
+         */
+        fun facetsOf(document: StoredDocument): Map<String, String> {
+            val facets = mutableMapOf(MODIFIED_KEY to document.lastModified.toString())
+            document.metadata[TAGS_KEY]?.takeIf { it.isNotBlank() }?.let { facets[TAGS_KEY] = it }
+            return facets
+        }
+    }
+    
+    val isEmpty: Boolean
+        get() = documentIds.isEmpty() && tags.isEmpty() && modifiedFrom == null && modifiedTo == null
+    
+    fun matches(chunk: EmbeddedChunk): Boolean {
+        if (documentIds.isNotEmpty() && chunk.documentId !in documentIds) return false
+        if (tags.isNotEmpty()) {
+            val chunkTags = chunk.metadata[TAGS_KEY]?.split(',')?.map { it.trim(' ') } ?: return false
+            if (chunkTags.none { it in tags }) return false
+        }
+        if (modifiedFrom != null || modifiedTo != null) {
+            val modified = chunk.metadata[MODIFIED_KEY]?.toLongOrNull() ?: return false
+            if (modifiedFrom != null && modified < modifiedFrom) return false
+            if (modifiedTo != null && modified > modifiedTo) return false
+        }
+        return true
+    }
+}
+
 /**
  * Chunk with similarity score
  */
@@ -283,7 +417,8 @@ sealed class BatchProcessingResult {
         val totalDocuments: Int,
         val successCount: Int,
         val errorCount: Int,
-        val errors: List<ProcessingError>
+        val errors: List<ProcessingError>,
+        val stageThroughput: List<StageThroughput> = emptyList()
     ) : BatchProcessingResult()
 }
 
@@ -8,8 +8,8 @@ import android.util.Log
 import dagger.hilt.android.qualifiers.ApplicationContext
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.flow.Flow
-import kotlinx.coroutines.flow.flow
 import kotlinx.coroutines.withContext
+import java.io.File
 import javax.inject.Inject
 import javax.inject.Singleton
 
@@ -25,10 +25,20 @@ class DocumentProcessorImpl @Inject constructor(
     @ApplicationContext private val context: Context
 ) : DocumentProcessor {
     
+    private val pipeline by lazy {
+        IngestionPipeline(
+            textExtractor = textExtractor,
+            chunkingService = chunkingService,
+            embeddingService = embeddingService,
+            vectorStore = vectorStore,
+            progressFile = File(context.filesDir, PROGRESS_FILE),
+            describe = ::describeDocument
+        )
+    }
+    
     companion object {
         private const val TAG = "DocumentProcessor"
-        private const val MAX_CHUNK_SIZE = 1000
-        private const val CHUNK_OVERLAP = 200
+        private const val PROGRESS_FILE = "rag_ingest_progress.properties"
         private const val SUPPORTED_MIME_TYPES = "application/pdf,text/plain,text/markdown,application/vnd.openxmlformats-officedocument.wordprocessingml.document"
     }
     
@@ -37,161 +47,72 @@ class DocumentProcessorImpl @Inject constructor(
         metadata: DocumentMetadata?
     ): Result<ProcessingResult> = withContext(Dispatchers.IO) {
         
-        try {
-            Log.i(TAG, "Starting document processing for: $uri")
-            
-            val startTime = System.currentTimeMillis()
-            
-            // Extract document info and validate
-            val documentInfo = extractDocumentInfo(uri)
-            if (!isSupportedFormat(documentInfo.mimeType)) {
-                return@withContext Result.failure(
-                    DocumentProcessingException("Unsupported file format: ${documentInfo.mimeType}")
-                )
-            }
-            
-            // Extract text content
-            val extractionResult = textExtractor.extractText(uri, documentInfo)
-            if (extractionResult.isFailure) {
-                return@withContext Result.failure(
-                    extractionResult.exceptionOrNull() ?: Exception("Text extraction failed")
-                )
+        Log.i(TAG, "Starting document processing for: $uri")
+        
+        var outcome: Result<ProcessingResult> =
+            Result.failure(DocumentProcessingException("Document processing failed"))
+        pipeline.run(listOf(IngestJob(uri, metadata))).collect { event ->
+            when (event) {
+                is BatchProcessingResult.DocumentCompleted -> {
+                    Log.i(TAG, "Document processed successfully: ${event.result.documentId}")
+                    outcome = Result.success(event.result)
+                }
+                is BatchProcessingResult.DocumentFailed -> {
+                    outcome = Result.failure(DocumentProcessingException(event.error.error))
+                }
+                else -> Unit
             }
-            
-            val textContent = extractionResult.getOrNull()!!
-            Log.d(TAG, "Extracted ${textContent.length} characters from document")
-            
-            // Create document record
-            val document = StoredDocument(
-                id = generateDocumentId(),
-                title = metadata?.title ?: documentInfo.fileName,
-                uri = uri.toString(),
-                mimeType = documentInfo.mimeType,
-                size = documentInfo.size,
-                textContent = textContent,
-                metadata = metadata?.properties ?: emptyMap(),
-                createdAt = System.currentTimeMillis(),
-                lastModified = documentInfo.lastModified,
-                chunkCount = 0,
-                isProcessed = false
-            )
-            
-            // Save document record
-            vectorStore.saveDocument(document)
-            
-            // Chunk the document
-            val chunks = chunkingService.chunkText(
-                text = textContent,
-                maxChunkSize = MAX_CHUNK_SIZE,
-                overlap = CHUNK_OVERLAP,
-                documentId = document.id
-            )
-            
-            Log.d(TAG, "Created ${chunks.size} chunks from document")
-            
-            // Generate embeddings for chunks
-            val embeddedChunks = generateEmbeddingsForChunks(chunks, document.id)
-            
-            // Store chunks and embeddings
-            vectorStore.saveChunks(embeddedChunks)
-            
-            // Update document record
-            val updatedDocument = document.copy(
-                chunkCount = chunks.size,
-                isProcessed = true
-            )
-            vectorStore.updateDocument(updatedDocument)
-            
-            val processingTime = System.currentTimeMillis() - startTime
-            
-            val result = ProcessingResult(
-                documentId = document.id,
-                title = document.title,
-                chunkCount = chunks.size,
-                characterCount = textContent.length,
-                processingTime = processingTime,
-                success = true
-            )
-            
-            Log.i(TAG, "Document processed successfully: ${document.id}")
-            
-            Result.success(result)
-            
-        } catch (e: Exception) {
-            Log.e(TAG, "Document processing failed", e)
-            Result.failure(DocumentProcessingException("Document processing failed", e))
         }
+        outcome
     }
     
     override suspend fun processMultipleDocuments(
         uris: List<Uri>,
         batchMetadata: Map<String, DocumentMetadata>?
-    ): Flow<BatchProcessingResult> = flow {
-        
-        val totalDocuments = uris.size
-        var processedCount = 0
-        var successCount = 0
-        val errors = mutableListOf<ProcessingError>()
-        
-        emit(BatchProcessingResult.Started(totalDocuments))
-        
-        uris.forEach { uri ->
-            try {
-                val metadata = batchMetadata?.get(uri.toString())
-                val result = processDocument(uri, metadata)
-                
-                processedCount++
-                
-                if (result.isSuccess) {
-                    successCount++
-                    emit(BatchProcessingResult.DocumentCompleted(
-                        uri = uri,
-                        result = result.getOrNull()!!,
-                        progress = (processedCount * 100) / totalDocuments
-                    ))
-                } else {
-                    val error = ProcessingError(
-                        uri = uri,
-                        error = result.exceptionOrNull()?.message ?: "Processing failed"
-                    )
-                    errors.add(error)
-                    emit(BatchProcessingResult.DocumentFailed(error))
-                }
-                
-            } catch (e: Exception) {
-                val error = ProcessingError(
-                    uri = uri,
-                    error = e.message ?: "Unknown error"
-                )
-                errors.add(error)
-                emit(BatchProcessingResult.DocumentFailed(error))
-                processedCount++
-            }
-        }
-        
-        emit(BatchProcessingResult.Completed(
-            totalDocuments = totalDocuments,
-            successCount = successCount,
-            errorCount = errors.size,
-            errors = errors
-        ))
+    ): Flow<BatchProcessingResult> {
+        return pipeline.run(uris.map { IngestJob(it, batchMetadata?.get(it.toString())) })
     }
     
-    override suspend fun reprocessDocument(documentId: String): Result<ProcessingResult> {
-        return try {
+    override suspend fun reprocessDocument(documentId: String): Result<ProcessingResult> = withContext(Dispatchers.IO) {
+        try {
             val document = vectorStore.getDocument(documentId)
-                ?: return Result.failure(DocumentProcessingException("Document not found: $documentId"))
-            
-            // Delete existing chunks
-            vectorStore.deleteChunksByDocumentId(documentId)
+                ?: return@withContext Result.failure(DocumentProcessingException("Document not found: $documentId"))
+            val startTime = System.currentTimeMillis()
             
-            // Reprocess from URI
+            // Re-chunk in place under the same ID; only chunks with new content are embedded
             val uri = Uri.parse(document.uri)
-            processDocument(uri, DocumentMetadata(
-                title = document.title,
-                properties = document.metadata
+            val info = describeDocument(uri)
+            val text = textExtractor.extractText(uri, info).getOrElse {
+                throw DocumentProcessingException("Text extraction failed", it)
+            }
+            val facets = SearchFilter.facetsOf(document.copy(lastModified = info.lastModified))
+            val chunks = chunkingService.chunkByTokens(
+                text = text,
+                maxTokens = IngestionPipeline.MAX_CHUNK_TOKENS,
+                overlapTokens = IngestionPipeline.CHUNK_OVERLAP_TOKENS,
+                documentId = documentId
+            ).map { it.copy(metadata = it.metadata + facets) }
+            pipeline.forgetDocument(documentId)
+            val embedded = vectorStore.upsertChunks(documentId, chunks) { texts ->
+                embeddingService.generateEmbeddings(texts)
+            }
+            vectorStore.updateDocument(document.copy(
+                size = info.size,
+                textContent = text,
+                lastModified = info.lastModified,
+                chunkCount = chunks.size,
+                isProcessed = true
             ))
+            Log.i(TAG, "Reprocessed $documentId: $embedded of ${chunks.size} chunks embedded")
             
+            Result.success(ProcessingResult(
+                documentId = documentId,
+                title = document.title,
+                chunkCount = chunks.size,
+                characterCount = text.length,
+                processingTime = System.currentTimeMillis() - startTime,
+                success = true
+            ))
         } catch (e: Exception) {
             Log.e(TAG, "Document reprocessing failed", e)
             Result.failure(DocumentProcessingException("Reprocessing failed", e))
@@ -202,6 +123,7 @@ class DocumentProcessorImpl @Inject constructor(
         return try {
             vectorStore.deleteDocument(documentId)
             vectorStore.deleteChunksByDocumentId(documentId)
+            pipeline.forgetDocument(documentId)
             
             true
         } catch (e: Exception) {
@@ -274,46 +196,20 @@ class DocumentProcessorImpl @Inject constructor(
         } ?: throw DocumentProcessingException("Could not access document")
     }
     
-    private fun isSupportedFormat(mimeType: String): Boolean {
-        return SUPPORTED_MIME_TYPES.split(",").any { supportedType ->
-            mimeType.startsWith(supportedType.trim())
+    /**
+     * Document info for the pipeline; unsupported formats fail here, before extraction
+     */
+    private suspend fun describeDocument(uri: Uri): DocumentInfo {
+        val documentInfo = extractDocumentInfo(uri)
+        if (!isSupportedFormat(documentInfo.mimeType)) {
+            throw DocumentProcessingException("Unsupported file format: ${documentInfo.mimeType}")
         }
+        return documentInfo
     }
     
-    private suspend fun generateEmbeddingsForChunks(
-        chunks: List<DocumentChunk>,
-        documentId: String
-    ): List<EmbeddedChunk> {
-        return chunks.mapIndexed { index, chunk ->
-            try {
-                val embedding = embeddingService.generateEmbedding(chunk.content)
-                
-                EmbeddedChunk(
-                    id = "${documentId}_chunk_${index}",
-                    documentId = documentId,
-                    content = chunk.content,
-                    embedding = embedding,
-                    startIndex = chunk.startIndex,
-                    endIndex = chunk.endIndex,
-                    metadata = chunk.metadata
-                )
-            } catch (e: Exception) {
-                Log.w(TAG, "Failed to generate embedding for chunk $index", e)
-                // Return chunk with empty embedding as fallback
-                EmbeddedChunk(
-                    id = "${documentId}_chunk_${index}",
-                    documentId = documentId,
-                    content = chunk.content,
-                    embedding = FloatArray(384), // Empty embedding
-                    startIndex = chunk.startIndex,
-                    endIndex = chunk.endIndex,
-                    metadata = chunk.metadata
-                )
-            }
+    private fun isSupportedFormat(mimeType: String): Boolean {
+        return SUPPORTED_MIME_TYPES.split(",").any { supportedType ->
+            mimeType.startsWith(supportedType.trim())
         }
     }
-    
-    private fun generateDocumentId(): String {
-        return "doc_${System.currentTimeMillis()}_${(100000..999999).random()}"
-    }
 }
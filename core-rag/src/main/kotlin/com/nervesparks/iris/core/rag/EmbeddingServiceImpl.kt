@@ -22,6 +22,11 @@ class EmbeddingServiceImpl @Inject constructor() : EmbeddingService {
         private const val EMBEDDING_DIM = 384 // Standard dimension for many embedding models
     }
     
+    override val modelFingerprint: String = "hash-embedding-v1:$EMBEDDING_DIM"
+    
+    // Hash features, not a model: nearness says little about meaning
+    override val isSemantic: Boolean = false
+    
     override suspend fun generateEmbedding(text: String): FloatArray = withContext(Dispatchers.Default) {
         try {
             // Generate a deterministic embedding based on text content
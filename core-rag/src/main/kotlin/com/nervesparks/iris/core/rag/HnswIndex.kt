@@ -0,0 +1,147 @@
+package com.nervesparks.iris.core.rag
+
+import android.util.Log
+import java.io.Closeable
+
+/**
+ * Result of a native index lookup
+ */
+data class IndexHit(
+    val label: Int,
+    val score: Float
+)
+
+/**
+ * Handle to the native HNSW graph index (libiris_rag)
+ *
+ * Vectors are L2-normalized on insert, so returned scores are cosine similarities.
+ * Inserts and searches are safe to call concurrently; the native side does its own locking.
+ */
+class HnswIndex(
+    val dimension: Int,
+    m: Int = DEFAULT_M,
+    efConstruction: Int = DEFAULT_EF_CONSTRUCTION,
+    initialCapacity: Int = DEFAULT_CAPACITY
+) : Closeable {
+
+    companion object {
+        private const val TAG = "HnswIndex"
+        const val DEFAULT_M = 16
+        const val DEFAULT_EF_CONSTRUCTION = 200
+        const val DEFAULT_EF_SEARCH = 64
+        private const val DEFAULT_CAPACITY = 1024
+
+        // Native library loading - callers fall back to Kotlin search when unavailable
+        var isNativeAvailable = false
+            private set
+
+        init {
+            try {
+                System.loadLibrary("iris_rag")
+                isNativeAvailable = true
+                Log.i(TAG, "Native RAG library loaded successfully")
+            } catch (e: UnsatisfiedLinkError) {
+                Log.w(TAG, "Native RAG library not available, using Kotlin vector search", e)
+                isNativeAvailable = false
+            }
+        }
+    }
+
+    private var handle: Long = nativeCreate(dimension, m, efConstruction, initialCapacity)
+
+    /**
+     * Number of live vectors in the index
+     */
+    val size: Int
+        get() = if (handle != 0L) nativeSize(handle) else 0
+
+    /**
+     * Insert vectors; an existing label is replaced
+     * @param labels One label per vector
+     * @param vectors Row-major vectors, `labels.size * dimension` floats
+     * @param threads Number of native threads used to build the graph
+     */
+    fun add(labels: IntArray, vectors: FloatArray, threads: Int = Runtime.getRuntime().availableProcessors()) {
+        check(handle != 0L) { "Index is closed" }
+        require(vectors.size == labels.size * dimension) { "Expected ${labels.size * dimension} floats, got ${vectors.size}" }
+        nativeAdd(handle, labels, vectors, threads)
+    }
+
+    /**
+     * Insert rows of a [VectorFile] straight from its mapping; labels are row numbers
+     */
+    fun addFromFile(file: VectorFile, rows: IntArray, threads: Int = Runtime.getRuntime().availableProcessors()) {
+        check(handle != 0L) { "Index is closed" }
+        require(file.dimension == dimension) { "Store dimension ${file.dimension} != index dimension $dimension" }
+        nativeAddFromFile(handle, file.nativeHandle, rows, threads)
+    }
+
+    /**
+     * Remove a vector; searches skip it immediately
+     */
+    fun remove(label: Int): Boolean {
+        check(handle != 0L) { "Index is closed" }
+        return nativeRemove(handle, label)
+    }
+
+    /**
+     * Approximate top-k search
+     * @param ef Candidate list size; raise for recall, lower for latency
+     * @param rows Only return these labels; other nodes are still traversed.
+     *        Recall drops for very selective sets, which are better scanned.
+     * @return Hits sorted by descending score
+     */
+    fun search(query: FloatArray, k: Int, ef: Int = DEFAULT_EF_SEARCH, rows: RowBitmap? = null): List<IndexHit> {
+        check(handle != 0L) { "Index is closed" }
+        if (k <= 0) return emptyList()
+
+        val labels = IntArray(k)
+        val scores = FloatArray(k)
+        val count = nativeSearch(handle, query, k, maxOf(ef, k), rows?.nativeHandle ?: 0L, labels, scores)
+        return List(count) { IndexHit(labels[it], scores[it]) }
+    }
+
+    /**
+     * Exact top-k over every vector using the native SIMD block kernels
+     */
+    fun exactSearch(query: FloatArray, k: Int): List<IndexHit> {
+        check(handle != 0L) { "Index is closed" }
+        if (k <= 0) return emptyList()
+
+        val labels = IntArray(k)
+        val scores = FloatArray(k)
+        val count = nativeExactSearch(handle, query, k, labels, scores)
+        return List(count) { IndexHit(labels[it], scores[it]) }
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeCreate(dimension: Int, m: Int, efConstruction: Int, capacity: Int): Long
+    private external fun nativeAdd(handle: Long, labels: IntArray, vectors: FloatArray, threads: Int)
+    private external fun nativeAddFromFile(handle: Long, fileHandle: Long, rows: IntArray, threads: Int)
+    private external fun nativeRemove(handle: Long, label: Int): Boolean
+    private external fun nativeSearch(
+        handle: Long,
+        query: FloatArray,
+        k: Int,
+        ef: Int,
+        filterHandle: Long,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+    private external fun nativeExactSearch(
+        handle: Long,
+        query: FloatArray,
+        k: Int,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+    private external fun nativeSize(handle: Long): Int
+    private external fun nativeFree(handle: Long)
+}
@@ -0,0 +1,568 @@
+package com.nervesparks.iris.core.rag
+
+import android.net.Uri
+import android.util.Log
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.channels.Channel
+import kotlinx.coroutines.channels.ReceiveChannel
+import kotlinx.coroutines.channels.SendChannel
+import kotlinx.coroutines.flow.Flow
+import kotlinx.coroutines.flow.channelFlow
+import kotlinx.coroutines.joinAll
+import kotlinx.coroutines.launch
+import java.io.File
+import java.util.Collections
+import java.util.Properties
+import java.util.concurrent.atomic.AtomicInteger
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * A document to ingest
+ */
+data class IngestJob(
+    val uri: Uri,
+    val metadata: DocumentMetadata? = null
+)
+
+/**
+ * Work done by one ingestion stage. [perSecond] is measured over the time the
+ * stage was busy, not waiting on its neighbours, so the slowest stage is the
+ * one with the lowest rate. Extraction counts documents; the other stages count chunks.
+ */
+data class StageThroughput(
+    val stage: String,
+    val items: Long,
+    val busyMillis: Double
+) {
+    val perSecond: Double
+        get() = if (busyMillis > 0) items * 1000.0 / busyMillis else 0.0
+}
+
+/**
+ * What ingestion does with a chunk that nearly repeats one ingested before
+ */
+enum class DedupMode {
+    /** Embed and store every chunk */
+    OFF,
+
+    /** Store the chunk with the earlier chunk's embedding and a [IngestionPipeline.DUPLICATE_OF_KEY] link to it */
+    LINK,
+
+    /** Drop the chunk; its content is only found through the earlier chunk */
+    SKIP
+}
+
+/**
+ * Staged document ingestion: extract → chunk → embed → index
+ *
+ * Each stage runs in its own coroutine; stages are joined by bounded channels,
+ * so extraction (I/O), chunking and embedding (CPU) and store writes overlap
+ * across documents. A full channel suspends the stage feeding it. Memory stays
+ * bounded at a few extracted documents and [CHUNK_QUEUE_CAPACITY] chunks
+ * however many documents are queued.
+ * The embedding stage takes whatever chunks are waiting, up to
+ * [EMBED_BATCH_SIZE], into one [EmbeddingService.generateEmbeddings] call.
+ *
+ * Progress is checkpointed per document in `progressFile` after every stored
+ * batch. If ingestion is interrupted, running the same URI again reuses the
+ * document ID and skips the chunks already stored, as long as the extracted
+ * text has not changed.
+ *
+ * Before embedding, each chunk is checked against the chunks ingested so far
+ * by this pipeline with a [NearDuplicateIndex] (Jaccard similarity of word
+ * shingles, 0.8 or more), so repeated headers, boilerplate and forwarded
+ * copies are not embedded again; see [DedupMode]. The index is in memory and
+ * needs the native library; without it every chunk is embedded.
+ *
+ * @param describe Resolves name, size and type of a URI; throws for unsupported documents
+ */
+class IngestionPipeline(
+    private val textExtractor: TextExtractor,
+    private val chunkingService: ChunkingService,
+    private val embeddingService: EmbeddingService,
+    private val vectorStore: VectorStore,
+    progressFile: File,
+    private val describe: suspend (Uri) -> DocumentInfo,
+    private val dedup: DedupMode = DedupMode.LINK
+) {
+
+    companion object {
+        private const val TAG = "IngestionPipeline"
+
+        const val MAX_CHUNK_TOKENS = 254 // 256-token embedding context less [CLS] and [SEP]
+        const val CHUNK_OVERLAP_TOKENS = 32
+        const val EMBED_BATCH_SIZE = 32
+
+        private const val EXTRACT_WORKERS = 2
+        private const val DOCUMENT_QUEUE_CAPACITY = 2
+        private const val CHUNK_QUEUE_CAPACITY = 4 * EMBED_BATCH_SIZE
+        private const val BATCH_QUEUE_CAPACITY = 4
+        private const val FALLBACK_EMBEDDING_DIM = 384
+
+        /** Chunk metadata: ID of the chunk a [DedupMode.LINK] duplicate reuses the embedding of */
+        const val DUPLICATE_OF_KEY = "duplicate_of"
+
+        // Embeddings kept for linking, newest first; 384 floats each, about 3 MB
+        private const val LINKABLE_VECTORS = 2048
+    }
+
+    /**
+     * A document between extraction and its last stored chunk
+     */
+    private class Ingesting(
+        val uri: Uri,
+        val document: StoredDocument,
+        val resumeFrom: Int,
+        val textHash: Int,
+        val startTime: Long
+    ) {
+        @Volatile var chunkCount = 0
+        var stored = resumeFrom // index stage only
+        @Volatile var failed = false
+    }
+
+    private sealed class Work {
+        class Chunk(val doc: Ingesting, val index: Int, val chunk: DocumentChunk) : Work()
+        class Embedded(val doc: Ingesting, val chunks: List<EmbeddedChunk>, val skipped: Int) : Work()
+        class End(val doc: Ingesting) : Work()
+    }
+
+    private class StageMeter(val stage: String) {
+        val items = AtomicLong()
+        val busyNanos = AtomicLong()
+
+        inline fun <T> measure(block: () -> T): T {
+            val start = System.nanoTime()
+            try {
+                return block()
+            } finally {
+                busyNanos.addAndGet(System.nanoTime() - start)
+            }
+        }
+
+        fun count(n: Int) {
+            items.addAndGet(n.toLong())
+        }
+
+        fun throughput() = StageThroughput(stage, items.get(), busyNanos.get() / 1e6)
+    }
+
+    private val progress = ProgressFile(progressFile)
+
+    private val duplicates: NearDuplicateIndex? =
+        if (dedup != DedupMode.OFF && HnswIndex.isNativeAvailable) NearDuplicateIndex() else null
+    private val dedupLock = Any()
+    private var nextLabel = 0
+    private val labelChunks = mutableMapOf<Int, String>()
+    private val documentLabels = mutableMapOf<String, MutableList<Int>>()
+    private val linkableVectors = object : LinkedHashMap<String, FloatArray>(16, 0.75f, true) {
+        override fun removeEldestEntry(eldest: MutableMap.MutableEntry<String, FloatArray>) =
+            size > LINKABLE_VECTORS
+    }
+
+    /**
+     * Stop matching new chunks against a document's chunks, e.g. once it is deleted or re-chunked
+     */
+    fun forgetDocument(documentId: String) {
+        val index = duplicates ?: return
+        synchronized(dedupLock) {
+            for (label in documentLabels.remove(documentId).orEmpty()) {
+                index.remove(label)
+                labelChunks.remove(label)?.let { linkableVectors.remove(it) }
+            }
+        }
+    }
+
+    /**
+     * Ingest documents; results arrive as each document's last chunk is stored
+     */
+    fun run(jobs: List<IngestJob>): Flow<BatchProcessingResult> = channelFlow {
+        send(BatchProcessingResult.Started(jobs.size))
+
+        val meters = listOf("extract", "chunk", "embed", "index").map { StageMeter(it) }
+        val (extractMeter, chunkMeter, embedMeter, indexMeter) = meters
+        val duplicateChunks = AtomicInteger()
+        val finished = AtomicInteger()
+        val successes = AtomicInteger()
+        val errors = Collections.synchronizedList(mutableListOf<ProcessingError>())
+        val startTime = System.currentTimeMillis()
+
+        suspend fun failJob(uri: Uri, e: Throwable) {
+            Log.e(TAG, "Ingestion failed for $uri", e)
+            val error = ProcessingError(uri = uri, error = e.message ?: "Processing failed")
+            errors.add(error)
+            finished.incrementAndGet()
+            send(BatchProcessingResult.DocumentFailed(error))
+        }
+
+        suspend fun failDocument(doc: Ingesting, e: Throwable) {
+            if (!doc.failed) {
+                doc.failed = true
+                forgetDocument(doc.document.id)
+                failJob(doc.uri, e)
+            }
+        }
+
+        val pendingJobs = Channel<IngestJob>(Channel.UNLIMITED)
+        jobs.forEach { pendingJobs.trySend(it) }
+        pendingJobs.close()
+        val extracted = Channel<Ingesting>(DOCUMENT_QUEUE_CAPACITY)
+        val chunks = Channel<Work>(CHUNK_QUEUE_CAPACITY)
+        val batches = Channel<Work>(BATCH_QUEUE_CAPACITY)
+
+        // Extract: a few documents at once, mostly waiting on I/O
+        val extractors = List(EXTRACT_WORKERS) {
+            launch(Dispatchers.IO) {
+                for (job in pendingJobs) {
+                    val doc = try {
+                        extractMeter.measure { open(job) }
+                    } catch (e: Exception) {
+                        failJob(job.uri, e)
+                        continue
+                    }
+                    extractMeter.count(1)
+                    extracted.send(doc)
+                }
+            }
+        }
+        launch {
+            extractors.joinAll()
+            extracted.close()
+        }
+
+        // Chunk: one document at a time, in token-budget spans
+        launch(Dispatchers.Default) {
+            for (doc in extracted) {
+                val documentChunks = try {
+                    chunkMeter.measure {
+                        chunkingService.chunkByTokens(
+                            text = doc.document.textContent,
+                            maxTokens = MAX_CHUNK_TOKENS,
+                            overlapTokens = CHUNK_OVERLAP_TOKENS,
+                            documentId = doc.document.id
+                        )
+                    }
+                } catch (e: Exception) {
+                    failDocument(doc, e)
+                    continue
+                }
+                chunkMeter.count(documentChunks.size)
+                doc.chunkCount = documentChunks.size
+                for (i in doc.resumeFrom until documentChunks.size) {
+                    chunks.send(Work.Chunk(doc, i, documentChunks[i]))
+                }
+                chunks.send(Work.End(doc))
+            }
+            chunks.close()
+        }
+
+        // Embed: batches of whatever is queued
+        launch(Dispatchers.Default) {
+            embedStage(chunks, batches, embedMeter, duplicateChunks)
+            batches.close()
+        }
+
+        // Index: a single writer, so each document's chunks are stored in order
+        launch(Dispatchers.IO) {
+            for (work in batches) {
+                when (work) {
+                    is Work.Embedded -> {
+                        val doc = work.doc
+                        if (doc.failed) continue
+                        try {
+                            if (work.chunks.isNotEmpty()) {
+                                indexMeter.measure { vectorStore.saveChunks(work.chunks) }
+                                indexMeter.count(work.chunks.size)
+                            }
+                            // Skipped duplicates count as stored, so a resumed run does not redo them
+                            doc.stored += work.chunks.size + work.skipped
+                            progress.put(doc.uri, Progress(doc.document.id, doc.stored, doc.textHash))
+                        } catch (e: Exception) {
+                            failDocument(doc, e)
+                        }
+                    }
+                    is Work.End -> {
+                        val doc = work.doc
+                        if (doc.failed) continue
+                        try {
+                            vectorStore.updateDocument(
+                                doc.document.copy(chunkCount = doc.chunkCount, isProcessed = true)
+                            )
+                            progress.remove(doc.uri)
+                        } catch (e: Exception) {
+                            failDocument(doc, e)
+                            continue
+                        }
+                        successes.incrementAndGet()
+                        val done = finished.incrementAndGet()
+                        send(BatchProcessingResult.DocumentCompleted(
+                            uri = doc.uri,
+                            result = ProcessingResult(
+                                documentId = doc.document.id,
+                                title = doc.document.title,
+                                chunkCount = doc.chunkCount,
+                                characterCount = doc.document.textContent.length,
+                                processingTime = System.currentTimeMillis() - doc.startTime,
+                                success = true
+                            ),
+                            progress = (done * 100) / jobs.size
+                        ))
+                    }
+                    is Work.Chunk -> error("Unembedded chunk reached the index stage")
+                }
+            }
+
+            val throughput = meters.map { it.throughput() }
+            Log.i(TAG, "Ingested ${jobs.size} documents in ${System.currentTimeMillis() - startTime} ms: " +
+                throughput.joinToString { "${it.stage} %.0f/s".format(it.perSecond) } +
+                if (duplicateChunks.get() > 0) ", ${duplicateChunks.get()} near-duplicate chunks" else "")
+            send(BatchProcessingResult.Completed(
+                totalDocuments = jobs.size,
+                successCount = successes.get(),
+                errorCount = errors.size,
+                errors = errors.toList(),
+                stageThroughput = throughput
+            ))
+        }
+    }
+
+    /**
+     * Extract the text and register the document, resuming an interrupted run of the same URI
+     */
+    private suspend fun open(job: IngestJob): Ingesting {
+        val startTime = System.currentTimeMillis()
+        val info = describe(job.uri)
+        val text = textExtractor.extractText(job.uri, info).getOrElse {
+            throw DocumentProcessingException("Text extraction failed", it)
+        }
+        val textHash = text.hashCode()
+
+        val saved = progress.get(job.uri)
+        val resume = saved?.takeIf { it.textHash == textHash }
+        if (saved != null && resume == null) {
+            // The document changed since the interrupted run; its stored chunks are stale
+            vectorStore.deleteChunksByDocumentId(saved.documentId)
+            forgetDocument(saved.documentId)
+        }
+
+        val document = StoredDocument(
+            id = resume?.documentId ?: generateDocumentId(),
+            title = job.metadata?.title ?: info.fileName,
+            uri = job.uri.toString(),
+            mimeType = info.mimeType,
+            size = info.size,
+            textContent = text,
+            metadata = documentMetadata(job.metadata),
+            createdAt = System.currentTimeMillis(),
+            lastModified = info.lastModified,
+            chunkCount = 0,
+            isProcessed = false
+        )
+        vectorStore.saveDocument(document)
+        val storedChunks = resume?.storedChunks ?: 0
+        progress.put(job.uri, Progress(document.id, storedChunks, textHash))
+        if (storedChunks > 0) {
+            Log.i(TAG, "Resuming ${document.id} after $storedChunks stored chunks")
+        }
+        return Ingesting(job.uri, document, storedChunks, textHash, startTime)
+    }
+
+    /**
+     * Caller properties plus the tags, which chunks inherit for [SearchFilter]
+     */
+    private fun documentMetadata(metadata: DocumentMetadata?): Map<String, String> {
+        val properties = metadata?.properties ?: emptyMap()
+        if (metadata == null || metadata.tags.isEmpty()) return properties
+        return properties + (SearchFilter.TAGS_KEY to metadata.tags.joinToString(","))
+    }
+
+    private suspend fun embedStage(
+        input: ReceiveChannel<Work>,
+        output: SendChannel<Work>,
+        meter: StageMeter,
+        duplicateChunks: AtomicInteger
+    ) {
+        val batch = ArrayList<Work.Chunk>(EMBED_BATCH_SIZE)
+
+        suspend fun flush() {
+            if (batch.isEmpty()) return
+            val originals = meter.measure { findDuplicates(batch) }
+            val vectors = meter.measure { embedUnique(batch, originals) }
+            meter.count(batch.size)
+            duplicateChunks.addAndGet(originals.count { it != null })
+
+            // Batches may span documents; the index stage gets one list per document
+            var start = 0
+            while (start < batch.size) {
+                val doc = batch[start].doc
+                var end = start
+                while (end < batch.size && batch[end].doc === doc) end++
+                val facets = SearchFilter.facetsOf(doc.document)
+                val kept = (start until end).mapNotNull { i ->
+                    val item = batch[i]
+                    val embedding = vectors[i] ?: return@mapNotNull null
+                    val link = originals[i]?.let { mapOf(DUPLICATE_OF_KEY to it) } ?: emptyMap()
+                    EmbeddedChunk(
+                        id = chunkId(doc, item.index),
+                        documentId = doc.document.id,
+                        content = item.chunk.content,
+                        embedding = embedding,
+                        startIndex = item.chunk.startIndex,
+                        endIndex = item.chunk.endIndex,
+                        metadata = item.chunk.metadata + facets + link
+                    )
+                }
+                output.send(Work.Embedded(doc, kept, skipped = end - start - kept.size))
+                start = end
+            }
+            batch.clear()
+        }
+
+        suspend fun accept(work: Work) {
+            when (work) {
+                is Work.Chunk -> if (!work.doc.failed) batch.add(work)
+                is Work.End -> {
+                    flush()
+                    output.send(work)
+                }
+                is Work.Embedded -> error("Embedded work in the embedding queue")
+            }
+        }
+
+        for (work in input) {
+            accept(work)
+            // Take whatever else is already queued, up to a full batch, before embedding
+            while (batch.size in 1 until EMBED_BATCH_SIZE) {
+                accept(input.tryReceive().getOrNull() ?: break)
+            }
+            flush()
+        }
+    }
+
+    private fun chunkId(doc: Ingesting, index: Int) = "${doc.document.id}_chunk_$index"
+
+    /**
+     * Per chunk, the ID of an earlier chunk it nearly repeats, or null; the others are
+     * registered so later chunks, including ones later in this batch, can match them
+     */
+    private fun findDuplicates(batch: List<Work.Chunk>): List<String?> {
+        val index = duplicates ?: return List(batch.size) { null }
+        synchronized(dedupLock) {
+            val labels = IntArray(batch.size) { nextLabel++ }
+            val matches = index.addOrMatch(labels, Array(batch.size) { batch[it].chunk.content })
+            return batch.indices.map { i ->
+                if (matches[i] >= 0) {
+                    labelChunks[matches[i]]
+                } else {
+                    val item = batch[i]
+                    labelChunks[labels[i]] = chunkId(item.doc, item.index)
+                    documentLabels.getOrPut(item.doc.document.id) { mutableListOf() }.add(labels[i])
+                    null
+                }
+            }
+        }
+    }
+
+    /**
+     * Embeddings for the batch: null for a skipped duplicate, the original's for a
+     * linked one while it is still cached, otherwise computed
+     */
+    private suspend fun embedUnique(batch: List<Work.Chunk>, originals: List<String?>): List<FloatArray?> {
+        if (duplicates == null) return embed(batch.map { it.chunk.content })
+
+        val vectors = arrayOfNulls<FloatArray>(batch.size)
+        val unique = batch.indices.filter { originals[it] == null }
+        embed(unique.map { batch[it].chunk.content }).forEachIndexed { j, vector -> vectors[unique[j]] = vector }
+        synchronized(dedupLock) {
+            for (i in unique) {
+                linkableVectors[chunkId(batch[i].doc, batch[i].index)] = vectors[i]!!
+            }
+            if (dedup == DedupMode.LINK) {
+                for (i in batch.indices) {
+                    vectors[i] = vectors[i] ?: linkableVectors[originals[i]]
+                }
+            }
+        }
+        if (dedup == DedupMode.LINK) {
+            // Originals that aged out of the cache: embed the duplicate after all
+            val unlinked = batch.indices.filter { vectors[it] == null }
+            embed(unlinked.map { batch[it].chunk.content }).forEachIndexed { j, vector -> vectors[unlinked[j]] = vector }
+        }
+        return vectors.toList()
+    }
+
+    /**
+     * One batched call; if it fails, chunks are embedded one by one and a chunk that
+     * still fails gets a zero vector rather than failing its document
+     */
+    private suspend fun embed(texts: List<String>): List<FloatArray> {
+        if (texts.isEmpty()) return emptyList()
+        try {
+            return embeddingService.generateEmbeddings(texts)
+        } catch (e: Exception) {
+            Log.w(TAG, "Batch embedding failed, embedding ${texts.size} chunks one by one", e)
+        }
+        return texts.mapIndexed { index, text ->
+            try {
+                embeddingService.generateEmbedding(text)
+            } catch (e: Exception) {
+                Log.w(TAG, "Failed to generate embedding for chunk $index", e)
+                FloatArray(FALLBACK_EMBEDDING_DIM)
+            }
+        }
+    }
+
+    private fun generateDocumentId(): String {
+        return "doc_${System.currentTimeMillis()}_${(100000..999999).random()}"
+    }
+
+    private data class Progress(val documentId: String, val storedChunks: Int, val textHash: Int)
+
+    /**
+     * Unfinished documents by URI, rewritten atomically on every change
+     */
+    private class ProgressFile(private val file: File) {
+        private val entries = Properties()
+
+        init {
+            if (file.exists()) {
+                try {
+                    file.inputStream().use { entries.load(it) }
+                } catch (e: Exception) {
+                    Log.w(TAG, "Ignoring unreadable ingestion progress ${file.name}", e)
+                }
+            }
+        }
+
+        @Synchronized
+        fun get(uri: Uri): Progress? {
+            val fields = entries.getProperty(uri.toString())?.split(',') ?: return null
+            if (fields.size != 3) return null
+            val storedChunks = fields[1].toIntOrNull() ?: return null
+            val textHash = fields[2].toIntOrNull() ?: return null
+            return Progress(fields[0], storedChunks, textHash)
+        }
+
+        @Synchronized
+        fun put(uri: Uri, progress: Progress) {
+            entries.setProperty(uri.toString(), "${progress.documentId},${progress.storedChunks},${progress.textHash}")
+            save()
+        }
+
+        @Synchronized
+        fun remove(uri: Uri) {
+            if (entries.remove(uri.toString()) != null) {
+                save()
+            }
+        }
+
+        private fun save() {
+            file.parentFile?.mkdirs()
+            val temp = File(file.path + ".tmp")
+            temp.outputStream().use { entries.store(it, null) }
+            if (!temp.renameTo(file)) {
+                Log.w(TAG, "Could not write ingestion progress ${file.name}")
+            }
+        }
+    }
+}
@@ -0,0 +1,183 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+import java.io.File
+
+/**
+ * Handle to the native IVF-PQ index (libiris_rag) over the rows of a [VectorFile]
+ *
+ * Vectors are kept as product-quantized residuals in `nlist` inverted lists, so
+ * the index costs a few dozen bytes per chunk while the f32 vectors stay in the
+ * memory-mapped store. Searches probe the [nprobe][search] nearest lists and
+ * rescore the shortlist exactly against the store; labels are row numbers.
+ * Adds, removes and searches are safe to call concurrently.
+ */
+class IvfPqIndex private constructor(private var handle: Long) : Closeable {
+
+    companion object {
+        const val DEFAULT_NPROBE = 16
+        const val DEFAULT_TRAINING_ITERATIONS = 10
+        const val MAX_TRAINING_SAMPLES = 32768
+        private const val CODEBOOK_SIZE = 256
+
+        /**
+         * Subspaces for a dimension: 8-dim subvectors, one byte each
+         */
+        fun defaultSubquantizers(dimension: Int): Int {
+            var m = maxOf(dimension / 8, 1)
+            while (dimension % m != 0) m--
+            return m
+        }
+
+        /**
+         * About sqrt(rows) lists, bounded so every list gets training samples
+         */
+        fun defaultNlist(rows: Int): Int =
+            Math.sqrt(rows.toDouble()).toInt().coerceIn(16, MAX_TRAINING_SAMPLES / 32)
+
+        /**
+         * Smallest store that can be trained
+         */
+        fun minTrainingRows(nlist: Int): Int = maxOf(nlist, CODEBOOK_SIZE)
+
+        /**
+         * Train a new index on a sample of `file`'s live rows; rows are not added
+         */
+        fun train(
+            file: VectorFile,
+            nlist: Int = defaultNlist(file.liveCount),
+            subquantizers: Int = defaultSubquantizers(file.dimension),
+            threads: Int = Runtime.getRuntime().availableProcessors()
+        ): IvfPqIndex {
+            check(HnswIndex.isNativeAvailable) { "Native RAG library not available" }
+            val index = IvfPqIndex(nativeCreate(file.dimension, nlist, subquantizers))
+            try {
+                index.nativeTrainFromFile(
+                    index.handle, file.nativeHandle, MAX_TRAINING_SAMPLES, DEFAULT_TRAINING_ITERATIONS, threads
+                )
+            } catch (e: Exception) {
+                index.close()
+                throw e
+            }
+            return index
+        }
+
+        /**
+         * Load an index written by [save]
+         */
+        fun load(file: File): IvfPqIndex {
+            check(HnswIndex.isNativeAvailable) { "Native RAG library not available" }
+            return IvfPqIndex(nativeLoad(file.absolutePath))
+        }
+
+        @JvmStatic
+        private external fun nativeCreate(dimension: Int, nlist: Int, subquantizers: Int): Long
+
+        @JvmStatic
+        private external fun nativeLoad(path: String): Long
+    }
+
+    val size: Int
+        get() = if (handle != 0L) nativeSize(handle) else 0
+
+    /**
+     * Number of rows the quantizers were trained on; retrain once the store outgrows it
+     */
+    val trainedOn: Int
+        get() = if (handle != 0L) nativeTrainedOn(handle) else 0
+
+    /**
+     * Encode rows of `file`; deleted rows are skipped and existing labels replaced
+     */
+    fun addFromFile(file: VectorFile, rows: IntArray) {
+        check(handle != 0L) { "Index is closed" }
+        if (rows.isNotEmpty()) {
+            nativeAddFromFile(handle, file.nativeHandle, rows)
+        }
+    }
+
+    /**
+     * Bring the index in line with `file`'s live rows
+     */
+    fun syncWith(file: VectorFile) {
+        check(handle != 0L) { "Index is closed" }
+        nativeSyncWithFile(handle, file.nativeHandle)
+    }
+
+    fun remove(label: Int): Boolean {
+        check(handle != 0L) { "Index is closed" }
+        return nativeRemove(handle, label)
+    }
+
+    /**
+     * Rename each label `l` to `mapping[l]` after the store was compacted;
+     * labels mapped to -1 are dropped. Codes are kept, nothing is re-encoded.
+     */
+    fun relabel(mapping: IntArray) {
+        check(handle != 0L) { "Index is closed" }
+        nativeRelabel(handle, mapping)
+    }
+
+    /**
+     * Approximate top-k, rescored against `file`
+     * @param nprobe Lists scanned; raise for recall, lower for latency
+     * @param candidates Shortlist size rescored exactly
+     * @param rows Only consider these labels
+     */
+    fun search(
+        file: VectorFile,
+        query: FloatArray,
+        k: Int,
+        nprobe: Int,
+        candidates: Int,
+        rows: RowBitmap? = null
+    ): List<IndexHit> {
+        check(handle != 0L) { "Index is closed" }
+        if (k <= 0) return emptyList()
+
+        val labels = IntArray(k)
+        val scores = FloatArray(k)
+        val count = nativeSearch(handle, file.nativeHandle, query, k, nprobe, candidates, rows?.nativeHandle ?: 0L, labels, scores)
+        return List(count) { IndexHit(labels[it], scores[it]) }
+    }
+
+    fun save(file: File) {
+        check(handle != 0L) { "Index is closed" }
+        nativeSave(handle, file.absolutePath)
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeTrainFromFile(
+        handle: Long,
+        fileHandle: Long,
+        maxSamples: Int,
+        iterations: Int,
+        threads: Int
+    )
+    private external fun nativeAddFromFile(handle: Long, fileHandle: Long, rows: IntArray)
+    private external fun nativeSyncWithFile(handle: Long, fileHandle: Long)
+    private external fun nativeRemove(handle: Long, label: Int): Boolean
+    private external fun nativeRelabel(handle: Long, mapping: IntArray)
+    private external fun nativeSearch(
+        handle: Long,
+        fileHandle: Long,
+        query: FloatArray,
+        k: Int,
+        nprobe: Int,
+        candidates: Int,
+        filterHandle: Long,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+    private external fun nativeSave(handle: Long, path: String)
+    private external fun nativeSize(handle: Long): Int
+    private external fun nativeTrainedOn(handle: Long): Int
+    private external fun nativeFree(handle: Long)
+}
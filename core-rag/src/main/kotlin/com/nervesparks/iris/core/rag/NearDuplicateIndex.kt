@@ -0,0 +1,68 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+
+/**
+ * Handle to the native near-duplicate index (libiris_rag)
+ *
+ * Texts are compared as sets of 3-word shingles. Each gets a MinHash signature
+ * of `bands * rows` values, and LSH buckets on whole bands find candidates
+ * without comparing against every indexed text; a candidate whose estimated
+ * Jaccard similarity reaches `threshold` is a duplicate. With the defaults a
+ * pair at 0.8 is found 95% of the time and one at 0.5 is almost never looked
+ * at. Labels are chosen by the caller. Safe to call from several threads.
+ */
+class NearDuplicateIndex(
+    bands: Int = DEFAULT_BANDS,
+    rows: Int = DEFAULT_ROWS,
+    threshold: Float = DEFAULT_THRESHOLD
+) : Closeable {
+
+    companion object {
+        const val DEFAULT_BANDS = 16
+        const val DEFAULT_ROWS = 8
+
+        // Reworded or reformatted copies of a chunk; chunks merely on the same topic stay far below
+        const val DEFAULT_THRESHOLD = 0.8f
+    }
+
+    private var handle: Long = nativeCreate(bands, rows, threshold)
+
+    /**
+     * Number of indexed texts
+     */
+    val size: Int
+        get() = if (handle != 0L) nativeSize(handle) else 0
+
+    /**
+     * Index each text under its label unless it duplicates one already indexed,
+     * including one earlier in the same call
+     * @return Per text, the label it duplicates (and it is not indexed), or -1
+     */
+    fun addOrMatch(labels: IntArray, texts: Array<String>): IntArray {
+        check(handle != 0L) { "Index is closed" }
+        require(labels.size == texts.size) { "Expected ${labels.size} texts, got ${texts.size}" }
+        val matches = IntArray(labels.size)
+        nativeAddOrMatch(handle, labels, texts, matches)
+        return matches
+    }
+
+    fun remove(label: Int): Boolean {
+        check(handle != 0L) { "Index is closed" }
+        return nativeRemove(handle, label)
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeCreate(bands: Int, rows: Int, threshold: Float): Long
+    private external fun nativeAddOrMatch(handle: Long, labels: IntArray, texts: Array<String>, outMatches: IntArray)
+    private external fun nativeRemove(handle: Long, label: Int): Boolean
+    private external fun nativeSize(handle: Long): Int
+    private external fun nativeFree(handle: Long)
+}
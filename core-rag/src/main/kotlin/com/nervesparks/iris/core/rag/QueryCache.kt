@@ -0,0 +1,146 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+
+/**
+ * Query cache counters
+ *
+ * @property lookups Queries looked up; the semantic tier is only tried after an exact miss
+ * @property invalidations Entries dropped because the index changed
+ * @property savedMillis Search time the hits replaced, not counting embeddings semantic hits still paid for
+ */
+data class QueryCacheStats(
+    val lookups: Long,
+    val exactHits: Long,
+    val semanticHits: Long,
+    val invalidations: Long,
+    val evictions: Long,
+    val entries: Int,
+    val savedMillis: Double
+) {
+    val hitRate: Float
+        get() = if (lookups == 0L) 0f else (exactHits + semanticHits).toFloat() / lookups
+}
+
+/**
+ * Handle to the native two-tier query cache (libiris_rag)
+ *
+ * Results are found by normalized query text (case, punctuation and spacing
+ * ignored) or, failing that, by a cached query embedding with cosine similarity
+ * of at least `minSimilarity`. Every call carries the version of the index the
+ * results came from: a newer version empties the cache, and results computed
+ * under an older one are not stored. The least recently used entry is evicted
+ * when full. The native side keeps keys and embeddings; results stay here in
+ * the slot it assigns them.
+ */
+class QueryCache<T>(
+    private val capacity: Int = DEFAULT_CAPACITY,
+    minSimilarity: Float = DEFAULT_MIN_SIMILARITY
+) : Closeable {
+
+    companion object {
+        const val DEFAULT_CAPACITY = 256
+
+        // Paraphrases of one question embed above this; related questions stay well below
+        const val DEFAULT_MIN_SIMILARITY = 0.95f
+
+        private const val STATS_FIELDS = 7
+    }
+
+    private var handle: Long = nativeCreate(capacity, minSimilarity)
+    private val results = arrayOfNulls<Any>(capacity)
+
+    /**
+     * Results cached for this query (same normalized text) holding at least `k` items
+     */
+    @Synchronized
+    fun getExact(query: String, version: Long, k: Int): T? {
+        check(handle != 0L) { "Cache is closed" }
+        return resultAt(nativeLookupExact(handle, query, version, k))
+    }
+
+    /**
+     * Results of the most similar cached query embedding, if similar enough, holding at least `k` items
+     */
+    @Synchronized
+    fun getSimilar(embedding: FloatArray, version: Long, k: Int): T? {
+        check(handle != 0L) { "Cache is closed" }
+        return resultAt(nativeLookupSimilar(handle, embedding, version, k))
+    }
+
+    /**
+     * Cache `value`, the top `k` results for `query` under `version`
+     * @param costMillis Time the search took
+     * @param embedMillis Part of it spent embedding the query
+     */
+    @Synchronized
+    fun put(
+        query: String,
+        embedding: FloatArray?,
+        version: Long,
+        k: Int,
+        value: T,
+        costMillis: Double,
+        embedMillis: Double
+    ) {
+        check(handle != 0L) { "Cache is closed" }
+        val slot = nativePut(handle, query, embedding, version, k, costMillis, embedMillis)
+        if (slot in 0 until capacity) {
+            results[slot] = value
+        }
+    }
+
+    @Synchronized
+    fun clear() {
+        if (handle != 0L) {
+            nativeClear(handle)
+            results.fill(null)
+        }
+    }
+
+    @Synchronized
+    fun stats(): QueryCacheStats {
+        val values = LongArray(STATS_FIELDS)
+        if (handle != 0L) {
+            nativeStats(handle, values)
+        }
+        return QueryCacheStats(
+            lookups = values[0],
+            exactHits = values[1],
+            semanticHits = values[2],
+            invalidations = values[3],
+            evictions = values[4],
+            entries = values[5].toInt(),
+            savedMillis = values[6] / 1000.0
+        )
+    }
+
+    @Synchronized
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+            results.fill(null)
+        }
+    }
+
+    @Suppress("UNCHECKED_CAST")
+    private fun resultAt(slot: Int): T? = if (slot in 0 until capacity) results[slot] as T? else null
+
+    // Native method declarations
+    private external fun nativeCreate(capacity: Int, minSimilarity: Float): Long
+    private external fun nativeLookupExact(handle: Long, query: String, version: Long, k: Int): Int
+    private external fun nativeLookupSimilar(handle: Long, embedding: FloatArray, version: Long, k: Int): Int
+    private external fun nativePut(
+        handle: Long,
+        query: String,
+        embedding: FloatArray?,
+        version: Long,
+        k: Int,
+        costMs: Double,
+        embedMs: Double
+    ): Int
+    private external fun nativeClear(handle: Long)
+    private external fun nativeStats(handle: Long, outStats: LongArray)
+    private external fun nativeFree(handle: Long)
+}
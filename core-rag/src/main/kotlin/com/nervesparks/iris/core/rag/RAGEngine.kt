@@ -61,6 +61,11 @@ interface RAGEngine {
      */
     suspend fun search(query: String, limit: Int = 5): List<RetrievedChunk>
     
+    /**
+     * Whether search results are picked by a [Reranker], so a few of them carry the relevant context
+     */
+    val reranks: Boolean get() = false
+    
     /**
      * Delete a document from the index
      */
@@ -81,3 +86,13 @@ interface RAGEngine {
      */
     suspend fun optimizeIndex(): Result<Unit>
 }
+
+/**
+ * Cross-encoder that scores retrieved passages against their query
+ */
+interface Reranker {
+    /**
+     * @return One relevance score per passage, in input order; higher is more relevant
+     */
+    suspend fun score(query: String, passages: List<String>): FloatArray
+}
@@ -10,17 +10,75 @@ import kotlin.math.sqrt
 /**
  * Production-ready implementation of RAGEngine
  * Uses in-memory vector storage with TF-IDF embeddings
+ * 
+ * Chunks are ranked by TF-IDF cosine similarity with the smoothed
+ * idf = ln((N + 1) / (df + 1)) + 1. With libiris_rag loaded the ranking runs in
+ * a native [TfIdfIndex] (interned terms, CSR postings, term-at-a-time scoring),
+ * so a query touches only the chunks sharing one of its terms and deleting a
+ * document only updates the frequencies of its chunks' terms. Without it every
+ * chunk is scored in Kotlin with the same weighting.
+ * 
+ * When a [VectorStore] and [EmbeddingService] are available, search is hybrid:
+ * this engine's TF-IDF ranking, the store's BM25 ranking and its embedding
+ * ranking are merged with reciprocal-rank fusion ([RankFusion]), so exact names,
+ * codes and numbers are found even when the embedding misses them. The
+ * embedding ranking only joins when [EmbeddingService.isSemantic]; a placeholder
+ * embedder's ranking would only dilute the lexical ones.
+ * 
+ * With a [reranker] attached, a deeper candidate list is retrieved and the
+ * cross-encoder picks the best `limit` of it, so a few precise chunks can go
+ * into the prompt instead of many loosely related ones.
+ * 
+ * Search results are kept in a native [QueryCache]: a repeated question (same
+ * words, any case or punctuation) skips the embedding and the search, and a
+ * rephrased one whose embedding is close enough skips the search. Any change to
+ * this engine's chunks or the store's invalidates the cache.
  */
 @Singleton
-class RAGEngineImpl @Inject constructor() : RAGEngine {
+class RAGEngineImpl @Inject constructor(
+    private val vectorStore: VectorStore?,
+    private val embeddingService: EmbeddingService?
+) : RAGEngine {
+    
+    /**
+     * Lexical-only engine with nothing to fuse with
+     */
+    constructor() : this(null, null)
+    
+    /**
+     * Reorders search candidates when set; null keeps retrieval order
+     */
+    @Volatile
+    var reranker: Reranker? = null
+        set(value) {
+            field = value
+            queryCache?.clear() // cached results were ordered by the previous reranker
+        }
+    
+    override val reranks: Boolean get() = reranker != null
+    
+    // Recent search results, when the native library is available
+    private val queryCache: QueryCache<List<RetrievedChunk>>? =
+        if (HnswIndex.isNativeAvailable) QueryCache() else null
+    
+    // Bumped by every change to this engine's chunks; part of the cache version
+    @Volatile
+    private var localVersion = 0L
     
     // Thread-safe storage
     private val mutex = Mutex()
     private val documents = mutableMapOf<String, Document>()
     private val chunks = mutableMapOf<String, DocumentChunk>()
-    private val termFrequencies = mutableMapOf<String, MutableMap<String, Int>>()
+    private val documentFrequencies = mutableMapOf<String, Int>() // Kotlin fallback only
     private var documentCount = 0
     
+    // Native TF-IDF index, when available; chunks are labelled with a running counter
+    private val tfidfIndex: TfIdfIndex? =
+        if (HnswIndex.isNativeAvailable) TfIdfIndex(stopWords, MIN_TERM_LENGTH) else null
+    private var nextLabel = 0
+    private val chunkLabels = mutableMapOf<String, Int>()
+    private val labelChunks = mutableMapOf<Int, DocumentChunk>()
+    
     // Chunking configuration
     private val chunkSize = 512 // characters per chunk
     private val chunkOverlap = 128 // overlap between chunks
@@ -34,8 +92,7 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
         val chunkIndex: Int,
         val content: String,
         val metadata: Map<String, Any>,
-        val terms: Map<String, Int>, // term frequencies
-        val magnitude: Double // vector magnitude for cosine similarity
+        val terms: Map<String, Int> // term frequencies; empty when the native index holds them
     )
     
     override suspend fun indexDocument(document: Document): Result<Unit> = mutex.withLock {
@@ -46,17 +103,15 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
             // Chunk the document
             val documentChunks = chunkDocument(document)
             
-            // Index each chunk
+            // Index each chunk, replacing any indexed under the same ID
             for (chunk in documentChunks) {
+                removeChunk(chunk.id)
                 chunks[chunk.id] = chunk
-                
-                // Update term frequencies for IDF calculation
-                for (term in chunk.terms.keys) {
-                    termFrequencies.getOrPut(term) { mutableMapOf() }[chunk.id] = chunk.terms[term]!!
-                }
             }
+            addToIndex(documentChunks)
             
             documentCount++
+            localVersion++
             
             Result.success(Unit)
         } catch (e: Exception) {
@@ -64,46 +119,166 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
         }
     }
     
-    override suspend fun search(query: String, limit: Int): List<RetrievedChunk> = mutex.withLock {
-        if (chunks.isEmpty()) {
+    override suspend fun search(query: String, limit: Int): List<RetrievedChunk> {
+        if (limit <= 0) {
             return emptyList()
         }
+        val cache = queryCache
+        val version = cacheVersion()
+        if (cache == null || version == null) {
+            return searchUncached(query, queryEmbedding(query), limit)
+        }
         
-        // Extract terms from query
-        val queryTerms = extractTerms(query)
-        if (queryTerms.isEmpty()) {
-            return emptyList()
+        val start = System.nanoTime()
+        cache.getExact(query, version, limit)?.let { return it.take(limit) }
+        val embedding = queryEmbedding(query)
+        val embedMillis = (System.nanoTime() - start) / 1e6
+        if (embedding != null) {
+            cache.getSimilar(embedding, version, limit)?.let { return it.take(limit) }
+        }
+        val results = searchUncached(query, embedding, limit)
+        cache.put(query, embedding, version, limit, results, (System.nanoTime() - start) / 1e6, embedMillis)
+        return results
+    }
+    
+    /**
+     * Query cache counters; null when the native library is unavailable
+     */
+    fun getQueryCacheStats(): QueryCacheStats? = queryCache?.stats()
+    
+    /**
+     * Retrieval plus reranking, without the cache
+     */
+    private suspend fun searchUncached(query: String, embedding: FloatArray?, limit: Int): List<RetrievedChunk> {
+        val crossEncoder = reranker
+        if (crossEncoder == null) {
+            return retrieve(query, embedding, limit)
+        }
+        
+        val candidates = retrieve(query, embedding, maxOf(limit * RERANK_CANDIDATES_PER_RESULT, MIN_RERANK_CANDIDATES))
+        if (candidates.size <= 1) {
+            return candidates
+        }
+        val scores = try {
+            crossEncoder.score(query, candidates.map { it.content })
+        } catch (e: Exception) {
+            return candidates.take(limit)
+        }
+        return candidates.indices
+            .sortedByDescending { scores[it] }
+            .take(limit)
+            .map { candidates[it].copy(score = scores[it]) }
+    }
+    
+    /**
+     * Query embedding for the semantic ranking and the cache's similarity tier;
+     * null without a store and a semantic embedder, or if embedding fails
+     */
+    private suspend fun queryEmbedding(query: String): FloatArray? {
+        val embedder = embeddingService
+        if (vectorStore == null || embedder == null || !embedder.isSemantic) {
+            return null
+        }
+        return try {
+            embedder.generateEmbedding(query)
+        } catch (e: Exception) {
+            null
+        }
+    }
+    
+    /**
+     * Version of everything search reads: this engine's chunks plus, when it is
+     * searched, the store's; null if the store does not track changes
+     */
+    private fun cacheVersion(): Long? {
+        val store = vectorStore
+        if (store == null || embeddingService == null) {
+            return localVersion
+        }
+        return store.chunkVersion?.let { it + localVersion }
+    }
+    
+    /**
+     * First-stage retrieval: lexical alone, or fused hybrid when a store is available
+     */
+    private suspend fun retrieve(query: String, embedding: FloatArray?, limit: Int): List<RetrievedChunk> {
+        val store = vectorStore
+        if (store == null || embeddingService == null) {
+            return mutex.withLock { searchLocal(query, limit) }
         }
         
-        // Calculate query magnitude
-        val queryMagnitude = calculateMagnitudeInt(queryTerms)
+        // Each retriever contributes a deeper list than requested so fusion has overlap to work with
+        val candidates = maxOf(limit * FUSION_CANDIDATES_PER_RESULT, MIN_FUSION_CANDIDATES)
+        val local = mutex.withLock { searchLocal(query, candidates) }
+        val keyword = store.searchLexical(query, candidates).map { it.toRetrievedChunk() }
+        val semantic = if (embedding == null) emptyList() else try {
+            store.searchSimilar(embedding, candidates, 0f).map { it.toRetrievedChunk() }
+        } catch (e: Exception) {
+            emptyList()
+        }
+        if (keyword.isEmpty() && semantic.isEmpty()) {
+            return local.take(limit)
+        }
         
-        // Calculate cosine similarity with all chunks using simple term matching
-        val scored = chunks.values.map { chunk ->
-            val similarity = calculateCosineSimilarity(
-                queryTerms,
-                chunk.terms,
-                queryMagnitude,
-                chunk.magnitude
+        // Fusion works on int labels: number every distinct chunk ID
+        val byLabel = mutableListOf<RetrievedChunk>()
+        val labels = mutableMapOf<String, Int>()
+        val rankings = listOf(local, keyword, semantic).map { ranking ->
+            IntArray(ranking.size) { i ->
+                labels.getOrPut(ranking[i].id) {
+                    byLabel.add(ranking[i])
+                    byLabel.size - 1
+                }
+            }
+        }
+        return RankFusion.fuse(rankings, limit).map { hit -> byLabel[hit.label].copy(score = hit.score) }
+    }
+    
+    /**
+     * TF-IDF cosine ranking over this engine's own chunks
+     */
+    private fun searchLocal(query: String, limit: Int): List<RetrievedChunk> {
+        if (chunks.isEmpty()) {
+            return emptyList()
+        }
+        
+        val index = tfidfIndex
+        val scored = if (index != null) {
+            index.search(query, limit).mapNotNull { hit ->
+                labelChunks[hit.label]?.let { it to hit.score.toDouble() }
+            }
+        } else {
+            scoreAllChunks(query, limit)
+        }
+        return scored.map { (chunk, score) ->
+            RetrievedChunk(
+                id = chunk.id,
+                content = chunk.content,
+                score = score.toFloat(),
+                documentId = chunk.documentId,
+                chunkIndex = chunk.chunkIndex,
+                metadata = chunk.metadata
             )
-            chunk to similarity
         }
+    }
+    
+    /**
+     * Kotlin fallback for [TfIdfIndex]: TF-IDF cosine against every chunk
+     */
+    private fun scoreAllChunks(query: String, limit: Int): List<Pair<DocumentChunk, Double>> {
+        val queryWeights = calculateTFIDF(extractTerms(query)).filterValues { it > 0.0 }
+        if (queryWeights.isEmpty()) {
+            return emptyList()
+        }
+        val queryMagnitude = calculateMagnitude(queryWeights)
         
-        // Sort by similarity and return top results
-        return scored
+        return chunks.values
+            .map { chunk ->
+                chunk to calculateCosineSimilarity(queryWeights, queryMagnitude, calculateTFIDF(chunk.terms))
+            }
             .filter { it.second > 0.0 } // Only return results with some similarity
             .sortedByDescending { it.second }
             .take(limit)
-            .map { (chunk, score) ->
-                RetrievedChunk(
-                    id = chunk.id,
-                    content = chunk.content,
-                    score = score.toFloat(),
-                    documentId = chunk.documentId,
-                    chunkIndex = chunk.chunkIndex,
-                    metadata = chunk.metadata
-                )
-            }
     }
     
     override suspend fun deleteIndex(documentId: String): Result<Unit> = mutex.withLock {
@@ -117,16 +292,11 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
                 .map { it.id }
             
             for (chunkId in chunkIds) {
-                chunks.remove(chunkId)
-                
-                // Clean up term frequencies
-                termFrequencies.values.forEach { it.remove(chunkId) }
+                removeChunk(chunkId)
             }
             
-            // Clean up empty term entries
-            termFrequencies.entries.removeIf { it.value.isEmpty() }
-            
             documentCount = documents.size
+            localVersion++
             
             Result.success(Unit)
         } catch (e: Exception) {
@@ -158,12 +328,11 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
                 .map { it.id }
             
             for (chunkId in orphanedChunks) {
-                chunks.remove(chunkId)
-                termFrequencies.values.forEach { it.remove(chunkId) }
+                removeChunk(chunkId)
+            }
+            if (orphanedChunks.isNotEmpty()) {
+                localVersion++
             }
-            
-            // Clean up empty term entries
-            termFrequencies.entries.removeIf { it.value.isEmpty() }
             
             Result.success(Unit)
         } catch (e: Exception) {
@@ -171,6 +340,49 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
         }
     }
     
+    /**
+     * Add chunks to the TF-IDF index: natively under new labels, or to the fallback's document frequencies
+     */
+    private fun addToIndex(newChunks: List<DocumentChunk>) {
+        val index = tfidfIndex
+        if (index == null) {
+            for (chunk in newChunks) {
+                for (term in chunk.terms.keys) {
+                    documentFrequencies[term] = (documentFrequencies[term] ?: 0) + 1
+                }
+            }
+            return
+        }
+        if (newChunks.isEmpty()) {
+            return
+        }
+        val labels = IntArray(newChunks.size) { nextLabel++ }
+        newChunks.forEachIndexed { i, chunk ->
+            chunkLabels[chunk.id] = labels[i]
+            labelChunks[labels[i]] = chunk
+        }
+        index.add(labels, Array(newChunks.size) { newChunks[it].content })
+    }
+    
+    /**
+     * Drop a chunk from storage and from the TF-IDF index
+     */
+    private fun removeChunk(chunkId: String) {
+        val chunk = chunks.remove(chunkId) ?: return
+        val index = tfidfIndex
+        if (index == null) {
+            for (term in chunk.terms.keys) {
+                val df = (documentFrequencies[term] ?: 0) - 1
+                if (df > 0) documentFrequencies[term] = df else documentFrequencies.remove(term)
+            }
+            return
+        }
+        chunkLabels.remove(chunkId)?.let { label ->
+            index.remove(label)
+            labelChunks.remove(label)
+        }
+    }
+    
     /**
      * Chunk a document into overlapping segments
      */
@@ -186,8 +398,8 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
             val chunkContent = content.substring(startIndex, endIndex).trim()
             
             if (chunkContent.isNotEmpty()) {
-                val terms = extractTerms(chunkContent)
-                val magnitude = calculateMagnitudeInt(terms)
+                // The native index tokenizes the content itself
+                val terms = if (tfidfIndex == null) extractTerms(chunkContent) else emptyMap()
                 
                 val chunk = DocumentChunk(
                     id = "${document.id}_chunk_$chunkIndex",
@@ -198,8 +410,7 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
                         "source" to document.source.name,
                         "timestamp" to document.timestamp
                     ),
-                    terms = terms,
-                    magnitude = magnitude
+                    terms = terms
                 )
                 
                 documentChunks.add(chunk)
@@ -220,7 +431,7 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
         // Simple tokenization: lowercase, split on non-alphanumeric, filter short words
         val terms = text.lowercase()
             .split(Regex("[^a-z0-9]+"))
-            .filter { it.length >= 3 } // Minimum word length
+            .filter { it.length >= MIN_TERM_LENGTH }
             .filterNot { it in stopWords }
         
         // Count term frequencies
@@ -228,53 +439,45 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
     }
     
     /**
-     * Calculate TF-IDF weighted vector
+     * Calculate TF-IDF weighted vector over the current chunks; terms no chunk contains weigh 0
      */
-    private fun calculateTFIDF(terms: Map<String, Int>, totalChunks: Int): Map<String, Double> {
+    private fun calculateTFIDF(terms: Map<String, Int>): Map<String, Double> {
+        val totalChunks = chunks.size
         return terms.mapValues { (term, tf) ->
-            val df = termFrequencies[term]?.size ?: 0
+            val df = documentFrequencies[term] ?: 0
             if (df == 0) {
                 0.0
             } else {
-                // TF-IDF = term frequency * log(total docs / document frequency)
-                val idf = kotlin.math.ln((totalChunks.toDouble() + 1) / (df + 1))
-                tf * idf
+                // Smoothed like TfIdfIndex: tf * (ln((N + 1) / (df + 1)) + 1)
+                tf * (kotlin.math.ln((totalChunks.toDouble() + 1) / (df + 1)) + 1.0)
             }
         }
     }
     
     /**
-     * Calculate vector magnitude for normalization (Int version)
-     */
-    private fun calculateMagnitudeInt(vector: Map<String, Int>): Double {
-        return sqrt(vector.values.sumOf { it * it.toDouble() })
-    }
-    
-    /**
-     * Calculate vector magnitude for normalization (Double version)
+     * Calculate vector magnitude for normalization
      */
-    private fun calculateMagnitudeDouble(vector: Map<String, Double>): Double {
+    private fun calculateMagnitude(vector: Map<String, Double>): Double {
         return sqrt(vector.values.sumOf { it * it })
     }
     
     /**
-     * Calculate cosine similarity between two term frequency vectors
+     * Calculate cosine similarity between two TF-IDF vectors
      */
     private fun calculateCosineSimilarity(
-        queryTerms: Map<String, Int>,
-        chunkTerms: Map<String, Int>,
+        queryWeights: Map<String, Double>,
         queryMagnitude: Double,
-        chunkMagnitude: Double
+        chunkWeights: Map<String, Double>
     ): Double {
+        val chunkMagnitude = calculateMagnitude(chunkWeights)
         if (queryMagnitude == 0.0 || chunkMagnitude == 0.0) {
             return 0.0
         }
         
         // Calculate dot product
         var dotProduct = 0.0
-        for ((term, queryFreq) in queryTerms) {
-            val chunkFreq = chunkTerms[term] ?: 0
-            dotProduct += queryFreq * chunkFreq.toDouble()
+        for ((term, queryWeight) in queryWeights) {
+            dotProduct += queryWeight * (chunkWeights[term] ?: 0.0)
         }
         
         // Cosine similarity = dot product / (magnitude1 * magnitude2)
@@ -297,13 +500,33 @@ class RAGEngineImpl @Inject constructor() : RAGEngine {
             chunk.id.length + chunk.content.length + chunk.terms.size * 20L
         }
         
-        // Term frequencies
-        size += termFrequencies.size * 50L
+        // Term index
+        size += tfidfIndex?.let { it.memoryBytes + chunkLabels.size * 50L } ?: (documentFrequencies.size * 50L)
         
         return size
     }
     
+    private fun ScoredChunk.toRetrievedChunk() = RetrievedChunk(
+        id = chunk.id,
+        content = chunk.content,
+        score = score,
+        documentId = chunk.documentId,
+        chunkIndex = chunk.metadata["chunk_index"]?.toIntOrNull() ?: 0,
+        metadata = chunk.metadata
+    )
+    
     companion object {
+        // Hybrid search: candidates drawn from each retriever before fusion
+        private const val FUSION_CANDIDATES_PER_RESULT = 4
+        private const val MIN_FUSION_CANDIDATES = 20
+        
+        // Reranking: candidates scored by the cross-encoder per result kept
+        private const val RERANK_CANDIDATES_PER_RESULT = 4
+        private const val MIN_RERANK_CANDIDATES = 10
+        
+        // Shortest term indexed, in characters
+        private const val MIN_TERM_LENGTH = 3
+        
         // Common English stop words to filter out
         private val stopWords = setOf(
             "the", "and", "for", "are", "but", "not", "you", "all", "can", "her",
@@ -0,0 +1,51 @@
+package com.nervesparks.iris.core.rag
+
+/**
+ * Reciprocal-rank fusion of rankings from different retrievers
+ *
+ * A label scores `sum(1 / (k0 + rank))` over the rankings that contain it, ranks
+ * counted from 1, so scores on different scales (BM25, cosine) never need to be
+ * calibrated against each other. Runs natively when libiris_rag is loaded.
+ */
+object RankFusion {
+    const val DEFAULT_K0 = 60f
+
+    /**
+     * @param rankings Labels best-first; a label repeated within one ranking counts once
+     * @return Up to `limit` fused hits, best first; ties keep first appearance
+     */
+    fun fuse(rankings: List<IntArray>, limit: Int, k0: Float = DEFAULT_K0): List<IndexHit> {
+        if (limit <= 0 || rankings.all { it.isEmpty() }) return emptyList()
+
+        if (HnswIndex.isNativeAvailable) {
+            val labels = IntArray(limit)
+            val scores = FloatArray(limit)
+            val count = nativeFuse(rankings.toTypedArray(), limit, k0, labels, scores)
+            return List(count) { IndexHit(labels[it], scores[it]) }
+        }
+
+        val fused = LinkedHashMap<Int, Float>()
+        for (ranking in rankings) {
+            val counted = HashSet<Int>()
+            ranking.forEachIndexed { rank, label ->
+                if (counted.add(label)) {
+                    fused[label] = (fused[label] ?: 0f) + 1f / (k0 + rank + 1)
+                }
+            }
+        }
+        // sortedByDescending is stable, so ties keep insertion (first appearance) order
+        return fused.entries
+            .sortedByDescending { it.value }
+            .take(limit)
+            .map { IndexHit(it.key, it.value) }
+    }
+
+    @JvmStatic
+    private external fun nativeFuse(
+        rankings: Array<IntArray>,
+        limit: Int,
+        k0: Float,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+}
@@ -0,0 +1,36 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+
+/**
+ * Handle to a native compressed set of [VectorFile] rows (libiris_rag)
+ *
+ * Produced by [VectorFile.selectRows] and passed to the `search` methods of
+ * [VectorFile], [HnswIndex] and [IvfPqIndex] to restrict results to its rows.
+ * Reflects the store when it was selected; close it once the search is done.
+ */
+class RowBitmap internal constructor(private var handle: Long) : Closeable {
+
+    /**
+     * Number of rows in the set
+     */
+    val cardinality: Int
+        get() = if (handle != 0L) nativeCardinality(handle) else 0
+
+    internal val nativeHandle: Long
+        get() {
+            check(handle != 0L) { "Row bitmap is closed" }
+            return handle
+        }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeCardinality(handle: Long): Int
+    private external fun nativeFree(handle: Long)
+}
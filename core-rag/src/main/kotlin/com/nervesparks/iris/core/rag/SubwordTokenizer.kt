@@ -0,0 +1,80 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+import java.io.File
+
+/**
+ * Handle to the native WordPiece tokenizer and chunker (libiris_rag)
+ *
+ * Loaded from the embedding model's `vocab.txt`, it counts tokens the way the
+ * model does, so chunks cut to a token budget fit the model's context exactly.
+ * A [wordLevel] tokenizer counts one token per word or punctuation mark, for
+ * when no vocabulary is available. Safe to use from several threads.
+ */
+class SubwordTokenizer private constructor(private var handle: Long) : Closeable {
+
+    companion object {
+        /**
+         * @throws java.io.IOException if the vocabulary cannot be read
+         */
+        fun load(vocabulary: File): SubwordTokenizer {
+            check(HnswIndex.isNativeAvailable) { "Native RAG library not available" }
+            return SubwordTokenizer(nativeLoad(vocabulary.absolutePath))
+        }
+
+        fun wordLevel(): SubwordTokenizer {
+            check(HnswIndex.isNativeAvailable) { "Native RAG library not available" }
+            return SubwordTokenizer(nativeCreate())
+        }
+
+        @JvmStatic
+        private external fun nativeCreate(): Long
+
+        @JvmStatic
+        private external fun nativeLoad(vocabPath: String): Long
+    }
+
+    /**
+     * Pieces in the vocabulary, 0 for a word-level tokenizer
+     */
+    val vocabularySize: Int
+        get() = if (handle != 0L) nativeVocabularySize(handle) else 0
+
+    fun countTokens(text: String): Int {
+        check(handle != 0L) { "Tokenizer is closed" }
+        return nativeCountTokens(handle, text)
+    }
+
+    /**
+     * Split `text` into chunks of at most `maxTokens` tokens, cut at paragraph,
+     * sentence or clause boundaries where possible, consecutive chunks sharing
+     * up to `overlapTokens` tokens
+     * @return Spans as offsets into `text`
+     */
+    fun chunk(text: String, maxTokens: Int, overlapTokens: Int): List<TokenSpan> {
+        check(handle != 0L) { "Tokenizer is closed" }
+        require(maxTokens > 0 && overlapTokens in 0 until maxTokens) {
+            "Expected maxTokens > 0 and 0 <= overlapTokens < maxTokens"
+        }
+        val spans = nativeChunk(handle, text, maxTokens, overlapTokens)
+        return List(spans.size / 3) { TokenSpan(spans[3 * it], spans[3 * it + 1], spans[3 * it + 2]) }
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeVocabularySize(handle: Long): Int
+    private external fun nativeCountTokens(handle: Long, text: String): Int
+    private external fun nativeChunk(handle: Long, text: String, maxTokens: Int, overlapTokens: Int): IntArray
+    private external fun nativeFree(handle: Long)
+}
+
+/**
+ * A chunk of text: `[start, end)` in UTF-16 units and its token count
+ */
+data class TokenSpan(val start: Int, val end: Int, val tokens: Int)
@@ -50,7 +50,12 @@ class TextExtractorImpl @Inject constructor(
     private suspend fun extractPlainText(uri: Uri): Result<String> {
         return try {
             context.contentResolver.openInputStream(uri)?.use { inputStream ->
-                val text = inputStream.bufferedReader().use { it.readText() }
+                val text = if (HnswIndex.isNativeAvailable) {
+                    // Decoded, validated and cleaned in one native pass
+                    TextNormalizer.normalize(inputStream.readBytes()).text
+                } else {
+                    inputStream.bufferedReader().use { it.readText() }
+                }
                 Result.success(text)
             } ?: Result.failure(DocumentProcessingException("Could not open file"))
         } catch (e: Exception) {
@@ -65,7 +70,13 @@ class TextExtractorImpl @Inject constructor(
             context.contentResolver.openInputStream(uri)?.use { inputStream ->
                 // Simple heuristic: try to read as text if it's a text-based PDF
                 val bytes = inputStream.readBytes()
-                val text = extractTextFromPdfBytes(bytes)
+                val raw = extractTextFromPdfBytes(bytes)
+                // PDF lines break mid-word; rejoin hyphenated words and collapse layout whitespace
+                val text = if (HnswIndex.isNativeAvailable) {
+                    TextNormalizer.normalize(raw, dehyphenate = true).text
+                } else {
+                    raw
+                }
                 
                 if (text.isNotBlank()) {
                     Result.success(text)
@@ -0,0 +1,61 @@
+package com.nervesparks.iris.core.rag
+
+/**
+ * Native cleanup and sentence segmentation of extracted document text (libiris_rag)
+ *
+ * One pass validates UTF-8, folds ligatures, fullwidth forms and Unicode spaces,
+ * collapses whitespace, optionally joins words hyphenated across line breaks,
+ * and finds sentence boundaries. Sentences come back as offsets, not strings.
+ * Normalized text normalizes to itself, so its sentences can be found again
+ * later with [sentences].
+ */
+object TextNormalizer {
+
+    /**
+     * @param bytes UTF-8 document; malformed sequences become U+FFFD
+     * @param dehyphenate Join "exam-\nple" into "example"; for text extracted from PDF
+     */
+    fun normalize(bytes: ByteArray, dehyphenate: Boolean = false): NormalizedText {
+        check(HnswIndex.isNativeAvailable) { "Native RAG library not available" }
+        val text = arrayOfNulls<String>(1)
+        val spans = nativeNormalize(bytes, dehyphenate, text)
+        return NormalizedText(text[0]!!, toSentences(spans))
+    }
+
+    fun normalize(text: String, dehyphenate: Boolean = false): NormalizedText {
+        check(HnswIndex.isNativeAvailable) { "Native RAG library not available" }
+        val normalized = arrayOfNulls<String>(1)
+        val spans = nativeNormalizeText(text, dehyphenate, normalized)
+        return NormalizedText(normalized[0]!!, toSentences(spans))
+    }
+
+    /**
+     * Sentences of `text` as offsets into `text` itself, without rewriting it
+     */
+    fun sentences(text: String): List<SentenceSpan> {
+        check(HnswIndex.isNativeAvailable) { "Native RAG library not available" }
+        return toSentences(nativeSentences(text))
+    }
+
+    private fun toSentences(spans: IntArray): List<SentenceSpan> =
+        List(spans.size / 3) { SentenceSpan(spans[3 * it], spans[3 * it + 1], spans[3 * it + 2] != 0) }
+
+    @JvmStatic
+    private external fun nativeNormalize(bytes: ByteArray, dehyphenate: Boolean, outText: Array<String?>): IntArray
+
+    @JvmStatic
+    private external fun nativeNormalizeText(text: String, dehyphenate: Boolean, outText: Array<String?>): IntArray
+
+    @JvmStatic
+    private external fun nativeSentences(text: String): IntArray
+}
+
+/**
+ * Normalized text and its sentences, as offsets into it
+ */
+data class NormalizedText(val text: String, val sentences: List<SentenceSpan>)
+
+/**
+ * A sentence: `[start, end)` in UTF-16 units, and whether it opens a paragraph
+ */
+data class SentenceSpan(val start: Int, val end: Int, val paragraphStart: Boolean)
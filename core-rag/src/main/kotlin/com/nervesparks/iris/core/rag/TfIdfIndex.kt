@@ -0,0 +1,81 @@
+package com.nervesparks.iris.core.rag
+
+import java.io.Closeable
+
+/**
+ * Handle to the native sparse TF-IDF index (libiris_rag)
+ *
+ * Terms are interned to integer IDs and documents stored as CSR rows with
+ * precomputed norms; queries accumulate cosine scores term-at-a-time over the
+ * inverted lists, so only documents sharing a query term are touched. Adds and
+ * removes only update document frequencies; the inverted lists are rebuilt by
+ * the add or remove that takes the changes past a quarter of the index.
+ * Document IDs must be added in increasing order, e.g. a running counter.
+ * Adds, removes and searches are safe to call concurrently.
+ */
+class TfIdfIndex(stopWords: Set<String>, minTermChars: Int) : Closeable {
+
+    private var handle: Long = nativeCreate(stopWords.toTypedArray(), minTermChars)
+
+    /**
+     * Number of live documents
+     */
+    val size: Int
+        get() = if (handle != 0L) nativeSize(handle) else 0
+
+    /**
+     * Bytes held by the term dictionary and both CSR indexes
+     */
+    val memoryBytes: Long
+        get() = if (handle != 0L) nativeMemoryBytes(handle) else 0L
+
+    /**
+     * Index texts; IDs must be ascending and above every ID added before
+     */
+    fun add(docs: IntArray, texts: Array<String>) {
+        check(handle != 0L) { "Index is closed" }
+        require(docs.size == texts.size) { "Expected ${docs.size} texts, got ${texts.size}" }
+        nativeAdd(handle, docs, texts)
+    }
+
+    fun remove(doc: Int): Boolean {
+        check(handle != 0L) { "Index is closed" }
+        return nativeRemove(handle, doc)
+    }
+
+    /**
+     * Top-k documents by TF-IDF cosine similarity; only documents sharing a term with the query
+     * @return Hits sorted by descending score
+     */
+    fun search(query: String, k: Int): List<IndexHit> {
+        check(handle != 0L) { "Index is closed" }
+        if (k <= 0) return emptyList()
+
+        val labels = IntArray(k)
+        val scores = FloatArray(k)
+        val count = nativeSearch(handle, query, k, labels, scores)
+        return List(count) { IndexHit(labels[it], scores[it]) }
+    }
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeFree(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeCreate(stopWords: Array<String>, minTermChars: Int): Long
+    private external fun nativeAdd(handle: Long, docs: IntArray, texts: Array<String>)
+    private external fun nativeRemove(handle: Long, doc: Int): Boolean
+    private external fun nativeSearch(
+        handle: Long,
+        query: String,
+        k: Int,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+    private external fun nativeSize(handle: Long): Int
+    private external fun nativeMemoryBytes(handle: Long): Long
+    private external fun nativeFree(handle: Long)
+}
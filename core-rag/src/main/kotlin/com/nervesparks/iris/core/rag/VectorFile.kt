@@ -0,0 +1,331 @@
+package com.nervesparks.iris.core.rag
+
+import org.json.JSONObject
+import java.io.Closeable
+import java.io.File
+
+/**
+ * Codes kept beside the f32 vectors for the first search pass
+ */
+enum class VectorQuantization {
+    /** No codes; searches scan the f32 vectors */
+    NONE,
+    /** int8 per dimension plus a scale, 4x smaller than f32 */
+    INT8,
+    /** One sign bit per dimension, 32x smaller than f32 */
+    BINARY
+}
+
+/**
+ * Handle to the native memory-mapped vector store (libiris_rag)
+ *
+ * Chunks are addressed by row number; rows are assigned on append, never reused,
+ * and double as [HnswIndex] labels. Vectors stay in the mapped file rather than
+ * on the Java heap and are stored L2-normalized. Appends and deletes are durable
+ * when the call returns. A quantized store [search]es its compact codes first and
+ * rescores a shortlist against the f32 vectors.
+ *
+ * Deleted rows are tombstones until [compactInto] copies the live rows into a
+ * fresh store; the copy runs while this store keeps serving.
+ */
+class VectorFile private constructor(private var handle: Long) : Closeable {
+
+    companion object {
+        /**
+         * True when libiris_rag is loaded (shared with [HnswIndex])
+         */
+        val isNativeAvailable: Boolean
+            get() = HnswIndex.isNativeAvailable
+
+        /**
+         * Open or create a store
+         * @param dimension Vector dimension; 0 opens an existing store with its own dimension
+         * @param fingerprint Embedding model identity; a store written by another model is discarded
+         * @param quantization Codes to keep; an existing store is re-encoded if it differs,
+         *        null keeps what an existing store has
+         */
+        fun open(
+            directory: File,
+            dimension: Int,
+            fingerprint: String,
+            quantization: VectorQuantization? = null
+        ): VectorFile {
+            check(isNativeAvailable) { "Native RAG library not available" }
+            return VectorFile(
+                nativeOpen(directory.absolutePath, dimension, fingerprint, true, quantization?.ordinal ?: -1)
+            )
+        }
+
+        /**
+         * Whether a store exists in `directory`, i.e. whether [open] can be called with dimension 0
+         */
+        fun exists(directory: File): Boolean = File(directory, "store.vec").exists()
+
+        @JvmStatic
+        private external fun nativeOpen(
+            directory: String,
+            dimension: Int,
+            fingerprint: String,
+            resetOnMismatch: Boolean,
+            quantization: Int
+        ): Long
+    }
+
+    val dimension: Int = nativeDimension(handle)
+
+    val quantization: VectorQuantization = VectorQuantization.values()[nativeQuantization(handle)]
+
+    /**
+     * Number of chunks not deleted
+     */
+    val liveCount: Int
+        get() = if (handle != 0L) nativeLiveCount(handle) else 0
+
+    /**
+     * Rows ever appended, live or deleted; `rowCount - liveCount` rows are tombstones
+     */
+    val rowCount: Int
+        get() = if (handle != 0L) nativeRowCount(handle) else 0
+
+    /**
+     * Append chunks; embeddings must all have [dimension] floats
+     * @return Row assigned to each chunk
+     */
+    fun append(chunks: List<EmbeddedChunk>): IntArray {
+        check(handle != 0L) { "Vector store is closed" }
+        val vectors = FloatArray(chunks.size * dimension)
+        chunks.forEachIndexed { i, chunk ->
+            require(chunk.embedding.size == dimension) { "Expected dimension $dimension, got ${chunk.embedding.size}" }
+            chunk.embedding.copyInto(vectors, i * dimension)
+        }
+        return nativeAppend(
+            handle,
+            Array(chunks.size) { chunks[it].id },
+            Array(chunks.size) { chunks[it].documentId },
+            Array(chunks.size) { chunks[it].content },
+            Array(chunks.size) { JSONObject(chunks[it].metadata).toString() },
+            IntArray(chunks.size) { chunks[it].startIndex },
+            IntArray(chunks.size) { chunks[it].endIndex },
+            vectors
+        )
+    }
+
+    fun markDeleted(rows: IntArray) {
+        check(handle != 0L) { "Vector store is closed" }
+        if (rows.isNotEmpty()) {
+            nativeMarkDeleted(handle, rows)
+        }
+    }
+
+    /**
+     * Live rows of one document in ascending order
+     */
+    fun documentRows(documentId: String): IntArray {
+        check(handle != 0L) { "Vector store is closed" }
+        return nativeDocumentRows(handle, documentId)
+    }
+
+    /**
+     * Delete every chunk of a document
+     * @return The rows deleted
+     */
+    fun deleteDocument(documentId: String): IntArray {
+        check(handle != 0L) { "Vector store is closed" }
+        return nativeDeleteDocument(handle, documentId)
+    }
+
+    /**
+     * For each of `contents`, a live row of `documentId` storing exactly that
+     * content, or -1; each row matches at most one content
+     */
+    fun matchContent(documentId: String, contents: List<String>): IntArray {
+        check(handle != 0L) { "Vector store is closed" }
+        if (contents.isEmpty()) return IntArray(0)
+        return nativeMatchContent(handle, documentId, contents.toTypedArray())
+    }
+
+    /**
+     * Copy the live rows into a new store in `directory`, replacing any store there.
+     * Searches and writes on this store may continue meanwhile; bring the copy up
+     * to date with [syncCompacted] before switching to it.
+     * @return The copy and, for each row of this store, its row in the copy or -1
+     */
+    fun compactInto(directory: File): Pair<VectorFile, IntArray> {
+        check(handle != 0L) { "Vector store is closed" }
+        val compactedHandle = LongArray(1)
+        val rowMap = nativeCompactInto(handle, directory.absolutePath, compactedHandle)
+        return VectorFile(compactedHandle[0]) to rowMap
+    }
+
+    /**
+     * Apply deletes and appends made here since `rowMap` was produced to `target`
+     * @return `rowMap` extended to the rows appended since
+     */
+    fun syncCompacted(target: VectorFile, rowMap: IntArray): IntArray {
+        check(handle != 0L && target.handle != 0L) { "Vector store is closed" }
+        return nativeSyncCompacted(handle, target.handle, rowMap)
+    }
+
+    /**
+     * Flush to the main file and truncate the write-ahead log
+     */
+    fun checkpoint() {
+        check(handle != 0L) { "Vector store is closed" }
+        nativeCheckpoint(handle)
+    }
+
+    /**
+     * Live rows in ascending order
+     */
+    fun liveRows(): IntArray {
+        check(handle != 0L) { "Vector store is closed" }
+        return nativeLiveRows(handle)
+    }
+
+    /**
+     * Chunk ID and document ID for each row
+     */
+    fun keys(rows: IntArray): List<Pair<String, String>> {
+        check(handle != 0L) { "Vector store is closed" }
+        val keys = nativeKeys(handle, rows)
+        return List(rows.size) { keys[it * 2] to keys[it * 2 + 1] }
+    }
+
+    /**
+     * Materialize one stored chunk (embedding is the normalized stored vector)
+     */
+    fun read(row: Int): EmbeddedChunk {
+        check(handle != 0L) { "Vector store is closed" }
+        val span = IntArray(2)
+        val embedding = FloatArray(dimension)
+        val fields = nativeReadRecord(handle, row, span, embedding)
+        val metadata = JSONObject(fields[3]).let { json ->
+            json.keys().asSequence().associateWith { json.getString(it) }
+        }
+        return EmbeddedChunk(
+            id = fields[0],
+            documentId = fields[1],
+            content = fields[2],
+            embedding = embedding,
+            startIndex = span[0],
+            endIndex = span[1],
+            metadata = metadata
+        )
+    }
+
+    /**
+     * Live rows meeting `filter`; every live row when it sets no criterion.
+     * Tags and modification times come from the chunk metadata keys
+     * [SearchFilter.TAGS_KEY] and [SearchFilter.MODIFIED_KEY].
+     */
+    fun selectRows(filter: SearchFilter): RowBitmap {
+        check(handle != 0L) { "Vector store is closed" }
+        return RowBitmap(
+            nativeFilterRows(
+                handle,
+                filter.documentIds.toTypedArray(),
+                filter.tags.toTypedArray(),
+                filter.modifiedFrom ?: Long.MIN_VALUE,
+                filter.modifiedTo ?: Long.MAX_VALUE
+            )
+        )
+    }
+
+    /**
+     * Exact top-k over live rows, or only over `rows`; hit labels are row numbers.
+     * Blocks of the arena without a filtered row are skipped, so a selective
+     * filter scans little. Large stores are scanned on every core.
+     * @param threshold Rows scoring below this are skipped inside the scan
+     */
+    fun exactSearch(
+        query: FloatArray,
+        k: Int,
+        rows: RowBitmap? = null,
+        threshold: Float = Float.NEGATIVE_INFINITY
+    ): List<IndexHit> {
+        check(handle != 0L) { "Vector store is closed" }
+        if (k <= 0) return emptyList()
+
+        val labels = IntArray(k)
+        val scores = FloatArray(k)
+        val count = nativeExactSearch(handle, query, k, rows?.nativeHandle ?: 0L, threshold, labels, scores)
+        return List(count) { IndexHit(labels[it], scores[it]) }
+    }
+
+    /**
+     * Top-k through the quantized codes: the best `candidates` rows by code are
+     * rescored exactly. Same as [exactSearch] for an unquantized store.
+     * @param rows Only consider these rows
+     */
+    fun search(query: FloatArray, k: Int, candidates: Int, rows: RowBitmap? = null): List<IndexHit> {
+        check(handle != 0L) { "Vector store is closed" }
+        if (k <= 0) return emptyList()
+
+        val labels = IntArray(k)
+        val scores = FloatArray(k)
+        val count = nativeSearch(handle, query, k, candidates, rows?.nativeHandle ?: 0L, labels, scores)
+        return List(count) { IndexHit(labels[it], scores[it]) }
+    }
+
+    internal val nativeHandle: Long
+        get() = handle
+
+    override fun close() {
+        if (handle != 0L) {
+            nativeClose(handle)
+            handle = 0L
+        }
+    }
+
+    // Native method declarations
+    private external fun nativeDimension(handle: Long): Int
+    private external fun nativeQuantization(handle: Long): Int
+    private external fun nativeLiveCount(handle: Long): Int
+    private external fun nativeRowCount(handle: Long): Int
+    private external fun nativeAppend(
+        handle: Long,
+        ids: Array<String>,
+        documentIds: Array<String>,
+        contents: Array<String>,
+        metadata: Array<String>,
+        starts: IntArray,
+        ends: IntArray,
+        vectors: FloatArray
+    ): IntArray
+    private external fun nativeMarkDeleted(handle: Long, rows: IntArray)
+    private external fun nativeDocumentRows(handle: Long, documentId: String): IntArray
+    private external fun nativeDeleteDocument(handle: Long, documentId: String): IntArray
+    private external fun nativeMatchContent(handle: Long, documentId: String, contents: Array<String>): IntArray
+    private external fun nativeCompactInto(handle: Long, directory: String, outHandle: LongArray): IntArray
+    private external fun nativeSyncCompacted(handle: Long, targetHandle: Long, rowMap: IntArray): IntArray
+    private external fun nativeCheckpoint(handle: Long)
+    private external fun nativeLiveRows(handle: Long): IntArray
+    private external fun nativeKeys(handle: Long, rows: IntArray): Array<String>
+    private external fun nativeReadRecord(handle: Long, row: Int, outSpan: IntArray, outVector: FloatArray): Array<String>
+    private external fun nativeFilterRows(
+        handle: Long,
+        documentIds: Array<String>,
+        tags: Array<String>,
+        modifiedFrom: Long,
+        modifiedTo: Long
+    ): Long
+    private external fun nativeExactSearch(
+        handle: Long,
+        query: FloatArray,
+        k: Int,
+        filterHandle: Long,
+        threshold: Float,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+    private external fun nativeSearch(
+        handle: Long,
+        query: FloatArray,
+        k: Int,
+        candidates: Int,
+        filterHandle: Long,
+        outLabels: IntArray,
+        outScores: FloatArray
+    ): Int
+    private external fun nativeClose(handle: Long)
+}
@@ -0,0 +1,31 @@
+package com.nervesparks.iris.core.rag.di
+
+import com.nervesparks.iris.core.rag.EmbeddingService
+import com.nervesparks.iris.core.rag.EmbeddingServiceImpl
+import com.nervesparks.iris.core.rag.VectorStore
+import com.nervesparks.iris.core.rag.VectorStoreImpl
+import dagger.Binds
+import dagger.Module
+import dagger.hilt.InstallIn
+import dagger.hilt.components.SingletonComponent
+import javax.inject.Singleton
+
+/**
+ * Hilt module for retrieval storage dependencies
+ */
+@Module
+@InstallIn(SingletonComponent::class)
+abstract class RagModule {
+    
+    @Binds
+    @Singleton
+    abstract fun bindVectorStore(
+        impl: VectorStoreImpl
+    ): VectorStore
+    
+    @Binds
+    @Singleton
+    abstract fun bindEmbeddingService(
+        impl: EmbeddingServiceImpl
+    ): EmbeddingService
+}
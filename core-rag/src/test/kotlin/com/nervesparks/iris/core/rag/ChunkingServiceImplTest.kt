@@ -250,4 +250,21 @@ class ChunkingServiceImplTest {
         // Should create at least one chunk
         assertTrue(chunks.size >= 1)
     }
+    
+    @Test
+    fun `chunkByTokens falls back to character chunking without native library`() = runTest {
+        val paragraph = "This is a test paragraph. ".repeat(20)
+        val text = List(5) { paragraph }.joinToString("\n\n")
+        
+        val chunks = chunkingService.chunkByTokens(
+            text = text,
+            maxTokens = 100,
+            overlapTokens = 10,
+            documentId = "doc1"
+        )
+        
+        assertTrue(chunks.size > 1)
+        assertTrue(chunks.all { it.content.isNotEmpty() && it.content.length <= 400 })
+        assertEquals("doc1", chunks[0].metadata["document_id"])
+    }
 }
@@ -0,0 +1,133 @@
+package com.nervesparks.iris.core.rag
+
+import android.net.Uri
+import kotlinx.coroutines.flow.toList
+import kotlinx.coroutines.test.runTest
+import org.junit.Assert.*
+import org.junit.Before
+import org.junit.Rule
+import org.junit.Test
+import org.junit.rules.TemporaryFolder
+import org.junit.runner.RunWith
+import org.robolectric.RobolectricTestRunner
+import java.io.File
+
+/**
+ * Unit tests for IngestionPipeline
+ */
+@RunWith(RobolectricTestRunner::class)
+class IngestionPipelineTest {
+
+    @get:Rule
+    val temporaryFolder = TemporaryFolder()
+
+    private lateinit var store: RecordingVectorStore
+    private lateinit var progressFile: File
+    private val texts = mutableMapOf<String, String>()
+
+    private val extractor = object : TextExtractor {
+        override suspend fun extractText(uri: Uri, documentInfo: DocumentInfo): Result<String> =
+            texts[uri.toString()]?.let { Result.success(it) }
+                ?: Result.failure(DocumentProcessingException("No text for $uri"))
+    }
+
+    /**
+     * In-memory store that can be told to fail a save, to interrupt ingestion
+     */
+    private class RecordingVectorStore : VectorStore {
+        val documents = mutableMapOf<String, StoredDocument>()
+        val savedChunkIds = mutableListOf<String>()
+        var saveCalls = 0
+        var failOnSaveCall = -1
+
+        override suspend fun saveDocument(document: StoredDocument) { documents[document.id] = document }
+        override suspend fun updateDocument(document: StoredDocument) { documents[document.id] = document }
+        override suspend fun getDocument(documentId: String) = documents[documentId]
+        override suspend fun getAllDocuments() = documents.values.toList()
+        override suspend fun deleteDocument(documentId: String) = documents.remove(documentId) != null
+        override suspend fun saveChunks(chunks: List<EmbeddedChunk>) {
+            if (++saveCalls == failOnSaveCall) throw IllegalStateException("Storage interrupted")
+            savedChunkIds.addAll(chunks.map { it.id })
+        }
+        override suspend fun deleteChunksByDocumentId(documentId: String): Boolean {
+            savedChunkIds.removeAll { it.startsWith("${documentId}_") }
+            return true
+        }
+        override suspend fun searchSimilar(queryEmbedding: FloatArray, limit: Int, threshold: Float) =
+            emptyList<ScoredChunk>()
+    }
+
+    @Before
+    fun setup() {
+        store = RecordingVectorStore()
+        progressFile = File(temporaryFolder.root, "progress.properties")
+    }
+
+    private fun pipeline() = IngestionPipeline(
+        textExtractor = extractor,
+        chunkingService = ChunkingServiceImpl(),
+        embeddingService = EmbeddingServiceImpl(),
+        vectorStore = store,
+        progressFile = progressFile,
+        describe = { DocumentInfo("test.txt", 0L, "text/plain", 0L) }
+    )
+
+    private fun longText(sentences: Int) =
+        (0 until sentences).joinToString(" ") { "Sentence number $it has a few more words." }
+
+    @Test
+    fun `run ingests every document and reports stage throughput`() = runTest {
+        val uris = (0 until 3).map { Uri.parse("content://docs/$it") }
+        uris.forEach { texts[it.toString()] = longText(200) }
+
+        val events = pipeline().run(uris.map { IngestJob(it) }).toList()
+
+        val completed = events.filterIsInstance<BatchProcessingResult.DocumentCompleted>()
+        assertEquals(3, completed.size)
+        val summary = events.last() as BatchProcessingResult.Completed
+        assertEquals(3, summary.successCount)
+        assertEquals(0, summary.errorCount)
+
+        val totalChunks = completed.sumOf { it.result.chunkCount }
+        assertEquals(totalChunks, store.savedChunkIds.size)
+        assertEquals(listOf("extract", "chunk", "embed", "index"), summary.stageThroughput.map { it.stage })
+        assertEquals(3L, summary.stageThroughput[0].items)
+        assertTrue(summary.stageThroughput.drop(1).all { it.items == totalChunks.toLong() })
+        assertTrue(store.documents.values.all { it.isProcessed })
+    }
+
+    @Test
+    fun `run reports documents that cannot be extracted`() = runTest {
+        val good = Uri.parse("content://docs/good")
+        texts[good.toString()] = longText(20)
+
+        val events = pipeline().run(listOf(IngestJob(good), IngestJob(Uri.parse("content://docs/missing")))).toList()
+
+        val summary = events.last() as BatchProcessingResult.Completed
+        assertEquals(1, summary.successCount)
+        assertEquals(1, summary.errorCount)
+        assertEquals(1, events.filterIsInstance<BatchProcessingResult.DocumentFailed>().size)
+    }
+
+    @Test
+    fun `interrupted document resumes without storing chunks twice`() = runTest {
+        val uri = Uri.parse("content://docs/long")
+        texts[uri.toString()] = longText(2500) // more than two embedding batches
+        store.failOnSaveCall = 2
+
+        val first = pipeline().run(listOf(IngestJob(uri))).toList()
+        assertEquals(1, first.filterIsInstance<BatchProcessingResult.DocumentFailed>().size)
+        val storedBefore = store.savedChunkIds.size
+        assertTrue(storedBefore > 0)
+        val documentId = store.documents.keys.single()
+
+        store.failOnSaveCall = -1
+        val second = pipeline().run(listOf(IngestJob(uri))).toList()
+
+        val completed = second.filterIsInstance<BatchProcessingResult.DocumentCompleted>().single()
+        assertEquals(documentId, completed.result.documentId)
+        assertEquals(completed.result.chunkCount, store.savedChunkIds.size)
+        assertEquals(store.savedChunkIds.size, store.savedChunkIds.toSet().size)
+        assertTrue(store.documents.getValue(documentId).isProcessed)
+    }
+}
@@ -1,5 +1,9 @@
 package com.nervesparks.iris.core.rag
 
+import io.mockk.coEvery
+import io.mockk.coVerify
+import io.mockk.every
+import io.mockk.mockk
 import kotlinx.coroutines.test.runTest
 import org.junit.Assert.assertEquals
 import org.junit.Assert.assertTrue
@@ -235,6 +239,19 @@ class RAGEngineImplTest {
         assertEquals("doc1", results.first().documentId)
     }
     
+    @Test
+    fun `search weights rare terms above common ones`() = runTest {
+        val contents = listOf("programming tutorial programming guide", "kotlin tutorial", "programming basics")
+        contents.forEachIndexed { i, content ->
+            ragEngine.indexDocument(Document(id = "doc${i + 1}", content = content, source = DataSource.NOTE))
+        }
+        
+        // By raw term counts doc1 matches best; "kotlin" is rarer than "programming"
+        val results = ragEngine.search("programming kotlin", limit = 5)
+        
+        assertEquals("doc2", results.first().documentId)
+    }
+    
     @Test
     fun `search is case insensitive`() = runTest {
         val document = Document(
@@ -363,4 +380,62 @@ class RAGEngineImplTest {
         // Should handle gracefully, may or may not find results
         assertTrue(results.isEmpty() || results.all { it.score >= 0.0f })
     }
+    
+    @Test
+    fun `search returns the reranker's best candidates first`() = runTest {
+        listOf("doc1" to "Garden notes: tomato plants need water every morning",
+               "doc2" to "Shopping: buy tomato seeds and a watering can",
+               "doc3" to "Recipe: tomato soup with basil").forEach { (id, content) ->
+            ragEngine.indexDocument(Document(id = id, content = content, source = DataSource.NOTE))
+        }
+        ragEngine.reranker = object : Reranker {
+            override suspend fun score(query: String, passages: List<String>) =
+                FloatArray(passages.size) { if ("soup" in passages[it]) 5f else 0f }
+        }
+        
+        val results = ragEngine.search("tomato", limit = 1)
+        
+        assertEquals(1, results.size)
+        assertEquals("doc3", results.first().documentId)
+        assertEquals(5f, results.first().score, 0f)
+    }
+    
+    @Test
+    fun `reranks follows the attached reranker`() {
+        assertTrue(!ragEngine.reranks)
+        ragEngine.reranker = mockk()
+        assertTrue(ragEngine.reranks)
+        ragEngine.reranker = null
+        assertTrue(!ragEngine.reranks)
+    }
+    
+    @Test
+    fun `hybrid search leaves out a placeholder embedder's ranking`() = runTest {
+        val store = mockk<VectorStore>(relaxed = true)
+        val embedder = mockk<EmbeddingService>(relaxed = true)
+        every { embedder.isSemantic } returns false
+        val engine = RAGEngineImpl(store, embedder)
+        engine.indexDocument(Document(id = "doc1", content = "Invoice INV-2291 is due", source = DataSource.NOTE))
+        
+        val results = engine.search("invoice", limit = 3)
+        
+        assertEquals("doc1", results.first().documentId)
+        coVerify(exactly = 1) { store.searchLexical("invoice", any()) }
+        coVerify(exactly = 0) { embedder.generateEmbedding(any()) }
+        coVerify(exactly = 0) { store.searchSimilar(any(), any(), any()) }
+    }
+    
+    @Test
+    fun `hybrid search fuses a semantic embedder's ranking`() = runTest {
+        val store = mockk<VectorStore>(relaxed = true)
+        val embedder = mockk<EmbeddingService>(relaxed = true)
+        every { embedder.isSemantic } returns true
+        coEvery { embedder.generateEmbedding(any()) } returns FloatArray(4) { 0.5f }
+        val engine = RAGEngineImpl(store, embedder)
+        engine.indexDocument(Document(id = "doc1", content = "Invoice INV-2291 is due", source = DataSource.NOTE))
+        
+        engine.search("invoice", limit = 3)
+        
+        coVerify(exactly = 1) { store.searchSimilar(any(), any(), any()) }
+    }
 }
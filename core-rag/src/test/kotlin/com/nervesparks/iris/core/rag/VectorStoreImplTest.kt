@@ -6,6 +6,7 @@ import org.junit.Before
 import org.junit.Test
 import org.junit.runner.RunWith
 import org.robolectric.RobolectricTestRunner
+import org.robolectric.RuntimeEnvironment
 
 /**
  * Unit tests for VectorStoreImpl
@@ -19,7 +20,7 @@ class VectorStoreImplTest {
     @Before
     fun setup() {
         embeddingService = EmbeddingServiceImpl()
-        vectorStore = VectorStoreImpl(embeddingService)
+        vectorStore = VectorStoreImpl(embeddingService, RuntimeEnvironment.getApplication())
     }
     
     @Test
@@ -278,8 +279,52 @@ class VectorStoreImplTest {
         }
     }
     
+    @Test
+    fun `upsertChunks embeds only changed content`() = runTest {
+        fun chunk(content: String) = DocumentChunk(content, 0, content.length, emptyMap())
+        val embedded = mutableListOf<String>()
+        val embed: suspend (List<String>) -> List<FloatArray> = { texts ->
+            embedded.addAll(texts)
+            embeddingService.generateEmbeddings(texts)
+        }
+
+        vectorStore.upsertChunks("doc1", listOf(chunk("alpha"), chunk("beta"), chunk("gamma")), embed)
+        embedded.clear()
+        val count = vectorStore.upsertChunks("doc1", listOf(chunk("alpha"), chunk("delta"), chunk("gamma")), embed)
+
+        assertEquals(1, count)
+        assertEquals(listOf("delta"), embedded)
+        val results = vectorStore.searchSimilar(embeddingService.generateEmbedding("delta"), 10, -1.0f)
+        assertEquals(setOf("alpha", "delta", "gamma"), results.map { it.chunk.content }.toSet())
+        assertEquals("doc1_chunk_1", results.first { it.chunk.content == "delta" }.chunk.id)
+    }
+
+    @Test
+    fun `searchFiltered returns only chunks matching the filter`() = runTest {
+        fun facets(tags: String, modified: Long) =
+            mapOf(SearchFilter.TAGS_KEY to tags, SearchFilter.MODIFIED_KEY to modified.toString())
+        vectorStore.saveChunks(listOf(
+            createEmbeddedChunk("chunk1", "doc1", "quarterly report").copy(metadata = facets("work", 1_000)),
+            createEmbeddedChunk("chunk2", "doc2", "quarterly budget").copy(metadata = facets("work,finance", 5_000)),
+            createEmbeddedChunk("chunk3", "doc3", "quarterly holiday").copy(metadata = facets("personal", 5_000))
+        ))
+        val query = embeddingService.generateEmbedding("quarterly")
+
+        val work = vectorStore.searchFiltered(query, 10, -1.0f, SearchFilter(tags = setOf("work")))
+        assertEquals(setOf("chunk1", "chunk2"), work.map { it.chunk.id }.toSet())
+
+        val recentWork = SearchFilter(tags = setOf("work", "personal"), modifiedFrom = 2_000)
+        assertEquals(
+            setOf("chunk2", "chunk3"),
+            vectorStore.searchFiltered(query, 10, -1.0f, recentWork).map { it.chunk.id }.toSet()
+        )
+
+        val oneDocument = SearchFilter(documentIds = setOf("doc3"))
+        assertEquals(listOf("chunk3"), vectorStore.searchFiltered(query, 10, -1.0f, oneDocument).map { it.chunk.id })
+    }
+
     // Helper methods
-    
+
     private suspend fun createEmbeddedChunk(
         id: String,
         documentId: String,